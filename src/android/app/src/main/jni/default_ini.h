@@ -91,12 +91,36 @@ udp_pad_index=
 # 0: Interpreter (slow), 1 (default): JIT (fast)
 use_cpu_jit =
 
+# Whether the JIT accesses guest memory through a host mapping of the address space (fastmem)
+# instead of a page table lookup. Only supported on Linux x86-64 hosts.
+# 0: Off, 1 (default): On
+use_fastmem =
+
+# Whether each emulated CPU core runs on its own host thread. Experimental, only used by the JIT
+# when more than one core is emulated. The interleaving of the cores may differ between runs.
+# 0 (default): Off, 1: On
+use_cpu_threads =
+
+# Whether cores found spinning in an idle loop or polling svcGetSystemTick skip ahead to the next
+# scheduled event instead of executing the loop. Lowers host CPU usage, but may change timing.
+# Not used when use_cpu_threads is enabled.
+# 0 (default): Off, 1: On
+skip_idle_loops =
+
 # Change the Clock Frequency of the emulated 3DS CPU.
 # Underclocking can increase the performance of the game at the risk of freezing.
 # Overclocking may fix lag that happens on console, but also comes with the risk of freezing.
 # Range is any positive integer (but we suspect 25 - 400 is a good idea) Default is 100
 cpu_clock_percentage =
 
+# Number of emulated frames between the in-memory snapshots emulation can be rewound to
+# 0 (default): Rewinding disabled
+rewind_interval =
+
+# Maximum memory in MiB held by the rewind snapshots, including a copy of FCRAM (128 MiB, or
+# 256 MiB on New 3DS). Default is 384
+rewind_buffer_size =
+
 [Renderer]
 # Whether to render using GLES or OpenGL
 # 0: OpenGL, 1 (default): GLES
@@ -126,6 +150,18 @@ use_asynchronous_gpu_emulation =
 # 0: Interpreter (slow), 1 (default): JIT (fast)
 use_shader_jit =
 
+# Number of threads the software renderer rasterizes with
+# 0 (default): One per host core, 1: Single-threaded, Otherwise the given number of threads
+sw_rasterizer_threads =
+
+# Number of threads large draws are vertex shaded with when not using hardware shaders
+# 0 (default): One per host core, 1: Single-threaded, Otherwise the given number of threads
+vertex_shader_threads =
+
+# Whether to process GPU commands on a separate thread when using the software rasterizer
+# 0 (default): Off, 1: On
+use_async_gpu =
+
 # Forces VSync on the display thread. Usually doesn't impact performance, but on some drivers it can
 # so only turn this off if you notice a speed difference.
 # 0: Off, 1 (default): On
@@ -218,6 +254,10 @@ enable_dsp_lle =
 # 0 (default): No, 1: Yes
 enable_dsp_lle_thread =
 
+# Number of threads the audio sources are processed with when not using DSP LLE
+# 0: One per host core, 1 (default): Single-threaded, Otherwise the given number of threads
+audio_source_threads =
+
 # Which audio output engine to use.
 # auto (default): Auto-select, null: No audio output, sdl2: SDL2 (if available)
 output_engine =
@@ -0,0 +1,451 @@
+// Copyright 2022 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cstring>
+#include "audio_core/audio_kernels.h"
+
+#if defined(ARCHITECTURE_x86_64)
+#include <emmintrin.h>
+#elif defined(ARCHITECTURE_ARM64)
+#include <arm_neon.h>
+#endif
+
+namespace AudioCore::Kernels {
+
+namespace {
+
+constexpr u64 FRACTION_MASK = (1ULL << POSITION_FRACTION_BITS) - 1;
+
+// The vector downmix processes whole groups of eight samples
+static_assert(samples_per_frame % 8 == 0);
+
+s16 WidenPCM8(u8 sample) {
+    return static_cast<s16>(static_cast<u16>(sample) << 8);
+}
+
+s16 InterpolateLinear(s16 x0, s16 x1, u64 fraction) {
+    // This is a saturated subtraction. (Verified by black-box fuzzing.)
+    const s64 delta = std::clamp<s64>(x1 - x0, -32768, 32767);
+    // Rounds towards negative infinity, the firmware rounds the same way
+    return static_cast<s16>(x0 + ((static_cast<s64>(fraction) * delta) >> POSITION_FRACTION_BITS));
+}
+
+void InterpolateLinearScalar(const Sample* input, u64 position, u64 step, Sample* output,
+                             std::size_t count) {
+    for (std::size_t i = 0; i < count; ++i, position += step) {
+        const Sample& x0 = input[position >> POSITION_FRACTION_BITS];
+        const Sample& x1 = input[(position >> POSITION_FRACTION_BITS) + 1];
+        const u64 fraction = position & FRACTION_MASK;
+        output[i] = {InterpolateLinear(x0[0], x1[0], fraction),
+                     InterpolateLinear(x0[1], x1[1], fraction)};
+    }
+}
+
+/**
+ * Positions of four consecutive output samples, for the vector interpolation kernels. Only the
+ * fractional bits are kept in vector lanes, so those lanes are tracked modulo 2^32.
+ */
+struct LinearPositions {
+    u64 position;
+    u64 step;
+    std::array<u32, 4> lanes;
+
+    LinearPositions(u64 position_, u64 step_) : position(position_), step(step_) {
+        for (std::size_t i = 0; i < lanes.size(); ++i) {
+            lanes[i] = static_cast<u32>(position + i * step);
+        }
+    }
+
+    /// Index of the first sample of the pair used by the given lane
+    std::size_t Index(std::size_t lane) const {
+        return static_cast<std::size_t>((position + lane * step) >> POSITION_FRACTION_BITS);
+    }
+};
+
+} // Anonymous namespace
+
+#if defined(ARCHITECTURE_x86_64)
+
+void WidenPCM8Mono(const u8* input, std::size_t count, Sample* output) {
+    const __m128i zero = _mm_setzero_si128();
+    std::size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i));
+        // Interleaving with zero bytes below shifts each sample left by 8
+        const __m128i low = _mm_unpacklo_epi8(zero, bytes);
+        const __m128i high = _mm_unpackhi_epi8(zero, bytes);
+        __m128i* dst = reinterpret_cast<__m128i*>(output + i);
+        _mm_storeu_si128(dst + 0, _mm_unpacklo_epi16(low, low));
+        _mm_storeu_si128(dst + 1, _mm_unpackhi_epi16(low, low));
+        _mm_storeu_si128(dst + 2, _mm_unpacklo_epi16(high, high));
+        _mm_storeu_si128(dst + 3, _mm_unpackhi_epi16(high, high));
+    }
+    for (; i < count; ++i) {
+        output[i].fill(WidenPCM8(input[i]));
+    }
+}
+
+void WidenPCM8Stereo(const u8* input, std::size_t count, Sample* output) {
+    const __m128i zero = _mm_setzero_si128();
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i * 2));
+        __m128i* dst = reinterpret_cast<__m128i*>(output + i);
+        _mm_storeu_si128(dst + 0, _mm_unpacklo_epi8(zero, bytes));
+        _mm_storeu_si128(dst + 1, _mm_unpackhi_epi8(zero, bytes));
+    }
+    for (; i < count; ++i) {
+        output[i] = {WidenPCM8(input[i * 2]), WidenPCM8(input[i * 2 + 1])};
+    }
+}
+
+void WidenPCM16Mono(const u8* input, std::size_t count, Sample* output) {
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m128i samples =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i * sizeof(s16)));
+        __m128i* dst = reinterpret_cast<__m128i*>(output + i);
+        _mm_storeu_si128(dst + 0, _mm_unpacklo_epi16(samples, samples));
+        _mm_storeu_si128(dst + 1, _mm_unpackhi_epi16(samples, samples));
+    }
+    for (; i < count; ++i) {
+        s16 sample;
+        std::memcpy(&sample, input + i * sizeof(s16), sizeof(s16));
+        output[i].fill(sample);
+    }
+}
+
+void InterpolateLinear(const Sample* input, u64 position, u64 step, Sample* output,
+                       std::size_t count) {
+    // Sign extends the 16-bit lanes of the low or high half of a vector to 32 bits
+    const auto widen_low = [](__m128i v) { return _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16); };
+    const auto widen_high = [](__m128i v) { return _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16); };
+    // Truncates 32-bit lanes to 16 bits, packing with signed saturation after sign extension
+    const auto truncate = [](__m128i v) { return _mm_srai_epi32(_mm_slli_epi32(v, 16), 16); };
+
+    LinearPositions positions(position, step);
+    __m128i fraction_lanes =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(positions.lanes.data()));
+    const __m128i fraction_advance = _mm_set1_epi32(static_cast<s32>(4 * step));
+    const __m128i fraction_mask = _mm_set1_epi32(static_cast<s32>(FRACTION_MASK));
+
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        // Each 64-bit load reads the pair of samples of one output sample
+        const auto load_pair = [input, &positions](std::size_t lane) {
+            return _mm_castsi128_ps(_mm_loadl_epi64(
+                reinterpret_cast<const __m128i*>(input + positions.Index(lane))));
+        };
+        const __m128 pairs_a = _mm_movelh_ps(load_pair(0), load_pair(1));
+        const __m128 pairs_b = _mm_movelh_ps(load_pair(2), load_pair(3));
+        const __m128i x0 =
+            _mm_castps_si128(_mm_shuffle_ps(pairs_a, pairs_b, _MM_SHUFFLE(2, 0, 2, 0)));
+        const __m128i x1 =
+            _mm_castps_si128(_mm_shuffle_ps(pairs_a, pairs_b, _MM_SHUFFLE(3, 1, 3, 1)));
+        const __m128i delta = _mm_subs_epi16(x1, x0);
+
+        // Repeats a value below 2^15 in both 16-bit halves of each lane, once per channel
+        const auto repeat = [](__m128i v) { return _mm_or_si128(v, _mm_slli_epi32(v, 16)); };
+        const __m128i fraction = _mm_and_si128(fraction_lanes, fraction_mask);
+        const __m128i fraction_high = repeat(_mm_srli_epi32(fraction, 9));
+        const __m128i fraction_low = repeat(_mm_and_si128(fraction, _mm_set1_epi32(0x1FF)));
+        fraction_lanes = _mm_add_epi32(fraction_lanes, fraction_advance);
+        positions.position += 4 * step;
+
+        // fraction * delta >> 24 == (high * delta + (low * delta >> 9)) >> 15, rounding down
+        const __m128i high_lo = _mm_mullo_epi16(fraction_high, delta);
+        const __m128i high_hi = _mm_mulhi_epi16(fraction_high, delta);
+        const __m128i low_lo = _mm_mullo_epi16(fraction_low, delta);
+        const __m128i low_hi = _mm_mulhi_epi16(fraction_low, delta);
+        const auto step_of = [](__m128i high, __m128i low) {
+            return _mm_srai_epi32(_mm_add_epi32(high, _mm_srai_epi32(low, 9)), 15);
+        };
+        const __m128i step_a = step_of(_mm_unpacklo_epi16(high_lo, high_hi),
+                                       _mm_unpacklo_epi16(low_lo, low_hi));
+        const __m128i step_b = step_of(_mm_unpackhi_epi16(high_lo, high_hi),
+                                       _mm_unpackhi_epi16(low_lo, low_hi));
+
+        const __m128i result_a = truncate(_mm_add_epi32(widen_low(x0), step_a));
+        const __m128i result_b = truncate(_mm_add_epi32(widen_high(x0), step_b));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i),
+                         _mm_packs_epi32(result_a, result_b));
+    }
+    InterpolateLinearScalar(input, positions.position, step, output + i, count - i);
+}
+
+void MixIntoQuad(const StereoFrame16& input, const std::array<float, 4>& gains,
+                 QuadFrame32& dest) {
+    const __m128 gain = _mm_loadu_ps(gains.data());
+    for (std::size_t i = 0; i < input.size(); ++i) {
+        u32 pair;
+        std::memcpy(&pair, &input[i], sizeof(pair));
+        // Lanes hold left, right, left, right
+        const __m128i samples = _mm_set1_epi32(static_cast<s32>(pair));
+        const __m128i widened = _mm_srai_epi32(_mm_unpacklo_epi16(samples, samples), 16);
+        const __m128i scaled = _mm_cvttps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(widened), gain));
+        __m128i* dst = reinterpret_cast<__m128i*>(dest[i].data());
+        _mm_storeu_si128(dst, _mm_add_epi32(_mm_loadu_si128(dst), scaled));
+    }
+}
+
+void DownmixStereo(const QuadFrame32& input, float gain, StereoFrame16& dest) {
+    const __m128 gains = _mm_set1_ps(gain);
+    const auto scale = [&gains, &input](std::size_t i) {
+        const __m128i quad = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input[i].data()));
+        return _mm_mul_ps(_mm_cvtepi32_ps(quad), gains);
+    };
+    // Lanes hold the left and right channels of two samples
+    const auto downmix_pair = [&scale](std::size_t i) {
+        const __m128 a = scale(i);
+        const __m128 b = scale(i + 1);
+        return _mm_cvttps_epi32(_mm_add_ps(_mm_movelh_ps(a, b), _mm_movehl_ps(b, a)));
+    };
+
+    for (std::size_t i = 0; i < input.size(); i += 4) {
+        const __m128i mixed = _mm_packs_epi32(downmix_pair(i), downmix_pair(i + 2));
+        __m128i* dst = reinterpret_cast<__m128i*>(dest[i].data());
+        _mm_storeu_si128(dst, _mm_adds_epi16(_mm_loadu_si128(dst), mixed));
+    }
+}
+
+void DownmixMono(const QuadFrame32& input, float gain, StereoFrame16& dest) {
+    const __m128 gains = _mm_set1_ps(gain);
+    const auto scale = [&gains, &input](std::size_t i) {
+        const __m128i quad = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input[i].data()));
+        return _mm_mul_ps(_mm_cvtepi32_ps(quad), gains);
+    };
+    // Lanes hold four consecutive samples, the channels are added in the same order as the
+    // scalar code to get the same rounding
+    const auto downmix_four = [&scale](std::size_t i) {
+        __m128 c0 = scale(i);
+        __m128 c1 = scale(i + 1);
+        __m128 c2 = scale(i + 2);
+        __m128 c3 = scale(i + 3);
+        _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+        const __m128 sum = _mm_add_ps(_mm_add_ps(_mm_add_ps(c0, c1), c2), c3);
+        return _mm_cvttps_epi32(_mm_mul_ps(sum, _mm_set1_ps(0.5f)));
+    };
+
+    for (std::size_t i = 0; i < input.size(); i += 8) {
+        const __m128i mono = _mm_packs_epi32(downmix_four(i), downmix_four(i + 4));
+        __m128i* dst = reinterpret_cast<__m128i*>(dest[i].data());
+        _mm_storeu_si128(dst + 0,
+                         _mm_adds_epi16(_mm_loadu_si128(dst + 0), _mm_unpacklo_epi16(mono, mono)));
+        _mm_storeu_si128(dst + 1,
+                         _mm_adds_epi16(_mm_loadu_si128(dst + 1), _mm_unpackhi_epi16(mono, mono)));
+    }
+}
+
+#elif defined(ARCHITECTURE_ARM64)
+
+void WidenPCM8Mono(const u8* input, std::size_t count, Sample* output) {
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const int16x8_t samples = vreinterpretq_s16_u16(vshll_n_u8(vld1_u8(input + i), 8));
+        vst2q_s16(reinterpret_cast<s16*>(output + i), int16x8x2_t{{samples, samples}});
+    }
+    for (; i < count; ++i) {
+        output[i].fill(WidenPCM8(input[i]));
+    }
+}
+
+void WidenPCM8Stereo(const u8* input, std::size_t count, Sample* output) {
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const uint16x8_t samples = vshll_n_u8(vld1_u8(input + i * 2), 8);
+        vst1q_u16(reinterpret_cast<u16*>(output + i), samples);
+    }
+    for (; i < count; ++i) {
+        output[i] = {WidenPCM8(input[i * 2]), WidenPCM8(input[i * 2 + 1])};
+    }
+}
+
+void WidenPCM16Mono(const u8* input, std::size_t count, Sample* output) {
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const int16x8_t samples =
+            vreinterpretq_s16_u8(vld1q_u8(input + i * sizeof(s16)));
+        vst2q_s16(reinterpret_cast<s16*>(output + i), int16x8x2_t{{samples, samples}});
+    }
+    for (; i < count; ++i) {
+        s16 sample;
+        std::memcpy(&sample, input + i * sizeof(s16), sizeof(s16));
+        output[i].fill(sample);
+    }
+}
+
+void InterpolateLinear(const Sample* input, u64 position, u64 step, Sample* output,
+                       std::size_t count) {
+    LinearPositions positions(position, step);
+    uint32x4_t fraction_lanes = vld1q_u32(positions.lanes.data());
+    const uint32x4_t fraction_advance = vdupq_n_u32(static_cast<u32>(4 * step));
+    const uint32x4_t fraction_mask = vdupq_n_u32(static_cast<u32>(FRACTION_MASK));
+
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        // Each 64-bit load reads the pair of samples of one output sample
+        const auto load_pair = [input, &positions](std::size_t lane) {
+            return vld1_u32(reinterpret_cast<const u32*>(input + positions.Index(lane)));
+        };
+        const uint32x4_t pairs_a = vcombine_u32(load_pair(0), load_pair(1));
+        const uint32x4_t pairs_b = vcombine_u32(load_pair(2), load_pair(3));
+        const int16x8_t x0 = vreinterpretq_s16_u32(vuzp1q_u32(pairs_a, pairs_b));
+        const int16x8_t delta = vqsubq_s16(vreinterpretq_s16_u32(vuzp2q_u32(pairs_a, pairs_b)), x0);
+
+        // Repeats a value below 2^15 in both 16-bit halves of each lane, once per channel
+        const auto repeat = [](uint32x4_t v) {
+            return vreinterpretq_s16_u32(vorrq_u32(v, vshlq_n_u32(v, 16)));
+        };
+        const uint32x4_t fraction = vandq_u32(fraction_lanes, fraction_mask);
+        const int16x8_t fraction_high = repeat(vshrq_n_u32(fraction, 9));
+        const int16x8_t fraction_low = repeat(vandq_u32(fraction, vdupq_n_u32(0x1FF)));
+        fraction_lanes = vaddq_u32(fraction_lanes, fraction_advance);
+        positions.position += 4 * step;
+
+        // fraction * delta >> 24 == (high * delta + (low * delta >> 9)) >> 15, rounding down
+        const int32x4_t step_a = vshrq_n_s32(
+            vaddq_s32(vmull_s16(vget_low_s16(fraction_high), vget_low_s16(delta)),
+                      vshrq_n_s32(vmull_s16(vget_low_s16(fraction_low), vget_low_s16(delta)), 9)),
+            15);
+        const int32x4_t step_b = vshrq_n_s32(
+            vaddq_s32(vmull_high_s16(fraction_high, delta),
+                      vshrq_n_s32(vmull_high_s16(fraction_low, delta), 9)),
+            15);
+
+        const int16x4_t result_a = vmovn_s32(vaddw_s16(step_a, vget_low_s16(x0)));
+        const int16x4_t result_b = vmovn_s32(vaddw_high_s16(step_b, x0));
+        vst1q_s16(reinterpret_cast<s16*>(output + i), vcombine_s16(result_a, result_b));
+    }
+    InterpolateLinearScalar(input, positions.position, step, output + i, count - i);
+}
+
+void MixIntoQuad(const StereoFrame16& input, const std::array<float, 4>& gains,
+                 QuadFrame32& dest) {
+    const float32x4_t gain = vld1q_f32(gains.data());
+    for (std::size_t i = 0; i < input.size(); ++i) {
+        // Lanes hold left, right, left, right
+        const int16x4_t samples = vreinterpret_s16_s32(vld1_dup_s32(
+            reinterpret_cast<const s32*>(input[i].data())));
+        const int32x4_t scaled = vcvtq_s32_f32(vmulq_f32(vcvtq_f32_s32(vmovl_s16(samples)), gain));
+        vst1q_s32(dest[i].data(), vaddq_s32(vld1q_s32(dest[i].data()), scaled));
+    }
+}
+
+void DownmixStereo(const QuadFrame32& input, float gain, StereoFrame16& dest) {
+    for (std::size_t i = 0; i < input.size(); i += 4) {
+        // Each vector holds one channel of four samples
+        const int32x4x4_t channels = vld4q_s32(input[i].data());
+        const auto scale = [gain](int32x4_t channel) {
+            return vmulq_n_f32(vcvtq_f32_s32(channel), gain);
+        };
+        const int32x4_t left =
+            vcvtq_s32_f32(vaddq_f32(scale(channels.val[0]), scale(channels.val[2])));
+        const int32x4_t right =
+            vcvtq_s32_f32(vaddq_f32(scale(channels.val[1]), scale(channels.val[3])));
+
+        int16x4x2_t accumulator = vld2_s16(dest[i].data());
+        accumulator.val[0] = vqadd_s16(accumulator.val[0], vqmovn_s32(left));
+        accumulator.val[1] = vqadd_s16(accumulator.val[1], vqmovn_s32(right));
+        vst2_s16(dest[i].data(), accumulator);
+    }
+}
+
+void DownmixMono(const QuadFrame32& input, float gain, StereoFrame16& dest) {
+    for (std::size_t i = 0; i < input.size(); i += 4) {
+        // Each vector holds one channel of four samples, they are added in the same order as the
+        // scalar code to get the same rounding
+        const int32x4x4_t channels = vld4q_s32(input[i].data());
+        const auto scale = [gain](int32x4_t channel) {
+            return vmulq_n_f32(vcvtq_f32_s32(channel), gain);
+        };
+        const float32x4_t sum =
+            vaddq_f32(vaddq_f32(vaddq_f32(scale(channels.val[0]), scale(channels.val[1])),
+                                scale(channels.val[2])),
+                      scale(channels.val[3]));
+        const int16x4_t mono = vqmovn_s32(vcvtq_s32_f32(vmulq_n_f32(sum, 0.5f)));
+
+        int16x4x2_t accumulator = vld2_s16(dest[i].data());
+        accumulator.val[0] = vqadd_s16(accumulator.val[0], mono);
+        accumulator.val[1] = vqadd_s16(accumulator.val[1], mono);
+        vst2_s16(dest[i].data(), accumulator);
+    }
+}
+
+#else
+
+namespace {
+
+s16 ClampToS16(s32 value) {
+    return static_cast<s16>(std::clamp(value, -32768, 32767));
+}
+
+s16 AddAndClampToS16(s16 a, s16 b) {
+    return ClampToS16(static_cast<s32>(a) + static_cast<s32>(b));
+}
+
+} // Anonymous namespace
+
+void WidenPCM8Mono(const u8* input, std::size_t count, Sample* output) {
+    for (std::size_t i = 0; i < count; ++i) {
+        output[i].fill(WidenPCM8(input[i]));
+    }
+}
+
+void WidenPCM8Stereo(const u8* input, std::size_t count, Sample* output) {
+    for (std::size_t i = 0; i < count; ++i) {
+        output[i] = {WidenPCM8(input[i * 2]), WidenPCM8(input[i * 2 + 1])};
+    }
+}
+
+void WidenPCM16Mono(const u8* input, std::size_t count, Sample* output) {
+    for (std::size_t i = 0; i < count; ++i) {
+        s16 sample;
+        std::memcpy(&sample, input + i * sizeof(s16), sizeof(s16));
+        output[i].fill(sample);
+    }
+}
+
+void InterpolateLinear(const Sample* input, u64 position, u64 step, Sample* output,
+                       std::size_t count) {
+    InterpolateLinearScalar(input, position, step, output, count);
+}
+
+void MixIntoQuad(const StereoFrame16& input, const std::array<float, 4>& gains,
+                 QuadFrame32& dest) {
+    for (std::size_t i = 0; i < input.size(); ++i) {
+        dest[i][0] += static_cast<s32>(gains[0] * input[i][0]);
+        dest[i][1] += static_cast<s32>(gains[1] * input[i][1]);
+        dest[i][2] += static_cast<s32>(gains[2] * input[i][0]);
+        dest[i][3] += static_cast<s32>(gains[3] * input[i][1]);
+    }
+}
+
+void DownmixStereo(const QuadFrame32& input, float gain, StereoFrame16& dest) {
+    for (std::size_t i = 0; i < input.size(); ++i) {
+        const s16 left = ClampToS16(static_cast<s32>(gain * input[i][0] + gain * input[i][2]));
+        const s16 right = ClampToS16(static_cast<s32>(gain * input[i][1] + gain * input[i][3]));
+        dest[i] = {AddAndClampToS16(dest[i][0], left), AddAndClampToS16(dest[i][1], right)};
+    }
+}
+
+void DownmixMono(const QuadFrame32& input, float gain, StereoFrame16& dest) {
+    for (std::size_t i = 0; i < input.size(); ++i) {
+        const s16 mono = ClampToS16(static_cast<s32>(
+            (gain * input[i][0] + gain * input[i][1] + gain * input[i][2] + gain * input[i][3]) /
+            2));
+        dest[i] = {AddAndClampToS16(dest[i][0], mono), AddAndClampToS16(dest[i][1], mono)};
+    }
+}
+
+#endif
+
+void InterpolateNone(const Sample* input, u64 position, u64 step, Sample* output,
+                     std::size_t count) {
+    for (std::size_t i = 0; i < count; ++i, position += step) {
+        output[i] = input[position >> POSITION_FRACTION_BITS];
+    }
+}
+
+} // namespace AudioCore::Kernels
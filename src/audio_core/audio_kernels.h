@@ -0,0 +1,60 @@
+// Copyright 2022 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include "audio_core/audio_types.h"
+#include "common/common_types.h"
+
+/**
+ * Vectorized sample processing used by the HLE DSP. Every kernel produces exactly the same result
+ * as the per-sample code it replaces, the vector paths (SSE2 on x86-64, NEON on ARM64) only
+ * process several samples at once and the scalar path handles the remainder.
+ */
+namespace AudioCore::Kernels {
+
+using Sample = StereoBuffer16::Sample;
+
+/// Number of fractional bits of positions in the interpolation kernels
+constexpr u32 POSITION_FRACTION_BITS = 24;
+
+/// Widens unsigned 8-bit mono samples to PCM16 on both channels
+void WidenPCM8Mono(const u8* input, std::size_t count, Sample* output);
+
+/// Widens unsigned 8-bit interleaved stereo samples to PCM16
+void WidenPCM8Stereo(const u8* input, std::size_t count, Sample* output);
+
+/// Copies little endian PCM16 mono samples to both channels
+void WidenPCM16Mono(const u8* input, std::size_t count, Sample* output);
+
+/**
+ * Zero-order hold resampling: output[i] = input[position_i >> POSITION_FRACTION_BITS], where
+ * position_i = position + i * step. All input samples referenced must exist.
+ */
+void InterpolateNone(const Sample* input, u64 position, u64 step, Sample* output,
+                     std::size_t count);
+
+/**
+ * First-order hold resampling between input[index_i] and input[index_i + 1], where index_i is the
+ * integer part of position + i * step. The difference of the two samples is saturated and the
+ * result wraps around, matching the firmware.
+ */
+void InterpolateLinear(const Sample* input, u64 position, u64 step, Sample* output,
+                       std::size_t count);
+
+/**
+ * Applies the four gains of an intermediate mix to a stereo frame and accumulates the result:
+ * dest[i] += {gains[0] * left, gains[1] * right, gains[2] * left, gains[3] * right}
+ */
+void MixIntoQuad(const StereoFrame16& input, const std::array<float, 4>& gains, QuadFrame32& dest);
+
+/// Downmixes a quadraphonic frame to stereo with gain and adds it to dest, saturating
+void DownmixStereo(const QuadFrame32& input, float gain, StereoFrame16& dest);
+
+/// Downmixes a quadraphonic frame to mono with gain and adds it to both channels, saturating
+void DownmixMono(const QuadFrame32& input, float gain, StereoFrame16& dest);
+
+} // namespace AudioCore::Kernels
@@ -4,9 +4,11 @@
 
 #pragma once
 
+#include <algorithm>
 #include <array>
 #include <cstddef>
-#include <deque>
+#include <vector>
+#include <boost/serialization/access.hpp>
 #include "common/common_types.h"
 
 namespace AudioCore {
@@ -23,8 +25,70 @@ using StereoFrame16 = std::array<std::array<s16, 2>, samples_per_frame>;
 /// The DSP is quadraphonic internally.
 using QuadFrame32 = std::array<std::array<s32, 4>, samples_per_frame>;
 
-/// A variable length buffer of signed PCM16 stereo samples.
-using StereoBuffer16 = std::deque<std::array<s16, 2>>;
+/**
+ * A variable length buffer of signed PCM16 stereo samples that is consumed from the front.
+ * Samples are stored contiguously and consuming them only advances a read position, so once the
+ * storage has grown to the size of the largest buffer, refilling it doesn't allocate.
+ */
+class StereoBuffer16 {
+public:
+    using Sample = std::array<s16, 2>;
+
+    bool Empty() const {
+        return read_position == samples.size();
+    }
+
+    /// Returns the number of samples that haven't been consumed yet
+    std::size_t Size() const {
+        return samples.size() - read_position;
+    }
+
+    /// Returns the samples that haven't been consumed yet
+    const Sample* Data() const {
+        return samples.data() + read_position;
+    }
+
+    const Sample& operator[](std::size_t index) const {
+        return samples[read_position + index];
+    }
+
+    /// Discards all samples
+    void Clear() {
+        samples.clear();
+        read_position = 0;
+    }
+
+    /**
+     * Discards all samples and replaces them with count zeroed samples.
+     * @return Pointer to the new samples, valid until the next call to Reset
+     */
+    Sample* Reset(std::size_t count) {
+        Clear();
+        samples.resize(count);
+        return samples.data();
+    }
+
+    /// Consumes count samples from the front of the buffer
+    void Consume(std::size_t count) {
+        read_position += std::min(count, Size());
+    }
+
+private:
+    std::vector<Sample> samples;
+    std::size_t read_position = 0;
+
+    template <class Archive>
+    void serialize(Archive& ar, const unsigned int) {
+        // Only the samples that haven't been consumed are stored
+        std::vector<Sample> remaining(samples.begin() + read_position, samples.end());
+        ar& remaining;
+        if (Archive::is_loading::value) {
+            samples = std::move(remaining);
+            read_position = 0;
+        }
+    }
+    friend class boost::serialization::access;
+};
 
 constexpr std::size_t num_dsp_pipe = 8;
 enum class DspPipe {
@@ -6,6 +6,7 @@
 #include <array>
 #include <cstddef>
 #include <cstring>
+#include "audio_core/audio_kernels.h"
 #include "audio_core/audio_types.h"
 #include "audio_core/codec.h"
 #include "common/assert.h"
@@ -13,8 +14,9 @@
 
 namespace AudioCore::Codec {
 
-StereoBuffer16 DecodeADPCM(const u8* const data, const std::size_t sample_count,
-                           const std::array<s16, 16>& adpcm_coeff, ADPCMState& state) {
+void DecodeADPCM(const u8* const data, const std::size_t sample_count,
+                 const std::array<s16, 16>& adpcm_coeff, ADPCMState& state,
+                 StereoBuffer16& output) {
     // GC-ADPCM with scale factor and variable coefficients.
     // Frames are 8 bytes long containing 14 samples each.
     // Samples are 4 bits (one nibble) long.
@@ -27,7 +29,7 @@ StereoBuffer16 DecodeADPCM(const u8* const data, const std::size_t sample_count,
 
     const std::size_t ret_size =
         sample_count % 2 == 0 ? sample_count : sample_count + 1; // Ensure multiple of two.
-    StereoBuffer16 ret(ret_size);
+    StereoBuffer16::Sample* const ret = output.Reset(ret_size);
 
     int yn1 = state.yn1, yn2 = state.yn2;
 
@@ -75,52 +77,32 @@ StereoBuffer16 DecodeADPCM(const u8* const data, const std::size_t sample_count,
 
     state.yn1 = static_cast<s16>(yn1);
     state.yn2 = static_cast<s16>(yn2);
-
-    return ret;
 }
 
-StereoBuffer16 DecodePCM8(const unsigned num_channels, const u8* const data,
-                          const std::size_t sample_count) {
+void DecodePCM8(const unsigned num_channels, const u8* const data, const std::size_t sample_count,
+                StereoBuffer16& output) {
     ASSERT(num_channels == 1 || num_channels == 2);
 
-    const auto decode_sample = [](u8 sample) {
-        return static_cast<s16>(static_cast<u16>(sample) << 8);
-    };
-
-    StereoBuffer16 ret(sample_count);
+    StereoBuffer16::Sample* const ret = output.Reset(sample_count);
 
     if (num_channels == 1) {
-        for (std::size_t i = 0; i < sample_count; i++) {
-            ret[i].fill(decode_sample(data[i]));
-        }
+        Kernels::WidenPCM8Mono(data, sample_count, ret);
     } else {
-        for (std::size_t i = 0; i < sample_count; i++) {
-            ret[i][0] = decode_sample(data[i * 2 + 0]);
-            ret[i][1] = decode_sample(data[i * 2 + 1]);
-        }
+        Kernels::WidenPCM8Stereo(data, sample_count, ret);
     }
-
-    return ret;
 }
 
-StereoBuffer16 DecodePCM16(const unsigned num_channels, const u8* const data,
-                           const std::size_t sample_count) {
+void DecodePCM16(const unsigned num_channels, const u8* const data, const std::size_t sample_count,
+                 StereoBuffer16& output) {
     ASSERT(num_channels == 1 || num_channels == 2);
 
-    StereoBuffer16 ret(sample_count);
+    StereoBuffer16::Sample* const ret = output.Reset(sample_count);
 
     if (num_channels == 1) {
-        for (std::size_t i = 0; i < sample_count; i++) {
-            s16 sample;
-            std::memcpy(&sample, data + i * sizeof(s16), sizeof(s16));
-            ret[i].fill(sample);
-        }
+        Kernels::WidenPCM16Mono(data, sample_count, ret);
     } else {
-        for (std::size_t i = 0; i < sample_count; ++i) {
-            std::memcpy(&ret[i], data + i * sizeof(s16) * 2, 2 * sizeof(s16));
-        }
+        // Interleaved stereo samples are already in the layout of the buffer
+        std::memcpy(ret, data, sample_count * sizeof(StereoBuffer16::Sample));
     }
-
-    return ret;
 }
 } // namespace AudioCore::Codec
@@ -21,6 +21,7 @@ void DspInterface::SetSink(const std::string& sink_id, const std::string& audio_
     sink->SetCallback(
         [this](s16* buffer, std::size_t num_frames) { OutputCallback(buffer, num_frames); });
     time_stretcher.SetOutputSampleRate(sink->GetNativeSampleRate());
+    latency_controller.SetSampleRate(sink->GetNativeSampleRate());
 }
 
 Sink& DspInterface::GetSink() {
@@ -38,6 +39,15 @@ void DspInterface::EnableStretching(bool enable) {
     perform_time_stretching = enable;
 }
 
+DspInterface::OutputStats DspInterface::GetOutputStats() const {
+    return {
+        .buffered_frames = stats_buffered_frames.load(std::memory_order_relaxed),
+        .target_latency = stats_target_latency.load(std::memory_order_relaxed),
+        .callback_jitter = stats_callback_jitter.load(std::memory_order_relaxed),
+        .underruns = stats_underruns.load(std::memory_order_relaxed),
+    };
+}
+
 void DspInterface::OutputFrame(StereoFrame16 frame) {
     if (!sink)
         return;
@@ -61,11 +71,14 @@ void DspInterface::OutputSample(std::array<s16, 2> sample) {
 }
 
 void DspInterface::OutputCallback(s16* buffer, std::size_t num_frames) {
+    const auto callback_time = LatencyController::Clock::now();
+
     std::size_t frames_written;
     if (perform_time_stretching) {
-        const std::vector<s16> in{fifo.Pop()};
-        const std::size_t num_in{in.size() / 2};
-        frames_written = time_stretcher.Process(in.data(), num_in, buffer, num_frames);
+        time_stretcher.SetTargetLatency(latency_controller.GetTargetLatency());
+        const std::size_t num_in = fifo.Pop(stretcher_input.data(), fifo_capacity);
+        frames_written =
+            time_stretcher.Process(stretcher_input.data(), num_in, buffer, num_frames);
     } else if (flushing_time_stretcher) {
         time_stretcher.Flush();
         frames_written = time_stretcher.Process(nullptr, 0, buffer, num_frames);
@@ -75,6 +88,13 @@ void DspInterface::OutputCallback(s16* buffer, std::size_t num_frames) {
         frames_written = fifo.Pop(buffer, num_frames);
     }
 
+    latency_controller.RecordCallback(callback_time, num_frames, frames_written);
+    stats_buffered_frames.store(fifo.Size() + time_stretcher.GetBacklog(),
+                                std::memory_order_relaxed);
+    stats_target_latency.store(latency_controller.GetTargetLatency(), std::memory_order_relaxed);
+    stats_callback_jitter.store(latency_controller.GetCallbackJitter(), std::memory_order_relaxed);
+    stats_underruns.store(latency_controller.GetUnderrunCount(), std::memory_order_relaxed);
+
     if (frames_written > 0) {
         std::memcpy(&last_frame[0], buffer + 2 * (frames_written - 1), 2 * sizeof(s16));
     }
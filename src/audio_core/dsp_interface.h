@@ -4,10 +4,12 @@
 
 #pragma once
 
+#include <atomic>
 #include <memory>
 #include <vector>
 #include <boost/serialization/access.hpp>
 #include "audio_core/audio_types.h"
+#include "audio_core/latency_controller.h"
 #include "audio_core/time_stretch.h"
 #include "common/common_types.h"
 #include "common/ring_buffer.h"
@@ -100,6 +102,21 @@ public:
     /// Enable/Disable audio stretching.
     void EnableStretching(bool enable);
 
+    struct OutputStats {
+        /// Frames waiting to be played, as of the last sink callback
+        std::size_t buffered_frames;
+        /// Latency the time stretcher aims for, in seconds
+        double target_latency;
+        /// Smoothed deviation of the interval between sink callbacks from the expected one, in
+        /// seconds
+        double callback_jitter;
+        /// Number of times the sink ran out of audio
+        u64 underruns;
+    };
+
+    /// Returns statistics about the audio output, can be called from any thread
+    OutputStats GetOutputStats() const;
+
 protected:
     void OutputFrame(StereoFrame16 frame);
     void OutputSample(std::array<s16, 2> sample);
@@ -108,13 +125,25 @@ private:
     void FlushResidualStretcherAudio();
     void OutputCallback(s16* buffer, std::size_t num_frames);
 
+    static constexpr std::size_t fifo_capacity = 0x2000;
+
     std::atomic<bool> perform_time_stretching = false;
     std::atomic<bool> flushing_time_stretcher = false;
-    Common::RingBuffer<s16, 0x2000, 2> fifo;
+    Common::RingBuffer<s16, fifo_capacity, 2> fifo;
+    /// Frames popped from the fifo for the time stretcher, kept around to avoid allocations in the
+    /// sink callback
+    std::array<s16, fifo_capacity * 2> stretcher_input{};
     std::array<s16, 2> last_frame{};
     TimeStretcher time_stretcher;
+    LatencyController latency_controller{native_sample_rate};
     std::unique_ptr<Sink> sink;
 
+    // Output statistics, written by the sink callback
+    std::atomic<std::size_t> stats_buffered_frames = 0;
+    std::atomic<double> stats_target_latency = 0.0;
+    std::atomic<double> stats_callback_jitter = 0.0;
+    std::atomic<u64> stats_underruns = 0;
+
     template <class Archive>
     void serialize(Archive& ar, const unsigned int) {}
     friend class boost::serialization::access;
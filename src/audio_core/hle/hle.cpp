@@ -2,6 +2,8 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <thread>
 #include <boost/serialization/array.hpp>
 #include <boost/serialization/base_object.hpp>
 #include <boost/serialization/shared_ptr.hpp>
@@ -23,6 +25,7 @@
 #include "audio_core/hle/mixers.h"
 #include "audio_core/hle/shared_memory.h"
 #include "audio_core/hle/source.h"
+#include "audio_core/hle/source_processor.h"
 #include "audio_core/sink.h"
 #include "common/assert.h"
 #include "common/common_types.h"
@@ -30,6 +33,7 @@
 #include "common/logging/log.h"
 #include "core/core.h"
 #include "core/core_timing.h"
+#include "core/settings.h"
 
 SERIALIZE_EXPORT_IMPL(AudioCore::DspHle)
 
@@ -97,6 +101,8 @@ private:
     }};
     HLE::Mixers mixers{};
 
+    std::unique_ptr<HLE::SourceProcessor> source_processor;
+
     DspHle& parent;
     Core::TimingEventType* tick_event{};
 
@@ -123,6 +129,16 @@ DspHle::Impl::Impl(DspHle& parent_, Memory::MemorySystem& memory) : parent(paren
         source.SetMemory(memory);
     }
 
+    std::size_t num_source_threads = Settings::values.audio_source_threads;
+    if (num_source_threads == 0) {
+        num_source_threads = std::max(1U, std::thread::hardware_concurrency());
+    }
+    num_source_threads = std::min(num_source_threads, HLE::num_sources);
+    if (num_source_threads > 1) {
+        LOG_INFO(Audio_DSP, "Processing audio sources with {} threads", num_source_threads);
+    }
+    source_processor = std::make_unique<HLE::SourceProcessor>(num_source_threads);
+
 #if defined(HAVE_MF) && defined(HAVE_FFMPEG)
     decoder = std::make_unique<HLE::WMFDecoder>(memory);
     if (!decoder->IsValid()) {
@@ -402,16 +418,8 @@ StereoFrame16 DspHle::Impl::GenerateCurrentFrame() {
     HLE::SharedMemory& read = ReadRegion();
     HLE::SharedMemory& write = WriteRegion();
 
-    std::array<QuadFrame32, 3> intermediate_mixes = {};
-
     // Generate intermediate mixes
-    for (std::size_t i = 0; i < HLE::num_sources; i++) {
-        write.source_statuses.status[i] =
-            sources[i].Tick(read.source_configurations.config[i], read.adpcm_coefficients.coeff[i]);
-        for (std::size_t mix = 0; mix < 3; mix++) {
-            sources[i].MixInto(intermediate_mixes[mix], mix);
-        }
-    }
+    const auto intermediate_mixes = source_processor->Process(sources, read, write);
 
     // Generate final mix
     write.dsp_status = mixers.Tick(read.dsp_configuration, read.intermediate_mix_samples,
@@ -2,8 +2,8 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
-#include <algorithm>
 #include <cstddef>
+#include "audio_core/audio_kernels.h"
 #include "audio_core/hle/mixers.h"
 #include "common/assert.h"
 #include "common/logging/log.h"
@@ -84,32 +84,12 @@ void Mixers::ParseConfig(DspConfiguration& config) {
     config.dirty_raw = 0;
 }
 
-static s16 ClampToS16(s32 value) {
-    return static_cast<s16>(std::clamp(value, -32768, 32767));
-}
-
-static std::array<s16, 2> AddAndClampToS16(const std::array<s16, 2>& a,
-                                           const std::array<s16, 2>& b) {
-    return {ClampToS16(static_cast<s32>(a[0]) + static_cast<s32>(b[0])),
-            ClampToS16(static_cast<s32>(a[1]) + static_cast<s32>(b[1]))};
-}
-
 void Mixers::DownmixAndMixIntoCurrentFrame(float gain, const QuadFrame32& samples) {
     // TODO(merry): Limiter. (Currently we're performing final mixing assuming a disabled limiter.)
 
     switch (state.output_format) {
     case OutputFormat::Mono:
-        std::transform(
-            current_frame.begin(), current_frame.end(), samples.begin(), current_frame.begin(),
-            [gain](const std::array<s16, 2>& accumulator,
-                   const std::array<s32, 4>& sample) -> std::array<s16, 2> {
-                // Downmix to mono
-                s16 mono = ClampToS16(static_cast<s32>(
-                    (gain * sample[0] + gain * sample[1] + gain * sample[2] + gain * sample[3]) /
-                    2));
-                // Mix into current frame
-                return AddAndClampToS16(accumulator, {mono, mono});
-            });
+        Kernels::DownmixMono(samples, gain, current_frame);
         return;
 
     case OutputFormat::Surround:
@@ -117,16 +97,7 @@ void Mixers::DownmixAndMixIntoCurrentFrame(float gain, const QuadFrame32& sample
         // fallthrough
 
     case OutputFormat::Stereo:
-        std::transform(
-            current_frame.begin(), current_frame.end(), samples.begin(), current_frame.begin(),
-            [gain](const std::array<s16, 2>& accumulator,
-                   const std::array<s32, 4>& sample) -> std::array<s16, 2> {
-                // Downmix to stereo
-                s16 left = ClampToS16(static_cast<s32>(gain * sample[0] + gain * sample[2]));
-                s16 right = ClampToS16(static_cast<s32>(gain * sample[1] + gain * sample[3]));
-                // Mix into current frame
-                return AddAndClampToS16(accumulator, {left, right});
-            });
+        Kernels::DownmixStereo(samples, gain, current_frame);
         return;
     }
 
@@ -4,6 +4,7 @@
 
 #include <algorithm>
 #include <array>
+#include "audio_core/audio_kernels.h"
 #include "audio_core/codec.h"
 #include "audio_core/hle/common.h"
 #include "audio_core/hle/source.h"
@@ -29,14 +30,8 @@ void Source::MixInto(QuadFrame32& dest, std::size_t intermediate_mix_id) const {
     if (!state.enabled)
         return;
 
-    const std::array<float, 4>& gains = state.gain.at(intermediate_mix_id);
-    for (std::size_t samplei = 0; samplei < samples_per_frame; samplei++) {
-        // Conversion from stereo (current_frame) to quadraphonic (dest) occurs here.
-        dest[samplei][0] += static_cast<s32>(gains[0] * current_frame[samplei][0]);
-        dest[samplei][1] += static_cast<s32>(gains[1] * current_frame[samplei][1]);
-        dest[samplei][2] += static_cast<s32>(gains[2] * current_frame[samplei][0]);
-        dest[samplei][3] += static_cast<s32>(gains[3] * current_frame[samplei][1]);
-    }
+    // Conversion from stereo (current_frame) to quadraphonic (dest) occurs here.
+    Kernels::MixIntoQuad(current_frame, state.gain.at(intermediate_mix_id), dest);
 }
 
 void Source::Reset() {
@@ -193,19 +188,18 @@ void Source::ParseConfig(SourceConfiguration::Configuration& config,
                 // TODO(xperia64): This may just work fine like PCM16, but I haven't tested and
                 // couldn't find any test case games
                 UNIMPLEMENTED_MSG("{} not handled for partial buffer updates", "PCM8");
-                // state.current_buffer = Codec::DecodePCM8(num_channels, memory, config.length);
+                // Codec::DecodePCM8(num_channels, memory, config.length, state.current_buffer);
                 break;
             case Format::PCM16:
-                state.current_buffer = Codec::DecodePCM16(num_channels, memory, config.length);
+                Codec::DecodePCM16(num_channels, memory, config.length, state.current_buffer);
                 valid = true;
                 break;
             case Format::ADPCM:
                 // TODO(xperia64): Are partial embedded buffer updates even valid for ADPCM? What
                 // about the adpcm state?
                 UNIMPLEMENTED_MSG("{} not handled for partial buffer updates", "ADPCM");
-                /* state.current_buffer =
-                    Codec::DecodeADPCM(memory, config.length, state.adpcm_coeffs,
-                   state.adpcm_state); */
+                /* Codec::DecodeADPCM(memory, config.length, state.adpcm_coeffs,
+                   state.adpcm_state, state.current_buffer); */
                 break;
             default:
                 UNIMPLEMENTED();
@@ -221,12 +215,10 @@ void Source::ParseConfig(SourceConfiguration::Configuration& config,
                 // TODO(xperia64): Tomodachi life apparently can decrease config.length when the
                 // user skips dialog. I don't know the correct behavior, but to avoid crashing, just
                 // reset the current sample number to 0 and don't try to truncate the buffer
-                if (state.current_buffer.size() < state.current_sample_number) {
+                if (state.current_buffer.Size() < state.current_sample_number) {
                     state.current_sample_number = 0;
                 } else {
-                    state.current_buffer.erase(
-                        state.current_buffer.begin(),
-                        std::next(state.current_buffer.begin(), state.current_sample_number));
+                    state.current_buffer.Consume(state.current_sample_number);
                 }
             }
         }
@@ -319,7 +311,7 @@ void Source::ParseConfig(SourceConfiguration::Configuration& config,
 void Source::GenerateFrame() {
     current_frame.fill({});
 
-    if (state.current_buffer.empty() && !DequeueBuffer()) {
+    if (state.current_buffer.Empty() && !DequeueBuffer()) {
         state.enabled = false;
         state.buffer_update = true;
         state.current_buffer_id = 0;
@@ -330,7 +322,7 @@ void Source::GenerateFrame() {
 
     state.current_sample_number = state.next_sample_number;
     while (frame_position < current_frame.size()) {
-        if (state.current_buffer.empty() && !DequeueBuffer()) {
+        if (state.current_buffer.Empty() && !DequeueBuffer()) {
             break;
         }
 
@@ -361,7 +353,7 @@ void Source::GenerateFrame() {
 }
 
 bool Source::DequeueBuffer() {
-    ASSERT_MSG(state.current_buffer.empty(),
+    ASSERT_MSG(state.current_buffer.Empty(),
                "Shouldn't dequeue; we still have data in current_buffer");
 
     if (state.input_queue.empty())
@@ -382,15 +374,15 @@ bool Source::DequeueBuffer() {
         const unsigned num_channels = buf.mono_or_stereo == MonoOrStereo::Stereo ? 2 : 1;
         switch (buf.format) {
         case Format::PCM8:
-            state.current_buffer = Codec::DecodePCM8(num_channels, memory, buf.length);
+            Codec::DecodePCM8(num_channels, memory, buf.length, state.current_buffer);
             break;
         case Format::PCM16:
-            state.current_buffer = Codec::DecodePCM16(num_channels, memory, buf.length);
+            Codec::DecodePCM16(num_channels, memory, buf.length, state.current_buffer);
             break;
         case Format::ADPCM:
             DEBUG_ASSERT(num_channels == 1);
-            state.current_buffer =
-                Codec::DecodeADPCM(memory, buf.length, state.adpcm_coeffs, state.adpcm_state);
+            Codec::DecodeADPCM(memory, buf.length, state.adpcm_coeffs, state.adpcm_state,
+                               state.current_buffer);
             break;
         default:
             UNIMPLEMENTED();
@@ -400,7 +392,7 @@ bool Source::DequeueBuffer() {
         LOG_WARNING(Audio_DSP,
                     "source_id={} buffer_id={} length={}: Invalid physical address {:#010x}",
                     source_id, buf.buffer_id, buf.length, buf.physical_address);
-        state.current_buffer.clear();
+        state.current_buffer.Clear();
         return true;
     }
 
@@ -417,7 +409,7 @@ bool Source::DequeueBuffer() {
     }
 
     LOG_TRACE(Audio_DSP, "source_id={} buffer_id={} from_queue={} current_buffer.size()={}",
-              source_id, buf.buffer_id, buf.from_queue, state.current_buffer.size());
+              source_id, buf.buffer_id, buf.from_queue, state.current_buffer.Size());
     return true;
 }
 
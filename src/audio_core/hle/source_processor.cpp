@@ -0,0 +1,71 @@
+// Copyright 2022 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include "audio_core/hle/source.h"
+#include "audio_core/hle/source_processor.h"
+#include "common/thread_worker.h"
+
+namespace AudioCore::HLE {
+
+SourceProcessor::SourceProcessor(std::size_t num_threads) {
+    if (num_threads > 1) {
+        // The calling thread processes a group of sources as well
+        workers = std::make_unique<Common::ThreadWorker>(num_threads - 1, "AudioSources");
+        worker_mixes.resize(num_threads - 1);
+    }
+}
+
+SourceProcessor::~SourceProcessor() = default;
+
+SourceProcessor::IntermediateMixes SourceProcessor::Process(
+    std::array<Source, num_sources>& sources, SharedMemory& read, SharedMemory& write) {
+    IntermediateMixes intermediate_mixes = {};
+    if (workers == nullptr) {
+        ProcessGroup(sources, read, write, 0, num_sources, intermediate_mixes);
+        return intermediate_mixes;
+    }
+
+    // Splits the sources into contiguous groups, one per thread
+    const std::size_t num_groups = worker_mixes.size() + 1;
+    const auto group_begin = [num_groups](std::size_t group) {
+        return group * num_sources / num_groups;
+    };
+    for (std::size_t group = 1; group < num_groups; group++) {
+        workers->QueueWork([this, &sources, &read, &write, group, group_begin] {
+            IntermediateMixes& mixes = worker_mixes[group - 1];
+            mixes = {};
+            ProcessGroup(sources, read, write, group_begin(group), group_begin(group + 1), mixes);
+        });
+    }
+    ProcessGroup(sources, read, write, 0, group_begin(1), intermediate_mixes);
+    workers->WaitForRequests();
+
+    // The mixes are sums of integers, so adding up the groups in any order gives exactly the same
+    // result as processing the sources serially. They are added in group order anyway.
+    for (const IntermediateMixes& mixes : worker_mixes) {
+        for (std::size_t mix = 0; mix < mixes.size(); mix++) {
+            for (std::size_t samplei = 0; samplei < samples_per_frame; samplei++) {
+                for (std::size_t channeli = 0; channeli < 4; channeli++) {
+                    intermediate_mixes[mix][samplei][channeli] += mixes[mix][samplei][channeli];
+                }
+            }
+        }
+    }
+    return intermediate_mixes;
+}
+
+void SourceProcessor::ProcessGroup(std::array<Source, num_sources>& sources,
+                                   SharedMemory& read, SharedMemory& write,
+                                   std::size_t first, std::size_t last, IntermediateMixes& mixes) {
+    // Sources only touch their own state and their own entries of the shared memory region
+    for (std::size_t i = first; i < last; i++) {
+        write.source_statuses.status[i] =
+            sources[i].Tick(read.source_configurations.config[i], read.adpcm_coefficients.coeff[i]);
+        for (std::size_t mix = 0; mix < 3; mix++) {
+            sources[i].MixInto(mixes[mix], mix);
+        }
+    }
+}
+
+} // namespace AudioCore::HLE
@@ -0,0 +1,53 @@
+// Copyright 2022 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <memory>
+#include <vector>
+#include "audio_core/audio_types.h"
+#include "audio_core/hle/common.h"
+#include "audio_core/hle/shared_memory.h"
+
+namespace Common {
+class ThreadWorker;
+}
+
+namespace AudioCore::HLE {
+
+class Source;
+
+/**
+ * Ticks the sources and sums their output into the intermediate mixes. Sources are split into
+ * contiguous groups that are processed in parallel, one group per thread.
+ */
+class SourceProcessor final {
+public:
+    using IntermediateMixes = std::array<QuadFrame32, 3>;
+
+    /// @param num_threads Number of threads processing sources, including the calling thread
+    explicit SourceProcessor(std::size_t num_threads);
+    ~SourceProcessor();
+
+    /**
+     * Ticks every source with its configuration from read, which clears its dirty flags, and writes
+     * its status to write.
+     * @returns The intermediate mixes, which are the same for any number of threads
+     */
+    IntermediateMixes Process(std::array<Source, num_sources>& sources, SharedMemory& read,
+                              SharedMemory& write);
+
+private:
+    void ProcessGroup(std::array<Source, num_sources>& sources, SharedMemory& read,
+                      SharedMemory& write, std::size_t first, std::size_t last,
+                      IntermediateMixes& mixes);
+
+    /// Processes the groups of sources after the first one, nullptr when single-threaded
+    std::unique_ptr<Common::ThreadWorker> workers;
+    /// Intermediate mixes of the groups of sources processed on workers
+    std::vector<IntermediateMixes> worker_mixes;
+};
+
+} // namespace AudioCore::HLE
@@ -3,6 +3,7 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
+#include "audio_core/audio_kernels.h"
 #include "audio_core/interpolate.h"
 #include "common/assert.h"
 
@@ -10,67 +11,77 @@ namespace AudioCore::AudioInterp {
 
 // Calculations are done in fixed point with 24 fractional bits.
 // (This is not verified. This was chosen for minimal error.)
-constexpr u64 scale_factor = 1 << 24;
-constexpr u64 scale_mask = scale_factor - 1;
+constexpr u64 scale_factor = 1 << Kernels::POSITION_FRACTION_BITS;
+
+using Sample = StereoBuffer16::Sample;
+using Kernel = void (*)(const Sample* input, u64 position, u64 step, Sample* output,
+                        std::size_t count);
 
 /// Here we step over the input in steps of rate, until we consume all of the input.
-/// Three adjacent samples are passed to fn each step.
-template <typename Function>
+/// Each output sample is produced by kernel from the input sample at its position and the next.
 static void StepOverSamples(State& state, StereoBuffer16& input, float rate, StereoFrame16& output,
-                            std::size_t& outputi, Function fn) {
+                            std::size_t& outputi, Kernel kernel) {
     ASSERT(rate > 0);
 
-    if (input.empty())
+    if (input.Empty())
         return;
 
-    input.insert(input.begin(), {state.xn2, state.xn1});
+    // The two historical samples precede the input, positions below are relative to xn2. A
+    // position is only used once the two samples following it are available.
+    const std::array<Sample, 3> head{state.xn2, state.xn1, input[0]};
+    const auto sample = [&head, &input](std::size_t index) -> const Sample& {
+        return index < 2 ? head[index] : input[index - 2];
+    };
+    const std::size_t input_size = input.Size() + 2;
+    const u64 end = static_cast<u64>(input_size - 2) * scale_factor;
 
     const u64 step_size = static_cast<u64>(rate * scale_factor);
     u64 fposition = state.fposition;
-    std::size_t inputi = 0;
+    std::size_t produced = 0;
 
-    while (outputi < output.size()) {
-        inputi = static_cast<std::size_t>(fposition / scale_factor);
-
-        if (inputi + 2 >= input.size()) {
-            inputi = input.size() - 2;
-            break;
+    // Runs the kernel over the positions before limit, samples holds the sample at base
+    const auto produce = [&](const Sample* samples, u64 base, u64 limit) {
+        if (outputi == output.size() || fposition >= limit) {
+            return;
         }
+        std::size_t count = output.size() - outputi;
+        if (step_size != 0) {
+            count = static_cast<std::size_t>(
+                std::min<u64>(count, (limit - fposition + step_size - 1) / step_size));
+        }
+        kernel(samples, fposition - base, step_size, output.data() + outputi, count);
+        outputi += count;
+        produced += count;
+        fposition += count * step_size;
+    };
+    // The first two positions read the historical samples, the others only read the input
+    produce(head.data(), 0, std::min(2 * scale_factor, end));
+    produce(input.Data(), 2 * scale_factor, end);
 
-        u64 fraction = fposition & scale_mask;
-        output[outputi++] = fn(fraction, input[inputi], input[inputi + 1], input[inputi + 2]);
-
-        fposition += step_size;
+    std::size_t inputi = 0;
+    if (outputi < output.size()) {
+        // Ran out of input
+        inputi = input_size - 2;
+    } else if (produced > 0) {
+        inputi = static_cast<std::size_t>((fposition - step_size) / scale_factor);
     }
 
-    state.xn2 = input[inputi];
-    state.xn1 = input[inputi + 1];
+    state.xn2 = sample(inputi);
+    state.xn1 = sample(inputi + 1);
     state.fposition = fposition - inputi * scale_factor;
 
-    input.erase(input.begin(), std::next(input.begin(), inputi + 2));
+    input.Consume(inputi);
 }
 
 void None(State& state, StereoBuffer16& input, float rate, StereoFrame16& output,
           std::size_t& outputi) {
-    StepOverSamples(
-        state, input, rate, output, outputi,
-        [](u64 fraction, const auto& x0, const auto& x1, const auto& x2) { return x0; });
+    StepOverSamples(state, input, rate, output, outputi, Kernels::InterpolateNone);
 }
 
 void Linear(State& state, StereoBuffer16& input, float rate, StereoFrame16& output,
             std::size_t& outputi) {
     // Note on accuracy: Some values that this produces are +/- 1 from the actual firmware.
-    StepOverSamples(state, input, rate, output, outputi,
-                    [](u64 fraction, const auto& x0, const auto& x1, const auto& x2) {
-                        // This is a saturated subtraction. (Verified by black-box fuzzing.)
-                        s64 delta0 = std::clamp<s64>(x1[0] - x0[0], -32768, 32767);
-                        s64 delta1 = std::clamp<s64>(x1[1] - x0[1], -32768, 32767);
-
-                        return std::array<s16, 2>{
-                            static_cast<s16>(x0[0] + fraction * delta0 / scale_factor),
-                            static_cast<s16>(x0[1] + fraction * delta1 / scale_factor),
-                        };
-                    });
+    StepOverSamples(state, input, rate, output, outputi, Kernels::InterpolateLinear);
 }
 
 } // namespace AudioCore::AudioInterp
@@ -5,15 +5,11 @@
 #pragma once
 
 #include <array>
-#include <deque>
 #include "audio_core/audio_types.h"
 #include "common/common_types.h"
 
 namespace AudioCore::AudioInterp {
 
-/// A variable length buffer of signed PCM16 stereo samples.
-using StereoBuffer16 = std::deque<std::array<s16, 2>>;
-
 struct State {
     /// Two historical samples.
     std::array<s16, 2> xn1 = {}; ///< x[n-1]
@@ -0,0 +1,49 @@
+// Copyright 2022 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cmath>
+#include "audio_core/latency_controller.h"
+
+namespace AudioCore {
+
+/// Headroom added by each underrun, in seconds
+constexpr double UNDERRUN_HEADROOM = 0.02;
+/// Time constant of the decay of the underrun headroom, in seconds
+constexpr double HEADROOM_DECAY_TIME = 10.0;
+
+LatencyController::LatencyController(unsigned int sample_rate_) : sample_rate(sample_rate_) {}
+
+void LatencyController::SetSampleRate(unsigned int sample_rate_) {
+    sample_rate = sample_rate_;
+    last_callback.reset();
+}
+
+void LatencyController::RecordCallback(Clock::time_point now, std::size_t num_frames,
+                                       std::size_t num_written) {
+    period = static_cast<double>(num_frames) / sample_rate;
+
+    if (last_callback) {
+        const double interval = std::chrono::duration<double>(now - *last_callback).count();
+        // Same estimator as the interarrival jitter of RTP (RFC 3550)
+        jitter += (std::abs(interval - period) - jitter) / 16.0;
+        headroom *= std::exp(-interval / HEADROOM_DECAY_TIME);
+    }
+    last_callback = now;
+
+    // Consecutive short callbacks are a single underrun, this also keeps pauses and the silence
+    // before the first frame from counting
+    const bool short_callback = num_written < num_frames;
+    if (short_callback && !starved) {
+        ++underruns;
+        headroom = std::min(headroom + UNDERRUN_HEADROOM, MAX_LATENCY);
+    }
+    starved = short_callback;
+}
+
+double LatencyController::GetTargetLatency() const {
+    return std::clamp(2.0 * period + 4.0 * jitter + headroom, MIN_LATENCY, MAX_LATENCY);
+}
+
+} // namespace AudioCore
@@ -0,0 +1,64 @@
+// Copyright 2022 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <optional>
+#include "common/common_types.h"
+
+namespace AudioCore {
+
+/**
+ * Chooses how much audio the time stretcher keeps buffered for the sink. The sink pulls samples in
+ * bursts at somewhat irregular intervals, so the buffer has to cover a couple of callback periods
+ * plus the jitter of the callbacks. Every underrun adds some headroom on top of that, which decays
+ * again while the output is stable.
+ */
+class LatencyController {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /// Lowest target latency, in seconds
+    static constexpr double MIN_LATENCY = 0.02;
+    /// Highest target latency, in seconds
+    static constexpr double MAX_LATENCY = 0.25;
+
+    explicit LatencyController(unsigned int sample_rate);
+
+    void SetSampleRate(unsigned int sample_rate);
+
+    /**
+     * Records a sink callback.
+     * @param now          Time at which the callback started
+     * @param num_frames   Number of frames requested by the sink
+     * @param num_written  Number of frames that were available
+     */
+    void RecordCallback(Clock::time_point now, std::size_t num_frames, std::size_t num_written);
+
+    /// Returns the latency the time stretcher should aim for, in seconds
+    double GetTargetLatency() const;
+
+    /// Returns the smoothed deviation of the callback interval from the expected one, in seconds
+    double GetCallbackJitter() const {
+        return jitter;
+    }
+
+    /// Returns the number of times the output ran dry
+    u64 GetUnderrunCount() const {
+        return underruns;
+    }
+
+private:
+    unsigned int sample_rate;
+    std::optional<Clock::time_point> last_callback;
+    double period = 0.0;   ///< Expected interval between callbacks, in seconds
+    double jitter = 0.0;   ///< In seconds
+    double headroom = 0.0; ///< Latency added after underruns, in seconds
+    bool starved = true;   ///< Whether the previous callback ran dry
+    u64 underruns = 0;
+};
+
+} // namespace AudioCore
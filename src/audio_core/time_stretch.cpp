@@ -28,20 +28,27 @@ void TimeStretcher::SetOutputSampleRate(unsigned int sample_rate) {
     sample_rate = native_sample_rate;
 }
 
+void TimeStretcher::SetTargetLatency(double seconds) {
+    target_latency = seconds;
+}
+
+std::size_t TimeStretcher::GetBacklog() const {
+    return sound_touch->numSamples();
+}
+
 std::size_t TimeStretcher::Process(const s16* in, std::size_t num_in, s16* out,
                                    std::size_t num_out) {
     const double time_delta = static_cast<double>(num_out) / sample_rate; // seconds
     double current_ratio = static_cast<double>(num_in) / static_cast<double>(num_out);
 
-    const double max_latency = 0.25; // seconds
-    const double max_backlog = sample_rate * max_latency;
+    const double max_backlog = sample_rate * target_latency * 2.0;
     const double backlog_fullness = sound_touch->numSamples() / max_backlog;
     if (backlog_fullness > 4.0) {
         // Too many samples in backlog: Don't push anymore on
         num_in = 0;
     }
 
-    // We ideally want the backlog to be about 50% full.
+    // We ideally want the backlog to be about 50% full, which is the target latency.
     // This gives some headroom both ways to prevent underflow and overflow.
     // We tweak current_ratio to encourage this.
     constexpr double tweak_time_scale = 0.050; // seconds
@@ -22,6 +22,12 @@ public:
 
     void SetOutputSampleRate(unsigned int sample_rate);
 
+    /// Sets the amount of audio the stretcher aims to keep in its backlog, in seconds
+    void SetTargetLatency(double seconds);
+
+    /// Returns the number of frames in the backlog
+    std::size_t GetBacklog() const;
+
     /// @param in       Input sample buffer
     /// @param num_in   Number of input frames in `in`
     /// @param out      Output sample buffer
@@ -37,6 +43,7 @@ private:
     unsigned int sample_rate;
     std::unique_ptr<soundtouch::SoundTouch> sound_touch;
     double stretch_ratio = 1.0;
+    double target_latency = 0.125;
 };
 
 } // namespace AudioCore
@@ -70,6 +70,7 @@ static void PrintHelp(const char* argv0) {
                  "-p, --movie-play=[file]    Playback the movie (game inputs) from the given file\n"
                  "-d, --dump-video=[file]    Dumps audio and video to the given video file\n"
                  "-f, --fullscreen     Start in fullscreen mode\n"
+                 "-s, --software-renderer Render on the CPU, without a window or GPU\n"
                  "-h, --help           Display this help and exit\n"
                  "-v, --version        Output version information and exit\n";
 }
@@ -227,13 +228,14 @@ int main(int argc, char** argv) {
         {"movie-play", required_argument, 0, 'p'},
         {"dump-video", required_argument, 0, 'd'},
         {"fullscreen", no_argument, 0, 'f'},
+        {"software-renderer", no_argument, 0, 's'},
         {"help", no_argument, 0, 'h'},
         {"version", no_argument, 0, 'v'},
         {0, 0, 0, 0},
     };
 
     while (optind < argc) {
-        int arg = getopt_long(argc, argv, "g:i:m:r:p:fhv", long_options, &option_index);
+        int arg = getopt_long(argc, argv, "g:i:m:r:p:fshv", long_options, &option_index);
         if (arg != -1) {
             switch (static_cast<char>(arg)) {
             case 'g':
@@ -306,6 +308,9 @@ int main(int argc, char** argv) {
                 fullscreen = true;
                 LOG_INFO(Frontend, "Starting in fullscreen mode...");
                 break;
+            case 's':
+                Settings::values.graphics_api = Settings::GraphicsAPI::Software;
+                break;
             case 'h':
                 PrintHelp(argv[0]);
                 return 0;
@@ -358,7 +363,10 @@ int main(int argc, char** argv) {
     // Register generic image interface
     Core::System::GetInstance().RegisterImageInterface(std::make_shared<LodePNGImageInterface>());
 
-    std::unique_ptr<EmuWindow_SDL2> emu_window{std::make_unique<EmuWindow_SDL2>(fullscreen)};
+    // The software renderer keeps the screens in memory, so it does not need a window
+    const bool headless = Settings::values.graphics_api == Settings::GraphicsAPI::Software;
+    std::unique_ptr<EmuWindow_SDL2> emu_window{
+        std::make_unique<EmuWindow_SDL2>(fullscreen, headless)};
     Frontend::ScopeAcquireContext scope(*emu_window);
     Core::System& system = Core::System::GetInstance();
 
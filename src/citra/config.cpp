@@ -105,10 +105,21 @@ void Config::ReadValues() {
 
     // Core
     Settings::values.use_cpu_jit = sdl2_config->GetBoolean("Core", "use_cpu_jit", true);
+    Settings::values.use_fastmem = sdl2_config->GetBoolean("Core", "use_fastmem", true);
+    Settings::values.use_cpu_threads =
+        sdl2_config->GetBoolean("Core", "use_cpu_threads", false);
+    Settings::values.skip_idle_loops =
+        sdl2_config->GetBoolean("Core", "skip_idle_loops", false);
     Settings::values.cpu_clock_percentage =
         sdl2_config->GetInteger("Core", "cpu_clock_percentage", 100);
+    Settings::values.rewind_interval =
+        static_cast<u16>(sdl2_config->GetInteger("Core", "rewind_interval", 0));
+    Settings::values.rewind_buffer_size =
+        static_cast<u16>(sdl2_config->GetInteger("Core", "rewind_buffer_size", 384));
 
     // Renderer
+    Settings::values.graphics_api = static_cast<Settings::GraphicsAPI>(
+        sdl2_config->GetInteger("Renderer", "graphics_api", 0));
     Settings::values.use_gles = sdl2_config->GetBoolean("Renderer", "use_gles", false);
     Settings::values.use_hw_renderer = sdl2_config->GetBoolean("Renderer", "use_hw_renderer", true);
     Settings::values.use_hw_shader = sdl2_config->GetBoolean("Renderer", "use_hw_shader", true);
@@ -122,6 +133,11 @@ void Config::ReadValues() {
     Settings::values.shaders_accurate_mul =
         sdl2_config->GetBoolean("Renderer", "shaders_accurate_mul", true);
     Settings::values.use_shader_jit = sdl2_config->GetBoolean("Renderer", "use_shader_jit", true);
+    Settings::values.sw_rasterizer_threads =
+        static_cast<u16>(sdl2_config->GetInteger("Renderer", "sw_rasterizer_threads", 0));
+    Settings::values.vertex_shader_threads =
+        static_cast<u16>(sdl2_config->GetInteger("Renderer", "vertex_shader_threads", 0));
+    Settings::values.use_async_gpu = sdl2_config->GetBoolean("Renderer", "use_async_gpu", false);
     Settings::values.resolution_factor =
         static_cast<u16>(sdl2_config->GetInteger("Renderer", "resolution_factor", 1));
     Settings::values.use_disk_shader_cache =
@@ -189,6 +205,8 @@ void Config::ReadValues() {
     Settings::values.enable_dsp_lle = sdl2_config->GetBoolean("Audio", "enable_dsp_lle", false);
     Settings::values.enable_dsp_lle_multithread =
         sdl2_config->GetBoolean("Audio", "enable_dsp_lle_multithread", false);
+    Settings::values.audio_source_threads =
+        static_cast<u16>(sdl2_config->GetInteger("Audio", "audio_source_threads", 1));
     Settings::values.sink_id = sdl2_config->GetString("Audio", "output_engine", "auto");
     Settings::values.enable_audio_stretching =
         sdl2_config->GetBoolean("Audio", "enable_audio_stretching", true);
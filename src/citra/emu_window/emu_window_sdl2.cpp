@@ -135,9 +135,11 @@ void EmuWindow_SDL2::Fullscreen() {
     SDL_MaximizeWindow(render_window);
 }
 
-EmuWindow_SDL2::EmuWindow_SDL2(bool fullscreen) {
-    // Initialize the window
-    if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_GAMECONTROLLER) < 0) {
+EmuWindow_SDL2::EmuWindow_SDL2(bool fullscreen, bool headless) : headless{headless} {
+    // Initialize the window. Without one SDL is still used for controllers and quit requests.
+    const u32 subsystems = headless ? SDL_INIT_EVENTS | SDL_INIT_GAMECONTROLLER
+                                    : SDL_INIT_VIDEO | SDL_INIT_GAMECONTROLLER;
+    if (SDL_Init(subsystems) < 0) {
         LOG_CRITICAL(Frontend, "Failed to initialize SDL2: {}! Exiting...", SDL_GetError());
         exit(1);
     }
@@ -147,6 +149,20 @@ EmuWindow_SDL2::EmuWindow_SDL2(bool fullscreen) {
 
     SDL_SetMainReady();
 
+    if (headless) {
+        UpdateCurrentFramebufferLayout(Core::kScreenTopWidth,
+                                       Core::kScreenTopHeight + Core::kScreenBottomHeight);
+    } else {
+        InitializeRenderWindow(fullscreen);
+    }
+
+    SDL_PumpEvents();
+    LOG_INFO(Frontend, "Citra Version: {} | {}-{}", Common::g_build_fullname, Common::g_scm_branch,
+             Common::g_scm_desc);
+    Settings::LogSettings();
+}
+
+void EmuWindow_SDL2::InitializeRenderWindow(bool fullscreen) {
     if (Settings::values.use_gles) {
         SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
         SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 2);
@@ -210,10 +226,6 @@ EmuWindow_SDL2::EmuWindow_SDL2(bool fullscreen) {
 
     OnResize();
     OnMinimalClientAreaChangeRequest(GetActiveConfig().min_client_area_size);
-    SDL_PumpEvents();
-    LOG_INFO(Frontend, "Citra Version: {} | {}-{}", Common::g_build_fullname, Common::g_scm_branch,
-             Common::g_scm_desc);
-    Settings::LogSettings();
 }
 
 EmuWindow_SDL2::~EmuWindow_SDL2() {
@@ -237,6 +249,10 @@ void EmuWindow_SDL2::RestoreContext() {
 }
 
 void EmuWindow_SDL2::Present() {
+    if (headless) {
+        return;
+    }
+
     SDL_GL_MakeCurrent(render_window, window_context);
     SDL_GL_SetSwapInterval(1);
     while (IsOpen()) {
@@ -303,21 +319,30 @@ void EmuWindow_SDL2::PollEvents() {
     const u32 current_time = SDL_GetTicks();
     if (current_time > last_time + 2000) {
         const auto results = Core::System::GetInstance().GetAndResetPerfStats();
-        const auto title =
-            fmt::format("Citra {} | {}-{} | FPS: {:.0f} ({:.0f}%)", Common::g_build_fullname,
-                        Common::g_scm_branch, Common::g_scm_desc, results.game_fps,
-                        results.emulation_speed * 100.0f);
-        SDL_SetWindowTitle(render_window, title.c_str());
+        if (headless) {
+            LOG_INFO(Frontend, "FPS: {:.0f} ({:.0f}%)", results.game_fps,
+                     results.emulation_speed * 100.0f);
+        } else {
+            const auto title =
+                fmt::format("Citra {} | {}-{} | FPS: {:.0f} ({:.0f}%)", Common::g_build_fullname,
+                            Common::g_scm_branch, Common::g_scm_desc, results.game_fps,
+                            results.emulation_speed * 100.0f);
+            SDL_SetWindowTitle(render_window, title.c_str());
+        }
         last_time = current_time;
     }
 }
 
 void EmuWindow_SDL2::MakeCurrent() {
-    core_context->MakeCurrent();
+    if (core_context) {
+        core_context->MakeCurrent();
+    }
 }
 
 void EmuWindow_SDL2::DoneCurrent() {
-    core_context->DoneCurrent();
+    if (core_context) {
+        core_context->DoneCurrent();
+    }
 }
 
 void EmuWindow_SDL2::OnMinimalClientAreaChangeRequest(std::pair<u32, u32> minimal_size) {
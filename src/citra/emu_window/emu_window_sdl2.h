@@ -29,7 +29,12 @@ private:
 
 class EmuWindow_SDL2 : public Frontend::EmuWindow {
 public:
-    explicit EmuWindow_SDL2(bool fullscreen);
+    /**
+     * @param fullscreen Whether to start in fullscreen mode
+     * @param headless Whether to run without a window and graphics context, for renderers which
+     *                 do not present anything
+     */
+    EmuWindow_SDL2(bool fullscreen, bool headless);
     ~EmuWindow_SDL2();
 
     void Present();
@@ -58,6 +63,9 @@ public:
     void RestoreContext() override;
 
 private:
+    /// Creates the render window and its OpenGL contexts
+    void InitializeRenderWindow(bool fullscreen);
+
     /// Called by PollEvents when a key is pressed or released.
     void OnKeyEvent(int key, u8 state);
 
@@ -91,19 +99,22 @@ private:
     /// Is the window still open?
     bool is_open = true;
 
+    /// Whether there is no render window
+    bool headless;
+
     /// Internal SDL2 render window
-    SDL_Window* render_window;
+    SDL_Window* render_window = nullptr;
 
     /// Fake hidden window for the core context
-    SDL_Window* dummy_window;
+    SDL_Window* dummy_window = nullptr;
 
     using SDL_GLContext = void*;
 
     /// The OpenGL context associated with the window
-    SDL_GLContext window_context;
+    SDL_GLContext window_context = nullptr;
 
     /// Used by SaveContext and RestoreContext
-    SDL_GLContext last_saved_context;
+    SDL_GLContext last_saved_context = nullptr;
 
     /// The OpenGL context associated with the core
     std::unique_ptr<Frontend::GraphicsContext> core_context;
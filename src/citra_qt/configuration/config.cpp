@@ -58,7 +58,7 @@ const std::array<std::array<int, 5>, Settings::NativeAnalog::NumAnalogs> Config:
 // This must be in alphabetical order according to action name as it must have the same order as
 // UISetting::values.shortcuts, which is alphabetically ordered.
 // clang-format off
-const std::array<UISettings::Shortcut, 23> default_hotkeys{
+const std::array<UISettings::Shortcut, 24> default_hotkeys{
     {{QStringLiteral("Advance Frame"),            QStringLiteral("Main Window"), {QStringLiteral("\\"), Qt::ApplicationShortcut}},
      {QStringLiteral("Capture Screenshot"),       QStringLiteral("Main Window"), {QStringLiteral("Ctrl+P"), Qt::ApplicationShortcut}},
      {QStringLiteral("Continue/Pause Emulation"), QStringLiteral("Main Window"), {QStringLiteral("F4"), Qt::WindowShortcut}},
@@ -72,6 +72,7 @@ const std::array<UISettings::Shortcut, 23> default_hotkeys{
      {QStringLiteral("Load from Newest Slot"),    QStringLiteral("Main Window"), {QStringLiteral("Ctrl+V"), Qt::WindowShortcut}},
      {QStringLiteral("Remove Amiibo"),            QStringLiteral("Main Window"), {QStringLiteral("F3"), Qt::ApplicationShortcut}},
      {QStringLiteral("Restart Emulation"),        QStringLiteral("Main Window"), {QStringLiteral("F6"), Qt::WindowShortcut}},
+     {QStringLiteral("Rewind"),                   QStringLiteral("Main Window"), {QStringLiteral("Ctrl+R"), Qt::WindowShortcut}},
      {QStringLiteral("Rotate Screens Upright"),   QStringLiteral("Main Window"), {QStringLiteral("F8"), Qt::WindowShortcut}},
      {QStringLiteral("Save to Oldest Slot"),      QStringLiteral("Main Window"), {QStringLiteral("Ctrl+C"), Qt::WindowShortcut}},
      {QStringLiteral("Stop Emulation"),           QStringLiteral("Main Window"), {QStringLiteral("F5"), Qt::WindowShortcut}},
@@ -107,6 +108,8 @@ void Config::ReadAudioValues() {
     Settings::values.enable_dsp_lle = ReadSetting(QStringLiteral("enable_dsp_lle"), false).toBool();
     Settings::values.enable_dsp_lle_multithread =
         ReadSetting(QStringLiteral("enable_dsp_lle_multithread"), false).toBool();
+    Settings::values.audio_source_threads =
+        static_cast<u16>(ReadSetting(QStringLiteral("audio_source_threads"), 1).toInt());
     Settings::values.sink_id = ReadSetting(QStringLiteral("output_engine"), QStringLiteral("auto"))
                                    .toString()
                                    .toStdString();
@@ -293,8 +296,17 @@ void Config::ReadCoreValues() {
     qt_config->beginGroup(QStringLiteral("Core"));
 
     Settings::values.use_cpu_jit = ReadSetting(QStringLiteral("use_cpu_jit"), true).toBool();
+    Settings::values.use_fastmem = ReadSetting(QStringLiteral("use_fastmem"), true).toBool();
+    Settings::values.use_cpu_threads =
+        ReadSetting(QStringLiteral("use_cpu_threads"), false).toBool();
+    Settings::values.skip_idle_loops =
+        ReadSetting(QStringLiteral("skip_idle_loops"), false).toBool();
     Settings::values.cpu_clock_percentage =
         ReadSetting(QStringLiteral("cpu_clock_percentage"), 100).toInt();
+    Settings::values.rewind_interval =
+        static_cast<u16>(ReadSetting(QStringLiteral("rewind_interval"), 0).toInt());
+    Settings::values.rewind_buffer_size =
+        static_cast<u16>(ReadSetting(QStringLiteral("rewind_buffer_size"), 384).toInt());
 
     qt_config->endGroup();
 }
@@ -495,6 +507,11 @@ void Config::ReadRendererValues() {
     Settings::values.shaders_accurate_mul =
         ReadSetting(QStringLiteral("shaders_accurate_mul"), true).toBool();
     Settings::values.use_shader_jit = ReadSetting(QStringLiteral("use_shader_jit"), true).toBool();
+    Settings::values.sw_rasterizer_threads =
+        static_cast<u16>(ReadSetting(QStringLiteral("sw_rasterizer_threads"), 0).toInt());
+    Settings::values.vertex_shader_threads =
+        static_cast<u16>(ReadSetting(QStringLiteral("vertex_shader_threads"), 0).toInt());
+    Settings::values.use_async_gpu = ReadSetting(QStringLiteral("use_async_gpu"), false).toBool();
     Settings::values.use_disk_shader_cache =
         ReadSetting(QStringLiteral("use_disk_shader_cache"), true).toBool();
     Settings::values.use_vsync_new = ReadSetting(QStringLiteral("use_vsync_new"), true).toBool();
@@ -740,6 +757,7 @@ void Config::SaveAudioValues() {
     WriteSetting(QStringLiteral("enable_dsp_lle"), Settings::values.enable_dsp_lle, false);
     WriteSetting(QStringLiteral("enable_dsp_lle_multithread"),
                  Settings::values.enable_dsp_lle_multithread, false);
+    WriteSetting(QStringLiteral("audio_source_threads"), Settings::values.audio_source_threads, 1);
     WriteSetting(QStringLiteral("output_engine"), QString::fromStdString(Settings::values.sink_id),
                  QStringLiteral("auto"));
     WriteSetting(QStringLiteral("enable_audio_stretching"),
@@ -859,8 +877,13 @@ void Config::SaveCoreValues() {
     qt_config->beginGroup(QStringLiteral("Core"));
 
     WriteSetting(QStringLiteral("use_cpu_jit"), Settings::values.use_cpu_jit, true);
+    WriteSetting(QStringLiteral("use_fastmem"), Settings::values.use_fastmem, true);
+    WriteSetting(QStringLiteral("use_cpu_threads"), Settings::values.use_cpu_threads, false);
+    WriteSetting(QStringLiteral("skip_idle_loops"), Settings::values.skip_idle_loops, false);
     WriteSetting(QStringLiteral("cpu_clock_percentage"), Settings::values.cpu_clock_percentage,
                  100);
+    WriteSetting(QStringLiteral("rewind_interval"), Settings::values.rewind_interval, 0);
+    WriteSetting(QStringLiteral("rewind_buffer_size"), Settings::values.rewind_buffer_size, 384);
 
     qt_config->endGroup();
 }
@@ -1004,6 +1027,11 @@ void Config::SaveRendererValues() {
     WriteSetting(QStringLiteral("shaders_accurate_mul"), Settings::values.shaders_accurate_mul,
                  true);
     WriteSetting(QStringLiteral("use_shader_jit"), Settings::values.use_shader_jit, true);
+    WriteSetting(QStringLiteral("sw_rasterizer_threads"), Settings::values.sw_rasterizer_threads,
+                 0);
+    WriteSetting(QStringLiteral("vertex_shader_threads"), Settings::values.vertex_shader_threads,
+                 0);
+    WriteSetting(QStringLiteral("use_async_gpu"), Settings::values.use_async_gpu, false);
     WriteSetting(QStringLiteral("use_disk_shader_cache"), Settings::values.use_disk_shader_cache,
                  true);
     WriteSetting(QStringLiteral("use_vsync_new"), Settings::values.use_vsync_new, true);
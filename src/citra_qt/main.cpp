@@ -596,6 +596,13 @@ void GMainWindow::InitializeHotkeys() {
             &QShortcut::activated, ui->action_Load_from_Newest_Slot, &QAction::trigger);
     connect(hotkey_registry.GetHotkey(main_window, QStringLiteral("Save to Oldest Slot"), this),
             &QShortcut::activated, ui->action_Save_to_Oldest_Slot, &QAction::trigger);
+    connect(hotkey_registry.GetHotkey(main_window, QStringLiteral("Rewind"), this),
+            &QShortcut::activated, this, [&] {
+                if (emulation_running) {
+                    Core::System::GetInstance().SendSignal(Core::System::Signal::Rewind);
+                    Core::System::GetInstance().frame_limiter.AdvanceFrame();
+                }
+            });
 }
 
 void GMainWindow::ShowUpdaterWidgets() {
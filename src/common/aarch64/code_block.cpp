@@ -0,0 +1,79 @@
+// Copyright 2022 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#ifdef __APPLE__
+#include <libkern/OSCacheControl.h>
+#include <pthread.h>
+#endif // __APPLE__
+#endif // _WIN32
+
+#include "common/aarch64/code_block.h"
+#include "common/assert.h"
+
+namespace Common::A64 {
+
+CodeBlock::CodeBlock(std::size_t size) : memory_size(size) {
+#if defined(_WIN32)
+    memory = static_cast<u32*>(VirtualAlloc(nullptr, size, MEM_COMMIT, PAGE_READWRITE));
+    ASSERT_MSG(memory != nullptr, "Failed to allocate code memory");
+#elif defined(__APPLE__)
+    // Pages mapped with MAP_JIT are switched between writable and executable per thread
+    void* result = mmap(nullptr, size, PROT_READ | PROT_WRITE | PROT_EXEC,
+                        MAP_PRIVATE | MAP_ANONYMOUS | MAP_JIT, -1, 0);
+    ASSERT_MSG(result != MAP_FAILED, "Failed to allocate code memory");
+    memory = static_cast<u32*>(result);
+    Unprotect();
+#else
+    void* result = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    ASSERT_MSG(result != MAP_FAILED, "Failed to allocate code memory");
+    memory = static_cast<u32*>(result);
+#endif
+}
+
+CodeBlock::~CodeBlock() {
+#ifdef _WIN32
+    VirtualFree(memory, 0, MEM_RELEASE);
+#else
+    munmap(memory, memory_size);
+#endif
+}
+
+void CodeBlock::Unprotect() {
+#if defined(_WIN32)
+    DWORD old_protect;
+    VirtualProtect(memory, memory_size, PAGE_READWRITE, &old_protect);
+#elif defined(__APPLE__)
+    pthread_jit_write_protect_np(false);
+#else
+    mprotect(memory, memory_size, PROT_READ | PROT_WRITE);
+#endif
+}
+
+void CodeBlock::Protect() {
+#if defined(_WIN32)
+    DWORD old_protect;
+    VirtualProtect(memory, memory_size, PAGE_EXECUTE_READ, &old_protect);
+#elif defined(__APPLE__)
+    pthread_jit_write_protect_np(true);
+#else
+    mprotect(memory, memory_size, PROT_READ | PROT_EXEC);
+#endif
+}
+
+void CodeBlock::Invalidate(const u32* start, std::size_t size) {
+#if defined(_WIN32)
+    FlushInstructionCache(GetCurrentProcess(), start, size);
+#elif defined(__APPLE__)
+    sys_icache_invalidate(const_cast<u32*>(start), size);
+#else
+    char* begin = reinterpret_cast<char*>(const_cast<u32*>(start));
+    __builtin___clear_cache(begin, begin + size);
+#endif
+}
+
+} // namespace Common::A64
@@ -0,0 +1,47 @@
+// Copyright 2022 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include "common/common_types.h"
+
+namespace Common::A64 {
+
+/**
+ * A block of memory that generated AArch64 code is written to and executed from. The block starts
+ * out writable; Protect makes it executable, after which Unprotect has to be called before any
+ * further code is written to it.
+ */
+class CodeBlock {
+public:
+    explicit CodeBlock(std::size_t size);
+    ~CodeBlock();
+
+    CodeBlock(const CodeBlock&) = delete;
+    CodeBlock& operator=(const CodeBlock&) = delete;
+
+    u32* ptr() const {
+        return memory;
+    }
+
+    std::size_t size() const {
+        return memory_size;
+    }
+
+    /// Makes the block writable
+    void Unprotect();
+
+    /// Makes the block executable
+    void Protect();
+
+    /// Invalidates the instruction cache for code that has been written to the block
+    void Invalidate(const u32* start, std::size_t size);
+
+private:
+    u32* memory = nullptr;
+    std::size_t memory_size = 0;
+};
+
+} // namespace Common::A64
@@ -0,0 +1,725 @@
+// Copyright 2022 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstring>
+#include <optional>
+#include <vector>
+#include "common/assert.h"
+#include "common/common_types.h"
+
+namespace Common::A64 {
+
+struct WReg;
+
+/// 64-bit general purpose register. Index 31 is either SP or XZR depending on the instruction.
+struct XReg {
+    u32 index;
+    constexpr WReg toW() const;
+};
+
+/// 32-bit view of a general purpose register. Index 31 is either WSP or WZR.
+struct WReg {
+    u32 index;
+    constexpr XReg toX() const {
+        return XReg{index};
+    }
+};
+
+constexpr WReg XReg::toW() const {
+    return WReg{index};
+}
+
+struct SReg;
+
+/// 128-bit SIMD register, operated on as 4 single precision lanes or 16 bytes
+struct QReg {
+    u32 index;
+    constexpr SReg toS() const;
+};
+
+/// Lowest single precision lane of a SIMD register, used by scalar instructions
+struct SReg {
+    u32 index;
+    constexpr QReg toQ() const {
+        return QReg{index};
+    }
+};
+
+constexpr SReg QReg::toS() const {
+    return SReg{index};
+}
+
+// clang-format off
+inline constexpr XReg X0{0}, X1{1}, X2{2}, X3{3}, X4{4}, X5{5}, X6{6}, X7{7};
+inline constexpr XReg X8{8}, X9{9}, X10{10}, X11{11}, X12{12}, X13{13}, X14{14}, X15{15};
+inline constexpr XReg X16{16}, X17{17}, X18{18}, X19{19}, X20{20}, X21{21}, X22{22}, X23{23};
+inline constexpr XReg X24{24}, X25{25}, X26{26}, X27{27}, X28{28}, X29{29}, X30{30};
+inline constexpr XReg SP{31}, XZR{31};
+inline constexpr WReg W0{0}, W1{1}, W2{2}, W3{3}, W4{4}, W5{5}, W6{6}, W7{7};
+inline constexpr WReg W8{8}, W9{9}, W10{10}, W11{11}, W12{12}, W13{13}, W14{14}, W15{15};
+inline constexpr WReg W16{16}, W17{17}, W18{18}, W19{19}, W20{20}, W21{21}, W22{22}, W23{23};
+inline constexpr WReg W24{24}, W25{25}, W26{26}, W27{27}, W28{28}, W29{29}, W30{30};
+inline constexpr WReg WZR{31};
+inline constexpr QReg Q0{0}, Q1{1}, Q2{2}, Q3{3}, Q4{4}, Q5{5}, Q6{6}, Q7{7};
+inline constexpr QReg Q8{8}, Q9{9}, Q10{10}, Q11{11}, Q12{12}, Q13{13}, Q14{14}, Q15{15};
+inline constexpr QReg Q16{16}, Q17{17}, Q18{18}, Q19{19}, Q20{20}, Q21{21}, Q22{22}, Q23{23};
+inline constexpr QReg Q24{24}, Q25{25}, Q26{26}, Q27{27}, Q28{28}, Q29{29}, Q30{30}, Q31{31};
+inline constexpr SReg S0{0}, S1{1}, S2{2}, S3{3}, S4{4}, S5{5}, S6{6}, S7{7};
+inline constexpr SReg S8{8}, S9{9}, S10{10}, S11{11}, S12{12}, S13{13}, S14{14}, S15{15};
+inline constexpr SReg S16{16}, S17{17}, S18{18}, S19{19}, S20{20}, S21{21}, S22{22}, S23{23};
+inline constexpr SReg S24{24}, S25{25}, S26{26}, S27{27}, S28{28}, S29{29}, S30{30}, S31{31};
+// clang-format on
+
+/// Condition codes, as encoded in conditional branches
+enum class Cond : u32 {
+    EQ = 0,
+    NE = 1,
+    HS = 2,
+    LO = 3,
+    MI = 4,
+    PL = 5,
+    VS = 6,
+    VC = 7,
+    HI = 8,
+    LS = 9,
+    GE = 10,
+    LT = 11,
+    GT = 12,
+    LE = 13,
+    AL = 14,
+};
+
+/// Addressing modes of the load/store pair instructions
+enum class IndexMode {
+    Offset,    ///< [base, #offset]
+    PreIndex,  ///< [base, #offset]!
+    PostIndex, ///< [base], #offset
+};
+
+/**
+ * Encodes a value as the bitmask immediate of a logical instruction
+ * @param value Value to encode
+ * @param width Register width of the instruction, 32 or 64
+ * @return The N:immr:imms fields, or nothing if the value can't be represented
+ */
+constexpr std::optional<u32> EncodeLogicalImmediate(u64 value, u32 width) {
+    if (width == 32) {
+        value = (value & 0xFFFFFFFF) | (value << 32);
+    }
+    if (value == 0 || value == ~u64{0}) {
+        return std::nullopt;
+    }
+
+    // Find the smallest element the value is a repetition of
+    u32 size = 64;
+    while (size > 2) {
+        const u32 half = size / 2;
+        const u64 mask = (u64{1} << half) - 1;
+        if ((value & mask) != ((value >> half) & mask)) {
+            break;
+        }
+        size = half;
+    }
+
+    // The element has to be a rotated run of ones
+    const u64 mask = size == 64 ? ~u64{0} : (u64{1} << size) - 1;
+    const u64 element = value & mask;
+    const u32 ones = static_cast<u32>(std::popcount(element));
+    const u64 run = (u64{1} << ones) - 1;
+    for (u32 rotation = 0; rotation < size; ++rotation) {
+        const u64 rotated = rotation == 0
+                                ? element
+                                : ((element >> rotation) | (element << (size - rotation))) & mask;
+        if (rotated == run) {
+            const u32 n = size == 64 ? 1 : 0;
+            const u32 immr = (size - rotation) % size;
+            const u32 imms = ((~(size - 1) << 1) | (ones - 1)) & 0x3F;
+            return (n << 12) | (immr << 6) | imms;
+        }
+    }
+    return std::nullopt;
+}
+
+class CodeEmitter;
+
+/// A position in the emitted code. Branches to a label may be emitted before it is bound.
+class Label {
+public:
+    /// Returns the address the label was bound to, or nullptr if it hasn't been bound yet
+    const u32* GetAddress() const {
+        return address;
+    }
+
+private:
+    friend class CodeEmitter;
+
+    enum class FixupType {
+        Imm26, ///< B, BL
+        Imm19, ///< B.cond, CBZ, CBNZ
+    };
+
+    struct Fixup {
+        u32* location;
+        FixupType type;
+    };
+
+    const u32* address = nullptr;
+    std::vector<Fixup> fixups;
+};
+
+/**
+ * Minimal AArch64 assembler writing instructions to a caller-provided buffer. Only the subset of
+ * the instruction set needed by the JIT compilers is implemented. Instruction names follow the
+ * architectural mnemonics; QReg operands use the 4S arrangement for floating point instructions
+ * and 16B for bitwise ones. Every instruction is checked against the end of the buffer before it
+ * is written.
+ */
+class CodeEmitter {
+public:
+    /**
+     * @param code Buffer to write instructions to
+     * @param size Size of the buffer in bytes
+     */
+    CodeEmitter(u32* code, std::size_t size)
+        : code_start(code), code_end(code + size / sizeof(u32)), current(code) {}
+
+    const u32* GetCode() const {
+        return code_start;
+    }
+
+    const u32* GetCurrent() const {
+        return current;
+    }
+
+    /// Size in bytes of the code emitted so far
+    std::size_t GetSize() const {
+        return static_cast<std::size_t>(current - code_start) * sizeof(u32);
+    }
+
+    /// Binds the label to the current position, resolving the branches emitted to it so far
+    void L(Label& label) {
+        ASSERT(label.address == nullptr);
+        label.address = current;
+        for (const auto& fixup : label.fixups) {
+            *fixup.location |= EncodeBranchOffset(fixup.location, current, fixup.type);
+        }
+        label.fixups.clear();
+    }
+
+    /// Size in bytes of the space left in the buffer
+    std::size_t GetRemainingSize() const {
+        return static_cast<std::size_t>(code_end - current) * sizeof(u32);
+    }
+
+    void dw(u32 value) {
+        ASSERT_MSG(current < code_end, "Emitted code exceeds the size of the code buffer");
+        *current++ = value;
+    }
+
+    // Arithmetic
+
+    void ADD(XReg d, XReg n, u32 imm) {
+        AddSubImmediate(0x91000000, d.index, n.index, imm);
+    }
+    void ADD(WReg d, WReg n, u32 imm) {
+        AddSubImmediate(0x11000000, d.index, n.index, imm);
+    }
+    void SUB(XReg d, XReg n, u32 imm) {
+        AddSubImmediate(0xD1000000, d.index, n.index, imm);
+    }
+    void SUB(WReg d, WReg n, u32 imm) {
+        AddSubImmediate(0x51000000, d.index, n.index, imm);
+    }
+    void SUBS(XReg d, XReg n, u32 imm) {
+        AddSubImmediate(0xF1000000, d.index, n.index, imm);
+    }
+    void SUBS(WReg d, WReg n, u32 imm) {
+        AddSubImmediate(0x71000000, d.index, n.index, imm);
+    }
+    void CMP(XReg n, u32 imm) {
+        SUBS(XZR, n, imm);
+    }
+    void CMP(WReg n, u32 imm) {
+        SUBS(WZR, n, imm);
+    }
+
+    void ADD(XReg d, XReg n, XReg m) {
+        ThreeRegister(0x8B000000, d.index, n.index, m.index);
+    }
+    void ADD(WReg d, WReg n, WReg m) {
+        ThreeRegister(0x0B000000, d.index, n.index, m.index);
+    }
+    void SUB(XReg d, XReg n, XReg m) {
+        ThreeRegister(0xCB000000, d.index, n.index, m.index);
+    }
+    void SUB(WReg d, WReg n, WReg m) {
+        ThreeRegister(0x4B000000, d.index, n.index, m.index);
+    }
+    void CMP(XReg n, XReg m) {
+        ThreeRegister(0xEB000000, XZR.index, n.index, m.index);
+    }
+    void CMP(WReg n, WReg m) {
+        ThreeRegister(0x6B000000, WZR.index, n.index, m.index);
+    }
+
+    // Logical
+
+    void AND(XReg d, XReg n, XReg m) {
+        ThreeRegister(0x8A000000, d.index, n.index, m.index);
+    }
+    void AND(WReg d, WReg n, WReg m) {
+        ThreeRegister(0x0A000000, d.index, n.index, m.index);
+    }
+    void ORR(XReg d, XReg n, XReg m) {
+        ThreeRegister(0xAA000000, d.index, n.index, m.index);
+    }
+    void ORR(WReg d, WReg n, WReg m) {
+        ThreeRegister(0x2A000000, d.index, n.index, m.index);
+    }
+    void EOR(XReg d, XReg n, XReg m) {
+        ThreeRegister(0xCA000000, d.index, n.index, m.index);
+    }
+    void EOR(WReg d, WReg n, WReg m) {
+        ThreeRegister(0x4A000000, d.index, n.index, m.index);
+    }
+    void AND(XReg d, XReg n, u64 imm) {
+        LogicalImmediate(0x92000000, d.index, n.index, imm, 64);
+    }
+    void AND(WReg d, WReg n, u32 imm) {
+        LogicalImmediate(0x12000000, d.index, n.index, imm, 32);
+    }
+    void ORR(XReg d, XReg n, u64 imm) {
+        LogicalImmediate(0xB2000000, d.index, n.index, imm, 64);
+    }
+    void ORR(WReg d, WReg n, u32 imm) {
+        LogicalImmediate(0x32000000, d.index, n.index, imm, 32);
+    }
+    void EOR(XReg d, XReg n, u64 imm) {
+        LogicalImmediate(0xD2000000, d.index, n.index, imm, 64);
+    }
+    void EOR(WReg d, WReg n, u32 imm) {
+        LogicalImmediate(0x52000000, d.index, n.index, imm, 32);
+    }
+
+    void MOV(XReg d, XReg m) {
+        ORR(d, XZR, m);
+    }
+    void MOV(WReg d, WReg m) {
+        ORR(d, WZR, m);
+    }
+
+    void MOVZ(XReg d, u16 imm, u32 shift = 0) {
+        MoveWide(0xD2800000, d.index, imm, shift);
+    }
+    void MOVZ(WReg d, u16 imm, u32 shift = 0) {
+        ASSERT(shift <= 16);
+        MoveWide(0x52800000, d.index, imm, shift);
+    }
+    void MOVN(XReg d, u16 imm, u32 shift = 0) {
+        MoveWide(0x92800000, d.index, imm, shift);
+    }
+    void MOVN(WReg d, u16 imm, u32 shift = 0) {
+        ASSERT(shift <= 16);
+        MoveWide(0x12800000, d.index, imm, shift);
+    }
+    void MOVK(XReg d, u16 imm, u32 shift = 0) {
+        MoveWide(0xF2800000, d.index, imm, shift);
+    }
+    void MOVK(WReg d, u16 imm, u32 shift = 0) {
+        ASSERT(shift <= 16);
+        MoveWide(0x72800000, d.index, imm, shift);
+    }
+
+    /// Materializes an arbitrary constant using as few MOVZ/MOVN/MOVK as possible
+    void MOV(XReg d, u64 imm) {
+        if (imm == ~u64{0}) {
+            MOVN(d, 0);
+            return;
+        }
+        bool first = true;
+        for (u32 shift = 0; shift < 64; shift += 16) {
+            const u16 part = static_cast<u16>(imm >> shift);
+            if (part == 0) {
+                continue;
+            }
+            if (first) {
+                MOVZ(d, part, shift);
+                first = false;
+            } else {
+                MOVK(d, part, shift);
+            }
+        }
+        if (first) {
+            MOVZ(d, 0);
+        }
+    }
+    void MOV(WReg d, u32 imm) {
+        const u16 low = static_cast<u16>(imm);
+        const u16 high = static_cast<u16>(imm >> 16);
+        if (high == 0) {
+            MOVZ(d, low);
+        } else if (low == 0) {
+            MOVZ(d, high, 16);
+        } else {
+            MOVZ(d, low);
+            MOVK(d, high, 16);
+        }
+    }
+
+    // Bitfield
+
+    void UBFM(XReg d, XReg n, u32 immr, u32 imms) {
+        Bitfield(0xD3400000, d.index, n.index, immr, imms, 64);
+    }
+    void UBFM(WReg d, WReg n, u32 immr, u32 imms) {
+        Bitfield(0x53000000, d.index, n.index, immr, imms, 32);
+    }
+    void SBFM(XReg d, XReg n, u32 immr, u32 imms) {
+        Bitfield(0x93400000, d.index, n.index, immr, imms, 64);
+    }
+    void SBFM(WReg d, WReg n, u32 immr, u32 imms) {
+        Bitfield(0x13000000, d.index, n.index, immr, imms, 32);
+    }
+    void LSL(XReg d, XReg n, u32 shift) {
+        ASSERT(shift < 64);
+        UBFM(d, n, (64 - shift) % 64, 63 - shift);
+    }
+    void LSL(WReg d, WReg n, u32 shift) {
+        ASSERT(shift < 32);
+        UBFM(d, n, (32 - shift) % 32, 31 - shift);
+    }
+    void LSR(XReg d, XReg n, u32 shift) {
+        UBFM(d, n, shift, 63);
+    }
+    void LSR(WReg d, WReg n, u32 shift) {
+        UBFM(d, n, shift, 31);
+    }
+    void ASR(XReg d, XReg n, u32 shift) {
+        SBFM(d, n, shift, 63);
+    }
+    void ASR(WReg d, WReg n, u32 shift) {
+        SBFM(d, n, shift, 31);
+    }
+    void UBFX(WReg d, WReg n, u32 lsb, u32 width) {
+        ASSERT(width > 0 && lsb + width <= 32);
+        UBFM(d, n, lsb, lsb + width - 1);
+    }
+
+    // Loads and stores, with an unsigned offset scaled by the access size
+
+    void LDR(XReg t, XReg n, u32 offset = 0) {
+        LoadStore(0xF9400000, t.index, n.index, offset, 8);
+    }
+    void LDR(WReg t, XReg n, u32 offset = 0) {
+        LoadStore(0xB9400000, t.index, n.index, offset, 4);
+    }
+    void LDR(QReg t, XReg n, u32 offset = 0) {
+        LoadStore(0x3DC00000, t.index, n.index, offset, 16);
+    }
+    void LDR(SReg t, XReg n, u32 offset = 0) {
+        LoadStore(0xBD400000, t.index, n.index, offset, 4);
+    }
+    void LDRB(WReg t, XReg n, u32 offset = 0) {
+        LoadStore(0x39400000, t.index, n.index, offset, 1);
+    }
+    void STR(XReg t, XReg n, u32 offset = 0) {
+        LoadStore(0xF9000000, t.index, n.index, offset, 8);
+    }
+    void STR(WReg t, XReg n, u32 offset = 0) {
+        LoadStore(0xB9000000, t.index, n.index, offset, 4);
+    }
+    void STR(QReg t, XReg n, u32 offset = 0) {
+        LoadStore(0x3D800000, t.index, n.index, offset, 16);
+    }
+    void STR(SReg t, XReg n, u32 offset = 0) {
+        LoadStore(0xBD000000, t.index, n.index, offset, 4);
+    }
+    void STRB(WReg t, XReg n, u32 offset = 0) {
+        LoadStore(0x39000000, t.index, n.index, offset, 1);
+    }
+
+    void LDP(XReg t1, XReg t2, XReg n, s32 offset, IndexMode mode = IndexMode::Offset) {
+        LoadStorePair(0xA8400000, t1.index, t2.index, n.index, offset, 8, mode);
+    }
+    void STP(XReg t1, XReg t2, XReg n, s32 offset, IndexMode mode = IndexMode::Offset) {
+        LoadStorePair(0xA8000000, t1.index, t2.index, n.index, offset, 8, mode);
+    }
+    void LDP(QReg t1, QReg t2, XReg n, s32 offset, IndexMode mode = IndexMode::Offset) {
+        LoadStorePair(0xAC400000, t1.index, t2.index, n.index, offset, 16, mode);
+    }
+    void STP(QReg t1, QReg t2, XReg n, s32 offset, IndexMode mode = IndexMode::Offset) {
+        LoadStorePair(0xAC000000, t1.index, t2.index, n.index, offset, 16, mode);
+    }
+
+    // Branches
+
+    void B(Label& label) {
+        Branch(0x14000000, label, Label::FixupType::Imm26);
+    }
+    void BL(Label& label) {
+        Branch(0x94000000, label, Label::FixupType::Imm26);
+    }
+    void B(Cond cond, Label& label) {
+        Branch(0x54000000 | static_cast<u32>(cond), label, Label::FixupType::Imm19);
+    }
+    void CBZ(XReg t, Label& label) {
+        Branch(0xB4000000 | t.index, label, Label::FixupType::Imm19);
+    }
+    void CBZ(WReg t, Label& label) {
+        Branch(0x34000000 | t.index, label, Label::FixupType::Imm19);
+    }
+    void CBNZ(XReg t, Label& label) {
+        Branch(0xB5000000 | t.index, label, Label::FixupType::Imm19);
+    }
+    void CBNZ(WReg t, Label& label) {
+        Branch(0x35000000 | t.index, label, Label::FixupType::Imm19);
+    }
+    void BR(XReg n) {
+        dw(0xD61F0000 | (n.index << 5));
+    }
+    void BLR(XReg n) {
+        dw(0xD63F0000 | (n.index << 5));
+    }
+    void RET() {
+        dw(0xD65F03C0);
+    }
+
+    // SIMD, 4 single precision lanes
+
+    void FADD(QReg d, QReg n, QReg m) {
+        ThreeRegister(0x4E20D400, d.index, n.index, m.index);
+    }
+    void FSUB(QReg d, QReg n, QReg m) {
+        ThreeRegister(0x4EA0D400, d.index, n.index, m.index);
+    }
+    void FMUL(QReg d, QReg n, QReg m) {
+        ThreeRegister(0x6E20DC00, d.index, n.index, m.index);
+    }
+    void FDIV(QReg d, QReg n, QReg m) {
+        ThreeRegister(0x6E20FC00, d.index, n.index, m.index);
+    }
+    void FADDP(QReg d, QReg n, QReg m) {
+        ThreeRegister(0x6E20D400, d.index, n.index, m.index);
+    }
+    void FCMEQ(QReg d, QReg n, QReg m) {
+        ThreeRegister(0x4E20E400, d.index, n.index, m.index);
+    }
+    void FCMGE(QReg d, QReg n, QReg m) {
+        ThreeRegister(0x6E20E400, d.index, n.index, m.index);
+    }
+    void FCMGT(QReg d, QReg n, QReg m) {
+        ThreeRegister(0x6EA0E400, d.index, n.index, m.index);
+    }
+    void FNEG(QReg d, QReg n) {
+        TwoRegister(0x6EA0F800, d.index, n.index);
+    }
+    void FRINTM(QReg d, QReg n) {
+        TwoRegister(0x4E219800, d.index, n.index);
+    }
+    void FCVTZS(QReg d, QReg n) {
+        TwoRegister(0x4EA1B800, d.index, n.index);
+    }
+
+    /// Sets all lanes to a floating point constant representable as an 8-bit immediate
+    void FMOV(QReg d, float value) {
+        dw(0x4F00F400 | EncodeFloatImmediate(value, 16, 5) | d.index);
+    }
+
+    // SIMD, 16 bytes
+
+    void AND(QReg d, QReg n, QReg m) {
+        ThreeRegister(0x4E201C00, d.index, n.index, m.index);
+    }
+    void BIC(QReg d, QReg n, QReg m) {
+        ThreeRegister(0x4E601C00, d.index, n.index, m.index);
+    }
+    void ORR(QReg d, QReg n, QReg m) {
+        ThreeRegister(0x4EA01C00, d.index, n.index, m.index);
+    }
+    void ORN(QReg d, QReg n, QReg m) {
+        ThreeRegister(0x4EE01C00, d.index, n.index, m.index);
+    }
+    void EOR(QReg d, QReg n, QReg m) {
+        ThreeRegister(0x6E201C00, d.index, n.index, m.index);
+    }
+    /// d = (d & n) | (~d & m)
+    void BSL(QReg d, QReg n, QReg m) {
+        ThreeRegister(0x6E601C00, d.index, n.index, m.index);
+    }
+    /// d = (n & m) | (d & ~m)
+    void BIT(QReg d, QReg n, QReg m) {
+        ThreeRegister(0x6EA01C00, d.index, n.index, m.index);
+    }
+    /// d = (d & m) | (n & ~m)
+    void BIF(QReg d, QReg n, QReg m) {
+        ThreeRegister(0x6EE01C00, d.index, n.index, m.index);
+    }
+    void NOT(QReg d, QReg n) {
+        TwoRegister(0x6E205800, d.index, n.index);
+    }
+    void MOV(QReg d, QReg n) {
+        ORR(d, n, n);
+    }
+
+    // SIMD lane moves, on 32-bit lanes
+
+    void DUP(QReg d, QReg n, u32 lane) {
+        dw(0x4E000400 | (LaneImm5(lane) << 16) | (n.index << 5) | d.index);
+    }
+    /// Copies lane n_lane of n into lane d_lane of d
+    void INS(QReg d, u32 d_lane, QReg n, u32 n_lane) {
+        ASSERT(n_lane < 4);
+        dw(0x6E000400 | (LaneImm5(d_lane) << 16) | (n_lane << 13) | (n.index << 5) | d.index);
+    }
+    void UMOV(WReg d, QReg n, u32 lane) {
+        dw(0x0E003C00 | (LaneImm5(lane) << 16) | (n.index << 5) | d.index);
+    }
+    void SMOV(XReg d, QReg n, u32 lane) {
+        dw(0x4E002C00 | (LaneImm5(lane) << 16) | (n.index << 5) | d.index);
+    }
+
+    // Scalar single precision
+
+    void FADD(SReg d, SReg n, SReg m) {
+        ThreeRegister(0x1E202800, d.index, n.index, m.index);
+    }
+    void FSUB(SReg d, SReg n, SReg m) {
+        ThreeRegister(0x1E203800, d.index, n.index, m.index);
+    }
+    void FMUL(SReg d, SReg n, SReg m) {
+        ThreeRegister(0x1E200800, d.index, n.index, m.index);
+    }
+    void FDIV(SReg d, SReg n, SReg m) {
+        ThreeRegister(0x1E201800, d.index, n.index, m.index);
+    }
+    void FMAX(SReg d, SReg n, SReg m) {
+        ThreeRegister(0x1E204800, d.index, n.index, m.index);
+    }
+    void FMIN(SReg d, SReg n, SReg m) {
+        ThreeRegister(0x1E205800, d.index, n.index, m.index);
+    }
+    void FSQRT(SReg d, SReg n) {
+        TwoRegister(0x1E21C000, d.index, n.index);
+    }
+    void FCMP(SReg n, SReg m) {
+        dw(0x1E202000 | (m.index << 16) | (n.index << 5));
+    }
+    /// Compares against +0.0
+    void FCMP(SReg n) {
+        dw(0x1E202008 | (n.index << 5));
+    }
+    void FMOV(SReg d, WReg n) {
+        TwoRegister(0x1E270000, d.index, n.index);
+    }
+    void FMOV(WReg d, SReg n) {
+        TwoRegister(0x1E260000, d.index, n.index);
+    }
+    void SCVTF(SReg d, WReg n) {
+        TwoRegister(0x1E220000, d.index, n.index);
+    }
+    /// Converts to a signed integer, rounding to nearest with ties to even
+    void FCVTNS(WReg d, SReg n) {
+        TwoRegister(0x1E200000, d.index, n.index);
+    }
+
+private:
+    static u32 EncodeBranchOffset(const u32* location, const u32* target, Label::FixupType type) {
+        const s64 offset = target - location;
+        switch (type) {
+        case Label::FixupType::Imm26:
+            ASSERT_MSG(offset >= -(s64{1} << 25) && offset < (s64{1} << 25),
+                       "Branch target out of range");
+            return static_cast<u32>(offset) & 0x3FFFFFF;
+        case Label::FixupType::Imm19:
+            ASSERT_MSG(offset >= -(s64{1} << 18) && offset < (s64{1} << 18),
+                       "Branch target out of range");
+            return (static_cast<u32>(offset) & 0x7FFFF) << 5;
+        }
+        UNREACHABLE();
+        return 0;
+    }
+
+    static u32 LaneImm5(u32 lane) {
+        ASSERT(lane < 4);
+        return (lane << 3) | 0b100;
+    }
+
+    static u32 EncodeFloatImmediate(float value, u32 high_shift, u32 low_shift) {
+        u32 bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        const u32 b = (bits >> 29) & 1;
+        const u32 exponent_high = (bits >> 25) & 0x3F;
+        ASSERT_MSG((bits & 0x7FFFF) == 0 && exponent_high == (b ? 0x1F : 0x20),
+                   "Floating point constant can't be encoded as an immediate");
+        const u32 imm8 = ((bits >> 24) & 0x80) | (b << 6) | ((bits >> 19) & 0x3F);
+        return ((imm8 >> 5) << high_shift) | ((imm8 & 0x1F) << low_shift);
+    }
+
+    void Branch(u32 opcode, Label& label, Label::FixupType type) {
+        if (label.address != nullptr) {
+            dw(opcode | EncodeBranchOffset(current, label.address, type));
+        } else {
+            label.fixups.push_back({current, type});
+            dw(opcode);
+        }
+    }
+
+    void ThreeRegister(u32 opcode, u32 d, u32 n, u32 m) {
+        dw(opcode | (m << 16) | (n << 5) | d);
+    }
+
+    void TwoRegister(u32 opcode, u32 d, u32 n) {
+        dw(opcode | (n << 5) | d);
+    }
+
+    void AddSubImmediate(u32 opcode, u32 d, u32 n, u32 imm) {
+        if (imm < 0x1000) {
+            dw(opcode | (imm << 10) | (n << 5) | d);
+        } else {
+            ASSERT_MSG((imm & 0xFFF) == 0 && imm < 0x1000000, "Immediate out of range");
+            dw(opcode | (1 << 22) | ((imm >> 12) << 10) | (n << 5) | d);
+        }
+    }
+
+    void LogicalImmediate(u32 opcode, u32 d, u32 n, u64 imm, u32 width) {
+        const auto encoded = EncodeLogicalImmediate(imm, width);
+        ASSERT_MSG(encoded.has_value(), "Immediate can't be encoded as a bitmask");
+        dw(opcode | (*encoded << 10) | (n << 5) | d);
+    }
+
+    void MoveWide(u32 opcode, u32 d, u16 imm, u32 shift) {
+        ASSERT(shift % 16 == 0 && shift < 64);
+        dw(opcode | ((shift / 16) << 21) | (u32{imm} << 5) | d);
+    }
+
+    void Bitfield(u32 opcode, u32 d, u32 n, u32 immr, u32 imms, u32 width) {
+        ASSERT(immr < width && imms < width);
+        dw(opcode | (immr << 16) | (imms << 10) | (n << 5) | d);
+    }
+
+    void LoadStore(u32 opcode, u32 t, u32 n, u32 offset, u32 scale) {
+        ASSERT_MSG(offset % scale == 0 && offset / scale < 0x1000, "Offset out of range");
+        dw(opcode | ((offset / scale) << 10) | (n << 5) | t);
+    }
+
+    void LoadStorePair(u32 opcode, u32 t1, u32 t2, u32 n, s32 offset, s32 scale,
+                       IndexMode mode) {
+        ASSERT_MSG(offset % scale == 0 && offset / scale >= -64 && offset / scale < 64,
+                   "Offset out of range");
+        static constexpr u32 mode_bits[] = {0x01000000, 0x01800000, 0x00800000};
+        const u32 imm7 = static_cast<u32>(offset / scale) & 0x7F;
+        dw(opcode | mode_bits[static_cast<int>(mode)] | (imm7 << 15) | (t2 << 10) | (n << 5) |
+           t1);
+    }
+
+    u32* code_start;
+    u32* code_end;
+    u32* current;
+};
+
+} // namespace Common::A64
@@ -263,6 +263,24 @@ bool Rename(const std::string& srcFilename, const std::string& destFilename) {
     return false;
 }
 
+bool Replace(const std::string& srcFilename, const std::string& destFilename) {
+    LOG_TRACE(Common_Filesystem, "{} --> {}", srcFilename, destFilename);
+#ifdef _WIN32
+    // Unlike _wrename, this doesn't fail when the destination exists
+    if (MoveFileExW(Common::UTF8ToUTF16W(srcFilename).c_str(),
+                    Common::UTF8ToUTF16W(destFilename).c_str(),
+                    MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH))
+        return true;
+#else
+    // rename replaces an existing destination atomically
+    if (rename(srcFilename.c_str(), destFilename.c_str()) == 0)
+        return true;
+#endif
+    LOG_ERROR(Common_Filesystem, "failed {} --> {}: {}", srcFilename, destFilename,
+              GetLastErrorMsg());
+    return false;
+}
+
 bool Copy(const std::string& srcFilename, const std::string& destFilename) {
     LOG_TRACE(Common_Filesystem, "{} --> {}", srcFilename, destFilename);
 #ifdef _WIN32
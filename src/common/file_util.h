@@ -121,6 +121,10 @@ bool DeleteDir(const std::string& filename);
 // renames file srcFilename to destFilename, returns true on success
 bool Rename(const std::string& srcFilename, const std::string& destFilename);
 
+// renames file srcFilename to destFilename, atomically replacing destFilename if it exists.
+// destFilename is left untouched on failure. returns true on success
+bool Replace(const std::string& srcFilename, const std::string& destFilename);
+
 // copies file srcFilename to destFilename, returns true on success
 bool Copy(const std::string& srcFilename, const std::string& destFilename);
 
@@ -0,0 +1,117 @@
+// Copyright 2022 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#ifdef __linux__
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "common/assert.h"
+#include "common/host_memory.h"
+#include "common/logging/log.h"
+
+namespace Common {
+
+#ifdef __linux__
+
+HostMemory::HostMemory(std::size_t backing_size_) : backing_size{backing_size_} {
+    fd = memfd_create("CitraHostMemory", MFD_CLOEXEC);
+    if (fd < 0) {
+        LOG_ERROR(Common_Memory, "memfd_create failed: {}", std::strerror(errno));
+    } else if (ftruncate(fd, static_cast<off_t>(backing_size)) != 0) {
+        LOG_ERROR(Common_Memory, "ftruncate failed: {}", std::strerror(errno));
+        close(fd);
+        fd = -1;
+    } else {
+        void* const base =
+            mmap(nullptr, backing_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (base == MAP_FAILED) {
+            LOG_ERROR(Common_Memory, "Mapping the backing memory failed: {}",
+                      std::strerror(errno));
+            close(fd);
+            fd = -1;
+        } else {
+            backing_base = static_cast<u8*>(base);
+            return;
+        }
+    }
+
+    fallback = std::make_unique<u8[]>(backing_size);
+    backing_base = fallback.get();
+}
+
+HostMemory::~HostMemory() {
+    if (fd >= 0) {
+        munmap(backing_base, backing_size);
+        close(fd);
+    }
+}
+
+std::unique_ptr<HostMemory::View> HostMemory::CreateView() const {
+    if (fd < 0) {
+        return nullptr;
+    }
+    // Nothing is committed for the reservation itself, pages only exist once they are mapped
+    void* const base = mmap(nullptr, VIEW_SIZE, PROT_NONE,
+                            MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (base == MAP_FAILED) {
+        LOG_ERROR(Common_Memory, "Reserving a view failed: {}", std::strerror(errno));
+        return nullptr;
+    }
+    return std::unique_ptr<View>(new View(fd, static_cast<u8*>(base)));
+}
+
+HostMemory::View::View(int fd_, u8* base_) : fd{fd_}, base{base_} {}
+
+HostMemory::View::~View() {
+    munmap(base, VIEW_SIZE);
+}
+
+void HostMemory::View::Map(std::size_t virtual_offset, std::size_t backing_offset,
+                           std::size_t size) {
+    ASSERT(virtual_offset + size <= VIEW_SIZE);
+    void* const result = mmap(base + virtual_offset, size, PROT_READ | PROT_WRITE,
+                              MAP_SHARED | MAP_FIXED, fd, static_cast<off_t>(backing_offset));
+    ASSERT_MSG(result != MAP_FAILED, "Mapping into a view failed: {}", std::strerror(errno));
+}
+
+void HostMemory::View::Unmap(std::size_t virtual_offset, std::size_t size) {
+    ASSERT(virtual_offset + size <= VIEW_SIZE);
+    // Replacing the range keeps it reserved, so nothing else can be mapped there in between
+    void* const result = mmap(base + virtual_offset, size, PROT_NONE,
+                              MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_FIXED, -1, 0);
+    ASSERT_MSG(result != MAP_FAILED, "Unmapping from a view failed: {}", std::strerror(errno));
+}
+
+#else
+
+HostMemory::HostMemory(std::size_t backing_size_)
+    : backing_size{backing_size_}, fallback{std::make_unique<u8[]>(backing_size_)} {
+    backing_base = fallback.get();
+}
+
+HostMemory::~HostMemory() = default;
+
+std::unique_ptr<HostMemory::View> HostMemory::CreateView() const {
+    return nullptr;
+}
+
+HostMemory::View::View(int fd_, u8* base_) : fd{fd_}, base{base_} {}
+
+HostMemory::View::~View() = default;
+
+void HostMemory::View::Map(std::size_t, std::size_t, std::size_t) {
+    UNREACHABLE();
+}
+
+void HostMemory::View::Unmap(std::size_t, std::size_t) {
+    UNREACHABLE();
+}
+
+#endif
+
+} // namespace Common
@@ -0,0 +1,88 @@
+// Copyright 2022 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include "common/common_types.h"
+
+namespace Common {
+
+/**
+ * A block of host memory that can be mapped into 32-bit address space views besides its regular
+ * mapping. A JIT can then access any guest address by adding it to the base of a view, and
+ * accesses to pages not mapped into the view fault instead of going through a page table.
+ * Views are backed by a shared memory file and only supported on Linux. Elsewhere the memory is
+ * a plain allocation and CreateView returns nullptr.
+ */
+class HostMemory {
+public:
+    /// A 4 GiB host reservation in which ranges of the backing memory can be mapped
+    class View {
+    public:
+        ~View();
+
+        View(const View&) = delete;
+        View& operator=(const View&) = delete;
+
+        /// Returns the host address corresponding to address 0 of the view
+        u8* BasePointer() const {
+            return base;
+        }
+
+        /**
+         * Maps a range of the backing memory into the view.
+         * @param virtual_offset Offset in the view to map at, page aligned
+         * @param backing_offset Offset in the backing memory, page aligned
+         * @param size Size of the range in bytes, page aligned
+         */
+        void Map(std::size_t virtual_offset, std::size_t backing_offset, std::size_t size);
+
+        /// Makes a range of the view inaccessible, so that accesses to it fault
+        void Unmap(std::size_t virtual_offset, std::size_t size);
+
+    private:
+        friend class HostMemory;
+        View(int fd, u8* base);
+
+        int fd;
+        u8* base;
+    };
+
+    /// Size of the address space covered by a view
+    static constexpr std::size_t VIEW_SIZE = std::size_t{1} << 32;
+
+    explicit HostMemory(std::size_t backing_size);
+    ~HostMemory();
+
+    HostMemory(const HostMemory&) = delete;
+    HostMemory& operator=(const HostMemory&) = delete;
+
+    /// Returns the regular mapping of the backing memory, which is zero-initialized
+    u8* BackingBasePointer() const {
+        return backing_base;
+    }
+
+    /// Returns the offset of a pointer in the backing memory, or -1 if it isn't part of it
+    std::ptrdiff_t GetBackingOffset(const u8* pointer) const {
+        if (pointer < backing_base || pointer >= backing_base + backing_size) {
+            return -1;
+        }
+        return pointer - backing_base;
+    }
+
+    /// Creates a view with nothing mapped in it, returns nullptr if views aren't supported
+    std::unique_ptr<View> CreateView() const;
+
+private:
+    std::size_t backing_size;
+    u8* backing_base = nullptr;
+    /// Shared memory file backing the memory, -1 when views aren't supported
+    int fd = -1;
+    /// Allocation used instead of the shared memory file when views aren't supported
+    std::unique_ptr<u8[]> fallback;
+};
+
+} // namespace Common
@@ -18,6 +18,9 @@
 namespace Common {
 
 /// SPSC ring buffer
+/// Push must only be called from the producer thread and Pop only from the consumer thread. Each
+/// side publishes its index with release semantics after copying the slots, and acquires the index
+/// of the other side before accessing them.
 /// @tparam T            Element type
 /// @tparam capacity     Number of slots in ring buffer
 /// @tparam granularity  Slot size in terms of number of elements
@@ -39,8 +42,9 @@ public:
     /// @param slot_count  Number of slots to push
     /// @returns The number of slots actually pushed
     std::size_t Push(const void* new_slots, std::size_t slot_count) {
-        const std::size_t write_index = m_write_index.load();
-        const std::size_t slots_free = capacity + m_read_index.load() - write_index;
+        const std::size_t write_index = m_write_index.load(std::memory_order_relaxed);
+        const std::size_t slots_free =
+            capacity + m_read_index.load(std::memory_order_acquire) - write_index;
         const std::size_t push_count = std::min(slot_count, slots_free);
 
         const std::size_t pos = write_index % capacity;
@@ -52,7 +56,7 @@ public:
         in += first_copy * slot_size;
         std::memcpy(m_data.data(), in, second_copy * slot_size);
 
-        m_write_index.store(write_index + push_count);
+        m_write_index.store(write_index + push_count, std::memory_order_release);
 
         return push_count;
     }
@@ -66,8 +70,8 @@ public:
     /// @param max_slots  Maximum number of slots to pop
     /// @returns The number of slots actually popped
     std::size_t Pop(void* output, std::size_t max_slots = ~std::size_t(0)) {
-        const std::size_t read_index = m_read_index.load();
-        const std::size_t slots_filled = m_write_index.load() - read_index;
+        const std::size_t read_index = m_read_index.load(std::memory_order_relaxed);
+        const std::size_t slots_filled = m_write_index.load(std::memory_order_acquire) - read_index;
         const std::size_t pop_count = std::min(slots_filled, max_slots);
 
         const std::size_t pos = read_index % capacity;
@@ -79,7 +83,7 @@ public:
         out += first_copy * slot_size;
         std::memcpy(out, m_data.data(), second_copy * slot_size);
 
-        m_read_index.store(read_index + pop_count);
+        m_read_index.store(read_index + pop_count, std::memory_order_release);
 
         return pop_count;
     }
@@ -0,0 +1,260 @@
+// Copyright 2022 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include "common/common_types.h"
+#include "common/swap.h"
+
+#if defined(ARCHITECTURE_x86_64)
+#include <emmintrin.h>
+#elif defined(ARCHITECTURE_ARM64)
+#include <arm_neon.h>
+#endif
+
+/**
+ * Pixel conversion helpers working on one 32-bit pixel per lane. Code is written once against the
+ * shared interface and instantiated with Lanes for the bulk of an image and with Scalar for the
+ * pixels left over. Loads zero extend little endian values of the given size.
+ */
+namespace Common::Simd {
+
+/// A single pixel, used where a run of pixels doesn't fill a whole vector
+struct Scalar {
+    static constexpr std::size_t Count = 1;
+
+    u32 v;
+
+    static Scalar Splat(u32 value) {
+        return {value};
+    }
+
+    static Scalar Load8(const u8* src) {
+        return {src[0]};
+    }
+
+    static Scalar Load16(const u8* src) {
+        u16_le value;
+        std::memcpy(&value, src, sizeof(value));
+        return {value};
+    }
+
+    static Scalar Load24(const u8* src) {
+        return {static_cast<u32>(src[0] | (src[1] << 8) | (src[2] << 16))};
+    }
+
+    static Scalar Load32(const u8* src) {
+        u32_le value;
+        std::memcpy(&value, src, sizeof(value));
+        return {value};
+    }
+
+    void Store16(u8* dst) const {
+        const u16_le value = static_cast<u16>(v);
+        std::memcpy(dst, &value, sizeof(value));
+    }
+
+    void Store24(u8* dst) const {
+        dst[0] = static_cast<u8>(v);
+        dst[1] = static_cast<u8>(v >> 8);
+        dst[2] = static_cast<u8>(v >> 16);
+    }
+
+    void Store32(u8* dst) const {
+        const u32_le value = v;
+        std::memcpy(dst, &value, sizeof(value));
+    }
+
+    template <int shift>
+    Scalar ShiftLeft() const {
+        return {v << shift};
+    }
+
+    template <int shift>
+    Scalar ShiftRight() const {
+        return {v >> shift};
+    }
+
+    Scalar operator&(const Scalar& other) const {
+        return {v & other.v};
+    }
+
+    Scalar operator|(const Scalar& other) const {
+        return {v | other.v};
+    }
+
+    Scalar operator-(const Scalar& other) const {
+        return {v - other.v};
+    }
+
+    /// Adds each byte separately, clamping to 255
+    Scalar AddSaturateBytes(const Scalar& other) const {
+        u32 result = 0;
+        for (u32 shift = 0; shift < 32; shift += 8) {
+            const u32 sum = ((v >> shift) & 0xFF) + ((other.v >> shift) & 0xFF);
+            result |= std::min<u32>(sum, 0xFF) << shift;
+        }
+        return {result};
+    }
+
+    /// Subtracts each byte separately, clamping to 0
+    Scalar SubSaturateBytes(const Scalar& other) const {
+        u32 result = 0;
+        for (u32 shift = 0; shift < 32; shift += 8) {
+            const u32 a = (v >> shift) & 0xFF;
+            const u32 b = (other.v >> shift) & 0xFF;
+            result |= (a > b ? a - b : 0) << shift;
+        }
+        return {result};
+    }
+};
+
+#if defined(ARCHITECTURE_x86_64)
+
+/// Four pixels, one per 32-bit lane. SSE2 is part of the x86-64 baseline.
+struct Lanes {
+    static constexpr std::size_t Count = 4;
+
+    __m128i v;
+
+    static Lanes Splat(u32 value) {
+        return {_mm_set1_epi32(static_cast<s32>(value))};
+    }
+
+    static Lanes Load8(const u8* src) {
+        u32 bytes;
+        std::memcpy(&bytes, src, sizeof(bytes));
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i pixels = _mm_cvtsi32_si128(static_cast<s32>(bytes));
+        return {_mm_unpacklo_epi16(_mm_unpacklo_epi8(pixels, zero), zero)};
+    }
+
+    static Lanes Load16(const u8* src) {
+        const __m128i pixels = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(src));
+        return {_mm_unpacklo_epi16(pixels, _mm_setzero_si128())};
+    }
+
+    static Lanes Load32(const u8* src) {
+        return {_mm_loadu_si128(reinterpret_cast<const __m128i*>(src))};
+    }
+
+    void Store16(u8* dst) const {
+        // Sign extend the low halves so that the signed saturation of the pack keeps them intact
+        const __m128i low = _mm_srai_epi32(_mm_slli_epi32(v, 16), 16);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(dst), _mm_packs_epi32(low, low));
+    }
+
+    void Store32(u8* dst) const {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), v);
+    }
+
+    template <int shift>
+    Lanes ShiftLeft() const {
+        return {_mm_slli_epi32(v, shift)};
+    }
+
+    template <int shift>
+    Lanes ShiftRight() const {
+        return {_mm_srli_epi32(v, shift)};
+    }
+
+    Lanes operator&(const Lanes& other) const {
+        return {_mm_and_si128(v, other.v)};
+    }
+
+    Lanes operator|(const Lanes& other) const {
+        return {_mm_or_si128(v, other.v)};
+    }
+
+    Lanes operator-(const Lanes& other) const {
+        return {_mm_sub_epi32(v, other.v)};
+    }
+
+    Lanes AddSaturateBytes(const Lanes& other) const {
+        return {_mm_adds_epu8(v, other.v)};
+    }
+
+    Lanes SubSaturateBytes(const Lanes& other) const {
+        return {_mm_subs_epu8(v, other.v)};
+    }
+};
+
+#elif defined(ARCHITECTURE_ARM64)
+
+/// Four pixels, one per 32-bit lane
+struct Lanes {
+    static constexpr std::size_t Count = 4;
+
+    uint32x4_t v;
+
+    static Lanes Splat(u32 value) {
+        return {vdupq_n_u32(value)};
+    }
+
+    static Lanes Load8(const u8* src) {
+        u32 bytes;
+        std::memcpy(&bytes, src, sizeof(bytes));
+        const uint8x8_t pixels = vreinterpret_u8_u32(vdup_n_u32(bytes));
+        return {vmovl_u16(vget_low_u16(vmovl_u8(pixels)))};
+    }
+
+    static Lanes Load16(const u8* src) {
+        return {vmovl_u16(vreinterpret_u16_u8(vld1_u8(src)))};
+    }
+
+    static Lanes Load32(const u8* src) {
+        return {vreinterpretq_u32_u8(vld1q_u8(src))};
+    }
+
+    void Store16(u8* dst) const {
+        vst1_u8(dst, vreinterpret_u8_u16(vmovn_u32(v)));
+    }
+
+    void Store32(u8* dst) const {
+        vst1q_u8(dst, vreinterpretq_u8_u32(v));
+    }
+
+    template <int shift>
+    Lanes ShiftLeft() const {
+        return {vshlq_n_u32(v, shift)};
+    }
+
+    template <int shift>
+    Lanes ShiftRight() const {
+        return {vshrq_n_u32(v, shift)};
+    }
+
+    Lanes operator&(const Lanes& other) const {
+        return {vandq_u32(v, other.v)};
+    }
+
+    Lanes operator|(const Lanes& other) const {
+        return {vorrq_u32(v, other.v)};
+    }
+
+    Lanes operator-(const Lanes& other) const {
+        return {vsubq_u32(v, other.v)};
+    }
+
+    Lanes AddSaturateBytes(const Lanes& other) const {
+        return {vreinterpretq_u32_u8(
+            vqaddq_u8(vreinterpretq_u8_u32(v), vreinterpretq_u8_u32(other.v)))};
+    }
+
+    Lanes SubSaturateBytes(const Lanes& other) const {
+        return {vreinterpretq_u32_u8(
+            vqsubq_u8(vreinterpretq_u8_u32(v), vreinterpretq_u8_u32(other.v)))};
+    }
+};
+
+#else
+
+using Lanes = Scalar;
+
+#endif
+
+} // namespace Common::Simd
@@ -0,0 +1,53 @@
+// Copyright 2022 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Common {
+
+/**
+ * A fixed pool of host threads draining a shared queue of work items.
+ *
+ * Work items are executed in no particular order and on no particular thread, so callers that
+ * need ordering have to partition the work such that independent items never touch the same data.
+ */
+class ThreadWorker {
+public:
+    explicit ThreadWorker(std::size_t num_workers, const std::string& name);
+    ~ThreadWorker();
+
+    /// Queues a work item to be run on one of the worker threads
+    void QueueWork(std::function<void()> work);
+
+    /// Blocks until every work item queued so far has finished executing
+    void WaitForRequests();
+
+    /// Returns the number of host threads owned by the pool
+    std::size_t NumWorkers() const {
+        return threads.size();
+    }
+
+private:
+    void WorkerLoop(const std::string& thread_name);
+
+    std::vector<std::thread> threads;
+    std::queue<std::function<void()>> requests;
+    std::mutex queue_mutex;
+    std::condition_variable condition;
+    std::condition_variable wait_condition;
+    std::size_t work_scheduled = 0;
+    std::size_t work_done = 0;
+    bool stop = false;
+};
+
+} // namespace Common
@@ -7,6 +7,7 @@
 // a simple lockless thread-safe,
 // single reader, single writer queue
 
+#include <array>
 #include <atomic>
 #include <condition_variable>
 #include <cstddef>
@@ -124,6 +125,102 @@ private:
     std::condition_variable cv;
 };
 
+/**
+ * Single reader, single writer queue of fixed capacity. Elements live in a ring of preallocated
+ * slots, so pushing never allocates. Each side publishes its index with release semantics after
+ * accessing the slots and acquires the index of the other side before accessing them. The mutex is
+ * only taken to sleep when the queue is full or empty, and to wake a side which went to sleep.
+ * @tparam T Element type, which has to be default constructible and move assignable
+ * @tparam capacity Number of slots, a power of two
+ */
+template <typename T, std::size_t capacity>
+class BoundedSPSCQueue {
+    static_assert(capacity > 0 && (capacity & (capacity - 1)) == 0,
+                  "capacity must be a power of two");
+
+public:
+    [[nodiscard]] std::size_t Size() const {
+        return write_index.load(std::memory_order_acquire) -
+               read_index.load(std::memory_order_acquire);
+    }
+
+    [[nodiscard]] bool Empty() const {
+        return Size() == 0;
+    }
+
+    /// Pushes an element, blocking while the queue is full. Must only be called by the writer.
+    template <typename Arg>
+    void Push(Arg&& t) {
+        const std::size_t write = write_index.load(std::memory_order_relaxed);
+        if (write - read_index.load(std::memory_order_acquire) == capacity) {
+            Sleep(writer_waiting, not_full, [this, write] {
+                return write - read_index.load(std::memory_order_acquire) < capacity;
+            });
+        }
+        slots[write % capacity] = std::forward<Arg>(t);
+        write_index.store(write + 1, std::memory_order_release);
+        Wake(reader_waiting, not_empty);
+    }
+
+    /// Pops an element if there is one. Must only be called by the reader.
+    bool Pop(T& t) {
+        const std::size_t read = read_index.load(std::memory_order_relaxed);
+        if (read == write_index.load(std::memory_order_acquire)) {
+            return false;
+        }
+        t = std::move(slots[read % capacity]);
+        read_index.store(read + 1, std::memory_order_release);
+        Wake(writer_waiting, not_full);
+        return true;
+    }
+
+    /// Pops an element, blocking while the queue is empty. Must only be called by the reader.
+    T PopWait() {
+        const std::size_t read = read_index.load(std::memory_order_relaxed);
+        if (read == write_index.load(std::memory_order_acquire)) {
+            Sleep(reader_waiting, not_empty, [this, read] {
+                return read != write_index.load(std::memory_order_acquire);
+            });
+        }
+        T t{};
+        Pop(t);
+        return t;
+    }
+
+private:
+    /// Blocks until the condition holds. The waiting flag is raised before the condition is
+    /// checked again and the other side checks the flag after publishing its index, so with the
+    /// fences in between one of them always sees the other's write and no wakeup is lost.
+    template <typename Predicate>
+    void Sleep(std::atomic_bool& waiting, std::condition_variable& cv, Predicate&& predicate) {
+        std::unique_lock lock{cv_mutex};
+        waiting.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        cv.wait(lock, predicate);
+        waiting.store(false, std::memory_order_relaxed);
+    }
+
+    void Wake(std::atomic_bool& waiting, std::condition_variable& cv) {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiting.load(std::memory_order_relaxed)) {
+            // Under the mutex the other side is either asleep already or yet to check its condition
+            std::lock_guard lock{cv_mutex};
+            cv.notify_one();
+        }
+    }
+
+    // The indices are kept on separate cache lines to avoid false sharing between the threads
+    alignas(128) std::atomic_size_t read_index{0};
+    alignas(128) std::atomic_size_t write_index{0};
+    alignas(128) std::array<T, capacity> slots{};
+
+    std::atomic_bool reader_waiting{false};
+    std::atomic_bool writer_waiting{false};
+    std::mutex cv_mutex;
+    std::condition_variable not_empty;
+    std::condition_variable not_full;
+};
+
 // a simple thread-safe,
 // single reader, multiple writer queue
 
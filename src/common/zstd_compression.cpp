@@ -3,6 +3,7 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
+#include <utility>
 #include <zstd.h>
 
 #include "common/assert.h"
@@ -48,4 +49,52 @@ std::vector<u8> DecompressDataZSTD(const std::vector<u8>& compressed) {
     return decompressed;
 }
 
+ZSTDDecompressionStreamBuffer::ZSTDDecompressionStreamBuffer(ReadFunction read_)
+    : read(std::move(read_)), context(ZSTD_createDCtx()), input(ZSTD_DStreamInSize()),
+      output(ZSTD_DStreamOutSize()) {
+    ASSERT_MSG(context != nullptr, "Failed to create decompression context");
+}
+
+ZSTDDecompressionStreamBuffer::~ZSTDDecompressionStreamBuffer() {
+    ZSTD_freeDCtx(context);
+}
+
+ZSTDDecompressionStreamBuffer::int_type ZSTDDecompressionStreamBuffer::underflow() {
+    if (gptr() < egptr()) {
+        return traits_type::to_int_type(*gptr());
+    }
+
+    while (!error) {
+        if (input_position == input_size && !input_finished) {
+            input_size = read(input.data(), input.size());
+            input_position = 0;
+            input_finished = input_size == 0;
+        }
+
+        ZSTD_inBuffer in{input.data(), input_size, input_position};
+        ZSTD_outBuffer out{output.data(), output.size(), 0};
+        const std::size_t result = ZSTD_decompressStream(context, &out, &in);
+        if (ZSTD_isError(result)) {
+            error = true;
+            break;
+        }
+        if (in.pos != input_position || out.pos != 0) {
+            // Zero once the frame has been decoded and flushed completely
+            frame_complete = result == 0;
+        }
+        input_position = in.pos;
+
+        if (out.pos != 0) {
+            setg(output.data(), output.data(), output.data() + out.pos);
+            return traits_type::to_int_type(*gptr());
+        }
+
+        if (input_finished && input_position == input_size) {
+            error = !frame_complete;
+            break;
+        }
+    }
+    return traits_type::eof();
+}
+
 } // namespace Common::Compression
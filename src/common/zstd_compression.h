@@ -4,10 +4,15 @@
 
 #pragma once
 
+#include <cstddef>
+#include <functional>
+#include <streambuf>
 #include <vector>
 
 #include "common/common_types.h"
 
+struct ZSTD_DCtx_s;
+
 namespace Common::Compression {
 
 /**
@@ -42,4 +47,41 @@ namespace Common::Compression {
  */
 [[nodiscard]] std::vector<u8> DecompressDataZSTD(const std::vector<u8>& compressed);
 
+/**
+ * Stream buffer decompressing a sequence of Zstandard frames while it is being read, so that large
+ * inputs never have to be held in memory as a whole.
+ */
+class ZSTDDecompressionStreamBuffer final : public std::streambuf {
+public:
+    /// Reads up to the given number of compressed bytes into the buffer, returning the count read
+    using ReadFunction = std::function<std::size_t(u8* buffer, std::size_t size)>;
+
+    explicit ZSTDDecompressionStreamBuffer(ReadFunction read);
+    ~ZSTDDecompressionStreamBuffer() override;
+
+    ZSTDDecompressionStreamBuffer(const ZSTDDecompressionStreamBuffer&) = delete;
+    ZSTDDecompressionStreamBuffer& operator=(const ZSTDDecompressionStreamBuffer&) = delete;
+
+    /// Returns whether the compressed data turned out to be malformed or truncated
+    [[nodiscard]] bool HasError() const {
+        return error;
+    }
+
+protected:
+    int_type underflow() override;
+
+private:
+    ReadFunction read;
+    ZSTD_DCtx_s* context;
+
+    std::vector<u8> input;
+    std::size_t input_size = 0;
+    std::size_t input_position = 0;
+    bool input_finished = false;
+
+    std::vector<char> output;
+    bool frame_complete = true;
+    bool error = false;
+};
+
 } // namespace Common::Compression
@@ -3,8 +3,10 @@
 // Refer to the license.txt file included.
 
 #include <cstring>
+#include <optional>
 #include <dynarmic/A32/a32.h>
 #include <dynarmic/A32/context.h>
+#include <dynarmic/exclusive_monitor.h>
 #include "common/assert.h"
 #include "common/microprofile.h"
 #include "core/arm/dynarmic/arm_dynarmic.h"
@@ -13,7 +15,9 @@
 #include "core/core_timing.h"
 #include "core/gdbstub/gdbstub.h"
 #include "core/hle/kernel/svc.h"
+#include "core/hle/lock.h"
 #include "core/memory.h"
+#include "core/settings.h"
 
 class DynarmicThreadContext final : public ARM_Interface::ThreadContext {
 public:
@@ -71,33 +75,71 @@ private:
 class DynarmicUserCallbacks final : public Dynarmic::A32::UserCallbacks {
 public:
     explicit DynarmicUserCallbacks(ARM_Dynarmic& parent)
-        : parent(parent), svc_context(parent.system), memory(parent.memory) {}
+        : parent(parent), memory(parent.memory) {
+        if (parent.system) {
+            svc_context.emplace(*parent.system);
+        }
+    }
     ~DynarmicUserCallbacks() = default;
 
+    /**
+     * When the cores run on their own host threads, which is when they share an exclusive
+     * monitor, the kernel and the memory system are shared with the other cores. Callbacks then
+     * hold the HLE lock and make this core the running one, so that the kernel state and the
+     * current page table belong to it.
+     */
+    template <typename Func>
+    auto Synchronized(Func&& func) {
+        if (!parent.exclusive_monitor) {
+            return func();
+        }
+        std::lock_guard lock{HLE::g_hle_lock};
+        if (parent.system) {
+            parent.system->SetRunningCore(parent);
+        }
+        return func();
+    }
+
     std::uint8_t MemoryRead8(VAddr vaddr) override {
-        return memory.Read8(vaddr);
+        return Synchronized([&] { return memory.Read8(vaddr); });
     }
     std::uint16_t MemoryRead16(VAddr vaddr) override {
-        return memory.Read16(vaddr);
+        return Synchronized([&] { return memory.Read16(vaddr); });
     }
     std::uint32_t MemoryRead32(VAddr vaddr) override {
-        return memory.Read32(vaddr);
+        return Synchronized([&] { return memory.Read32(vaddr); });
     }
     std::uint64_t MemoryRead64(VAddr vaddr) override {
-        return memory.Read64(vaddr);
+        return Synchronized([&] { return memory.Read64(vaddr); });
     }
 
     void MemoryWrite8(VAddr vaddr, std::uint8_t value) override {
-        memory.Write8(vaddr, value);
+        Synchronized([&] { memory.Write8(vaddr, value); });
     }
     void MemoryWrite16(VAddr vaddr, std::uint16_t value) override {
-        memory.Write16(vaddr, value);
+        Synchronized([&] { memory.Write16(vaddr, value); });
     }
     void MemoryWrite32(VAddr vaddr, std::uint32_t value) override {
-        memory.Write32(vaddr, value);
+        Synchronized([&] { memory.Write32(vaddr, value); });
     }
     void MemoryWrite64(VAddr vaddr, std::uint64_t value) override {
-        memory.Write64(vaddr, value);
+        Synchronized([&] { memory.Write64(vaddr, value); });
+    }
+
+    bool MemoryWriteExclusive8(VAddr vaddr, std::uint8_t value, std::uint8_t expected) override {
+        return Synchronized([&] { return memory.WriteExclusive8(vaddr, value, expected); });
+    }
+    bool MemoryWriteExclusive16(VAddr vaddr, std::uint16_t value,
+                                std::uint16_t expected) override {
+        return Synchronized([&] { return memory.WriteExclusive16(vaddr, value, expected); });
+    }
+    bool MemoryWriteExclusive32(VAddr vaddr, std::uint32_t value,
+                                std::uint32_t expected) override {
+        return Synchronized([&] { return memory.WriteExclusive32(vaddr, value, expected); });
+    }
+    bool MemoryWriteExclusive64(VAddr vaddr, std::uint64_t value,
+                                std::uint64_t expected) override {
+        return Synchronized([&] { return memory.WriteExclusive64(vaddr, value, expected); });
     }
 
     void InterpreterFallback(VAddr pc, std::size_t num_instructions) override {
@@ -107,7 +149,8 @@ public:
     }
 
     void CallSVC(std::uint32_t swi) override {
-        svc_context.CallSVC(swi);
+        DEBUG_ASSERT(svc_context);
+        Synchronized([&] { svc_context->CallSVC(swi); });
     }
 
     void ExceptionRaised(VAddr pc, Dynarmic::A32::Exception exception) override {
@@ -145,13 +188,16 @@ public:
     }
 
     ARM_Dynarmic& parent;
-    Kernel::SVCContext svc_context;
+    /// Null when the core runs without a system, as in tests
+    std::optional<Kernel::SVCContext> svc_context;
     Memory::MemorySystem& memory;
 };
 
 ARM_Dynarmic::ARM_Dynarmic(Core::System* system, Memory::MemorySystem& memory, u32 id,
-                           std::shared_ptr<Core::Timing::Timer> timer)
-    : ARM_Interface(id, timer), system(*system), memory(memory),
+                           std::shared_ptr<Core::Timing::Timer> timer,
+                           std::shared_ptr<Dynarmic::ExclusiveMonitor> exclusive_monitor)
+    : ARM_Interface(id, timer), system(system), memory(memory),
+      exclusive_monitor(std::move(exclusive_monitor)),
       cb(std::make_unique<DynarmicUserCallbacks>(*this)) {
     SetPageTable(memory.GetCurrentPageTable());
 }
@@ -161,7 +207,8 @@ ARM_Dynarmic::~ARM_Dynarmic() = default;
 MICROPROFILE_DEFINE(ARM_Jit, "ARM JIT", "ARM JIT", MP_RGB(255, 64, 64));
 
 void ARM_Dynarmic::Run() {
-    ASSERT(memory.GetCurrentPageTable() == current_page_table);
+    // With core threads the current page table is whichever core entered the kernel last
+    ASSERT(exclusive_monitor || memory.GetCurrentPageTable() == current_page_table);
     MICROPROFILE_SCOPE(ARM_Jit);
 
     jit->Run();
@@ -296,6 +343,10 @@ std::shared_ptr<Memory::PageTable> ARM_Dynarmic::GetPageTable() const {
 }
 
 void ARM_Dynarmic::SetPageTable(const std::shared_ptr<Memory::PageTable>& page_table) {
+    // Also called while executing, when a callback makes this core the running one
+    if (jit && page_table == current_page_table) {
+        return;
+    }
     current_page_table = page_table;
     Dynarmic::A32::Context ctx{};
     if (jit) {
@@ -316,16 +367,46 @@ void ARM_Dynarmic::SetPageTable(const std::shared_ptr<Memory::PageTable>& page_t
 }
 
 void ARM_Dynarmic::ServeBreak() {
-    Kernel::Thread* thread = system.Kernel().GetCurrentThreadManager().GetCurrentThread();
+    DEBUG_ASSERT(system != nullptr);
+    Kernel::Thread* thread = system->Kernel().GetCurrentThreadManager().GetCurrentThread();
     SaveContext(thread->context);
     GDBStub::Break();
     GDBStub::SendTrap(thread, 5);
 }
 
+/// Older dynarmic versions can't access guest memory through a host view of the address space
+template <typename Config>
+constexpr bool SupportsFastmem = requires(Config& config) {
+    config.fastmem_pointer;
+    config.recompile_on_fastmem_failure;
+};
+
+template <typename Config>
+static void ConfigureFastmem(Config& config, Memory::MemorySystem& memory,
+                             Memory::PageTable& page_table) {
+    if constexpr (SupportsFastmem<Config>) {
+        // Accesses to pages that aren't mapped in the view, like MMIO and rasterizer cached
+        // memory, fault and get recompiled to go through the memory callbacks
+        config.fastmem_pointer = memory.GetFastmemBase(page_table);
+        config.recompile_on_fastmem_failure = true;
+    } else {
+        LOG_WARNING(Core_ARM11, "Fastmem is not supported by this version of dynarmic");
+    }
+}
+
 std::unique_ptr<Dynarmic::A32::Jit> ARM_Dynarmic::MakeJit() {
     Dynarmic::A32::UserConfig config;
     config.callbacks = cb.get();
     config.page_table = &current_page_table->GetPointerArray();
+#ifdef ARCHITECTURE_x86_64
+    if (Settings::values.use_fastmem) {
+        ConfigureFastmem(config, memory, *current_page_table);
+    }
+#endif
+    if (exclusive_monitor) {
+        config.global_monitor = exclusive_monitor.get();
+        config.processor_id = GetID();
+    }
     config.coprocessors[15] = std::make_shared<DynarmicCP15>(cp15_state);
     config.define_unpredictable_behaviour = true;
     return std::make_unique<Dynarmic::A32::Jit>(config);
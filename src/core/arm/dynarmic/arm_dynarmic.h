@@ -11,6 +11,10 @@
 #include "core/arm/arm_interface.h"
 #include "core/arm/dynarmic/arm_dynarmic_cp15.h"
 
+namespace Dynarmic {
+class ExclusiveMonitor;
+}
+
 namespace Memory {
 struct PageTable;
 class MemorySystem;
@@ -25,7 +29,8 @@ class DynarmicUserCallbacks;
 class ARM_Dynarmic final : public ARM_Interface {
 public:
     ARM_Dynarmic(Core::System* system, Memory::MemorySystem& memory, u32 id,
-                 std::shared_ptr<Core::Timing::Timer> timer);
+                 std::shared_ptr<Core::Timing::Timer> timer,
+                 std::shared_ptr<Dynarmic::ExclusiveMonitor> exclusive_monitor = nullptr);
     ~ARM_Dynarmic() override;
 
     void Run() override;
@@ -62,8 +67,10 @@ private:
     void ServeBreak();
 
     friend class DynarmicUserCallbacks;
-    Core::System& system;
+    Core::System* system;
     Memory::MemorySystem& memory;
+    /// Monitor shared by the cores for exclusive accesses, null to use a monitor local to the JIT
+    std::shared_ptr<Dynarmic::ExclusiveMonitor> exclusive_monitor;
     std::unique_ptr<DynarmicUserCallbacks> cb;
     std::unique_ptr<Dynarmic::A32::Jit> MakeJit();
 
@@ -0,0 +1,395 @@
+// Copyright 2022 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include "common/logging/log.h"
+#include "core/arm/arm_interface.h"
+#include "core/arm/idle_loop_detector.h"
+#include "core/core_timing.h"
+#include "core/memory.h"
+
+namespace {
+
+/// Longest loop body considered, in instructions
+constexpr u32 MAX_LOOP_INSTRUCTIONS = 8;
+
+/// Analysis results are dropped all at once when there are more than this many
+constexpr std::size_t MAX_CACHED_LOOPS = 4096;
+
+/// Calls to svcGetSystemTick from the same caller within this many cycles may be a poll loop
+constexpr u64 TICK_POLL_WINDOW = 2000;
+/// Number of consecutive polls after which time is fast-forwarded
+constexpr u32 TICK_POLL_THRESHOLD = 16;
+/// Upper bound for a single fast-forward of a poll loop, which may overshoot what it waits for
+constexpr s64 MAX_TICK_POLL_SKIP = usToCycles(50);
+
+/// Pseudo register standing for the condition flags in register masks
+constexpr u32 FLAGS = 1 << 16;
+constexpr u32 PC = 15;
+constexpr u32 COND_ALWAYS = 0xE;
+
+constexpr u32 RegBit(u32 reg) {
+    // Reading PC yields a constant, so it is never part of a mask
+    return reg == PC ? 0 : 1 << reg;
+}
+
+struct Instruction {
+    u32 reads = 0;
+    u32 writes = 0;
+    bool conditional = false;
+    std::optional<VAddr> branch_target;
+    std::optional<IdleLoopLoad> load;
+};
+
+/// Decodes the A32 instructions allowed in an idle loop, returns nullopt for any other instruction
+std::optional<Instruction> Decode(u32 inst, VAddr address) {
+    const u32 cond = inst >> 28;
+    const u32 rn = (inst >> 16) & 0xF;
+    const u32 rd = (inst >> 12) & 0xF;
+    const u32 rs = (inst >> 8) & 0xF;
+    const u32 rm = inst & 0xF;
+    const bool pre_index = (inst >> 24) & 1;
+    const bool add = (inst >> 23) & 1;
+    const bool writeback = (inst >> 21) & 1;
+    const bool load = (inst >> 20) & 1;
+
+    if (cond == 0xF) {
+        return std::nullopt;
+    }
+    Instruction result;
+    result.conditional = cond != COND_ALWAYS;
+    if (result.conditional) {
+        result.reads |= FLAGS;
+    }
+
+    // NOP, YIELD, WFE and WFI
+    if ((inst & 0x0FFFFFFC) == 0x0320F000) {
+        return result;
+    }
+
+    switch ((inst >> 25) & 7) {
+    case 0b101: {
+        // BL has the side effect of writing LR
+        if ((inst >> 24) & 1) {
+            return std::nullopt;
+        }
+        const s32 offset = static_cast<s32>(inst << 8) >> 6;
+        result.branch_target = address + 8 + offset;
+        return result;
+    }
+    case 0b010:
+    case 0b011: {
+        const bool register_offset = (inst >> 25) & 1;
+        // Stores, writeback and media instructions
+        if (!load || !pre_index || writeback || rd == PC || (register_offset && (inst & 0x10))) {
+            return std::nullopt;
+        }
+        const u32 size = (inst >> 22) & 1 ? 1 : 4;
+        IdleLoopLoad info{address, rn, std::nullopt, inst & 0xFFF, 0, add, size};
+        if (register_offset) {
+            // Only LSL by an immediate
+            if (((inst >> 5) & 3) != 0) {
+                return std::nullopt;
+            }
+            info.offset_reg = rm;
+            info.offset = 0;
+            info.shift = (inst >> 7) & 0x1F;
+            result.reads |= RegBit(rm);
+        }
+        result.reads |= RegBit(rn);
+        result.writes |= RegBit(rd);
+        result.load = info;
+        return result;
+    }
+    case 0b000:
+    case 0b001: {
+        const bool immediate = (inst >> 25) & 1;
+        if (!immediate && (inst & 0x90) == 0x90) {
+            // LDRH, LDRSB and LDRSH, everything else here is a multiply, swap or store
+            const u32 op = (inst >> 5) & 3;
+            if (op == 0 || !load || !pre_index || writeback || rd == PC) {
+                return std::nullopt;
+            }
+            IdleLoopLoad info{address, rn, std::nullopt, 0, 0, add, op == 2 ? 1u : 2u};
+            if ((inst >> 22) & 1) {
+                info.offset = ((inst >> 4) & 0xF0) | rm;
+            } else {
+                info.offset_reg = rm;
+                result.reads |= RegBit(rm);
+            }
+            result.reads |= RegBit(rn);
+            result.writes |= RegBit(rd);
+            result.load = info;
+            return result;
+        }
+
+        const u32 opcode = (inst >> 21) & 0xF;
+        const bool set_flags = (inst >> 20) & 1;
+        const bool compare = (opcode & 0b1100) == 0b1000;
+        // Without S these encodings are MRS, MSR, BX and the other miscellaneous instructions
+        if ((compare && !set_flags) || (rd == PC && !compare)) {
+            return std::nullopt;
+        }
+        // MOV and MVN don't read Rn
+        if (opcode != 0b1101 && opcode != 0b1111) {
+            result.reads |= RegBit(rn);
+        }
+        // ADC, SBC and RSC read the carry flag
+        if (opcode == 0b0101 || opcode == 0b0110 || opcode == 0b0111) {
+            result.reads |= FLAGS;
+        }
+        if (!immediate) {
+            result.reads |= RegBit(rm);
+            if (inst & 0x10) {
+                if (rs == PC || rm == PC || rn == PC) {
+                    return std::nullopt;
+                }
+                result.reads |= RegBit(rs);
+            } else if (((inst >> 5) & 3) == 3 && ((inst >> 7) & 0x1F) == 0) {
+                // RRX reads the carry flag
+                result.reads |= FLAGS;
+            }
+        }
+        if (!compare) {
+            result.writes |= RegBit(rd);
+        }
+        if (set_flags) {
+            result.writes |= FLAGS;
+        }
+        return result;
+    }
+    default:
+        return std::nullopt;
+    }
+}
+
+/**
+ * Analyzes the loop around pc for FindIdleLoop and FindTickPollLoop
+ * @param call Address of a BL that is allowed in the loop, it is taken to return a new value in
+ * r0 and r1 and to clobber the other registers a call may clobber
+ */
+std::optional<IdleLoop> AnalyzeLoop(VAddr pc, const std::function<u32(VAddr)>& read_code,
+                                    std::optional<VAddr> call) {
+    const auto decode = [&](VAddr address) -> std::optional<Instruction> {
+        const u32 inst = read_code(address);
+        if (address == call && (inst & 0xFF000000) == 0xEB000000) {
+            Instruction result;
+            result.writes = RegBit(0) | RegBit(1) | RegBit(2) | RegBit(3) | RegBit(12) |
+                            RegBit(14) | FLAGS;
+            return result;
+        }
+        return Decode(inst, address);
+    };
+
+    // Find the branch closing the loop around pc
+    std::optional<VAddr> start;
+    VAddr end = pc;
+    for (u32 i = 0; i < MAX_LOOP_INSTRUCTIONS && !start; ++i) {
+        end = pc + i * 4;
+        const auto inst = decode(end);
+        if (!inst) {
+            return std::nullopt;
+        }
+        if (inst->branch_target && *inst->branch_target <= pc) {
+            start = inst->branch_target;
+        }
+    }
+    if (!start || (end - *start) / 4 >= MAX_LOOP_INSTRUCTIONS) {
+        return std::nullopt;
+    }
+
+    std::vector<Instruction> body;
+    u32 body_writes = 0;
+    for (VAddr address = *start; address <= end; address += 4) {
+        const auto inst = decode(address);
+        if (!inst) {
+            return std::nullopt;
+        }
+        // Branches other than the last one have to leave the loop
+        if (address != end && inst->branch_target && *inst->branch_target >= *start &&
+            *inst->branch_target <= end) {
+            return std::nullopt;
+        }
+        body_writes |= inst->writes;
+        body.push_back(*inst);
+    }
+
+    // Every value read in the loop must either be constant or be produced earlier in the same
+    // iteration, otherwise iterations could differ, as in a loop counting down a register
+    IdleLoop loop{*start, end, {}};
+    u32 defined = 0;
+    for (const Instruction& inst : body) {
+        if (inst.reads & body_writes & ~defined) {
+            return std::nullopt;
+        }
+        if (inst.load) {
+            const u32 address_regs =
+                RegBit(inst.load->base_reg) |
+                (inst.load->offset_reg ? RegBit(*inst.load->offset_reg) : 0);
+            if (address_regs & body_writes) {
+                return std::nullopt;
+            }
+            loop.loads.push_back(*inst.load);
+        }
+        if (!inst.conditional) {
+            defined |= inst.writes;
+        }
+    }
+    return loop;
+}
+
+} // Anonymous namespace
+
+std::optional<IdleLoop> FindIdleLoop(VAddr pc, const std::function<u32(VAddr)>& read_code) {
+    return AnalyzeLoop(pc, read_code, std::nullopt);
+}
+
+std::optional<IdleLoop> FindTickPollLoop(VAddr return_address,
+                                         const std::function<u32(VAddr)>& read_code) {
+    const VAddr call = return_address - 4;
+    return AnalyzeLoop(call, read_code, call);
+}
+
+IdleLoopDetector::IdleLoopDetector(Memory::MemorySystem& memory, std::size_t num_cores)
+    : memory(memory), cores(num_cores) {}
+
+IdleLoopDetector::~IdleLoopDetector() = default;
+
+bool IdleLoopDetector::SkipIdleLoop(ARM_Interface& core, u64 title_id) {
+    CoreState& state = cores[core.GetID()];
+    const auto& loop = LookupLoop(core);
+    if (!loop) {
+        state.last_loop.reset();
+        return false;
+    }
+    // Only loops that survive a whole slice are worth probing
+    if (state.last_loop != loop->start) {
+        state.last_loop = loop->start;
+        return false;
+    }
+
+    // The loop only exits once memory changes. Run two iterations to see whether it already did
+    const auto in_loop = [&] { return core.GetPC() >= loop->start && core.GetPC() <= loop->end; };
+    const u32 num_instructions = (loop->end - loop->start) / 4 + 1;
+    for (u32 i = 0; i < 2 * num_instructions; ++i) {
+        core.Step();
+        if (!in_loop()) {
+            state.last_loop.reset();
+            return false;
+        }
+    }
+    // MMIO may change at any time
+    if (!LoadsFromMemory(core, *loop)) {
+        return false;
+    }
+
+    auto& timer = core.GetTimer();
+    const s64 remaining = std::max<s64>(timer.GetDowncount(), 0);
+    Stats& title_stats = stats[title_id];
+    title_stats.skipped_cycles += remaining;
+    ++title_stats.skipped_slices;
+    LOG_TRACE(Core_ARM11, "Core {} skipping {} cycles of idle loop at {:08X}", core.GetID(),
+              remaining, loop->start);
+    timer.Idle();
+    return true;
+}
+
+void IdleLoopDetector::OnGetSystemTick(ARM_Interface& core, u64 title_id) {
+    CoreState& state = cores[core.GetID()];
+    auto& timer = core.GetTimer();
+    // Callers share the code issuing the SVC, so a poll loop is told apart by its return address
+    const VAddr return_address = core.GetReg(14);
+    const u64 ticks = timer.GetTicks();
+    if (return_address == state.tick_poll_return_address &&
+        ticks - state.tick_poll_ticks < TICK_POLL_WINDOW) {
+        ++state.tick_poll_count;
+    } else {
+        state.tick_poll_count = 0;
+    }
+    state.tick_poll_return_address = return_address;
+    state.tick_poll_ticks = ticks;
+    if (state.tick_poll_count < TICK_POLL_THRESHOLD) {
+        return;
+    }
+
+    // Frequent calls alone don't make a wait, the caller could be doing work between them
+    const auto& loop = LookupTickPollLoop(return_address);
+    if (!loop || !LoadsFromMemory(core, *loop)) {
+        return;
+    }
+
+    // Nothing but the next event can end the wait early, so skip towards it in bounded steps
+    const s64 remaining = std::max<s64>(timer.GetDowncount(), 0);
+    const s64 skipped = std::min(remaining, MAX_TICK_POLL_SKIP);
+    if (skipped == remaining) {
+        timer.Idle();
+    } else {
+        timer.AddTicks(skipped);
+    }
+    Stats& title_stats = stats[title_id];
+    title_stats.skipped_cycles += skipped;
+    ++title_stats.skipped_tick_polls;
+    state.tick_poll_ticks = timer.GetTicks();
+}
+
+void IdleLoopDetector::InvalidateCode() {
+    loops.clear();
+    tick_poll_loops.clear();
+    for (CoreState& state : cores) {
+        state.last_loop.reset();
+    }
+}
+
+const std::optional<IdleLoop>& IdleLoopDetector::LookupLoop(ARM_Interface& core) {
+    static const std::optional<IdleLoop> thumb_code;
+    // Thumb code isn't analyzed
+    if (core.GetCPSR() & (1 << 5)) {
+        return thumb_code;
+    }
+    return Lookup(loops, core.GetPC(), FindIdleLoop);
+}
+
+const std::optional<IdleLoop>& IdleLoopDetector::LookupTickPollLoop(VAddr return_address) {
+    static const std::optional<IdleLoop> thumb_code;
+    // Thumb callers return to an odd address
+    if (return_address & 1) {
+        return thumb_code;
+    }
+    return Lookup(tick_poll_loops, return_address, FindTickPollLoop);
+}
+
+const std::optional<IdleLoop>& IdleLoopDetector::Lookup(LoopCache& cache, VAddr address,
+                                                        LoopFinder find) {
+    const std::pair<const void*, VAddr> key{memory.GetCurrentPageTable().get(), address};
+    const auto it = cache.find(key);
+    if (it != cache.end()) {
+        return it->second;
+    }
+
+    if (cache.size() >= MAX_CACHED_LOOPS) {
+        cache.clear();
+    }
+
+    // Code outside of plain memory isn't analyzed, 0xFFFFFFFF doesn't decode to anything allowed
+    const auto& pointers = memory.GetCurrentPageTable()->GetPointerArray();
+    const auto read_code = [&](VAddr code_address) -> u32 {
+        return pointers[code_address >> Memory::PAGE_BITS] != nullptr
+                   ? memory.Read32(code_address)
+                   : 0xFFFFFFFF;
+    };
+    return cache.emplace(key, find(address, read_code)).first->second;
+}
+
+bool IdleLoopDetector::LoadsFromMemory(ARM_Interface& core, const IdleLoop& loop) const {
+    const auto& pointers = memory.GetCurrentPageTable()->GetPointerArray();
+    return std::all_of(loop.loads.begin(), loop.loads.end(), [&](const IdleLoopLoad& load) {
+        const u32 base = load.base_reg == PC ? load.address + 8 : core.GetReg(load.base_reg);
+        const u32 offset =
+            load.offset_reg ? core.GetReg(*load.offset_reg) << load.shift : load.offset;
+        const VAddr address = load.add ? base + offset : base - offset;
+        const VAddr last = address + load.size - 1;
+        return pointers[address >> Memory::PAGE_BITS] != nullptr &&
+               pointers[last >> Memory::PAGE_BITS] != nullptr;
+    });
+}
@@ -0,0 +1,126 @@
+// Copyright 2022 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <functional>
+#include <map>
+#include <optional>
+#include <utility>
+#include <vector>
+#include "common/common_types.h"
+
+class ARM_Interface;
+
+namespace Memory {
+class MemorySystem;
+}
+
+/// A load performed by an idle loop, its address only depends on registers the loop doesn't write
+struct IdleLoopLoad {
+    /// Address of the load instruction, used when the base register is PC
+    VAddr address;
+    u32 base_reg;
+    /// Register holding the offset, or nullopt for an immediate offset
+    std::optional<u32> offset_reg;
+    u32 offset;
+    u32 shift;
+    bool add;
+    u32 size;
+};
+
+/// A loop of A32 code whose iterations only depend on memory and not on previous iterations
+struct IdleLoop {
+    /// Address of the first instruction of the loop body
+    VAddr start;
+    /// Address of the branch back to start
+    VAddr end;
+    std::vector<IdleLoopLoad> loads;
+};
+
+/**
+ * Looks for a short loop around pc that is made of loads from memory, arithmetic on registers and
+ * branches only, and in which no register or flag is carried over from one iteration to the next.
+ * Such a loop keeps spinning until memory changes. Returns nullopt for any other code.
+ * @param read_code Reads the instruction word at an address
+ */
+std::optional<IdleLoop> FindIdleLoop(VAddr pc, const std::function<u32(VAddr)>& read_code);
+
+/**
+ * Looks for a loop like FindIdleLoop, around the call returning to return_address. The call is
+ * taken to return a new value in r0 and r1 on every iteration, like svcGetSystemTick does, so the
+ * loop may only wait for that value or for memory to change.
+ */
+std::optional<IdleLoop> FindTickPollLoop(VAddr return_address,
+                                         const std::function<u32(VAddr)>& read_code);
+
+/**
+ * Detects cores that spin in an idle loop or busy-wait on svcGetSystemTick, and fast-forwards
+ * them to the next scheduled event instead of executing the loop. Only valid while the cores are
+ * time-sliced, as memory polled by one core can then only change at the end of its slice.
+ */
+class IdleLoopDetector {
+public:
+    struct Stats {
+        /// Cycles that were skipped instead of being executed
+        u64 skipped_cycles = 0;
+        /// Slices that were skipped because the core was in an idle loop
+        u64 skipped_slices = 0;
+        /// Calls to svcGetSystemTick that were followed by a skip
+        u64 skipped_tick_polls = 0;
+    };
+
+    IdleLoopDetector(Memory::MemorySystem& memory, std::size_t num_cores);
+    ~IdleLoopDetector();
+
+    /**
+     * Called before a core runs a slice. If the core keeps spinning in the same idle loop it was
+     * found in at the start of its previous slice, the rest of the slice is skipped.
+     * @returns Whether the slice was skipped
+     */
+    bool SkipIdleLoop(ARM_Interface& core, u64 title_id);
+
+    /// Called on svcGetSystemTick, skips ahead if the core is busy-waiting on the tick count
+    void OnGetSystemTick(ARM_Interface& core, u64 title_id);
+
+    /// Drops the results of previous code analysis, must be called when guest code changes
+    void InvalidateCode();
+
+    /// Returns the statistics of every title seen so far, indexed by title ID
+    const std::map<u64, Stats>& GetStats() const {
+        return stats;
+    }
+
+private:
+    struct CoreState {
+        /// Start of the idle loop the core was in at the start of its last slice
+        std::optional<VAddr> last_loop;
+        VAddr tick_poll_return_address = 0;
+        u64 tick_poll_ticks = 0;
+        u32 tick_poll_count = 0;
+    };
+
+    /// Analysis results indexed by page table and address
+    using LoopCache = std::map<std::pair<const void*, VAddr>, std::optional<IdleLoop>>;
+    using LoopFinder = std::optional<IdleLoop> (*)(VAddr, const std::function<u32(VAddr)>&);
+
+    /// Returns the idle loop around the PC of the core, using previous results when possible
+    const std::optional<IdleLoop>& LookupLoop(ARM_Interface& core);
+
+    /// Returns the tick poll loop the call returning to return_address is part of
+    const std::optional<IdleLoop>& LookupTickPollLoop(VAddr return_address);
+
+    const std::optional<IdleLoop>& Lookup(LoopCache& cache, VAddr address, LoopFinder find);
+
+    /// Returns whether all loads of the loop read from plain memory with the current registers
+    bool LoadsFromMemory(ARM_Interface& core, const IdleLoop& loop) const;
+
+    Memory::MemorySystem& memory;
+    std::vector<CoreState> cores;
+    /// Analysis results of idle loops, by PC
+    LoopCache loops;
+    /// Analysis results of tick poll loops, by return address of the call
+    LoopCache tick_poll_loops;
+    std::map<u64, Stats> stats;
+};
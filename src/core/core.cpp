@@ -2,9 +2,11 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <fstream>
 #include <memory>
 #include <stdexcept>
+#include <thread>
 #include <utility>
 #include <boost/serialization/array.hpp>
 #include "audio_core/dsp_interface.h"
@@ -12,13 +14,17 @@
 #include "audio_core/lle/lle.h"
 #include "common/logging/log.h"
 #include "common/texture.h"
+#include "common/thread_worker.h"
 #include "core/arm/arm_interface.h"
 #if defined(ARCHITECTURE_x86_64) || defined(ARCHITECTURE_ARM64)
+#include <dynarmic/exclusive_monitor.h>
 #include "core/arm/dynarmic/arm_dynarmic.h"
 #endif
 #include "core/arm/dyncom/arm_dyncom.h"
+#include "core/arm/idle_loop_detector.h"
 #include "core/cheats/cheats.h"
 #include "core/core.h"
+#include "core/core_threads.h"
 #include "core/core_timing.h"
 #include "core/dumping/backend.h"
 #ifdef ENABLE_FFMPEG_VIDEO_DUMPER
@@ -31,6 +37,7 @@
 #include "core/hle/kernel/kernel.h"
 #include "core/hle/kernel/process.h"
 #include "core/hle/kernel/thread.h"
+#include "core/hle/lock.h"
 #include "core/hle/service/apt/applet_manager.h"
 #include "core/hle/service/apt/apt.h"
 #include "core/hle/service/fs/archive.h"
@@ -43,7 +50,9 @@
 #include "core/hw/lcd.h"
 #include "core/loader/loader.h"
 #include "core/movie.h"
+#include "core/rewind.h"
 #include "core/rpc/rpc_server.h"
+#include "core/savestate.h"
 #include "core/settings.h"
 #include "network/network.h"
 #include "video_core/renderer_base.h"
@@ -121,6 +130,9 @@ System::ResultStatus System::RunLoop(bool tight_loop) {
             status_details = e.what();
             return ResultStatus::ErrorSavestate;
         }
+        if (rewind_buffer) {
+            rewind_buffer->Clear();
+        }
         frame_limiter.WaitOnce();
         return ResultStatus::Success;
     }
@@ -137,10 +149,27 @@ System::ResultStatus System::RunLoop(bool tight_loop) {
         frame_limiter.WaitOnce();
         return ResultStatus::Success;
     }
+    case Signal::Rewind: {
+        try {
+            if (!rewind_buffer || !rewind_buffer->Rewind(*this)) {
+                LOG_WARNING(Core, "No rewind snapshot available");
+            }
+        } catch (const std::exception& e) {
+            LOG_ERROR(Core, "Error rewinding: {}", e.what());
+            status_details = e.what();
+            return ResultStatus::ErrorSavestate;
+        }
+        frame_limiter.WaitOnce();
+        return ResultStatus::Success;
+    }
     default:
         break;
     }
 
+    if (rewind_buffer) {
+        rewind_buffer->Update(*this);
+    }
+
     // All cores should have executed the same amount of ticks. If this is not the case an event was
     // scheduled with a cycles_into_future smaller then the current downcount.
     // So we have to get those cores to the same global time first
@@ -180,7 +209,7 @@ System::ResultStatus System::RunLoop(bool tight_loop) {
             PrepareReschedule();
         } else {
             if (tight_loop) {
-                current_core_to_execute->Run();
+                RunCoreSlice(*current_core_to_execute);
             } else {
                 current_core_to_execute->Step();
             }
@@ -197,27 +226,31 @@ System::ResultStatus System::RunLoop(bool tight_loop) {
             kernel->GetThreadManager(cpu_core->GetID()).Reschedule();
             max_slice = std::min(max_slice, cpu_core->GetTimer().GetMaxSliceLength());
         }
-        for (auto& cpu_core : cpu_cores) {
-            cpu_core->GetTimer().SetNextSlice(max_slice);
-            auto start_ticks = cpu_core->GetTimer().GetTicks();
-            LOG_TRACE(Core_ARM11, "Core {} running for {} ticks", cpu_core->GetID(),
-                      cpu_core->GetTimer().GetDowncount());
-            running_core = cpu_core.get();
-            kernel->SetRunningCPU(running_core);
-            // If we don't have a currently active thread then don't execute instructions,
-            // instead advance to the next event and try to yield to the next thread
-            if (kernel->GetCurrentThreadManager().GetCurrentThread() == nullptr) {
-                LOG_TRACE(Core_ARM11, "Core {} idling", cpu_core->GetID());
-                cpu_core->GetTimer().Idle();
-                PrepareReschedule();
-            } else {
-                if (tight_loop) {
-                    cpu_core->Run();
+        if (core_threads && tight_loop && !GDBStub::IsServerEnabled()) {
+            RunSliceOnCoreThreads(max_slice);
+        } else {
+            for (auto& cpu_core : cpu_cores) {
+                cpu_core->GetTimer().SetNextSlice(max_slice);
+                auto start_ticks = cpu_core->GetTimer().GetTicks();
+                LOG_TRACE(Core_ARM11, "Core {} running for {} ticks", cpu_core->GetID(),
+                          cpu_core->GetTimer().GetDowncount());
+                running_core = cpu_core.get();
+                kernel->SetRunningCPU(running_core);
+                // If we don't have a currently active thread then don't execute instructions,
+                // instead advance to the next event and try to yield to the next thread
+                if (kernel->GetCurrentThreadManager().GetCurrentThread() == nullptr) {
+                    LOG_TRACE(Core_ARM11, "Core {} idling", cpu_core->GetID());
+                    cpu_core->GetTimer().Idle();
+                    PrepareReschedule();
                 } else {
-                    cpu_core->Step();
+                    if (tight_loop) {
+                        RunCoreSlice(*cpu_core);
+                    } else {
+                        cpu_core->Step();
+                    }
                 }
+                max_slice = cpu_core->GetTimer().GetTicks() - start_ticks;
             }
-            max_slice = cpu_core->GetTimer().GetTicks() - start_ticks;
         }
     }
 
@@ -309,6 +342,11 @@ System::ResultStatus System::Load(Frontend::EmuWindow& emu_window, const std::st
                   static_cast<u32>(load_result));
     }
     perf_stats = std::make_unique<PerfStats>(title_id);
+    if (Settings::values.rewind_interval > 0 && !Settings::values.enable_dsp_lle) {
+        rewind_buffer = std::make_unique<RewindBuffer>(
+            static_cast<std::size_t>(Settings::values.rewind_buffer_size) * 1024 * 1024,
+            static_cast<s64>(Settings::values.rewind_interval * GPU::frame_ticks));
+    }
     custom_tex_cache = std::make_unique<Core::CustomTexCache>();
 
     if (Settings::values.custom_textures) {
@@ -353,10 +391,79 @@ void System::Reschedule() {
     }
 }
 
+void System::RunCoreSlice(ARM_Interface& core) {
+    if (idle_loop_detector && !GDBStub::IsServerEnabled()) {
+        const auto process = kernel->GetCurrentProcess();
+        const u64 title_id = process && process->codeset ? process->codeset->program_id : 0;
+        if (idle_loop_detector->SkipIdleLoop(core, title_id)) {
+            return;
+        }
+    }
+    core.Run();
+}
+
+void System::ReportIdleLoopStats() {
+    u64 total_skipped_cycles = 0;
+    for (const auto& [title_id, stats] : idle_loop_detector->GetStats()) {
+        LOG_INFO(Core, "Title {:016X} skipped {} cycles in {} idle slices and {} tick polls",
+                 title_id, stats.skipped_cycles, stats.skipped_slices, stats.skipped_tick_polls);
+        total_skipped_cycles += stats.skipped_cycles;
+    }
+    telemetry_session->AddField(Common::Telemetry::FieldType::Performance,
+                                "Shutdown_IdleSkippedCycles", total_skipped_cycles);
+}
+
+void System::InvalidateCacheRange(u32 start_address, std::size_t length) {
+    for (const auto& cpu : cpu_cores) {
+        cpu->InvalidateCacheRange(start_address, length);
+    }
+    if (idle_loop_detector) {
+        idle_loop_detector->InvalidateCode();
+    }
+}
+
+void System::SetRunningCore(ARM_Interface& core) {
+    if (running_core != &core) {
+        running_core = &core;
+        kernel->SetRunningCPU(running_core);
+    }
+}
+
+void System::RunSliceOnCoreThreads(s64 slice_length) {
+    // Idle cores are handled here, the core threads only ever execute guest code
+    std::vector<u32> active_cores;
+    for (auto& cpu_core : cpu_cores) {
+        cpu_core->GetTimer().SetNextSlice(slice_length);
+        LOG_TRACE(Core_ARM11, "Core {} running for {} ticks", cpu_core->GetID(),
+                  cpu_core->GetTimer().GetDowncount());
+        if (kernel->GetThreadManager(cpu_core->GetID()).GetCurrentThread() == nullptr) {
+            LOG_TRACE(Core_ARM11, "Core {} idling", cpu_core->GetID());
+            cpu_core->GetTimer().Idle();
+            PrepareReschedule();
+        } else {
+            active_cores.push_back(cpu_core->GetID());
+        }
+    }
+
+    // Cores only touch the kernel and non-RAM memory with the HLE lock held, after making
+    // themselves the running core. Unlike in the time-sliced loop, a core that stops early doesn't
+    // shorten the slices of the others, it is caught up by the delayed path of the next iteration.
+    core_threads->RunCores(*timing, cpu_cores, active_cores);
+
+    // Leave the last core running, like the time-sliced loop does
+    std::lock_guard lock{HLE::g_hle_lock};
+    SetRunningCore(*cpu_cores.back());
+}
+
 System::ResultStatus System::Init(Frontend::EmuWindow& emu_window, u32 system_mode, u8 n3ds_mode,
                                   u32 num_cores) {
     LOG_DEBUG(HW_Memory, "initialized OK");
 
+    if (!save_state_workers) {
+        save_state_workers = std::make_unique<Common::ThreadWorker>(
+            std::max(2U, std::thread::hardware_concurrency()) - 1, "SaveState");
+    }
+
     memory = std::make_unique<Memory::MemorySystem>();
 
     timing = std::make_unique<Timing>(num_cores, Settings::values.cpu_clock_percentage);
@@ -366,9 +473,16 @@ System::ResultStatus System::Init(Frontend::EmuWindow& emu_window, u32 system_mo
 
     if (Settings::values.use_cpu_jit) {
 #if defined(ARCHITECTURE_x86_64) || defined(ARCHITECTURE_ARM64)
+        // Cores running in parallel need a global monitor for their exclusive accesses to work
+        // across host threads
+        std::shared_ptr<Dynarmic::ExclusiveMonitor> exclusive_monitor;
+        if (Settings::values.use_cpu_threads && num_cores > 1) {
+            exclusive_monitor = std::make_shared<Dynarmic::ExclusiveMonitor>(num_cores);
+            core_threads = std::make_unique<CoreThreads>(num_cores);
+        }
         for (u32 i = 0; i < num_cores; ++i) {
-            cpu_cores.push_back(
-                std::make_shared<ARM_Dynarmic>(this, *memory, i, timing->GetTimer(i)));
+            cpu_cores.push_back(std::make_shared<ARM_Dynarmic>(
+                this, *memory, i, timing->GetTimer(i), exclusive_monitor));
         }
 #else
         for (u32 i = 0; i < num_cores; ++i) {
@@ -385,6 +499,11 @@ System::ResultStatus System::Init(Frontend::EmuWindow& emu_window, u32 system_mo
     }
     running_core = cpu_cores[0].get();
 
+    // Memory polled by an idle core can only change between its slices while they are time-sliced
+    if (Settings::values.skip_idle_loops && !core_threads) {
+        idle_loop_detector = std::make_unique<IdleLoopDetector>(*memory, num_cores);
+    }
+
     kernel->SetCPUs(cpu_cores);
     kernel->SetRunningCPU(cpu_cores[0].get());
 
@@ -517,6 +636,9 @@ void System::RegisterImageInterface(std::shared_ptr<Frontend::ImageInterface> im
 }
 
 void System::Shutdown(bool is_deserializing) {
+    // Let save states still being written in the background finish
+    WaitForPendingSaveStates();
+
     // Log last frame performance stats
     const auto perf_results = GetAndResetPerfStats();
     constexpr auto performance = Common::Telemetry::FieldType::Performance;
@@ -526,14 +648,20 @@ void System::Shutdown(bool is_deserializing) {
     telemetry_session->AddField(performance, "Shutdown_Framerate", perf_results.game_fps);
     telemetry_session->AddField(performance, "Shutdown_Frametime", perf_results.frametime * 1000.0);
     telemetry_session->AddField(performance, "Mean_Frametime_MS", perf_stats->GetMeanFrametime());
+    if (idle_loop_detector) {
+        ReportIdleLoopStats();
+    }
 
     // Shutdown emulation session
+    // Pending work of the GPU thread may still be using the renderer
+    GPU::WaitForGPUThread();
     VideoCore::Shutdown();
     HW::Shutdown();
     if (!is_deserializing) {
         GDBStub::Shutdown();
         perf_stats.reset();
         cheat_engine.reset();
+        rewind_buffer.reset();
         app_loader.reset();
     }
     telemetry_session.reset();
@@ -542,6 +670,8 @@ void System::Shutdown(bool is_deserializing) {
     service_manager.reset();
     dsp_core.reset();
     kernel.reset();
+    idle_loop_detector.reset();
+    core_threads.reset();
     cpu_cores.clear();
     timing.reset();
 
@@ -587,6 +717,8 @@ void System::serialize(Archive& ar, const unsigned int file_version) {
     u32 num_cores;
     if (Archive::is_saving::value) {
         num_cores = this->GetNumCores();
+        // Work pending on the GPU thread has to be part of the saved state
+        GPU::SyncGPUThread();
     }
     ar& num_cores;
 
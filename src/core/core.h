@@ -19,6 +19,11 @@
 #include "core/telemetry_session.h"
 
 class ARM_Interface;
+class IdleLoopDetector;
+
+namespace Common {
+class ThreadWorker;
+}
 
 namespace Frontend {
 class EmuWindow;
@@ -61,6 +66,8 @@ class RendererBase;
 
 namespace Core {
 
+class CoreThreads;
+class RewindBuffer;
 class Timing;
 
 class System {
@@ -120,7 +127,7 @@ public:
     /// Shutdown and then load again
     void Reset();
 
-    enum class Signal : u32 { None, Shutdown, Reset, Save, Load };
+    enum class Signal : u32 { None, Shutdown, Reset, Save, Load, Rewind };
 
     bool SendSignal(Signal signal, u32 param = 0);
 
@@ -177,6 +184,17 @@ public:
         return *running_core;
     };
 
+    /**
+     * Makes core the running core of the kernel. Used by code that enters the kernel from the host
+     * thread of a core, which must hold the HLE lock.
+     */
+    void SetRunningCore(ARM_Interface& core);
+
+    /// Returns whether the cores are executed in parallel on their own host threads
+    [[nodiscard]] bool UsesCoreThreads() const {
+        return core_threads != nullptr;
+    }
+
     /**
      * Gets a reference to the emulated CPU.
      * @param core_id The id of the core requested.
@@ -191,10 +209,11 @@ public:
         return static_cast<u32>(cpu_cores.size());
     }
 
-    void InvalidateCacheRange(u32 start_address, std::size_t length) {
-        for (const auto& cpu : cpu_cores) {
-            cpu->InvalidateCacheRange(start_address, length);
-        }
+    void InvalidateCacheRange(u32 start_address, std::size_t length);
+
+    /// Returns the idle loop detector, or nullptr if idle loops aren't skipped
+    [[nodiscard]] IdleLoopDetector* GetIdleLoopDetector() const {
+        return idle_loop_detector.get();
     }
 
     /**
@@ -305,6 +324,9 @@ public:
 
     void LoadState(u32 slot);
 
+    /// Blocks until all save states which are still being compressed have been written to disk
+    void WaitForPendingSaveStates() const;
+
 private:
     /**
      * Initialize the emulated system.
@@ -319,6 +341,15 @@ private:
     /// Reschedule the core emulation
     void Reschedule();
 
+    /// Runs a slice of the given length on every core in parallel, on the core threads
+    void RunSliceOnCoreThreads(s64 slice_length);
+
+    /// Runs the running core until the end of its slice, unless it is found spinning idle
+    void RunCoreSlice(ARM_Interface& core);
+
+    /// Logs and reports how many cycles were skipped in idle loops
+    void ReportIdleLoopStats();
+
     /// AppLoader used to load the current executing application
     std::unique_ptr<Loader::AppLoader> app_loader;
 
@@ -326,6 +357,11 @@ private:
     std::vector<std::shared_ptr<ARM_Interface>> cpu_cores;
     ARM_Interface* running_core = nullptr;
 
+    /// Host threads executing the cores in parallel, null when the cores are time-sliced
+    std::unique_ptr<CoreThreads> core_threads;
+
+    std::unique_ptr<IdleLoopDetector> idle_loop_detector;
+
     /// DSP core
     std::unique_ptr<AudioCore::DspInterface> dsp_core;
 
@@ -345,6 +381,12 @@ private:
     /// Cheats manager
     std::unique_ptr<Cheats::CheatEngine> cheat_engine;
 
+    /// In-memory snapshots emulation can be rewound to
+    std::unique_ptr<RewindBuffer> rewind_buffer;
+
+    /// Compresses and writes save states in the background, created on first initialization
+    std::unique_ptr<Common::ThreadWorker> save_state_workers;
+
     /// Video dumper backend
     std::unique_ptr<VideoDumper::Backend> video_dumper;
 
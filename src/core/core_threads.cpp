@@ -0,0 +1,85 @@
+// Copyright 2022 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <string>
+#include "common/assert.h"
+#include "common/microprofile.h"
+#include "common/thread.h"
+#include "core/arm/arm_interface.h"
+#include "core/core_threads.h"
+#include "core/core_timing.h"
+
+namespace Core {
+
+CoreThreads::CoreThreads(std::size_t num_cores) : has_work(num_cores, false) {
+    threads.reserve(num_cores);
+    for (u32 core_id = 0; core_id < num_cores; ++core_id) {
+        threads.emplace_back(&CoreThreads::ThreadLoop, this, core_id);
+    }
+}
+
+CoreThreads::~CoreThreads() {
+    {
+        std::lock_guard lock{mutex};
+        stop = true;
+    }
+    work_condition.notify_all();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+void CoreThreads::RunSlice(const std::vector<u32>& core_ids,
+                           const std::function<void(u32)>& func) {
+    if (core_ids.empty()) {
+        return;
+    }
+
+    std::unique_lock lock{mutex};
+    ASSERT(pending == 0);
+    slice_func = &func;
+    for (const u32 core_id : core_ids) {
+        ASSERT(core_id < has_work.size() && !has_work[core_id]);
+        has_work[core_id] = true;
+    }
+    pending = core_ids.size();
+    work_condition.notify_all();
+
+    done_condition.wait(lock, [this] { return pending == 0; });
+    slice_func = nullptr;
+}
+
+void CoreThreads::RunCores(Timing& timing, const std::vector<std::shared_ptr<ARM_Interface>>& cores,
+                           const std::vector<u32>& core_ids) {
+    timing.SetCoresRunInParallel(true);
+    RunSlice(core_ids, [&cores](u32 core_id) { cores[core_id]->Run(); });
+    timing.SetCoresRunInParallel(false);
+}
+
+void CoreThreads::ThreadLoop(u32 core_id) {
+    const std::string name = "CoreThread:" + std::to_string(core_id);
+    Common::SetCurrentThreadName(name.c_str());
+    MicroProfileOnThreadCreate(name.c_str());
+
+    std::unique_lock lock{mutex};
+    while (true) {
+        work_condition.wait(lock, [this, core_id] { return stop || has_work[core_id]; });
+        if (stop) {
+            break;
+        }
+
+        const auto& func = *slice_func;
+        lock.unlock();
+        func(core_id);
+        lock.lock();
+
+        has_work[core_id] = false;
+        if (--pending == 0) {
+            done_condition.notify_one();
+        }
+    }
+    MicroProfileOnThreadExit();
+}
+
+} // namespace Core
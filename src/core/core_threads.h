@@ -0,0 +1,63 @@
+// Copyright 2022 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "common/common_types.h"
+
+class ARM_Interface;
+
+namespace Core {
+
+class Timing;
+
+/**
+ * One host thread per emulated CPU core, used to execute the slices of the cores in parallel.
+ * The caller prepares a slice for every core, hands it to RunSlice and gets control back once all
+ * of them are done, so the cores can drift apart by at most one slice before they are resynced.
+ */
+class CoreThreads {
+public:
+    explicit CoreThreads(std::size_t num_cores);
+    ~CoreThreads();
+
+    CoreThreads(const CoreThreads&) = delete;
+    CoreThreads& operator=(const CoreThreads&) = delete;
+
+    /**
+     * Calls func(core_id) for every core in core_ids on the host thread of that core, and blocks
+     * until all of the calls returned.
+     */
+    void RunSlice(const std::vector<u32>& core_ids, const std::function<void(u32)>& func);
+
+    /**
+     * Runs the cores in core_ids until the end of their slices, each on its own host thread.
+     * The timing is told that the cores run in parallel until all of them are done.
+     */
+    void RunCores(Timing& timing, const std::vector<std::shared_ptr<ARM_Interface>>& cores,
+                  const std::vector<u32>& core_ids);
+
+private:
+    void ThreadLoop(u32 core_id);
+
+    std::vector<std::thread> threads;
+    /// Whether the thread of each core has work in the current slice
+    std::vector<bool> has_work;
+    const std::function<void(u32)>* slice_func = nullptr;
+    std::size_t pending = 0;
+    bool stop = false;
+
+    std::mutex mutex;
+    std::condition_variable work_condition;
+    std::condition_variable done_condition;
+};
+
+} // namespace Core
@@ -20,6 +20,206 @@ bool Timing::Event::operator<(const Timing::Event& right) const {
     return std::tie(time, fifo_order) < std::tie(right.time, right.fifo_order);
 }
 
+std::size_t Timing::EventQueue::KeyHash::operator()(const Key& key) const {
+    const std::size_t type_hash = std::hash<const TimingEventType*>{}(key.type);
+    return type_hash ^ (std::hash<u64>{}(key.userdata) + 0x9E3779B9 + (type_hash << 6));
+}
+
+void Timing::EventQueue::Push(const Event& event) {
+    u32 slot;
+    if (free_slots.empty()) {
+        slot = static_cast<u32>(slots.size());
+        slots.emplace_back();
+    } else {
+        slot = free_slots.back();
+        free_slots.pop_back();
+    }
+    slots[slot] = Slot{event, static_cast<u32>(heap.size()), INVALID_SLOT, INVALID_SLOT};
+
+    // Keep the load factor at most 1/2, so that probe sequences stay short
+    if ((num_keys + 1) * 2 > key_table.size()) {
+        GrowKeyTable();
+    }
+    const Key key{event.type, event.userdata};
+    KeyEntry& entry = key_table[FindKey(key)];
+    if (entry.first_slot == INVALID_SLOT) {
+        entry = KeyEntry{key, slot};
+        ++num_keys;
+    } else {
+        slots[slot].next_same_key = entry.first_slot;
+        slots[entry.first_slot].prev_same_key = slot;
+        entry.first_slot = slot;
+    }
+
+    heap.push_back(slot);
+    SiftUp(static_cast<u32>(heap.size() - 1));
+}
+
+Timing::Event Timing::EventQueue::Pop() {
+    const u32 slot = heap.front();
+    Event event = slots[slot].event;
+    Erase(slot);
+    return event;
+}
+
+void Timing::EventQueue::Remove(const TimingEventType* event_type, u64 userdata) {
+    if (key_table.empty()) {
+        return;
+    }
+    u32 slot = key_table[FindKey(Key{event_type, userdata})].first_slot;
+    while (slot != INVALID_SLOT) {
+        // Erasing an event leaves the links of the others intact
+        const u32 next = slots[slot].next_same_key;
+        Erase(slot);
+        slot = next;
+    }
+}
+
+void Timing::EventQueue::RemoveAll(const TimingEventType* event_type) {
+    std::vector<u32> matching;
+    for (const u32 slot : heap) {
+        if (slots[slot].event.type == event_type) {
+            matching.push_back(slot);
+        }
+    }
+    for (const u32 slot : matching) {
+        Erase(slot);
+    }
+}
+
+std::vector<Timing::Event> Timing::EventQueue::GetEvents() const {
+    std::vector<Event> events;
+    events.reserve(heap.size());
+    for (const u32 slot : heap) {
+        events.push_back(slots[slot].event);
+    }
+    return events;
+}
+
+void Timing::EventQueue::Clear() {
+    slots.clear();
+    free_slots.clear();
+    heap.clear();
+    std::fill(key_table.begin(), key_table.end(), KeyEntry{});
+    num_keys = 0;
+}
+
+bool Timing::EventQueue::IsBefore(u32 slot_a, u32 slot_b) const {
+    return slots[slot_a].event < slots[slot_b].event;
+}
+
+void Timing::EventQueue::Place(u32 heap_index, u32 slot) {
+    heap[heap_index] = slot;
+    slots[slot].heap_index = heap_index;
+}
+
+void Timing::EventQueue::SiftUp(u32 heap_index) {
+    const u32 slot = heap[heap_index];
+    while (heap_index > 0) {
+        const u32 parent = (heap_index - 1) / 2;
+        if (!IsBefore(slot, heap[parent])) {
+            break;
+        }
+        Place(heap_index, heap[parent]);
+        heap_index = parent;
+    }
+    Place(heap_index, slot);
+}
+
+void Timing::EventQueue::SiftDown(u32 heap_index) {
+    const u32 slot = heap[heap_index];
+    const u32 size = static_cast<u32>(heap.size());
+    while (true) {
+        u32 child = heap_index * 2 + 1;
+        if (child >= size) {
+            break;
+        }
+        if (child + 1 < size && IsBefore(heap[child + 1], heap[child])) {
+            ++child;
+        }
+        if (!IsBefore(heap[child], slot)) {
+            break;
+        }
+        Place(heap_index, heap[child]);
+        heap_index = child;
+    }
+    Place(heap_index, slot);
+}
+
+void Timing::EventQueue::Erase(u32 slot) {
+    Slot& erased = slots[slot];
+    if (erased.prev_same_key != INVALID_SLOT) {
+        slots[erased.prev_same_key].next_same_key = erased.next_same_key;
+    } else {
+        const std::size_t index = FindKey(Key{erased.event.type, erased.event.userdata});
+        ASSERT(key_table[index].first_slot == slot);
+        if (erased.next_same_key != INVALID_SLOT) {
+            key_table[index].first_slot = erased.next_same_key;
+        } else {
+            EraseKey(index);
+        }
+    }
+    if (erased.next_same_key != INVALID_SLOT) {
+        slots[erased.next_same_key].prev_same_key = erased.prev_same_key;
+    }
+
+    // Move the last event of the heap into the hole and restore the heap order from there
+    const u32 heap_index = erased.heap_index;
+    const u32 last = heap.back();
+    heap.pop_back();
+    if (heap_index < heap.size()) {
+        Place(heap_index, last);
+        if (heap_index > 0 && IsBefore(last, heap[(heap_index - 1) / 2])) {
+            SiftUp(heap_index);
+        } else {
+            SiftDown(heap_index);
+        }
+    }
+    free_slots.push_back(slot);
+}
+
+std::size_t Timing::EventQueue::FindKey(const Key& key) const {
+    const std::size_t mask = key_table.size() - 1;
+    std::size_t index = HomeIndex(key);
+    while (key_table[index].first_slot != INVALID_SLOT && !(key_table[index].key == key)) {
+        index = (index + 1) & mask;
+    }
+    return index;
+}
+
+std::size_t Timing::EventQueue::HomeIndex(const Key& key) const {
+    // Event types are aligned pointers and userdata are often small, mix the bits before masking
+    const u64 hash = static_cast<u64>(KeyHash{}(key)) * 0x9E3779B97F4A7C15;
+    return static_cast<std::size_t>(hash >> 32) & (key_table.size() - 1);
+}
+
+void Timing::EventQueue::EraseKey(std::size_t index) {
+    // Shift later entries of the probe sequence back, so that no tombstones are needed
+    const std::size_t mask = key_table.size() - 1;
+    std::size_t hole = index;
+    for (std::size_t next = (hole + 1) & mask; key_table[next].first_slot != INVALID_SLOT;
+         next = (next + 1) & mask) {
+        // The entry can fill the hole if the hole is between its home and its current index
+        const std::size_t home = HomeIndex(key_table[next].key);
+        if (((next - home) & mask) >= ((next - hole) & mask)) {
+            key_table[hole] = key_table[next];
+            hole = next;
+        }
+    }
+    key_table[hole] = KeyEntry{};
+    --num_keys;
+}
+
+void Timing::EventQueue::GrowKeyTable() {
+    std::vector<KeyEntry> old_table = std::move(key_table);
+    key_table.assign(std::max<std::size_t>(old_table.size() * 2, 16), KeyEntry{});
+    for (const KeyEntry& entry : old_table) {
+        if (entry.first_slot != INVALID_SLOT) {
+            key_table[FindKey(entry.key)] = entry;
+        }
+    }
+}
+
 Timing::Timing(std::size_t num_cores, u32 cpu_clock_percentage) {
     timers.resize(num_cores);
     for (std::size_t i = 0; i < num_cores; ++i) {
@@ -62,18 +262,15 @@ void Timing::ScheduleEvent(s64 cycles_into_future, const TimingEventType* event_
         timer = timers.at(core_id).get();
     }
 
-    s64 timeout = timer->GetTicks() + cycles_into_future;
+    s64 timeout = GetTicksSeenByCurrentCore(*timer) + cycles_into_future;
     if (current_timer == timer) {
         // If this event needs to be scheduled before the next advance(), force one early
         if (!timer->is_timer_sane)
             timer->ForceExceptionCheck(cycles_into_future);
 
-        timer->event_queue.emplace_back(
-            Event{timeout, timer->event_fifo_id++, userdata, event_type});
-        std::push_heap(timer->event_queue.begin(), timer->event_queue.end(), std::greater<>());
+        timer->event_queue.Push(Event{timeout, timer->event_fifo_id++, userdata, event_type});
     } else {
-        timer->ts_queue.Push(Event{static_cast<s64>(timer->GetTicks() + cycles_into_future), 0,
-                                   userdata, event_type});
+        timer->ts_queue.Push(Event{timeout, 0, userdata, event_type});
     }
 }
 
@@ -81,16 +278,8 @@ void Timing::UnscheduleEvent(const TimingEventType* event_type, u64 userdata) {
     if (event_queue_locked) {
         return;
     }
-    for (auto timer : timers) {
-        auto itr = std::remove_if(
-            timer->event_queue.begin(), timer->event_queue.end(),
-            [&](const Event& e) { return e.type == event_type && e.userdata == userdata; });
-
-        // Removing random items breaks the invariant so we have to re-establish it.
-        if (itr != timer->event_queue.end()) {
-            timer->event_queue.erase(itr, timer->event_queue.end());
-            std::make_heap(timer->event_queue.begin(), timer->event_queue.end(), std::greater<>());
-        }
+    for (const auto& timer : timers) {
+        timer->event_queue.Remove(event_type, userdata);
     }
     // TODO:remove events from ts_queue
 }
@@ -99,15 +288,8 @@ void Timing::RemoveEvent(const TimingEventType* event_type) {
     if (event_queue_locked) {
         return;
     }
-    for (auto timer : timers) {
-        auto itr = std::remove_if(timer->event_queue.begin(), timer->event_queue.end(),
-                                  [&](const Event& e) { return e.type == event_type; });
-
-        // Removing random items breaks the invariant so we have to re-establish it.
-        if (itr != timer->event_queue.end()) {
-            timer->event_queue.erase(itr, timer->event_queue.end());
-            std::make_heap(timer->event_queue.begin(), timer->event_queue.end(), std::greater<>());
-        }
+    for (const auto& timer : timers) {
+        timer->event_queue.RemoveAll(event_type);
     }
     // TODO:remove events from ts_queue
 }
@@ -121,11 +303,18 @@ s64 Timing::GetTicks() const {
 }
 
 s64 Timing::GetGlobalTicks() const {
-    const auto& timer =
-        std::max_element(timers.cbegin(), timers.cend(), [](const auto& a, const auto& b) {
-            return a->GetTicks() < b->GetTicks();
-        });
-    return (*timer)->GetTicks();
+    u64 ticks = 0;
+    for (const auto& timer : timers) {
+        ticks = std::max(ticks, GetTicksSeenByCurrentCore(*timer));
+    }
+    return static_cast<s64>(ticks);
+}
+
+u64 Timing::GetTicksSeenByCurrentCore(const Timer& timer) const {
+    if (cores_run_in_parallel && &timer != current_timer) {
+        return timer.slice_start_ticks;
+    }
+    return timer.GetTicks();
 }
 
 std::chrono::microseconds Timing::GetGlobalTimeUs() const {
@@ -169,16 +358,15 @@ void Timing::Timer::ForceExceptionCheck(s64 cycles) {
 void Timing::Timer::MoveEvents() {
     for (Event ev; ts_queue.Pop(ev);) {
         ev.fifo_order = event_fifo_id++;
-        event_queue.emplace_back(std::move(ev));
-        std::push_heap(event_queue.begin(), event_queue.end(), std::greater<>());
+        event_queue.Push(ev);
     }
 }
 
 s64 Timing::Timer::GetMaxSliceLength() const {
-    const auto& next_event = event_queue.begin();
-    if (next_event != event_queue.end()) {
-        ASSERT(next_event->time - executed_ticks > 0);
-        return next_event->time - executed_ticks;
+    if (!event_queue.Empty()) {
+        const Event& next_event = event_queue.Top();
+        ASSERT(next_event.time - executed_ticks > 0);
+        return next_event.time - executed_ticks;
     }
     return MAX_SLICE_LENGTH;
 }
@@ -194,10 +382,8 @@ void Timing::Timer::Advance() {
 
     is_timer_sane = true;
 
-    while (!event_queue.empty() && event_queue.front().time <= executed_ticks) {
-        Event evt = std::move(event_queue.front());
-        std::pop_heap(event_queue.begin(), event_queue.end(), std::greater<>());
-        event_queue.pop_back();
+    while (!event_queue.Empty() && event_queue.Top().time <= executed_ticks) {
+        const Event evt = event_queue.Pop();
         if (evt.type->callback != nullptr) {
             evt.type->callback(evt.userdata, static_cast<int>(executed_ticks - evt.time));
         } else {
@@ -209,12 +395,13 @@ void Timing::Timer::Advance() {
 }
 
 void Timing::Timer::SetNextSlice(s64 max_slice_length) {
+    slice_start_ticks = GetTicks();
     slice_length = max_slice_length;
 
     // Still events left (scheduled in the future)
-    if (!event_queue.empty()) {
+    if (!event_queue.Empty()) {
         slice_length = static_cast<int>(
-            std::min<s64>(event_queue.front().time - executed_ticks, max_slice_length));
+            std::min<s64>(event_queue.Top().time - executed_ticks, max_slice_length));
     }
 
     downcount = slice_length;
@@ -171,6 +171,90 @@ public:
         BOOST_SERIALIZATION_SPLIT_MEMBER()
     };
 
+    /**
+     * Min-heap of events that is also indexed by event type and userdata, so that unscheduling an
+     * event finds it with a hash lookup instead of scanning and rebuilding the whole heap.
+     * Events are kept in a pool of slots, and each slot remembers its position in the heap.
+     */
+    class EventQueue {
+    public:
+        bool Empty() const {
+            return heap.empty();
+        }
+
+        std::size_t Size() const {
+            return heap.size();
+        }
+
+        /// Returns the earliest event, events at the same time are ordered by fifo_order
+        const Event& Top() const {
+            return slots[heap.front()].event;
+        }
+
+        void Push(const Event& event);
+
+        Event Pop();
+
+        /// Removes every event with the given type and userdata
+        void Remove(const TimingEventType* event_type, u64 userdata);
+
+        /// Removes every event with the given type
+        void RemoveAll(const TimingEventType* event_type);
+
+        /// Returns a copy of all events in an unspecified order
+        std::vector<Event> GetEvents() const;
+
+        void Clear();
+
+    private:
+        static constexpr u32 INVALID_SLOT = std::numeric_limits<u32>::max();
+
+        struct Key {
+            const TimingEventType* type;
+            u64 userdata;
+
+            bool operator==(const Key&) const = default;
+        };
+
+        struct KeyHash {
+            std::size_t operator()(const Key& key) const;
+        };
+
+        struct Slot {
+            Event event;
+            u32 heap_index;
+            // Events sharing a key form a doubly linked list starting at the key's entry
+            u32 prev_same_key;
+            u32 next_same_key;
+        };
+
+        struct KeyEntry {
+            Key key;
+            // INVALID_SLOT marks an unused entry
+            u32 first_slot = INVALID_SLOT;
+        };
+
+        bool IsBefore(u32 slot_a, u32 slot_b) const;
+        void Place(u32 heap_index, u32 slot);
+        void SiftUp(u32 heap_index);
+        void SiftDown(u32 heap_index);
+        void Erase(u32 slot);
+
+        /// Returns the index of the entry of key, or of the unused entry where it would go
+        std::size_t FindKey(const Key& key) const;
+        std::size_t HomeIndex(const Key& key) const;
+        void EraseKey(std::size_t index);
+        void GrowKeyTable();
+
+        std::vector<Slot> slots;
+        std::vector<u32> free_slots;
+        std::vector<u32> heap;
+        // Linear probing hash table from each key to its first event. Unlike a node based map it
+        // only allocates when it grows, so scheduling an event never allocates in the steady state
+        std::vector<KeyEntry> key_table;
+        std::size_t num_keys = 0;
+    };
+
     // currently Service::HID::pad_update_ticks is the smallest interval for an event that gets
     // always scheduled. Therfore we use this as orientation for the MAX_SLICE_LENGTH
     // For performance bigger slice length are desired, though this will lead to cores desync
@@ -205,11 +289,7 @@ public:
 
     private:
         friend class Timing;
-        // The queue is a min-heap using std::make_heap/push_heap/pop_heap.
-        // We don't use std::priority_queue because we need to be able to serialize, unserialize and
-        // erase arbitrary events (RemoveEvent()) regardless of the queue order. These aren't
-        // accommodated by the standard adaptor class.
-        std::vector<Event> event_queue;
+        EventQueue event_queue;
         u64 event_fifo_id = 0;
         // the queue for storing the events from other threads threadsafe until they will be added
         // to the event_queue by the emu thread
@@ -226,6 +306,9 @@ public:
         s64 slice_length = MAX_SLICE_LENGTH;
         s64 downcount = MAX_SLICE_LENGTH;
         s64 executed_ticks = 0;
+        // Tick count when the current slice started, which other cores can read while this
+        // core's slice runs in parallel to theirs
+        u64 slice_start_ticks = 0;
         u64 idled_cycles = 0;
         // Stores a scaling for the internal clockspeed. Changing this number results in
         // under/overclocking the guest cpu
@@ -238,7 +321,18 @@ public:
             // TODO(SaveState): Remove the next two lines when we break compatibility
             s64 x;
             ar& x; // to keep compatibility with old save states that stored global_timer
-            ar& event_queue;
+            // The queue is stored as a plain vector of events, as it was when it was a binary heap
+            std::vector<Event> events;
+            if (!Archive::is_loading::value) {
+                events = event_queue.GetEvents();
+            }
+            ar& events;
+            if (Archive::is_loading::value) {
+                event_queue.Clear();
+                for (const Event& event : events) {
+                    event_queue.Push(event);
+                }
+            }
             ar& event_fifo_id;
             ar& slice_length;
             ar& downcount;
@@ -267,6 +361,15 @@ public:
 
     void SetCurrentTimer(std::size_t core_id);
 
+    /**
+     * Tells whether the cores currently run their slices in parallel on their own host threads.
+     * The tick counts of the other cores then keep changing, so while this is set their counts
+     * are only read as of the start of the slice.
+     */
+    void SetCoresRunInParallel(bool in_parallel) {
+        cores_run_in_parallel = in_parallel;
+    }
+
     s64 GetTicks() const;
 
     s64 GetGlobalTicks() const;
@@ -301,6 +404,11 @@ private:
     // destructor side effects.
     bool event_queue_locked = false;
 
+    bool cores_run_in_parallel = false;
+
+    /// Returns the ticks of the given timer as they can be read by the current core
+    u64 GetTicksSeenByCurrentCore(const Timer& timer) const;
+
     template <class Archive>
     void serialize(Archive& ar, const unsigned int file_version) {
         // event_types set during initialization of other things
@@ -12,6 +12,7 @@
 #include "common/scm_rev.h"
 #include "common/scope_exit.h"
 #include "core/arm/arm_interface.h"
+#include "core/arm/idle_loop_detector.h"
 #include "core/core.h"
 #include "core/core_timing.h"
 #include "core/hle/kernel/address_arbiter.h"
@@ -1282,6 +1283,10 @@ s64 SVC::GetSystemTick() {
     // Advance time to defeat dumb games (like Cubic Ninja) that busy-wait for the frame to end.
     // Measured time between two calls on a 9.2 o3DS with Ninjhax 1.1b
     system.GetRunningCore().GetTimer().AddTicks(150);
+    if (IdleLoopDetector* detector = system.GetIdleLoopDetector()) {
+        detector->OnGetSystemTick(system.GetRunningCore(),
+                                  kernel.GetCurrentProcess()->codeset->program_id);
+    }
     return result;
 }
 
@@ -3,26 +3,28 @@
 // Refer to the license.txt file included.
 
 #include <cstring>
+#include <memory>
 #include <numeric>
 #include <type_traits>
+#include <variant>
 #include "common/alignment.h"
-#include "common/color.h"
 #include "common/common_types.h"
 #include "common/logging/log.h"
 #include "common/microprofile.h"
-#include "common/vector_math.h"
 #include "core/core.h"
 #include "core/core_timing.h"
 #include "core/hle/service/gsp/gsp.h"
 #include "core/hw/gpu.h"
+#include "core/hw/gpu_transfer.h"
 #include "core/hw/hw.h"
 #include "core/memory.h"
+#include "core/settings.h"
 #include "core/tracer/recorder.h"
 #include "video_core/command_processor.h"
 #include "video_core/debug_utils/debug_utils.h"
+#include "video_core/gpu_thread.h"
 #include "video_core/rasterizer_interface.h"
 #include "video_core/renderer_base.h"
-#include "video_core/utils.h"
 #include "video_core/video_core.h"
 
 namespace GPU {
@@ -33,8 +35,20 @@ Memory::MemorySystem* g_memory;
 /// Event id for CoreTiming
 static Core::TimingEventType* vblank_event;
 
+/// The CPU runs ahead of the GPU thread for at most this many ticks after submitting work
+constexpr s64 fence_ticks = frame_ticks / 8;
+
+/// Event id for CoreTiming, synchronizing with the GPU thread
+static Core::TimingEventType* fence_event;
+static bool fence_scheduled;
+
+static std::unique_ptr<VideoCore::GPUThread> gpu_thread;
+
 template <typename T>
 inline void Read(T& var, const u32 raw_addr) {
+    // The registers of pending work are only updated once the CPU has synchronized with it
+    SyncGPUThread();
+
     u32 addr = raw_addr - HW::VADDR_GPU;
     u32 index = addr / 4;
 
@@ -47,29 +61,6 @@ inline void Read(T& var, const u32 raw_addr) {
     var = g_regs[addr / 4];
 }
 
-static Common::Vec4<u8> DecodePixel(Regs::PixelFormat input_format, const u8* src_pixel) {
-    switch (input_format) {
-    case Regs::PixelFormat::RGBA8:
-        return Color::DecodeRGBA8(src_pixel);
-
-    case Regs::PixelFormat::RGB8:
-        return Color::DecodeRGB8(src_pixel);
-
-    case Regs::PixelFormat::RGB565:
-        return Color::DecodeRGB565(src_pixel);
-
-    case Regs::PixelFormat::RGB5A1:
-        return Color::DecodeRGB5A1(src_pixel);
-
-    case Regs::PixelFormat::RGBA4:
-        return Color::DecodeRGBA4(src_pixel);
-
-    default:
-        LOG_ERROR(HW_GPU, "Unknown source framebuffer format {:x}", input_format);
-        return {0, 0, 0, 0};
-    }
-}
-
 MICROPROFILE_DEFINE(GPU_DisplayTransfer, "GPU", "DisplayTransfer", MP_RGB(100, 100, 255));
 MICROPROFILE_DEFINE(GPU_CmdlistProcessing, "GPU", "Cmdlist Processing", MP_RGB(100, 255, 100));
 
@@ -103,27 +94,7 @@ static void MemoryFill(const Regs::MemoryFillConfig& config) {
     Memory::RasterizerInvalidateRegion(config.GetStartAddress(),
                                        config.GetEndAddress() - config.GetStartAddress());
 
-    if (config.fill_24bit) {
-        // fill with 24-bit values
-        for (u8* ptr = start; ptr < end; ptr += 3) {
-            ptr[0] = config.value_24bit_r;
-            ptr[1] = config.value_24bit_g;
-            ptr[2] = config.value_24bit_b;
-        }
-    } else if (config.fill_32bit) {
-        // fill with 32-bit values
-        if (end > start) {
-            u32 value = config.value_32bit;
-            std::size_t len = (end - start) / sizeof(u32);
-            for (std::size_t i = 0; i < len; ++i)
-                memcpy(&start[i * sizeof(u32)], &value, sizeof(u32));
-        }
-    } else {
-        // fill with 16-bit values
-        u16 value_16bit = config.value_16bit.Value();
-        for (u8* ptr = start; ptr < end; ptr += sizeof(u16))
-            memcpy(ptr, &value_16bit, sizeof(u16));
-    }
+    PerformMemoryFill(config, start, end);
 }
 
 static void DisplayTransfer(const Regs::DisplayTransferConfig& config) {
@@ -193,113 +164,7 @@ static void DisplayTransfer(const Regs::DisplayTransferConfig& config) {
     Memory::RasterizerFlushRegion(config.GetPhysicalInputAddress(), input_size);
     Memory::RasterizerInvalidateRegion(config.GetPhysicalOutputAddress(), output_size);
 
-    for (u32 y = 0; y < output_height; ++y) {
-        for (u32 x = 0; x < output_width; ++x) {
-            Common::Vec4<u8> src_color;
-
-            // Calculate the [x,y] position of the input image
-            // based on the current output position and the scale
-            u32 input_x = x << horizontal_scale;
-            u32 input_y = y << vertical_scale;
-
-            u32 output_y;
-            if (config.flip_vertically) {
-                // Flip the y value of the output data,
-                // we do this after calculating the [x,y] position of the input image
-                // to account for the scaling options.
-                output_y = output_height - y - 1;
-            } else {
-                output_y = y;
-            }
-
-            u32 dst_bytes_per_pixel = GPU::Regs::BytesPerPixel(config.output_format);
-            u32 src_bytes_per_pixel = GPU::Regs::BytesPerPixel(config.input_format);
-            u32 src_offset;
-            u32 dst_offset;
-
-            if (config.input_linear) {
-                if (!config.dont_swizzle) {
-                    // Interpret the input as linear and the output as tiled
-                    u32 coarse_y = output_y & ~7;
-                    u32 stride = output_width * dst_bytes_per_pixel;
-
-                    src_offset = (input_x + input_y * config.input_width) * src_bytes_per_pixel;
-                    dst_offset = VideoCore::GetMortonOffset(x, output_y, dst_bytes_per_pixel) +
-                                 coarse_y * stride;
-                } else {
-                    // Both input and output are linear
-                    src_offset = (input_x + input_y * config.input_width) * src_bytes_per_pixel;
-                    dst_offset = (x + output_y * output_width) * dst_bytes_per_pixel;
-                }
-            } else {
-                if (!config.dont_swizzle) {
-                    // Interpret the input as tiled and the output as linear
-                    u32 coarse_y = input_y & ~7;
-                    u32 stride = config.input_width * src_bytes_per_pixel;
-
-                    src_offset = VideoCore::GetMortonOffset(input_x, input_y, src_bytes_per_pixel) +
-                                 coarse_y * stride;
-                    dst_offset = (x + output_y * output_width) * dst_bytes_per_pixel;
-                } else {
-                    // Both input and output are tiled
-                    u32 out_coarse_y = output_y & ~7;
-                    u32 out_stride = output_width * dst_bytes_per_pixel;
-
-                    u32 in_coarse_y = input_y & ~7;
-                    u32 in_stride = config.input_width * src_bytes_per_pixel;
-
-                    src_offset = VideoCore::GetMortonOffset(input_x, input_y, src_bytes_per_pixel) +
-                                 in_coarse_y * in_stride;
-                    dst_offset = VideoCore::GetMortonOffset(x, output_y, dst_bytes_per_pixel) +
-                                 out_coarse_y * out_stride;
-                }
-            }
-
-            const u8* src_pixel = src_pointer + src_offset;
-            src_color = DecodePixel(config.input_format, src_pixel);
-            if (config.scaling == config.ScaleX) {
-                Common::Vec4<u8> pixel =
-                    DecodePixel(config.input_format, src_pixel + src_bytes_per_pixel);
-                src_color = ((src_color + pixel) / 2).Cast<u8>();
-            } else if (config.scaling == config.ScaleXY) {
-                Common::Vec4<u8> pixel1 =
-                    DecodePixel(config.input_format, src_pixel + 1 * src_bytes_per_pixel);
-                Common::Vec4<u8> pixel2 =
-                    DecodePixel(config.input_format, src_pixel + 2 * src_bytes_per_pixel);
-                Common::Vec4<u8> pixel3 =
-                    DecodePixel(config.input_format, src_pixel + 3 * src_bytes_per_pixel);
-                src_color = (((src_color + pixel1) + (pixel2 + pixel3)) / 4).Cast<u8>();
-            }
-
-            u8* dst_pixel = dst_pointer + dst_offset;
-            switch (config.output_format) {
-            case Regs::PixelFormat::RGBA8:
-                Color::EncodeRGBA8(src_color, dst_pixel);
-                break;
-
-            case Regs::PixelFormat::RGB8:
-                Color::EncodeRGB8(src_color, dst_pixel);
-                break;
-
-            case Regs::PixelFormat::RGB565:
-                Color::EncodeRGB565(src_color, dst_pixel);
-                break;
-
-            case Regs::PixelFormat::RGB5A1:
-                Color::EncodeRGB5A1(src_color, dst_pixel);
-                break;
-
-            case Regs::PixelFormat::RGBA4:
-                Color::EncodeRGBA4(src_color, dst_pixel);
-                break;
-
-            default:
-                LOG_ERROR(HW_GPU, "Unknown destination framebuffer format {:x}",
-                          static_cast<u32>(config.output_format.Value()));
-                break;
-            }
-        }
-    }
+    PerformDisplayTransfer(config, src_pointer, dst_pointer);
 }
 
 static void TextureCopy(const Regs::DisplayTransferConfig& config) {
@@ -384,6 +249,140 @@ static void TextureCopy(const Regs::DisplayTransferConfig& config) {
     }
 }
 
+void RunOnCPUThread(std::function<void()> callback) {
+    if (gpu_thread && gpu_thread->IsGPUThread()) {
+        gpu_thread->DeferToCPU(std::move(callback));
+    } else {
+        callback();
+    }
+}
+
+static void ExecuteMemoryFill(const VideoCore::MemoryFillCommand& command) {
+    const auto& config = command.config;
+    MemoryFill(config);
+    LOG_TRACE(HW_GPU, "MemoryFill from {:#010X} to {:#010X}", config.GetStartAddress(),
+              config.GetEndAddress());
+
+    const bool is_second_filler = command.is_second_filler;
+    const bool signal_interrupt = config.GetStartAddress() != 0;
+    RunOnCPUThread([is_second_filler, signal_interrupt] {
+        // It seems that it won't signal interrupt if "address_start" is zero.
+        // TODO: hwtest this
+        if (signal_interrupt) {
+            if (!is_second_filler) {
+                Service::GSP::SignalInterrupt(Service::GSP::InterruptId::PSC0);
+            } else {
+                Service::GSP::SignalInterrupt(Service::GSP::InterruptId::PSC1);
+            }
+        }
+
+        // Reset "trigger" flag and set the "finish" flag
+        // NOTE: This was confirmed to happen on hardware even if "address_start" is zero.
+        auto& regs_config = g_regs.memory_fill_config[is_second_filler];
+        regs_config.trigger.Assign(0);
+        regs_config.finished.Assign(1);
+    });
+}
+
+static void ExecuteDisplayTransfer(const VideoCore::DisplayTransferCommand& command) {
+    MICROPROFILE_SCOPE(GPU_DisplayTransfer);
+
+    const auto& config = command.config;
+    if (Pica::g_debug_context)
+        Pica::g_debug_context->OnEvent(Pica::DebugContext::Event::IncomingDisplayTransfer,
+                                       nullptr);
+
+    if (config.is_texture_copy) {
+        TextureCopy(config);
+        LOG_TRACE(HW_GPU,
+                  "TextureCopy: {:#X} bytes from {:#010X}({}+{})-> "
+                  "{:#010X}({}+{}), flags {:#010X}",
+                  config.texture_copy.size, config.GetPhysicalInputAddress(),
+                  config.texture_copy.input_width * 16, config.texture_copy.input_gap * 16,
+                  config.GetPhysicalOutputAddress(), config.texture_copy.output_width * 16,
+                  config.texture_copy.output_gap * 16, config.flags);
+    } else {
+        DisplayTransfer(config);
+        LOG_TRACE(HW_GPU,
+                  "DisplayTransfer: {:#010X}({}x{})-> "
+                  "{:#010X}({}x{}), dst format {:x}, flags {:#010X}",
+                  config.GetPhysicalInputAddress(), config.input_width.Value(),
+                  config.input_height.Value(), config.GetPhysicalOutputAddress(),
+                  config.output_width.Value(), config.output_height.Value(),
+                  static_cast<u32>(config.output_format.Value()), config.flags);
+    }
+
+    RunOnCPUThread([] {
+        g_regs.display_transfer_config.trigger = 0;
+        Service::GSP::SignalInterrupt(Service::GSP::InterruptId::PPF);
+    });
+}
+
+static void ExecuteCommandList(const VideoCore::SubmitListCommand& command) {
+    MICROPROFILE_SCOPE(GPU_CmdlistProcessing);
+
+    Pica::CommandProcessor::ProcessCommandList(command.address, command.size);
+
+    RunOnCPUThread([] { g_regs.command_processor_config.trigger = 0; });
+}
+
+static void ExecuteCommand(const VideoCore::CommandData& command) {
+    if (const auto* fill = std::get_if<VideoCore::MemoryFillCommand>(&command)) {
+        ExecuteMemoryFill(*fill);
+    } else if (const auto* transfer = std::get_if<VideoCore::DisplayTransferCommand>(&command)) {
+        ExecuteDisplayTransfer(*transfer);
+    } else if (const auto* list = std::get_if<VideoCore::SubmitListCommand>(&command)) {
+        ExecuteCommandList(*list);
+    }
+}
+
+/**
+ * Returns whether GPU work may run on the GPU thread. The OpenGL rasterizer is bound to the
+ * context of the CPU thread, and the PICA tracer is not thread safe, so both force synchronous
+ * processing.
+ */
+static bool UseGPUThread() {
+    return gpu_thread && !VideoCore::g_hw_renderer_enabled &&
+           !(Pica::g_debug_context && Pica::g_debug_context->recorder);
+}
+
+static void SubmitCommand(VideoCore::CommandData command) {
+    if (!UseGPUThread()) {
+        // Earlier work may still be pending if the GPU thread was just disabled
+        SyncGPUThread();
+        ExecuteCommand(command);
+        return;
+    }
+
+    gpu_thread->Submit(std::move(command));
+    if (!fence_scheduled) {
+        Core::System::GetInstance().CoreTiming().ScheduleEvent(fence_ticks, fence_event);
+        fence_scheduled = true;
+    }
+}
+
+void SignalInterrupt(Service::GSP::InterruptId interrupt_id) {
+    RunOnCPUThread([interrupt_id] { Service::GSP::SignalInterrupt(interrupt_id); });
+}
+
+void WaitForGPUThread() {
+    if (gpu_thread && !gpu_thread->IsGPUThread()) {
+        gpu_thread->WaitIdle();
+    }
+}
+
+void SyncGPUThread() {
+    if (gpu_thread) {
+        gpu_thread->WaitIdle();
+        gpu_thread->RunDeferred();
+    }
+}
+
+static void FenceCallback(u64 userdata, s64 cycles_late) {
+    fence_scheduled = false;
+    SyncGPUThread();
+}
+
 template <typename T>
 inline void Write(u32 addr, const T data) {
     addr -= HW::VADDR_GPU;
@@ -403,63 +402,18 @@ inline void Write(u32 addr, const T data) {
     case GPU_REG_INDEX(memory_fill_config[0].trigger):
     case GPU_REG_INDEX(memory_fill_config[1].trigger): {
         const bool is_second_filler = (index != GPU_REG_INDEX(memory_fill_config[0].trigger));
-        auto& config = g_regs.memory_fill_config[is_second_filler];
+        const auto& config = g_regs.memory_fill_config[is_second_filler];
 
         if (config.trigger) {
-            MemoryFill(config);
-            LOG_TRACE(HW_GPU, "MemoryFill from {:#010X} to {:#010X}", config.GetStartAddress(),
-                      config.GetEndAddress());
-
-            // It seems that it won't signal interrupt if "address_start" is zero.
-            // TODO: hwtest this
-            if (config.GetStartAddress() != 0) {
-                if (!is_second_filler) {
-                    Service::GSP::SignalInterrupt(Service::GSP::InterruptId::PSC0);
-                } else {
-                    Service::GSP::SignalInterrupt(Service::GSP::InterruptId::PSC1);
-                }
-            }
-
-            // Reset "trigger" flag and set the "finish" flag
-            // NOTE: This was confirmed to happen on hardware even if "address_start" is zero.
-            config.trigger.Assign(0);
-            config.finished.Assign(1);
+            SubmitCommand(VideoCore::MemoryFillCommand{config, is_second_filler});
         }
         break;
     }
 
     case GPU_REG_INDEX(display_transfer_config.trigger): {
-        MICROPROFILE_SCOPE(GPU_DisplayTransfer);
-
         const auto& config = g_regs.display_transfer_config;
         if (config.trigger & 1) {
-
-            if (Pica::g_debug_context)
-                Pica::g_debug_context->OnEvent(Pica::DebugContext::Event::IncomingDisplayTransfer,
-                                               nullptr);
-
-            if (config.is_texture_copy) {
-                TextureCopy(config);
-                LOG_TRACE(HW_GPU,
-                          "TextureCopy: {:#X} bytes from {:#010X}({}+{})-> "
-                          "{:#010X}({}+{}), flags {:#010X}",
-                          config.texture_copy.size, config.GetPhysicalInputAddress(),
-                          config.texture_copy.input_width * 16, config.texture_copy.input_gap * 16,
-                          config.GetPhysicalOutputAddress(), config.texture_copy.output_width * 16,
-                          config.texture_copy.output_gap * 16, config.flags);
-            } else {
-                DisplayTransfer(config);
-                LOG_TRACE(HW_GPU,
-                          "DisplayTransfer: {:#010X}({}x{})-> "
-                          "{:#010X}({}x{}), dst format {:x}, flags {:#010X}",
-                          config.GetPhysicalInputAddress(), config.input_width.Value(),
-                          config.input_height.Value(), config.GetPhysicalOutputAddress(),
-                          config.output_width.Value(), config.output_height.Value(),
-                          static_cast<u32>(config.output_format.Value()), config.flags);
-            }
-
-            g_regs.display_transfer_config.trigger = 0;
-            Service::GSP::SignalInterrupt(Service::GSP::InterruptId::PPF);
+            SubmitCommand(VideoCore::DisplayTransferCommand{config});
         }
         break;
     }
@@ -468,11 +422,7 @@ inline void Write(u32 addr, const T data) {
     case GPU_REG_INDEX(command_processor_config.trigger): {
         const auto& config = g_regs.command_processor_config;
         if (config.trigger & 1) {
-            MICROPROFILE_SCOPE(GPU_CmdlistProcessing);
-
-            Pica::CommandProcessor::ProcessCommandList(config.GetPhysicalAddress(), config.size);
-
-            g_regs.command_processor_config.trigger = 0;
+            SubmitCommand(VideoCore::SubmitListCommand{config.GetPhysicalAddress(), config.size});
         }
         break;
     }
@@ -504,6 +454,9 @@ template void Write<u8>(u32 addr, const u8 data);
 
 /// Update hardware
 static void VBlankCallback(u64 userdata, s64 cycles_late) {
+    // The framebuffers have to be complete before they are displayed
+    SyncGPUThread();
+
     VideoCore::g_renderer->SwapBuffers();
 
     // Signal to GSP that GPU interrupt has occurred
@@ -553,11 +506,20 @@ void Init(Memory::MemorySystem& memory) {
     vblank_event = timing.RegisterEvent("GPU::VBlankCallback", VBlankCallback);
     timing.ScheduleEvent(frame_ticks, vblank_event);
 
+    // Registered regardless of the setting, so that save states with a pending fence load
+    fence_event = timing.RegisterEvent("GPU::FenceCallback", FenceCallback);
+    fence_scheduled = false;
+    if (Settings::values.use_async_gpu) {
+        gpu_thread = std::make_unique<VideoCore::GPUThread>(ExecuteCommand);
+    }
+
     LOG_DEBUG(HW_GPU, "initialized OK");
 }
 
 /// Shutdown hardware
 void Shutdown() {
+    gpu_thread.reset();
+
     LOG_DEBUG(HW_GPU, "shutdown OK");
 }
 
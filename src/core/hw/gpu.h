@@ -5,6 +5,7 @@
 #pragma once
 
 #include <cstddef>
+#include <functional>
 #include <type_traits>
 #include <boost/serialization/access.hpp>
 #include <boost/serialization/binary_object.hpp>
@@ -18,6 +19,10 @@ namespace Memory {
 class MemorySystem;
 }
 
+namespace Service::GSP {
+enum class InterruptId : u8;
+}
+
 namespace GPU {
 
 // Measured on hardware to be 2240568 timer cycles or 4481136 ARM11 cycles
@@ -320,6 +325,24 @@ void Read(T& var, const u32 addr);
 template <typename T>
 void Write(u32 addr, const T data);
 
+/**
+ * Signals a GSP interrupt raised by GPU work. Interrupts raised on the GPU thread are delivered
+ * once the CPU thread synchronizes with it.
+ */
+void SignalInterrupt(Service::GSP::InterruptId interrupt_id);
+
+/// Runs the given function on the CPU thread, deferring it if called on the GPU thread
+void RunOnCPUThread(std::function<void()> callback);
+
+/**
+ * Blocks until the GPU thread, if enabled, has finished all submitted work. Must be called before
+ * the CPU accesses memory the GPU may read or write; does nothing on the GPU thread itself.
+ */
+void WaitForGPUThread();
+
+/// Waits for the GPU thread and delivers the interrupts and register updates of its finished work
+void SyncGPUThread();
+
 /// Initialize hardware
 void Init(Memory::MemorySystem& memory);
 
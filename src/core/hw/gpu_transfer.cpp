@@ -0,0 +1,594 @@
+// Copyright 2022 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+#include "common/alignment.h"
+#include "common/color.h"
+#include "common/logging/log.h"
+#include "common/simd_lanes.h"
+#include "common/swap.h"
+#include "common/vector_math.h"
+#include "core/hw/gpu_transfer.h"
+#include "video_core/utils.h"
+
+namespace GPU {
+
+using PixelFormat = Regs::PixelFormat;
+
+namespace {
+
+using Common::Simd::Lanes;
+using Common::Simd::Scalar;
+
+constexpr std::size_t TILE_SIZE = 8 * 8;
+
+/// Pixels in the layout of RGBA8 memory read as little endian words: red in the highest byte
+using ImageTile = std::array<u32, TILE_SIZE>;
+
+struct TilePosition {
+    u8 x;
+    u8 y;
+};
+
+/// Position within the tile of each pixel of an 8x8 tile stored in Morton order
+constexpr std::array<TilePosition, TILE_SIZE> tile_positions = [] {
+    std::array<TilePosition, TILE_SIZE> positions{};
+    for (u32 y = 0; y < 8; ++y) {
+        for (u32 x = 0; x < 8; ++x) {
+            positions[VideoCore::MortonInterleave(x, y)] = {static_cast<u8>(x), static_cast<u8>(y)};
+        }
+    }
+    return positions;
+}();
+
+/**
+ * Conversion of each pixel format from and to RGBA8. Decode and Encode work on pixels loaded as
+ * little endian integers of the size of the format, one pixel per lane.
+ */
+template <PixelFormat format>
+struct FormatTraits;
+
+template <>
+struct FormatTraits<PixelFormat::RGBA8> {
+    static constexpr u32 bytes_per_pixel = 4;
+
+    template <typename V>
+    static V Decode(V pixel) {
+        return pixel;
+    }
+
+    template <typename V>
+    static V Encode(V color) {
+        return color;
+    }
+};
+
+template <>
+struct FormatTraits<PixelFormat::RGB8> {
+    static constexpr u32 bytes_per_pixel = 3;
+
+    template <typename V>
+    static V Decode(V pixel) {
+        return pixel.template ShiftLeft<8>() | V::Splat(0xFF);
+    }
+
+    template <typename V>
+    static V Encode(V color) {
+        return color.template ShiftRight<8>();
+    }
+};
+
+template <>
+struct FormatTraits<PixelFormat::RGB565> {
+    static constexpr u32 bytes_per_pixel = 2;
+
+    template <typename V>
+    static V Decode(V pixel) {
+        const V r = pixel.template ShiftRight<11>() & V::Splat(0x1F);
+        const V g = pixel.template ShiftRight<5>() & V::Splat(0x3F);
+        const V b = pixel & V::Splat(0x1F);
+        return (r.template ShiftLeft<3>() | r.template ShiftRight<2>()).template ShiftLeft<24>() |
+               (g.template ShiftLeft<2>() | g.template ShiftRight<4>()).template ShiftLeft<16>() |
+               (b.template ShiftLeft<3>() | b.template ShiftRight<2>()).template ShiftLeft<8>() |
+               V::Splat(0xFF);
+    }
+
+    template <typename V>
+    static V Encode(V color) {
+        return (color.template ShiftRight<16>() & V::Splat(0xF800)) |
+               (color.template ShiftRight<13>() & V::Splat(0x07E0)) |
+               (color.template ShiftRight<11>() & V::Splat(0x001F));
+    }
+};
+
+template <>
+struct FormatTraits<PixelFormat::RGB5A1> {
+    static constexpr u32 bytes_per_pixel = 2;
+
+    template <typename V>
+    static V Decode(V pixel) {
+        const V r = pixel.template ShiftRight<11>() & V::Splat(0x1F);
+        const V g = pixel.template ShiftRight<6>() & V::Splat(0x1F);
+        const V b = pixel.template ShiftRight<1>() & V::Splat(0x1F);
+        const V a = pixel & V::Splat(0x1);
+        return (r.template ShiftLeft<3>() | r.template ShiftRight<2>()).template ShiftLeft<24>() |
+               (g.template ShiftLeft<3>() | g.template ShiftRight<2>()).template ShiftLeft<16>() |
+               (b.template ShiftLeft<3>() | b.template ShiftRight<2>()).template ShiftLeft<8>() |
+               (a.template ShiftLeft<8>() - a);
+    }
+
+    template <typename V>
+    static V Encode(V color) {
+        return (color.template ShiftRight<16>() & V::Splat(0xF800)) |
+               (color.template ShiftRight<13>() & V::Splat(0x07C0)) |
+               (color.template ShiftRight<10>() & V::Splat(0x003E)) |
+               (color.template ShiftRight<7>() & V::Splat(0x0001));
+    }
+};
+
+template <>
+struct FormatTraits<PixelFormat::RGBA4> {
+    static constexpr u32 bytes_per_pixel = 2;
+
+    template <typename V>
+    static V Decode(V pixel) {
+        // Spread the nibbles to the high nibble of each byte, then copy them to the low nibble
+        const V high = (pixel.template ShiftLeft<16>() & V::Splat(0xF0000000)) |
+                       (pixel.template ShiftLeft<12>() & V::Splat(0x00F00000)) |
+                       (pixel.template ShiftLeft<8>() & V::Splat(0x0000F000)) |
+                       (pixel.template ShiftLeft<4>() & V::Splat(0x000000F0));
+        return high | high.template ShiftRight<4>();
+    }
+
+    template <typename V>
+    static V Encode(V color) {
+        return (color.template ShiftRight<16>() & V::Splat(0xF000)) |
+               (color.template ShiftRight<12>() & V::Splat(0x0F00)) |
+               (color.template ShiftRight<8>() & V::Splat(0x00F0)) |
+               (color.template ShiftRight<4>() & V::Splat(0x000F));
+    }
+};
+
+template <typename V, u32 bytes_per_pixel>
+V LoadPixels(const u8* src) {
+    if constexpr (bytes_per_pixel == 2) {
+        return V::Load16(src);
+    } else if constexpr (bytes_per_pixel == 3) {
+        return V::Load24(src);
+    } else {
+        return V::Load32(src);
+    }
+}
+
+template <typename V, u32 bytes_per_pixel>
+void StorePixels(const V& pixels, u8* dst) {
+    if constexpr (bytes_per_pixel == 2) {
+        pixels.Store16(dst);
+    } else if constexpr (bytes_per_pixel == 3) {
+        pixels.Store24(dst);
+    } else {
+        pixels.Store32(dst);
+    }
+}
+
+/// Returns the number of pixels of a run which are converted a whole vector at a time
+template <PixelFormat format>
+constexpr std::size_t VectorPixels(std::size_t count) {
+    // RGB8 pixels don't line up with the lanes, the compiler is left to vectorize those
+    if constexpr (FormatTraits<format>::bytes_per_pixel == 3) {
+        return 0;
+    } else {
+        return Common::AlignDown(count, Lanes::Count);
+    }
+}
+
+template <PixelFormat format>
+void DecodePixels(const u8* src, u32* dst, std::size_t count) {
+    using Traits = FormatTraits<format>;
+    constexpr u32 bpp = Traits::bytes_per_pixel;
+
+    const std::size_t vector_count = VectorPixels<format>(count);
+    std::size_t i = 0;
+    if constexpr (bpp != 3) {
+        for (; i < vector_count; i += Lanes::Count) {
+            Traits::Decode(LoadPixels<Lanes, bpp>(src + i * bpp))
+                .Store32(reinterpret_cast<u8*>(dst + i));
+        }
+    }
+    for (; i < count; ++i) {
+        dst[i] = Traits::Decode(LoadPixels<Scalar, bpp>(src + i * bpp)).v;
+    }
+}
+
+template <PixelFormat format>
+void EncodePixels(const u32* src, u8* dst, std::size_t count) {
+    using Traits = FormatTraits<format>;
+    constexpr u32 bpp = Traits::bytes_per_pixel;
+
+    const std::size_t vector_count = VectorPixels<format>(count);
+    std::size_t i = 0;
+    if constexpr (bpp != 3) {
+        for (; i < vector_count; i += Lanes::Count) {
+            StorePixels<Lanes, bpp>(
+                Traits::Encode(Lanes::Load32(reinterpret_cast<const u8*>(src + i))), dst + i * bpp);
+        }
+    }
+    for (; i < count; ++i) {
+        StorePixels<Scalar, bpp>(Traits::Encode(Scalar{src[i]}), dst + i * bpp);
+    }
+}
+
+/// Averages the channels of two pixels, rounding down
+constexpr u32 Average2(u32 a, u32 b) {
+    return ((a >> 1) & 0x7F7F7F7F) + ((b >> 1) & 0x7F7F7F7F) + (a & b & 0x01010101);
+}
+
+/// Averages the channels of four pixels, rounding down
+constexpr u32 Average4(u32 a, u32 b, u32 c, u32 d) {
+    // Sum the upper six and the lower two bits of each channel separately so that none overflows
+    const u32 high = ((a >> 2) & 0x3F3F3F3F) + ((b >> 2) & 0x3F3F3F3F) + ((c >> 2) & 0x3F3F3F3F) +
+                     ((d >> 2) & 0x3F3F3F3F);
+    const u32 low = (a & 0x03030303) + (b & 0x03030303) + (c & 0x03030303) + (d & 0x03030303);
+    return high + ((low >> 2) & 0x03030303);
+}
+
+struct TransferLayout {
+    const u8* src;
+    u8* dst;
+    u32 input_width;
+    /// Dimensions of the output image after scaling
+    u32 output_width;
+    u32 output_height;
+    /// Log2 of the number of input pixels averaged per output pixel in either direction
+    u32 horizontal_scale;
+    u32 vertical_scale;
+    bool input_tiled;
+    bool output_tiled;
+    bool flip;
+};
+
+/**
+ * Converts the image in strips of eight output rows: the input rows of a strip are decoded to
+ * RGBA8, scaled, then encoded to the output. Tiled images must have dimensions which are multiples
+ * of the tile size.
+ */
+template <PixelFormat input_format, PixelFormat output_format>
+void ConvertImage(const TransferLayout& layout) {
+    constexpr u32 input_bpp = FormatTraits<input_format>::bytes_per_pixel;
+    constexpr u32 output_bpp = FormatTraits<output_format>::bytes_per_pixel;
+
+    const u32 input_columns = layout.output_width << layout.horizontal_scale;
+    const u32 input_strip_rows = 8 << layout.vertical_scale;
+    const bool scaled = layout.horizontal_scale != 0 || layout.vertical_scale != 0;
+
+    std::vector<u32> input_strip(std::size_t{input_columns} * input_strip_rows);
+    std::vector<u32> scaled_strip(scaled ? std::size_t{layout.output_width} * 8 : 0);
+    ImageTile tile;
+
+    for (u32 y = 0; y < layout.output_height; y += 8) {
+        const u32 strip_rows = std::min(8U, layout.output_height - y);
+        const u32 input_y = y << layout.vertical_scale;
+
+        if (layout.input_tiled) {
+            for (u32 row = 0; row < input_strip_rows; row += 8) {
+                const u8* tile_row =
+                    layout.src + std::size_t{input_y + row} * layout.input_width * input_bpp;
+                for (u32 x = 0; x < input_columns; x += 8) {
+                    DecodePixels<input_format>(tile_row + x * 8 * input_bpp, tile.data(),
+                                               tile.size());
+                    u32* dest = &input_strip[std::size_t{row} * input_columns + x];
+                    for (std::size_t i = 0; i < TILE_SIZE; ++i) {
+                        const TilePosition position = tile_positions[i];
+                        dest[position.y * input_columns + position.x] = tile[i];
+                    }
+                }
+            }
+        } else {
+            for (u32 row = 0; row < strip_rows; ++row) {
+                DecodePixels<input_format>(
+                    layout.src + std::size_t{input_y + row} * layout.input_width * input_bpp,
+                    &input_strip[std::size_t{row} * input_columns], input_columns);
+            }
+        }
+
+        const u32* strip = input_strip.data();
+        if (layout.vertical_scale != 0) {
+            for (u32 row = 0; row < strip_rows; ++row) {
+                const u32* upper = &input_strip[std::size_t{row} * 2 * input_columns];
+                const u32* lower = upper + input_columns;
+                u32* dest = &scaled_strip[std::size_t{row} * layout.output_width];
+                for (u32 x = 0; x < layout.output_width; ++x) {
+                    dest[x] = Average4(upper[2 * x], upper[2 * x + 1], lower[2 * x],
+                                       lower[2 * x + 1]);
+                }
+            }
+            strip = scaled_strip.data();
+        } else if (layout.horizontal_scale != 0) {
+            for (u32 row = 0; row < strip_rows; ++row) {
+                const u32* source = &input_strip[std::size_t{row} * input_columns];
+                u32* dest = &scaled_strip[std::size_t{row} * layout.output_width];
+                for (u32 x = 0; x < layout.output_width; ++x) {
+                    dest[x] = Average2(source[2 * x], source[2 * x + 1]);
+                }
+            }
+            strip = scaled_strip.data();
+        }
+
+        if (layout.output_tiled) {
+            // Flipping maps the strip to the mirrored tile row with its rows reversed
+            const u32 output_y = layout.flip ? layout.output_height - 8 - y : y;
+            u8* tile_row = layout.dst + std::size_t{output_y} * layout.output_width * output_bpp;
+            for (u32 x = 0; x < layout.output_width; x += 8) {
+                for (std::size_t i = 0; i < TILE_SIZE; ++i) {
+                    const TilePosition position = tile_positions[i];
+                    const u32 row = layout.flip ? 7 - position.y : position.y;
+                    tile[i] = strip[row * layout.output_width + x + position.x];
+                }
+                EncodePixels<output_format>(tile.data(), tile_row + x * 8 * output_bpp,
+                                            tile.size());
+            }
+        } else {
+            for (u32 row = 0; row < strip_rows; ++row) {
+                const u32 output_y = layout.flip ? layout.output_height - 1 - (y + row) : y + row;
+                EncodePixels<output_format>(
+                    &strip[std::size_t{row} * layout.output_width],
+                    layout.dst + std::size_t{output_y} * layout.output_width * output_bpp,
+                    layout.output_width);
+            }
+        }
+    }
+}
+
+using ConvertFunction = void (*)(const TransferLayout&);
+
+template <PixelFormat input_format>
+ConvertFunction GetConvertFunction(PixelFormat output_format) {
+    switch (output_format) {
+    case PixelFormat::RGBA8:
+        return &ConvertImage<input_format, PixelFormat::RGBA8>;
+    case PixelFormat::RGB8:
+        return &ConvertImage<input_format, PixelFormat::RGB8>;
+    case PixelFormat::RGB565:
+        return &ConvertImage<input_format, PixelFormat::RGB565>;
+    case PixelFormat::RGB5A1:
+        return &ConvertImage<input_format, PixelFormat::RGB5A1>;
+    case PixelFormat::RGBA4:
+        return &ConvertImage<input_format, PixelFormat::RGBA4>;
+    default:
+        return nullptr;
+    }
+}
+
+ConvertFunction GetConvertFunction(PixelFormat input_format, PixelFormat output_format) {
+    switch (input_format) {
+    case PixelFormat::RGBA8:
+        return GetConvertFunction<PixelFormat::RGBA8>(output_format);
+    case PixelFormat::RGB8:
+        return GetConvertFunction<PixelFormat::RGB8>(output_format);
+    case PixelFormat::RGB565:
+        return GetConvertFunction<PixelFormat::RGB565>(output_format);
+    case PixelFormat::RGB5A1:
+        return GetConvertFunction<PixelFormat::RGB5A1>(output_format);
+    case PixelFormat::RGBA4:
+        return GetConvertFunction<PixelFormat::RGBA4>(output_format);
+    default:
+        return nullptr;
+    }
+}
+
+Common::Vec4<u8> DecodePixel(PixelFormat input_format, const u8* src_pixel) {
+    switch (input_format) {
+    case PixelFormat::RGBA8:
+        return Color::DecodeRGBA8(src_pixel);
+
+    case PixelFormat::RGB8:
+        return Color::DecodeRGB8(src_pixel);
+
+    case PixelFormat::RGB565:
+        return Color::DecodeRGB565(src_pixel);
+
+    case PixelFormat::RGB5A1:
+        return Color::DecodeRGB5A1(src_pixel);
+
+    case PixelFormat::RGBA4:
+        return Color::DecodeRGBA4(src_pixel);
+
+    default:
+        LOG_ERROR(HW_GPU, "Unknown source framebuffer format {:x}", input_format);
+        return {0, 0, 0, 0};
+    }
+}
+
+/// Fills the range with a repeating pattern whose size is a multiple of 16 bytes
+template <std::size_t pattern_size>
+void FillPattern(u8* dst, std::size_t size, const std::array<u8, pattern_size>& pattern) {
+    static_assert(pattern_size % 16 == 0);
+    std::size_t offset = 0;
+    for (; offset + pattern_size <= size; offset += pattern_size) {
+        std::memcpy(dst + offset, pattern.data(), pattern_size);
+    }
+    std::memcpy(dst + offset, pattern.data(), size - offset);
+}
+
+} // Anonymous namespace
+
+void PerformMemoryFill(const Regs::MemoryFillConfig& config, u8* start, u8* end) {
+    const std::size_t size = end - start;
+    if (config.fill_24bit) {
+        // The pattern lines up with 16-byte blocks again every three of them
+        std::array<u8, 48> pattern;
+        for (std::size_t i = 0; i < pattern.size(); i += 3) {
+            pattern[i] = static_cast<u8>(config.value_24bit_r);
+            pattern[i + 1] = static_cast<u8>(config.value_24bit_g);
+            pattern[i + 2] = static_cast<u8>(config.value_24bit_b);
+        }
+        FillPattern(start, Common::AlignUp(size, 3), pattern);
+    } else if (config.fill_32bit) {
+        const u32 value = config.value_32bit;
+        std::array<u8, 64> pattern;
+        for (std::size_t i = 0; i < pattern.size(); i += sizeof(u32)) {
+            std::memcpy(&pattern[i], &value, sizeof(u32));
+        }
+        FillPattern(start, Common::AlignDown(size, sizeof(u32)), pattern);
+    } else {
+        const u16 value = config.value_16bit.Value();
+        std::array<u8, 64> pattern;
+        for (std::size_t i = 0; i < pattern.size(); i += sizeof(u16)) {
+            std::memcpy(&pattern[i], &value, sizeof(u16));
+        }
+        FillPattern(start, Common::AlignUp(size, sizeof(u16)), pattern);
+    }
+}
+
+void PerformDisplayTransfer(const Regs::DisplayTransferConfig& config, const u8* src, u8* dst) {
+    const u32 horizontal_scale = config.scaling != config.NoScale ? 1 : 0;
+    const u32 vertical_scale = config.scaling == config.ScaleXY ? 1 : 0;
+
+    const TransferLayout layout{
+        .src = src,
+        .dst = dst,
+        .input_width = config.input_width,
+        .output_width = config.output_width >> horizontal_scale,
+        .output_height = config.output_height >> vertical_scale,
+        .horizontal_scale = horizontal_scale,
+        .vertical_scale = vertical_scale,
+        .input_tiled = !config.input_linear,
+        .output_tiled = config.input_linear != config.dont_swizzle,
+        .flip = config.flip_vertically != 0,
+    };
+
+    const ConvertFunction convert =
+        GetConvertFunction(config.input_format, config.output_format);
+    const bool tile_aligned = layout.output_width % 8 == 0 && layout.output_height % 8 == 0 &&
+                              (!layout.input_tiled || layout.input_width % 8 == 0);
+    if (convert == nullptr || ((layout.input_tiled || layout.output_tiled) && !tile_aligned)) {
+        PerformDisplayTransferGeneric(config, src, dst);
+        return;
+    }
+
+    convert(layout);
+}
+
+void PerformDisplayTransferGeneric(const Regs::DisplayTransferConfig& config, const u8* src,
+                                   u8* dst) {
+    int horizontal_scale = config.scaling != config.NoScale ? 1 : 0;
+    int vertical_scale = config.scaling == config.ScaleXY ? 1 : 0;
+
+    u32 output_width = config.output_width >> horizontal_scale;
+    u32 output_height = config.output_height >> vertical_scale;
+
+    for (u32 y = 0; y < output_height; ++y) {
+        for (u32 x = 0; x < output_width; ++x) {
+            Common::Vec4<u8> src_color;
+
+            // Calculate the [x,y] position of the input image
+            // based on the current output position and the scale
+            u32 input_x = x << horizontal_scale;
+            u32 input_y = y << vertical_scale;
+
+            u32 output_y;
+            if (config.flip_vertically) {
+                // Flip the y value of the output data,
+                // we do this after calculating the [x,y] position of the input image
+                // to account for the scaling options.
+                output_y = output_height - y - 1;
+            } else {
+                output_y = y;
+            }
+
+            u32 dst_bytes_per_pixel = GPU::Regs::BytesPerPixel(config.output_format);
+            u32 src_bytes_per_pixel = GPU::Regs::BytesPerPixel(config.input_format);
+            u32 src_offset;
+            u32 dst_offset;
+
+            if (config.input_linear) {
+                if (!config.dont_swizzle) {
+                    // Interpret the input as linear and the output as tiled
+                    u32 coarse_y = output_y & ~7;
+                    u32 stride = output_width * dst_bytes_per_pixel;
+
+                    src_offset = (input_x + input_y * config.input_width) * src_bytes_per_pixel;
+                    dst_offset = VideoCore::GetMortonOffset(x, output_y, dst_bytes_per_pixel) +
+                                 coarse_y * stride;
+                } else {
+                    // Both input and output are linear
+                    src_offset = (input_x + input_y * config.input_width) * src_bytes_per_pixel;
+                    dst_offset = (x + output_y * output_width) * dst_bytes_per_pixel;
+                }
+            } else {
+                if (!config.dont_swizzle) {
+                    // Interpret the input as tiled and the output as linear
+                    u32 coarse_y = input_y & ~7;
+                    u32 stride = config.input_width * src_bytes_per_pixel;
+
+                    src_offset = VideoCore::GetMortonOffset(input_x, input_y, src_bytes_per_pixel) +
+                                 coarse_y * stride;
+                    dst_offset = (x + output_y * output_width) * dst_bytes_per_pixel;
+                } else {
+                    // Both input and output are tiled
+                    u32 out_coarse_y = output_y & ~7;
+                    u32 out_stride = output_width * dst_bytes_per_pixel;
+
+                    u32 in_coarse_y = input_y & ~7;
+                    u32 in_stride = config.input_width * src_bytes_per_pixel;
+
+                    src_offset = VideoCore::GetMortonOffset(input_x, input_y, src_bytes_per_pixel) +
+                                 in_coarse_y * in_stride;
+                    dst_offset = VideoCore::GetMortonOffset(x, output_y, dst_bytes_per_pixel) +
+                                 out_coarse_y * out_stride;
+                }
+            }
+
+            const u8* src_pixel = src + src_offset;
+            src_color = DecodePixel(config.input_format, src_pixel);
+            if (config.scaling == config.ScaleX) {
+                Common::Vec4<u8> pixel =
+                    DecodePixel(config.input_format, src_pixel + src_bytes_per_pixel);
+                src_color = ((src_color + pixel) / 2).Cast<u8>();
+            } else if (config.scaling == config.ScaleXY) {
+                Common::Vec4<u8> pixel1 =
+                    DecodePixel(config.input_format, src_pixel + 1 * src_bytes_per_pixel);
+                Common::Vec4<u8> pixel2 =
+                    DecodePixel(config.input_format, src_pixel + 2 * src_bytes_per_pixel);
+                Common::Vec4<u8> pixel3 =
+                    DecodePixel(config.input_format, src_pixel + 3 * src_bytes_per_pixel);
+                src_color = (((src_color + pixel1) + (pixel2 + pixel3)) / 4).Cast<u8>();
+            }
+
+            u8* dst_pixel = dst + dst_offset;
+            switch (config.output_format) {
+            case PixelFormat::RGBA8:
+                Color::EncodeRGBA8(src_color, dst_pixel);
+                break;
+
+            case PixelFormat::RGB8:
+                Color::EncodeRGB8(src_color, dst_pixel);
+                break;
+
+            case PixelFormat::RGB565:
+                Color::EncodeRGB565(src_color, dst_pixel);
+                break;
+
+            case PixelFormat::RGB5A1:
+                Color::EncodeRGB5A1(src_color, dst_pixel);
+                break;
+
+            case PixelFormat::RGBA4:
+                Color::EncodeRGBA4(src_color, dst_pixel);
+                break;
+
+            default:
+                LOG_ERROR(HW_GPU, "Unknown destination framebuffer format {:x}",
+                          static_cast<u32>(config.output_format.Value()));
+                break;
+            }
+        }
+    }
+}
+
+} // namespace GPU
@@ -0,0 +1,30 @@
+// Copyright 2022 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include "common/common_types.h"
+#include "core/hw/gpu.h"
+
+namespace GPU {
+
+/**
+ * Fills the memory range the way the memory fill units do. Like on hardware, a 16-bit or 24-bit
+ * value that straddles the end of the range is still written in full.
+ */
+void PerformMemoryFill(const Regs::MemoryFillConfig& config, u8* start, u8* end);
+
+/**
+ * Converts an image the way the display transfer engine does. The conversion is specialized per
+ * pair of pixel formats at compile time and works on whole 8x8 tiles with SIMD kernels; images
+ * whose dimensions aren't multiples of the tile size fall back to PerformDisplayTransferGeneric.
+ * The scaling mode must be supported, see DisplayTransfer in gpu.cpp.
+ */
+void PerformDisplayTransfer(const Regs::DisplayTransferConfig& config, const u8* src, u8* dst);
+
+/// Converts an image pixel by pixel, used for irregular images and to verify the fast path
+void PerformDisplayTransferGeneric(const Regs::DisplayTransferConfig& config, const u8* src,
+                                   u8* dst);
+
+} // namespace GPU
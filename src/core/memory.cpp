@@ -3,7 +3,9 @@
 // Refer to the license.txt file included.
 
 #include <array>
+#include <atomic>
 #include <cstring>
+#include <stdexcept>
 #include <boost/serialization/array.hpp>
 #include <boost/serialization/binary_object.hpp>
 #include "audio_core/dsp_interface.h"
@@ -18,6 +20,7 @@
 #include "core/hle/kernel/memory.h"
 #include "core/hle/kernel/process.h"
 #include "core/hle/lock.h"
+#include "core/hw/gpu.h"
 #include "core/memory.h"
 #include "core/settings.h"
 #include "video_core/renderer_base.h"
@@ -34,6 +37,9 @@ void PageTable::Clear() {
     pointers.raw.fill(nullptr);
     pointers.refs.fill(MemoryRef());
     attributes.fill(PageType::Unmapped);
+    if (fastmem) {
+        fastmem->Unmap(0, Common::HostMemory::VIEW_SIZE);
+    }
 }
 
 class RasterizerCacheMarker {
@@ -79,13 +85,24 @@ private:
     }
 };
 
+namespace {
+/// Keyframe set by the FCRAMDeltaScope alive on this thread, if any
+struct FCRAMDeltaKeyframe {
+    const u8* data = nullptr;
+    std::size_t size = 0;
+};
+thread_local FCRAMDeltaKeyframe fcram_delta_keyframe;
+} // Anonymous namespace
+
 class MemorySystem::Impl {
 public:
-    // Visual Studio would try to allocate these on compile time if they are std::array, which would
-    // exceed the memory limit.
-    std::unique_ptr<u8[]> fcram = std::make_unique<u8[]>(Memory::FCRAM_N3DS_SIZE);
-    std::unique_ptr<u8[]> vram = std::make_unique<u8[]>(Memory::VRAM_SIZE);
-    std::unique_ptr<u8[]> n3ds_extra_ram = std::make_unique<u8[]>(Memory::N3DS_EXTRA_RAM_SIZE);
+    // FCRAM, VRAM and the N3DS extra RAM share one host allocation, so that they can be mapped
+    // into the fastmem views of the page tables
+    Common::HostMemory host_memory{Memory::FCRAM_N3DS_SIZE + Memory::VRAM_SIZE +
+                                   Memory::N3DS_EXTRA_RAM_SIZE};
+    u8* const fcram = host_memory.BackingBasePointer();
+    u8* const vram = fcram + Memory::FCRAM_N3DS_SIZE;
+    u8* const n3ds_extra_ram = vram + Memory::VRAM_SIZE;
 
     std::shared_ptr<PageTable> current_page_table = nullptr;
     RasterizerCacheMarker cache_marker;
@@ -103,13 +120,13 @@ public:
     const u8* GetPtr(Region r) const {
         switch (r) {
         case Region::VRAM:
-            return vram.get();
+            return vram;
         case Region::DSP:
             return dsp->GetDspMemory().data();
         case Region::FCRAM:
-            return fcram.get();
+            return fcram;
         case Region::N3DS:
-            return n3ds_extra_ram.get();
+            return n3ds_extra_ram;
         default:
             UNREACHABLE();
         }
@@ -118,13 +135,13 @@ public:
     u8* GetPtr(Region r) {
         switch (r) {
         case Region::VRAM:
-            return vram.get();
+            return vram;
         case Region::DSP:
             return dsp->GetDspMemory().data();
         case Region::FCRAM:
-            return fcram.get();
+            return fcram;
         case Region::N3DS:
-            return n3ds_extra_ram.get();
+            return n3ds_extra_ram;
         default:
             UNREACHABLE();
         }
@@ -151,11 +168,21 @@ private:
     void serialize(Archive& ar, const unsigned int file_version) {
         bool save_n3ds_ram = Settings::values.is_new_3ds;
         ar& save_n3ds_ram;
-        ar& boost::serialization::make_binary_object(vram.get(), Memory::VRAM_SIZE);
-        ar& boost::serialization::make_binary_object(
-            fcram.get(), save_n3ds_ram ? Memory::FCRAM_N3DS_SIZE : Memory::FCRAM_SIZE);
+        ar& boost::serialization::make_binary_object(vram, Memory::VRAM_SIZE);
+        const std::size_t fcram_size =
+            save_n3ds_ram ? Memory::FCRAM_N3DS_SIZE : Memory::FCRAM_SIZE;
+        bool is_delta = false;
+        if (file_version > 0) {
+            is_delta = Archive::is_saving::value && fcram_delta_keyframe.data != nullptr;
+            ar& is_delta;
+        }
+        if (is_delta) {
+            SerializeFCRAMDelta(ar, fcram, fcram_size);
+        } else {
+            ar& boost::serialization::make_binary_object(fcram, fcram_size);
+        }
         ar& boost::serialization::make_binary_object(
-            n3ds_extra_ram.get(), save_n3ds_ram ? Memory::N3DS_EXTRA_RAM_SIZE : 0);
+            n3ds_extra_ram, save_n3ds_ram ? Memory::N3DS_EXTRA_RAM_SIZE : 0);
         ar& cache_marker;
         ar& page_table_list;
         // dsp is set from Core::System at startup
@@ -226,6 +253,7 @@ void MemorySystem::MapPages(PageTable& page_table, u32 base, u32 size, MemoryRef
     RasterizerFlushVirtualRegion(base << PAGE_BITS, size * PAGE_SIZE,
                                  FlushMode::FlushAndInvalidate);
 
+    const u32 first_page = base;
     u32 end = base + size;
     while (base != end) {
         ASSERT_MSG(base < PAGE_TABLE_NUM_ENTRIES, "out of range mapping at {:08X}", base);
@@ -243,6 +271,57 @@ void MemorySystem::MapPages(PageTable& page_table, u32 base, u32 size, MemoryRef
         if (memory != nullptr && memory.GetSize() > PAGE_SIZE)
             memory += PAGE_SIZE;
     }
+
+    UpdateFastmem(page_table, first_page, size);
+}
+
+void MemorySystem::UpdateFastmem(PageTable& page_table, u32 base, u32 size) {
+    if (!page_table.fastmem) {
+        return;
+    }
+
+    // Offset of the memory backing a page in the host memory, or -1 if it must not be mapped
+    const auto& pointers = page_table.GetPointerArray();
+    const auto backing_offset = [&](u32 page) -> std::ptrdiff_t {
+        if (page_table.attributes[page] != PageType::Memory) {
+            return -1;
+        }
+        return impl->host_memory.GetBackingOffset(pointers[page]);
+    };
+
+    // Runs of pages that are contiguous in the host memory are mapped with a single call
+    const u32 end = base + size;
+    while (base != end) {
+        const std::ptrdiff_t offset = backing_offset(base);
+        u32 run_end = base + 1;
+        if (offset < 0) {
+            while (run_end != end && backing_offset(run_end) < 0) {
+                ++run_end;
+            }
+            page_table.fastmem->Unmap(std::size_t{base} << PAGE_BITS,
+                                      std::size_t{run_end - base} << PAGE_BITS);
+        } else {
+            while (run_end != end &&
+                   backing_offset(run_end) ==
+                       offset + (static_cast<std::ptrdiff_t>(run_end - base) << PAGE_BITS)) {
+                ++run_end;
+            }
+            page_table.fastmem->Map(std::size_t{base} << PAGE_BITS, offset,
+                                    std::size_t{run_end - base} << PAGE_BITS);
+        }
+        base = run_end;
+    }
+}
+
+u8* MemorySystem::GetFastmemBase(PageTable& page_table) {
+    if (!page_table.fastmem) {
+        page_table.fastmem = impl->host_memory.CreateView();
+        if (!page_table.fastmem) {
+            return nullptr;
+        }
+        UpdateFastmem(page_table, 0, PAGE_TABLE_NUM_ENTRIES);
+    }
+    return page_table.fastmem->BasePointer();
 }
 
 void MemorySystem::MapMemoryRegion(PageTable& page_table, VAddr base, u32 size, MemoryRef target) {
@@ -373,6 +452,49 @@ void MemorySystem::Write(const VAddr vaddr, const T data) {
     }
 }
 
+template <typename T>
+bool MemorySystem::WriteExclusive(const VAddr vaddr, const T data, const T expected) {
+    u8* page_pointer = impl->current_page_table->pointers[vaddr >> PAGE_BITS];
+    if (page_pointer) {
+        // Exclusive accesses are aligned, which makes them valid atomic objects
+        T* pointer = reinterpret_cast<T*>(&page_pointer[vaddr & PAGE_MASK]);
+        T value = expected;
+        return std::atomic_ref<T>{*pointer}.compare_exchange_strong(value, data);
+    }
+
+    PageType type = impl->current_page_table->attributes[vaddr >> PAGE_BITS];
+    switch (type) {
+    case PageType::Unmapped:
+        LOG_ERROR(HW_Memory, "unmapped WriteExclusive{} 0x{:08X} @ 0x{:08X} at PC 0x{:08X}",
+                  sizeof(data) * 8, static_cast<u64>(data), vaddr,
+                  Core::GetRunningCore().GetPC());
+        return true;
+    case PageType::Memory:
+        ASSERT_MSG(false, "Mapped memory page without a pointer @ {:08X}", vaddr);
+        return true;
+    case PageType::RasterizerCachedMemory: {
+        // The compare needs the newest data, so write back what the rasterizer holds first
+        RasterizerFlushVirtualRegion(vaddr, sizeof(T), FlushMode::FlushAndInvalidate);
+        T* pointer = reinterpret_cast<T*>(GetPointerForRasterizerCache(vaddr).GetPtr());
+        T value = expected;
+        return std::atomic_ref<T>{*pointer}.compare_exchange_strong(value, data);
+    }
+    case PageType::Special: {
+        // MMIO handlers have no compare and swap. Cores only access MMIO with the HLE lock held, so
+        // holding it across the read and the write makes the pair atomic to them.
+        std::lock_guard lock{HLE::g_hle_lock};
+        const MMIORegionPointer handler = GetMMIOHandler(*impl->current_page_table, vaddr);
+        if (ReadMMIO<T>(handler, vaddr) != expected) {
+            return false;
+        }
+        WriteMMIO<T>(handler, vaddr, data);
+        return true;
+    }
+    default:
+        UNREACHABLE();
+    }
+}
+
 bool IsValidVirtualAddress(const Kernel::Process& process, const VAddr vaddr) {
     auto& page_table = *process.vm_manager.page_table;
 
@@ -548,6 +670,7 @@ void MemorySystem::RasterizerMarkRegionCached(PAddr start, u32 size, bool cached
                     case PageType::Memory:
                         page_type = PageType::RasterizerCachedMemory;
                         page_table->pointers[vaddr >> PAGE_BITS] = nullptr;
+                        UpdateFastmem(*page_table, vaddr >> PAGE_BITS, 1);
                         break;
                     default:
                         UNREACHABLE();
@@ -563,6 +686,7 @@ void MemorySystem::RasterizerMarkRegionCached(PAddr start, u32 size, bool cached
                         page_type = PageType::Memory;
                         page_table->pointers[vaddr >> PAGE_BITS] =
                             GetPointerForRasterizerCache(vaddr & ~PAGE_MASK);
+                        UpdateFastmem(*page_table, vaddr >> PAGE_BITS, 1);
                         break;
                     }
                     default:
@@ -579,6 +703,7 @@ void RasterizerFlushRegion(PAddr start, u32 size) {
         return;
     }
 
+    GPU::WaitForGPUThread();
     VideoCore::g_renderer->Rasterizer()->FlushRegion(start, size);
 }
 
@@ -587,6 +712,7 @@ void RasterizerInvalidateRegion(PAddr start, u32 size) {
         return;
     }
 
+    GPU::WaitForGPUThread();
     VideoCore::g_renderer->Rasterizer()->InvalidateRegion(start, size);
 }
 
@@ -597,6 +723,7 @@ void RasterizerFlushAndInvalidateRegion(PAddr start, u32 size) {
         return;
     }
 
+    GPU::WaitForGPUThread();
     VideoCore::g_renderer->Rasterizer()->FlushAndInvalidateRegion(start, size);
 }
 
@@ -607,6 +734,7 @@ void RasterizerClearAll(bool flush) {
         return;
     }
 
+    GPU::WaitForGPUThread();
     VideoCore::g_renderer->Rasterizer()->ClearAll(flush);
 }
 
@@ -617,6 +745,8 @@ void RasterizerFlushVirtualRegion(VAddr start, u32 size, FlushMode mode) {
         return;
     }
 
+    GPU::WaitForGPUThread();
+
     VAddr end = start + size;
 
     auto CheckRegion = [&](VAddr region_start, VAddr region_end, PAddr paddr_region_start) {
@@ -732,6 +862,22 @@ void MemorySystem::Write64(const VAddr addr, const u64 data) {
     Write<u64_le>(addr, data);
 }
 
+bool MemorySystem::WriteExclusive8(const VAddr addr, const u8 data, const u8 expected) {
+    return WriteExclusive<u8>(addr, data, expected);
+}
+
+bool MemorySystem::WriteExclusive16(const VAddr addr, const u16 data, const u16 expected) {
+    return WriteExclusive<u16>(addr, data, expected);
+}
+
+bool MemorySystem::WriteExclusive32(const VAddr addr, const u32 data, const u32 expected) {
+    return WriteExclusive<u32>(addr, data, expected);
+}
+
+bool MemorySystem::WriteExclusive64(const VAddr addr, const u64 data, const u64 expected) {
+    return WriteExclusive<u64>(addr, data, expected);
+}
+
 void MemorySystem::WriteBlock(const Kernel::Process& process, const VAddr dest_addr,
                               const void* src_buffer, const std::size_t size) {
     auto& page_table = *process.vm_manager.page_table;
@@ -931,18 +1077,18 @@ void WriteMMIO<u64>(MMIORegionPointer mmio_handler, VAddr addr, const u64 data)
 }
 
 u32 MemorySystem::GetFCRAMOffset(const u8* pointer) const {
-    ASSERT(pointer >= impl->fcram.get() && pointer <= impl->fcram.get() + Memory::FCRAM_N3DS_SIZE);
-    return static_cast<u32>(pointer - impl->fcram.get());
+    ASSERT(pointer >= impl->fcram && pointer <= impl->fcram + Memory::FCRAM_N3DS_SIZE);
+    return static_cast<u32>(pointer - impl->fcram);
 }
 
 u8* MemorySystem::GetFCRAMPointer(std::size_t offset) {
     ASSERT(offset <= Memory::FCRAM_N3DS_SIZE);
-    return impl->fcram.get() + offset;
+    return impl->fcram + offset;
 }
 
 const u8* MemorySystem::GetFCRAMPointer(std::size_t offset) const {
     ASSERT(offset <= Memory::FCRAM_N3DS_SIZE);
-    return impl->fcram.get() + offset;
+    return impl->fcram + offset;
 }
 
 MemoryRef MemorySystem::GetFCRAMRef(std::size_t offset) const {
@@ -954,4 +1100,49 @@ void MemorySystem::SetDSP(AudioCore::DspInterface& dsp) {
     impl->dsp = &dsp;
 }
 
+std::vector<u32> FindDirtyPages(const u8* memory, const u8* keyframe, std::size_t size) {
+    ASSERT(size % PAGE_SIZE == 0);
+    std::vector<u32> dirty_pages;
+    for (std::size_t offset = 0; offset < size; offset += PAGE_SIZE) {
+        if (std::memcmp(memory + offset, keyframe + offset, PAGE_SIZE) != 0) {
+            dirty_pages.push_back(static_cast<u32>(offset / PAGE_SIZE));
+        }
+    }
+    return dirty_pages;
+}
+
+template <class Archive>
+void SerializeFCRAMDelta(Archive& ar, u8* fcram, std::size_t fcram_size) {
+    const u8* keyframe = fcram_delta_keyframe.data;
+    if (keyframe == nullptr || fcram_delta_keyframe.size != fcram_size) {
+        throw std::runtime_error("FCRAM delta does not match the current keyframe");
+    }
+
+    std::vector<u32> dirty_pages;
+    if (Archive::is_saving::value) {
+        dirty_pages = FindDirtyPages(fcram, keyframe, fcram_size);
+    } else {
+        std::memcpy(fcram, keyframe, fcram_size);
+    }
+    ar& dirty_pages;
+    for (const u32 page : dirty_pages) {
+        if (page >= fcram_size / PAGE_SIZE) {
+            throw std::runtime_error("FCRAM delta contains an invalid page");
+        }
+        ar& boost::serialization::make_binary_object(fcram + page * PAGE_SIZE, PAGE_SIZE);
+    }
+}
+
+template void SerializeFCRAMDelta<iarchive>(iarchive& ar, u8* fcram, std::size_t fcram_size);
+template void SerializeFCRAMDelta<oarchive>(oarchive& ar, u8* fcram, std::size_t fcram_size);
+
+FCRAMDeltaScope::FCRAMDeltaScope(const u8* keyframe, std::size_t size) {
+    ASSERT_MSG(fcram_delta_keyframe.data == nullptr, "FCRAM delta scopes cannot be nested");
+    fcram_delta_keyframe = {keyframe, size};
+}
+
+FCRAMDeltaScope::~FCRAMDeltaScope() {
+    fcram_delta_keyframe = {};
+}
+
 } // namespace Memory
@@ -12,6 +12,7 @@
 #include <boost/serialization/array.hpp>
 #include <boost/serialization/vector.hpp>
 #include "common/common_types.h"
+#include "common/host_memory.h"
 #include "common/memory_ref.h"
 #include "core/mmio.h"
 
@@ -125,6 +126,13 @@ struct PageTable {
      */
     std::array<PageType, PAGE_TABLE_NUM_ENTRIES> attributes;
 
+    /**
+     * Host view of the address space used by the JIT for fastmem, created on demand by
+     * MemorySystem::GetFastmemBase. Only pages of type `Memory` backed by FCRAM, VRAM or the N3DS
+     * extra RAM are mapped in it, accesses to any other page fault.
+     */
+    std::unique_ptr<Common::HostMemory::View> fastmem;
+
     std::array<u8*, PAGE_TABLE_NUM_ENTRIES>& GetPointerArray() {
         return pointers.raw;
     }
@@ -327,6 +335,16 @@ public:
     void Write32(VAddr addr, u32 data);
     void Write64(VAddr addr, u64 data);
 
+    /**
+     * Writes data to addr if it still holds expected, atomically with respect to other writers.
+     * Used by the exclusive store instructions of cores that run in parallel.
+     * @returns Whether the value was written
+     */
+    bool WriteExclusive8(VAddr addr, u8 data, u8 expected);
+    bool WriteExclusive16(VAddr addr, u16 data, u16 expected);
+    bool WriteExclusive32(VAddr addr, u32 data, u32 expected);
+    bool WriteExclusive64(VAddr addr, u64 data, u64 expected);
+
     void ReadBlock(const Kernel::Process& process, VAddr src_addr, void* dest_buffer,
                    std::size_t size);
     void WriteBlock(const Kernel::Process& process, VAddr dest_addr, const void* src_buffer,
@@ -369,6 +387,12 @@ public:
      */
     void RasterizerMarkRegionCached(PAddr start, u32 size, bool cached);
 
+    /**
+     * Returns the base of the host view of the page table's address space, in which guest memory
+     * can be accessed directly at its virtual address. Returns nullptr if fastmem is unsupported.
+     */
+    u8* GetFastmemBase(PageTable& page_table);
+
     /// Registers page table for rasterizer cache marking
     void RegisterPageTable(std::shared_ptr<PageTable> page_table);
 
@@ -384,6 +408,9 @@ private:
     template <typename T>
     void Write(const VAddr vaddr, const T data);
 
+    template <typename T>
+    bool WriteExclusive(const VAddr vaddr, const T data, const T expected);
+
     /**
      * Gets the pointer for virtual memory where the page is marked as RasterizerCachedMemory.
      * This is used to access the memory where the page pointer is nullptr due to rasterizer cache.
@@ -394,6 +421,9 @@ private:
 
     void MapPages(PageTable& page_table, u32 base, u32 size, MemoryRef memory, PageType type);
 
+    /// Updates the fastmem view of the page table, if any, to match the given pages
+    void UpdateFastmem(PageTable& page_table, u32 base, u32 size);
+
     class Impl;
 
     std::unique_ptr<Impl> impl;
@@ -410,9 +440,47 @@ public:
 /// Determines if the given VAddr is valid for the specified process.
 bool IsValidVirtualAddress(const Kernel::Process& process, VAddr vaddr);
 
+/**
+ * Returns the indices of the pages whose contents differ between two equally sized memory regions.
+ * @param memory The current contents of the region
+ * @param keyframe The contents the region is compared against
+ * @param size The size of both regions in bytes, a multiple of PAGE_SIZE
+ */
+std::vector<u32> FindDirtyPages(const u8* memory, const u8* keyframe, std::size_t size);
+
+/**
+ * Saves or loads FCRAM as a delta to the keyframe of the FCRAMDeltaScope alive on this thread.
+ * Throws std::runtime_error if there is no such keyframe, or it doesn't match the FCRAM size.
+ * Instantiated for the iarchive and oarchive types.
+ * @param fcram The FCRAM contents to save, or to overwrite when loading
+ * @param fcram_size Size of FCRAM in bytes, a multiple of PAGE_SIZE
+ */
+template <class Archive>
+void SerializeFCRAMDelta(Archive& ar, u8* fcram, std::size_t fcram_size);
+
+/**
+ * While alive, makes MemorySystem serialization on the current thread store FCRAM as a delta to
+ * the given keyframe: saving only writes the pages whose contents differ from it, and loading
+ * restores all other pages from it. The keyframe has to stay unchanged while the scope is alive
+ * and must be the same one the delta was saved against when loading.
+ */
+class FCRAMDeltaScope {
+public:
+    /**
+     * @param keyframe Copy of FCRAM the delta is relative to
+     * @param size Size of the keyframe in bytes, FCRAM_SIZE or FCRAM_N3DS_SIZE
+     */
+    FCRAMDeltaScope(const u8* keyframe, std::size_t size);
+    ~FCRAMDeltaScope();
+
+    FCRAMDeltaScope(const FCRAMDeltaScope&) = delete;
+    FCRAMDeltaScope& operator=(const FCRAMDeltaScope&) = delete;
+};
+
 } // namespace Memory
 
 BOOST_CLASS_EXPORT_KEY(Memory::MemorySystem::BackingMemImpl<Memory::Region::FCRAM>)
 BOOST_CLASS_EXPORT_KEY(Memory::MemorySystem::BackingMemImpl<Memory::Region::VRAM>)
 BOOST_CLASS_EXPORT_KEY(Memory::MemorySystem::BackingMemImpl<Memory::Region::DSP>)
 BOOST_CLASS_EXPORT_KEY(Memory::MemorySystem::BackingMemImpl<Memory::Region::N3DS>)
+BOOST_CLASS_VERSION(Memory::MemorySystem::Impl, 1)
@@ -0,0 +1,197 @@
+// Copyright 2022 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <istream>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include "common/archives.h"
+#include "common/assert.h"
+#include "common/logging/log.h"
+#include "common/zstd_compression.h"
+#include "core/core.h"
+#include "core/core_timing.h"
+#include "core/memory.h"
+#include "core/rewind.h"
+#include "core/settings.h"
+#include "network/network.h"
+
+namespace Core {
+
+/// Snapshots are taken while emulation waits, so favour speed over ratio
+constexpr s32 RewindCompressionLevel = 1;
+
+RewindBuffer::RewindBuffer(std::size_t capacity, s64 interval_ticks)
+    : capacity(capacity), interval_ticks(interval_ticks) {
+    const std::size_t fcram_size =
+        Settings::values.is_new_3ds ? Memory::FCRAM_N3DS_SIZE : Memory::FCRAM_SIZE;
+    if (capacity <= fcram_size) {
+        LOG_WARNING(Core,
+                    "Rewind buffer of {} MiB leaves no room next to the {} MiB keyframe copy of "
+                    "FCRAM, only the latest snapshot will be kept",
+                    capacity / 1024 / 1024, fcram_size / 1024 / 1024);
+    }
+}
+
+RewindBuffer::~RewindBuffer() = default;
+
+void RewindBuffer::Update(System& system) {
+    const s64 ticks = system.CoreTiming().GetGlobalTicks();
+    if (ticks < next_snapshot_ticks) {
+        return;
+    }
+    next_snapshot_ticks = ticks + interval_ticks;
+
+    try {
+        Capture(system);
+    } catch (const std::exception& e) {
+        LOG_ERROR(Core, "Error taking rewind snapshot: {}", e.what());
+    }
+}
+
+bool RewindBuffer::Rewind(System& system) {
+    if (Network::GetRoomMember().lock()->IsConnected()) {
+        throw std::runtime_error("Unable to rewind while connected to multiplayer");
+    }
+    if (snapshots.empty()) {
+        return false;
+    }
+
+    const Snapshot snapshot = std::move(snapshots.back());
+    snapshots.pop_back();
+    total_size -= snapshot.data.size();
+
+    if (snapshot.is_keyframe) {
+        Restore(system, snapshot);
+        CopyKeyframe(system, snapshot.keyframe_id);
+        // The keyframe is gone from the buffer, so the next snapshot has to be a new one
+        keyframe_snapshots = 0;
+    } else {
+        if (snapshot.keyframe_id != keyframe_id) {
+            const auto keyframe =
+                std::find_if(snapshots.begin(), snapshots.end(), [&snapshot](const Snapshot& s) {
+                    return s.is_keyframe && s.keyframe_id == snapshot.keyframe_id;
+                });
+            ASSERT_MSG(keyframe != snapshots.end(), "Rewind snapshot without keyframe");
+            Restore(system, *keyframe);
+            CopyKeyframe(system, snapshot.keyframe_id);
+        }
+        Restore(system, snapshot);
+        keyframe_snapshots = static_cast<u32>(
+            std::count_if(snapshots.begin(), snapshots.end(),
+                          [this](const Snapshot& s) { return s.keyframe_id == keyframe_id; }));
+    }
+
+    next_snapshot_ticks = system.CoreTiming().GetGlobalTicks() + interval_ticks;
+    return true;
+}
+
+void RewindBuffer::Clear() {
+    snapshots.clear();
+    total_size = 0;
+    keyframe_fcram.clear();
+    keyframe_snapshots = 0;
+}
+
+void RewindBuffer::Capture(System& system) {
+    const auto start_time = std::chrono::steady_clock::now();
+
+    const std::size_t fcram_size =
+        Settings::values.is_new_3ds ? Memory::FCRAM_N3DS_SIZE : Memory::FCRAM_SIZE;
+    const bool is_keyframe = keyframe_snapshots == 0 ||
+                             keyframe_snapshots >= SnapshotsPerKeyframe ||
+                             keyframe_fcram.size() != fcram_size;
+
+    std::ostringstream stream;
+    {
+        std::optional<Memory::FCRAMDeltaScope> delta_scope;
+        if (!is_keyframe) {
+            delta_scope.emplace(keyframe_fcram.data(), keyframe_fcram.size());
+        }
+        oarchive oa{stream};
+        oa& system;
+    }
+    const std::string state = std::move(stream).str();
+
+    Snapshot snapshot{
+        .data = Common::Compression::CompressDataZSTD(reinterpret_cast<const u8*>(state.data()),
+                                                      state.size(), RewindCompressionLevel),
+        .keyframe_id = is_keyframe ? next_keyframe_id++ : keyframe_id,
+        .is_keyframe = is_keyframe,
+    };
+    if (snapshot.data.empty()) {
+        throw std::runtime_error("Could not compress rewind snapshot");
+    }
+
+    if (is_keyframe) {
+        CopyKeyframe(system, snapshot.keyframe_id);
+        keyframe_snapshots = 0;
+    }
+    keyframe_snapshots++;
+
+    LOG_DEBUG(Core, "Took rewind {} of {} bytes ({} compressed) in {} ms",
+              is_keyframe ? "keyframe" : "delta", state.size(), snapshot.data.size(),
+              std::chrono::duration_cast<std::chrono::milliseconds>(
+                  std::chrono::steady_clock::now() - start_time)
+                  .count());
+
+    total_size += snapshot.data.size();
+    snapshots.push_back(std::move(snapshot));
+    while (GetSize() > capacity && snapshots.size() > 1) {
+        DropOldest();
+    }
+}
+
+void RewindBuffer::Restore(System& system, const Snapshot& snapshot) {
+    std::size_t position = 0;
+    Common::Compression::ZSTDDecompressionStreamBuffer buffer{
+        [&snapshot, &position](u8* data, std::size_t size) {
+            const std::size_t count = std::min(size, snapshot.data.size() - position);
+            std::memcpy(data, snapshot.data.data() + position, count);
+            position += count;
+            return count;
+        }};
+    std::istream stream{&buffer};
+
+    {
+        std::optional<Memory::FCRAMDeltaScope> delta_scope;
+        if (!snapshot.is_keyframe) {
+            delta_scope.emplace(keyframe_fcram.data(), keyframe_fcram.size());
+        }
+        iarchive ia{stream};
+        ia& system;
+    }
+
+    if (buffer.HasError()) {
+        throw std::runtime_error("Could not decompress rewind snapshot");
+    }
+}
+
+void RewindBuffer::CopyKeyframe(System& system, u64 id) {
+    const std::size_t fcram_size =
+        Settings::values.is_new_3ds ? Memory::FCRAM_N3DS_SIZE : Memory::FCRAM_SIZE;
+    const u8* fcram = system.Memory().GetFCRAMPointer(0);
+    keyframe_fcram.assign(fcram, fcram + fcram_size);
+    keyframe_id = id;
+}
+
+void RewindBuffer::DropOldest() {
+    const u64 oldest_keyframe = snapshots.front().keyframe_id;
+    if (snapshots.back().keyframe_id != oldest_keyframe) {
+        // Deltas cannot be restored without their keyframe, so the whole group goes at once
+        while (snapshots.front().keyframe_id == oldest_keyframe) {
+            total_size -= snapshots.front().data.size();
+            snapshots.pop_front();
+        }
+    } else {
+        // Only the current keyframe is left, which new deltas still depend on
+        total_size -= snapshots[1].data.size();
+        snapshots.erase(snapshots.begin() + 1);
+    }
+}
+
+} // namespace Core
@@ -0,0 +1,87 @@
+// Copyright 2022 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include <deque>
+#include <vector>
+#include "common/common_types.h"
+
+namespace Core {
+
+class System;
+
+/**
+ * Ring buffer of compressed in-memory snapshots of the emulated system, taken at a fixed interval
+ * of emulated time, which emulation can be rewound to. Every few snapshots a keyframe holding the
+ * full state is taken; the snapshots in between store FCRAM only as the pages which differ from
+ * the FCRAM of their keyframe, so an uncompressed copy of the current keyframe's FCRAM is kept as
+ * well. The oldest snapshots are dropped once the buffer grows beyond its capacity.
+ */
+class RewindBuffer {
+public:
+    /// Number of snapshots sharing the FCRAM of one keyframe, including the keyframe itself
+    static constexpr u32 SnapshotsPerKeyframe = 30;
+
+    /**
+     * @param capacity Maximum memory held by the buffer in bytes, counting both the compressed
+     *                 snapshots and the FCRAM copy of the current keyframe
+     * @param interval_ticks Emulated ticks between two snapshots
+     */
+    RewindBuffer(std::size_t capacity, s64 interval_ticks);
+    ~RewindBuffer();
+
+    /// Takes a snapshot if the interval has passed since the previous one
+    void Update(System& system);
+
+    /**
+     * Restores the most recent snapshot and drops it, so that repeated calls step further back.
+     * @returns false if there is no snapshot to rewind to
+     */
+    bool Rewind(System& system);
+
+    /// Drops all snapshots
+    void Clear();
+
+    std::size_t GetSnapshotCount() const {
+        return snapshots.size();
+    }
+
+    /// Returns the memory held by the compressed snapshots and the keyframe FCRAM copy in bytes
+    std::size_t GetSize() const {
+        return total_size + keyframe_fcram.size();
+    }
+
+private:
+    struct Snapshot {
+        /// Zstandard compressed serialized system state
+        std::vector<u8> data;
+        /// Keyframe the FCRAM delta is relative to, the snapshot's own id for keyframes
+        u64 keyframe_id;
+        bool is_keyframe;
+    };
+
+    void Capture(System& system);
+    void Restore(System& system, const Snapshot& snapshot);
+    void CopyKeyframe(System& system, u64 id);
+    void DropOldest();
+
+    std::deque<Snapshot> snapshots;
+    std::size_t capacity;
+    /// Total size of the compressed snapshots
+    std::size_t total_size = 0;
+
+    s64 interval_ticks;
+    s64 next_snapshot_ticks = 0;
+
+    /// FCRAM contents of the keyframe which new deltas are taken against
+    std::vector<u8> keyframe_fcram;
+    u64 keyframe_id = 0;
+    u64 next_keyframe_id = 1;
+    /// Snapshots taken against the current keyframe, including the keyframe itself
+    u32 keyframe_snapshots = 0;
+};
+
+} // namespace Core
@@ -3,16 +3,23 @@
 // Refer to the license.txt file included.
 
 #include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <ostream>
+#include <sstream>
 #include <boost/serialization/binary_object.hpp>
 #include <cryptopp/hex.h>
 #include "common/archives.h"
+#include "common/file_util.h"
 #include "common/logging/log.h"
 #include "common/scm_rev.h"
-#include "common/zstd_compression.h"
+#include "common/thread_worker.h"
 #include "core/cheats/cheats.h"
 #include "core/core.h"
 #include "core/movie.h"
 #include "core/savestate.h"
+#include "core/savestate_stream.h"
 #include "network/network.h"
 #include "video_core/video_core.h"
 
@@ -24,8 +31,10 @@ struct CSTHeader {
     u64_le program_id;           /// ID of the ROM being executed. Also called title_id
     std::array<u8, 20> revision; /// Git hash of the revision this savestate was created with
     u64_le time;                 /// The time when this save state was created
+    /// Size of the serialized data, written last. 0 in save states of older versions
+    u64_le uncompressed_size;
 
-    std::array<u8, 216> reserved; /// Make heading 256 bytes so it has consistent size
+    std::array<u8, 208> reserved; /// Make heading 256 bytes so it has consistent size
 
     template <class Archive>
     void serialize(Archive& ar, const unsigned int) {
@@ -50,6 +59,9 @@ std::string GetSaveStatePath(u64 program_id, u32 slot) {
 }
 
 std::vector<SaveStateInfo> ListSaveStates(u64 program_id) {
+    // Make sure states still being written show up
+    System::GetInstance().WaitForPendingSaveStates();
+
     std::vector<SaveStateInfo> result;
     for (u32 slot = 1; slot <= SaveStateSlotCount; ++slot) {
         const auto path = GetSaveStatePath(program_id, slot);
@@ -97,24 +109,27 @@ std::vector<SaveStateInfo> ListSaveStates(u64 program_id) {
     return result;
 }
 
+void System::WaitForPendingSaveStates() const {
+    if (save_state_workers) {
+        save_state_workers->WaitForRequests();
+    }
+}
+
 void System::SaveState(u32 slot) const {
-    std::ostringstream sstream{std::ios_base::binary};
-    // Serialize
-    oarchive oa{sstream};
-    oa&* this;
+    // A previous save to the same slot might still be in progress
+    WaitForPendingSaveStates();
 
-    const std::string& str{sstream.str()};
-    auto buffer = Common::Compression::CompressDataZSTDDefault(
-        reinterpret_cast<const u8*>(str.data()), str.size());
+    const auto start_time = std::chrono::steady_clock::now();
 
     const auto path = GetSaveStatePath(title_id, slot);
     if (!FileUtil::CreateFullPath(path)) {
         throw std::runtime_error("Could not create path " + path);
     }
 
-    FileUtil::IOFile file(path, "wb");
+    const auto temp_path = path + ".tmp";
+    FileUtil::IOFile file(temp_path, "wb");
     if (!file) {
-        throw std::runtime_error("Could not open file " + path);
+        throw std::runtime_error("Could not open file " + temp_path);
     }
 
     CSTHeader header{};
@@ -128,10 +143,33 @@ void System::SaveState(u32 slot) const {
                       std::chrono::system_clock::now().time_since_epoch())
                       .count();
 
-    if (file.WriteBytes(&header, sizeof(header)) != sizeof(header) ||
-        file.WriteBytes(buffer.data(), buffer.size()) != buffer.size()) {
-        throw std::runtime_error("Could not write to file " + path);
+    if (file.WriteBytes(&header, sizeof(header)) != sizeof(header)) {
+        file.Close();
+        FileUtil::Delete(temp_path);
+        throw std::runtime_error("Could not write to file " + temp_path);
+    }
+
+    // Chunks are compressed and written in the background while serialization goes on
+    auto writer =
+        std::make_shared<SaveStateWriter>(*save_state_workers, path, temp_path, std::move(file),
+                                          offsetof(CSTHeader, uncompressed_size));
+    ChunkStreamBuffer buffer{
+        [&writer](std::vector<u8> chunk) { writer->AddChunk(std::move(chunk)); }};
+    try {
+        std::ostream stream{&buffer};
+        // Serialize
+        oarchive oa{stream};
+        oa&* this;
+    } catch (...) {
+        writer->Finish(false);
+        throw;
     }
+    buffer.Finish();
+    writer->Finish(true);
+
+    const auto stall_time = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start_time);
+    LOG_INFO(Core, "Serialized save state in {} ms", stall_time.count());
 }
 
 void System::LoadState(u32 slot) {
@@ -139,26 +177,25 @@ void System::LoadState(u32 slot) {
         throw std::runtime_error("Unable to load while connected to multiplayer");
     }
 
-    const auto path = GetSaveStatePath(title_id, slot);
+    WaitForPendingSaveStates();
 
-    std::vector<u8> decompressed;
-    {
-        std::vector<u8> buffer(FileUtil::GetSize(path) - sizeof(CSTHeader));
+    const auto path = GetSaveStatePath(title_id, slot);
 
-        FileUtil::IOFile file(path, "rb");
-        file.Seek(sizeof(CSTHeader), SEEK_SET); // Skip header
-        if (file.ReadBytes(buffer.data(), buffer.size()) != buffer.size()) {
-            throw std::runtime_error("Could not read from file at " + path);
-        }
-        decompressed = Common::Compression::DecompressDataZSTD(buffer);
+    FileUtil::IOFile file(path, "rb");
+    CSTHeader header;
+    if (!file || file.ReadBytes(&header, sizeof(header)) != sizeof(header)) {
+        throw std::runtime_error("Could not read from file at " + path);
     }
-    std::istringstream sstream{
-        std::string{reinterpret_cast<char*>(decompressed.data()), decompressed.size()},
-        std::ios_base::binary};
-    decompressed.clear();
+
+    // Nothing is deserialized before the whole file has been decompressed and checked, so that a
+    // damaged file leaves the system untouched
+    std::string data = DecompressSaveState(
+        [&file](u8* buffer, std::size_t size) { return file.ReadBytes(buffer, size); },
+        header.uncompressed_size);
+    std::istringstream stream{std::move(data), std::ios_base::binary};
 
     // Deserialize
-    iarchive ia{sstream};
+    iarchive ia{stream};
     ia&* this;
 }
 
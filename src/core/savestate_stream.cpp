@@ -0,0 +1,171 @@
+// Copyright 2022 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <stdexcept>
+#include "common/logging/log.h"
+#include "common/swap.h"
+#include "common/thread_worker.h"
+#include "core/savestate_stream.h"
+
+namespace Core {
+
+ChunkStreamBuffer::ChunkStreamBuffer(ChunkHandler handler_, std::size_t chunk_size_)
+    : handler(std::move(handler_)), chunk_size(chunk_size_) {
+    StartChunk();
+}
+
+void ChunkStreamBuffer::Finish() {
+    EmitChunk();
+}
+
+ChunkStreamBuffer::int_type ChunkStreamBuffer::overflow(int_type c) {
+    EmitChunk();
+    if (!traits_type::eq_int_type(c, traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(c);
+        pbump(1);
+    }
+    return traits_type::not_eof(c);
+}
+
+void ChunkStreamBuffer::StartChunk() {
+    chunk.resize(chunk_size);
+    char* begin = reinterpret_cast<char*>(chunk.data());
+    setp(begin, begin + chunk.size());
+}
+
+void ChunkStreamBuffer::EmitChunk() {
+    const auto size = static_cast<std::size_t>(pptr() - pbase());
+    if (size == 0) {
+        return;
+    }
+    chunk.resize(size);
+    handler(std::move(chunk));
+    chunk = {};
+    StartChunk();
+}
+
+SaveStateWriter::SaveStateWriter(Common::ThreadWorker& workers_, std::string path_,
+                                 std::string temp_path_, FileUtil::IOFile file_,
+                                 std::size_t size_offset_)
+    : workers(workers_), path(std::move(path_)), temp_path(std::move(temp_path_)),
+      file(std::move(file_)), size_offset(size_offset_),
+      start_time(std::chrono::steady_clock::now()) {}
+
+void SaveStateWriter::AddChunk(std::vector<u8> chunk) {
+    std::size_t index;
+    {
+        std::unique_lock lock{mutex};
+        chunk_written.wait(lock, [this] {
+            return num_chunks - num_chunks_written < MaxSaveStateChunksInFlight;
+        });
+        index = num_chunks++;
+        uncompressed_size += chunk.size();
+        buffered_size += chunk.size();
+        peak_buffered_size = std::max(peak_buffered_size, buffered_size);
+    }
+
+    workers.QueueWork([writer = shared_from_this(), index, chunk = std::move(chunk)] {
+        writer->CompressChunk(index, chunk);
+    });
+}
+
+void SaveStateWriter::Finish(bool success) {
+    std::unique_lock lock{mutex};
+    finished = true;
+    failed |= !success;
+    if (num_chunks_written == num_chunks) {
+        Complete();
+    }
+}
+
+void SaveStateWriter::CompressChunk(std::size_t index, const std::vector<u8>& chunk) {
+    auto compressed = Common::Compression::CompressDataZSTDDefault(chunk.data(), chunk.size());
+
+    std::unique_lock lock{mutex};
+    if (compressed.empty()) {
+        LOG_ERROR(Core, "Could not compress save state chunk {}", index);
+        failed = true;
+    }
+    buffered_size = buffered_size - chunk.size() + compressed.size();
+    compressed_chunks.emplace(index, std::move(compressed));
+
+    // Write all chunks up to the first one still being compressed
+    for (auto it = compressed_chunks.begin();
+         it != compressed_chunks.end() && it->first == num_chunks_written;
+         it = compressed_chunks.erase(it)) {
+        const auto& data = it->second;
+        if (!failed && file.WriteBytes(data.data(), data.size()) != data.size()) {
+            LOG_ERROR(Core, "Could not write to file {}", temp_path);
+            failed = true;
+        }
+        compressed_size += data.size();
+        buffered_size -= data.size();
+        ++num_chunks_written;
+    }
+    chunk_written.notify_all();
+
+    if (finished && num_chunks_written == num_chunks) {
+        Complete();
+    }
+}
+
+void SaveStateWriter::Complete() {
+    // The size is only recorded once everything else is written, a file cut short keeps a size
+    // that doesn't match its contents
+    const u64_le size = uncompressed_size;
+    if (!failed && (!file.Seek(static_cast<s64>(size_offset), SEEK_SET) ||
+                    file.WriteBytes(&size, sizeof(size)) != sizeof(size))) {
+        LOG_ERROR(Core, "Could not write to file {}", temp_path);
+        failed = true;
+    }
+    // Closing flushes the file, which may fail as well
+    if (!file.Close()) {
+        failed = true;
+    }
+    // The previous save state is replaced in a single step, it is kept if anything goes wrong
+    if (failed || !FileUtil::Replace(temp_path, path)) {
+        LOG_ERROR(Core, "Failed to save state to {}", path);
+        FileUtil::Delete(temp_path);
+        return;
+    }
+
+    constexpr double MiB = 1024.0 * 1024.0;
+    const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start_time);
+    LOG_INFO(Core,
+             "Saved state to {} in {} ms: {:.1f} MiB compressed to {:.1f} MiB, "
+             "{:.1f} MiB buffered at peak",
+             path, elapsed.count(), uncompressed_size / MiB, compressed_size / MiB,
+             peak_buffered_size / MiB);
+}
+
+std::string DecompressSaveState(
+    const Common::Compression::ZSTDDecompressionStreamBuffer::ReadFunction& read,
+    u64 expected_size) {
+    Common::Compression::ZSTDDecompressionStreamBuffer buffer{read};
+    std::string data;
+    data.reserve(expected_size);
+
+    std::vector<char> block(1024 * 1024);
+    while (true) {
+        const auto read_size = static_cast<std::size_t>(buffer.sgetn(block.data(), block.size()));
+        if (read_size == 0) {
+            break;
+        }
+        data.append(block.data(), read_size);
+        if (expected_size != 0 && data.size() > expected_size) {
+            throw std::runtime_error("Save state is larger than recorded");
+        }
+    }
+    if (buffer.HasError()) {
+        throw std::runtime_error("Save state is malformed or truncated");
+    }
+    if (expected_size != 0 && data.size() != expected_size) {
+        throw std::runtime_error("Save state is truncated");
+    }
+    return data;
+}
+
+} // namespace Core
@@ -0,0 +1,115 @@
+// Copyright 2022 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <streambuf>
+#include <string>
+#include <vector>
+#include "common/common_types.h"
+#include "common/file_util.h"
+#include "common/zstd_compression.h"
+
+namespace Common {
+class ThreadWorker;
+}
+
+namespace Core {
+
+/// Size of the chunks save states are serialized and compressed in
+constexpr std::size_t SaveStateChunkSize = 4 * 1024 * 1024;
+
+/// Number of chunks which may wait for compression or writing before serialization blocks
+constexpr std::size_t MaxSaveStateChunksInFlight = 16;
+
+/// Stream buffer handing off the data written to it in chunks of a fixed size
+class ChunkStreamBuffer final : public std::streambuf {
+public:
+    using ChunkHandler = std::function<void(std::vector<u8> chunk)>;
+
+    explicit ChunkStreamBuffer(ChunkHandler handler, std::size_t chunk_size = SaveStateChunkSize);
+
+    /// Hands off the last, partially filled chunk
+    void Finish();
+
+protected:
+    int_type overflow(int_type c) override;
+
+private:
+    void StartChunk();
+    void EmitChunk();
+
+    ChunkHandler handler;
+    const std::size_t chunk_size;
+    std::vector<u8> chunk;
+};
+
+/**
+ * Compresses the chunks of a save state on worker threads, each chunk into its own Zstandard
+ * frame, and writes the frames to disk in order as soon as they are ready. The file is written
+ * under a temporary name and only replaces the previous save state once it is complete.
+ */
+class SaveStateWriter : public std::enable_shared_from_this<SaveStateWriter> {
+public:
+    /**
+     * @param file Temporary file, positioned where the first frame goes
+     * @param size_offset Offset in the file of the u64 which receives the uncompressed size of the
+     * save state once all chunks have been written
+     */
+    SaveStateWriter(Common::ThreadWorker& workers, std::string path, std::string temp_path,
+                    FileUtil::IOFile file, std::size_t size_offset);
+
+    /// Queues a chunk for compression, blocking while too many chunks are in flight
+    void AddChunk(std::vector<u8> chunk);
+
+    /**
+     * Marks the end of the save state, completing it once all chunks have been written.
+     * @param success Whether serialization succeeded, otherwise the file is discarded
+     */
+    void Finish(bool success);
+
+private:
+    void CompressChunk(std::size_t index, const std::vector<u8>& chunk);
+
+    /// Closes the file and moves it into place, called with the mutex held
+    void Complete();
+
+    Common::ThreadWorker& workers;
+    const std::string path;
+    const std::string temp_path;
+    FileUtil::IOFile file;
+    const std::size_t size_offset;
+    const std::chrono::steady_clock::time_point start_time;
+
+    std::mutex mutex;
+    std::condition_variable chunk_written;
+    /// Compressed chunks waiting for the chunks before them to be written
+    std::map<std::size_t, std::vector<u8>> compressed_chunks;
+    std::size_t num_chunks = 0;
+    std::size_t num_chunks_written = 0;
+    bool finished = false;
+    bool failed = false;
+
+    std::size_t uncompressed_size = 0;
+    std::size_t compressed_size = 0;
+    std::size_t buffered_size = 0; ///< Bytes of chunks which haven't been written yet
+    std::size_t peak_buffered_size = 0;
+};
+
+/**
+ * Decompresses the frames of a save state completely, so that nothing is deserialized from a
+ * damaged file. Throws std::runtime_error if the data is malformed or truncated.
+ * @param expected_size Uncompressed size recorded by SaveStateWriter, or 0 if it is unknown
+ */
+std::string DecompressSaveState(
+    const Common::Compression::ZSTDDecompressionStreamBuffer::ReadFunction& read,
+    u64 expected_size);
+
+} // namespace Core
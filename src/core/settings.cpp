@@ -26,7 +26,8 @@ void Apply() {
     GDBStub::SetServerPort(values.gdbstub_port);
     GDBStub::ToggleServer(values.use_gdbstub);
 
-    VideoCore::g_hw_renderer_enabled = values.use_hw_renderer;
+    VideoCore::g_hw_renderer_enabled =
+        values.use_hw_renderer && values.graphics_api == GraphicsAPI::OpenGL;
     VideoCore::g_shader_jit_enabled = values.use_shader_jit;
     VideoCore::g_hw_shader_enabled = values.use_hw_shader;
     VideoCore::g_separable_shader_enabled = values.separable_shader;
@@ -79,13 +80,22 @@ void LogSettings() {
 
     LOG_INFO(Config, "Citra Configuration:");
     log_setting("Core_UseCpuJit", values.use_cpu_jit);
+    log_setting("Core_UseFastmem", values.use_fastmem);
+    log_setting("Core_UseCpuThreads", values.use_cpu_threads);
+    log_setting("Core_SkipIdleLoops", values.skip_idle_loops);
     log_setting("Core_CPUClockPercentage", values.cpu_clock_percentage);
+    log_setting("Core_RewindInterval", values.rewind_interval);
+    log_setting("Core_RewindBufferSize", values.rewind_buffer_size);
+    log_setting("Renderer_GraphicsAPI", static_cast<u32>(values.graphics_api));
     log_setting("Renderer_UseGLES", values.use_gles);
     log_setting("Renderer_UseHwRenderer", values.use_hw_renderer);
     log_setting("Renderer_UseHwShader", values.use_hw_shader);
     log_setting("Renderer_SeparableShader", values.separable_shader);
     log_setting("Renderer_ShadersAccurateMul", values.shaders_accurate_mul);
     log_setting("Renderer_UseShaderJit", values.use_shader_jit);
+    log_setting("Renderer_SwRasterizerThreads", values.sw_rasterizer_threads);
+    log_setting("Renderer_VertexShaderThreads", values.vertex_shader_threads);
+    log_setting("Renderer_UseAsyncGpu", values.use_async_gpu);
     log_setting("Renderer_UseResolutionFactor", values.resolution_factor);
     log_setting("Renderer_FrameLimit", values.frame_limit);
     log_setting("Renderer_UseFrameLimitAlternate", values.use_frame_limit_alternate);
@@ -104,6 +114,7 @@ void LogSettings() {
     log_setting("Utility_UseDiskShaderCache", values.use_disk_shader_cache);
     log_setting("Audio_EnableDspLle", values.enable_dsp_lle);
     log_setting("Audio_EnableDspLleMultithread", values.enable_dsp_lle_multithread);
+    log_setting("Audio_SourceThreads", values.audio_source_threads);
     log_setting("Audio_OutputEngine", values.sink_id);
     log_setting("Audio_EnableAudioStretching", values.enable_audio_stretching);
     log_setting("Audio_OutputDevice", values.audio_device_id);
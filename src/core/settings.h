@@ -19,6 +19,11 @@ enum class InitClock {
     FixedTime = 1,
 };
 
+enum class GraphicsAPI {
+    OpenGL = 0,
+    Software = 1,
+};
+
 enum class LayoutOption {
     Default,
     SingleScreen,
@@ -151,7 +156,12 @@ struct Values {
 
     // Core
     bool use_cpu_jit;
+    bool use_fastmem;
+    bool use_cpu_threads;
+    bool skip_idle_loops;
     int cpu_clock_percentage;
+    u16 rewind_interval;
+    u16 rewind_buffer_size;
 
     // Data Storage
     bool use_virtual_sd;
@@ -162,6 +172,7 @@ struct Values {
     u64 init_time;
 
     // Renderer
+    GraphicsAPI graphics_api;
     bool use_gles;
     bool use_hw_renderer;
     bool use_hw_shader;
@@ -169,6 +180,9 @@ struct Values {
     bool use_disk_shader_cache;
     bool shaders_accurate_mul;
     bool use_shader_jit;
+    u16 sw_rasterizer_threads;
+    u16 vertex_shader_threads;
+    bool use_async_gpu;
     u16 resolution_factor;
     bool use_frame_limit_alternate;
     u16 frame_limit;
@@ -211,6 +225,7 @@ struct Values {
     // Audio
     bool enable_dsp_lle;
     bool enable_dsp_lle_multithread;
+    u16 audio_source_threads;
     std::string sink_id;
     bool enable_audio_stretching;
     std::string audio_device_id;
@@ -0,0 +1,245 @@
+// Copyright 2022 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <array>
+#include <random>
+#include <vector>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include "audio_core/audio_kernels.h"
+
+using namespace AudioCore;
+using Kernels::Sample;
+
+namespace {
+
+// Reference implementations, these are the per-sample loops the kernels replaced
+
+/// Rounds a product to float, so that the compiler can't fuse it into a multiply-add
+float Rounded(float value) {
+    volatile float rounded = value;
+    return rounded;
+}
+
+s16 ClampToS16(s32 value) {
+    return static_cast<s16>(std::clamp(value, -32768, 32767));
+}
+
+std::array<s16, 2> AddAndClampToS16(const std::array<s16, 2>& a, const std::array<s16, 2>& b) {
+    return {ClampToS16(static_cast<s32>(a[0]) + static_cast<s32>(b[0])),
+            ClampToS16(static_cast<s32>(a[1]) + static_cast<s32>(b[1]))};
+}
+
+std::vector<Sample> WidenPCM8Reference(const std::vector<u8>& data, std::size_t num_channels) {
+    const auto decode_sample = [](u8 sample) {
+        return static_cast<s16>(static_cast<u16>(sample) << 8);
+    };
+    std::vector<Sample> output(data.size() / num_channels);
+    for (std::size_t i = 0; i < output.size(); i++) {
+        output[i][0] = decode_sample(data[i * num_channels]);
+        output[i][1] = decode_sample(data[i * num_channels + num_channels - 1]);
+    }
+    return output;
+}
+
+std::vector<Sample> InterpolateLinearReference(const std::vector<Sample>& input, u64 position,
+                                               u64 step, std::size_t count) {
+    constexpr u64 scale_factor = 1 << 24;
+    std::vector<Sample> output;
+    for (std::size_t i = 0; i < count; ++i, position += step) {
+        const Sample& x0 = input[position / scale_factor];
+        const Sample& x1 = input[position / scale_factor + 1];
+        const u64 fraction = position & (scale_factor - 1);
+        const s64 delta0 = std::clamp<s64>(x1[0] - x0[0], -32768, 32767);
+        const s64 delta1 = std::clamp<s64>(x1[1] - x0[1], -32768, 32767);
+        output.push_back({
+            static_cast<s16>(x0[0] + fraction * delta0 / scale_factor),
+            static_cast<s16>(x0[1] + fraction * delta1 / scale_factor),
+        });
+    }
+    return output;
+}
+
+void MixIntoQuadReference(const StereoFrame16& input, const std::array<float, 4>& gains,
+                          QuadFrame32& dest) {
+    for (std::size_t i = 0; i < samples_per_frame; i++) {
+        dest[i][0] += static_cast<s32>(gains[0] * input[i][0]);
+        dest[i][1] += static_cast<s32>(gains[1] * input[i][1]);
+        dest[i][2] += static_cast<s32>(gains[2] * input[i][0]);
+        dest[i][3] += static_cast<s32>(gains[3] * input[i][1]);
+    }
+}
+
+void DownmixReference(const QuadFrame32& input, float gain, bool mono, StereoFrame16& dest) {
+    for (std::size_t i = 0; i < samples_per_frame; i++) {
+        const auto& sample = input[i];
+        if (mono) {
+            const s16 value = ClampToS16(static_cast<s32>(
+                (Rounded(Rounded(Rounded(gain * sample[0]) + Rounded(gain * sample[1])) +
+                         Rounded(gain * sample[2])) +
+                 Rounded(gain * sample[3])) /
+                2));
+            dest[i] = AddAndClampToS16(dest[i], {value, value});
+        } else {
+            const s16 left = ClampToS16(
+                static_cast<s32>(Rounded(gain * sample[0]) + Rounded(gain * sample[2])));
+            const s16 right = ClampToS16(
+                static_cast<s32>(Rounded(gain * sample[1]) + Rounded(gain * sample[3])));
+            dest[i] = AddAndClampToS16(dest[i], {left, right});
+        }
+    }
+}
+
+/// Random samples biased towards the extremes, where saturation and rounding go wrong
+s16 RandomSample(std::mt19937& rng) {
+    switch (rng() % 4) {
+    case 0:
+        return static_cast<s16>(rng() % 2 ? 32767 - rng() % 16 : -32768 + rng() % 16);
+    case 1:
+        return static_cast<s16>(static_cast<s32>(rng() % 64) - 32);
+    default:
+        return static_cast<s16>(rng());
+    }
+}
+
+StereoFrame16 RandomStereoFrame(std::mt19937& rng) {
+    StereoFrame16 frame;
+    for (auto& sample : frame) {
+        sample = {RandomSample(rng), RandomSample(rng)};
+    }
+    return frame;
+}
+
+/// Random quadraphonic samples, small enough that four of them with gain fit into s32
+QuadFrame32 RandomQuadFrame(std::mt19937& rng) {
+    QuadFrame32 frame;
+    for (auto& sample : frame) {
+        for (s32& channel : sample) {
+            channel = static_cast<s32>(rng()) >> (3 + rng() % 20);
+        }
+    }
+    return frame;
+}
+
+} // Anonymous namespace
+
+TEST_CASE("Audio kernels widen PCM8 and PCM16", "[audio_core]") {
+    std::mt19937 rng(1);
+    for (const std::size_t count : {0, 1, 7, 15, 16, 17, 100, 1001}) {
+        std::vector<u8> data(count * 2);
+        std::generate(data.begin(), data.end(), [&rng] { return static_cast<u8>(rng()); });
+
+        std::vector<Sample> output(count);
+        Kernels::WidenPCM8Stereo(data.data(), count, output.data());
+        REQUIRE(output == WidenPCM8Reference(data, 2));
+
+        const std::vector<u8> mono(data.begin(), data.begin() + count);
+        Kernels::WidenPCM8Mono(mono.data(), count, output.data());
+        REQUIRE(output == WidenPCM8Reference(mono, 1));
+
+        Kernels::WidenPCM16Mono(data.data(), count, output.data());
+        for (std::size_t i = 0; i < count; ++i) {
+            const s16 sample = static_cast<s16>(data[i * 2] | (data[i * 2 + 1] << 8));
+            REQUIRE(output[i][0] == sample);
+            REQUIRE(output[i][1] == sample);
+        }
+    }
+}
+
+TEST_CASE("Audio kernels interpolate like the scalar code", "[audio_core]") {
+    std::mt19937 rng(2);
+    std::vector<Sample> input(2048);
+    for (Sample& sample : input) {
+        sample = {RandomSample(rng), RandomSample(rng)};
+    }
+
+    for (int run = 0; run < 200; ++run) {
+        const u64 step = rng() % (4ULL << 24);
+        const u64 position = rng() % (16ULL << 24);
+        const std::size_t count = 1 + rng() % 160;
+        if (((position + step * count) >> 24) + 1 >= input.size()) {
+            continue;
+        }
+
+        std::vector<Sample> output(count);
+        Kernels::InterpolateLinear(input.data(), position, step, output.data(), count);
+        REQUIRE(output == InterpolateLinearReference(input, position, step, count));
+
+        Kernels::InterpolateNone(input.data(), position, step, output.data(), count);
+        for (std::size_t i = 0; i < count; ++i) {
+            REQUIRE(output[i] == input[(position + i * step) >> 24]);
+        }
+    }
+}
+
+TEST_CASE("Audio kernels mix like the scalar code", "[audio_core]") {
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<float> gain_distribution(-2.0f, 2.0f);
+    for (int run = 0; run < 100; ++run) {
+        const float gain = gain_distribution(rng);
+        const std::array<float, 4> gains{gain_distribution(rng), gain_distribution(rng),
+                                         gain_distribution(rng), gain_distribution(rng)};
+
+        const StereoFrame16 stereo = RandomStereoFrame(rng);
+        QuadFrame32 quad = RandomQuadFrame(rng);
+        QuadFrame32 expected_quad = quad;
+        Kernels::MixIntoQuad(stereo, gains, quad);
+        MixIntoQuadReference(stereo, gains, expected_quad);
+        REQUIRE(quad == expected_quad);
+
+        for (const bool mono : {false, true}) {
+            StereoFrame16 mixed = RandomStereoFrame(rng);
+            StereoFrame16 expected_mixed = mixed;
+            if (mono) {
+                Kernels::DownmixMono(quad, gain, mixed);
+            } else {
+                Kernels::DownmixStereo(quad, gain, mixed);
+            }
+            DownmixReference(quad, gain, mono, expected_mixed);
+            REQUIRE(mixed == expected_mixed);
+        }
+    }
+}
+
+TEST_CASE("Audio kernels performance", "[.benchmark][audio_core]") {
+    std::mt19937 rng(4);
+    const StereoFrame16 stereo = RandomStereoFrame(rng);
+    const QuadFrame32 quad = RandomQuadFrame(rng);
+    const std::array<float, 4> gains{0.5f, 0.25f, 0.75f, 1.0f};
+    std::vector<Sample> input(samples_per_frame * 2);
+    for (Sample& sample : input) {
+        sample = {RandomSample(rng), RandomSample(rng)};
+    }
+    constexpr u64 step = (1ULL << 24) * 3 / 2;
+
+    BENCHMARK("interpolate linear") {
+        std::vector<Sample> output(samples_per_frame);
+        Kernels::InterpolateLinear(input.data(), 0, step, output.data(), output.size());
+        return output[0];
+    };
+    BENCHMARK("interpolate linear reference") {
+        return InterpolateLinearReference(input, 0, step, samples_per_frame)[0];
+    };
+    BENCHMARK("mix into quad") {
+        QuadFrame32 dest{};
+        Kernels::MixIntoQuad(stereo, gains, dest);
+        return dest[0];
+    };
+    BENCHMARK("mix into quad reference") {
+        QuadFrame32 dest{};
+        MixIntoQuadReference(stereo, gains, dest);
+        return dest[0];
+    };
+    BENCHMARK("downmix stereo") {
+        StereoFrame16 dest{};
+        Kernels::DownmixStereo(quad, 0.5f, dest);
+        return dest[0];
+    };
+    BENCHMARK("downmix stereo reference") {
+        StereoFrame16 dest{};
+        DownmixReference(quad, 0.5f, false, dest);
+        return dest[0];
+    };
+}
@@ -0,0 +1,117 @@
+// Copyright 2022 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <array>
+#include <cstring>
+#include <memory>
+#include <vector>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include "audio_core/hle/shared_memory.h"
+#include "audio_core/hle/source.h"
+#include "core/memory.h"
+
+using AudioCore::HLE::Source;
+using Configuration = AudioCore::HLE::SourceConfiguration::Configuration;
+
+namespace {
+
+constexpr s16_le NO_ADPCM_COEFFS[16]{};
+
+/// Configures a source to play a looping embedded buffer at FCRAM offset
+Configuration MakeConfig(std::size_t offset, u32 length, Configuration::Format format,
+                         Configuration::MonoOrStereo mono_or_stereo, float rate,
+                         Configuration::InterpolationMode interpolation_mode) {
+    Configuration config;
+    std::memset(&config, 0, sizeof(config));
+    config.enable = 1;
+    config.enable_dirty.Assign(1);
+    config.rate_multiplier = rate;
+    config.rate_multiplier_dirty.Assign(1);
+    config.interpolation_mode = interpolation_mode;
+    config.interpolation_dirty.Assign(1);
+    config.gain[0][0] = 1.0f;
+    config.gain[0][1] = 1.0f;
+    config.gain_0_dirty.Assign(1);
+    config.physical_address = static_cast<u32>(Memory::FCRAM_PADDR + offset);
+    config.length = length;
+    config.format.Assign(format);
+    config.mono_or_stereo.Assign(mono_or_stereo);
+    config.is_looping.Assign(1);
+    config.embedded_buffer_dirty.Assign(1);
+    return config;
+}
+
+} // Anonymous namespace
+
+TEST_CASE("Source plays a looping PCM16 buffer", "[audio_core]") {
+    Memory::MemorySystem memory;
+    constexpr u32 length = 100;
+    std::array<std::array<s16, 2>, length> samples;
+    for (u32 i = 0; i < length; ++i) {
+        samples[i] = {static_cast<s16>(i * 100), static_cast<s16>(-static_cast<s16>(i))};
+    }
+    std::memcpy(memory.GetFCRAMPointer(0), samples.data(), sizeof(samples));
+
+    Source source(0);
+    source.SetMemory(memory);
+    Configuration config = MakeConfig(0, length, Configuration::Format::PCM16,
+                                      Configuration::MonoOrStereo::Stereo, 1.0f,
+                                      Configuration::InterpolationMode::None);
+
+    // Output is delayed by two samples, and wraps around at the end of the buffer
+    for (u32 frame = 0; frame < 3; ++frame) {
+        source.Tick(config, NO_ADPCM_COEFFS);
+        AudioCore::QuadFrame32 mix{};
+        source.MixInto(mix, 0);
+        for (u32 i = 0; i < AudioCore::samples_per_frame; ++i) {
+            const u32 position = frame * AudioCore::samples_per_frame + i;
+            const std::array<s16, 2> expected =
+                position < 2 ? std::array<s16, 2>{} : samples[(position - 2) % length];
+            REQUIRE(mix[i][0] == expected[0]);
+            REQUIRE(mix[i][1] == expected[1]);
+        }
+    }
+}
+
+TEST_CASE("Source mixing performance", "[.benchmark][audio_core]") {
+    // Every source plays its own looping buffer of a few frames, so buffers are dequeued and
+    // decoded regularly, with a mix of formats, rates and interpolation modes
+    Memory::MemorySystem memory;
+    constexpr u32 length = 1000;
+    constexpr std::size_t buffer_size = length * 4;
+    u8* const fcram = memory.GetFCRAMPointer(0);
+    for (std::size_t i = 0; i < buffer_size * AudioCore::HLE::num_sources; ++i) {
+        fcram[i] = static_cast<u8>(i * 37 + (i >> 8));
+    }
+
+    std::vector<std::unique_ptr<Source>> sources;
+    std::vector<Configuration> configs;
+    for (std::size_t i = 0; i < AudioCore::HLE::num_sources; ++i) {
+        static constexpr std::array formats{Configuration::Format::PCM16,
+                                            Configuration::Format::ADPCM,
+                                            Configuration::Format::PCM8};
+        const auto format = formats[i % formats.size()];
+        const auto mono_or_stereo = format == Configuration::Format::ADPCM || i % 2
+                                        ? Configuration::MonoOrStereo::Mono
+                                        : Configuration::MonoOrStereo::Stereo;
+        const auto interpolation_mode = i % 4 == 0 ? Configuration::InterpolationMode::None
+                                                   : Configuration::InterpolationMode::Linear;
+        configs.push_back(MakeConfig(i * buffer_size, length, format, mono_or_stereo,
+                                     0.5f + 0.1f * static_cast<float>(i % 10),
+                                     interpolation_mode));
+        sources.push_back(std::make_unique<Source>(i));
+        sources.back()->SetMemory(memory);
+    }
+
+    BENCHMARK("24 sources, one frame") {
+        AudioCore::QuadFrame32 mix{};
+        for (std::size_t i = 0; i < sources.size(); ++i) {
+            sources[i]->Tick(configs[i], NO_ADPCM_COEFFS);
+            sources[i]->MixInto(mix, 0);
+        }
+        return mix[0][0];
+    };
+}
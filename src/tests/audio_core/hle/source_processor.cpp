@@ -0,0 +1,112 @@
+// Copyright 2022 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <array>
+#include <cstring>
+#include <memory>
+#include <vector>
+#include "audio_core/hle/shared_memory.h"
+#include "audio_core/hle/source.h"
+#include "audio_core/hle/source_processor.h"
+#include "core/memory.h"
+
+using namespace AudioCore::HLE;
+using Configuration = SourceConfiguration::Configuration;
+
+namespace {
+
+constexpr u32 BUFFER_LENGTH = 1000;
+constexpr std::size_t BUFFER_SIZE = BUFFER_LENGTH * 4;
+
+/// Every source plays its own looping buffer with its own format, rate and gains
+void Configure(SharedMemory& shared_memory) {
+    std::memset(&shared_memory, 0, sizeof(shared_memory));
+    for (std::size_t i = 0; i < num_sources; ++i) {
+        static constexpr std::array formats{Configuration::Format::PCM16,
+                                            Configuration::Format::ADPCM,
+                                            Configuration::Format::PCM8};
+        const auto format = formats[i % formats.size()];
+        Configuration& config = shared_memory.source_configurations.config[i];
+        config.enable = 1;
+        config.enable_dirty.Assign(1);
+        config.rate_multiplier = 0.5f + 0.1f * static_cast<float>(i % 10);
+        config.rate_multiplier_dirty.Assign(1);
+        config.interpolation_mode = i % 4 == 0 ? Configuration::InterpolationMode::None
+                                               : Configuration::InterpolationMode::Linear;
+        config.interpolation_dirty.Assign(1);
+        // Sources feed every intermediate mix, with different gains
+        for (std::size_t mix = 0; mix < 3; ++mix) {
+            for (std::size_t channel = 0; channel < 4; ++channel) {
+                config.gain[mix][channel] = 0.25f * static_cast<float>((i + mix + channel) % 5);
+            }
+        }
+        config.gain_0_dirty.Assign(1);
+        config.gain_1_dirty.Assign(1);
+        config.gain_2_dirty.Assign(1);
+        config.physical_address = static_cast<u32>(Memory::FCRAM_PADDR + i * BUFFER_SIZE);
+        config.length = BUFFER_LENGTH;
+        config.format.Assign(format);
+        config.mono_or_stereo.Assign(format == Configuration::Format::ADPCM || i % 2
+                                         ? Configuration::MonoOrStereo::Mono
+                                         : Configuration::MonoOrStereo::Stereo);
+        config.is_looping.Assign(1);
+        config.embedded_buffer_dirty.Assign(1);
+    }
+}
+
+struct Output {
+    std::vector<SourceProcessor::IntermediateMixes> mixes;
+    /// Source statuses of every frame, as raw bytes
+    std::vector<u8> statuses;
+};
+
+Output RunFrames(Memory::MemorySystem& memory, std::size_t num_threads) {
+    std::array<Source, num_sources> sources{{
+        Source(0),  Source(1),  Source(2),  Source(3),  Source(4),  Source(5),
+        Source(6),  Source(7),  Source(8),  Source(9),  Source(10), Source(11),
+        Source(12), Source(13), Source(14), Source(15), Source(16), Source(17),
+        Source(18), Source(19), Source(20), Source(21), Source(22), Source(23),
+    }};
+    for (Source& source : sources) {
+        source.SetMemory(memory);
+    }
+    auto read = std::make_unique<SharedMemory>();
+    auto write = std::make_unique<SharedMemory>();
+    Configure(*read);
+    std::memset(write.get(), 0, sizeof(*write));
+
+    SourceProcessor processor(num_threads);
+    Output output;
+    // Enough frames to go through the buffers of the fastest sources several times
+    for (int frame = 0; frame < 16; ++frame) {
+        output.mixes.push_back(processor.Process(sources, *read, *write));
+        const u8* statuses = reinterpret_cast<const u8*>(&write->source_statuses);
+        output.statuses.insert(output.statuses.end(), statuses,
+                               statuses + sizeof(write->source_statuses));
+    }
+    return output;
+}
+
+} // Anonymous namespace
+
+TEST_CASE("SourceProcessor gives the same result with any number of threads", "[audio_core]") {
+    Memory::MemorySystem memory;
+    u8* const fcram = memory.GetFCRAMPointer(0);
+    for (std::size_t i = 0; i < BUFFER_SIZE * num_sources; ++i) {
+        fcram[i] = static_cast<u8>(i * 37 + (i >> 8));
+    }
+
+    const Output serial = RunFrames(memory, 1);
+    // The sources are still playing at the last frame
+    REQUIRE(serial.mixes.back() != SourceProcessor::IntermediateMixes{});
+
+    // Four groups of six sources, and groups of uneven size
+    for (const std::size_t num_threads : {4, 5}) {
+        const Output threaded = RunFrames(memory, num_threads);
+        REQUIRE(threaded.mixes == serial.mixes);
+        REQUIRE(threaded.statuses == serial.statuses);
+    }
+}
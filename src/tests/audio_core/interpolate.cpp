@@ -0,0 +1,95 @@
+// Copyright 2022 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <array>
+#include <random>
+#include <vector>
+#include "audio_core/interpolate.h"
+
+using AudioCore::StereoBuffer16;
+using AudioCore::StereoFrame16;
+
+namespace {
+
+using Sample = StereoBuffer16::Sample;
+
+constexpr u64 scale_factor = 1 << 24;
+
+/// Resamples a whole stream in one go, as the interpolator would see it with no buffer boundaries
+std::vector<Sample> Resample(const std::vector<Sample>& input, float rate, bool linear,
+                             std::size_t count) {
+    // The interpolators have a two-sample predelay
+    std::vector<Sample> stream(2);
+    stream.insert(stream.end(), input.begin(), input.end());
+
+    std::vector<Sample> output;
+    const u64 step_size = static_cast<u64>(rate * scale_factor);
+    for (u64 fposition = 0; output.size() < count; fposition += step_size) {
+        const std::size_t index = static_cast<std::size_t>(fposition / scale_factor);
+        const u64 fraction = fposition & (scale_factor - 1);
+        const Sample& x0 = stream[index];
+        const Sample& x1 = stream[index + 1];
+        if (!linear) {
+            output.push_back(x0);
+            continue;
+        }
+        Sample sample;
+        for (std::size_t channel = 0; channel < 2; ++channel) {
+            const s64 delta = std::clamp<s64>(x1[channel] - x0[channel], -32768, 32767);
+            sample[channel] = static_cast<s16>(x0[channel] + fraction * delta / scale_factor);
+        }
+        output.push_back(sample);
+    }
+    return output;
+}
+
+} // Anonymous namespace
+
+TEST_CASE("AudioInterp is independent of buffer boundaries", "[audio_core]") {
+    std::mt19937 rng(7);
+    std::vector<Sample> input(4000);
+    for (Sample& sample : input) {
+        sample = {static_cast<s16>(rng()), static_cast<s16>(rng())};
+    }
+
+    for (const float rate : {0.25f, 0.5f, 1.0f, 1.37f, 3.0f}) {
+        for (const bool linear : {false, true}) {
+            AudioCore::AudioInterp::State state;
+            StereoBuffer16 buffer;
+            std::vector<Sample> output;
+            std::size_t inputi = 0;
+
+            // Feed the input in buffers of random sizes and collect whole frames
+            StereoFrame16 frame{};
+            std::size_t outputi = 0;
+            while (true) {
+                if (buffer.Empty()) {
+                    if (inputi == input.size()) {
+                        break;
+                    }
+                    const std::size_t size = std::min<std::size_t>(1 + rng() % 300,
+                                                                   input.size() - inputi);
+                    Sample* samples = buffer.Reset(size);
+                    std::copy_n(input.begin() + inputi, size, samples);
+                    inputi += size;
+                }
+                if (linear) {
+                    AudioCore::AudioInterp::Linear(state, buffer, rate, frame, outputi);
+                } else {
+                    AudioCore::AudioInterp::None(state, buffer, rate, frame, outputi);
+                }
+                if (outputi == frame.size()) {
+                    output.insert(output.end(), frame.begin(), frame.end());
+                    outputi = 0;
+                }
+            }
+
+            REQUIRE(!output.empty());
+            REQUIRE(output == Resample(input, rate, linear, output.size()));
+        }
+    }
+}
@@ -0,0 +1,85 @@
+// Copyright 2022 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <catch2/catch_test_macros.hpp>
+#include "audio_core/latency_controller.h"
+
+using AudioCore::LatencyController;
+using namespace std::chrono_literals;
+
+namespace {
+
+constexpr unsigned int sample_rate = 48000;
+constexpr std::size_t frames_per_callback = 480; // 10ms
+
+/// Runs callbacks at the given interval, every one of them fully served
+LatencyController::Clock::time_point RunCallbacks(LatencyController& controller,
+                                                  LatencyController::Clock::time_point time,
+                                                  int count, std::chrono::microseconds interval) {
+    for (int i = 0; i < count; ++i) {
+        controller.RecordCallback(time, frames_per_callback, frames_per_callback);
+        time += interval;
+    }
+    return time;
+}
+
+} // Anonymous namespace
+
+TEST_CASE("LatencyController follows the callback period and jitter", "[audio_core]") {
+    LatencyController controller(sample_rate);
+    auto time = RunCallbacks(controller, LatencyController::Clock::time_point{}, 500, 10ms);
+
+    // Two callback periods without any jitter
+    REQUIRE(controller.GetCallbackJitter() == 0.0);
+    REQUIRE(controller.GetTargetLatency() == 0.02);
+
+    // Callbacks alternating between 5ms and 15ms apart deviate by 5ms from the period
+    for (int i = 0; i < 250; ++i) {
+        time = RunCallbacks(controller, time, 1, 5ms);
+        time = RunCallbacks(controller, time, 1, 15ms);
+    }
+    REQUIRE(controller.GetCallbackJitter() > 0.0049);
+    REQUIRE(controller.GetCallbackJitter() < 0.0051);
+    REQUIRE(controller.GetTargetLatency() > 0.039);
+    REQUIRE(controller.GetUnderrunCount() == 0);
+}
+
+TEST_CASE("LatencyController adds headroom after underruns", "[audio_core]") {
+    LatencyController controller(sample_rate);
+    auto time = LatencyController::Clock::time_point{};
+
+    // Silence before the first frame doesn't count
+    for (int i = 0; i < 10; ++i) {
+        controller.RecordCallback(time, frames_per_callback, 0);
+        time += 10ms;
+    }
+    time = RunCallbacks(controller, time, 10, 10ms);
+    REQUIRE(controller.GetUnderrunCount() == 0);
+    const double stable_latency = controller.GetTargetLatency();
+
+    // Consecutive short callbacks are a single underrun
+    for (int i = 0; i < 3; ++i) {
+        controller.RecordCallback(time, frames_per_callback, frames_per_callback / 2);
+        time += 10ms;
+    }
+    REQUIRE(controller.GetUnderrunCount() == 1);
+    const double underrun_latency = controller.GetTargetLatency();
+    REQUIRE(underrun_latency > stable_latency + 0.015);
+
+    controller.RecordCallback(time, frames_per_callback, 0);
+    time += 10ms;
+    REQUIRE(controller.GetUnderrunCount() == 1);
+
+    time = RunCallbacks(controller, time, 1, 10ms);
+    controller.RecordCallback(time, frames_per_callback, 0);
+    time += 10ms;
+    REQUIRE(controller.GetUnderrunCount() == 2);
+    REQUIRE(controller.GetTargetLatency() > underrun_latency);
+
+    // The headroom decays once the output is stable
+    RunCallbacks(controller, time, 6000, 10ms);
+    REQUIRE(controller.GetTargetLatency() < stable_latency + 0.001);
+    REQUIRE(controller.GetTargetLatency() <= LatencyController::MAX_LATENCY);
+}
@@ -0,0 +1,54 @@
+// Copyright 2022 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <memory>
+#include <string>
+#include <thread>
+#include <catch2/catch_test_macros.hpp>
+#include "common/common_types.h"
+#include "common/threadsafe_queue.h"
+
+namespace Common {
+
+TEST_CASE("BoundedSPSCQueue", "[common]") {
+    BoundedSPSCQueue<std::unique_ptr<std::string>, 4> queue;
+    REQUIRE(queue.Empty());
+
+    std::unique_ptr<std::string> element;
+    REQUIRE(!queue.Pop(element));
+
+    // Wraps around the ring several times
+    for (int i = 0; i < 10; ++i) {
+        queue.Push(std::make_unique<std::string>(std::to_string(i)));
+        queue.Push(std::make_unique<std::string>("second"));
+        REQUIRE(queue.Size() == 2);
+        REQUIRE(*queue.PopWait() == std::to_string(i));
+        REQUIRE(queue.Pop(element));
+        REQUIRE(*element == "second");
+        REQUIRE(queue.Empty());
+    }
+}
+
+TEST_CASE("BoundedSPSCQueue across threads", "[common]") {
+    // A small queue keeps both sides going to sleep on a full and on an empty queue
+    constexpr u32 count = 100000;
+    BoundedSPSCQueue<u32, 8> queue;
+
+    std::thread producer([&queue] {
+        for (u32 i = 0; i < count; ++i) {
+            queue.Push(i);
+        }
+    });
+
+    bool in_order = true;
+    for (u32 i = 0; i < count; ++i) {
+        in_order &= queue.PopWait() == i;
+    }
+    producer.join();
+
+    REQUIRE(in_order);
+    REQUIRE(queue.Empty());
+}
+
+} // namespace Common
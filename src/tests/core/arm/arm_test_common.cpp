@@ -12,13 +12,13 @@ namespace ArmTests {
 
 static std::shared_ptr<Memory::PageTable> page_table = nullptr;
 
-TestEnvironment::TestEnvironment(bool mutable_memory_)
+TestEnvironment::TestEnvironment(bool mutable_memory_, u32 num_cores)
     : mutable_memory(mutable_memory_), test_memory(std::make_shared<TestMemory>(this)) {
 
-    timing = std::make_unique<Core::Timing>(1, 100);
+    timing = std::make_unique<Core::Timing>(num_cores, 100);
     memory = std::make_unique<Memory::MemorySystem>();
     kernel = std::make_unique<Kernel::KernelSystem>(
-        *memory, *timing, [] {}, 0, 1, 0);
+        *memory, *timing, [] {}, 0, num_cores, 0);
 
     kernel->SetCurrentProcess(kernel->CreateProcess(kernel->CreateCodeSet("", 0)));
     page_table = kernel->GetCurrentProcess()->vm_manager.page_table;
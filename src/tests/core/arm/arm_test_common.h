@@ -27,8 +27,9 @@ public:
      * Inititalise test environment
      * @param mutable_memory If false, writes to memory can never be read back.
      *                       (Memory is immutable.)
+     * @param num_cores Number of cores the timing and the kernel are set up for.
      */
-    explicit TestEnvironment(bool mutable_memory = false);
+    explicit TestEnvironment(bool mutable_memory = false, u32 num_cores = 1);
 
     /// Shutdown test environment
     ~TestEnvironment();
@@ -53,6 +54,10 @@ public:
         return *memory;
     }
 
+    Core::Timing& GetTiming() {
+        return *timing;
+    }
+
 private:
     friend struct TestMemory;
     struct TestMemory final : Memory::MMIORegion {
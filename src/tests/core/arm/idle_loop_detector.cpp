@@ -0,0 +1,156 @@
+// Copyright 2022 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <vector>
+#include "core/arm/idle_loop_detector.h"
+
+static std::optional<IdleLoop> Find(const std::vector<u32>& code, VAddr pc) {
+    return FindIdleLoop(pc, [&code](VAddr address) {
+        return address / 4 < code.size() ? code[address / 4] : 0xFFFFFFFF;
+    });
+}
+
+TEST_CASE("FindIdleLoop detects polling loops", "[core][arm]") {
+    SECTION("load, compare and branch back") {
+        const std::vector<u32> code{
+            0xE5910000, // ldr r0, [r1]
+            0xE3500000, // cmp r0, #0
+            0x0AFFFFFC, // beq 0
+        };
+        for (VAddr pc = 0; pc < 12; pc += 4) {
+            const auto loop = Find(code, pc);
+            REQUIRE(loop);
+            REQUIRE(loop->start == 0);
+            REQUIRE(loop->end == 8);
+            REQUIRE(loop->loads.size() == 1);
+            REQUIRE(loop->loads[0].base_reg == 1);
+            REQUIRE(loop->loads[0].size == 4);
+        }
+    }
+
+    SECTION("value compared against a literal") {
+        const std::vector<u32> code{
+            0xE59F2008, // ldr r2, [pc, #8]
+            0xE1D100B2, // ldrh r0, [r1, #2]
+            0xE1500002, // cmp r0, r2
+            0x1AFFFFFB, // bne 0
+        };
+        const auto loop = Find(code, 8);
+        REQUIRE(loop);
+        REQUIRE(loop->loads.size() == 2);
+        REQUIRE(loop->loads[0].base_reg == 15);
+        REQUIRE(loop->loads[0].address == 0);
+        REQUIRE(loop->loads[1].base_reg == 1);
+        REQUIRE(loop->loads[1].offset == 2);
+        REQUIRE(loop->loads[1].size == 2);
+    }
+
+    SECTION("branch to itself") {
+        const auto loop = Find({0xEAFFFFFE}, 0); // b 0
+        REQUIRE(loop);
+        REQUIRE(loop->loads.empty());
+    }
+}
+
+TEST_CASE("FindIdleLoop rejects loops with side effects", "[core][arm]") {
+    SECTION("store") {
+        REQUIRE_FALSE(Find({0xE5810000, 0xE3500000, 0x1AFFFFFC}, 0)); // str r0, [r1]; cmp; bne
+    }
+
+    SECTION("call") {
+        REQUIRE_FALSE(Find({0xEB000010, 0xE3500000, 0x0AFFFFFC}, 0)); // bl; cmp; beq
+    }
+
+    SECTION("register counting down") {
+        REQUIRE_FALSE(Find({0xE2500001, 0x1AFFFFFD}, 0)); // subs r0, r0, #1; bne 0
+    }
+
+    SECTION("flags carried into the next iteration") {
+        const std::vector<u32> code{
+            0x03A02001, // moveq r2, #1
+            0xE5910000, // ldr r0, [r1]
+            0xE3500000, // cmp r0, #0
+            0x0AFFFFFB, // beq 0
+        };
+        REQUIRE_FALSE(Find(code, 4));
+    }
+
+    SECTION("load through a pointer that changes") {
+        REQUIRE_FALSE(Find({0xE5911000, 0xE3510000, 0x1AFFFFFC}, 0)); // ldr r1, [r1]; cmp; bne
+    }
+
+    SECTION("code that doesn't branch back") {
+        REQUIRE_FALSE(Find({0xE5910000, 0xE3500000, 0x0A000010}, 0)); // ldr; cmp; beq forward
+    }
+}
+
+static std::optional<IdleLoop> FindTickPoll(const std::vector<u32>& code, VAddr return_address) {
+    return FindTickPollLoop(return_address, [&code](VAddr address) {
+        return address / 4 < code.size() ? code[address / 4] : 0xFFFFFFFF;
+    });
+}
+
+TEST_CASE("FindTickPollLoop detects waits on the tick count", "[core][arm]") {
+    SECTION("tick count compared against a deadline") {
+        const std::vector<u32> code{
+            0xEB000010, // bl svcGetSystemTick
+            0xE0500004, // subs r0, r0, r4
+            0xE0D11005, // sbcs r1, r1, r5
+            0x3AFFFFFB, // blo 0
+        };
+        const auto loop = FindTickPoll(code, 4);
+        REQUIRE(loop);
+        REQUIRE(loop->start == 0);
+        REQUIRE(loop->end == 12);
+        REQUIRE(loop->loads.empty());
+    }
+
+    SECTION("wait that also polls memory") {
+        const std::vector<u32> code{
+            0xE5962000, // ldr r2, [r6]
+            0xE3520000, // cmp r2, #0
+            0x1A000002, // bne 24
+            0xEB000010, // bl svcGetSystemTick
+            0xE1500004, // cmp r0, r4
+            0x3AFFFFF9, // blo 0
+        };
+        const auto loop = FindTickPoll(code, 16);
+        REQUIRE(loop);
+        REQUIRE(loop->start == 0);
+        REQUIRE(loop->loads.size() == 1);
+        REQUIRE(loop->loads[0].base_reg == 6);
+    }
+}
+
+TEST_CASE("FindTickPollLoop rejects callers doing work", "[core][arm]") {
+    SECTION("counter carried across calls") {
+        const std::vector<u32> code{
+            0xEB000010, // bl svcGetSystemTick
+            0xE2877001, // add r7, r7, #1
+            0xE1500004, // cmp r0, r4
+            0x3AFFFFFB, // blo 0
+        };
+        REQUIRE_FALSE(FindTickPoll(code, 4));
+    }
+
+    SECTION("store between calls") {
+        const std::vector<u32> code{
+            0xEB000010, // bl svcGetSystemTick
+            0xE5860000, // str r0, [r6]
+            0xE1500004, // cmp r0, r4
+            0x3AFFFFFB, // blo 0
+        };
+        REQUIRE_FALSE(FindTickPoll(code, 4));
+    }
+
+    SECTION("call that isn't part of a loop") {
+        REQUIRE_FALSE(FindTickPoll({0xEB000010, 0xE1500004, 0xE12FFF1E}, 4)); // bl; cmp; bx lr
+    }
+
+    SECTION("conditional call") {
+        REQUIRE_FALSE(FindTickPoll({0x3B000010, 0xE1500004, 0x3AFFFFFC}, 4)); // bllo; cmp; blo 0
+    }
+}
@@ -0,0 +1,179 @@
+// Copyright 2022 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "core/core_threads.h"
+#include "core/core_timing.h"
+#include "core/memory.h"
+#include "tests/core/arm/arm_test_common.h"
+
+#if defined(ARCHITECTURE_x86_64) || defined(ARCHITECTURE_ARM64)
+#include <dynarmic/exclusive_monitor.h>
+#include "core/arm/dynarmic/arm_dynarmic.h"
+#endif
+
+namespace {
+
+constexpr u32 NUM_CORES = 4;
+
+#if defined(ARCHITECTURE_x86_64) || defined(ARCHITECTURE_ARM64)
+constexpr u32 NUM_ITERATIONS = 300;
+constexpr s64 SLICE_LENGTH = 200;
+constexpr int MAX_SLICES = 10000;
+
+constexpr VAddr COUNTER_ADDR = 0x1000;
+constexpr VAddr SUM_ADDR = 0x1100;
+constexpr VAddr RESULTS_ADDR = 0x2000;
+constexpr VAddr DONE_ADDR = 0x3C;
+
+/**
+ * Every core adds 1 to the word at r0 and its r9 to the doubleword at r8 with exclusive accesses,
+ * r1 times, then stores how many rounds it did to the word at r2. The end result doesn't depend on
+ * how the cores interleave, as long as the exclusive stores of the cores exclude each other.
+ */
+constexpr std::array<u32, 16> PROGRAM{
+    0xE1903F9F, // 0x00: ldrex r3, [r0]
+    0xE2833001, // 0x04: add r3, r3, #1
+    0xE1804F93, // 0x08: strex r4, r3, [r0]
+    0xE3540000, // 0x0C: cmp r4, #0
+    0x1AFFFFFA, // 0x10: bne 0x00
+    0xE1B86F9F, // 0x14: ldrexd r6, r7, [r8]
+    0xE0966009, // 0x18: adds r6, r6, r9
+    0xE2A77000, // 0x1C: adc r7, r7, #0
+    0xE1A84F96, // 0x20: strexd r4, r6, r7, [r8]
+    0xE3540000, // 0x24: cmp r4, #0
+    0x1AFFFFF9, // 0x28: bne 0x14
+    0xE2855001, // 0x2C: add r5, r5, #1
+    0xE2511001, // 0x30: subs r1, r1, #1
+    0x1AFFFFF1, // 0x34: bne 0x00
+    0xE5825000, // 0x38: str r5, [r2]
+    0xEAFFFFFE, // 0x3C: b 0x3C
+};
+
+struct Results {
+    u32 counter;
+    u64 sum;
+    std::array<u32, NUM_CORES> rounds;
+
+    bool operator==(const Results&) const = default;
+};
+
+/**
+ * Runs PROGRAM on every core until all of them are done, driving them like System::RunLoop. The
+ * cores either take turns on the calling thread, or run in parallel on core_threads with a shared
+ * exclusive monitor, like System::RunSliceOnCoreThreads runs them.
+ */
+Results RunCores(Core::CoreThreads* core_threads) {
+    ArmTests::TestEnvironment test_env(true, NUM_CORES);
+    for (std::size_t i = 0; i < PROGRAM.size(); ++i) {
+        test_env.SetMemory32(static_cast<VAddr>(i * 4), PROGRAM[i]);
+    }
+    test_env.SetMemory32(COUNTER_ADDR, 0);
+    test_env.SetMemory64(SUM_ADDR, 0);
+    for (u32 i = 0; i < NUM_CORES; ++i) {
+        test_env.SetMemory32(RESULTS_ADDR + i * 4, 0);
+    }
+
+    Core::Timing& timing = test_env.GetTiming();
+    std::shared_ptr<Dynarmic::ExclusiveMonitor> exclusive_monitor;
+    if (core_threads) {
+        exclusive_monitor = std::make_shared<Dynarmic::ExclusiveMonitor>(NUM_CORES);
+    }
+    std::vector<std::shared_ptr<ARM_Interface>> cores;
+    for (u32 i = 0; i < NUM_CORES; ++i) {
+        auto core = std::make_shared<ARM_Dynarmic>(nullptr, test_env.GetMemory(), i,
+                                                   timing.GetTimer(i), exclusive_monitor);
+        core->SetReg(0, COUNTER_ADDR);
+        core->SetReg(1, NUM_ITERATIONS);
+        core->SetReg(2, RESULTS_ADDR + i * 4);
+        core->SetReg(5, 0);
+        core->SetReg(8, SUM_ADDR);
+        core->SetReg(9, 0x90000000 + i);
+        core->SetPC(0);
+        cores.push_back(std::move(core));
+    }
+
+    const std::vector<u32> core_ids{0, 1, 2, 3};
+    const auto all_done = [&cores] {
+        return std::all_of(cores.begin(), cores.end(),
+                           [](const auto& core) { return core->GetPC() == DONE_ADDR; });
+    };
+    for (int slice = 0; slice < MAX_SLICES && !all_done(); ++slice) {
+        for (u32 i = 0; i < NUM_CORES; ++i) {
+            timing.SetCurrentTimer(i);
+            timing.GetTimer(i)->Advance();
+            timing.GetTimer(i)->SetNextSlice(SLICE_LENGTH);
+        }
+        if (core_threads) {
+            core_threads->RunCores(timing, cores, core_ids);
+        } else {
+            for (auto& core : cores) {
+                core->Run();
+            }
+        }
+    }
+    REQUIRE(all_done());
+
+    Memory::MemorySystem& memory = test_env.GetMemory();
+    Results results{memory.Read32(COUNTER_ADDR), memory.Read64(SUM_ADDR), {}};
+    for (u32 i = 0; i < NUM_CORES; ++i) {
+        results.rounds[i] = memory.Read32(RESULTS_ADDR + i * 4);
+    }
+    return results;
+}
+#endif
+
+} // Anonymous namespace
+
+#if defined(ARCHITECTURE_x86_64) || defined(ARCHITECTURE_ARM64)
+TEST_CASE("CoreThreads matches the time-sliced results", "[core]") {
+    const Results time_sliced = RunCores(nullptr);
+    REQUIRE(time_sliced.counter == NUM_CORES * NUM_ITERATIONS);
+    u64 expected_sum = 0;
+    for (u32 i = 0; i < NUM_CORES; ++i) {
+        REQUIRE(time_sliced.rounds[i] == NUM_ITERATIONS);
+        expected_sum += static_cast<u64>(NUM_ITERATIONS) * (0x90000000 + i);
+    }
+    REQUIRE(time_sliced.sum == expected_sum);
+
+    Core::CoreThreads core_threads(NUM_CORES);
+    for (int run = 0; run < 3; ++run) {
+        REQUIRE(RunCores(&core_threads) == time_sliced);
+    }
+}
+#endif
+
+TEST_CASE("CoreThreads runs each core on its own host thread", "[core]") {
+    Core::CoreThreads core_threads(NUM_CORES);
+    std::mutex mutex;
+    std::array<std::vector<std::thread::id>, NUM_CORES> thread_ids;
+    const auto record = [&](u32 core_id) {
+        std::lock_guard lock{mutex};
+        thread_ids[core_id].push_back(std::this_thread::get_id());
+    };
+
+    for (int slice = 0; slice < 8; ++slice) {
+        core_threads.RunSlice({0, 1, 2, 3}, record);
+    }
+    core_threads.RunSlice({2}, record);
+    core_threads.RunSlice({}, record);
+
+    REQUIRE(thread_ids[0].size() == 8);
+    REQUIRE(thread_ids[2].size() == 9);
+    for (u32 i = 0; i < NUM_CORES; ++i) {
+        REQUIRE(std::count(thread_ids[i].begin(), thread_ids[i].end(), thread_ids[i][0]) ==
+                static_cast<std::ptrdiff_t>(thread_ids[i].size()));
+        REQUIRE(thread_ids[i][0] != std::this_thread::get_id());
+        for (u32 j = 0; j < i; ++j) {
+            REQUIRE(thread_ids[i][0] != thread_ids[j][0]);
+        }
+    }
+}
@@ -4,9 +4,13 @@
 
 #include <catch2/catch_test_macros.hpp>
 
+#include <algorithm>
 #include <array>
 #include <bitset>
+#include <random>
 #include <string>
+#include <vector>
+#include <catch2/benchmark/catch_benchmark.hpp>
 #include "common/file_util.h"
 #include "core/core.h"
 #include "core/core_timing.h"
@@ -196,4 +200,176 @@ TEST_CASE("CoreTiming[ChainScheduling]", "[core]") {
     REQUIRE(MAX_SLICE_LENGTH == timing.GetTimer(0)->GetDowncount());
 }
 
+TEST_CASE("CoreTiming[UnscheduleEvent]", "[core]") {
+    Core::Timing timing(1, 100);
+
+    Core::TimingEventType* cb_a = timing.RegisterEvent("callbackA", CallbackTemplate<0>);
+    Core::TimingEventType* cb_b = timing.RegisterEvent("callbackB", CallbackTemplate<1>);
+    Core::TimingEventType* cb_c = timing.RegisterEvent("callbackC", CallbackTemplate<2>);
+
+    // Enter slice 0
+    timing.GetTimer(0)->Advance();
+    timing.GetTimer(0)->SetNextSlice();
+
+    timing.ScheduleEvent(100, cb_a, CB_IDS[0], 0);
+    timing.ScheduleEvent(200, cb_a, CB_IDS[0], 0);
+    timing.ScheduleEvent(300, cb_a, CB_IDS[1], 0);
+    timing.ScheduleEvent(400, cb_b, CB_IDS[1], 0);
+    timing.ScheduleEvent(500, cb_c, CB_IDS[2], 0);
+    REQUIRE(100 == timing.GetTimer(0)->GetDowncount());
+
+    // Both events of cb_a with CB_IDS[0] go, the one with another userdata stays
+    timing.UnscheduleEvent(cb_a, CB_IDS[0]);
+    timing.UnscheduleEvent(cb_b, CB_IDS[0]);
+    timing.GetTimer(0)->SetNextSlice();
+    REQUIRE(300 == timing.GetTimer(0)->GetDowncount());
+
+    timing.UnscheduleEvent(cb_a, CB_IDS[1]);
+    timing.GetTimer(0)->SetNextSlice();
+    REQUIRE(400 == timing.GetTimer(0)->GetDowncount());
+
+    AdvanceAndCheck(timing, 1, 100); // cb_b
+    AdvanceAndCheck(timing, 2, MAX_SLICE_LENGTH);
+}
+
+TEST_CASE("CoreTiming[EventQueueOrder]", "[core]") {
+    std::array<Core::TimingEventType, 4> types{};
+    Core::Timing::EventQueue queue;
+    // Reference model, kept sorted by time and fifo order
+    std::vector<Core::Timing::Event> expected;
+
+    std::mt19937 rng(1234);
+    u64 fifo_order = 0;
+    for (int step = 0; step < 20000; ++step) {
+        const u32 action = rng() % 8;
+        const auto* type = &types[rng() % types.size()];
+        const u64 userdata = rng() % 16;
+        if (action < 4) {
+            const Core::Timing::Event event{static_cast<s64>(rng() % 1000), fifo_order++,
+                                            userdata, type};
+            queue.Push(event);
+            expected.insert(std::upper_bound(expected.begin(), expected.end(), event), event);
+        } else if (action < 6) {
+            queue.Remove(type, userdata);
+            std::erase_if(expected, [&](const Core::Timing::Event& e) {
+                return e.type == type && e.userdata == userdata;
+            });
+        } else if (action < 7 && !expected.empty()) {
+            const auto event = queue.Pop();
+            REQUIRE(event.fifo_order == expected.front().fifo_order);
+            expected.erase(expected.begin());
+        } else if (step % 1000 == 7) {
+            queue.RemoveAll(type);
+            std::erase_if(expected, [&](const Core::Timing::Event& e) { return e.type == type; });
+        }
+        REQUIRE(queue.Size() == expected.size());
+        if (!expected.empty()) {
+            REQUIRE(queue.Top().fifo_order == expected.front().fifo_order);
+        }
+    }
+
+    while (!expected.empty()) {
+        REQUIRE(queue.Pop().fifo_order == expected.front().fifo_order);
+        expected.erase(expected.begin());
+    }
+    REQUIRE(queue.Empty());
+}
+
+TEST_CASE("CoreTiming[EventQueue] performance", "[.benchmark][core]") {
+    // Models thread wakeups: many pending timeouts that are mostly cancelled before they expire
+    constexpr u64 NUM_THREADS = 512;
+    constexpr int NUM_OPERATIONS = 4096;
+    Core::TimingEventType wakeup{};
+
+    std::mt19937 rng(42);
+    // Pairs of thread and new wakeup time
+    std::vector<std::pair<u64, s64>> operations(NUM_OPERATIONS);
+    for (auto& [thread, time] : operations) {
+        thread = rng() % NUM_THREADS;
+        time = rng() % 100000;
+    }
+
+    BENCHMARK("indexed heap") {
+        Core::Timing::EventQueue queue;
+        u64 fifo_order = 0;
+        for (u64 thread = 0; thread < NUM_THREADS; ++thread) {
+            queue.Push({static_cast<s64>(thread * 100), fifo_order++, thread, &wakeup});
+        }
+        for (const auto& [thread, time] : operations) {
+            queue.Remove(&wakeup, thread);
+            queue.Push({time, fifo_order++, thread, &wakeup});
+        }
+        return queue.Top().time;
+    };
+
+    BENCHMARK("binary heap with linear removal") {
+        std::vector<Core::Timing::Event> queue;
+        u64 fifo_order = 0;
+        for (u64 thread = 0; thread < NUM_THREADS; ++thread) {
+            queue.push_back({static_cast<s64>(thread * 100), fifo_order++, thread, &wakeup});
+            std::push_heap(queue.begin(), queue.end(), std::greater<>());
+        }
+        for (const auto& operation : operations) {
+            const u64 thread = operation.first;
+            const auto itr = std::remove_if(queue.begin(), queue.end(), [&](const auto& e) {
+                return e.type == &wakeup && e.userdata == thread;
+            });
+            if (itr != queue.end()) {
+                queue.erase(itr, queue.end());
+                std::make_heap(queue.begin(), queue.end(), std::greater<>());
+            }
+            queue.push_back({operation.second, fifo_order++, thread, &wakeup});
+            std::push_heap(queue.begin(), queue.end(), std::greater<>());
+        }
+        return queue.front().time;
+    };
+}
+
+TEST_CASE("CoreTiming[EventQueue] schedule and pop throughput", "[.benchmark][core]") {
+    // Models the steady state of the scheduler: the earliest event fires and schedules a new one,
+    // with a new key every time like callbacks that pass a fresh handle as userdata
+    constexpr int NUM_PENDING = 64;
+    constexpr int NUM_OPERATIONS = 16384;
+    Core::TimingEventType event_type{};
+
+    std::mt19937 rng(7);
+    std::vector<s64> delays(NUM_OPERATIONS);
+    for (s64& delay : delays) {
+        delay = 1 + rng() % 10000;
+    }
+
+    BENCHMARK("indexed heap") {
+        Core::Timing::EventQueue queue;
+        u64 fifo_order = 0;
+        for (int i = 0; i < NUM_PENDING; ++i) {
+            queue.Push({delays[i], fifo_order, fifo_order, &event_type});
+            ++fifo_order;
+        }
+        for (const s64 delay : delays) {
+            const s64 now = queue.Pop().time;
+            queue.Push({now + delay, fifo_order, fifo_order, &event_type});
+            ++fifo_order;
+        }
+        return queue.Top().time;
+    };
+
+    BENCHMARK("binary heap") {
+        std::vector<Core::Timing::Event> queue;
+        u64 fifo_order = 0;
+        for (int i = 0; i < NUM_PENDING; ++i) {
+            queue.push_back({delays[i], fifo_order, fifo_order, &event_type});
+            std::push_heap(queue.begin(), queue.end(), std::greater<>());
+            ++fifo_order;
+        }
+        for (const s64 delay : delays) {
+            std::pop_heap(queue.begin(), queue.end(), std::greater<>());
+            const s64 now = queue.back().time;
+            queue.back() = {now + delay, fifo_order, fifo_order, &event_type};
+            std::push_heap(queue.begin(), queue.end(), std::greater<>());
+            ++fifo_order;
+        }
+        return queue.front().time;
+    };
+}
+
 // TODO: Add tests for multiple timers
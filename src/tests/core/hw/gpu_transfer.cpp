@@ -0,0 +1,144 @@
+// Copyright 2022 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <random>
+#include <string>
+#include <vector>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include "core/hw/gpu_transfer.h"
+
+using GPU::Regs;
+using PixelFormat = Regs::PixelFormat;
+
+constexpr std::array<PixelFormat, 5> PIXEL_FORMATS = {
+    PixelFormat::RGBA8, PixelFormat::RGB8, PixelFormat::RGB565, PixelFormat::RGB5A1,
+    PixelFormat::RGBA4,
+};
+
+static Regs::DisplayTransferConfig MakeConfig(PixelFormat input_format, PixelFormat output_format,
+                                              u32 width, u32 height, bool input_linear,
+                                              bool dont_swizzle, u32 scaling, bool flip) {
+    Regs::DisplayTransferConfig config{};
+    config.input_width.Assign(width);
+    config.input_height.Assign(height);
+    config.output_width.Assign(width);
+    config.output_height.Assign(height);
+    config.input_format.Assign(input_format);
+    config.output_format.Assign(output_format);
+    config.input_linear.Assign(input_linear);
+    config.dont_swizzle.Assign(dont_swizzle);
+    config.scaling.Assign(static_cast<Regs::DisplayTransferConfig::ScalingMode>(scaling));
+    config.flip_vertically.Assign(flip);
+    return config;
+}
+
+static std::vector<u8> RandomImage(std::mt19937& rng, std::size_t size) {
+    std::vector<u8> image(size);
+    std::uniform_int_distribution<u32> distribution(0, 255);
+    for (u8& byte : image) {
+        byte = static_cast<u8>(distribution(rng));
+    }
+    return image;
+}
+
+static void CheckTransfer(std::mt19937& rng, const Regs::DisplayTransferConfig& config) {
+    const std::size_t input_size = config.input_width * config.input_height *
+                                   Regs::BytesPerPixel(config.input_format);
+    const std::size_t output_size = config.output_width * config.output_height *
+                                    Regs::BytesPerPixel(config.output_format);
+    const std::vector<u8> input = RandomImage(rng, input_size);
+    std::vector<u8> expected(output_size, 0xCD);
+    std::vector<u8> actual(output_size, 0xCD);
+
+    GPU::PerformDisplayTransferGeneric(config, input.data(), expected.data());
+    GPU::PerformDisplayTransfer(config, input.data(), actual.data());
+    REQUIRE(actual == expected);
+}
+
+TEST_CASE("PerformDisplayTransfer matches the per-pixel conversion", "[core][gpu]") {
+    std::mt19937 rng(42);
+
+    for (const PixelFormat input_format : PIXEL_FORMATS) {
+        for (const PixelFormat output_format : PIXEL_FORMATS) {
+            INFO("input format " << static_cast<u32>(input_format) << ", output format "
+                                 << static_cast<u32>(output_format));
+            for (const bool flip : {false, true}) {
+                INFO("flip " << flip);
+                for (const bool dont_swizzle : {false, true}) {
+                    INFO("dont_swizzle " << dont_swizzle);
+                    // Scaling is only supported on tiled input
+                    for (u32 scaling = 0; scaling <= Regs::DisplayTransferConfig::ScaleXY;
+                         ++scaling) {
+                        INFO("scaling " << scaling);
+                        CheckTransfer(rng, MakeConfig(input_format, output_format, 32, 32, false,
+                                                      dont_swizzle, scaling, flip));
+                    }
+                    CheckTransfer(rng, MakeConfig(input_format, output_format, 32, 24, true,
+                                                  dont_swizzle, 0, flip));
+                    // Linear images don't have to be made of whole tiles
+                    CheckTransfer(rng, MakeConfig(input_format, output_format, 13, 5, true, true,
+                                                  0, flip));
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE("PerformMemoryFill writes the last value in full", "[core][gpu]") {
+    Regs::MemoryFillConfig config{};
+    std::array<u8, 16> memory{};
+
+    SECTION("24-bit") {
+        config.fill_24bit.Assign(1);
+        config.value_24bit_r.Assign(0x11);
+        config.value_24bit_g.Assign(0x22);
+        config.value_24bit_b.Assign(0x33);
+        GPU::PerformMemoryFill(config, memory.data(), memory.data() + 7);
+        const std::array<u8, 16> expected = {0x11, 0x22, 0x33, 0x11, 0x22, 0x33, 0x11, 0x22, 0x33};
+        REQUIRE(memory == expected);
+    }
+
+    SECTION("32-bit") {
+        config.fill_32bit.Assign(1);
+        config.value_32bit = 0x44332211;
+        GPU::PerformMemoryFill(config, memory.data(), memory.data() + 7);
+        const std::array<u8, 16> expected = {0x11, 0x22, 0x33, 0x44};
+        REQUIRE(memory == expected);
+    }
+
+    SECTION("16-bit") {
+        config.value_16bit.Assign(0x2211);
+        GPU::PerformMemoryFill(config, memory.data(), memory.data() + 5);
+        const std::array<u8, 16> expected = {0x11, 0x22, 0x11, 0x22, 0x11, 0x22};
+        REQUIRE(memory == expected);
+    }
+}
+
+TEST_CASE("PerformDisplayTransfer performance", "[.benchmark][core][gpu]") {
+    std::mt19937 rng(42);
+    constexpr u32 width = 240;
+    constexpr u32 height = 400;
+    const std::vector<u8> input = RandomImage(rng, width * height * 4);
+    std::vector<u8> output(width * height * 4);
+
+    for (const PixelFormat input_format : PIXEL_FORMATS) {
+        for (const PixelFormat output_format : PIXEL_FORMATS) {
+            const auto config =
+                MakeConfig(input_format, output_format, width, height, false, false, 0, false);
+            const auto name = std::to_string(static_cast<u32>(input_format)) + " to " +
+                              std::to_string(static_cast<u32>(output_format));
+
+            BENCHMARK("tiled " + name) {
+                GPU::PerformDisplayTransfer(config, input.data(), output.data());
+                return output[0];
+            };
+            BENCHMARK("per pixel " + name) {
+                GPU::PerformDisplayTransferGeneric(config, input.data(), output.data());
+                return output[0];
+            };
+        }
+    }
+}
@@ -2,13 +2,22 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
 #include <catch2/catch_test_macros.hpp>
+#include "common/archives.h"
 #include "core/core.h"
 #include "core/core_timing.h"
 #include "core/hle/kernel/memory.h"
 #include "core/hle/kernel/process.h"
 #include "core/hle/kernel/shared_page.h"
 #include "core/memory.h"
+#include "core/mmio.h"
 
 TEST_CASE("Memory::IsValidVirtualAddress", "[core][memory]") {
     Core::Timing timing(1, 100);
@@ -55,3 +64,201 @@ TEST_CASE("Memory::IsValidVirtualAddress", "[core][memory]") {
         CHECK(Memory::IsValidVirtualAddress(*process, Memory::CONFIG_MEMORY_VADDR) == false);
     }
 }
+
+TEST_CASE("Memory::FindDirtyPages", "[core][memory]") {
+    constexpr std::size_t num_pages = 8;
+    std::vector<u8> keyframe(num_pages * Memory::PAGE_SIZE, 0xAB);
+    std::vector<u8> memory = keyframe;
+
+    CHECK(Memory::FindDirtyPages(memory.data(), keyframe.data(), memory.size()).empty());
+
+    memory[0] = 0;
+    memory[3 * Memory::PAGE_SIZE + 17] = 0;
+    memory[num_pages * Memory::PAGE_SIZE - 1] = 0;
+    CHECK(Memory::FindDirtyPages(memory.data(), keyframe.data(), memory.size()) ==
+          std::vector<u32>{0, 3, num_pages - 1});
+}
+
+TEST_CASE("Memory::SerializeFCRAMDelta", "[core][memory]") {
+    constexpr std::size_t num_pages = 64;
+    constexpr std::size_t size = num_pages * Memory::PAGE_SIZE;
+    std::vector<u8> fcram(size);
+    for (std::size_t i = 0; i < size; ++i) {
+        fcram[i] = static_cast<u8>(i * 7 + i / Memory::PAGE_SIZE);
+    }
+    const std::vector<u8> keyframe = fcram;
+
+    // Dirty a few pages, including single bytes and the last page
+    fcram[5] = 0x11;
+    std::memset(&fcram[7 * Memory::PAGE_SIZE], 0x22, 3 * Memory::PAGE_SIZE);
+    fcram[size - 1] = 0x33;
+    const std::vector<u8> expected = fcram;
+
+    std::ostringstream saved;
+    {
+        Memory::FCRAMDeltaScope scope(keyframe.data(), keyframe.size());
+        oarchive oa{saved};
+        Memory::SerializeFCRAMDelta(oa, fcram.data(), size);
+    }
+    // Only the five dirty pages are stored
+    CHECK(saved.str().size() < 6 * Memory::PAGE_SIZE);
+
+    std::fill(fcram.begin(), fcram.end(), 0x5A);
+    {
+        std::istringstream loaded{saved.str()};
+        Memory::FCRAMDeltaScope scope(keyframe.data(), keyframe.size());
+        iarchive ia{loaded};
+        Memory::SerializeFCRAMDelta(ia, fcram.data(), size);
+    }
+    REQUIRE(fcram == expected);
+
+    SECTION("loading against another keyframe fails") {
+        std::istringstream loaded{saved.str()};
+        Memory::FCRAMDeltaScope scope(keyframe.data(), size - Memory::PAGE_SIZE);
+        iarchive ia{loaded};
+        REQUIRE_THROWS_AS(Memory::SerializeFCRAMDelta(ia, fcram.data(), size),
+                          std::runtime_error);
+    }
+}
+
+TEST_CASE("Memory::GetFastmemBase", "[core][memory]") {
+    Core::Timing timing(1, 100);
+    Memory::MemorySystem memory;
+    Kernel::KernelSystem kernel(
+        memory, timing, [] {}, 0, 1, 0);
+    auto process = kernel.CreateProcess(kernel.CreateCodeSet("", 0));
+    u8* const fastmem = memory.GetFastmemBase(*process->vm_manager.page_table);
+    if (fastmem == nullptr) {
+        SUCCEED("fastmem is not supported on this host");
+        return;
+    }
+
+    SECTION("memory mapped after the view was created is accessible through it") {
+        kernel.HandleSpecialMapping(process->vm_manager,
+                                    {Memory::VRAM_VADDR, Memory::VRAM_SIZE, false, false});
+        u8* const vram = memory.GetPhysicalPointer(Memory::VRAM_PADDR);
+        vram[0x1234] = 0x5A;
+        CHECK(fastmem[Memory::VRAM_VADDR + 0x1234] == 0x5A);
+        fastmem[Memory::VRAM_VADDR + 0x20] = 0xA5;
+        CHECK(vram[0x20] == 0xA5);
+    }
+
+    SECTION("views created later map the memory that is already there") {
+        kernel.HandleSpecialMapping(process->vm_manager,
+                                    {Memory::VRAM_VADDR, Memory::VRAM_SIZE, false, false});
+        auto other = kernel.CreateProcess(kernel.CreateCodeSet("", 0));
+        kernel.HandleSpecialMapping(other->vm_manager,
+                                    {Memory::VRAM_VADDR, Memory::VRAM_SIZE, false, false});
+        u8* const other_fastmem = memory.GetFastmemBase(*other->vm_manager.page_table);
+        REQUIRE(other_fastmem != nullptr);
+        fastmem[Memory::VRAM_VADDR + 0x40] = 0x3C;
+        CHECK(other_fastmem[Memory::VRAM_VADDR + 0x40] == 0x3C);
+    }
+}
+
+namespace {
+
+/// Register file with plain storage, so exclusive stores to MMIO can be observed
+class TestMMIORegion final : public Memory::MMIORegion {
+public:
+    bool IsValidAddress(VAddr addr) override {
+        return true;
+    }
+
+    u8 Read8(VAddr addr) override {
+        return Read<u8>(addr);
+    }
+    u16 Read16(VAddr addr) override {
+        return Read<u16>(addr);
+    }
+    u32 Read32(VAddr addr) override {
+        return Read<u32>(addr);
+    }
+    u64 Read64(VAddr addr) override {
+        return Read<u64>(addr);
+    }
+    bool ReadBlock(VAddr src_addr, void* dest_buffer, std::size_t size) override {
+        return false;
+    }
+
+    void Write8(VAddr addr, u8 data) override {
+        Write(addr, data);
+    }
+    void Write16(VAddr addr, u16 data) override {
+        Write(addr, data);
+    }
+    void Write32(VAddr addr, u32 data) override {
+        Write(addr, data);
+    }
+    void Write64(VAddr addr, u64 data) override {
+        Write(addr, data);
+    }
+    bool WriteBlock(VAddr dest_addr, const void* src_buffer, std::size_t size) override {
+        return false;
+    }
+
+private:
+    template <typename T>
+    T Read(VAddr addr) const {
+        T value;
+        std::memcpy(&value, &registers[addr & (registers.size() - 1)], sizeof(T));
+        return value;
+    }
+
+    template <typename T>
+    void Write(VAddr addr, T data) {
+        std::memcpy(&registers[addr & (registers.size() - 1)], &data, sizeof(T));
+    }
+
+    std::array<u8, 0x100> registers{};
+};
+
+/// Checks a matching and a mismatching exclusive store of every width at addr
+void CheckWriteExclusive(Memory::MemorySystem& memory, VAddr addr) {
+    memory.Write64(addr, 0x0123456789ABCDEF);
+    CHECK(memory.WriteExclusive8(addr, 0x11, 0xEF));
+    CHECK(memory.Read8(addr) == 0x11);
+    CHECK_FALSE(memory.WriteExclusive8(addr, 0x22, 0xEF));
+    CHECK(memory.Read8(addr) == 0x11);
+
+    memory.Write64(addr, 0x0123456789ABCDEF);
+    CHECK(memory.WriteExclusive16(addr, 0x1122, 0xCDEF));
+    CHECK(memory.Read16(addr) == 0x1122);
+    CHECK_FALSE(memory.WriteExclusive16(addr, 0x3344, 0xCDEF));
+    CHECK(memory.Read16(addr) == 0x1122);
+
+    memory.Write64(addr, 0x0123456789ABCDEF);
+    CHECK(memory.WriteExclusive32(addr, 0x11223344, 0x89ABCDEF));
+    CHECK(memory.Read32(addr) == 0x11223344);
+    CHECK_FALSE(memory.WriteExclusive32(addr, 0x55667788, 0x89ABCDEF));
+    CHECK(memory.Read32(addr) == 0x11223344);
+
+    memory.Write64(addr, 0x0123456789ABCDEF);
+    CHECK(memory.WriteExclusive64(addr, 0x1122334455667788, 0x0123456789ABCDEF));
+    CHECK(memory.Read64(addr) == 0x1122334455667788);
+    CHECK_FALSE(memory.WriteExclusive64(addr, 0x99AABBCCDDEEFF00, 0x0123456789ABCDEF));
+    CHECK(memory.Read64(addr) == 0x1122334455667788);
+}
+
+} // Anonymous namespace
+
+TEST_CASE("Memory::WriteExclusive", "[core][memory]") {
+    Core::Timing timing(1, 100);
+    Memory::MemorySystem memory;
+    Kernel::KernelSystem kernel(
+        memory, timing, [] {}, 0, 1, 0);
+    auto process = kernel.CreateProcess(kernel.CreateCodeSet("", 0));
+    memory.SetCurrentPageTable(process->vm_manager.page_table);
+
+    SECTION("memory backed pages compare and swap") {
+        kernel.HandleSpecialMapping(process->vm_manager,
+                                    {Memory::VRAM_VADDR, Memory::VRAM_SIZE, false, false});
+        CheckWriteExclusive(memory, Memory::VRAM_VADDR + 0x100);
+    }
+
+    SECTION("MMIO pages compare before they store") {
+        memory.MapIoRegion(*process->vm_manager.page_table, Memory::IO_AREA_VADDR,
+                           Memory::PAGE_SIZE, std::make_shared<TestMMIORegion>());
+        CheckWriteExclusive(memory, Memory::IO_AREA_VADDR + 0x10);
+    }
+}
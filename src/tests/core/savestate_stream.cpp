@@ -0,0 +1,164 @@
+// Copyright 2022 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <ostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "common/file_util.h"
+#include "common/swap.h"
+#include "common/thread_worker.h"
+#include "core/savestate_stream.h"
+
+namespace {
+
+/// Temporary directory which is removed again with everything in it
+class TempDir {
+public:
+    TempDir() {
+        path = std::filesystem::temp_directory_path() /
+               ("citra_savestate_test_" + std::to_string(std::random_device{}()));
+        std::filesystem::create_directories(path);
+    }
+    ~TempDir() {
+        std::filesystem::remove_all(path);
+    }
+
+    std::string File(const std::string& name) const {
+        return (path / name).string();
+    }
+
+private:
+    std::filesystem::path path;
+};
+
+/// Save state contents that compress, but not to nothing
+std::string MakeData(std::size_t size) {
+    std::string data(size, '\0');
+    for (std::size_t i = 0; i < size; ++i) {
+        data[i] = static_cast<char>((i * i) >> 7);
+    }
+    return data;
+}
+
+/**
+ * Writes data through a ChunkStreamBuffer and a SaveStateWriter to path. The file starts with
+ * the u64 receiving the uncompressed size, like the size field of the save state header.
+ */
+void WriteSaveState(Common::ThreadWorker& workers, const std::string& path,
+                    const std::string& data, bool success = true) {
+    const std::string temp_path = path + ".tmp";
+    FileUtil::IOFile file(temp_path, "wb");
+    REQUIRE(file.IsOpen());
+    const u64_le placeholder = 0;
+    REQUIRE(file.WriteBytes(&placeholder, sizeof(placeholder)) == sizeof(placeholder));
+
+    auto writer =
+        std::make_shared<Core::SaveStateWriter>(workers, path, temp_path, std::move(file), 0);
+    // Small chunks, so that the data is spread over many frames compressed in parallel
+    Core::ChunkStreamBuffer buffer{
+        [&writer](std::vector<u8> chunk) { writer->AddChunk(std::move(chunk)); }, 1000};
+    std::ostream stream{&buffer};
+    stream.write(data.data(), static_cast<std::streamsize>(data.size()));
+    buffer.Finish();
+    writer->Finish(success);
+    workers.WaitForRequests();
+}
+
+std::vector<u8> ReadFile(const std::string& path) {
+    std::vector<u8> contents(FileUtil::GetSize(path));
+    FileUtil::IOFile file(path, "rb");
+    REQUIRE(file.ReadBytes(contents.data(), contents.size()) == contents.size());
+    return contents;
+}
+
+/// Decompresses the frames following the size field of a file written by WriteSaveState
+std::string Decompress(const std::vector<u8>& contents, std::size_t length, u64 expected_size) {
+    std::size_t position = sizeof(u64_le);
+    return Core::DecompressSaveState(
+        [&](u8* buffer, std::size_t size) {
+            const std::size_t count = std::min(size, length - position);
+            std::memcpy(buffer, contents.data() + position, count);
+            position += count;
+            return count;
+        },
+        expected_size);
+}
+
+u64 RecordedSize(const std::vector<u8>& contents) {
+    u64_le size;
+    std::memcpy(&size, contents.data(), sizeof(size));
+    return size;
+}
+
+} // Anonymous namespace
+
+TEST_CASE("SaveStateWriter round trip", "[core][savestate]") {
+    TempDir dir;
+    Common::ThreadWorker workers{3, "SaveStateTest"};
+    const std::string path = dir.File("state.cst");
+    const std::string data = MakeData(50000);
+
+    SECTION("the file holds the data and its size") {
+        WriteSaveState(workers, path, data);
+        REQUIRE(!FileUtil::Exists(path + ".tmp"));
+        const auto contents = ReadFile(path);
+        REQUIRE(RecordedSize(contents) == data.size());
+        REQUIRE(Decompress(contents, contents.size(), data.size()) == data);
+        // Save states written before the size was recorded still load
+        REQUIRE(Decompress(contents, contents.size(), 0) == data);
+    }
+
+    SECTION("a new save state replaces the previous one") {
+        WriteSaveState(workers, path, MakeData(3000));
+        WriteSaveState(workers, path, data);
+        const auto contents = ReadFile(path);
+        REQUIRE(Decompress(contents, contents.size(), RecordedSize(contents)) == data);
+    }
+
+    SECTION("a failed save state keeps the previous one") {
+        WriteSaveState(workers, path, data);
+        const auto previous = ReadFile(path);
+        WriteSaveState(workers, path, MakeData(3000), false);
+        REQUIRE(!FileUtil::Exists(path + ".tmp"));
+        REQUIRE(ReadFile(path) == previous);
+    }
+}
+
+TEST_CASE("DecompressSaveState rejects damaged save states", "[core][savestate]") {
+    TempDir dir;
+    Common::ThreadWorker workers{3, "SaveStateTest"};
+    const std::string path = dir.File("state.cst");
+    const std::string data = MakeData(50000);
+    WriteSaveState(workers, path, data);
+    const auto contents = ReadFile(path);
+    const u64 size = RecordedSize(contents);
+
+    SECTION("truncated within a frame") {
+        REQUIRE_THROWS_AS(Decompress(contents, contents.size() - 5, size), std::runtime_error);
+        REQUIRE_THROWS_AS(Decompress(contents, contents.size() - 5, 0), std::runtime_error);
+    }
+
+    SECTION("truncated after a frame") {
+        // Equivalent to a file missing its last frames, which only the recorded size can reveal
+        REQUIRE_THROWS_AS(Decompress(contents, contents.size(), size + 1000), std::runtime_error);
+    }
+
+    SECTION("longer than recorded") {
+        REQUIRE_THROWS_AS(Decompress(contents, contents.size(), size - 1), std::runtime_error);
+    }
+
+    SECTION("corrupted") {
+        auto corrupted = contents;
+        corrupted[sizeof(u64_le) + 1] ^= 0xFF;
+        REQUIRE_THROWS_AS(Decompress(corrupted, corrupted.size(), size), std::runtime_error);
+    }
+}
@@ -0,0 +1,230 @@
+// Copyright 2022 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+#include "core/frontend/emu_window.h"
+#include "core/memory.h"
+#include "core/settings.h"
+#include "video_core/command_processor.h"
+#include "video_core/pica.h"
+#include "video_core/pica_state.h"
+#include "video_core/rasterizer_interface.h"
+#include "video_core/regs.h"
+#include "video_core/renderer_base.h"
+#include "video_core/shader/shader.h"
+#include "video_core/video_core.h"
+
+namespace {
+
+/// Window without any graphics context, as used when running headless
+class HeadlessWindow : public Frontend::EmuWindow {
+public:
+    void PollEvents() override {}
+    void MakeCurrent() override {}
+    void DoneCurrent() override {}
+};
+
+/// Rasterizer keeping the vertices of every triangle the primitive assembler outputs
+class RecordingRasterizer : public VideoCore::RasterizerInterface {
+public:
+    void AddTriangle(const Pica::Shader::OutputVertex& v0, const Pica::Shader::OutputVertex& v1,
+                     const Pica::Shader::OutputVertex& v2) override {
+        vertices.push_back(v0);
+        vertices.push_back(v1);
+        vertices.push_back(v2);
+    }
+    void DrawTriangles() override {}
+    void NotifyPicaRegisterChanged(u32 id) override {}
+    void FlushAll() override {}
+    void FlushRegion(PAddr addr, u32 size) override {}
+    void InvalidateRegion(PAddr addr, u32 size) override {}
+    void FlushAndInvalidateRegion(PAddr addr, u32 size) override {}
+    void ClearAll(bool flush) override {}
+
+    std::vector<Pica::Shader::OutputVertex> vertices;
+};
+
+class RecordingRenderer : public RendererBase {
+public:
+    explicit RecordingRenderer(Frontend::EmuWindow& window) : RendererBase(window) {
+        rasterizer = std::make_unique<RecordingRasterizer>();
+    }
+
+    VideoCore::ResultStatus Init() override {
+        return VideoCore::ResultStatus::Success;
+    }
+    void ShutDown() override {}
+    void SwapBuffers() override {}
+    void TryPresent(int timeout_ms) override {}
+    void PrepareVideoDumping() override {}
+    void CleanupVideoDumping() override {}
+
+    std::vector<Pica::Shader::OutputVertex>& Vertices() {
+        return static_cast<RecordingRasterizer*>(rasterizer.get())->vertices;
+    }
+};
+
+constexpr PAddr base_address = Memory::VRAM_PADDR;
+constexpr u32 vertex_stride = 16; // float position[3], u8 color[4]
+constexpr u32 num_array_vertices = 3000;
+constexpr u32 indices_u16_offset = num_array_vertices * vertex_stride;
+constexpr u32 num_indices_u16 = 3000;
+constexpr u32 indices_u8_offset = indices_u16_offset + num_indices_u16 * sizeof(u16);
+constexpr u32 num_indices_u8 = 1500;
+constexpr PAddr command_list_address = Memory::VRAM_PADDR + 0x100000;
+
+// o0 = v0, o1 = v0 * v1
+constexpr std::array<u32, 3> vertex_shader{
+    (0x13u << 26) | (0x0 << 21) | (0x00 << 12),                // mov o0, v0
+    (0x08u << 26) | (0x1 << 21) | (0x00 << 12) | (0x01 << 7), // mul o1, v0, v1
+    0x22u << 26,                                               // end
+};
+// Write all components, identity swizzles
+constexpr u32 operand_descriptor = 0xF | (0x1B << 5) | (0x1B << 14) | (0x1B << 23);
+
+void FillVertexData(Memory::MemorySystem& memory) {
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> position(-2.f, 2.f);
+    std::uniform_int_distribution<u32> byte(0, 255);
+
+    u8* data = memory.GetPhysicalPointer(base_address);
+    for (u32 vertex = 0; vertex < num_array_vertices; ++vertex) {
+        const std::array<float, 3> pos{position(rng), position(rng), position(rng)};
+        std::memcpy(data + vertex * vertex_stride, pos.data(), sizeof(pos));
+        for (u32 comp = 0; comp < 4; ++comp) {
+            data[vertex * vertex_stride + sizeof(pos) + comp] = static_cast<u8>(byte(rng));
+        }
+    }
+
+    // Indices repeat, so that the vertex cache is hit within and across the draws
+    std::uniform_int_distribution<u32> index(0, num_array_vertices - 1);
+    for (u32 i = 0; i < num_indices_u16; ++i) {
+        const u16 value = static_cast<u16>(index(rng));
+        std::memcpy(data + indices_u16_offset + i * sizeof(u16), &value, sizeof(value));
+    }
+    for (u32 i = 0; i < num_indices_u8; ++i) {
+        data[indices_u8_offset + i] = static_cast<u8>(byte(rng));
+    }
+}
+
+void SetupPipeline() {
+    using VSOutputAttributes = Pica::RasterizerRegs::VSOutputAttributes;
+    using Format = Pica::PipelineRegs::VertexAttributeFormat;
+    auto& regs = Pica::g_state.regs;
+
+    auto& attributes = regs.pipeline.vertex_attributes;
+    attributes.base_address.Assign(base_address / 16);
+    attributes.format0.Assign(Format::FLOAT);
+    attributes.size0.Assign(2);
+    attributes.format1.Assign(Format::UBYTE);
+    attributes.size1.Assign(3);
+    attributes.max_attribute_index.Assign(1);
+    attributes.attribute_loaders[0].data_offset.Assign(0);
+    attributes.attribute_loaders[0].comp0.Assign(0);
+    attributes.attribute_loaders[0].comp1.Assign(1);
+    attributes.attribute_loaders[0].byte_count.Assign(vertex_stride);
+    attributes.attribute_loaders[0].component_count.Assign(2);
+    regs.pipeline.max_input_attrib_index.Assign(1);
+
+    regs.vs.max_input_attribute_index.Assign(1);
+    regs.vs.input_attribute_to_register_map_low = 0x10;
+    regs.vs.output_mask.Assign(0b11);
+    regs.vs.main_offset.Assign(0);
+    std::copy(vertex_shader.begin(), vertex_shader.end(), Pica::g_state.vs.program_code.begin());
+    Pica::g_state.vs.swizzle_data[0] = operand_descriptor;
+    Pica::g_state.vs.MarkProgramCodeDirty();
+    Pica::g_state.vs.MarkSwizzleDataDirty();
+
+    regs.rasterizer.vs_output_total.Assign(2);
+    regs.rasterizer.vs_output_attributes[0].map_x.Assign(VSOutputAttributes::POSITION_X);
+    regs.rasterizer.vs_output_attributes[0].map_y.Assign(VSOutputAttributes::POSITION_Y);
+    regs.rasterizer.vs_output_attributes[0].map_z.Assign(VSOutputAttributes::POSITION_Z);
+    regs.rasterizer.vs_output_attributes[0].map_w.Assign(VSOutputAttributes::POSITION_W);
+    regs.rasterizer.vs_output_attributes[1].map_x.Assign(VSOutputAttributes::COLOR_R);
+    regs.rasterizer.vs_output_attributes[1].map_y.Assign(VSOutputAttributes::COLOR_G);
+    regs.rasterizer.vs_output_attributes[1].map_z.Assign(VSOutputAttributes::COLOR_B);
+    regs.rasterizer.vs_output_attributes[1].map_w.Assign(VSOutputAttributes::COLOR_A);
+}
+
+/// Command list with indexed and non-indexed draws, all large enough to be shaded in parallel
+std::vector<u32> BuildCommandList() {
+    using Topology = Pica::PipelineRegs::TriangleTopology;
+    std::vector<u32> list;
+    const auto write = [&list](u32 id, u32 value) {
+        list.push_back(value);
+        list.push_back(id | (0xF << 16));
+    };
+    const auto draw = [&](u32 topology, u32 num_vertices, u32 vertex_offset, u32 index_array) {
+        write(PICA_REG_INDEX(pipeline.triangle_topology), topology << 8);
+        write(PICA_REG_INDEX(pipeline.num_vertices), num_vertices);
+        write(PICA_REG_INDEX(pipeline.vertex_offset), vertex_offset);
+        write(PICA_REG_INDEX(pipeline.index_array), index_array);
+    };
+
+    // With a triangle list, the triangles hold every vertex sent to the primitive assembler
+    draw(static_cast<u32>(Topology::List), num_array_vertices, 0, 0);
+    write(PICA_REG_INDEX(pipeline.trigger_draw), 1);
+    draw(static_cast<u32>(Topology::List), num_indices_u16, 0, indices_u16_offset | (1u << 31));
+    write(PICA_REG_INDEX(pipeline.trigger_draw_indexed), 1);
+    draw(static_cast<u32>(Topology::List), num_indices_u8, 0, indices_u8_offset);
+    write(PICA_REG_INDEX(pipeline.trigger_draw_indexed), 1);
+
+    // Strips and fans check that the assembly itself sees the vertices in the same order
+    draw(static_cast<u32>(Topology::Strip), 2000, 500, 0);
+    write(PICA_REG_INDEX(pipeline.trigger_draw), 1);
+    draw(static_cast<u32>(Topology::Fan), num_indices_u16, 0, indices_u16_offset | (1u << 31));
+    write(PICA_REG_INDEX(pipeline.trigger_draw_indexed), 1);
+    return list;
+}
+
+std::vector<Pica::Shader::OutputVertex> RunDraws(Memory::MemorySystem& memory,
+                                                 RecordingRenderer& renderer, u16 num_threads) {
+    Settings::values.vertex_shader_threads = num_threads;
+    Pica::Init();
+    SetupPipeline();
+
+    const std::vector<u32> list = BuildCommandList();
+    std::memcpy(memory.GetPhysicalPointer(command_list_address), list.data(),
+                list.size() * sizeof(u32));
+    renderer.Vertices().clear();
+    Pica::CommandProcessor::ProcessCommandList(command_list_address,
+                                               static_cast<u32>(list.size() * sizeof(u32)));
+
+    Pica::Shutdown();
+    return renderer.Vertices();
+}
+
+} // Anonymous namespace
+
+TEST_CASE("Parallel vertex shading matches serial shading", "[video_core]") {
+    Memory::MemorySystem memory;
+    VideoCore::g_memory = &memory;
+    HeadlessWindow window;
+    VideoCore::g_renderer = std::make_unique<RecordingRenderer>(window);
+    auto& renderer = static_cast<RecordingRenderer&>(*VideoCore::g_renderer);
+    const u16 old_threads = Settings::values.vertex_shader_threads;
+
+    FillVertexData(memory);
+    const auto serial = RunDraws(memory, renderer, 1);
+    const u32 num_triangles = (num_array_vertices + num_indices_u16 + num_indices_u8) / 3 +
+                              (2000 - 2) + (num_indices_u16 - 2);
+    REQUIRE(serial.size() == num_triangles * 3);
+
+    for (const u16 num_threads : {2, 4}) {
+        const auto parallel = RunDraws(memory, renderer, num_threads);
+        REQUIRE(parallel.size() == serial.size());
+        for (std::size_t i = 0; i < serial.size(); ++i) {
+            REQUIRE(std::memcmp(&parallel[i], &serial[i], sizeof(serial[i])) == 0);
+        }
+    }
+
+    Settings::values.vertex_shader_threads = old_threads;
+    VideoCore::g_renderer.reset();
+    VideoCore::g_memory = nullptr;
+}
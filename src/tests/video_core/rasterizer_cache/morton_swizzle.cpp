@@ -0,0 +1,273 @@
+// Copyright 2022 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+#include "common/alignment.h"
+#include "common/thread_worker.h"
+#include "core/memory.h"
+#include "video_core/rasterizer_cache/morton_swizzle.h"
+#include "video_core/rasterizer_cache/pixel_format.h"
+#include "video_core/renderer_opengl/gl_vars.h"
+#include "video_core/utils.h"
+#include "video_core/video_core.h"
+
+using OpenGL::PixelFormat;
+
+namespace {
+
+constexpr std::array<PixelFormat, 8> PIXEL_FORMATS = {
+    PixelFormat::RGBA8, PixelFormat::RGB8, PixelFormat::RGB5A1, PixelFormat::RGB565,
+    PixelFormat::RGBA4, PixelFormat::D16,  PixelFormat::D24,    PixelFormat::D24S8,
+};
+
+/// The per-pixel copy the kernels replaced, used as the reference
+template <bool morton_to_gl, PixelFormat format>
+void ReferenceCopyTile(u32 stride, u8* tile_buffer, u8* gl_buffer) {
+    constexpr u32 bytes_per_pixel = OpenGL::GetFormatBpp(format) / 8;
+    constexpr u32 aligned_bytes_per_pixel = OpenGL::GetBytesPerPixel(format);
+    const bool gles = OpenGL::GLES;
+    for (u32 y = 0; y < 8; ++y) {
+        for (u32 x = 0; x < 8; ++x) {
+            u8* tile_ptr = tile_buffer + VideoCore::MortonInterleave(x, y) * bytes_per_pixel;
+            u8* gl_ptr = gl_buffer + ((7 - y) * stride + x) * aligned_bytes_per_pixel;
+            if constexpr (morton_to_gl) {
+                if constexpr (format == PixelFormat::D24S8) {
+                    gl_ptr[0] = tile_ptr[3];
+                    std::memcpy(gl_ptr + 1, tile_ptr, 3);
+                } else if (format == PixelFormat::RGBA8 && gles) {
+                    gl_ptr[0] = tile_ptr[3];
+                    gl_ptr[1] = tile_ptr[2];
+                    gl_ptr[2] = tile_ptr[1];
+                    gl_ptr[3] = tile_ptr[0];
+                } else if (format == PixelFormat::RGB8 && gles) {
+                    gl_ptr[0] = tile_ptr[2];
+                    gl_ptr[1] = tile_ptr[1];
+                    gl_ptr[2] = tile_ptr[0];
+                } else {
+                    std::memcpy(gl_ptr, tile_ptr, bytes_per_pixel);
+                }
+            } else {
+                if constexpr (format == PixelFormat::D24S8) {
+                    std::memcpy(tile_ptr, gl_ptr + 1, 3);
+                    tile_ptr[3] = gl_ptr[0];
+                } else if (format == PixelFormat::RGBA8 && gles) {
+                    tile_ptr[0] = gl_ptr[3];
+                    tile_ptr[1] = gl_ptr[2];
+                    tile_ptr[2] = gl_ptr[1];
+                    tile_ptr[3] = gl_ptr[0];
+                } else if (format == PixelFormat::RGB8 && gles) {
+                    tile_ptr[0] = gl_ptr[2];
+                    tile_ptr[1] = gl_ptr[1];
+                    tile_ptr[2] = gl_ptr[0];
+                } else {
+                    std::memcpy(tile_ptr, gl_ptr, bytes_per_pixel);
+                }
+            }
+        }
+    }
+}
+
+template <bool morton_to_gl, PixelFormat format>
+void ReferenceCopy(u32 stride, u32 height, u8* gl_buffer, PAddr base, PAddr start, PAddr end,
+                   Common::ThreadWorker*) {
+    constexpr u32 bytes_per_pixel = OpenGL::GetFormatBpp(format) / 8;
+    constexpr u32 tile_size = bytes_per_pixel * 64;
+    constexpr u32 aligned_bytes_per_pixel = OpenGL::GetBytesPerPixel(format);
+    gl_buffer += aligned_bytes_per_pixel - bytes_per_pixel;
+
+    const PAddr aligned_down_start = base + Common::AlignDown(start - base, tile_size);
+    const PAddr aligned_start = base + Common::AlignUp(start - base, tile_size);
+    const PAddr aligned_end = base + Common::AlignDown(end - base, tile_size);
+
+    const u32 begin_pixel_index = (aligned_down_start - base) / bytes_per_pixel;
+    u32 x = (begin_pixel_index % (stride * 8)) / 8;
+    u32 y = (begin_pixel_index / (stride * 8)) * 8;
+    gl_buffer += ((height - 8 - y) * stride + x) * aligned_bytes_per_pixel;
+
+    auto glbuf_next_tile = [&] {
+        x = (x + 8) % stride;
+        gl_buffer += 8 * aligned_bytes_per_pixel;
+        if (!x) {
+            y += 8;
+            gl_buffer -= stride * 9 * aligned_bytes_per_pixel;
+        }
+    };
+
+    u8* tile_buffer = VideoCore::g_memory->GetPhysicalPointer(start);
+    if (start < aligned_start && !morton_to_gl) {
+        std::array<u8, tile_size> tmp_buf;
+        ReferenceCopyTile<morton_to_gl, format>(stride, &tmp_buf[0], gl_buffer);
+        std::memcpy(tile_buffer, &tmp_buf[start - aligned_down_start],
+                    std::min(aligned_start, end) - start);
+        tile_buffer += aligned_start - start;
+        glbuf_next_tile();
+    }
+
+    const u8* const buffer_end = tile_buffer + aligned_end - aligned_start;
+    while (tile_buffer < buffer_end) {
+        ReferenceCopyTile<morton_to_gl, format>(stride, tile_buffer, gl_buffer);
+        tile_buffer += tile_size;
+        glbuf_next_tile();
+    }
+
+    if (end > std::max(aligned_start, aligned_end) && !morton_to_gl) {
+        std::array<u8, tile_size> tmp_buf;
+        ReferenceCopyTile<morton_to_gl, format>(stride, &tmp_buf[0], gl_buffer);
+        std::memcpy(tile_buffer, &tmp_buf[0], end - aligned_end);
+    }
+}
+
+using MortonFunc = OpenGL::MortonFunc;
+
+template <bool morton_to_gl>
+MortonFunc GetReferenceCopy(PixelFormat format) {
+    switch (format) {
+    case PixelFormat::RGBA8:
+        return ReferenceCopy<morton_to_gl, PixelFormat::RGBA8>;
+    case PixelFormat::RGB8:
+        return ReferenceCopy<morton_to_gl, PixelFormat::RGB8>;
+    case PixelFormat::RGB5A1:
+        return ReferenceCopy<morton_to_gl, PixelFormat::RGB5A1>;
+    case PixelFormat::RGB565:
+        return ReferenceCopy<morton_to_gl, PixelFormat::RGB565>;
+    case PixelFormat::RGBA4:
+        return ReferenceCopy<morton_to_gl, PixelFormat::RGBA4>;
+    case PixelFormat::D16:
+        return ReferenceCopy<morton_to_gl, PixelFormat::D16>;
+    case PixelFormat::D24:
+        return ReferenceCopy<morton_to_gl, PixelFormat::D24>;
+    case PixelFormat::D24S8:
+        return ReferenceCopy<morton_to_gl, PixelFormat::D24S8>;
+    default:
+        return nullptr;
+    }
+}
+
+void Randomize(std::mt19937& rng, u8* data, std::size_t size) {
+    std::uniform_int_distribution<u32> distribution(0, 255);
+    for (std::size_t i = 0; i < size; ++i) {
+        data[i] = static_cast<u8>(distribution(rng));
+    }
+}
+
+/// Surfaces are placed at the start of VRAM
+constexpr PAddr SURFACE_ADDRESS = Memory::VRAM_PADDR;
+
+struct Surface {
+    PixelFormat format;
+    u32 width;
+    u32 height;
+
+    u32 GuestSize() const {
+        return width * height * OpenGL::GetFormatBpp(format) / 8;
+    }
+
+    u32 GLSize() const {
+        return width * height * OpenGL::GetBytesPerPixel(format);
+    }
+};
+
+/// Runs both copies from the same initial guest memory and GL buffer and compares the results
+template <bool morton_to_gl>
+void CheckCopy(std::mt19937& rng, const Surface& surface, u32 start_offset, u32 end_offset,
+               Common::ThreadWorker* workers) {
+    u8* const guest = VideoCore::g_memory->GetPhysicalPointer(SURFACE_ADDRESS);
+    const u32 guest_size = surface.GuestSize();
+    std::vector<u8> initial_guest(guest_size);
+    std::vector<u8> initial_gl(surface.GLSize());
+    Randomize(rng, initial_guest.data(), initial_guest.size());
+    Randomize(rng, initial_gl.data(), initial_gl.size());
+
+    const auto run = [&](MortonFunc copy, std::vector<u8>& gl_buffer, std::vector<u8>& result) {
+        std::memcpy(guest, initial_guest.data(), guest_size);
+        gl_buffer = initial_gl;
+        copy(surface.width, surface.height, gl_buffer.data(), SURFACE_ADDRESS,
+             SURFACE_ADDRESS + start_offset, SURFACE_ADDRESS + end_offset, workers);
+        result.assign(guest, guest + guest_size);
+    };
+
+    const auto index = static_cast<std::size_t>(surface.format);
+    const MortonFunc copy =
+        morton_to_gl ? OpenGL::morton_to_gl_fns[index] : OpenGL::gl_to_morton_fns[index];
+    std::vector<u8> expected_gl, expected_guest, actual_gl, actual_guest;
+    run(GetReferenceCopy<morton_to_gl>(surface.format), expected_gl, expected_guest);
+    run(copy, actual_gl, actual_guest);
+    REQUIRE(actual_gl == expected_gl);
+    REQUIRE(actual_guest == expected_guest);
+}
+
+} // Anonymous namespace
+
+TEST_CASE("MortonCopy matches the per-pixel copy", "[video_core][rasterizer_cache]") {
+    Memory::MemorySystem memory;
+    VideoCore::g_memory = &memory;
+    std::mt19937 rng(42);
+    Common::ThreadWorker thread_workers(3, "MortonCopy");
+
+    for (Common::ThreadWorker* const workers : {static_cast<Common::ThreadWorker*>(nullptr),
+                                                &thread_workers}) {
+        INFO("threaded " << (workers != nullptr));
+        for (const bool gles : {false, true}) {
+            OpenGL::GLES = gles;
+            INFO("GLES " << gles);
+            for (const PixelFormat format : PIXEL_FORMATS) {
+                INFO("format " << static_cast<u32>(format));
+                const u32 tile_size = OpenGL::GetFormatBpp(format) * 64 / 8;
+
+                // Enough tiles for the copy to be split across threads
+                for (const Surface surface :
+                     {Surface{format, 64, 32}, Surface{format, 512, 512}}) {
+                    INFO("size " << surface.width << "x" << surface.height);
+                    const u32 size = surface.GuestSize();
+                    CheckCopy<true>(rng, surface, 0, size, workers);
+                    CheckCopy<false>(rng, surface, 0, size, workers);
+                    // Loads always cover whole tiles, flushes don't have to
+                    CheckCopy<true>(rng, surface, 3 * tile_size, size - tile_size, workers);
+                    CheckCopy<false>(rng, surface, 5, size - 7, workers);
+                    CheckCopy<false>(rng, surface, tile_size + 1, tile_size + 2, workers);
+                }
+            }
+        }
+    }
+    OpenGL::GLES = false;
+}
+
+TEST_CASE("MortonCopy performance", "[.benchmark][video_core][rasterizer_cache]") {
+    Memory::MemorySystem memory;
+    VideoCore::g_memory = &memory;
+    OpenGL::GLES = false;
+    Common::ThreadWorker workers(std::max(1U, std::thread::hardware_concurrency()) - 1,
+                                 "MortonCopy");
+
+    constexpr u32 iterations = 20;
+    for (const PixelFormat format : PIXEL_FORMATS) {
+        const Surface surface{format, 1024, 1024};
+        const auto index = static_cast<std::size_t>(format);
+        std::vector<u8> gl_buffer(surface.GLSize());
+
+        const auto throughput = [&](MortonFunc copy) {
+            const auto begin = std::chrono::steady_clock::now();
+            for (u32 i = 0; i < iterations; ++i) {
+                copy(surface.width, surface.height, gl_buffer.data(), SURFACE_ADDRESS,
+                     SURFACE_ADDRESS, SURFACE_ADDRESS + surface.GuestSize(), &workers);
+            }
+            const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+            return static_cast<double>(surface.GuestSize()) * iterations / elapsed.count() / 1e9;
+        };
+
+        WARN("format " << static_cast<u32>(format) << " morton to gl: "
+                       << throughput(GetReferenceCopy<true>(format)) << " GB/s per pixel, "
+                       << throughput(OpenGL::morton_to_gl_fns[index]) << " GB/s kernels");
+        WARN("format " << static_cast<u32>(format) << " gl to morton: "
+                       << throughput(GetReferenceCopy<false>(format)) << " GB/s per pixel, "
+                       << throughput(OpenGL::gl_to_morton_fns[index]) << " GB/s kernels");
+    }
+}
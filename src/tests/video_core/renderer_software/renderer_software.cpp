@@ -0,0 +1,104 @@
+// Copyright 2022 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <utility>
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+#include "core/frontend/emu_window.h"
+#include "core/hw/gpu.h"
+#include "core/hw/lcd.h"
+#include "core/memory.h"
+#include "video_core/renderer_software/renderer_software.h"
+#include "video_core/video_core.h"
+
+namespace {
+
+/// Window without any graphics context, as used when running headless
+class HeadlessWindow : public Frontend::EmuWindow {
+public:
+    void PollEvents() override {}
+    void MakeCurrent() override {}
+    void DoneCurrent() override {}
+};
+
+constexpr u32 fb_width = 240;
+constexpr u32 fb_height = 400;
+constexpr PAddr top_address = Memory::VRAM_PADDR;
+constexpr PAddr bottom_address = Memory::VRAM_PADDR + 0x100000;
+
+void SetupFramebuffer(GPU::Regs::FramebufferConfig& framebuffer, PAddr address, u32 height,
+                      GPU::Regs::PixelFormat format) {
+    framebuffer = {};
+    framebuffer.width.Assign(fb_width);
+    framebuffer.height.Assign(height);
+    framebuffer.address_left1 = address;
+    framebuffer.address_left2 = address;
+    framebuffer.color_format.Assign(format);
+    framebuffer.stride = fb_width * GPU::Regs::BytesPerPixel(format);
+}
+
+} // Anonymous namespace
+
+TEST_CASE("RendererSoftware presents the LCD framebuffers", "[video_core][renderer_software]") {
+    Memory::MemorySystem memory;
+    VideoCore::g_memory = &memory;
+    LCD::g_regs = {};
+
+    // The top screen shows an RGBA8 gradient, the bottom one a solid RGB565 color
+    SetupFramebuffer(GPU::g_regs.framebuffer_config[0], top_address, fb_height,
+                     GPU::Regs::PixelFormat::RGBA8);
+    u8* top = memory.GetPhysicalPointer(top_address);
+    for (u32 row = 0; row < fb_height; ++row) {
+        for (u32 x = 0; x < fb_width; ++x) {
+            // Stored as ABGR in memory
+            u8* pixel = top + (row * fb_width + x) * 4;
+            pixel[0] = 0xFF;
+            pixel[1] = static_cast<u8>(row);
+            pixel[2] = static_cast<u8>(x);
+            pixel[3] = 0x80;
+        }
+    }
+    SetupFramebuffer(GPU::g_regs.framebuffer_config[1], bottom_address, 320,
+                     GPU::Regs::PixelFormat::RGB565);
+    u8* bottom = memory.GetPhysicalPointer(bottom_address);
+    for (u32 i = 0; i < fb_width * 320; ++i) {
+        // Pure green
+        bottom[i * 2] = 0xE0;
+        bottom[i * 2 + 1] = 0x07;
+    }
+
+    HeadlessWindow window;
+    SwRenderer::RendererSoftware renderer(window);
+    REQUIRE(renderer.Init() == VideoCore::ResultStatus::Success);
+    renderer.SwapBuffers();
+    REQUIRE(renderer.GetCurrentFrame() == 1);
+
+    // The LCDs are mounted sideways, so framebuffer rows become screen columns
+    const auto& top_screen = renderer.GetScreen(SwRenderer::ScreenId::TopLeft);
+    REQUIRE(top_screen.width == fb_height);
+    REQUIRE(top_screen.height == fb_width);
+    REQUIRE(top_screen.pixels.size() == fb_width * fb_height * 4);
+    for (const auto [row, x] : {std::pair<u32, u32>{0, 0}, {17, 3}, {399, 239}, {250, 100}}) {
+        const u8* pixel = &top_screen.pixels[((fb_width - 1 - x) * top_screen.width + row) * 4];
+        REQUIRE(pixel[0] == 0x80);
+        REQUIRE(pixel[1] == static_cast<u8>(x));
+        REQUIRE(pixel[2] == static_cast<u8>(row));
+        REQUIRE(pixel[3] == 0xFF);
+    }
+
+    // Without a right eye framebuffer the right screen repeats the left one
+    REQUIRE(renderer.GetScreen(SwRenderer::ScreenId::TopRight).pixels == top_screen.pixels);
+
+    const auto& bottom_screen = renderer.GetScreen(SwRenderer::ScreenId::Bottom);
+    REQUIRE(bottom_screen.width == 320);
+    REQUIRE(bottom_screen.height == fb_width);
+    std::vector<u8> green(bottom_screen.width * bottom_screen.height * 4);
+    for (std::size_t i = 0; i < green.size(); i += 4) {
+        green[i + 1] = 0xFF;
+        green[i + 3] = 0xFF;
+    }
+    REQUIRE(bottom_screen.pixels == green);
+
+    renderer.ShutDown();
+}
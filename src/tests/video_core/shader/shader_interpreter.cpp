@@ -0,0 +1,314 @@
+// Copyright 2022 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <initializer_list>
+#include <memory>
+#include <random>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include "video_core/shader/shader_interpreter.h"
+
+using float24 = Pica::float24;
+using ShaderInterpreter = Pica::Shader::InterpreterEngine;
+using ShaderSetup = Pica::Shader::ShaderSetup;
+using UnitState = Pica::Shader::UnitState;
+
+namespace {
+
+// Raw PICA instruction encodings, so that the tests can use flow control with conditions
+
+enum Compare : u32 { EQ, NE, LT, LE, GT, GE };
+enum Condition : u32 { Or, And, JustX, JustY };
+
+constexpr u32 IN0 = 0x00, IN1 = 0x01, IN2 = 0x02, IN3 = 0x03;
+constexpr u32 TMP0 = 0x10, TMP1 = 0x11, TMP2 = 0x12, TMP5 = 0x15, TMP6 = 0x16;
+constexpr u32 OUT0 = 0x00, OUT1 = 0x01, OUT2 = 0x02, OUT3 = 0x03, OUT4 = 0x04, OUT5 = 0x05;
+
+constexpr u32 Uniform(u32 index) {
+    return 0x20 + index;
+}
+
+constexpr u32 Op(u32 opcode) {
+    return opcode << 26;
+}
+
+constexpr u32 Arith(u32 opcode, u32 dest, u32 src1, u32 src2, u32 desc = 0, u32 idx = 0) {
+    return Op(opcode) | (dest << 21) | (idx << 19) | (src1 << 12) | (src2 << 7) | desc;
+}
+
+constexpr u32 ArithInverted(u32 opcode, u32 dest, u32 src1, u32 src2, u32 desc = 0) {
+    return Op(opcode) | (dest << 21) | (src1 << 14) | (src2 << 7) | desc;
+}
+
+constexpr u32 Cmp(u32 src1, Compare x, Compare y, u32 src2, u32 desc = 0) {
+    return Op(0x2E) | (x << 24) | (y << 21) | (src1 << 12) | (src2 << 7) | desc;
+}
+
+constexpr u32 Mad(u32 dest, u32 src1, u32 src2, u32 src3, u32 desc = 0, u32 idx = 0) {
+    return (0x7u << 29) | (dest << 24) | (idx << 22) | (src1 << 17) | (src2 << 10) | (src3 << 5) |
+           desc;
+}
+
+constexpr u32 Flow(u32 opcode, Condition op, u32 refx, u32 refy, u32 dest, u32 num) {
+    return Op(opcode) | (refx << 25) | (refy << 24) | (op << 22) | (dest << 10) | num;
+}
+
+constexpr u32 UniformFlow(u32 opcode, u32 uniform, u32 dest, u32 num) {
+    return Op(opcode) | (uniform << 22) | (dest << 10) | num;
+}
+
+constexpr u32 ADD = 0x00, DP3 = 0x01, DP4 = 0x02, DPH = 0x03, EX2 = 0x05, LG2 = 0x06, MUL = 0x08,
+              SGE = 0x09, SLT = 0x0A, FLR = 0x0B, MAX = 0x0C, MIN = 0x0D, RCP = 0x0E, RSQ = 0x0F,
+              MOVA = 0x12, MOV = 0x13, SGEI = 0x1A, END = 0x22, CALLC = 0x25, IFC = 0x28,
+              LOOP = 0x29, JMPC = 0x2C;
+
+constexpr u32 IDENTITY = 0x1B; // xyzw
+
+/// Operand descriptor with the given destination mask and source swizzles
+constexpr u32 Desc(u32 dest_mask, u32 src1 = IDENTITY, u32 src2 = IDENTITY, u32 src3 = IDENTITY,
+                   bool negate_src1 = false, bool negate_src2 = false) {
+    return dest_mask | (negate_src1 << 4) | (src1 << 5) | (negate_src2 << 13) | (src2 << 14) |
+           (src3 << 23);
+}
+
+std::unique_ptr<ShaderSetup> MakeSetup(std::initializer_list<u32> code, std::mt19937& rng) {
+    auto setup = std::make_unique<ShaderSetup>();
+    std::copy(code.begin(), code.end(), setup->program_code.begin());
+
+    setup->swizzle_data[0] = Desc(0xF);
+    setup->swizzle_data[1] = Desc(0xC, 0x39, 0x4E);        // xy = src1.yzwx, src2.zwxy
+    setup->swizzle_data[2] = Desc(0xF, IDENTITY, IDENTITY, // -src1, -src2
+                                  IDENTITY, true, true);
+    setup->swizzle_data[3] = Desc(0x9, 0x00, 0xFF, 0xAA);  // xw = src1.xxxx, src2.wwww, src3.zzzz
+    setup->swizzle_data[4] = Desc(0xC);                    // xy
+
+    std::uniform_real_distribution<float> value(-4.f, 4.f);
+    for (auto& uniform : setup->uniforms.f) {
+        for (std::size_t i = 0; i < 4; ++i) {
+            uniform[i] = float24::FromFloat32(value(rng));
+        }
+    }
+    setup->uniforms.i[0] = {3, 0, 1, 0};
+    setup->engine_data.entry_point = 0;
+    return setup;
+}
+
+void RandomizeUnit(UnitState& unit, std::mt19937& rng) {
+    std::uniform_real_distribution<float> value(-4.f, 4.f);
+    // Include values hitting the special cases of the PICA float operations
+    constexpr std::array<float, 5> special = {0.f, -0.f, INFINITY, -INFINITY, NAN};
+
+    const auto randomize = [&](auto& registers) {
+        for (auto& reg : registers) {
+            for (std::size_t i = 0; i < 4; ++i) {
+                const bool use_special = rng() % 8 == 0;
+                reg[i] = float24::FromFloat32(use_special ? special[rng() % special.size()]
+                                                          : value(rng));
+            }
+        }
+    };
+    randomize(unit.registers.input);
+    randomize(unit.registers.temporary);
+    randomize(unit.registers.output);
+
+    // Index of a uniform for relative addressing
+    unit.registers.input[3].x = float24::FromFloat32(static_cast<float>(rng() % 4));
+    unit.registers.input[3].y = float24::FromFloat32(static_cast<float>(rng() % 4 + 8));
+    for (auto& address_register : unit.address_registers) {
+        address_register = 0;
+    }
+}
+
+/// Compares values bit by bit to tell signed zeros apart. The host decides the sign of NaNs
+/// depending on operand order, so any two NaNs are considered equal.
+bool SameValue(const float24& a, const float24& b) {
+    const float value_a = a.ToFloat32();
+    const float value_b = b.ToFloat32();
+    if (std::isnan(value_a) || std::isnan(value_b)) {
+        return std::isnan(value_a) && std::isnan(value_b);
+    }
+    return std::memcmp(&value_a, &value_b, sizeof(float)) == 0;
+}
+
+bool SameState(const UnitState& a, const UnitState& b) {
+    for (std::size_t reg = 0; reg < 16; ++reg) {
+        for (std::size_t i = 0; i < 4; ++i) {
+            if (!SameValue(a.registers.output[reg][i], b.registers.output[reg][i]) ||
+                !SameValue(a.registers.temporary[reg][i], b.registers.temporary[reg][i])) {
+                return false;
+            }
+        }
+    }
+    return a.address_registers[0] == b.address_registers[0] &&
+           a.address_registers[1] == b.address_registers[1] &&
+           a.address_registers[2] == b.address_registers[2] &&
+           a.conditional_code[0] == b.conditional_code[0] &&
+           a.conditional_code[1] == b.conditional_code[1];
+}
+
+/// Runs the shader on every batch size with random units and compares against single units
+void CheckBatchMatchesSingle(std::initializer_list<u32> code, unsigned seed) {
+    std::mt19937 rng(seed);
+    const auto setup = MakeSetup(code, rng);
+    ShaderInterpreter interpreter;
+
+    for (int iteration = 0; iteration < 50; ++iteration) {
+        for (std::size_t count = 1; count <= Pica::Shader::MAX_BATCH_SIZE; ++count) {
+            std::array<UnitState, Pica::Shader::MAX_BATCH_SIZE> batch;
+            std::array<UnitState, Pica::Shader::MAX_BATCH_SIZE> single;
+            for (std::size_t unit = 0; unit < count; ++unit) {
+                RandomizeUnit(batch[unit], rng);
+                single[unit] = batch[unit];
+                interpreter.Run(*setup, single[unit]);
+            }
+
+            interpreter.RunBatch(*setup, batch.data(), count);
+            for (std::size_t unit = 0; unit < count; ++unit) {
+                REQUIRE(SameState(batch[unit], single[unit]));
+            }
+        }
+    }
+}
+
+} // Anonymous namespace
+
+TEST_CASE("RunBatch arithmetic", "[video_core][shader]") {
+    CheckBatchMatchesSingle(
+        {
+            // clang-format off
+            Arith(MOV, TMP0, IN0, 0),
+            Arith(MUL, TMP1, IN0, IN1),
+            Arith(ADD, TMP1, TMP1, IN2, 2),
+            Arith(DP4, OUT0, IN0, Uniform(0)),
+            Arith(DP3, OUT1, IN1, Uniform(1), 1),
+            Arith(DPH, OUT2, IN0, TMP1),
+            Mad(OUT3, IN0, IN1, IN2),
+            Mad(TMP2, IN1, Uniform(2), TMP0, 3),
+            Arith(MAX, OUT4, IN0, IN1),
+            Arith(MIN, OUT4, IN2, TMP1, 1),
+            Arith(FLR, TMP0, IN1, 0),
+            Arith(RCP, OUT5, IN0, 0, 3),
+            Arith(RSQ, OUT5, IN1, 0, 1),
+            Arith(EX2, TMP5, IN2, 0),
+            Arith(LG2, TMP6, IN0, 0, 1),
+            Arith(SGE, TMP0, IN0, IN1, 3),
+            Arith(SLT, TMP1, IN2, Uniform(3), 1),
+            ArithInverted(SGEI, TMP2, IN0, Uniform(4)),
+            Op(END),
+            // clang-format on
+        },
+        1234);
+}
+
+TEST_CASE("RunBatch relative addressing", "[video_core][shader]") {
+    CheckBatchMatchesSingle(
+        {
+            // clang-format off
+            Arith(MOVA, 0, IN3, 0, 4),
+            Arith(DP4, OUT0, Uniform(0), IN0, 0, 1),
+            Arith(DP4, OUT1, Uniform(0), IN0, 0, 2),
+            Mad(OUT2, IN1, Uniform(4), IN2, 0, 1),
+            Arith(MOV, TMP0, Uniform(0), 0, 0, 2),
+            Op(END),
+            // clang-format on
+        },
+        2345);
+}
+
+TEST_CASE("RunBatch diverging conditions", "[video_core][shader]") {
+    CheckBatchMatchesSingle(
+        {
+            // clang-format off
+            /*  0 */ Cmp(IN0, LT, GT, Uniform(0)),
+            /*  1 */ Flow(IFC, JustX, 1, 0, 4, 2),
+            /*  2 */ Arith(MOV, OUT0, IN1, 0),
+            /*  3 */ Arith(ADD, OUT1, IN1, IN2),
+            /*  4 */ Arith(MOV, OUT0, IN2, 0),
+            /*  5 */ Arith(MUL, OUT1, IN1, IN2),
+            /*  6 */ Flow(CALLC, JustY, 0, 1, 11, 4),
+            /*  7 */ UniformFlow(LOOP, 0, 8, 0),
+            /*  8 */ Arith(ADD, TMP5, Uniform(4), TMP5, 0, 3),
+            /*  9 */ Arith(MOV, OUT2, TMP5, 0),
+            /* 10 */ Op(END),
+            /* 11 */ Arith(MOV, TMP6, IN2, 0),
+            /* 12 */ Flow(IFC, Or, 0, 1, 14, 0),
+            /* 13 */ Arith(MUL, TMP6, TMP6, IN1),
+            /* 14 */ Arith(MOV, OUT3, TMP6, 0),
+            // clang-format on
+        },
+        3456);
+}
+
+TEST_CASE("RunBatch diverging jumps", "[video_core][shader]") {
+    CheckBatchMatchesSingle(
+        {
+            // clang-format off
+            /*  0 */ Cmp(IN0, GT, LE, Uniform(0)),
+            /*  1 */ Flow(JMPC, JustX, 1, 0, 4, 0),
+            /*  2 */ Arith(MOV, OUT0, IN1, 0),
+            /*  3 */ Op(END),
+            /*  4 */ Flow(IFC, JustY, 0, 1, 7, 1),
+            /*  5 */ Arith(MOV, OUT0, IN2, 0),
+            /*  6 */ Op(END),
+            /*  7 */ Arith(MUL, OUT0, IN2, IN1),
+            /*  8 */ Op(END),
+            // clang-format on
+        },
+        4567);
+}
+
+TEST_CASE("RunBatch performance", "[.benchmark][video_core][shader]") {
+    std::mt19937 rng(42);
+    // Operand descriptors 5 to 8 write a single component, x to w
+    constexpr u32 X = 5, Y = 6, Z = 7, W = 8;
+
+    // Typical vertex transform: the position through two 4x4 matrices, then a normalized normal
+    // and a few more attributes
+    const auto setup = MakeSetup(
+        {
+            // clang-format off
+            Arith(DP4, TMP0, Uniform(0), IN0, X),
+            Arith(DP4, TMP0, Uniform(1), IN0, Y),
+            Arith(DP4, TMP0, Uniform(2), IN0, Z),
+            Arith(DP4, TMP0, Uniform(3), IN0, W),
+            Arith(DP4, OUT0, Uniform(4), TMP0, X),
+            Arith(DP4, OUT0, Uniform(5), TMP0, Y),
+            Arith(DP4, OUT0, Uniform(6), TMP0, Z),
+            Arith(DP4, OUT0, Uniform(7), TMP0, W),
+            Arith(DP3, TMP1, Uniform(8), IN1),
+            Arith(RSQ, TMP2, TMP1, 0),
+            Arith(MUL, OUT1, IN1, TMP2),
+            Mad(OUT2, IN2, Uniform(9), IN3),
+            Arith(MOV, OUT3, IN3, 0),
+            Arith(MAX, TMP5, Uniform(10), TMP0),
+            Arith(MUL, OUT4, Uniform(11), TMP5),
+            Op(END),
+            // clang-format on
+        },
+        rng);
+    setup->swizzle_data[X] = Desc(0x8);
+    setup->swizzle_data[Y] = Desc(0x4);
+    setup->swizzle_data[Z] = Desc(0x2);
+    setup->swizzle_data[W] = Desc(0x1);
+
+    ShaderInterpreter interpreter;
+    std::array<UnitState, Pica::Shader::MAX_BATCH_SIZE> units;
+    for (auto& unit : units) {
+        RandomizeUnit(unit, rng);
+    }
+
+    BENCHMARK("single units") {
+        for (auto& unit : units) {
+            interpreter.Run(*setup, unit);
+        }
+        return units[0].registers.output[0].x.ToFloat32();
+    };
+    BENCHMARK("batch") {
+        interpreter.RunBatch(*setup, units.data(), units.size());
+        return units[0].registers.output[0].x.ToFloat32();
+    };
+}
@@ -0,0 +1,67 @@
+// Copyright 2022 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <catch2/catch_test_macros.hpp>
+#include "video_core/swrasterizer/framebuffer.h"
+#include "video_core/swrasterizer/texturing.h"
+
+using namespace Pica::Rasterizer;
+
+using FramebufferRegs = Pica::FramebufferRegs;
+using TextureConfig = Pica::TexturingRegs::TextureConfig;
+
+TEST_CASE("GetWrapTexCoordFunc matches the per-pixel border check and wrapping",
+          "[video_core][swrasterizer]") {
+    for (u32 mode = 0; mode < 8; ++mode) {
+        const auto wrap_mode = static_cast<TextureConfig::WrapMode>(mode);
+        const WrapTexCoordFunc wrap = GetWrapTexCoordFunc(wrap_mode);
+        for (const unsigned size : {8u, 64u, 1024u}) {
+            for (int val = -3 * static_cast<int>(size); val < 3 * static_cast<int>(size); ++val) {
+                bool use_border = false;
+                if (wrap_mode == TextureConfig::ClampToBorder) {
+                    use_border = val < 0 || val >= static_cast<int>(size);
+                } else if (wrap_mode == TextureConfig::ClampToBorder2) {
+                    use_border = val >= static_cast<int>(size);
+                }
+                const int expected = use_border ? -1 : GetWrappedTexCoord(wrap_mode, val, size);
+                REQUIRE(wrap(val, size) == expected);
+            }
+        }
+    }
+}
+
+TEST_CASE("GetStencilActionFunc matches PerformStencilAction", "[video_core][swrasterizer]") {
+    for (u32 action = 0; action < 8; ++action) {
+        const auto stencil_action = static_cast<FramebufferRegs::StencilAction>(action);
+        const StencilActionFunc func = GetStencilActionFunc(stencil_action);
+        for (u32 old_stencil = 0; old_stencil < 256; ++old_stencil) {
+            for (const u8 ref : {0, 1, 0x7F, 0x80, 0xFE, 0xFF}) {
+                REQUIRE(func(static_cast<u8>(old_stencil), ref) ==
+                        PerformStencilAction(stencil_action, static_cast<u8>(old_stencil), ref));
+            }
+        }
+    }
+}
+
+TEST_CASE("GetLogicOpFunc matches LogicOp on every channel", "[video_core][swrasterizer]") {
+    for (u32 op = 0; op < 16; ++op) {
+        const auto logic_op = static_cast<FramebufferRegs::LogicOp>(op);
+        const LogicOpFunc func = GetLogicOpFunc(logic_op);
+        for (u32 src = 0; src < 256; src += 5) {
+            for (u32 dest = 0; dest < 256; dest += 3) {
+                const Common::Vec4<u8> src_color{static_cast<u8>(src), static_cast<u8>(~src),
+                                                 static_cast<u8>(src ^ 0x5A),
+                                                 static_cast<u8>(src + 1)};
+                const Common::Vec4<u8> dest_color{static_cast<u8>(dest),
+                                                  static_cast<u8>(dest ^ 0xA5),
+                                                  static_cast<u8>(~dest),
+                                                  static_cast<u8>(dest + 7)};
+                const auto result = func(src_color, dest_color);
+                for (std::size_t i = 0; i < 4; ++i) {
+                    REQUIRE(result[i] == LogicOp(src_color[i], dest_color[i], logic_op));
+                }
+            }
+        }
+    }
+}
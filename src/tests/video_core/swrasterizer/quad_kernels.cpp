@@ -0,0 +1,229 @@
+// Copyright 2022 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <random>
+#include <string>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include "core/memory.h"
+#include "video_core/pica_state.h"
+#include "video_core/swrasterizer/quad_kernels.h"
+#include "video_core/swrasterizer/rasterizer.h"
+#include "video_core/swrasterizer/texture_cache.h"
+#include "video_core/swrasterizer/texturing.h"
+#include "video_core/video_core.h"
+
+using namespace Pica::Rasterizer;
+
+using TevStageConfig = Pica::TexturingRegs::TevStageConfig;
+using Operation = TevStageConfig::Operation;
+
+constexpr std::array<Operation, 8> QUAD_OPERATIONS = {
+    Operation::Replace,         Operation::Modulate,
+    Operation::Add,             Operation::AddSigned,
+    Operation::Lerp,            Operation::Subtract,
+    Operation::MultiplyThenAdd, Operation::AddThenMultiply,
+};
+
+/// Reference implementation matching the per-pixel path of the rasterizer
+static QuadColor CombineQuadScalar(const TevStageConfig& stage,
+                                   const std::array<QuadColor, 3>& inputs) {
+    QuadColor output;
+    for (std::size_t lane = 0; lane < QUAD_SIZE; ++lane) {
+        const Common::Vec3<u8> color_inputs[3] = {inputs[0][lane].rgb(), inputs[1][lane].rgb(),
+                                                  inputs[2][lane].rgb()};
+        const std::array<u8, 3> alpha_inputs = {inputs[0][lane].a(), inputs[1][lane].a(),
+                                                inputs[2][lane].a()};
+        const auto color = ColorCombine(stage.color_op, color_inputs);
+        const u8 alpha = AlphaCombine(stage.alpha_op, alpha_inputs);
+
+        for (std::size_t i = 0; i < 3; ++i) {
+            output[lane][i] = std::min(255u, color[i] * stage.GetColorMultiplier());
+        }
+        output[lane][3] = std::min(255u, alpha * stage.GetAlphaMultiplier());
+    }
+    return output;
+}
+
+static TevStageConfig MakeStage(Operation color_op, Operation alpha_op, u32 color_scale,
+                                u32 alpha_scale) {
+    TevStageConfig stage{};
+    stage.color_op.Assign(color_op);
+    stage.alpha_op.Assign(alpha_op);
+    stage.color_scale.Assign(color_scale);
+    stage.alpha_scale.Assign(alpha_scale);
+    return stage;
+}
+
+static std::array<QuadColor, 3> RandomInputs(std::mt19937& rng) {
+    // Bias towards the extremes, which is where rounding and saturation go wrong
+    std::uniform_int_distribution<int> dist(-64, 255 + 64);
+    std::array<QuadColor, 3> inputs;
+    for (auto& input : inputs) {
+        for (auto& color : input) {
+            for (std::size_t i = 0; i < 4; ++i) {
+                color[i] = static_cast<u8>(std::clamp(dist(rng), 0, 255));
+            }
+        }
+    }
+    return inputs;
+}
+
+TEST_CASE("CombineQuad matches the per-pixel combiner", "[video_core][swrasterizer]") {
+    std::mt19937 rng(1234);
+
+    for (const Operation color_op : QUAD_OPERATIONS) {
+        for (const Operation alpha_op : QUAD_OPERATIONS) {
+            for (u32 scale = 0; scale < 4; ++scale) {
+                const auto stage = MakeStage(color_op, alpha_op, scale, 3 - scale);
+                REQUIRE(IsQuadCombinerSupported(stage));
+
+                for (int i = 0; i < 200; ++i) {
+                    const auto inputs = RandomInputs(rng);
+                    REQUIRE(CombineQuad(stage, inputs) == CombineQuadScalar(stage, inputs));
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE("CombineQuad rejects Dot3", "[video_core][swrasterizer]") {
+    REQUIRE(!IsQuadCombinerSupported(MakeStage(Operation::Dot3_RGB, Operation::Add, 0, 0)));
+    REQUIRE(!IsQuadCombinerSupported(MakeStage(Operation::Add, Operation::Dot3_RGBA, 0, 0)));
+}
+
+TEST_CASE("EvaluateQuadCoverage", "[video_core][swrasterizer]") {
+    std::mt19937 rng(5678);
+    std::uniform_int_distribution<s32> dist(-0x100000, 0x100000);
+
+    for (int i = 0; i < 1000; ++i) {
+        std::array<s32, 3> w, step_x, step_y;
+        for (std::size_t e = 0; e < 3; ++e) {
+            w[e] = dist(rng);
+            step_x[e] = dist(rng) / 16;
+            step_y[e] = dist(rng) / 16;
+        }
+
+        QuadEdgeValues edges;
+        const u32 coverage = EvaluateQuadCoverage(w, step_x, step_y, edges);
+
+        for (std::size_t lane = 0; lane < QUAD_SIZE; ++lane) {
+            const s32 dx = lane & 1;
+            const s32 dy = static_cast<s32>(lane >> 1);
+            bool covered = true;
+            for (std::size_t e = 0; e < 3; ++e) {
+                const s32 expected = w[e] + dx * step_x[e] + dy * step_y[e];
+                REQUIRE(edges[e][lane] == expected);
+                covered = covered && expected >= 0;
+            }
+            REQUIRE(((coverage >> lane) & 1) == (covered ? 1u : 0u));
+        }
+    }
+}
+
+TEST_CASE("CombineQuad performance", "[.benchmark][video_core][swrasterizer]") {
+    std::mt19937 rng(42);
+    const auto inputs = RandomInputs(rng);
+
+    for (const Operation op : QUAD_OPERATIONS) {
+        const auto stage = MakeStage(op, op, 1, 0);
+        const auto name = std::to_string(static_cast<u32>(op));
+
+        BENCHMARK("quad op " + name) {
+            return CombineQuad(stage, inputs);
+        };
+        BENCHMARK("scalar op " + name) {
+            return CombineQuadScalar(stage, inputs);
+        };
+    }
+}
+
+TEST_CASE("Fragment pipeline performance", "[.benchmark][video_core][swrasterizer]") {
+    using FramebufferRegs = Pica::FramebufferRegs;
+    constexpr u32 size = 256;
+
+    Memory::MemorySystem memory;
+    VideoCore::g_memory = &memory;
+    auto& regs = Pica::g_state.regs;
+    std::memset(&regs, 0, sizeof(regs));
+
+    // Depth tested, alpha blended output, the most common configuration for 3D scenes
+    auto& framebuffer = regs.framebuffer.framebuffer;
+    framebuffer.allow_color_write.Assign(1);
+    framebuffer.allow_depth_stencil_write.Assign(1);
+    framebuffer.color_format.Assign(FramebufferRegs::ColorFormat::RGBA8);
+    framebuffer.depth_format.Assign(FramebufferRegs::DepthFormat::D24S8);
+    framebuffer.color_buffer_address.Assign(Memory::VRAM_PADDR / 8);
+    framebuffer.depth_buffer_address.Assign((Memory::VRAM_PADDR + size * size * 4) / 8);
+    framebuffer.width.Assign(size);
+    framebuffer.height.Assign(size - 1);
+
+    auto& output_merger = regs.framebuffer.output_merger;
+    output_merger.alphablend_enable.Assign(1);
+    output_merger.alpha_blending.factor_source_rgb.Assign(
+        FramebufferRegs::BlendFactor::SourceAlpha);
+    output_merger.alpha_blending.factor_dest_rgb.Assign(
+        FramebufferRegs::BlendFactor::OneMinusSourceAlpha);
+    output_merger.alpha_blending.factor_source_a.Assign(FramebufferRegs::BlendFactor::One);
+    output_merger.depth_test_enable.Assign(1);
+    output_merger.depth_test_func.Assign(FramebufferRegs::CompareFunc::Always);
+    output_merger.depth_write_enable.Assign(1);
+    output_merger.red_enable.Assign(1);
+    output_merger.green_enable.Assign(1);
+    output_merger.blue_enable.Assign(1);
+    output_merger.alpha_enable.Assign(1);
+    regs.lighting.disable.Assign(1);
+    regs.rasterizer.viewport_depth_range.Assign(0x3F0000); // 1.0 as float24
+
+    // Every stage modulates the previous result with a constant color
+    for (auto* stage : {&regs.texturing.tev_stage0, &regs.texturing.tev_stage1,
+                        &regs.texturing.tev_stage2, &regs.texturing.tev_stage3,
+                        &regs.texturing.tev_stage4, &regs.texturing.tev_stage5}) {
+        const bool first = stage == &regs.texturing.tev_stage0;
+        const auto source = first ? TevStageConfig::Source::PrimaryColor
+                                  : TevStageConfig::Source::Previous;
+        stage->color_source1.Assign(source);
+        stage->color_source2.Assign(TevStageConfig::Source::Constant);
+        stage->alpha_source1.Assign(source);
+        stage->alpha_source2.Assign(TevStageConfig::Source::Constant);
+        stage->color_op.Assign(Operation::Modulate);
+        stage->alpha_op.Assign(Operation::Modulate);
+        stage->const_color = 0xF0E0D0C0;
+    }
+
+    // Two triangles covering the whole framebuffer
+    const auto f24 = [](float value) { return Pica::float24::FromFloat32(value); };
+    const auto make_vertex = [&](float x, float y, float red) {
+        Pica::Shader::OutputVertex output{};
+        output.pos.w = f24(1.0f);
+        output.color = {f24(red), f24(0.5f), f24(0.25f), f24(0.75f)};
+        Vertex vertex(output);
+        vertex.screenpos = {f24(x), f24(y), f24(0.5f)};
+        return vertex;
+    };
+    const Vertex top_left = make_vertex(0.0f, 0.0f, 0.0f);
+    const Vertex top_right = make_vertex(size, 0.0f, 0.5f);
+    const Vertex bottom_left = make_vertex(0.0f, size, 0.5f);
+    const Vertex bottom_right = make_vertex(size, size, 1.0f);
+
+    TextureCache texture_cache;
+    const auto draw = [&] {
+        ProcessTriangle(top_left, top_right, bottom_left, texture_cache);
+        ProcessTriangle(top_right, bottom_right, bottom_left, texture_cache);
+        return memory.GetPhysicalPointer(Memory::VRAM_PADDR)[0];
+    };
+
+    BENCHMARK("full screen, quad combiner") {
+        return draw();
+    };
+
+    // A Dot3 stage makes the texture environment fall back to evaluating every pixel separately
+    regs.texturing.tev_stage5.color_op.Assign(Operation::Dot3_RGB);
+    BENCHMARK("full screen, per-pixel combiner") {
+        return draw();
+    };
+}
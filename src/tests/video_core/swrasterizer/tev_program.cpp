@@ -0,0 +1,197 @@
+// Copyright 2022 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <random>
+#include <catch2/catch_test_macros.hpp>
+#include "video_core/swrasterizer/tev_program.h"
+#include "video_core/swrasterizer/texturing.h"
+
+using namespace Pica::Rasterizer;
+
+using TexturingRegs = Pica::TexturingRegs;
+using TevStageConfig = TexturingRegs::TevStageConfig;
+
+/// Straightforward per-pixel implementation the program has to match
+static Common::Vec4<u8> RunReference(const TexturingRegs& regs, const TevInputs& inputs) {
+    using Source = TevStageConfig::Source;
+
+    const auto tev_stages = regs.GetTevStages();
+    Common::Vec4<u8> combiner_output = {0, 0, 0, 0};
+    Common::Vec4<u8> combiner_buffer = {0, 0, 0, 0};
+    Common::Vec4<u8> next_combiner_buffer =
+        Common::MakeVec(regs.tev_combiner_buffer_color.r.Value(),
+                        regs.tev_combiner_buffer_color.g.Value(),
+                        regs.tev_combiner_buffer_color.b.Value(),
+                        regs.tev_combiner_buffer_color.a.Value())
+            .Cast<u8>();
+
+    for (unsigned index = 0; index < tev_stages.size(); ++index) {
+        const auto& stage = tev_stages[index];
+
+        const auto GetSource = [&](Source source) -> Common::Vec4<u8> {
+            switch (source) {
+            case Source::PrimaryColor:
+                return inputs.primary_color;
+            case Source::PrimaryFragmentColor:
+                return inputs.primary_fragment_color;
+            case Source::SecondaryFragmentColor:
+                return inputs.secondary_fragment_color;
+            case Source::Texture0:
+            case Source::Texture1:
+            case Source::Texture2:
+            case Source::Texture3:
+                return inputs.texture_color[static_cast<u32>(source) - 3];
+            case Source::PreviousBuffer:
+                return combiner_buffer;
+            case Source::Constant:
+                return Common::MakeVec(stage.const_r.Value(), stage.const_g.Value(),
+                                       stage.const_b.Value(), stage.const_a.Value())
+                    .Cast<u8>();
+            case Source::Previous:
+                return combiner_output;
+            default:
+                return {0, 0, 0, 0};
+            }
+        };
+
+        const Common::Vec3<u8> color_inputs[3] = {
+            GetColorModifier(stage.color_modifier1, GetSource(stage.color_source1)),
+            GetColorModifier(stage.color_modifier2, GetSource(stage.color_source2)),
+            GetColorModifier(stage.color_modifier3, GetSource(stage.color_source3)),
+        };
+        const auto color_output = ColorCombine(stage.color_op, color_inputs);
+
+        u8 alpha_output;
+        if (stage.color_op == TevStageConfig::Operation::Dot3_RGBA) {
+            alpha_output = color_output.x;
+        } else {
+            const std::array<u8, 3> alpha_inputs = {{
+                GetAlphaModifier(stage.alpha_modifier1, GetSource(stage.alpha_source1)),
+                GetAlphaModifier(stage.alpha_modifier2, GetSource(stage.alpha_source2)),
+                GetAlphaModifier(stage.alpha_modifier3, GetSource(stage.alpha_source3)),
+            }};
+            alpha_output = AlphaCombine(stage.alpha_op, alpha_inputs);
+        }
+
+        for (std::size_t i = 0; i < 3; ++i) {
+            combiner_output[i] = std::min(255u, color_output[i] * stage.GetColorMultiplier());
+        }
+        combiner_output[3] = std::min(255u, alpha_output * stage.GetAlphaMultiplier());
+
+        combiner_buffer = next_combiner_buffer;
+        if (regs.tev_combiner_buffer_input.TevStageUpdatesCombinerBufferColor(index)) {
+            next_combiner_buffer.r() = combiner_output.r();
+            next_combiner_buffer.g() = combiner_output.g();
+            next_combiner_buffer.b() = combiner_output.b();
+        }
+        if (regs.tev_combiner_buffer_input.TevStageUpdatesCombinerBufferAlpha(index)) {
+            next_combiner_buffer.a() = combiner_output.a();
+        }
+    }
+    return combiner_output;
+}
+
+static void RandomizeStage(TevStageConfig& stage, std::mt19937& rng, bool allow_dot3) {
+    constexpr std::array<u32, 10> sources = {0x0, 0x1, 0x2, 0x3, 0x4, 0x5, 0x6, 0xd, 0xe, 0xf};
+    constexpr std::array<u32, 10> color_modifiers = {0x0, 0x1, 0x2, 0x3, 0x4,
+                                                     0x5, 0x8, 0x9, 0xc, 0xd};
+    const auto pick = [&rng](const auto& values) {
+        return values[std::uniform_int_distribution<std::size_t>(0, values.size() - 1)(rng)];
+    };
+    const auto random = [&rng](u32 max) { return std::uniform_int_distribution<u32>(0, max)(rng); };
+
+    u32 color_op;
+    u32 alpha_op;
+    do {
+        color_op = random(9);
+        alpha_op = random(9);
+    } while (!allow_dot3 && (color_op == 6 || color_op == 7 || alpha_op == 6 || alpha_op == 7));
+
+    stage.sources_raw = pick(sources) | (pick(sources) << 4) | (pick(sources) << 8) |
+                        (pick(sources) << 16) | (pick(sources) << 20) | (pick(sources) << 24);
+    stage.modifiers_raw = pick(color_modifiers) | (pick(color_modifiers) << 4) |
+                          (pick(color_modifiers) << 8) | (random(7) << 12) | (random(7) << 16) |
+                          (random(7) << 20);
+    stage.ops_raw = color_op | (alpha_op << 16);
+    stage.const_color = static_cast<u32>(rng());
+    stage.scales_raw = random(3) | (random(3) << 16);
+}
+
+static TexturingRegs RandomRegs(std::mt19937& rng, bool allow_dot3) {
+    TexturingRegs regs;
+    std::memset(&regs, 0, sizeof(regs));
+    RandomizeStage(regs.tev_stage0, rng, allow_dot3);
+    RandomizeStage(regs.tev_stage1, rng, allow_dot3);
+    RandomizeStage(regs.tev_stage2, rng, allow_dot3);
+    RandomizeStage(regs.tev_stage3, rng, allow_dot3);
+    RandomizeStage(regs.tev_stage4, rng, allow_dot3);
+    // Leave the last stage as a passthrough every now and then
+    if (rng() % 2) {
+        RandomizeStage(regs.tev_stage5, rng, allow_dot3);
+    } else {
+        regs.tev_stage5.sources_raw = 0xf000f;
+    }
+    regs.tev_combiner_buffer_input.update_mask_rgb.Assign(rng() % 16);
+    regs.tev_combiner_buffer_input.update_mask_a.Assign(rng() % 16);
+    regs.tev_combiner_buffer_color.raw = static_cast<u32>(rng());
+    return regs;
+}
+
+static TevInputs RandomInputs(std::mt19937& rng) {
+    const auto color = [&rng] {
+        const u32 value = static_cast<u32>(rng());
+        return Common::MakeVec<u8>(value & 0xFF, (value >> 8) & 0xFF, (value >> 16) & 0xFF,
+                                   value >> 24);
+    };
+    return {color(), color(), color(), {color(), color(), color(), color()}};
+}
+
+TEST_CASE("TevProgram matches the per-pixel texture environment", "[video_core][swrasterizer]") {
+    std::mt19937 rng(4321);
+
+    for (int config = 0; config < 500; ++config) {
+        const auto regs = RandomRegs(rng, true);
+        const TevProgram program(regs);
+
+        for (int i = 0; i < 20; ++i) {
+            const auto inputs = RandomInputs(rng);
+            REQUIRE(program.Run(inputs) == RunReference(regs, inputs));
+        }
+    }
+}
+
+TEST_CASE("TevProgram quads match single fragments", "[video_core][swrasterizer]") {
+    std::mt19937 rng(8765);
+
+    for (int config = 0; config < 500; ++config) {
+        const auto regs = RandomRegs(rng, false);
+        const TevProgram program(regs);
+        REQUIRE(program.IsQuadSupported());
+
+        for (int i = 0; i < 20; ++i) {
+            const std::array<TevInputs, QUAD_SIZE> inputs = {
+                RandomInputs(rng), RandomInputs(rng), RandomInputs(rng), RandomInputs(rng)};
+            const auto output =
+                program.RunQuad({&inputs[0], &inputs[1], &inputs[2], &inputs[3]});
+            for (std::size_t lane = 0; lane < QUAD_SIZE; ++lane) {
+                REQUIRE(output[lane] == program.Run(inputs[lane]));
+            }
+        }
+    }
+}
+
+TEST_CASE("TevProgram cache", "[video_core][swrasterizer]") {
+    std::mt19937 rng(1111);
+    const auto regs_a = RandomRegs(rng, true);
+    const auto regs_b = RandomRegs(rng, true);
+
+    const auto& program_a = GetTevProgram(regs_a);
+    REQUIRE(program_a.GetKey() == TevProgram::MakeKey(regs_a));
+    const auto& program_b = GetTevProgram(regs_b);
+    REQUIRE(program_b.GetKey() == TevProgram::MakeKey(regs_b));
+    REQUIRE(&GetTevProgram(regs_a) == &program_a);
+}
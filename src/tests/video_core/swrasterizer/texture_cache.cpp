@@ -0,0 +1,78 @@
+// Copyright 2022 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+#include "core/memory.h"
+#include "video_core/swrasterizer/texture_cache.h"
+#include "video_core/texture/texture_decode.h"
+#include "video_core/video_core.h"
+
+using Pica::TexturingRegs;
+
+static Pica::Texture::TextureInfo MakeInfo(TexturingRegs::TextureFormat format, unsigned int width,
+                                           unsigned int height) {
+    Pica::Texture::TextureInfo info{};
+    info.physical_address = Memory::VRAM_PADDR;
+    info.width = width;
+    info.height = height;
+    info.format = format;
+    info.SetDefaultStride();
+    return info;
+}
+
+static std::vector<u8> Decode(const Pica::Texture::TextureInfo& info) {
+    std::vector<u8> texels(info.width * info.height * 4);
+    Pica::Texture::DecodeTexture(info, VideoCore::g_memory->GetPhysicalPointer(Memory::VRAM_PADDR),
+                                 texels.data());
+    return texels;
+}
+
+TEST_CASE("TextureCache revalidates invalidated textures", "[video_core][swrasterizer]") {
+    Memory::MemorySystem memory;
+    VideoCore::g_memory = &memory;
+    const auto info = MakeInfo(TexturingRegs::TextureFormat::RGB565, 32, 16);
+    const u32 size = static_cast<u32>(info.stride * (info.height / 8));
+    u8* guest = memory.GetPhysicalPointer(Memory::VRAM_PADDR);
+    for (u32 i = 0; i < size; ++i) {
+        guest[i] = static_cast<u8>(i * 7);
+    }
+
+    Pica::Rasterizer::TextureCache cache;
+    const auto texture = cache.GetTexture(info);
+    REQUIRE(texture != nullptr);
+    REQUIRE(texture->texels == Decode(info));
+    REQUIRE(cache.GetTexture(info) == texture);
+
+    SECTION("unchanged data is reused") {
+        cache.InvalidateRegion(Memory::VRAM_PADDR + size - 1, 1);
+        REQUIRE(cache.GetTexture(info) == texture);
+    }
+
+    SECTION("changed data is decoded again") {
+        guest[3] ^= 0xFF;
+        cache.InvalidateRegion(Memory::VRAM_PADDR + 3, 1);
+        const auto updated = cache.GetTexture(info);
+        REQUIRE(updated != texture);
+        REQUIRE(updated->texels == Decode(info));
+    }
+
+    SECTION("writes outside of the texture are ignored") {
+        guest[size] ^= 0xFF;
+        cache.InvalidateRegion(Memory::VRAM_PADDR + size, 1);
+        REQUIRE(cache.GetTexture(info) == texture);
+    }
+
+    SECTION("cleared textures are decoded again") {
+        cache.ClearAll();
+        const auto updated = cache.GetTexture(info);
+        REQUIRE(updated != texture);
+        REQUIRE(updated->texels == texture->texels);
+    }
+
+    SECTION("textures that aren't made of whole tiles are sampled from memory") {
+        REQUIRE(cache.GetTexture(MakeInfo(TexturingRegs::TextureFormat::RGB565, 4, 4)) == nullptr);
+    }
+}
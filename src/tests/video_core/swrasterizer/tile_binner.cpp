@@ -0,0 +1,144 @@
+// Copyright 2022 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include <random>
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+#include "core/memory.h"
+#include "video_core/pica_state.h"
+#include "video_core/swrasterizer/texture_cache.h"
+#include "video_core/swrasterizer/tile_binner.h"
+#include "video_core/video_core.h"
+
+using namespace Pica::Rasterizer;
+using FramebufferRegs = Pica::FramebufferRegs;
+
+namespace {
+
+// Neither dimension is a multiple of the tile size, so the last row and column are partial
+constexpr u32 width = 200;
+constexpr u32 height = 136;
+constexpr PAddr color_address = Memory::VRAM_PADDR;
+constexpr PAddr depth_address = Memory::VRAM_PADDR + 0x40000;
+constexpr u32 buffer_size = width * height * 4;
+
+/// Alpha blended color with a depth and stencil test, so the result depends on triangle order
+void SetupRegisters() {
+    auto& regs = Pica::g_state.regs;
+    std::memset(&regs, 0, sizeof(regs));
+
+    auto& framebuffer = regs.framebuffer.framebuffer;
+    framebuffer.allow_color_write.Assign(1);
+    framebuffer.allow_depth_stencil_write.Assign(1);
+    framebuffer.color_format.Assign(FramebufferRegs::ColorFormat::RGBA8);
+    framebuffer.depth_format.Assign(FramebufferRegs::DepthFormat::D24S8);
+    framebuffer.color_buffer_address.Assign(color_address / 8);
+    framebuffer.depth_buffer_address.Assign(depth_address / 8);
+    framebuffer.width.Assign(width);
+    framebuffer.height.Assign(height - 1);
+
+    auto& output_merger = regs.framebuffer.output_merger;
+    output_merger.alphablend_enable.Assign(1);
+    output_merger.alpha_blending.factor_source_rgb.Assign(
+        FramebufferRegs::BlendFactor::SourceAlpha);
+    output_merger.alpha_blending.factor_dest_rgb.Assign(
+        FramebufferRegs::BlendFactor::OneMinusSourceAlpha);
+    output_merger.alpha_blending.factor_source_a.Assign(FramebufferRegs::BlendFactor::One);
+    output_merger.alpha_blending.factor_dest_a.Assign(FramebufferRegs::BlendFactor::Zero);
+    output_merger.stencil_test.enable.Assign(1);
+    output_merger.stencil_test.func.Assign(FramebufferRegs::CompareFunc::Always);
+    output_merger.stencil_test.write_mask.Assign(0xFF);
+    output_merger.stencil_test.input_mask.Assign(0xFF);
+    output_merger.stencil_test.action_depth_pass.Assign(
+        FramebufferRegs::StencilAction::IncrementWrap);
+    output_merger.depth_test_enable.Assign(1);
+    output_merger.depth_test_func.Assign(FramebufferRegs::CompareFunc::LessThanOrEqual);
+    output_merger.depth_write_enable.Assign(1);
+    output_merger.red_enable.Assign(1);
+    output_merger.green_enable.Assign(1);
+    output_merger.blue_enable.Assign(1);
+    output_merger.alpha_enable.Assign(1);
+
+    // All texture combiner stages pass the primary color through
+    regs.lighting.disable.Assign(1);
+    regs.rasterizer.viewport_depth_range.Assign(0x3F0000); // 1.0 as float24
+}
+
+/// Large random triangles, most of them spanning several tiles
+std::vector<Vertex> MakeTriangles(std::mt19937& rng, std::size_t count) {
+    std::uniform_real_distribution<float> x_distribution(0.0f, static_cast<float>(width));
+    std::uniform_real_distribution<float> y_distribution(0.0f, static_cast<float>(height));
+    std::uniform_real_distribution<float> unit_distribution(0.0f, 1.0f);
+    const auto f24 = [](float value) { return Pica::float24::FromFloat32(value); };
+
+    std::vector<Vertex> vertices;
+    for (std::size_t i = 0; i < count * 3; ++i) {
+        Pica::Shader::OutputVertex output{};
+        output.pos.w = f24(1.0f);
+        output.color = {f24(unit_distribution(rng)), f24(unit_distribution(rng)),
+                        f24(unit_distribution(rng)), f24(unit_distribution(rng))};
+        Vertex vertex(output);
+        vertex.screenpos = {f24(x_distribution(rng)), f24(y_distribution(rng)),
+                            f24(unit_distribution(rng))};
+        vertices.push_back(vertex);
+    }
+    return vertices;
+}
+
+/// Clears color, depth and stencil to a fixed pattern
+void ClearBuffers() {
+    u8* color = VideoCore::g_memory->GetPhysicalPointer(color_address);
+    u8* depth = VideoCore::g_memory->GetPhysicalPointer(depth_address);
+    for (u32 i = 0; i < buffer_size; ++i) {
+        color[i] = static_cast<u8>(i * 13);
+        depth[i] = 0xFF;
+    }
+}
+
+std::vector<u8> ReadBuffers() {
+    const u8* color = VideoCore::g_memory->GetPhysicalPointer(color_address);
+    const u8* depth = VideoCore::g_memory->GetPhysicalPointer(depth_address);
+    std::vector<u8> buffers(color, color + buffer_size);
+    buffers.insert(buffers.end(), depth, depth + buffer_size);
+    return buffers;
+}
+
+std::vector<u8> RenderBinned(std::size_t num_threads, const std::vector<Vertex>& vertices) {
+    TextureCache texture_cache;
+    TileBinner binner(num_threads, texture_cache);
+    ClearBuffers();
+    for (std::size_t i = 0; i < vertices.size(); i += 3) {
+        binner.AddTriangle(vertices[i], vertices[i + 1], vertices[i + 2]);
+    }
+    binner.Flush();
+    return ReadBuffers();
+}
+
+} // Anonymous namespace
+
+TEST_CASE("TileBinner matches the serial rasterizer", "[video_core][swrasterizer]") {
+    Memory::MemorySystem memory;
+    VideoCore::g_memory = &memory;
+    SetupRegisters();
+
+    std::mt19937 rng(1);
+    const auto vertices = MakeTriangles(rng, 64);
+
+    TextureCache texture_cache;
+    ClearBuffers();
+    for (std::size_t i = 0; i < vertices.size(); i += 3) {
+        ProcessTriangle(vertices[i], vertices[i + 1], vertices[i + 2], texture_cache);
+    }
+    const auto expected = ReadBuffers();
+
+    const auto single_threaded = RenderBinned(1, vertices);
+    REQUIRE(single_threaded == expected);
+    const auto multi_threaded = RenderBinned(4, vertices);
+    REQUIRE(multi_threaded == expected);
+
+    // The batch actually drew something, blending over the cleared color
+    ClearBuffers();
+    REQUIRE(ReadBuffers() != expected);
+}
@@ -0,0 +1,85 @@
+// Copyright 2022 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include "video_core/texture/texture_decode.h"
+
+using Pica::TexturingRegs;
+using TextureFormat = TexturingRegs::TextureFormat;
+
+namespace {
+
+Pica::Texture::TextureInfo MakeInfo(TextureFormat format, unsigned int width,
+                                    unsigned int height) {
+    Pica::Texture::TextureInfo info{};
+    info.width = width;
+    info.height = height;
+    info.format = format;
+    info.SetDefaultStride();
+    return info;
+}
+
+std::vector<u8> RandomTexture(std::mt19937& rng, const Pica::Texture::TextureInfo& info) {
+    std::vector<u8> texture(info.stride * (info.height / 8));
+    std::uniform_int_distribution<u32> distribution(0, 255);
+    for (u8& byte : texture) {
+        byte = static_cast<u8>(distribution(rng));
+    }
+    return texture;
+}
+
+std::vector<u8> LookupEveryTexel(const u8* source, const Pica::Texture::TextureInfo& info) {
+    std::vector<u8> texels(info.width * info.height * 4);
+    for (unsigned int y = 0; y < info.height; ++y) {
+        for (unsigned int x = 0; x < info.width; ++x) {
+            const auto color = Pica::Texture::LookupTexture(source, x, y, info);
+            std::memcpy(&texels[(y * info.width + x) * 4], color.AsArray(), 4);
+        }
+    }
+    return texels;
+}
+
+} // Anonymous namespace
+
+TEST_CASE("DecodeTexture matches LookupTexture", "[video_core][texture]") {
+    std::mt19937 rng(42);
+    for (u32 format = 0; format <= static_cast<u32>(TextureFormat::ETC1A4); ++format) {
+        INFO("format " << format);
+        const auto info = MakeInfo(static_cast<TextureFormat>(format), 64, 32);
+        const std::vector<u8> texture = RandomTexture(rng, info);
+
+        std::vector<u8> decoded(info.width * info.height * 4);
+        Pica::Texture::DecodeTexture(info, texture.data(), decoded.data());
+        REQUIRE(decoded == LookupEveryTexel(texture.data(), info));
+    }
+}
+
+TEST_CASE("DecodeTexture performance", "[.benchmark][video_core][texture]") {
+    std::mt19937 rng(42);
+    for (u32 format = 0; format <= static_cast<u32>(TextureFormat::ETC1A4); ++format) {
+        const auto info = MakeInfo(static_cast<TextureFormat>(format), 256, 256);
+        const std::vector<u8> texture = RandomTexture(rng, info);
+        std::vector<u8> decoded(info.width * info.height * 4);
+        const std::string name = std::to_string(format);
+
+        BENCHMARK("tiles " + name) {
+            Pica::Texture::DecodeTexture(info, texture.data(), decoded.data());
+            return decoded[0];
+        };
+        BENCHMARK("per texel " + name) {
+            for (unsigned int y = 0; y < info.height; ++y) {
+                for (unsigned int x = 0; x < info.width; ++x) {
+                    const auto color = Pica::Texture::LookupTexture(texture.data(), x, y, info);
+                    std::memcpy(&decoded[(y * info.width + x) * 4], color.AsArray(), 4);
+                }
+            }
+            return decoded[0];
+        };
+    }
+}
@@ -0,0 +1,61 @@
+// Copyright 2022 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <catch2/catch_test_macros.hpp>
+#include "video_core/vertex_cache.h"
+
+using VertexCache = Pica::VertexCache;
+
+TEST_CASE("VertexCache keeps entries for the same state", "[video_core]") {
+    VertexCache cache;
+    cache.BeginDraw(1);
+    REQUIRE(!cache.Contains(5));
+
+    cache.Insert(5);
+    cache.Get(5).attr[0].x = Pica::float24::FromFloat32(3.f);
+    REQUIRE(cache.Contains(5));
+    REQUIRE(!cache.Contains(4));
+    REQUIRE(!cache.Contains(100000));
+
+    // Growing the cache keeps existing entries
+    cache.Insert(1000);
+    REQUIRE(cache.Contains(1000));
+    REQUIRE(cache.Contains(5));
+    REQUIRE(cache.Get(5).attr[0].x.ToFloat32() == 3.f);
+
+    cache.BeginDraw(1);
+    REQUIRE(cache.Contains(5));
+    REQUIRE(cache.Contains(1000));
+}
+
+TEST_CASE("VertexCache drops entries on state changes", "[video_core]") {
+    VertexCache cache;
+    cache.BeginDraw(1);
+    cache.Insert(5);
+
+    cache.BeginDraw(2);
+    REQUIRE(!cache.Contains(5));
+
+    cache.Insert(5);
+    cache.Invalidate();
+    REQUIRE(!cache.Contains(5));
+}
+
+TEST_CASE("VertexCache only grows to the vertices inserted", "[video_core]") {
+    VertexCache cache;
+    cache.BeginDraw(1);
+    cache.Insert(40000);
+    REQUIRE(cache.Size() == 40001);
+    REQUIRE(cache.Contains(40000));
+    REQUIRE(!cache.Contains(40001));
+
+    cache.Insert(40002);
+    REQUIRE(cache.Size() == 40003);
+
+    // The largest 16 bit index fits
+    cache.Insert(VertexCache::MAX_VERTICES - 1);
+    REQUIRE(cache.Size() == VertexCache::MAX_VERTICES);
+    REQUIRE(cache.Contains(VertexCache::MAX_VERTICES - 1));
+    REQUIRE(cache.Contains(40000));
+}
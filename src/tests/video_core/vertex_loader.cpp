@@ -0,0 +1,248 @@
+// Copyright 2022 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <random>
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+#include "common/alignment.h"
+#include "core/memory.h"
+#include "video_core/debug_utils/debug_utils.h"
+#include "video_core/pica_state.h"
+#include "video_core/shader/shader.h"
+#include "video_core/vertex_loader.h"
+#include "video_core/video_core.h"
+
+using PipelineRegs = Pica::PipelineRegs;
+using Format = PipelineRegs::VertexAttributeFormat;
+using AttributeBuffer = Pica::Shader::AttributeBuffer;
+using float24 = Pica::float24;
+
+namespace {
+
+constexpr PAddr base_address = Memory::VRAM_PADDR;
+constexpr u32 data_size = 0x200000;
+constexpr std::array<u32, 5> test_vertices{0, 1, 7, 255, 1000};
+
+template <typename T>
+float24 ReadElement(const u8* data, u32 element) {
+    T value;
+    std::memcpy(&value, data + element * sizeof(T), sizeof(T));
+    return float24::FromFloat32(static_cast<float>(value));
+}
+
+/// Straightforward implementation decoding the registers for every vertex, which the compiled
+/// loaders have to match
+void LoadReference(const PipelineRegs& regs, u32 vertex, AttributeBuffer& input) {
+    const auto& attribute_config = regs.vertex_attributes;
+    const u32 num_total_attributes = attribute_config.GetNumTotalAttributes();
+    std::array<bool, 16> loaded{};
+
+    for (const auto& loader_config : attribute_config.attribute_loaders) {
+        u32 offset = 0;
+        for (u32 component = 0; component < std::min(loader_config.component_count.Value(), 12u);
+             ++component) {
+            const u32 attribute = loader_config.GetComponent(component);
+            if (attribute >= 12) {
+                // Padding of 4, 8, 12 or 16 bytes
+                offset = Common::AlignUp(offset, 4u) + (attribute - 11) * 4;
+                continue;
+            }
+
+            offset = Common::AlignUp(offset, attribute_config.GetElementSizeInBytes(attribute));
+            if (attribute < num_total_attributes) {
+                const u8* data = VideoCore::g_memory->GetPhysicalPointer(
+                    base_address + loader_config.data_offset + offset +
+                    loader_config.byte_count * vertex);
+                const u32 num_elements = attribute_config.GetNumElements(attribute);
+                for (u32 comp = 0; comp < 4; ++comp) {
+                    auto& value = input.attr[attribute][comp];
+                    if (comp >= num_elements) {
+                        value = float24::FromFloat32(comp == 3 ? 1.0f : 0.0f);
+                        continue;
+                    }
+                    switch (attribute_config.GetFormat(attribute)) {
+                    case Format::BYTE:
+                        value = ReadElement<s8>(data, comp);
+                        break;
+                    case Format::UBYTE:
+                        value = ReadElement<u8>(data, comp);
+                        break;
+                    case Format::SHORT:
+                        value = ReadElement<s16>(data, comp);
+                        break;
+                    case Format::FLOAT:
+                        value = ReadElement<float>(data, comp);
+                        break;
+                    }
+                }
+                loaded[attribute] = true;
+            }
+            offset += attribute_config.GetStride(attribute);
+        }
+    }
+
+    for (u32 attribute = 0; attribute < num_total_attributes; ++attribute) {
+        if (!loaded[attribute] && attribute_config.IsDefaultAttribute(attribute)) {
+            input.attr[attribute] = Pica::g_state.input_default_attributes.attr[attribute];
+        }
+    }
+}
+
+/// Random layout spreading the attributes over the loaders, with padding and extra stride
+PipelineRegs RandomLayout(std::mt19937& rng) {
+    const auto random = [&rng](u32 min, u32 max) {
+        return std::uniform_int_distribution<u32>(min, max)(rng);
+    };
+
+    // Format in the low two bits, number of elements minus one in the high two bits
+    std::array<u32, 12> formats{};
+    for (auto& format : formats) {
+        format = random(0, 15);
+    }
+    const auto element_size = [&formats](u32 attribute) -> u32 {
+        const auto format = static_cast<Format>(formats[attribute] & 3);
+        return format == Format::FLOAT ? 4 : format == Format::SHORT ? 2 : 1;
+    };
+
+    // Every attribute, including some beyond the total, is loaded at most once
+    std::array<u32, 12> order;
+    for (u32 i = 0; i < 12; ++i) {
+        order[i] = i;
+    }
+    std::shuffle(order.begin(), order.end(), rng);
+    std::array<std::vector<u32>, 12> components;
+    for (const u32 attribute : order) {
+        if (random(0, 4) == 0) {
+            continue;
+        }
+        auto& loader = components[random(0, 11)];
+        if (loader.size() < 11 && random(0, 3) == 0) {
+            loader.push_back(random(12, 15));
+        }
+        loader.push_back(attribute);
+    }
+
+    Pica::VertexLoader::Layout layout{};
+    for (u32 attribute = 0; attribute < 12; ++attribute) {
+        layout[attribute / 8] |= formats[attribute] << (attribute % 8 * 4);
+    }
+    // Attributes left to the defaults only use them if their bit is set
+    layout[1] |= random(0, 0xFFF) << 16;
+    layout[1] |= random(0, 11) << 28;
+
+    for (u32 loader = 0; loader < 12; ++loader) {
+        const auto& loader_components = components[loader];
+        u32* config = &layout[2 + loader * 3];
+        config[0] = loader * 0x10000 + random(0, 0x100) * 4;
+
+        u32 size = 0;
+        for (u32 i = 0; i < loader_components.size(); ++i) {
+            const u32 attribute = loader_components[i];
+            config[1 + i / 8] |= attribute << (i % 8 * 4);
+            if (attribute >= 12) {
+                size = Common::AlignUp(size, 4u) + (attribute - 11) * 4;
+            } else {
+                size = Common::AlignUp(size, element_size(attribute)) +
+                       element_size(attribute) * ((formats[attribute] >> 2) + 1);
+            }
+        }
+        const u32 byte_count = std::min(Common::AlignUp(size, 4u) + random(0, 3) * 4, 255u);
+        config[2] |= byte_count << 16;
+        config[2] |= static_cast<u32>(loader_components.size()) << 28;
+    }
+
+    // The layout is everything but the base address
+    PipelineRegs regs{};
+    std::memcpy(reinterpret_cast<u8*>(&regs.vertex_attributes) + sizeof(u32), layout.data(),
+                sizeof(layout));
+    return regs;
+}
+
+/// Compares the whole attribute buffers, including attributes neither of them loaded
+bool Equal(const AttributeBuffer& a, const AttributeBuffer& b) {
+    return std::memcmp(a.attr, b.attr, sizeof(a.attr)) == 0;
+}
+
+AttributeBuffer PoisonedBuffer() {
+    AttributeBuffer buffer;
+    for (auto& attribute : buffer.attr) {
+        attribute = Common::MakeVec(float24::FromRaw(0x123456), float24::FromRaw(0x234567),
+                                    float24::FromRaw(0x345678), float24::FromRaw(0x456789));
+    }
+    return buffer;
+}
+
+void FillMemory(Memory::MemorySystem& memory, std::mt19937& rng) {
+    u8* data = memory.GetPhysicalPointer(base_address);
+    std::uniform_int_distribution<u32> byte(0, 255);
+    for (u32 i = 0; i < data_size; ++i) {
+        data[i] = static_cast<u8>(byte(rng));
+    }
+
+    for (auto& attribute : Pica::g_state.input_default_attributes.attr) {
+        for (u32 comp = 0; comp < 4; ++comp) {
+            attribute[comp] = float24::FromRaw(byte(rng) << 16 | byte(rng) << 8 | byte(rng));
+        }
+    }
+}
+
+} // Anonymous namespace
+
+TEST_CASE("VertexLoader matches the reference loader", "[video_core]") {
+    Memory::MemorySystem memory;
+    VideoCore::g_memory = &memory;
+    std::mt19937 rng(1234);
+    FillMemory(memory, rng);
+    Pica::DebugUtils::MemoryAccessTracker memory_accesses;
+
+    for (int layout = 0; layout < 2000; ++layout) {
+        const PipelineRegs regs = RandomLayout(rng);
+        const Pica::VertexLoader loader(regs);
+        for (const u32 vertex : test_vertices) {
+            AttributeBuffer expected = PoisonedBuffer();
+            AttributeBuffer result = PoisonedBuffer();
+            LoadReference(regs, vertex, expected);
+            loader.LoadVertex(base_address, 0, vertex, result, memory_accesses);
+            REQUIRE(Equal(result, expected));
+        }
+    }
+
+    VideoCore::g_memory = nullptr;
+}
+
+TEST_CASE("VertexLoaderCache returns the loader of the current layout", "[video_core]") {
+    Memory::MemorySystem memory;
+    VideoCore::g_memory = &memory;
+    std::mt19937 rng(5678);
+    FillMemory(memory, rng);
+    Pica::DebugUtils::MemoryAccessTracker memory_accesses;
+
+    std::vector<PipelineRegs> layouts;
+    for (int i = 0; i < 8; ++i) {
+        layouts.push_back(RandomLayout(rng));
+    }
+
+    Pica::VertexLoaderCache cache;
+    for (int draw = 0; draw < 200; ++draw) {
+        PipelineRegs regs = layouts[std::uniform_int_distribution<u32>(0, 7)(rng)];
+        // The base address is not part of the layout
+        regs.vertex_attributes.base_address.Assign(draw);
+
+        const Pica::VertexLoader& loader = cache.Get(regs);
+        REQUIRE(&cache.Get(regs) == &loader);
+        REQUIRE(loader.GetLayout() == Pica::VertexLoader::GetLayout(regs));
+        for (const u32 vertex : test_vertices) {
+            AttributeBuffer expected = PoisonedBuffer();
+            AttributeBuffer result = PoisonedBuffer();
+            LoadReference(regs, vertex, expected);
+            loader.LoadVertex(base_address, 0, vertex, result, memory_accesses);
+            REQUIRE(Equal(result, expected));
+        }
+    }
+
+    VideoCore::g_memory = nullptr;
+}
@@ -2,18 +2,25 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <array>
 #include <cstddef>
 #include <cstring>
 #include <memory>
+#include <thread>
 #include <utility>
+#include <vector>
+#include "common/alignment.h"
 #include "common/assert.h"
+#include "common/hash.h"
 #include "common/logging/log.h"
 #include "common/microprofile.h"
+#include "common/thread_worker.h"
 #include "common/vector_math.h"
 #include "core/hle/service/gsp/gsp.h"
 #include "core/hw/gpu.h"
 #include "core/memory.h"
+#include "core/settings.h"
 #include "core/tracer/recorder.h"
 #include "video_core/command_processor.h"
 #include "video_core/debug_utils/debug_utils.h"
@@ -26,6 +33,7 @@
 #include "video_core/regs_texturing.h"
 #include "video_core/renderer_base.h"
 #include "video_core/shader/shader.h"
+#include "video_core/vertex_cache.h"
 #include "video_core/vertex_loader.h"
 #include "video_core/video_core.h"
 
@@ -39,6 +47,138 @@ constexpr std::array<u32, 16> expand_bits_to_bytes{
 
 MICROPROFILE_DEFINE(GPU_Drawing, "GPU", "Drawing", MP_RGB(50, 50, 240));
 
+static VertexLoaderCache vertex_loader_cache;
+
+/// Outputs of indexed vertices shaded by earlier draws of the current command list
+static VertexCache vertex_cache;
+
+/**
+ * Hashes the state the vertex shader outputs depend on besides the vertex data itself, which can't
+ * change in between the draws of a command list.
+ */
+static u64 ComputeVertexStateKey() {
+    std::size_t key = 0;
+    Common::HashCombine(key, Common::ComputeStructHash64(g_state.regs.pipeline.vertex_attributes));
+    Common::HashCombine(key, Common::ComputeStructHash64(g_state.regs.vs));
+    Common::HashCombine(key, g_state.vs.GetProgramCodeHash());
+    Common::HashCombine(key, g_state.vs.GetSwizzleDataHash());
+    Common::HashCombine(key, Common::ComputeStructHash64(g_state.vs.uniforms));
+    Common::HashCombine(key, Common::ComputeStructHash64(g_state.input_default_attributes));
+    return key;
+}
+
+/// Draws with at least this many vertices are shaded on the vertex shader thread pool
+constexpr u32 PARALLEL_SHADING_MIN_VERTICES = 1024;
+
+/// Pool used to shade large draws, or nullptr if vertices are shaded serially
+static std::unique_ptr<Common::ThreadWorker> vertex_shader_workers;
+
+void Init() {
+    std::size_t num_threads = Settings::values.vertex_shader_threads;
+    if (num_threads == 0) {
+        num_threads = std::max(1U, std::thread::hardware_concurrency());
+    }
+    if (num_threads > 1) {
+        LOG_INFO(HW_GPU, "Vertex shading with {} threads", num_threads);
+        // The calling thread shades a share of the vertices as well
+        vertex_shader_workers =
+            std::make_unique<Common::ThreadWorker>(num_threads - 1, "VertexShader");
+    }
+}
+
+void Shutdown() {
+    vertex_shader_workers.reset();
+}
+
+/**
+ * Shades the vertices of a draw in parallel and submits them to the geometry pipeline in draw
+ * order. The index buffer is scanned up front so that every vertex missing from the vertex cache
+ * is shaded exactly once, each thread working on its own range of vertices with its own shader
+ * units. Since the shader output only depends on the vertex inputs, the results match those of the
+ * serial path.
+ */
+static void ProcessVerticesParallel(Common::ThreadWorker& workers, Shader::ShaderEngine& engine,
+                                    const VertexLoader& loader, u32 base_address,
+                                    bool is_indexed, const u8* index_address_8, bool index_u16) {
+    const auto& regs = g_state.regs;
+    const u32 num_vertices = regs.pipeline.num_vertices;
+    const u16* index_address_16 = reinterpret_cast<const u16*>(index_address_8);
+
+    struct PendingVertex {
+        u32 index; // First index of the draw referring to the vertex, for logging only
+        u32 vertex;
+    };
+    std::vector<PendingVertex> pending_vertices;
+
+    // Indexed draws are shaded into the vertex cache, other draws into a temporary buffer
+    std::vector<Shader::AttributeBuffer> vs_outputs;
+    if (is_indexed) {
+        for (u32 index = 0; index < num_vertices; ++index) {
+            const u32 vertex = index_u16 ? index_address_16[index] : index_address_8[index];
+            if (!vertex_cache.Contains(vertex)) {
+                vertex_cache.Insert(vertex);
+                pending_vertices.push_back({index, vertex});
+            }
+        }
+    } else {
+        pending_vertices.resize(num_vertices);
+        for (u32 index = 0; index < num_vertices; ++index) {
+            pending_vertices[index] = {index, index + regs.pipeline.vertex_offset};
+        }
+        vs_outputs.resize(num_vertices);
+    }
+
+    const std::size_t num_pending = pending_vertices.size();
+    const std::size_t num_cache_hits = is_indexed ? num_vertices - num_pending : 0;
+    MICROPROFILE_META_CPU("Vertex cache hits", static_cast<int>(num_cache_hits));
+    MICROPROFILE_META_CPU("Vertex shader invocations", static_cast<int>(num_pending));
+
+    const auto shade_range = [&](std::size_t begin, std::size_t end) {
+        std::array<Shader::UnitState, Shader::MAX_BATCH_SIZE> shader_units;
+        // Memory accesses are only recorded with a debug context, which uses the serial path
+        DebugUtils::MemoryAccessTracker memory_accesses;
+
+        for (std::size_t batch = begin; batch < end; batch += Shader::MAX_BATCH_SIZE) {
+            const std::size_t count = std::min(Shader::MAX_BATCH_SIZE, end - batch);
+            for (std::size_t unit = 0; unit < count; ++unit) {
+                const auto& pending = pending_vertices[batch + unit];
+                Shader::AttributeBuffer input;
+                loader.LoadVertex(base_address, pending.index, pending.vertex, input,
+                                  memory_accesses);
+                shader_units[unit].LoadInput(regs.vs, input);
+            }
+            engine.RunBatch(g_state.vs, shader_units.data(), count);
+            for (std::size_t unit = 0; unit < count; ++unit) {
+                const std::size_t i = batch + unit;
+                shader_units[unit].WriteOutput(regs.vs,
+                                               is_indexed
+                                                   ? vertex_cache.Get(pending_vertices[i].vertex)
+                                                   : vs_outputs[i]);
+            }
+        }
+    };
+
+    // Split the vertices into one range per thread, keeping whole batches together
+    const std::size_t num_ranges = workers.NumWorkers() + 1;
+    const std::size_t range_size = Common::AlignUp((num_pending + num_ranges - 1) / num_ranges,
+                                                   Shader::MAX_BATCH_SIZE);
+    for (std::size_t begin = range_size; begin < num_pending; begin += range_size) {
+        const std::size_t end = std::min(begin + range_size, num_pending);
+        workers.QueueWork([&shade_range, begin, end] { shade_range(begin, end); });
+    }
+    shade_range(0, std::min(range_size, num_pending));
+    workers.WaitForRequests();
+
+    for (u32 index = 0; index < num_vertices; ++index) {
+        if (is_indexed) {
+            const u32 vertex = index_u16 ? index_address_16[index] : index_address_8[index];
+            g_state.geometry_pipeline.SubmitVertex(vertex_cache.Get(vertex));
+        } else {
+            g_state.geometry_pipeline.SubmitVertex(vs_outputs[index]);
+        }
+    }
+}
+
 static const char* GetShaderSetupTypeName(Shader::ShaderSetup& setup) {
     if (&setup == &g_state.vs) {
         return "vertex shader";
@@ -143,7 +283,7 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
     switch (id) {
     // Trigger IRQ
     case PICA_REG_INDEX(trigger_irq):
-        Service::GSP::SignalInterrupt(Service::GSP::InterruptId::P3D);
+        GPU::SignalInterrupt(Service::GSP::InterruptId::P3D);
         break;
 
     case PICA_REG_INDEX(pipeline.triangle_topology):
@@ -312,10 +452,9 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
         }
 
         // Processes information about internal vertex attributes to figure out how a vertex is
-        // loaded.
-        // Later, these can be compiled and cached.
+        // loaded. Loaders are compiled once per attribute layout and reused by later draws.
         const u32 base_address = regs.pipeline.vertex_attributes.GetPhysicalBaseAddress();
-        VertexLoader loader(regs.pipeline);
+        const VertexLoader& loader = vertex_loader_cache.Get(regs.pipeline);
         Shader::OutputVertex::ValidateSemantics(regs.rasterizer);
 
         // Load vertices
@@ -343,18 +482,7 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
 
         DebugUtils::MemoryAccessTracker memory_accesses;
 
-        // Simple circular-replacement vertex cache
-        // The size has been tuned for optimal balance between hit-rate and the cost of lookup
-        const std::size_t VERTEX_CACHE_SIZE = 32;
-        std::array<bool, VERTEX_CACHE_SIZE> vertex_cache_valid{};
-        std::array<u16, VERTEX_CACHE_SIZE> vertex_cache_ids;
-        std::array<Shader::AttributeBuffer, VERTEX_CACHE_SIZE> vertex_cache;
-        Shader::AttributeBuffer vs_output;
-
-        unsigned int vertex_cache_pos = 0;
-
         auto* shader_engine = Shader::GetEngine();
-        Shader::UnitState shader_unit;
 
         shader_engine->SetupBatch(g_state.vs, regs.vs.main_offset);
 
@@ -363,58 +491,106 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
         if (g_state.geometry_pipeline.NeedIndexInput())
             ASSERT(is_indexed);
 
-        for (unsigned int index = 0; index < regs.pipeline.num_vertices; ++index) {
-            // Indexed rendering doesn't use the start offset
-            unsigned int vertex =
-                is_indexed ? (index_u16 ? index_address_16[index] : index_address_8[index])
-                           : (index + regs.pipeline.vertex_offset);
-
-            bool vertex_cache_hit = false;
+        if (is_indexed) {
+            vertex_cache.BeginDraw(ComputeVertexStateKey());
+        }
 
-            if (is_indexed) {
-                if (g_state.geometry_pipeline.NeedIndexInput()) {
-                    g_state.geometry_pipeline.SubmitIndex(vertex);
-                    continue;
+        // Large draws without a geometry shader are spread over several threads
+        Common::ThreadWorker* workers = vertex_shader_workers.get();
+        if (workers != nullptr && regs.pipeline.use_gs == PipelineRegs::UseGS::No &&
+            regs.pipeline.num_vertices >= PARALLEL_SHADING_MIN_VERTICES && !g_debug_context) {
+            ProcessVerticesParallel(*workers, *shader_engine, loader, base_address, is_indexed,
+                                    index_address_8, index_u16);
+        } else {
+            // Vertices missing from the cache are collected into batches for the shader engine,
+            // which can process several of them at once. Everything queued up to the end of a
+            // batch is then sent to the geometry pipeline in the original order.
+            constexpr std::size_t MAX_QUEUED_VERTICES = 32;
+            // Vertex ids for indexed draws, which are shaded into the vertex cache, or shader units
+            std::array<u32, MAX_QUEUED_VERTICES> queued_vertices;
+            std::size_t num_queued_vertices = 0;
+
+            std::array<Shader::UnitState, Shader::MAX_BATCH_SIZE> shader_units;
+            std::array<u32, Shader::MAX_BATCH_SIZE> shader_unit_vertices;
+            std::array<Shader::AttributeBuffer, Shader::MAX_BATCH_SIZE> vs_outputs;
+            std::size_t num_shader_units = 0;
+
+            u32 num_cache_hits = 0;
+            u32 num_invocations = 0;
+
+            const auto flush_queued_vertices = [&] {
+                // Send to vertex shader
+                shader_engine->RunBatch(g_state.vs, shader_units.data(), num_shader_units);
+                for (std::size_t unit = 0; unit < num_shader_units; ++unit) {
+                    shader_units[unit].WriteOutput(
+                        regs.vs, is_indexed ? vertex_cache.Get(shader_unit_vertices[unit])
+                                            : vs_outputs[unit]);
                 }
 
-                if (g_debug_context && Pica::g_debug_context->recorder) {
-                    int size = index_u16 ? 2 : 1;
-                    memory_accesses.AddAccess(base_address + index_info.offset + size * index,
-                                              size);
+                // Send to geometry pipeline
+                for (std::size_t i = 0; i < num_queued_vertices; ++i) {
+                    const u32 queued = queued_vertices[i];
+                    g_state.geometry_pipeline.SubmitVertex(
+                        is_indexed ? vertex_cache.Get(queued) : vs_outputs[queued]);
                 }
 
-                for (unsigned int i = 0; i < VERTEX_CACHE_SIZE; ++i) {
-                    if (vertex_cache_valid[i] && vertex == vertex_cache_ids[i]) {
-                        vs_output = vertex_cache[i];
-                        vertex_cache_hit = true;
-                        break;
+                num_invocations += static_cast<u32>(num_shader_units);
+                num_queued_vertices = 0;
+                num_shader_units = 0;
+            };
+
+            for (unsigned int index = 0; index < regs.pipeline.num_vertices; ++index) {
+                // Indexed rendering doesn't use the start offset
+                unsigned int vertex =
+                    is_indexed ? (index_u16 ? index_address_16[index] : index_address_8[index])
+                               : (index + regs.pipeline.vertex_offset);
+
+                if (is_indexed) {
+                    if (g_state.geometry_pipeline.NeedIndexInput()) {
+                        g_state.geometry_pipeline.SubmitIndex(vertex);
+                        continue;
+                    }
+
+                    if (g_debug_context && Pica::g_debug_context->recorder) {
+                        int size = index_u16 ? 2 : 1;
+                        memory_accesses.AddAccess(base_address + index_info.offset + size * index,
+                                                  size);
                     }
                 }
-            }
 
-            if (!vertex_cache_hit) {
-                // Initialize data for the current vertex
-                Shader::AttributeBuffer input;
-                loader.LoadVertex(base_address, index, vertex, input, memory_accesses);
+                if (is_indexed && vertex_cache.Contains(vertex)) {
+                    // Either shaded before or waiting in the current batch
+                    queued_vertices[num_queued_vertices++] = vertex;
+                    ++num_cache_hits;
+                } else {
+                    // Initialize data for the current vertex
+                    Shader::AttributeBuffer input;
+                    loader.LoadVertex(base_address, index, vertex, input, memory_accesses);
 
-                // Send to vertex shader
-                if (g_debug_context)
-                    g_debug_context->OnEvent(DebugContext::Event::VertexShaderInvocation,
-                                             (void*)&input);
-                shader_unit.LoadInput(regs.vs, input);
-                shader_engine->Run(g_state.vs, shader_unit);
-                shader_unit.WriteOutput(regs.vs, vs_output);
+                    if (g_debug_context)
+                        g_debug_context->OnEvent(DebugContext::Event::VertexShaderInvocation,
+                                                 (void*)&input);
+                    shader_units[num_shader_units].LoadInput(regs.vs, input);
+                    shader_unit_vertices[num_shader_units] = vertex;
+                    if (is_indexed) {
+                        vertex_cache.Insert(vertex);
+                        queued_vertices[num_queued_vertices++] = vertex;
+                    } else {
+                        queued_vertices[num_queued_vertices++] =
+                            static_cast<u32>(num_shader_units);
+                    }
+                    ++num_shader_units;
+                }
 
-                if (is_indexed) {
-                    vertex_cache[vertex_cache_pos] = vs_output;
-                    vertex_cache_valid[vertex_cache_pos] = true;
-                    vertex_cache_ids[vertex_cache_pos] = vertex;
-                    vertex_cache_pos = (vertex_cache_pos + 1) % VERTEX_CACHE_SIZE;
+                if (num_shader_units == Shader::MAX_BATCH_SIZE ||
+                    num_queued_vertices == MAX_QUEUED_VERTICES) {
+                    flush_queued_vertices();
                 }
             }
+            flush_queued_vertices();
 
-            // Send to geometry pipeline
-            g_state.geometry_pipeline.SubmitVertex(vs_output);
+            MICROPROFILE_META_CPU("Vertex cache hits", static_cast<int>(num_cache_hits));
+            MICROPROFILE_META_CPU("Vertex shader invocations", static_cast<int>(num_invocations));
         }
 
         for (auto& range : memory_accesses.ranges) {
@@ -657,6 +833,9 @@ void ProcessCommandList(PAddr list, u32 size) {
     g_state.cmd_list.head_ptr = g_state.cmd_list.current_ptr = buffer;
     g_state.cmd_list.length = size / sizeof(u32);
 
+    // Vertex data may have been modified since the last command list
+    vertex_cache.Invalidate();
+
     while (g_state.cmd_list.current_ptr < g_state.cmd_list.head_ptr + g_state.cmd_list.length) {
 
         // Align read pointer to 8 bytes
@@ -32,6 +32,12 @@ static_assert(std::is_standard_layout<CommandHeader>::value == true,
               "CommandHeader does not use standard layout");
 static_assert(sizeof(CommandHeader) == sizeof(u32), "CommandHeader has incorrect size!");
 
+/// Starts the threads used to shade large draws, according to the current settings
+void Init();
+
+/// Stops the vertex shading threads
+void Shutdown();
+
 void ProcessCommandList(PAddr list, u32 size);
 
 } // namespace Pica::CommandProcessor
@@ -0,0 +1,70 @@
+// Copyright 2022 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include "common/microprofile.h"
+#include "common/thread.h"
+#include "video_core/gpu_thread.h"
+
+MICROPROFILE_DEFINE(GPU_ThreadWait, "GPU", "Wait for GPU thread", MP_RGB(128, 128, 192));
+
+namespace VideoCore {
+
+GPUThread::GPUThread(Executor executor)
+    : executor(std::move(executor)), thread(&GPUThread::ThreadLoop, this) {}
+
+GPUThread::~GPUThread() {
+    commands.Push(std::make_pair(CommandData{ExitCommand{}}, ++submitted_fence));
+    thread.join();
+}
+
+void GPUThread::Submit(CommandData command) {
+    commands.Push(std::make_pair(std::move(command), ++submitted_fence));
+}
+
+void GPUThread::WaitIdle() {
+    if (IsIdle()) {
+        return;
+    }
+
+    MICROPROFILE_SCOPE(GPU_ThreadWait);
+    std::unique_lock lock{fence_mutex};
+    fence_condition.wait(lock, [this] { return IsIdle(); });
+}
+
+void GPUThread::DeferToCPU(std::function<void()> callback) {
+    deferred.Push(std::move(callback));
+}
+
+void GPUThread::RunDeferred() {
+    std::function<void()> callback;
+    while (deferred.Pop(callback)) {
+        callback();
+    }
+}
+
+void GPUThread::ThreadLoop() {
+    Common::SetCurrentThreadName("GPU");
+    MicroProfileOnThreadCreate("GPU");
+
+    while (true) {
+        auto [command, fence] = commands.PopWait();
+        const bool exit = std::holds_alternative<ExitCommand>(command);
+        if (!exit) {
+            executor(command);
+        }
+
+        {
+            // Publish under the lock so a waiting CPU thread can't miss the notification
+            std::scoped_lock lock{fence_mutex};
+            executed_fence.store(fence, std::memory_order_release);
+        }
+        fence_condition.notify_all();
+
+        if (exit) {
+            break;
+        }
+    }
+}
+
+} // namespace VideoCore
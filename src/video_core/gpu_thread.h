@@ -0,0 +1,103 @@
+// Copyright 2022 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <variant>
+#include "common/common_types.h"
+#include "common/threadsafe_queue.h"
+#include "core/hw/gpu.h"
+
+namespace VideoCore {
+
+/// Processes the PICA command list at the given physical address
+struct SubmitListCommand {
+    PAddr address;
+    u32 size;
+};
+
+/// Runs the memory fill configured in one of the two fill units
+struct MemoryFillCommand {
+    GPU::Regs::MemoryFillConfig config;
+    bool is_second_filler;
+};
+
+/// Runs a display transfer or texture copy
+struct DisplayTransferCommand {
+    GPU::Regs::DisplayTransferConfig config;
+};
+
+/// Stops the GPU thread
+struct ExitCommand {};
+
+using CommandData =
+    std::variant<SubmitListCommand, MemoryFillCommand, DisplayTransferCommand, ExitCommand>;
+
+/**
+ * Host thread running the work triggered through the GPU registers, so that GPU and CPU emulation
+ * overlap. Commands are submitted from the CPU thread through a fixed-capacity lock-free queue and
+ * executed in order. Work which has to happen on the CPU thread once a command has finished, like
+ * signaling interrupts, is deferred until the CPU thread synchronizes with the GPU thread.
+ */
+class GPUThread {
+public:
+    /// Runs on the GPU thread for every submitted command
+    using Executor = std::function<void(const CommandData&)>;
+
+    explicit GPUThread(Executor executor);
+    ~GPUThread();
+
+    /// Queues a command for the GPU thread. Must be called from the CPU thread.
+    void Submit(CommandData command);
+
+    /// Blocks until every submitted command has been executed. Must be called from the CPU thread.
+    void WaitIdle();
+
+    /// Queues a function to be run by RunDeferred. Must be called from the GPU thread.
+    void DeferToCPU(std::function<void()> callback);
+
+    /// Runs the functions deferred so far in order. Must be called from the CPU thread.
+    void RunDeferred();
+
+    [[nodiscard]] bool IsGPUThread() const {
+        return std::this_thread::get_id() == thread.get_id();
+    }
+
+    /// Returns whether every submitted command has been executed
+    [[nodiscard]] bool IsIdle() const {
+        return executed_fence.load(std::memory_order_acquire) == submitted_fence;
+    }
+
+private:
+    void ThreadLoop();
+
+    Executor executor;
+
+    /// Number of commands the CPU thread can get ahead of the GPU thread before it blocks
+    static constexpr std::size_t MaxPendingCommands = 256;
+
+    Common::BoundedSPSCQueue<std::pair<CommandData, u64>, MaxPendingCommands> commands;
+    // Unbounded, since a GPU thread blocked on a full queue here would never finish the command
+    // the CPU thread is waiting for in WaitIdle. There are only a few callbacks per command, which
+    // signal interrupts or reset registers, so the allocation per push doesn't matter.
+    Common::SPSCQueue<std::function<void()>> deferred;
+
+    /// Number of commands submitted, only accessed by the CPU thread
+    u64 submitted_fence = 0;
+    /// Number of commands executed, written by the GPU thread
+    std::atomic<u64> executed_fence = 0;
+    std::mutex fence_mutex;
+    std::condition_variable fence_condition;
+
+    std::thread thread;
+};
+
+} // namespace VideoCore
@@ -5,6 +5,7 @@
 #include <cstring>
 #include <type_traits>
 #include "core/global.h"
+#include "video_core/command_processor.h"
 #include "video_core/geometry_pipeline.h"
 #include "video_core/pica.h"
 #include "video_core/pica_state.h"
@@ -24,9 +25,11 @@ State g_state;
 
 void Init() {
     g_state.Reset();
+    CommandProcessor::Init();
 }
 
 void Shutdown() {
+    CommandProcessor::Shutdown();
     Shader::Shutdown();
 }
 
@@ -6,12 +6,15 @@
 #include "common/scope_exit.h"
 #include "common/texture.h"
 #include "core/core.h"
+#include "core/memory.h"
 #include "video_core/rasterizer_cache/cached_surface.h"
 #include "video_core/rasterizer_cache/morton_swizzle.h"
 #include "video_core/rasterizer_cache/rasterizer_cache.h"
 #include "video_core/renderer_opengl/gl_state.h"
+#include "video_core/renderer_opengl/gl_vars.h"
 #include "video_core/renderer_opengl/texture_downloader_es.h"
 #include "video_core/renderer_opengl/texture_filters/texture_filterer.h"
+#include "video_core/video_core.h"
 
 namespace OpenGL {
 
@@ -106,17 +109,24 @@ void CachedSurface::LoadGLBuffer(PAddr load_start, PAddr load_end) {
             const auto rect = GetSubRect(FromInterval(load_interval));
             ASSERT(FromInterval(load_interval).GetInterval() == load_interval);
 
-            for (unsigned y = rect.bottom; y < rect.top; ++y) {
-                for (unsigned x = rect.left; x < rect.right; ++x) {
-                    auto vec4 =
-                        Pica::Texture::LookupTexture(texture_src_data, x, height - 1 - y, tex_info);
-                    const std::size_t offset = (x + (width * y)) * 4;
-                    std::memcpy(&gl_buffer[offset], vec4.AsArray(), 4);
+            // The rectangle covers whole tiles. The GL buffer is stored bottom-up, so the rows of
+            // a tile are written from its top GL row downwards.
+            const std::size_t tile_size = Pica::Texture::CalculateTileSize(tex_info.format);
+            const std::ptrdiff_t gl_pitch = -static_cast<std::ptrdiff_t>(width * 4);
+            for (unsigned y = rect.bottom; y < rect.top; y += 8) {
+                const u8* tile = texture_src_data + ((height - 8 - y) / 8) * tex_info.stride +
+                                 (rect.left / 8) * tile_size;
+                u8* tile_dst = &gl_buffer[(rect.left + width * (y + 7)) * 4];
+                for (unsigned x = rect.left; x < rect.right; x += 8) {
+                    Pica::Texture::DecodeTile(tex_info.format, tile, tile_dst, gl_pitch);
+                    tile += tile_size;
+                    tile_dst += 8 * 4;
                 }
             }
         } else {
-            morton_to_gl_fns[static_cast<std::size_t>(pixel_format)](stride, height, &gl_buffer[0],
-                                                                     addr, load_start, load_end);
+            morton_to_gl_fns[static_cast<std::size_t>(pixel_format)](
+                stride, height, &gl_buffer[0], addr, load_start, load_end,
+                owner.morton_workers.get());
         }
     }
 }
@@ -178,7 +188,8 @@ void CachedSurface::FlushGLBuffer(PAddr flush_start, PAddr flush_end) {
         }
     } else {
         gl_to_morton_fns[static_cast<std::size_t>(pixel_format)](stride, height, &gl_buffer[0],
-                                                                 addr, flush_start, flush_end);
+                                                                 addr, flush_start, flush_end,
+                                                                 owner.morton_workers.get());
     }
 }
 
@@ -0,0 +1,481 @@
+// Copyright 2022 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include "common/alignment.h"
+#include "common/assert.h"
+#include "common/logging/log.h"
+#include "common/swap.h"
+#include "common/thread_worker.h"
+#include "core/memory.h"
+#include "video_core/rasterizer_cache/morton_swizzle.h"
+#include "video_core/rasterizer_cache/pixel_format.h"
+#include "video_core/renderer_opengl/gl_vars.h"
+#include "video_core/video_core.h"
+
+#if defined(ARCHITECTURE_x86_64)
+#include <emmintrin.h>
+#elif defined(ARCHITECTURE_ARM64)
+#include <arm_neon.h>
+#endif
+
+namespace OpenGL {
+
+namespace {
+
+/*
+ * A tile is 8x8 pixels stored in Morton order. The bits of a pixel index within the tile are
+ * x0 y0 x1 y1 x2 y2 from least to most significant, so every run of 2 pixels lies on one row and
+ * every run of 4 pixels is a 2x2 block. The kernels below move whole blocks at once and split or
+ * join their rows with unpack instructions, rather than computing the position of every pixel.
+ *
+ * The linear side of a tile is given as a pointer to row 0 and the distance between rows, which
+ * is negative when writing straight into a bottom-up GL buffer.
+ */
+
+#if defined(ARCHITECTURE_x86_64) || defined(ARCHITECTURE_ARM64)
+
+#if defined(ARCHITECTURE_x86_64)
+
+/// 16 bytes of pixel data. SSE2 is part of the x86-64 baseline.
+struct Lanes {
+    __m128i value;
+
+    static Lanes Load(const u8* src) {
+        return {_mm_loadu_si128(reinterpret_cast<const __m128i*>(src))};
+    }
+
+    void Store(u8* dst) const {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), value);
+    }
+
+    /// Lower 8 bytes of a followed by the lower 8 bytes of b
+    static Lanes ZipLow64(Lanes a, Lanes b) {
+        return {_mm_unpacklo_epi64(a.value, b.value)};
+    }
+
+    /// Upper 8 bytes of a followed by the upper 8 bytes of b
+    static Lanes ZipHigh64(Lanes a, Lanes b) {
+        return {_mm_unpackhi_epi64(a.value, b.value)};
+    }
+
+    /// Interleaves the lower two 32-bit words of a and b
+    static Lanes ZipLow32(Lanes a, Lanes b) {
+        return {_mm_unpacklo_epi32(a.value, b.value)};
+    }
+
+    /// Interleaves the upper two 32-bit words of a and b
+    static Lanes ZipHigh32(Lanes a, Lanes b) {
+        return {_mm_unpackhi_epi32(a.value, b.value)};
+    }
+
+    /// Reorders the 32-bit words A B C D into A C B D
+    Lanes UnzipWords() const {
+        return {_mm_shuffle_epi32(value, _MM_SHUFFLE(3, 1, 2, 0))};
+    }
+};
+
+#elif defined(ARCHITECTURE_ARM64)
+
+/// 16 bytes of pixel data
+struct Lanes {
+    uint8x16_t value;
+
+    static Lanes Load(const u8* src) {
+        return {vld1q_u8(src)};
+    }
+
+    void Store(u8* dst) const {
+        vst1q_u8(dst, value);
+    }
+
+    static Lanes ZipLow64(Lanes a, Lanes b) {
+        return {vreinterpretq_u8_u64(
+            vzip1q_u64(vreinterpretq_u64_u8(a.value), vreinterpretq_u64_u8(b.value)))};
+    }
+
+    static Lanes ZipHigh64(Lanes a, Lanes b) {
+        return {vreinterpretq_u8_u64(
+            vzip2q_u64(vreinterpretq_u64_u8(a.value), vreinterpretq_u64_u8(b.value)))};
+    }
+
+    static Lanes ZipLow32(Lanes a, Lanes b) {
+        return {vreinterpretq_u8_u32(
+            vzip1q_u32(vreinterpretq_u32_u8(a.value), vreinterpretq_u32_u8(b.value)))};
+    }
+
+    static Lanes ZipHigh32(Lanes a, Lanes b) {
+        return {vreinterpretq_u8_u32(
+            vzip2q_u32(vreinterpretq_u32_u8(a.value), vreinterpretq_u32_u8(b.value)))};
+    }
+
+    Lanes UnzipWords() const {
+        const uint32x4_t words = vreinterpretq_u32_u8(value);
+        return ZipLow64({vreinterpretq_u8_u32(vuzp1q_u32(words, words))},
+                        {vreinterpretq_u8_u32(vuzp2q_u32(words, words))});
+    }
+};
+
+#endif
+
+/// 32-bit pixels: every 16 bytes of the tile are one 2x2 block
+void UnswizzleTile32(const u8* tile, u8* rows, std::ptrdiff_t pitch) {
+    for (u32 block_row = 0; block_row < 4; ++block_row) {
+        // Index of the leftmost block of the row, bit 1 is y1 and bit 3 is y2
+        const u32 base = ((block_row & 1) << 1) | ((block_row >> 1) << 3);
+        const Lanes b0 = Lanes::Load(tile + base * 16);
+        const Lanes b1 = Lanes::Load(tile + (base | 1) * 16);
+        const Lanes b2 = Lanes::Load(tile + (base | 4) * 16);
+        const Lanes b3 = Lanes::Load(tile + (base | 5) * 16);
+        u8* const row0 = rows + static_cast<std::ptrdiff_t>(block_row * 2) * pitch;
+        u8* const row1 = row0 + pitch;
+        Lanes::ZipLow64(b0, b1).Store(row0);
+        Lanes::ZipLow64(b2, b3).Store(row0 + 16);
+        Lanes::ZipHigh64(b0, b1).Store(row1);
+        Lanes::ZipHigh64(b2, b3).Store(row1 + 16);
+    }
+}
+
+void SwizzleTile32(const u8* rows, std::ptrdiff_t pitch, u8* tile) {
+    for (u32 block_row = 0; block_row < 4; ++block_row) {
+        const u32 base = ((block_row & 1) << 1) | ((block_row >> 1) << 3);
+        const u8* const row0 = rows + static_cast<std::ptrdiff_t>(block_row * 2) * pitch;
+        const u8* const row1 = row0 + pitch;
+        const Lanes r0_left = Lanes::Load(row0);
+        const Lanes r0_right = Lanes::Load(row0 + 16);
+        const Lanes r1_left = Lanes::Load(row1);
+        const Lanes r1_right = Lanes::Load(row1 + 16);
+        Lanes::ZipLow64(r0_left, r1_left).Store(tile + base * 16);
+        Lanes::ZipHigh64(r0_left, r1_left).Store(tile + (base | 1) * 16);
+        Lanes::ZipLow64(r0_right, r1_right).Store(tile + (base | 4) * 16);
+        Lanes::ZipHigh64(r0_right, r1_right).Store(tile + (base | 5) * 16);
+    }
+}
+
+/// 16-bit pixels: every 16 bytes of the tile are two 2x2 blocks next to each other
+void UnswizzleTile16(const u8* tile, u8* rows, std::ptrdiff_t pitch) {
+    for (u32 row_pair = 0; row_pair < 4; ++row_pair) {
+        // Index of the left half of the rows, bit 0 is y1 and bit 2 is y2. Bit 1 is x2.
+        const u32 left = (row_pair & 1) | ((row_pair >> 1) << 2);
+        const Lanes l = Lanes::Load(tile + left * 16).UnzipWords();
+        const Lanes r = Lanes::Load(tile + (left | 2) * 16).UnzipWords();
+        u8* const row0 = rows + static_cast<std::ptrdiff_t>(row_pair * 2) * pitch;
+        Lanes::ZipLow64(l, r).Store(row0);
+        Lanes::ZipHigh64(l, r).Store(row0 + pitch);
+    }
+}
+
+void SwizzleTile16(const u8* rows, std::ptrdiff_t pitch, u8* tile) {
+    for (u32 row_pair = 0; row_pair < 4; ++row_pair) {
+        const u32 left = (row_pair & 1) | ((row_pair >> 1) << 2);
+        const u8* const row0 = rows + static_cast<std::ptrdiff_t>(row_pair * 2) * pitch;
+        const Lanes r0 = Lanes::Load(row0);
+        const Lanes r1 = Lanes::Load(row0 + pitch);
+        Lanes::ZipLow32(r0, r1).Store(tile + left * 16);
+        Lanes::ZipHigh32(r0, r1).Store(tile + (left | 2) * 16);
+    }
+}
+
+#endif
+
+/// Position of every run of 2 pixels of a tile, as the linear index of its left pixel
+constexpr std::array<u8, 32> pair_positions = [] {
+    std::array<u8, 32> positions{};
+    for (u32 pair = 0; pair < 32; ++pair) {
+        const u32 index = pair * 2;
+        const u32 x = (index & 1) | ((index >> 1) & 2) | ((index >> 2) & 4);
+        const u32 y = ((index >> 1) & 1) | ((index >> 2) & 2) | ((index >> 3) & 4);
+        positions[pair] = static_cast<u8>(y * 8 + x);
+    }
+    return positions;
+}();
+
+template <u32 bytes_per_pixel>
+void UnswizzleTile(const u8* tile, u8* rows, std::ptrdiff_t pitch) {
+#if defined(ARCHITECTURE_x86_64) || defined(ARCHITECTURE_ARM64)
+    if constexpr (bytes_per_pixel == 4) {
+        return UnswizzleTile32(tile, rows, pitch);
+    } else if constexpr (bytes_per_pixel == 2) {
+        return UnswizzleTile16(tile, rows, pitch);
+    }
+#endif
+    // Pairs of pixels for the other sizes, or when there are no vector instructions
+    for (u32 pair = 0; pair < 32; ++pair) {
+        const u32 position = pair_positions[pair];
+        u8* const dst = rows + static_cast<std::ptrdiff_t>(position / 8) * pitch +
+                        (position % 8) * bytes_per_pixel;
+        std::memcpy(dst, tile + pair * 2 * bytes_per_pixel, 2 * bytes_per_pixel);
+    }
+}
+
+template <u32 bytes_per_pixel>
+void SwizzleTile(const u8* rows, std::ptrdiff_t pitch, u8* tile) {
+#if defined(ARCHITECTURE_x86_64) || defined(ARCHITECTURE_ARM64)
+    if constexpr (bytes_per_pixel == 4) {
+        return SwizzleTile32(rows, pitch, tile);
+    } else if constexpr (bytes_per_pixel == 2) {
+        return SwizzleTile16(rows, pitch, tile);
+    }
+#endif
+    // Pairs of pixels for the other sizes, or when there are no vector instructions
+    for (u32 pair = 0; pair < 32; ++pair) {
+        const u32 position = pair_positions[pair];
+        const u8* const src = rows + static_cast<std::ptrdiff_t>(position / 8) * pitch +
+                              (position % 8) * bytes_per_pixel;
+        std::memcpy(tile + pair * 2 * bytes_per_pixel, src, 2 * bytes_per_pixel);
+    }
+}
+
+/// Whether the pixels have to be converted on their way between the tile and the GL buffer
+template <PixelFormat format, bool gles>
+constexpr bool NeedsConversion() {
+    return format == PixelFormat::D24 || format == PixelFormat::D24S8 ||
+           (gles && (format == PixelFormat::RGBA8 || format == PixelFormat::RGB8));
+}
+
+/**
+ * Converts a row of 8 pixels between the guest layout and the GL layout. src and dst are packed
+ * for the guest side and use GetBytesPerPixel for the GL side.
+ */
+template <bool morton_to_gl, PixelFormat format, bool gles>
+void ConvertRow(const u8* src, u8* dst) {
+    constexpr u32 bytes_per_pixel = GetFormatBpp(format) / 8;
+    constexpr u32 aligned_bytes_per_pixel = GetBytesPerPixel(format);
+
+    if constexpr (format == PixelFormat::D24S8) {
+        // The guest stores the stencil in the upper byte, GL in the lower byte
+        for (u32 x = 0; x < 8; ++x) {
+            u32 value;
+            std::memcpy(&value, src + x * 4, sizeof(u32));
+            value = morton_to_gl ? (value << 8) | (value >> 24) : (value >> 8) | (value << 24);
+            std::memcpy(dst + x * 4, &value, sizeof(u32));
+        }
+    } else if constexpr (format == PixelFormat::RGBA8 && gles) {
+        // because GLES does not have ABGR format
+        // so we will do byteswapping here
+        for (u32 x = 0; x < 8; ++x) {
+            u32 value;
+            std::memcpy(&value, src + x * 4, sizeof(u32));
+            value = Common::swap32(value);
+            std::memcpy(dst + x * 4, &value, sizeof(u32));
+        }
+    } else if constexpr (format == PixelFormat::RGB8 && gles) {
+        for (u32 x = 0; x < 8; ++x) {
+            dst[x * 3 + 0] = src[x * 3 + 2];
+            dst[x * 3 + 1] = src[x * 3 + 1];
+            dst[x * 3 + 2] = src[x * 3 + 0];
+        }
+    } else {
+        // D24 is padded to 4 bytes in GL, the buffer is already offset so the padding comes first
+        constexpr u32 src_step = morton_to_gl ? bytes_per_pixel : aligned_bytes_per_pixel;
+        constexpr u32 dst_step = morton_to_gl ? aligned_bytes_per_pixel : bytes_per_pixel;
+        for (u32 x = 0; x < 8; ++x) {
+            std::memcpy(dst + x * dst_step, src + x * src_step, bytes_per_pixel);
+        }
+    }
+}
+
+template <bool morton_to_gl, PixelFormat format, bool gles>
+void MortonCopyTile(u32 stride, u8* tile_buffer, u8* gl_buffer) {
+    constexpr u32 bytes_per_pixel = GetFormatBpp(format) / 8;
+    constexpr u32 aligned_bytes_per_pixel = GetBytesPerPixel(format);
+
+    // GL buffers are stored bottom-up
+    const std::ptrdiff_t gl_pitch = -static_cast<std::ptrdiff_t>(stride * aligned_bytes_per_pixel);
+    u8* const gl_rows = gl_buffer - 7 * gl_pitch;
+
+    if constexpr (NeedsConversion<format, gles>()) {
+        constexpr std::ptrdiff_t linear_pitch = bytes_per_pixel * 8;
+        std::array<u8, bytes_per_pixel * 64> linear;
+        if constexpr (morton_to_gl) {
+            UnswizzleTile<bytes_per_pixel>(tile_buffer, linear.data(), linear_pitch);
+            for (u32 y = 0; y < 8; ++y) {
+                ConvertRow<true, format, gles>(&linear[y * linear_pitch], gl_rows + y * gl_pitch);
+            }
+        } else {
+            for (u32 y = 0; y < 8; ++y) {
+                ConvertRow<false, format, gles>(gl_rows + y * gl_pitch, &linear[y * linear_pitch]);
+            }
+            SwizzleTile<bytes_per_pixel>(linear.data(), linear_pitch, tile_buffer);
+        }
+    } else if constexpr (morton_to_gl) {
+        UnswizzleTile<bytes_per_pixel>(tile_buffer, gl_rows, gl_pitch);
+    } else {
+        SwizzleTile<bytes_per_pixel>(gl_rows, gl_pitch, tile_buffer);
+    }
+}
+
+/// Copies of at least this many bytes of whole tiles are split across the worker threads
+constexpr u32 PARALLEL_COPY_MIN_BYTES = 256 * 1024;
+
+/**
+ * Returns how many tiles starting at start can be accessed. Pokemon Super Mystery Dungeon will
+ * try to use textures that go beyond the end address of VRAM, so copies stop at the first tile
+ * which isn't backed by memory. Memory regions are contiguous, so the valid tiles always form a
+ * prefix of the range and can be found with a binary search instead of checking every tile.
+ */
+u32 CountValidTiles(PAddr start, u32 num_tiles, u32 tile_size) {
+    const auto is_valid = [start, tile_size](u32 tiles) {
+        return VideoCore::g_memory->IsValidPhysicalAddress(start + tiles * tile_size);
+    };
+    if (num_tiles == 0 || (is_valid(0) && is_valid(num_tiles))) {
+        return num_tiles;
+    }
+    if (!is_valid(0)) {
+        LOG_ERROR(Render_OpenGL, "Out of bound texture");
+        return 0;
+    }
+
+    // Tile i can be copied if the addresses start + i * tile_size and the one after are valid
+    u32 low = 0;
+    u32 high = num_tiles;
+    while (high - low > 1) {
+        const u32 middle = low + (high - low) / 2;
+        if (is_valid(middle)) {
+            low = middle;
+        } else {
+            high = middle;
+        }
+    }
+    LOG_ERROR(Render_OpenGL, "Out of bound texture");
+    return low;
+}
+
+template <bool morton_to_gl, PixelFormat format, bool gles>
+void MortonCopyImpl(u32 stride, u32 height, u8* gl_buffer, PAddr base, PAddr start, PAddr end,
+                    Common::ThreadWorker* workers) {
+    constexpr u32 bytes_per_pixel = GetFormatBpp(format) / 8;
+    constexpr u32 tile_size = bytes_per_pixel * 64;
+
+    constexpr u32 aligned_bytes_per_pixel = GetBytesPerPixel(format);
+    static_assert(aligned_bytes_per_pixel >= bytes_per_pixel, "");
+    gl_buffer += aligned_bytes_per_pixel - bytes_per_pixel;
+
+    const PAddr aligned_down_start = base + Common::AlignDown(start - base, tile_size);
+    const PAddr aligned_start = base + Common::AlignUp(start - base, tile_size);
+    const PAddr aligned_end = base + Common::AlignDown(end - base, tile_size);
+
+    ASSERT(!morton_to_gl || (aligned_start == start && aligned_end == end));
+
+    // Tiles are laid out in rows of stride / 8 tiles, the first row at the bottom of the buffer
+    const u32 tiles_per_row = stride / 8;
+    const auto gl_tile = [&](u32 tile_index) {
+        const u32 x = (tile_index % tiles_per_row) * 8;
+        const u32 y = (tile_index / tiles_per_row) * 8;
+        return gl_buffer + ((height - 8 - y) * stride + x) * aligned_bytes_per_pixel;
+    };
+
+    u8* tile_buffer = VideoCore::g_memory->GetPhysicalPointer(start);
+    u32 tile_index = (aligned_down_start - base) / tile_size;
+
+    if (start < aligned_start && !morton_to_gl) {
+        std::array<u8, tile_size> tmp_buf;
+        MortonCopyTile<morton_to_gl, format, gles>(stride, &tmp_buf[0], gl_tile(tile_index));
+        std::memcpy(tile_buffer, &tmp_buf[start - aligned_down_start],
+                    std::min(aligned_start, end) - start);
+
+        tile_buffer += aligned_start - start;
+        ++tile_index;
+    }
+
+    const u32 num_tiles =
+        aligned_end > aligned_start ? (aligned_end - aligned_start) / tile_size : 0;
+    const u32 valid_tiles = CountValidTiles(aligned_start, num_tiles, tile_size);
+
+    const auto copy_tiles = [&](u32 first, u32 last) {
+        for (u32 i = first; i < last; ++i) {
+            MortonCopyTile<morton_to_gl, format, gles>(stride, tile_buffer + i * tile_size,
+                                                       gl_tile(tile_index + i));
+        }
+    };
+
+    if (workers != nullptr && workers->NumWorkers() > 0 &&
+        valid_tiles * tile_size >= PARALLEL_COPY_MIN_BYTES) {
+        // Every tile maps to its own part of the GL buffer, so the ranges are independent
+        const u32 num_chunks = static_cast<u32>(workers->NumWorkers()) + 1;
+        const u32 chunk_size = (valid_tiles + num_chunks - 1) / num_chunks;
+        for (u32 first = chunk_size; first < valid_tiles; first += chunk_size) {
+            const u32 last = std::min(first + chunk_size, valid_tiles);
+            workers->QueueWork([&copy_tiles, first, last] { copy_tiles(first, last); });
+        }
+        copy_tiles(0, std::min(chunk_size, valid_tiles));
+        workers->WaitForRequests();
+    } else {
+        copy_tiles(0, valid_tiles);
+    }
+
+    if (valid_tiles < num_tiles) {
+        return;
+    }
+    tile_buffer += num_tiles * tile_size;
+    tile_index += num_tiles;
+
+    if (end > std::max(aligned_start, aligned_end) && !morton_to_gl) {
+        std::array<u8, tile_size> tmp_buf;
+        MortonCopyTile<morton_to_gl, format, gles>(stride, &tmp_buf[0], gl_tile(tile_index));
+        std::memcpy(tile_buffer, &tmp_buf[0], end - aligned_end);
+    }
+}
+
+template <bool morton_to_gl, PixelFormat format>
+void MortonCopy(u32 stride, u32 height, u8* gl_buffer, PAddr base, PAddr start, PAddr end,
+                Common::ThreadWorker* workers) {
+    if constexpr (format == PixelFormat::RGBA8 || format == PixelFormat::RGB8) {
+        if (GLES) {
+            MortonCopyImpl<morton_to_gl, format, true>(stride, height, gl_buffer, base, start,
+                                                       end, workers);
+            return;
+        }
+    }
+    MortonCopyImpl<morton_to_gl, format, false>(stride, height, gl_buffer, base, start, end,
+                                                workers);
+}
+
+} // Anonymous namespace
+
+const std::array<MortonFunc, 18> morton_to_gl_fns = {
+    MortonCopy<true, PixelFormat::RGBA8>,  // 0
+    MortonCopy<true, PixelFormat::RGB8>,   // 1
+    MortonCopy<true, PixelFormat::RGB5A1>, // 2
+    MortonCopy<true, PixelFormat::RGB565>, // 3
+    MortonCopy<true, PixelFormat::RGBA4>,  // 4
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,                             // 5 - 13
+    MortonCopy<true, PixelFormat::D16>,  // 14
+    nullptr,                             // 15
+    MortonCopy<true, PixelFormat::D24>,  // 16
+    MortonCopy<true, PixelFormat::D24S8> // 17
+};
+
+const std::array<MortonFunc, 18> gl_to_morton_fns = {
+    MortonCopy<false, PixelFormat::RGBA8>,  // 0
+    MortonCopy<false, PixelFormat::RGB8>,   // 1
+    MortonCopy<false, PixelFormat::RGB5A1>, // 2
+    MortonCopy<false, PixelFormat::RGB565>, // 3
+    MortonCopy<false, PixelFormat::RGBA4>,  // 4
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,                              // 5 - 13
+    MortonCopy<false, PixelFormat::D16>,  // 14
+    nullptr,                              // 15
+    MortonCopy<false, PixelFormat::D24>,  // 16
+    MortonCopy<false, PixelFormat::D24S8> // 17
+};
+
+} // namespace OpenGL
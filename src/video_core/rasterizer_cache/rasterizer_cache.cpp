@@ -3,10 +3,12 @@
 // Refer to the license.txt file included.
 
 #include <optional>
+#include <thread>
 #include <boost/range/iterator_range.hpp>
 #include "common/alignment.h"
 #include "common/logging/log.h"
 #include "common/microprofile.h"
+#include "common/thread_worker.h"
 #include "video_core/pica_state.h"
 #include "video_core/rasterizer_cache/rasterizer_cache.h"
 #include "video_core/renderer_opengl/gl_format_reinterpreter.h"
@@ -244,6 +246,12 @@ RasterizerCacheOpenGL::RasterizerCacheOpenGL() {
                                                          resolution_scale_factor);
     format_reinterpreter = std::make_unique<FormatReinterpreterOpenGL>();
     texture_downloader_es = std::make_unique<TextureDownloaderES>(false);
+
+    // The calling thread takes a share of every split copy, so it needs one helper less
+    const std::size_t num_threads = std::thread::hardware_concurrency();
+    if (num_threads > 1) {
+        morton_workers = std::make_unique<Common::ThreadWorker>(num_threads - 1, "MortonCopy");
+    }
 }
 
 RasterizerCacheOpenGL::~RasterizerCacheOpenGL() {
@@ -9,6 +9,10 @@
 #include "video_core/rasterizer_cache/surface_params.h"
 #include "video_core/texture/texture_decode.h"
 
+namespace Common {
+class ThreadWorker;
+}
+
 namespace OpenGL {
 
 enum class ScaleMatch {
@@ -126,6 +130,9 @@ public:
     std::unique_ptr<TextureFilterer> texture_filterer;
     std::unique_ptr<FormatReinterpreterOpenGL> format_reinterpreter;
     std::unique_ptr<TextureDownloaderES> texture_downloader_es;
+
+    /// Helper threads for large morton copies, null on single core hosts
+    std::unique_ptr<Common::ThreadWorker> morton_workers;
 };
 
 } // namespace OpenGL
@@ -0,0 +1,235 @@
+// Copyright 2022 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include "common/assert.h"
+#include "common/color.h"
+#include "common/logging/log.h"
+#include "core/core.h"
+#include "core/core_timing.h"
+#include "core/frontend/emu_window.h"
+#include "core/frontend/framebuffer_layout.h"
+#include "core/hw/hw.h"
+#include "core/hw/lcd.h"
+#include "core/memory.h"
+#include "core/settings.h"
+#include "core/tracer/recorder.h"
+#include "video_core/debug_utils/debug_utils.h"
+#include "video_core/renderer_software/renderer_software.h"
+#include "video_core/swrasterizer/swrasterizer.h"
+#include "video_core/video_core.h"
+
+namespace SwRenderer {
+
+namespace {
+
+using PixelDecoder = Common::Vec4<u8> (*)(const u8*);
+
+PixelDecoder GetPixelDecoder(GPU::Regs::PixelFormat format) {
+    switch (format) {
+    case GPU::Regs::PixelFormat::RGBA8:
+        return Color::DecodeRGBA8;
+    case GPU::Regs::PixelFormat::RGB8:
+        return Color::DecodeRGB8;
+    case GPU::Regs::PixelFormat::RGB565:
+        return Color::DecodeRGB565;
+    case GPU::Regs::PixelFormat::RGB5A1:
+        return Color::DecodeRGB5A1;
+    case GPU::Regs::PixelFormat::RGBA4:
+        return Color::DecodeRGBA4;
+    default:
+        UNIMPLEMENTED_MSG("Unknown framebuffer pixel format {}", format);
+        return nullptr;
+    }
+}
+
+void FillScreen(ScreenBuffer& screen, u32 width, u32 height, u8 r, u8 g, u8 b) {
+    screen.width = width;
+    screen.height = height;
+    screen.pixels.resize(width * height * 4);
+    for (std::size_t i = 0; i < screen.pixels.size(); i += 4) {
+        screen.pixels[i] = r;
+        screen.pixels[i + 1] = g;
+        screen.pixels[i + 2] = b;
+        screen.pixels[i + 3] = 255;
+    }
+}
+
+} // Anonymous namespace
+
+RendererSoftware::RendererSoftware(Frontend::EmuWindow& window) : RendererBase{window} {}
+
+RendererSoftware::~RendererSoftware() = default;
+
+VideoCore::ResultStatus RendererSoftware::Init() {
+    rasterizer = std::make_unique<VideoCore::SWRasterizer>();
+    return VideoCore::ResultStatus::Success;
+}
+
+void RendererSoftware::ShutDown() {}
+
+void RendererSoftware::SwapBuffers() {
+    PrepareRendertarget();
+
+    RenderScreenshot();
+
+    m_current_frame++;
+
+    // Frames are only paced while a title is running, the renderer can be driven without one
+    auto& system = Core::System::GetInstance();
+    if (system.perf_stats) {
+        system.perf_stats->EndSystemFrame();
+    }
+
+    render_window.PollEvents();
+
+    if (system.perf_stats) {
+        system.frame_limiter.DoFrameLimiting(system.CoreTiming().GetGlobalTimeUs());
+        system.perf_stats->BeginSystemFrame();
+    }
+
+    if (Pica::g_debug_context && Pica::g_debug_context->recorder) {
+        Pica::g_debug_context->recorder->FrameFinished();
+    }
+}
+
+void RendererSoftware::PrepareVideoDumping() {
+    LOG_ERROR(Render, "Video dumping is not supported by the software renderer");
+}
+
+void RendererSoftware::PrepareRendertarget() {
+    for (const ScreenId id : {ScreenId::TopLeft, ScreenId::TopRight, ScreenId::Bottom}) {
+        const int fb_id = id == ScreenId::Bottom ? 1 : 0;
+        const auto& framebuffer = GPU::g_regs.framebuffer_config[fb_id];
+        ScreenBuffer& screen = screens[static_cast<u32>(id)];
+
+        // Main LCD (0): 0x1ED02204, Sub LCD (1): 0x1ED02A04
+        u32 lcd_color_addr =
+            (fb_id == 0) ? LCD_REG_INDEX(color_fill_top) : LCD_REG_INDEX(color_fill_bottom);
+        lcd_color_addr = HW::VADDR_LCD + 4 * lcd_color_addr;
+        LCD::Regs::ColorFill color_fill = {0};
+        LCD::Read(color_fill.raw, lcd_color_addr);
+
+        if (color_fill.is_enabled) {
+            FillScreen(screen, framebuffer.height, framebuffer.width,
+                       static_cast<u8>(color_fill.color_r), static_cast<u8>(color_fill.color_g),
+                       static_cast<u8>(color_fill.color_b));
+        } else {
+            LoadFBToScreen(framebuffer, screen, id == ScreenId::TopRight);
+        }
+    }
+}
+
+void RendererSoftware::LoadFBToScreen(const GPU::Regs::FramebufferConfig& framebuffer,
+                                      ScreenBuffer& screen, bool right_eye) {
+    if (framebuffer.address_right1 == 0 || framebuffer.address_right2 == 0)
+        right_eye = false;
+
+    const PAddr framebuffer_addr =
+        framebuffer.active_fb == 0
+            ? (!right_eye ? framebuffer.address_left1 : framebuffer.address_right1)
+            : (!right_eye ? framebuffer.address_left2 : framebuffer.address_right2);
+
+    LOG_TRACE(Render_Software, "0x{:08x} bytes from 0x{:08x}({}x{}), fmt {:x}",
+              framebuffer.stride * framebuffer.height, framebuffer_addr, framebuffer.width.Value(),
+              framebuffer.height.Value(), framebuffer.format);
+
+    const PixelDecoder decode = GetPixelDecoder(framebuffer.color_format);
+    const u32 bpp = GPU::Regs::BytesPerPixel(framebuffer.color_format);
+    const u32 fb_width = framebuffer.width;
+    const u32 fb_height = framebuffer.height;
+    const u32 fb_size = framebuffer.stride * fb_height;
+    if (decode == nullptr || fb_size == 0 ||
+        !VideoCore::g_memory->IsValidPhysicalAddress(framebuffer_addr + fb_size - 1)) {
+        return;
+    }
+    const u8* framebuffer_data = VideoCore::g_memory->GetPhysicalPointer(framebuffer_addr);
+    if (framebuffer_data == nullptr) {
+        return;
+    }
+
+    // The LCDs are mounted sideways: each framebuffer row is a screen column, bottom to top
+    screen.width = fb_height;
+    screen.height = fb_width;
+    screen.pixels.resize(fb_width * fb_height * 4);
+    for (u32 row = 0; row < fb_height; ++row) {
+        const u8* source = framebuffer_data + row * framebuffer.stride;
+        for (u32 x = 0; x < fb_width; ++x) {
+            const Common::Vec4<u8> color = decode(source + x * bpp);
+            u8* dest = &screen.pixels[((fb_width - 1 - x) * screen.width + row) * 4];
+            dest[0] = color.r();
+            dest[1] = color.g();
+            dest[2] = color.b();
+            dest[3] = 255;
+        }
+    }
+}
+
+void RendererSoftware::RenderScreenshot() {
+    if (!VideoCore::g_renderer_screenshot_requested) {
+        return;
+    }
+
+    const Layout::FramebufferLayout layout{VideoCore::g_screenshot_framebuffer_layout};
+    u8* image = static_cast<u8*>(VideoCore::g_screenshot_bits);
+
+    const auto to_u8 = [](float value) {
+        return static_cast<u8>(std::clamp(value, 0.0f, 1.0f) * 255.0f);
+    };
+    const u8 bg_red = to_u8(Settings::values.bg_red);
+    const u8 bg_green = to_u8(Settings::values.bg_green);
+    const u8 bg_blue = to_u8(Settings::values.bg_blue);
+    for (std::size_t i = 0; i < std::size_t{layout.width} * layout.height * 4; i += 4) {
+        image[i] = bg_blue;
+        image[i + 1] = bg_green;
+        image[i + 2] = bg_red;
+        image[i + 3] = 0;
+    }
+
+    if (layout.top_screen_enabled) {
+        DrawScreen(screens[static_cast<u32>(ScreenId::TopLeft)], layout.top_screen,
+                   layout.is_rotated, layout, image);
+    }
+    if (layout.bottom_screen_enabled) {
+        DrawScreen(screens[static_cast<u32>(ScreenId::Bottom)], layout.bottom_screen,
+                   layout.is_rotated, layout, image);
+    }
+
+    VideoCore::g_screenshot_complete_callback();
+    VideoCore::g_renderer_screenshot_requested = false;
+}
+
+void RendererSoftware::DrawScreen(const ScreenBuffer& screen, const Common::Rectangle<u32>& rect,
+                                  bool rotated, const Layout::FramebufferLayout& layout,
+                                  u8* image) {
+    if (screen.pixels.empty()) {
+        return;
+    }
+
+    // Layouts which are not rotated show the screens upright, turned by 90 degrees
+    const u32 source_width = rotated ? screen.width : screen.height;
+    const u32 source_height = rotated ? screen.height : screen.width;
+    const u32 width = std::min(rect.GetWidth(), layout.width - std::min(rect.left, layout.width));
+    const u32 height =
+        std::min(rect.GetHeight(), layout.height - std::min(rect.top, layout.height));
+
+    for (u32 y = 0; y < height; ++y) {
+        const u32 source_y = y * source_height / rect.GetHeight();
+        // Like screenshots read back from OpenGL, the rows are stored bottom up
+        u8* dest_row = image + std::size_t{layout.height - 1 - (rect.top + y)} * layout.width * 4;
+        for (u32 x = 0; x < width; ++x) {
+            const u32 source_x = x * source_width / rect.GetWidth();
+            const u32 px = rotated ? source_x : screen.width - 1 - source_y;
+            const u32 py = rotated ? source_y : source_x;
+            const u8* source = &screen.pixels[(py * screen.width + px) * 4];
+            u8* dest = dest_row + (rect.left + x) * 4;
+            dest[0] = source[2];
+            dest[1] = source[1];
+            dest[2] = source[0];
+            dest[3] = source[3];
+        }
+    }
+}
+
+} // namespace SwRenderer
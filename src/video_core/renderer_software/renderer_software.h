@@ -0,0 +1,74 @@
+// Copyright 2022 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <vector>
+#include "common/math_util.h"
+#include "core/hw/gpu.h"
+#include "video_core/renderer_base.h"
+
+namespace Layout {
+struct FramebufferLayout;
+}
+
+namespace SwRenderer {
+
+enum class ScreenId : u32 {
+    TopLeft,
+    TopRight,
+    Bottom,
+};
+
+/// Contents of an emulated LCD, oriented as seen when holding the console normally
+struct ScreenBuffer {
+    u32 width = 0;
+    u32 height = 0;
+    /// RGBA8 pixels, row by row starting at the top left corner
+    std::vector<u8> pixels;
+};
+
+/**
+ * Renderer which runs entirely on the CPU: the PICA is emulated by the software rasterizer and the
+ * LCD framebuffers are composed in memory, so no graphics context is required. The screens are
+ * not presented anywhere but can be read back through GetScreen, which makes the renderer suitable
+ * for headless use.
+ */
+class RendererSoftware : public RendererBase {
+public:
+    explicit RendererSoftware(Frontend::EmuWindow& window);
+    ~RendererSoftware() override;
+
+    VideoCore::ResultStatus Init() override;
+    void ShutDown() override;
+    void SwapBuffers() override;
+    void TryPresent(int timeout_ms) override {}
+    void PrepareVideoDumping() override;
+    void CleanupVideoDumping() override {}
+
+    /// Returns the given screen as of the last frame. Must be called from the emulation thread.
+    [[nodiscard]] const ScreenBuffer& GetScreen(ScreenId id) const {
+        return screens[static_cast<u32>(id)];
+    }
+
+private:
+    /// Reads the framebuffers the LCDs are currently configured to display
+    void PrepareRendertarget();
+
+    /// Converts the given framebuffer to a screen buffer, rotating it to the viewing orientation
+    void LoadFBToScreen(const GPU::Regs::FramebufferConfig& framebuffer, ScreenBuffer& screen,
+                        bool right_eye);
+
+    /// Draws the screens into the pending screenshot buffer, if a screenshot was requested
+    void RenderScreenshot();
+
+    /// Draws a screen into a BGRA8 image with its rows stored bottom up, scaled to the rectangle
+    void DrawScreen(const ScreenBuffer& screen, const Common::Rectangle<u32>& rect, bool rotated,
+                    const Layout::FramebufferLayout& layout, u8* image);
+
+    std::array<ScreenBuffer, 3> screens;
+};
+
+} // namespace SwRenderer
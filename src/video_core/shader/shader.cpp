@@ -12,9 +12,11 @@
 #include "video_core/regs_shader.h"
 #include "video_core/shader/shader.h"
 #include "video_core/shader/shader_interpreter.h"
-#ifdef ARCHITECTURE_x86_64
+#if defined(ARCHITECTURE_x86_64)
 #include "video_core/shader/shader_jit_x64.h"
-#endif // ARCHITECTURE_x86_64
+#elif defined(ARCHITECTURE_ARM64)
+#include "video_core/shader/shader_jit_a64.h"
+#endif
 #include "video_core/video_core.h"
 
 namespace Pica::Shader {
@@ -132,31 +134,44 @@ void GSUnitState::ConfigOutput(const ShaderRegs& config) {
     emitter.output_mask = config.output_mask;
 }
 
+void ShaderEngine::RunBatch(const ShaderSetup& setup, UnitState* states,
+                            std::size_t count) const {
+    ASSERT(count <= MAX_BATCH_SIZE);
+    for (std::size_t i = 0; i < count; ++i) {
+        Run(setup, states[i]);
+    }
+}
+
 MICROPROFILE_DEFINE(GPU_Shader, "GPU", "Shader", MP_RGB(50, 50, 240));
 
-#ifdef ARCHITECTURE_x86_64
-static std::unique_ptr<JitX64Engine> jit_engine;
-#endif // ARCHITECTURE_x86_64
+#if defined(ARCHITECTURE_x86_64)
+using JitEngine = JitX64Engine;
+#elif defined(ARCHITECTURE_ARM64)
+using JitEngine = JitA64Engine;
+#endif
+#if defined(ARCHITECTURE_x86_64) || defined(ARCHITECTURE_ARM64)
+static std::unique_ptr<JitEngine> jit_engine;
+#endif
 static InterpreterEngine interpreter_engine;
 
 ShaderEngine* GetEngine() {
-#ifdef ARCHITECTURE_x86_64
+#if defined(ARCHITECTURE_x86_64) || defined(ARCHITECTURE_ARM64)
     // TODO(yuriks): Re-initialize on each change rather than being persistent
     if (VideoCore::g_shader_jit_enabled) {
         if (jit_engine == nullptr) {
-            jit_engine = std::make_unique<JitX64Engine>();
+            jit_engine = std::make_unique<JitEngine>();
         }
         return jit_engine.get();
     }
-#endif // ARCHITECTURE_x86_64
+#endif
 
     return &interpreter_engine;
 }
 
 void Shutdown() {
-#ifdef ARCHITECTURE_x86_64
+#if defined(ARCHITECTURE_x86_64) || defined(ARCHITECTURE_ARM64)
     jit_engine = nullptr;
-#endif // ARCHITECTURE_x86_64
+#endif
 }
 
 } // namespace Pica::Shader
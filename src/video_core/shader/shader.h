@@ -29,6 +29,8 @@ namespace Pica::Shader {
 
 constexpr unsigned MAX_PROGRAM_CODE_LENGTH = 4096;
 constexpr unsigned MAX_SWIZZLE_DATA_LENGTH = 4096;
+/// Maximum number of units ShaderEngine::RunBatch processes at once
+constexpr std::size_t MAX_BATCH_SIZE = 8;
 using ProgramCode = std::array<u32, MAX_PROGRAM_CODE_LENGTH>;
 using SwizzleData = std::array<u32, MAX_SWIZZLE_DATA_LENGTH>;
 
@@ -340,6 +342,16 @@ public:
      * @param state Shader unit state, must be setup with input data before each shader invocation.
      */
     virtual void Run(const ShaderSetup& setup, UnitState& state) const = 0;
+
+    /**
+     * Runs the currently setup shader on several vertex shader units. Equivalent to calling `Run`
+     * on each of them; engines that can process vertices side by side override this.
+     *
+     * @param setup Shader engine state, must be setup with SetupBatch on each shader change.
+     * @param states Shader unit states, each setup with input data.
+     * @param count Number of units in `states`, at most MAX_BATCH_SIZE.
+     */
+    virtual void RunBatch(const ShaderSetup& setup, UnitState* states, std::size_t count) const;
 };
 
 // TODO(yuriks): Remove and make it non-global state somewhere
@@ -4,12 +4,14 @@
 
 #include <algorithm>
 #include <array>
+#include <bit>
 #include <cmath>
 #include <numeric>
 #include <boost/container/static_vector.hpp>
 #include <boost/range/algorithm/fill.hpp>
 #include <nihstro/shader_bytecode.h>
 #include "common/assert.h"
+#include "common/bit_set.h"
 #include "common/common_types.h"
 #include "common/logging/log.h"
 #include "common/microprofile.h"
@@ -80,8 +82,8 @@ static void RunInterpreter(const ShaderSetup& setup, UnitState& state, DebugData
     const auto& swizzle_data = setup.swizzle_data;
     const auto& program_code = setup.program_code;
 
-    // Placeholder for invalid inputs
-    static float24 dummy_vec4_float24[4];
+    // Placeholder for invalid inputs, per thread since vertices may be shaded concurrently
+    static thread_local float24 dummy_vec4_float24[4];
 
     unsigned iteration = 0;
     bool exit_loop = false;
@@ -666,6 +668,738 @@ static void RunInterpreter(const ShaderSetup& setup, UnitState& state, DebugData
     }
 }
 
+/// One value per lane of a batch
+template <std::size_t N>
+using LaneFloats = std::array<float, N>;
+
+/// A vec4 register of a batch, stored as one lane array per component
+template <std::size_t N>
+using LaneVec4 = std::array<LaneFloats<N>, 4>;
+
+/// One of the register files of a batch
+template <std::size_t N>
+struct BatchRegisters {
+    alignas(16) std::array<LaneVec4<N>, 16> values;
+    /// Registers copied in from the units so far, the others are copied on first access
+    u32 loaded = 0;
+    /// Registers written by the program, the only ones that need copying back to the units
+    u32 written = 0;
+};
+
+/// Registers of the units in a batch, transposed so that each instruction processes all lanes
+template <std::size_t N>
+class BatchState {
+public:
+    BatchState(const UnitState* units, std::size_t num_units) : units(units), num_units(num_units) {
+        for (std::size_t lane = 0; lane < N; ++lane) {
+            for (std::size_t i = 0; i < 3; ++i) {
+                address_registers[i][lane] = GetUnit(lane).address_registers[i];
+            }
+        }
+    }
+
+    const LaneVec4<N>& Input(int index) {
+        return Load(input, index, [](const UnitState& unit) { return unit.registers.input; });
+    }
+
+    const LaneVec4<N>& Temporary(int index) {
+        return Load(temporary, index,
+                    [](const UnitState& unit) { return unit.registers.temporary; });
+    }
+
+    /// Returns the destination register for a write. Unless all of the register is overwritten,
+    /// it has to be copied in from the units first.
+    LaneVec4<N>& Dest(const DestRegister& dest_reg, bool overwrites_all) {
+        const int index = dest_reg.GetIndex();
+        auto& registers = (dest_reg < 0x10) ? output : temporary;
+        if (overwrites_all) {
+            registers.loaded |= 1u << index;
+        } else if (dest_reg < 0x10) {
+            Load(output, index, [](const UnitState& unit) { return unit.registers.output; });
+        } else {
+            Load(temporary, index, [](const UnitState& unit) { return unit.registers.temporary; });
+        }
+        registers.written |= 1u << index;
+        return registers.values[index];
+    }
+
+    /// Copies the results of a lane back to its unit
+    void Store(UnitState& unit, std::size_t lane) const {
+        for (int reg : Common::BitSet<u32>(output.written)) {
+            for (std::size_t i = 0; i < 4; ++i) {
+                unit.registers.output[reg][i] = float24::FromFloat32(output.values[reg][i][lane]);
+            }
+        }
+        for (int reg : Common::BitSet<u32>(temporary.written)) {
+            for (std::size_t i = 0; i < 4; ++i) {
+                unit.registers.temporary[reg][i] =
+                    float24::FromFloat32(temporary.values[reg][i][lane]);
+            }
+        }
+        for (std::size_t i = 0; i < 3; ++i) {
+            unit.address_registers[i] = address_registers[i][lane];
+        }
+        unit.conditional_code[0] = (conditional_code[0] >> lane) & 1;
+        unit.conditional_code[1] = (conditional_code[1] >> lane) & 1;
+    }
+
+    std::array<std::array<s32, N>, 3> address_registers;
+    /// Bit `lane` of each mask holds the conditional code of that lane
+    std::array<u32, 2> conditional_code{};
+
+private:
+    /// Padding lanes duplicate the last unit, which keeps them from producing exceptional values
+    /// of their own
+    const UnitState& GetUnit(std::size_t lane) const {
+        return units[std::min(lane, num_units - 1)];
+    }
+
+    template <typename F>
+    const LaneVec4<N>& Load(BatchRegisters<N>& registers, int index, F&& unit_registers) {
+        if (!(registers.loaded & (1u << index))) {
+            registers.loaded |= 1u << index;
+            for (std::size_t lane = 0; lane < N; ++lane) {
+                const auto& value = unit_registers(GetUnit(lane))[index];
+                for (std::size_t i = 0; i < 4; ++i) {
+                    registers.values[index][i][lane] = value[i].ToFloat32();
+                }
+            }
+        }
+        return registers.values[index];
+    }
+
+    const UnitState* units;
+    std::size_t num_units;
+
+    BatchRegisters<N> input;
+    BatchRegisters<N> temporary;
+    BatchRegisters<N> output;
+};
+
+struct BatchCallStackElement {
+    u32 final_address;      // Address upon which we jump to return_address
+    u32 return_address;     // Where to jump when leaving scope
+    u8 repeat_counter;      // How often to repeat until this call stack element is removed
+    u8 loop_increment;      // Which value to add to the loop counter after an iteration
+    u32 loop_address;       // The address where we'll return to after each loop iteration
+    u32 return_lanes;       // Lanes active again after leaving scope
+    u32 else_lanes;         // Lanes of a diverging IFC waiting to run the else branch
+    u32 else_final_address; // Address upon which the else branch is left
+};
+
+/// Multiplication with the PICA behaviour of giving 0 instead of NaN when multiplying by inf
+static float MultiplyPica(float a, float b) {
+    const float result = a * b;
+    // Written as comparisons rather than std::isnan so that lane loops using this vectorize
+    return (result != result && a == a && b == b) ? 0.f : result;
+}
+
+template <std::size_t N>
+static void LoadBatchSource(BatchState<N>& state, const ShaderSetup& setup,
+                            const SourceRegister& source_reg, const s32* offsets,
+                            const std::array<int, 4>& selectors, bool negate, LaneVec4<N>& out) {
+    // Loads the same register for all lanes, with each component being a copy of a lane array
+    const auto load_register = [&](const SourceRegister& reg) {
+        switch (reg.GetRegisterType()) {
+        case RegisterType::Input:
+        case RegisterType::Temporary: {
+            const auto& value = (reg.GetRegisterType() == RegisterType::Input)
+                                    ? state.Input(reg.GetIndex())
+                                    : state.Temporary(reg.GetIndex());
+            for (std::size_t i = 0; i < 4; ++i) {
+                out[i] = value[selectors[i]];
+            }
+            break;
+        }
+
+        case RegisterType::FloatUniform: {
+            const auto& value = setup.uniforms.f[reg.GetIndex()];
+            for (std::size_t i = 0; i < 4; ++i) {
+                out[i].fill(value[selectors[i]].ToFloat32());
+            }
+            break;
+        }
+
+        default:
+            for (auto& component : out) {
+                component.fill(0.f);
+            }
+            break;
+        }
+    };
+
+    const auto load_lane = [&](const SourceRegister& reg, std::size_t lane) {
+        switch (reg.GetRegisterType()) {
+        case RegisterType::Input:
+        case RegisterType::Temporary: {
+            const auto& value = (reg.GetRegisterType() == RegisterType::Input)
+                                    ? state.Input(reg.GetIndex())
+                                    : state.Temporary(reg.GetIndex());
+            for (std::size_t i = 0; i < 4; ++i) {
+                out[i][lane] = value[selectors[i]][lane];
+            }
+            break;
+        }
+
+        case RegisterType::FloatUniform: {
+            const auto& value = setup.uniforms.f[reg.GetIndex()];
+            for (std::size_t i = 0; i < 4; ++i) {
+                out[i][lane] = value[selectors[i]].ToFloat32();
+            }
+            break;
+        }
+
+        default:
+            for (auto& component : out) {
+                component[lane] = 0.f;
+            }
+            break;
+        }
+    };
+
+    if (offsets == nullptr) {
+        load_register(source_reg);
+    } else if (std::all_of(offsets, offsets + N,
+                           [&](s32 offset) { return offset == offsets[0]; })) {
+        load_register(source_reg + offsets[0]);
+    } else {
+        // Relative addressing, e.g. to index a matrix palette, may read a different register
+        // in each lane
+        for (std::size_t lane = 0; lane < N; ++lane) {
+            load_lane(source_reg + offsets[lane], lane);
+        }
+    }
+
+    if (negate) {
+        for (auto& component : out) {
+            for (float& value : component) {
+                value = -value;
+            }
+        }
+    }
+}
+
+/// Writes value(component, lane) to the enabled components of dest in the given lanes
+template <std::size_t N, typename F>
+static void WriteBatchDest(BatchState<N>& state, const DestRegister& dest_reg,
+                           const SwizzlePattern& swizzle, u32 lanes, F&& value) {
+    constexpr u32 all_lanes = (1u << N) - 1;
+
+    auto& dest = state.Dest(dest_reg, lanes == all_lanes && swizzle.dest_mask == 0xF);
+
+    for (int i = 0; i < 4; ++i) {
+        if (!swizzle.DestComponentEnabled(i))
+            continue;
+
+        if (lanes == all_lanes) {
+            for (std::size_t lane = 0; lane < N; ++lane) {
+                dest[i][lane] = value(i, lane);
+            }
+        } else {
+            for (std::size_t lane = 0; lane < N; ++lane) {
+                if (lanes & (1u << lane)) {
+                    dest[i][lane] = value(i, lane);
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Runs the shader on all lanes in `lanes` in lock step, returning the lanes that couldn't be
+ * completed and have to be run by the scalar interpreter.
+ *
+ * Lanes taking different sides of an IFC or CALLC are deactivated while the other lanes execute
+ * and are reactivated once the branch is left. Lanes which are inactive from the beginning only
+ * serve as padding: their registers are overwritten freely but never copied back.
+ */
+template <std::size_t N>
+static u32 RunInterpreterBatch(const ShaderSetup& setup, BatchState<N>& state, u32 lanes,
+                               unsigned offset) {
+    constexpr u32 all_lanes = (1u << N) - 1;
+    const u32 padding = all_lanes & ~lanes;
+
+    boost::container::static_vector<BatchCallStackElement, 16> call_stack;
+    u32 program_counter = offset;
+    u32 active = lanes;
+    u32 rerun = 0;
+
+    auto call = [&](u32 offset, u32 num_instructions, u32 return_offset, u8 repeat_count,
+                    u8 loop_increment, u32 call_lanes) {
+        // -1 to make sure when incrementing the PC we end up at the correct offset
+        program_counter = offset - 1;
+        ASSERT(call_stack.size() < call_stack.capacity());
+        call_stack.push_back({offset + num_instructions, return_offset, repeat_count,
+                              loop_increment, offset, active, 0, 0});
+        active = call_lanes;
+    };
+
+    // Removes lanes from the batch, leaving them to be run again by the scalar interpreter
+    auto drop_lanes = [&](u32 dropped) {
+        rerun |= dropped;
+        active &= ~dropped;
+        for (auto& element : call_stack) {
+            element.return_lanes &= ~dropped;
+            element.else_lanes &= ~dropped;
+        }
+    };
+
+    auto evaluate_condition = [&state](Instruction::FlowControlType flow_control) -> u32 {
+        using Op = Instruction::FlowControlType::Op;
+
+        const u32 result_x =
+            flow_control.refx.Value() ? state.conditional_code[0] : ~state.conditional_code[0];
+        const u32 result_y =
+            flow_control.refy.Value() ? state.conditional_code[1] : ~state.conditional_code[1];
+
+        switch (flow_control.op) {
+        case Op::Or:
+            return result_x | result_y;
+        case Op::And:
+            return result_x & result_y;
+        case Op::JustX:
+            return result_x;
+        case Op::JustY:
+            return result_y;
+        default:
+            UNREACHABLE();
+            return 0;
+        }
+    };
+
+    const auto& uniforms = setup.uniforms;
+    const auto& swizzle_data = setup.swizzle_data;
+    const auto& program_code = setup.program_code;
+
+    while (true) {
+        if (!call_stack.empty()) {
+            auto& top = call_stack.back();
+            if (program_counter == top.final_address) {
+                if (top.else_lanes != 0) {
+                    // The else branch of a diverging IFC starts where its if branch ends
+                    active = top.else_lanes;
+                    top.else_lanes = 0;
+                    top.final_address = top.else_final_address;
+                    continue;
+                }
+
+                for (std::size_t lane = 0; lane < N; ++lane) {
+                    if (active & (1u << lane)) {
+                        state.address_registers[2][lane] += top.loop_increment;
+                    }
+                }
+
+                if (top.repeat_counter-- == 0) {
+                    program_counter = top.return_address;
+                    active = top.return_lanes;
+                    call_stack.pop_back();
+                } else {
+                    program_counter = top.loop_address;
+                }
+
+                continue;
+            }
+        }
+
+        const Instruction instr = {program_code[program_counter]};
+        const u32 write_lanes = active | padding;
+
+        switch (instr.opcode.Value().GetInfo().type) {
+        case OpCode::Type::Arithmetic: {
+            const SwizzlePattern swizzle = {swizzle_data[instr.common.operand_desc_id]};
+            const bool is_inverted =
+                (0 != (instr.opcode.Value().GetInfo().subtype & OpCode::Info::SrcInversed));
+
+            const auto* offsets =
+                (instr.common.address_register_index == 0)
+                    ? nullptr
+                    : state.address_registers[instr.common.address_register_index - 1].data();
+
+            LaneVec4<N> src1;
+            LaneVec4<N> src2;
+            LoadBatchSource(state, setup, instr.common.GetSrc1(is_inverted),
+                            is_inverted ? nullptr : offsets,
+                            {(int)swizzle.src1_selector_0.Value(),
+                             (int)swizzle.src1_selector_1.Value(),
+                             (int)swizzle.src1_selector_2.Value(),
+                             (int)swizzle.src1_selector_3.Value()},
+                            swizzle.negate_src1 != 0, src1);
+            LoadBatchSource(state, setup, instr.common.GetSrc2(is_inverted),
+                            is_inverted ? offsets : nullptr,
+                            {(int)swizzle.src2_selector_0.Value(),
+                             (int)swizzle.src2_selector_1.Value(),
+                             (int)swizzle.src2_selector_2.Value(),
+                             (int)swizzle.src2_selector_3.Value()},
+                            swizzle.negate_src2 != 0, src2);
+
+            const auto write_dest = [&](auto&& value) {
+                WriteBatchDest(state, instr.common.dest.Value(), swizzle, write_lanes, value);
+            };
+
+            switch (instr.opcode.Value().EffectiveOpCode()) {
+            case OpCode::Id::ADD:
+                write_dest([&](int i, std::size_t lane) { return src1[i][lane] + src2[i][lane]; });
+                break;
+
+            case OpCode::Id::MUL:
+                write_dest([&](int i, std::size_t lane) {
+                    return MultiplyPica(src1[i][lane], src2[i][lane]);
+                });
+                break;
+
+            case OpCode::Id::FLR:
+                write_dest([&](int i, std::size_t lane) { return std::floor(src1[i][lane]); });
+                break;
+
+            case OpCode::Id::MAX:
+                // NOTE: Same NaN semantics as the scalar interpreter
+                write_dest([&](int i, std::size_t lane) {
+                    return (src1[i][lane] > src2[i][lane]) ? src1[i][lane] : src2[i][lane];
+                });
+                break;
+
+            case OpCode::Id::MIN:
+                write_dest([&](int i, std::size_t lane) {
+                    return (src1[i][lane] < src2[i][lane]) ? src1[i][lane] : src2[i][lane];
+                });
+                break;
+
+            case OpCode::Id::DP3:
+            case OpCode::Id::DP4:
+            case OpCode::Id::DPH:
+            case OpCode::Id::DPHI: {
+                const OpCode::Id opcode = instr.opcode.Value().EffectiveOpCode();
+                if (opcode == OpCode::Id::DPH || opcode == OpCode::Id::DPHI)
+                    src1[3].fill(1.0f);
+
+                const int num_components = (opcode == OpCode::Id::DP3) ? 3 : 4;
+                LaneFloats<N> dot;
+                dot.fill(0.f);
+                for (int i = 0; i < num_components; ++i) {
+                    for (std::size_t lane = 0; lane < N; ++lane) {
+                        dot[lane] = dot[lane] + MultiplyPica(src1[i][lane], src2[i][lane]);
+                    }
+                }
+                write_dest([&](int, std::size_t lane) { return dot[lane]; });
+                break;
+            }
+
+            // Reciprocal
+            case OpCode::Id::RCP: {
+                LaneFloats<N> rcp_res;
+                for (std::size_t lane = 0; lane < N; ++lane) {
+                    rcp_res[lane] = 1.0f / src1[0][lane];
+                }
+                write_dest([&](int, std::size_t lane) { return rcp_res[lane]; });
+                break;
+            }
+
+            // Reciprocal Square Root
+            case OpCode::Id::RSQ: {
+                LaneFloats<N> rsq_res;
+                for (std::size_t lane = 0; lane < N; ++lane) {
+                    rsq_res[lane] = 1.0f / std::sqrt(src1[0][lane]);
+                }
+                write_dest([&](int, std::size_t lane) { return rsq_res[lane]; });
+                break;
+            }
+
+            case OpCode::Id::MOVA:
+                for (int i = 0; i < 2; ++i) {
+                    if (!swizzle.DestComponentEnabled(i))
+                        continue;
+
+                    for (std::size_t lane = 0; lane < N; ++lane) {
+                        if (write_lanes & (1u << lane)) {
+                            state.address_registers[i][lane] = static_cast<s32>(src1[i][lane]);
+                        }
+                    }
+                }
+                break;
+
+            case OpCode::Id::MOV:
+                write_dest([&](int i, std::size_t lane) { return src1[i][lane]; });
+                break;
+
+            case OpCode::Id::SGE:
+            case OpCode::Id::SGEI:
+                write_dest([&](int i, std::size_t lane) {
+                    return (src1[i][lane] >= src2[i][lane]) ? 1.0f : 0.0f;
+                });
+                break;
+
+            case OpCode::Id::SLT:
+            case OpCode::Id::SLTI:
+                write_dest([&](int i, std::size_t lane) {
+                    return (src1[i][lane] < src2[i][lane]) ? 1.0f : 0.0f;
+                });
+                break;
+
+            case OpCode::Id::CMP:
+                for (int i = 0; i < 2; ++i) {
+                    auto compare_op = instr.common.compare_op;
+                    auto op = (i == 0) ? compare_op.x.Value() : compare_op.y.Value();
+
+                    const auto compare = [&](auto&& predicate) {
+                        u32 result = 0;
+                        for (std::size_t lane = 0; lane < N; ++lane) {
+                            result |= predicate(src1[i][lane], src2[i][lane]) ? (1u << lane) : 0;
+                        }
+                        state.conditional_code[i] =
+                            (state.conditional_code[i] & ~write_lanes) | (result & write_lanes);
+                    };
+
+                    switch (op) {
+                    case Instruction::Common::CompareOpType::Equal:
+                        compare([](float a, float b) { return a == b; });
+                        break;
+
+                    case Instruction::Common::CompareOpType::NotEqual:
+                        compare([](float a, float b) { return a != b; });
+                        break;
+
+                    case Instruction::Common::CompareOpType::LessThan:
+                        compare([](float a, float b) { return a < b; });
+                        break;
+
+                    case Instruction::Common::CompareOpType::LessEqual:
+                        compare([](float a, float b) { return a <= b; });
+                        break;
+
+                    case Instruction::Common::CompareOpType::GreaterThan:
+                        compare([](float a, float b) { return a > b; });
+                        break;
+
+                    case Instruction::Common::CompareOpType::GreaterEqual:
+                        compare([](float a, float b) { return a >= b; });
+                        break;
+
+                    default:
+                        LOG_ERROR(HW_GPU, "Unknown compare mode {:x}", static_cast<int>(op));
+                        break;
+                    }
+                }
+                break;
+
+            case OpCode::Id::EX2: {
+                LaneFloats<N> ex2_res;
+                for (std::size_t lane = 0; lane < N; ++lane) {
+                    ex2_res[lane] = std::exp2(src1[0][lane]);
+                }
+                write_dest([&](int, std::size_t lane) { return ex2_res[lane]; });
+                break;
+            }
+
+            case OpCode::Id::LG2: {
+                LaneFloats<N> lg2_res;
+                for (std::size_t lane = 0; lane < N; ++lane) {
+                    lg2_res[lane] = std::log2(src1[0][lane]);
+                }
+                write_dest([&](int, std::size_t lane) { return lg2_res[lane]; });
+                break;
+            }
+
+            default:
+                LOG_ERROR(HW_GPU, "Unhandled arithmetic instruction: 0x{:02x} ({}): 0x{:08x}",
+                          (int)instr.opcode.Value().EffectiveOpCode(),
+                          instr.opcode.Value().GetInfo().name, instr.hex);
+                DEBUG_ASSERT(false);
+                break;
+            }
+
+            break;
+        }
+
+        case OpCode::Type::MultiplyAdd: {
+            if ((instr.opcode.Value().EffectiveOpCode() == OpCode::Id::MAD) ||
+                (instr.opcode.Value().EffectiveOpCode() == OpCode::Id::MADI)) {
+                const SwizzlePattern& swizzle = *reinterpret_cast<const SwizzlePattern*>(
+                    &swizzle_data[instr.mad.operand_desc_id]);
+
+                bool is_inverted = (instr.opcode.Value().EffectiveOpCode() == OpCode::Id::MADI);
+
+                const auto* offsets =
+                    (instr.mad.address_register_index == 0)
+                        ? nullptr
+                        : state.address_registers[instr.mad.address_register_index - 1].data();
+
+                LaneVec4<N> src1;
+                LaneVec4<N> src2;
+                LaneVec4<N> src3;
+                LoadBatchSource(state, setup, instr.mad.GetSrc1(is_inverted), nullptr,
+                                {(int)swizzle.src1_selector_0.Value(),
+                                 (int)swizzle.src1_selector_1.Value(),
+                                 (int)swizzle.src1_selector_2.Value(),
+                                 (int)swizzle.src1_selector_3.Value()},
+                                swizzle.negate_src1 != 0, src1);
+                LoadBatchSource(state, setup, instr.mad.GetSrc2(is_inverted),
+                                is_inverted ? nullptr : offsets,
+                                {(int)swizzle.src2_selector_0.Value(),
+                                 (int)swizzle.src2_selector_1.Value(),
+                                 (int)swizzle.src2_selector_2.Value(),
+                                 (int)swizzle.src2_selector_3.Value()},
+                                swizzle.negate_src2 != 0, src2);
+                LoadBatchSource(state, setup, instr.mad.GetSrc3(is_inverted),
+                                is_inverted ? offsets : nullptr,
+                                {(int)swizzle.src3_selector_0.Value(),
+                                 (int)swizzle.src3_selector_1.Value(),
+                                 (int)swizzle.src3_selector_2.Value(),
+                                 (int)swizzle.src3_selector_3.Value()},
+                                swizzle.negate_src3 != 0, src3);
+
+                WriteBatchDest(state, instr.mad.dest.Value(), swizzle, write_lanes,
+                               [&](int i, std::size_t lane) {
+                                   return MultiplyPica(src1[i][lane], src2[i][lane]) +
+                                          src3[i][lane];
+                               });
+            } else {
+                LOG_ERROR(HW_GPU, "Unhandled multiply-add instruction: 0x{:02x} ({}): 0x{:08x}",
+                          (int)instr.opcode.Value().EffectiveOpCode(),
+                          instr.opcode.Value().GetInfo().name, instr.hex);
+            }
+            break;
+        }
+
+        default: {
+            // Handle each instruction on its own
+            switch (instr.opcode.Value()) {
+            case OpCode::Id::END:
+                // Lanes still waiting for the other side of a branch won't get to run it anymore
+                rerun |= lanes & ~(active | rerun);
+                return rerun;
+
+            case OpCode::Id::JMPC: {
+                const u32 taken = evaluate_condition(instr.flow_control) & active;
+                if (taken != 0 && taken != active) {
+                    // Jumps can't be followed with masks, so keep the larger group of lanes
+                    const u32 not_taken = active & ~taken;
+                    if (std::popcount(taken) >= std::popcount(not_taken)) {
+                        drop_lanes(not_taken);
+                    } else {
+                        drop_lanes(taken);
+                    }
+                }
+                if (active == taken) {
+                    program_counter = instr.flow_control.dest_offset - 1;
+                }
+                break;
+            }
+
+            case OpCode::Id::JMPU:
+                if (uniforms.b[instr.flow_control.bool_uniform_id] ==
+                    !(instr.flow_control.num_instructions & 1)) {
+                    program_counter = instr.flow_control.dest_offset - 1;
+                }
+                break;
+
+            case OpCode::Id::CALL:
+                call(instr.flow_control.dest_offset, instr.flow_control.num_instructions,
+                     program_counter + 1, 0, 0, active);
+                break;
+
+            case OpCode::Id::CALLU:
+                if (uniforms.b[instr.flow_control.bool_uniform_id]) {
+                    call(instr.flow_control.dest_offset, instr.flow_control.num_instructions,
+                         program_counter + 1, 0, 0, active);
+                }
+                break;
+
+            case OpCode::Id::CALLC: {
+                // Lanes not taking the call wait for the others to return
+                const u32 taken = evaluate_condition(instr.flow_control) & active;
+                if (taken != 0) {
+                    call(instr.flow_control.dest_offset, instr.flow_control.num_instructions,
+                         program_counter + 1, 0, 0, taken);
+                }
+                break;
+            }
+
+            case OpCode::Id::NOP:
+                break;
+
+            case OpCode::Id::IFU:
+                if (uniforms.b[instr.flow_control.bool_uniform_id]) {
+                    call(program_counter + 1, instr.flow_control.dest_offset - program_counter - 1,
+                         instr.flow_control.dest_offset + instr.flow_control.num_instructions, 0,
+                         0, active);
+                } else {
+                    call(instr.flow_control.dest_offset, instr.flow_control.num_instructions,
+                         instr.flow_control.dest_offset + instr.flow_control.num_instructions, 0,
+                         0, active);
+                }
+                break;
+
+            case OpCode::Id::IFC: {
+                const u32 taken = evaluate_condition(instr.flow_control) & active;
+                const u32 not_taken = active & ~taken;
+                if (taken != 0) {
+                    call(program_counter + 1, instr.flow_control.dest_offset - program_counter - 1,
+                         instr.flow_control.dest_offset + instr.flow_control.num_instructions, 0,
+                         0, taken);
+                    // Run the else branch for the remaining lanes once the if branch is done
+                    call_stack.back().else_lanes = not_taken;
+                    call_stack.back().else_final_address =
+                        instr.flow_control.dest_offset + instr.flow_control.num_instructions;
+                } else {
+                    call(instr.flow_control.dest_offset, instr.flow_control.num_instructions,
+                         instr.flow_control.dest_offset + instr.flow_control.num_instructions, 0,
+                         0, active);
+                }
+                break;
+            }
+
+            case OpCode::Id::LOOP: {
+                Common::Vec4<u8> loop_param(uniforms.i[instr.flow_control.int_uniform_id].x,
+                                            uniforms.i[instr.flow_control.int_uniform_id].y,
+                                            uniforms.i[instr.flow_control.int_uniform_id].z,
+                                            uniforms.i[instr.flow_control.int_uniform_id].w);
+                for (std::size_t lane = 0; lane < N; ++lane) {
+                    if (write_lanes & (1u << lane)) {
+                        state.address_registers[2][lane] = loop_param.y;
+                    }
+                }
+
+                call(program_counter + 1, instr.flow_control.dest_offset - program_counter,
+                     instr.flow_control.dest_offset + 1, loop_param.x, loop_param.z, active);
+                break;
+            }
+
+            case OpCode::Id::EMIT:
+            case OpCode::Id::SETEMIT:
+                // Geometry shaders aren't batched, leave reporting this to the scalar interpreter
+                return lanes;
+
+            default:
+                LOG_ERROR(HW_GPU, "Unhandled instruction: 0x{:02x} ({}): 0x{:08x}",
+                          (int)instr.opcode.Value().EffectiveOpCode(),
+                          instr.opcode.Value().GetInfo().name, instr.hex);
+                break;
+            }
+
+            break;
+        }
+        }
+
+        ++program_counter;
+    }
+}
+
+template <std::size_t N>
+static void RunBatchLanes(const ShaderSetup& setup, UnitState* states, std::size_t count) {
+    BatchState<N> batch(states, count);
+    const u32 lanes = (1u << count) - 1;
+    const u32 rerun = RunInterpreterBatch(setup, batch, lanes, setup.engine_data.entry_point);
+
+    for (std::size_t lane = 0; lane < count; ++lane) {
+        if (rerun & (1u << lane)) {
+            DebugData<false> dummy_debug_data;
+            RunInterpreter(setup, states[lane], dummy_debug_data, setup.engine_data.entry_point);
+        } else {
+            batch.Store(states[lane], lane);
+        }
+    }
+}
+
 void InterpreterEngine::SetupBatch(ShaderSetup& setup, unsigned int entry_point) {
     ASSERT(entry_point < MAX_PROGRAM_CODE_LENGTH);
     setup.engine_data.entry_point = entry_point;
@@ -681,6 +1415,22 @@ void InterpreterEngine::Run(const ShaderSetup& setup, UnitState& state) const {
     RunInterpreter(setup, state, dummy_debug_data, setup.engine_data.entry_point);
 }
 
+void InterpreterEngine::RunBatch(const ShaderSetup& setup, UnitState* states,
+                                 std::size_t count) const {
+    ASSERT(count <= MAX_BATCH_SIZE);
+    if (count == 0) {
+        return;
+    }
+
+    MICROPROFILE_SCOPE(GPU_Shader);
+
+    if (count <= 4) {
+        RunBatchLanes<4>(setup, states, count);
+    } else {
+        RunBatchLanes<8>(setup, states, count);
+    }
+}
+
 DebugData<true> InterpreterEngine::ProduceDebugInfo(const ShaderSetup& setup,
                                                     const AttributeBuffer& input,
                                                     const ShaderRegs& config) const {
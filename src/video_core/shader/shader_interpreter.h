@@ -14,6 +14,13 @@ public:
     void SetupBatch(ShaderSetup& setup, unsigned int entry_point) override;
     void Run(const ShaderSetup& setup, UnitState& state) const override;
 
+    /**
+     * Runs the units in SIMD lanes, with each register holding the values of all units. Control
+     * flow that diverges between the units is followed with per-lane masks as long as it stays
+     * structured (IFC, CALLC); units taking a diverging JMPC are finished one at a time instead.
+     */
+    void RunBatch(const ShaderSetup& setup, UnitState* states, std::size_t count) const override;
+
     /**
      * Produce debug information based on the given shader and input vertex
      * @param setup  Shader engine state
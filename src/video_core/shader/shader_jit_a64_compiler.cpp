@@ -0,0 +1,1115 @@
+// Copyright 2022 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cstdint>
+#include <type_traits>
+#include <nihstro/shader_bytecode.h>
+#include "common/aarch64/code_emitter.h"
+#include "common/assert.h"
+#include "common/logging/log.h"
+#include "common/vector_math.h"
+#include "video_core/pica_state.h"
+#include "video_core/pica_types.h"
+#include "video_core/shader/shader.h"
+#include "video_core/shader/shader_jit_a64_compiler.h"
+
+using namespace Common::A64;
+
+namespace Pica::Shader {
+
+typedef void (JitShader::*JitFunction)(Instruction instr);
+
+const JitFunction instr_table[64] = {
+    &JitShader::Compile_ADD,    // add
+    &JitShader::Compile_DP3,    // dp3
+    &JitShader::Compile_DP4,    // dp4
+    &JitShader::Compile_DPH,    // dph
+    nullptr,                    // unknown
+    &JitShader::Compile_EX2,    // ex2
+    &JitShader::Compile_LG2,    // lg2
+    nullptr,                    // unknown
+    &JitShader::Compile_MUL,    // mul
+    &JitShader::Compile_SGE,    // sge
+    &JitShader::Compile_SLT,    // slt
+    &JitShader::Compile_FLR,    // flr
+    &JitShader::Compile_MAX,    // max
+    &JitShader::Compile_MIN,    // min
+    &JitShader::Compile_RCP,    // rcp
+    &JitShader::Compile_RSQ,    // rsq
+    nullptr,                    // unknown
+    nullptr,                    // unknown
+    &JitShader::Compile_MOVA,   // mova
+    &JitShader::Compile_MOV,    // mov
+    nullptr,                    // unknown
+    nullptr,                    // unknown
+    nullptr,                    // unknown
+    nullptr,                    // unknown
+    &JitShader::Compile_DPH,    // dphi
+    nullptr,                    // unknown
+    &JitShader::Compile_SGE,    // sgei
+    &JitShader::Compile_SLT,    // slti
+    nullptr,                    // unknown
+    nullptr,                    // unknown
+    nullptr,                    // unknown
+    nullptr,                    // unknown
+    nullptr,                    // unknown
+    &JitShader::Compile_NOP,    // nop
+    &JitShader::Compile_END,    // end
+    &JitShader::Compile_BREAKC, // breakc
+    &JitShader::Compile_CALL,   // call
+    &JitShader::Compile_CALLC,  // callc
+    &JitShader::Compile_CALLU,  // callu
+    &JitShader::Compile_IF,     // ifu
+    &JitShader::Compile_IF,     // ifc
+    &JitShader::Compile_LOOP,   // loop
+    &JitShader::Compile_EMIT,   // emit
+    &JitShader::Compile_SETE,   // sete
+    &JitShader::Compile_JMP,    // jmpc
+    &JitShader::Compile_JMP,    // jmpu
+    &JitShader::Compile_CMP,    // cmp
+    &JitShader::Compile_CMP,    // cmp
+    &JitShader::Compile_MAD,    // madi
+    &JitShader::Compile_MAD,    // madi
+    &JitShader::Compile_MAD,    // madi
+    &JitShader::Compile_MAD,    // madi
+    &JitShader::Compile_MAD,    // madi
+    &JitShader::Compile_MAD,    // madi
+    &JitShader::Compile_MAD,    // madi
+    &JitShader::Compile_MAD,    // madi
+    &JitShader::Compile_MAD,    // mad
+    &JitShader::Compile_MAD,    // mad
+    &JitShader::Compile_MAD,    // mad
+    &JitShader::Compile_MAD,    // mad
+    &JitShader::Compile_MAD,    // mad
+    &JitShader::Compile_MAD,    // mad
+    &JitShader::Compile_MAD,    // mad
+    &JitShader::Compile_MAD,    // mad
+};
+
+// The following is used to alias some commonly used registers. Generally, X0-X17 and V0-V7 can be
+// used as scratch registers within a compiler function. The other registers have designated
+// purposes, as documented below. All the general purpose state lives in callee-saved registers, so
+// it survives calls into host functions.
+
+/// Pointer to the uniform memory
+constexpr XReg UNIFORMS = X19;
+/// Pointer to the UnitState instance for the current VS unit
+constexpr XReg STATE = X20;
+/// The two 32-bit VS address offset registers set by the MOVA instruction
+constexpr XReg ADDROFFS_REG_0 = X21;
+constexpr XReg ADDROFFS_REG_1 = X22;
+/// VS loop count register (Multiplied by 16)
+constexpr WReg LOOPCOUNT_REG = W23;
+/// Current VS loop iteration number (we could probably use LOOPCOUNT_REG, but this quicker)
+constexpr WReg LOOPCOUNT = W24;
+/// Number to increment LOOPCOUNT_REG by on each loop iteration (Multiplied by 16)
+constexpr WReg LOOPINC = W25;
+/// Result of the previous CMP instruction for the X-component comparison
+constexpr WReg COND0 = W26;
+/// Result of the previous CMP instruction for the Y-component comparison
+constexpr WReg COND1 = W27;
+/// Holds the link register while the EX2 and LG2 utility routines are called
+constexpr XReg SAVED_LR = X28;
+/// General purpose scratch register used for address computations
+constexpr XReg XSCRATCH = X16;
+/// SIMD scratch register
+constexpr QReg VSCRATCH0 = Q0;
+/// Loaded with the first swizzled source register, otherwise can be used as a scratch register
+constexpr QReg SRC1 = Q1;
+/// Loaded with the second swizzled source register, otherwise can be used as a scratch register
+constexpr QReg SRC2 = Q2;
+/// Loaded with the third swizzled source register, otherwise can be used as a scratch register
+constexpr QReg SRC3 = Q3;
+/// Additional scratch registers
+constexpr QReg VSCRATCH1 = Q4;
+constexpr QReg VSCRATCH2 = Q5;
+/// Constant vector of [1.0f, 1.0f, 1.0f, 1.0f], used to efficiently set a vector to one
+constexpr QReg ONE = Q31;
+
+/// Bytes of stack used to save the callee-saved registers in the prologue
+constexpr s32 CALLEE_SAVED_FRAME_SIZE = 96;
+
+/// Raw constant for the source register selector that indicates no swizzling is performed
+static const u8 NO_SRC_REG_SWIZZLE = 0x1b;
+/// Raw constant for the destination register enable mask that indicates all components are enabled
+static const u8 NO_DEST_REG_MASK = 0xf;
+
+static void LogCritical(const char* msg) {
+    LOG_CRITICAL(HW_GPU, "{}", msg);
+}
+
+void JitShader::Compile_PushCallerSavedRegs() {
+    // The link register only matters inside subroutines, but is cheap enough to always save
+    SUB(SP, SP, 32);
+    STR(ONE, SP, 0);
+    STR(X30, SP, 16);
+}
+
+void JitShader::Compile_PopCallerSavedRegs() {
+    LDR(ONE, SP, 0);
+    LDR(X30, SP, 16);
+    ADD(SP, SP, 32);
+}
+
+/// Calls a host function, with its arguments already placed in X0 and X1
+template <typename T>
+static void CallFarFunction(CodeEmitter& code, const T f) {
+    static_assert(std::is_pointer_v<T>, "Argument must be a (function) pointer.");
+    code.MOV(XSCRATCH, reinterpret_cast<u64>(f));
+    code.BLR(XSCRATCH);
+}
+
+void JitShader::Compile_Assert(bool condition, const char* msg) {
+    if (!condition) {
+        Compile_PushCallerSavedRegs();
+        MOV(X0, reinterpret_cast<u64>(msg));
+        CallFarFunction(*this, LogCritical);
+        Compile_PopCallerSavedRegs();
+    }
+}
+
+/**
+ * Loads and swizzles a source register into the specified SIMD register.
+ * @param instr VS instruction, used for determining how to load the source register
+ * @param src_num Number indicating which source register to load (1 = src1, 2 = src2, 3 = src3)
+ * @param src_reg SourceRegister object corresponding to the source register to load
+ * @param dest Destination SIMD register to store the loaded, swizzled source register
+ */
+void JitShader::Compile_SwizzleSrc(Instruction instr, unsigned src_num, SourceRegister src_reg,
+                                   QReg dest) {
+    XReg src_ptr = STATE;
+    std::size_t src_offset;
+
+    if (src_reg.GetRegisterType() == RegisterType::FloatUniform) {
+        src_ptr = UNIFORMS;
+        src_offset = Uniforms::GetFloatUniformOffset(src_reg.GetIndex());
+    } else {
+        src_offset = UnitState::InputOffset(src_reg);
+    }
+
+    unsigned operand_desc_id;
+
+    const bool is_inverted =
+        (0 != (instr.opcode.Value().GetInfo().subtype & OpCode::Info::SrcInversed));
+
+    unsigned address_register_index;
+    unsigned offset_src;
+
+    if (instr.opcode.Value().EffectiveOpCode() == OpCode::Id::MAD ||
+        instr.opcode.Value().EffectiveOpCode() == OpCode::Id::MADI) {
+        operand_desc_id = instr.mad.operand_desc_id;
+        offset_src = is_inverted ? 3 : 2;
+        address_register_index = instr.mad.address_register_index;
+    } else {
+        operand_desc_id = instr.common.operand_desc_id;
+        offset_src = is_inverted ? 2 : 1;
+        address_register_index = instr.common.address_register_index;
+    }
+
+    SwizzlePattern swiz = {(*swizzle_data)[operand_desc_id]};
+
+    // Component i of the result is taken from component selector[i] of the source
+    const u8 sel = swiz.GetRawSelector(src_num);
+    const std::array<u32, 4> selector = {static_cast<u32>((sel >> 6) & 3),
+                                         static_cast<u32>((sel >> 4) & 3),
+                                         static_cast<u32>((sel >> 2) & 3),
+                                         static_cast<u32>(sel & 3)};
+    const bool is_broadcast = std::all_of(selector.begin(), selector.end(),
+                                          [&selector](u32 lane) { return lane == selector[0]; });
+    const bool is_shuffle = sel != NO_SRC_REG_SWIZZLE && !is_broadcast;
+
+    // Shuffles are assembled lane by lane, so they need the loaded value in a separate register
+    const QReg loaded = is_shuffle ? VSCRATCH0 : dest;
+
+    if (src_num == offset_src && address_register_index != 0) {
+        switch (address_register_index) {
+        case 1: // address offset 1
+            ADD(XSCRATCH, src_ptr, ADDROFFS_REG_0);
+            break;
+        case 2: // address offset 2
+            ADD(XSCRATCH, src_ptr, ADDROFFS_REG_1);
+            break;
+        case 3: // address offset 3
+            ADD(XSCRATCH, src_ptr, LOOPCOUNT_REG.toX());
+            break;
+        default:
+            UNREACHABLE();
+            break;
+        }
+        LDR(loaded, XSCRATCH, static_cast<u32>(src_offset));
+    } else {
+        // Load the source
+        LDR(loaded, src_ptr, static_cast<u32>(src_offset));
+    }
+
+    // Generate instructions for source register swizzling as needed
+    if (is_broadcast && sel != NO_SRC_REG_SWIZZLE) {
+        DUP(dest, loaded, selector[0]);
+    } else if (is_shuffle) {
+        for (u32 lane = 0; lane < 4; ++lane) {
+            INS(dest, lane, loaded, selector[lane]);
+        }
+    }
+
+    // If the source register should be negated, flip the sign bits
+    const bool negate[] = {swiz.negate_src1, swiz.negate_src2, swiz.negate_src3};
+    if (negate[src_num - 1]) {
+        FNEG(dest, dest);
+    }
+}
+
+void JitShader::Compile_DestEnable(Instruction instr, QReg src) {
+    DestRegister dest;
+    unsigned operand_desc_id;
+    if (instr.opcode.Value().EffectiveOpCode() == OpCode::Id::MAD ||
+        instr.opcode.Value().EffectiveOpCode() == OpCode::Id::MADI) {
+        operand_desc_id = instr.mad.operand_desc_id;
+        dest = instr.mad.dest.Value();
+    } else {
+        operand_desc_id = instr.common.operand_desc_id;
+        dest = instr.common.dest.Value();
+    }
+
+    SwizzlePattern swiz = {(*swizzle_data)[operand_desc_id]};
+
+    const u32 dest_offset_disp = static_cast<u32>(UnitState::OutputOffset(dest));
+
+    // If all components are enabled, write the result to the destination register
+    if (swiz.dest_mask == NO_DEST_REG_MASK) {
+        // Store dest back to memory
+        STR(src, STATE, dest_offset_disp);
+
+    } else {
+        // Not all components are enabled, so merge the enabled ones into the destination
+        // register...
+        LDR(VSCRATCH0, STATE, dest_offset_disp);
+        for (u32 lane = 0; lane < 4; ++lane) {
+            if (swiz.DestComponentEnabled(lane)) {
+                INS(VSCRATCH0, lane, src, lane);
+            }
+        }
+
+        // Store dest back to memory
+        STR(VSCRATCH0, STATE, dest_offset_disp);
+    }
+}
+
+void JitShader::Compile_SanitizedMul(QReg src1, QReg src2, QReg scratch) {
+    // 0 * inf and inf * 0 in the PICA should return 0 instead of NaN. This can be implemented by
+    // checking for NaNs before and after the multiplication.  If the multiplication result is NaN
+    // where neither source was, this NaN was generated by a 0 * inf multiplication, and so the
+    // result should be transformed to 0 to match PICA fp rules.
+
+    // Set scratch to mask of (src1 != NaN and src2 != NaN)
+    FCMEQ(scratch, src1, src1);
+    FMUL(src1, src1, src2);
+    FCMEQ(src2, src2, src2);
+    AND(scratch, scratch, src2);
+
+    // Set src2 to mask of (result != NaN)
+    FCMEQ(src2, src1, src1);
+
+    // Clear components where the result is NaN but neither source was
+    BIC(scratch, scratch, src2);
+    BIC(src1, src1, scratch);
+}
+
+void JitShader::Compile_EvaluateCondition(Instruction instr) {
+    // A condition code passes if it equals the reference value
+    const auto test = [this](WReg result, WReg cond, bool ref) {
+        if (ref) {
+            MOV(result, cond);
+        } else {
+            EOR(result, cond, 1);
+        }
+    };
+
+    switch (instr.flow_control.op) {
+    case Instruction::FlowControlType::Or:
+        test(W0, COND0, instr.flow_control.refx.Value());
+        test(W1, COND1, instr.flow_control.refy.Value());
+        ORR(W0, W0, W1);
+        break;
+
+    case Instruction::FlowControlType::And:
+        test(W0, COND0, instr.flow_control.refx.Value());
+        test(W1, COND1, instr.flow_control.refy.Value());
+        AND(W0, W0, W1);
+        break;
+
+    case Instruction::FlowControlType::JustX:
+        test(W0, COND0, instr.flow_control.refx.Value());
+        break;
+
+    case Instruction::FlowControlType::JustY:
+        test(W0, COND1, instr.flow_control.refy.Value());
+        break;
+    }
+}
+
+void JitShader::Compile_UniformCondition(Instruction instr) {
+    std::size_t offset = Uniforms::GetBoolUniformOffset(instr.flow_control.bool_uniform_id);
+    LDRB(W0, UNIFORMS, static_cast<u32>(offset));
+}
+
+void JitShader::Compile_ADD(Instruction instr) {
+    Compile_SwizzleSrc(instr, 1, instr.common.src1, SRC1);
+    Compile_SwizzleSrc(instr, 2, instr.common.src2, SRC2);
+    FADD(SRC1, SRC1, SRC2);
+    Compile_DestEnable(instr, SRC1);
+}
+
+void JitShader::Compile_DP3(Instruction instr) {
+    Compile_SwizzleSrc(instr, 1, instr.common.src1, SRC1);
+    Compile_SwizzleSrc(instr, 2, instr.common.src2, SRC2);
+
+    Compile_SanitizedMul(SRC1, SRC2, VSCRATCH0);
+
+    DUP(SRC2, SRC1, 1);
+    DUP(SRC3, SRC1, 2);
+    DUP(SRC1, SRC1, 0);
+    FADD(SRC1, SRC1, SRC2);
+    FADD(SRC1, SRC1, SRC3);
+
+    Compile_DestEnable(instr, SRC1);
+}
+
+void JitShader::Compile_DP4(Instruction instr) {
+    Compile_SwizzleSrc(instr, 1, instr.common.src1, SRC1);
+    Compile_SwizzleSrc(instr, 2, instr.common.src2, SRC2);
+
+    Compile_SanitizedMul(SRC1, SRC2, VSCRATCH0);
+
+    FADDP(SRC1, SRC1, SRC1); // XYZW -> (X+Y)(Z+W)(X+Y)(Z+W)
+    FADDP(SRC1, SRC1, SRC1); // Sum of all components in every lane
+
+    Compile_DestEnable(instr, SRC1);
+}
+
+void JitShader::Compile_DPH(Instruction instr) {
+    if (instr.opcode.Value().EffectiveOpCode() == OpCode::Id::DPHI) {
+        Compile_SwizzleSrc(instr, 1, instr.common.src1i, SRC1);
+        Compile_SwizzleSrc(instr, 2, instr.common.src2i, SRC2);
+    } else {
+        Compile_SwizzleSrc(instr, 1, instr.common.src1, SRC1);
+        Compile_SwizzleSrc(instr, 2, instr.common.src2, SRC2);
+    }
+
+    // Set 4th component to 1.0
+    INS(SRC1, 3, ONE, 0);
+
+    Compile_SanitizedMul(SRC1, SRC2, VSCRATCH0);
+
+    FADDP(SRC1, SRC1, SRC1);
+    FADDP(SRC1, SRC1, SRC1);
+
+    Compile_DestEnable(instr, SRC1);
+}
+
+void JitShader::Compile_EX2(Instruction instr) {
+    Compile_SwizzleSrc(instr, 1, instr.common.src1, SRC1);
+    MOV(SAVED_LR, X30);
+    BL(exp2_subroutine);
+    MOV(X30, SAVED_LR);
+    Compile_DestEnable(instr, SRC1);
+}
+
+void JitShader::Compile_LG2(Instruction instr) {
+    Compile_SwizzleSrc(instr, 1, instr.common.src1, SRC1);
+    MOV(SAVED_LR, X30);
+    BL(log2_subroutine);
+    MOV(X30, SAVED_LR);
+    Compile_DestEnable(instr, SRC1);
+}
+
+void JitShader::Compile_MUL(Instruction instr) {
+    Compile_SwizzleSrc(instr, 1, instr.common.src1, SRC1);
+    Compile_SwizzleSrc(instr, 2, instr.common.src2, SRC2);
+    Compile_SanitizedMul(SRC1, SRC2, VSCRATCH0);
+    Compile_DestEnable(instr, SRC1);
+}
+
+void JitShader::Compile_SGE(Instruction instr) {
+    if (instr.opcode.Value().EffectiveOpCode() == OpCode::Id::SGEI) {
+        Compile_SwizzleSrc(instr, 1, instr.common.src1i, SRC1);
+        Compile_SwizzleSrc(instr, 2, instr.common.src2i, SRC2);
+    } else {
+        Compile_SwizzleSrc(instr, 1, instr.common.src1, SRC1);
+        Compile_SwizzleSrc(instr, 2, instr.common.src2, SRC2);
+    }
+
+    FCMGE(SRC2, SRC1, SRC2);
+    AND(SRC2, SRC2, ONE);
+
+    Compile_DestEnable(instr, SRC2);
+}
+
+void JitShader::Compile_SLT(Instruction instr) {
+    if (instr.opcode.Value().EffectiveOpCode() == OpCode::Id::SLTI) {
+        Compile_SwizzleSrc(instr, 1, instr.common.src1i, SRC1);
+        Compile_SwizzleSrc(instr, 2, instr.common.src2i, SRC2);
+    } else {
+        Compile_SwizzleSrc(instr, 1, instr.common.src1, SRC1);
+        Compile_SwizzleSrc(instr, 2, instr.common.src2, SRC2);
+    }
+
+    FCMGT(SRC1, SRC2, SRC1);
+    AND(SRC1, SRC1, ONE);
+
+    Compile_DestEnable(instr, SRC1);
+}
+
+void JitShader::Compile_FLR(Instruction instr) {
+    Compile_SwizzleSrc(instr, 1, instr.common.src1, SRC1);
+    FRINTM(SRC1, SRC1);
+    Compile_DestEnable(instr, SRC1);
+}
+
+void JitShader::Compile_MAX(Instruction instr) {
+    Compile_SwizzleSrc(instr, 1, instr.common.src1, SRC1);
+    Compile_SwizzleSrc(instr, 2, instr.common.src2, SRC2);
+    // NEON FMAX propagates NaNs, while PICA200 returns SRC2 unless SRC1 is greater. Select
+    // explicitly to match.
+    FCMGT(VSCRATCH0, SRC1, SRC2);
+    BIT(SRC2, SRC1, VSCRATCH0);
+    Compile_DestEnable(instr, SRC2);
+}
+
+void JitShader::Compile_MIN(Instruction instr) {
+    Compile_SwizzleSrc(instr, 1, instr.common.src1, SRC1);
+    Compile_SwizzleSrc(instr, 2, instr.common.src2, SRC2);
+    // NEON FMIN propagates NaNs, while PICA200 returns SRC2 unless SRC1 is less. Select
+    // explicitly to match.
+    FCMGT(VSCRATCH0, SRC2, SRC1);
+    BIT(SRC2, SRC1, VSCRATCH0);
+    Compile_DestEnable(instr, SRC2);
+}
+
+void JitShader::Compile_MOVA(Instruction instr) {
+    SwizzlePattern swiz = {(*swizzle_data)[instr.common.operand_desc_id]};
+
+    if (!swiz.DestComponentEnabled(0) && !swiz.DestComponentEnabled(1)) {
+        return; // NoOp
+    }
+
+    Compile_SwizzleSrc(instr, 1, instr.common.src1, SRC1);
+
+    // Convert floats to integers using truncation (only care about X and Y components)
+    FCVTZS(SRC1, SRC1);
+
+    // Handle destination enable
+    if (swiz.DestComponentEnabled(0)) {
+        // Move and sign-extend the X component
+        SMOV(ADDROFFS_REG_0, SRC1, 0);
+
+        // Multiply by 16 to be used as an offset later
+        LSL(ADDROFFS_REG_0, ADDROFFS_REG_0, 4);
+    }
+    if (swiz.DestComponentEnabled(1)) {
+        // Move and sign-extend the Y component
+        SMOV(ADDROFFS_REG_1, SRC1, 1);
+
+        // Multiply by 16 to be used as an offset later
+        LSL(ADDROFFS_REG_1, ADDROFFS_REG_1, 4);
+    }
+}
+
+void JitShader::Compile_MOV(Instruction instr) {
+    Compile_SwizzleSrc(instr, 1, instr.common.src1, SRC1);
+    Compile_DestEnable(instr, SRC1);
+}
+
+void JitShader::Compile_RCP(Instruction instr) {
+    Compile_SwizzleSrc(instr, 1, instr.common.src1, SRC1);
+
+    // FRECPE only provides 8 bits of precision, so divide to get the same result as the
+    // interpreter instead.
+    FDIV(SRC1.toS(), ONE.toS(), SRC1.toS());
+    DUP(SRC1, SRC1, 0); // XYWZ -> XXXX
+
+    Compile_DestEnable(instr, SRC1);
+}
+
+void JitShader::Compile_RSQ(Instruction instr) {
+    Compile_SwizzleSrc(instr, 1, instr.common.src1, SRC1);
+
+    // FRSQRTE only provides 8 bits of precision, so compute the exact value like the interpreter.
+    FSQRT(SRC1.toS(), SRC1.toS());
+    FDIV(SRC1.toS(), ONE.toS(), SRC1.toS());
+    DUP(SRC1, SRC1, 0); // XYWZ -> XXXX
+
+    Compile_DestEnable(instr, SRC1);
+}
+
+void JitShader::Compile_NOP(Instruction instr) {}
+
+void JitShader::Compile_END(Instruction instr) {
+    // Save conditional code
+    STRB(COND0, STATE, offsetof(UnitState, conditional_code[0]));
+    STRB(COND1, STATE, offsetof(UnitState, conditional_code[1]));
+
+    // Save address/loop registers
+    ASR(ADDROFFS_REG_0, ADDROFFS_REG_0, 4);
+    ASR(ADDROFFS_REG_1, ADDROFFS_REG_1, 4);
+    ASR(LOOPCOUNT_REG, LOOPCOUNT_REG, 4);
+    STR(ADDROFFS_REG_0.toW(), STATE, offsetof(UnitState, address_registers[0]));
+    STR(ADDROFFS_REG_1.toW(), STATE, offsetof(UnitState, address_registers[1]));
+    STR(LOOPCOUNT_REG, STATE, offsetof(UnitState, address_registers[2]));
+
+    // Unwind whatever is left on the stack (e.g. when ending inside a subroutine) through the
+    // frame pointer set up in the prologue
+    ADD(SP, X29, 0);
+    LDP(X19, X20, SP, 16);
+    LDP(X21, X22, SP, 32);
+    LDP(X23, X24, SP, 48);
+    LDP(X25, X26, SP, 64);
+    LDP(X27, X28, SP, 80);
+    LDP(X29, X30, SP, CALLEE_SAVED_FRAME_SIZE, IndexMode::PostIndex);
+    RET();
+}
+
+void JitShader::Compile_BREAKC(Instruction instr) {
+    Compile_Assert(loop_depth, "BREAKC must be inside a LOOP");
+    if (loop_depth) {
+        Compile_EvaluateCondition(instr);
+        ASSERT(!loop_break_labels.empty());
+        CBNZ(W0, loop_break_labels.back());
+    }
+}
+
+void JitShader::Compile_CALL(Instruction instr) {
+    // Push offset of the return and the link register
+    MOV(W0, instr.flow_control.dest_offset + instr.flow_control.num_instructions);
+    STP(X0, X30, SP, -16, IndexMode::PreIndex);
+
+    // Call the subroutine
+    BL(instruction_labels[instr.flow_control.dest_offset]);
+
+    // Skip over the return offset that's on the stack
+    LDP(X0, X30, SP, 16, IndexMode::PostIndex);
+}
+
+void JitShader::Compile_CALLC(Instruction instr) {
+    Compile_EvaluateCondition(instr);
+    Label b;
+    CBZ(W0, b);
+    Compile_CALL(instr);
+    L(b);
+}
+
+void JitShader::Compile_CALLU(Instruction instr) {
+    Compile_UniformCondition(instr);
+    Label b;
+    CBZ(W0, b);
+    Compile_CALL(instr);
+    L(b);
+}
+
+void JitShader::Compile_CMP(Instruction instr) {
+    using Op = Instruction::Common::CompareOpType::Op;
+    Op op_x = instr.common.compare_op.x;
+    Op op_y = instr.common.compare_op.y;
+
+    Compile_SwizzleSrc(instr, 1, instr.common.src1, SRC1);
+    Compile_SwizzleSrc(instr, 2, instr.common.src2, SRC2);
+
+    // NEON only has EQ, GE and GT comparisons, the others are emulated by swapping the operands or
+    // inverting the result. Unknown comparisons leave the condition code untouched, like in the
+    // interpreter.
+    const auto compare = [this](QReg dest, Op op) {
+        switch (op) {
+        case Op::Equal:
+            FCMEQ(dest, SRC1, SRC2);
+            return true;
+        case Op::NotEqual:
+            FCMEQ(dest, SRC1, SRC2);
+            NOT(dest, dest);
+            return true;
+        case Op::LessThan:
+            FCMGT(dest, SRC2, SRC1);
+            return true;
+        case Op::LessEqual:
+            FCMGE(dest, SRC2, SRC1);
+            return true;
+        case Op::GreaterThan:
+            FCMGT(dest, SRC1, SRC2);
+            return true;
+        case Op::GreaterEqual:
+            FCMGE(dest, SRC1, SRC2);
+            return true;
+        default:
+            LOG_ERROR(HW_GPU, "Unknown compare mode {:x}", static_cast<int>(op));
+            return false;
+        }
+    };
+
+    if (op_x == op_y) {
+        // Compare X-component and Y-component together
+        if (compare(VSCRATCH0, op_x)) {
+            UMOV(COND0, VSCRATCH0, 0);
+            UMOV(COND1, VSCRATCH0, 1);
+            LSR(COND0, COND0, 31);
+            LSR(COND1, COND1, 31);
+        }
+    } else {
+        if (compare(VSCRATCH0, op_x)) {
+            UMOV(COND0, VSCRATCH0, 0);
+            LSR(COND0, COND0, 31);
+        }
+        if (compare(VSCRATCH1, op_y)) {
+            UMOV(COND1, VSCRATCH1, 1);
+            LSR(COND1, COND1, 31);
+        }
+    }
+}
+
+void JitShader::Compile_MAD(Instruction instr) {
+    Compile_SwizzleSrc(instr, 1, instr.mad.src1, SRC1);
+
+    if (instr.opcode.Value().EffectiveOpCode() == OpCode::Id::MADI) {
+        Compile_SwizzleSrc(instr, 2, instr.mad.src2i, SRC2);
+        Compile_SwizzleSrc(instr, 3, instr.mad.src3i, SRC3);
+    } else {
+        Compile_SwizzleSrc(instr, 2, instr.mad.src2, SRC2);
+        Compile_SwizzleSrc(instr, 3, instr.mad.src3, SRC3);
+    }
+
+    Compile_SanitizedMul(SRC1, SRC2, VSCRATCH0);
+    FADD(SRC1, SRC1, SRC3);
+
+    Compile_DestEnable(instr, SRC1);
+}
+
+void JitShader::Compile_IF(Instruction instr) {
+    Compile_Assert(instr.flow_control.dest_offset >= program_counter,
+                   "Backwards if-statements not supported");
+    Label l_else, l_endif;
+
+    // Evaluate the "IF" condition
+    if (instr.opcode.Value() == OpCode::Id::IFU) {
+        Compile_UniformCondition(instr);
+    } else if (instr.opcode.Value() == OpCode::Id::IFC) {
+        Compile_EvaluateCondition(instr);
+    }
+    CBZ(W0, l_else);
+
+    // Compile the code that corresponds to the condition evaluating as true
+    Compile_Block(instr.flow_control.dest_offset);
+
+    // If there isn't an "ELSE" condition, we are done here
+    if (instr.flow_control.num_instructions == 0) {
+        L(l_else);
+        return;
+    }
+
+    B(l_endif);
+
+    L(l_else);
+    // This code corresponds to the "ELSE" condition
+    // Comple the code that corresponds to the condition evaluating as false
+    Compile_Block(instr.flow_control.dest_offset + instr.flow_control.num_instructions);
+
+    L(l_endif);
+}
+
+void JitShader::Compile_LOOP(Instruction instr) {
+    Compile_Assert(instr.flow_control.dest_offset >= program_counter,
+                   "Backwards loops not supported");
+    Compile_Assert(loop_depth < 1, "Nested loops may not be supported");
+    if (loop_depth++) {
+        STP(LOOPCOUNT_REG.toX(), LOOPCOUNT.toX(), SP, -16, IndexMode::PreIndex);
+        STP(LOOPINC.toX(), XZR, SP, -16, IndexMode::PreIndex);
+    }
+
+    // This decodes the fields from the integer uniform at index instr.flow_control.int_uniform_id.
+    // The Y (LOOPCOUNT_REG) and Z (LOOPINC) component are kept multiplied by 16 (Left shifted by
+    // 4 bits) to be used as an offset into the 16-byte vector registers later
+    std::size_t offset = Uniforms::GetIntUniformOffset(instr.flow_control.int_uniform_id);
+    LDR(LOOPCOUNT, UNIFORMS, static_cast<u32>(offset));
+    UBFX(LOOPCOUNT_REG, LOOPCOUNT, 8, 8); // Y-component is the start
+    LSL(LOOPCOUNT_REG, LOOPCOUNT_REG, 4);
+    UBFX(LOOPINC, LOOPCOUNT, 16, 8); // Z-component is the incrementer
+    LSL(LOOPINC, LOOPINC, 4);
+    UBFX(LOOPCOUNT, LOOPCOUNT, 0, 8);  // X-component is iteration count
+    ADD(LOOPCOUNT, LOOPCOUNT, 1);      // Iteration count is X-component + 1
+
+    Label l_loop_start;
+    L(l_loop_start);
+
+    loop_break_labels.emplace_back();
+    Compile_Block(instr.flow_control.dest_offset + 1);
+
+    ADD(LOOPCOUNT_REG, LOOPCOUNT_REG, LOOPINC); // Increment LOOPCOUNT_REG by Z-component
+    SUBS(LOOPCOUNT, LOOPCOUNT, 1);              // Increment loop count by 1
+    B(Cond::NE, l_loop_start);                  // Loop if not equal
+
+    L(loop_break_labels.back());
+    loop_break_labels.pop_back();
+
+    if (--loop_depth) {
+        LDP(LOOPINC.toX(), XZR, SP, 16, IndexMode::PostIndex);
+        LDP(LOOPCOUNT_REG.toX(), LOOPCOUNT.toX(), SP, 16, IndexMode::PostIndex);
+    }
+}
+
+void JitShader::Compile_JMP(Instruction instr) {
+    if (instr.opcode.Value() == OpCode::Id::JMPC)
+        Compile_EvaluateCondition(instr);
+    else if (instr.opcode.Value() == OpCode::Id::JMPU)
+        Compile_UniformCondition(instr);
+    else
+        UNREACHABLE();
+
+    bool inverted_condition =
+        (instr.opcode.Value() == OpCode::Id::JMPU) && (instr.flow_control.num_instructions & 1);
+
+    Label& b = instruction_labels[instr.flow_control.dest_offset];
+    if (inverted_condition) {
+        CBZ(W0, b);
+    } else {
+        CBNZ(W0, b);
+    }
+}
+
+static void Emit(GSEmitter* emitter, Common::Vec4<float24> (*output)[16]) {
+    emitter->Emit(*output);
+}
+
+void JitShader::Compile_EMIT(Instruction instr) {
+    Label have_emitter, end;
+    LDR(X0, STATE, offsetof(UnitState, emitter_ptr));
+    CBNZ(X0, have_emitter);
+
+    Compile_PushCallerSavedRegs();
+    MOV(X0, reinterpret_cast<u64>("Execute EMIT on VS"));
+    CallFarFunction(*this, LogCritical);
+    Compile_PopCallerSavedRegs();
+    B(end);
+
+    L(have_emitter);
+    Compile_PushCallerSavedRegs();
+    ADD(X1, STATE, static_cast<u32>(offsetof(UnitState, registers.output)));
+    CallFarFunction(*this, Emit);
+    Compile_PopCallerSavedRegs();
+    L(end);
+}
+
+void JitShader::Compile_SETE(Instruction instr) {
+    Label have_emitter, end;
+    LDR(X0, STATE, offsetof(UnitState, emitter_ptr));
+    CBNZ(X0, have_emitter);
+
+    Compile_PushCallerSavedRegs();
+    MOV(X0, reinterpret_cast<u64>("Execute SETEMIT on VS"));
+    CallFarFunction(*this, LogCritical);
+    Compile_PopCallerSavedRegs();
+    B(end);
+
+    L(have_emitter);
+    MOV(W1, static_cast<u32>(instr.setemit.vertex_id));
+    STRB(W1, X0, offsetof(GSEmitter, vertex_id));
+    MOV(W1, static_cast<u32>(instr.setemit.prim_emit));
+    STRB(W1, X0, offsetof(GSEmitter, prim_emit));
+    MOV(W1, static_cast<u32>(instr.setemit.winding));
+    STRB(W1, X0, offsetof(GSEmitter, winding));
+    L(end);
+}
+
+void JitShader::Compile_Block(unsigned end) {
+    while (program_counter < end) {
+        Compile_NextInstr();
+    }
+}
+
+void JitShader::Compile_Return() {
+    // Peek return offset on the stack and check if we're at that offset
+    LDR(X0, SP, 0);
+    CMP(X0, program_counter);
+
+    // If so, jump back to before CALL
+    Label b;
+    B(Cond::NE, b);
+    RET();
+    L(b);
+}
+
+void JitShader::Compile_NextInstr() {
+    if (std::binary_search(return_offsets.begin(), return_offsets.end(), program_counter)) {
+        Compile_Return();
+    }
+
+    L(instruction_labels[program_counter]);
+
+    Instruction instr = {(*program_code)[program_counter++]};
+
+    OpCode::Id opcode = instr.opcode.Value();
+    auto instr_func = instr_table[static_cast<unsigned>(opcode)];
+
+    if (instr_func) {
+        // JIT the instruction!
+        ((*this).*instr_func)(instr);
+    } else {
+        // Unhandled instruction
+        LOG_CRITICAL(HW_GPU, "Unhandled instruction: 0x{:02x} (0x{:08x})",
+                     static_cast<u32>(instr.opcode.Value().EffectiveOpCode()), instr.hex);
+    }
+}
+
+void JitShader::FindReturnOffsets() {
+    return_offsets.clear();
+
+    for (std::size_t offset = 0; offset < program_code->size(); ++offset) {
+        Instruction instr = {(*program_code)[offset]};
+
+        switch (instr.opcode.Value()) {
+        case OpCode::Id::CALL:
+        case OpCode::Id::CALLC:
+        case OpCode::Id::CALLU:
+            return_offsets.push_back(instr.flow_control.dest_offset +
+                                     instr.flow_control.num_instructions);
+            break;
+        default:
+            break;
+        }
+    }
+
+    // Sort for efficient binary search later
+    std::sort(return_offsets.begin(), return_offsets.end());
+}
+
+void JitShader::Compile(const std::array<u32, MAX_PROGRAM_CODE_LENGTH>* program_code_,
+                        const std::array<u32, MAX_SWIZZLE_DATA_LENGTH>* swizzle_data_) {
+    program_code = program_code_;
+    swizzle_data = swizzle_data_;
+
+    Unprotect();
+
+    // Reset flow control state
+    program = reinterpret_cast<CompiledShader*>(const_cast<u32*>(GetCurrent()));
+    program_counter = 0;
+    loop_depth = 0;
+    instruction_labels.fill(Label());
+
+    // Find all `CALL` instructions and identify return locations
+    FindReturnOffsets();
+
+    // Save the callee-saved registers and set up a frame pointer, which END uses to unwind
+    STP(X29, X30, SP, -CALLEE_SAVED_FRAME_SIZE, IndexMode::PreIndex);
+    STP(X19, X20, SP, 16);
+    STP(X21, X22, SP, 32);
+    STP(X23, X24, SP, 48);
+    STP(X25, X26, SP, 64);
+    STP(X27, X28, SP, 80);
+    ADD(X29, SP, 0);
+
+    // Push a dummy return offset, to catch any potential return checks (see Compile_Return) that
+    // happen in shader main routine.
+    MOV(XSCRATCH, ~u64{0});
+    STP(XSCRATCH, XSCRATCH, SP, -16, IndexMode::PreIndex);
+
+    MOV(UNIFORMS, X0);
+    MOV(STATE, X1);
+
+    // Load address/loop registers
+    LDR(ADDROFFS_REG_0.toW(), STATE, offsetof(UnitState, address_registers[0]));
+    LDR(ADDROFFS_REG_1.toW(), STATE, offsetof(UnitState, address_registers[1]));
+    LDR(LOOPCOUNT_REG, STATE, offsetof(UnitState, address_registers[2]));
+    SBFM(ADDROFFS_REG_0, ADDROFFS_REG_0, 0, 31); // Sign-extend
+    SBFM(ADDROFFS_REG_1, ADDROFFS_REG_1, 0, 31);
+    LSL(ADDROFFS_REG_0, ADDROFFS_REG_0, 4);
+    LSL(ADDROFFS_REG_1, ADDROFFS_REG_1, 4);
+    LSL(LOOPCOUNT_REG, LOOPCOUNT_REG, 4);
+
+    // Load conditional code
+    LDRB(COND0, STATE, offsetof(UnitState, conditional_code[0]));
+    LDRB(COND1, STATE, offsetof(UnitState, conditional_code[1]));
+
+    // Used to set a register to one
+    FMOV(ONE, 1.0f);
+
+    // Jump to start of the shader program
+    BR(X2);
+
+    // Compile entire program
+    Compile_Block(static_cast<unsigned>(program_code->size()));
+
+    // Free memory that's no longer needed
+    program_code = nullptr;
+    swizzle_data = nullptr;
+    return_offsets.clear();
+    return_offsets.shrink_to_fit();
+
+    Invalidate(GetCode(), GetSize());
+    Protect();
+
+    LOG_DEBUG(HW_GPU, "Compiled shader size={}", GetSize());
+}
+
+JitShader::JitShader()
+    : CodeBlock(MAX_SHADER_SIZE), CodeEmitter(CodeBlock::ptr(), CodeBlock::size()) {
+    CompilePrelude();
+}
+
+void JitShader::CompilePrelude() {
+    log2_subroutine = CompilePrelude_Log2();
+    exp2_subroutine = CompilePrelude_Exp2();
+}
+
+Label JitShader::CompilePrelude_Log2() {
+    Label subroutine;
+
+    // NEON does not have a log instruction, thus we must approximate.
+    // We perform this approximation first performaing a range reduction into the range [1.0, 2.0).
+    // A minimax polynomial which was fit for the function log2(x) / (x - 1) is then evaluated.
+    // We multiply the result by (x - 1) then restore the result into the appropriate range.
+    // The polynomial and the order of operations are the same as in the x64 JIT.
+
+    // Coefficients for the minimax polynomial.
+    // f(x) computes approximately log2(x) / (x - 1).
+    // f(x) = c4 + x * (c3 + x * (c2 + x * (c1 + x * c0)).
+    constexpr u32 c0 = 0x3d74552f;
+    constexpr u32 c1 = 0xbeee7397;
+    constexpr u32 c2 = 0x3fbd96dd;
+    constexpr u32 c3 = 0xc02153f6;
+    constexpr u32 c4 = 0x4038d96c;
+
+    constexpr u32 negative_infinity = 0xff800000;
+    constexpr u32 default_qnan = 0x7fc00000;
+
+    const auto load_constant = [this](SReg dest, u32 value) {
+        MOV(W2, value);
+        FMOV(dest, W2);
+    };
+    const auto add_constant = [&](SReg dest, u32 value) {
+        load_constant(VSCRATCH2.toS(), value);
+        FADD(dest, dest, VSCRATCH2.toS());
+    };
+
+    Label input_is_nan, input_is_zero, input_out_of_range;
+
+    L(input_out_of_range);
+    B(Cond::EQ, input_is_zero);
+    load_constant(SRC1.toS(), default_qnan);
+    B(input_is_nan);
+    L(input_is_zero);
+    load_constant(SRC1.toS(), negative_infinity);
+    B(input_is_nan);
+
+    L(subroutine);
+
+    // Here we handle edge cases: input in {NaN, 0, -Inf, Negative}.
+    FCMP(SRC1.toS());
+    B(Cond::VS, input_is_nan);
+    B(Cond::LE, input_out_of_range);
+
+    // Split input
+    FMOV(W0, SRC1.toS());
+    LSR(W1, W0, 23);
+    SUB(W1, W1, 0x7f);
+    AND(W0, W0, 0x007fffff);
+    ORR(W0, W0, 0x3f800000);
+    FMOV(SRC1.toS(), W0);
+    // SRC1 now contains the mantissa of the input.
+    SCVTF(VSCRATCH1.toS(), W1);
+    // VSCRATCH1 now contains the exponent of the input.
+
+    // Complete computation of polynomial
+    load_constant(VSCRATCH0.toS(), c0);
+    FMUL(VSCRATCH0.toS(), VSCRATCH0.toS(), SRC1.toS());
+    add_constant(VSCRATCH0.toS(), c1);
+    FMUL(VSCRATCH0.toS(), VSCRATCH0.toS(), SRC1.toS());
+    add_constant(VSCRATCH0.toS(), c2);
+    FMUL(VSCRATCH0.toS(), VSCRATCH0.toS(), SRC1.toS());
+    add_constant(VSCRATCH0.toS(), c3);
+    FMUL(VSCRATCH0.toS(), VSCRATCH0.toS(), SRC1.toS());
+    FSUB(SRC1.toS(), SRC1.toS(), ONE.toS());
+    add_constant(VSCRATCH0.toS(), c4);
+    FMUL(VSCRATCH0.toS(), VSCRATCH0.toS(), SRC1.toS());
+    FADD(SRC1.toS(), VSCRATCH1.toS(), VSCRATCH0.toS());
+
+    // Duplicate result across vector
+    L(input_is_nan);
+    DUP(SRC1, SRC1, 0);
+
+    RET();
+
+    return subroutine;
+}
+
+Label JitShader::CompilePrelude_Exp2() {
+    Label subroutine;
+
+    // NEON does not have a exp instruction, thus we must approximate.
+    // We perform this approximation first performaing a range reduction into the range [-0.5, 0.5).
+    // A minimax polynomial which was fit for the function exp2(x) is then evaluated.
+    // We then restore the result into the appropriate range.
+    // The polynomial and the order of operations are the same as in the x64 JIT.
+
+    constexpr u32 input_max = 0x43010000;
+    constexpr u32 input_min = 0xc2fdffff;
+    constexpr u32 c0 = 0x3c5dbe69;
+    constexpr u32 half = 0x3f000000;
+    constexpr u32 c1 = 0x3d5509f9;
+    constexpr u32 c2 = 0x3e773cc5;
+    constexpr u32 c3 = 0x3f3168b3;
+    constexpr u32 c4 = 0x3f800016;
+
+    const auto load_constant = [this](SReg dest, u32 value) {
+        MOV(W2, value);
+        FMOV(dest, W2);
+    };
+    const auto add_constant = [&](SReg dest, u32 value) {
+        load_constant(VSCRATCH2.toS(), value);
+        FADD(dest, dest, VSCRATCH2.toS());
+    };
+
+    Label ret_label;
+
+    L(subroutine);
+
+    // Handle edge cases
+    FCMP(SRC1.toS(), SRC1.toS());
+    B(Cond::VS, ret_label);
+    // Clamp to maximum range since we shift the value directly into the exponent.
+    load_constant(VSCRATCH0.toS(), input_max);
+    FMIN(SRC1.toS(), SRC1.toS(), VSCRATCH0.toS());
+    load_constant(VSCRATCH0.toS(), input_min);
+    FMAX(SRC1.toS(), SRC1.toS(), VSCRATCH0.toS());
+
+    // Decompose input
+    load_constant(VSCRATCH0.toS(), half);
+    FSUB(VSCRATCH0.toS(), SRC1.toS(), VSCRATCH0.toS());
+    FCVTNS(W0, VSCRATCH0.toS());
+    SCVTF(VSCRATCH0.toS(), W0);
+    // VSCRATCH0 now contains input rounded to the nearest integer.
+    ADD(W0, W0, 0x7f);
+    FSUB(SRC1.toS(), SRC1.toS(), VSCRATCH0.toS());
+    // SRC1 contains input - round(input), which is in [-0.5, 0.5).
+    LSL(W0, W0, 23);
+    FMOV(VSCRATCH0.toS(), W0);
+    // VSCRATCH0 contains 2^(round(input)).
+
+    // Complete computation of polynomial.
+    load_constant(VSCRATCH1.toS(), c0);
+    FMUL(VSCRATCH1.toS(), VSCRATCH1.toS(), SRC1.toS());
+    add_constant(VSCRATCH1.toS(), c1);
+    FMUL(VSCRATCH1.toS(), VSCRATCH1.toS(), SRC1.toS());
+    add_constant(VSCRATCH1.toS(), c2);
+    FMUL(VSCRATCH1.toS(), VSCRATCH1.toS(), SRC1.toS());
+    add_constant(VSCRATCH1.toS(), c3);
+    FMUL(SRC1.toS(), SRC1.toS(), VSCRATCH1.toS());
+    add_constant(SRC1.toS(), c4);
+    FMUL(SRC1.toS(), SRC1.toS(), VSCRATCH0.toS());
+
+    // Duplicate result across vector
+    L(ret_label);
+    DUP(SRC1, SRC1, 0);
+
+    RET();
+
+    return subroutine;
+}
+
+} // namespace Pica::Shader
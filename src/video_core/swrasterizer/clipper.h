@@ -9,11 +9,24 @@ namespace Shader {
 struct OutputVertex;
 }
 
+namespace Rasterizer {
+class TextureCache;
+class TileBinner;
+}
+
 namespace Clipper {
 
 using Shader::OutputVertex;
 
-void ProcessTriangle(const OutputVertex& v0, const OutputVertex& v1, const OutputVertex& v2);
+/**
+ * Clips the given triangle and forwards the resulting screen-space triangles to the rasterizer.
+ * @param texture_cache Cache of the decoded textures sampled by the rasterizer
+ * @param binner If not null, triangles are binned for deferred multithreaded rasterization instead
+ *               of being rasterized right away
+ */
+void ProcessTriangle(const OutputVertex& v0, const OutputVertex& v1, const OutputVertex& v2,
+                     Rasterizer::TextureCache& texture_cache,
+                     Rasterizer::TileBinner* binner = nullptr);
 
 } // namespace Clipper
 } // namespace Pica
@@ -3,6 +3,8 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
+#include <array>
+#include <utility>
 #include "common/assert.h"
 #include "common/color.h"
 #include "common/common_types.h"
@@ -257,11 +259,11 @@ u8 PerformStencilAction(FramebufferRegs::StencilAction action, u8 old_stencil, u
     }
 }
 
-Common::Vec4<u8> EvaluateBlendEquation(const Common::Vec4<u8>& src,
-                                       const Common::Vec4<u8>& srcfactor,
-                                       const Common::Vec4<u8>& dest,
-                                       const Common::Vec4<u8>& destfactor,
-                                       FramebufferRegs::BlendEquation equation) {
+template <FramebufferRegs::BlendEquation equation>
+static Common::Vec4<u8> BlendEquationImpl(const Common::Vec4<u8>& src,
+                                          const Common::Vec4<u8>& srcfactor,
+                                          const Common::Vec4<u8>& dest,
+                                          const Common::Vec4<u8>& destfactor) {
     Common::Vec4<int> result;
 
     auto src_result = (src * srcfactor).Cast<int>();
@@ -299,12 +301,188 @@ Common::Vec4<u8> EvaluateBlendEquation(const Common::Vec4<u8>& src,
     default:
         LOG_CRITICAL(HW_GPU, "Unknown RGB blend equation 0x{:x}", equation);
         UNIMPLEMENTED();
+        result = {0, 0, 0, 0};
     }
 
     return Common::Vec4<u8>(std::clamp(result.r(), 0, 255), std::clamp(result.g(), 0, 255),
                             std::clamp(result.b(), 0, 255), std::clamp(result.a(), 0, 255));
 };
 
+template <FramebufferRegs::BlendFactor factor>
+static Common::Vec4<u8> BlendFactorImpl(const Common::Vec4<u8>& src, const Common::Vec4<u8>& dest,
+                                        const Common::Vec4<u8>& blend_const) {
+    const auto invert = [](const Common::Vec4<u8>& value) {
+        return Common::MakeVec<u8>(255 - value.r(), 255 - value.g(), 255 - value.b(),
+                                   255 - value.a());
+    };
+    const auto splat = [](u8 value) { return Common::MakeVec(value, value, value, value); };
+
+    switch (factor) {
+    case FramebufferRegs::BlendFactor::Zero:
+        return splat(0);
+
+    case FramebufferRegs::BlendFactor::One:
+        return splat(255);
+
+    case FramebufferRegs::BlendFactor::SourceColor:
+        return src;
+
+    case FramebufferRegs::BlendFactor::OneMinusSourceColor:
+        return invert(src);
+
+    case FramebufferRegs::BlendFactor::DestColor:
+        return dest;
+
+    case FramebufferRegs::BlendFactor::OneMinusDestColor:
+        return invert(dest);
+
+    case FramebufferRegs::BlendFactor::SourceAlpha:
+        return splat(src.a());
+
+    case FramebufferRegs::BlendFactor::OneMinusSourceAlpha:
+        return splat(255 - src.a());
+
+    case FramebufferRegs::BlendFactor::DestAlpha:
+        return splat(dest.a());
+
+    case FramebufferRegs::BlendFactor::OneMinusDestAlpha:
+        return splat(255 - dest.a());
+
+    case FramebufferRegs::BlendFactor::ConstantColor:
+        return blend_const;
+
+    case FramebufferRegs::BlendFactor::OneMinusConstantColor:
+        return invert(blend_const);
+
+    case FramebufferRegs::BlendFactor::ConstantAlpha:
+        return splat(blend_const.a());
+
+    case FramebufferRegs::BlendFactor::OneMinusConstantAlpha:
+        return splat(255 - blend_const.a());
+
+    case FramebufferRegs::BlendFactor::SourceAlphaSaturate: {
+        // Returns 1.0 for the alpha channel
+        const u8 saturate = std::min(src.a(), static_cast<u8>(255 - dest.a()));
+        return {saturate, saturate, saturate, 255};
+    }
+
+    default:
+        LOG_CRITICAL(HW_GPU, "Unknown blend factor {:x}", factor);
+        UNIMPLEMENTED();
+        return src;
+    }
+}
+
+template <FramebufferRegs::CompareFunc func>
+static bool CompareTestImpl(u32 lhs, u32 rhs) {
+    switch (func) {
+    case FramebufferRegs::CompareFunc::Never:
+        return false;
+
+    case FramebufferRegs::CompareFunc::Always:
+        return true;
+
+    case FramebufferRegs::CompareFunc::Equal:
+        return lhs == rhs;
+
+    case FramebufferRegs::CompareFunc::NotEqual:
+        return lhs != rhs;
+
+    case FramebufferRegs::CompareFunc::LessThan:
+        return lhs < rhs;
+
+    case FramebufferRegs::CompareFunc::LessThanOrEqual:
+        return lhs <= rhs;
+
+    case FramebufferRegs::CompareFunc::GreaterThan:
+        return lhs > rhs;
+
+    case FramebufferRegs::CompareFunc::GreaterThanOrEqual:
+        return lhs >= rhs;
+    }
+
+    return false;
+}
+
+template <FramebufferRegs::StencilAction action>
+static u8 StencilActionImpl(u8 old_stencil, u8 ref) {
+    return PerformStencilAction(action, old_stencil, ref);
+}
+
+template <FramebufferRegs::LogicOp op>
+static Common::Vec4<u8> LogicOpImpl(const Common::Vec4<u8>& src, const Common::Vec4<u8>& dest) {
+    return {LogicOp(src.r(), dest.r(), op), LogicOp(src.g(), dest.g(), op),
+            LogicOp(src.b(), dest.b(), op), LogicOp(src.a(), dest.a(), op)};
+}
+
+// Lookup tables holding an instantiation of the above for every possible register value, so that
+// the output merger can resolve its configuration once per triangle instead of per pixel.
+
+template <std::size_t... equations>
+static constexpr std::array<BlendEquationFunc, sizeof...(equations)> MakeBlendEquationTable(
+    std::index_sequence<equations...>) {
+    return {&BlendEquationImpl<static_cast<FramebufferRegs::BlendEquation>(equations)>...};
+}
+
+template <std::size_t... factors>
+static constexpr std::array<BlendFactorFunc, sizeof...(factors)> MakeBlendFactorTable(
+    std::index_sequence<factors...>) {
+    return {&BlendFactorImpl<static_cast<FramebufferRegs::BlendFactor>(factors)>...};
+}
+
+template <std::size_t... funcs>
+static constexpr std::array<CompareTestFunc, sizeof...(funcs)> MakeCompareTestTable(
+    std::index_sequence<funcs...>) {
+    return {&CompareTestImpl<static_cast<FramebufferRegs::CompareFunc>(funcs)>...};
+}
+
+template <std::size_t... actions>
+static constexpr std::array<StencilActionFunc, sizeof...(actions)> MakeStencilActionTable(
+    std::index_sequence<actions...>) {
+    return {&StencilActionImpl<static_cast<FramebufferRegs::StencilAction>(actions)>...};
+}
+
+template <std::size_t... ops>
+static constexpr std::array<LogicOpFunc, sizeof...(ops)> MakeLogicOpTable(
+    std::index_sequence<ops...>) {
+    return {&LogicOpImpl<static_cast<FramebufferRegs::LogicOp>(ops)>...};
+}
+
+// The sizes match the widths of the corresponding FramebufferRegs bit fields
+constexpr auto blend_equation_table = MakeBlendEquationTable(std::make_index_sequence<8>{});
+constexpr auto blend_factor_table = MakeBlendFactorTable(std::make_index_sequence<16>{});
+constexpr auto compare_test_table = MakeCompareTestTable(std::make_index_sequence<8>{});
+constexpr auto stencil_action_table = MakeStencilActionTable(std::make_index_sequence<8>{});
+constexpr auto logic_op_table = MakeLogicOpTable(std::make_index_sequence<16>{});
+
+BlendEquationFunc GetBlendEquationFunc(FramebufferRegs::BlendEquation equation) {
+    return blend_equation_table[static_cast<u32>(equation) % blend_equation_table.size()];
+}
+
+BlendFactorFunc GetBlendFactorFunc(FramebufferRegs::BlendFactor factor) {
+    return blend_factor_table[static_cast<u32>(factor) % blend_factor_table.size()];
+}
+
+CompareTestFunc GetCompareTestFunc(FramebufferRegs::CompareFunc func) {
+    return compare_test_table[static_cast<u32>(func) % compare_test_table.size()];
+}
+
+StencilActionFunc GetStencilActionFunc(FramebufferRegs::StencilAction action) {
+    return stencil_action_table[static_cast<u32>(action) % stencil_action_table.size()];
+}
+
+LogicOpFunc GetLogicOpFunc(FramebufferRegs::LogicOp op) {
+    return logic_op_table[static_cast<u32>(op) % logic_op_table.size()];
+}
+
+Common::Vec4<u8> EvaluateBlendEquation(const Common::Vec4<u8>& src,
+                                       const Common::Vec4<u8>& srcfactor,
+                                       const Common::Vec4<u8>& dest,
+                                       const Common::Vec4<u8>& destfactor,
+                                       FramebufferRegs::BlendEquation equation) {
+    return GetBlendEquationFunc(equation)(src, srcfactor, dest, destfactor);
+}
+
 u8 LogicOp(u8 src, u8 dest, FramebufferRegs::LogicOp op) {
     switch (op) {
     case FramebufferRegs::LogicOp::Clear:
@@ -26,6 +26,37 @@ Common::Vec4<u8> EvaluateBlendEquation(const Common::Vec4<u8>& src,
 
 u8 LogicOp(u8 src, u8 dest, FramebufferRegs::LogicOp op);
 
+/// Returns whether lhs compares against rhs as requested by the compare function
+using CompareTestFunc = bool (*)(u32 lhs, u32 rhs);
+/// Returns the blend factor for all four channels
+using BlendFactorFunc = Common::Vec4<u8> (*)(const Common::Vec4<u8>& src,
+                                             const Common::Vec4<u8>& dest,
+                                             const Common::Vec4<u8>& blend_const);
+using BlendEquationFunc = Common::Vec4<u8> (*)(const Common::Vec4<u8>& src,
+                                               const Common::Vec4<u8>& srcfactor,
+                                               const Common::Vec4<u8>& dest,
+                                               const Common::Vec4<u8>& destfactor);
+/// Returns the new stencil value
+using StencilActionFunc = u8 (*)(u8 old_stencil, u8 ref);
+/// Returns the logic operation applied to all four channels
+using LogicOpFunc = Common::Vec4<u8> (*)(const Common::Vec4<u8>& src,
+                                         const Common::Vec4<u8>& dest);
+
+/// Returns the comparison of the alpha, stencil and depth tests specialized for the given function
+CompareTestFunc GetCompareTestFunc(FramebufferRegs::CompareFunc func);
+
+/// Returns the blend factor lookup specialized for the given factor
+BlendFactorFunc GetBlendFactorFunc(FramebufferRegs::BlendFactor factor);
+
+/// Returns EvaluateBlendEquation specialized for the given equation
+BlendEquationFunc GetBlendEquationFunc(FramebufferRegs::BlendEquation equation);
+
+/// Returns PerformStencilAction specialized for the given action
+StencilActionFunc GetStencilActionFunc(FramebufferRegs::StencilAction action);
+
+/// Returns LogicOp specialized for the given operation
+LogicOpFunc GetLogicOpFunc(FramebufferRegs::LogicOp op);
+
 void DrawShadowMapPixel(int x, int y, u32 depth, u8 stencil);
 
 } // namespace Pica::Rasterizer
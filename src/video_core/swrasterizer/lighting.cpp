@@ -20,15 +20,210 @@ static float LookupLightingLut(const Pica::State::Lighting& lighting, std::size_
     return lut_value + lut_diff * delta;
 }
 
+struct LightingVectors {
+    Common::Vec3<float> normal;
+    Common::Vec3<float> tangent;
+    Common::Vec3<float> norm_view;
+    Common::Vec3<float> light_vector;
+    Common::Vec3<float> norm_half_vector;
+    Common::Vec3<float> spot_direction;
+};
+
+template <LightingRegs::LightingLutInput input>
+static float LutInputImpl(const LightingVectors& vectors) {
+    using LutInput = LightingRegs::LightingLutInput;
+
+    switch (input) {
+    case LutInput::NH:
+        return Common::Dot(vectors.normal, vectors.norm_half_vector);
+
+    case LutInput::VH:
+        return Common::Dot(vectors.norm_view, vectors.norm_half_vector);
+
+    case LutInput::NV:
+        return Common::Dot(vectors.normal, vectors.norm_view);
+
+    case LutInput::LN:
+        return Common::Dot(vectors.light_vector, vectors.normal);
+
+    case LutInput::SP:
+        return Common::Dot(vectors.light_vector, vectors.spot_direction);
+
+    case LutInput::CP: {
+        const Common::Vec3<float> half_vector_proj =
+            vectors.norm_half_vector -
+            vectors.normal * Common::Dot(vectors.normal, vectors.norm_half_vector);
+        return Common::Dot(half_vector_proj, vectors.tangent);
+    }
+    }
+
+    UNREACHABLE();
+}
+
+static float ZeroLutInput(const LightingVectors&) {
+    return 0.0f;
+}
+
+static DecodedLighting::LutInputFunc GetLutInputFunc(LightingRegs::LightingLutInput input,
+                                                     LightingRegs::LightingConfig config) {
+    using LutInput = LightingRegs::LightingLutInput;
+
+    switch (input) {
+    case LutInput::NH:
+        return &LutInputImpl<LutInput::NH>;
+    case LutInput::VH:
+        return &LutInputImpl<LutInput::VH>;
+    case LutInput::NV:
+        return &LutInputImpl<LutInput::NV>;
+    case LutInput::LN:
+        return &LutInputImpl<LutInput::LN>;
+    case LutInput::SP:
+        return &LutInputImpl<LutInput::SP>;
+    case LutInput::CP:
+        // The tangent is only available in configuration 7
+        if (config == LightingRegs::LightingConfig::Config7) {
+            return &LutInputImpl<LutInput::CP>;
+        }
+        return &ZeroLutInput;
+    default:
+        LOG_CRITICAL(HW_GPU, "Unknown lighting LUT input {}", input);
+        UNIMPLEMENTED();
+        return &ZeroLutInput;
+    }
+}
+
+DecodedLighting::DecodedLighting(const LightingRegs& regs) {
+    using Sampler = LightingRegs::LightingSampler;
+    const LightingRegs::LightingConfig config = regs.config0.config;
+
+    const auto MakeLookup = [&regs, config](bool enable, LightingRegs::LightingLutInput input,
+                                            bool abs, LightingRegs::LightingScale scale,
+                                            Sampler sampler) {
+        return LutLookup{
+            .enable = enable,
+            .abs = abs,
+            // Unknown inputs of disabled lookups must not be reported
+            .input = enable ? GetLutInputFunc(input, config) : &ZeroLutInput,
+            .scale = regs.lut_scale.GetScale(scale),
+            .lut = static_cast<std::size_t>(sampler),
+        };
+    };
+    const auto IsSupported = [config](Sampler sampler) {
+        return LightingRegs::IsLightingSamplerSupported(config, sampler);
+    };
+
+    num_lights = regs.max_light_index + 1;
+    for (std::size_t light_index = 0; light_index < num_lights; ++light_index) {
+        const unsigned num = regs.light_enable.GetNum(static_cast<unsigned>(light_index));
+        const auto& light_config = regs.light[num];
+        Light& light = lights[light_index];
+
+        light.position = {float16::FromRaw(light_config.x).ToFloat32(),
+                          float16::FromRaw(light_config.y).ToFloat32(),
+                          float16::FromRaw(light_config.z).ToFloat32()};
+        const Common::Vec3<s32> spot_dir{light_config.spot_x.Value(), light_config.spot_y.Value(),
+                                         light_config.spot_z.Value()};
+        light.spot_direction = spot_dir.Cast<float>() / 2047.0f;
+        light.specular_0 = light_config.specular_0.ToVec3f();
+        light.specular_1 = light_config.specular_1.ToVec3f();
+        light.diffuse = light_config.diffuse.ToVec3f();
+        light.ambient = light_config.ambient.ToVec3f();
+        light.directional = light_config.config.directional != 0;
+        light.two_sided_diffuse = light_config.config.two_sided_diffuse != 0;
+        light.geometric_factor_0 = light_config.config.geometric_factor_0 != 0;
+        light.geometric_factor_1 = light_config.config.geometric_factor_1 != 0;
+        light.shadow = !regs.IsShadowDisabled(num);
+        light.dist_atten_enable = !regs.IsDistAttenDisabled(num);
+        light.dist_atten_scale = float20::FromRaw(light_config.dist_atten_scale).ToFloat32();
+        light.dist_atten_bias = float20::FromRaw(light_config.dist_atten_bias).ToFloat32();
+        light.dist_atten_lut =
+            static_cast<std::size_t>(LightingRegs::DistanceAttenuationSampler(num));
+        light.spot = MakeLookup(
+            !regs.IsSpotAttenDisabled(num) && IsSupported(Sampler::SpotlightAttenuation),
+            regs.lut_input.sp, regs.abs_lut_input.disable_sp == 0, regs.lut_scale.sp,
+            LightingRegs::SpotlightAttenuationSampler(num));
+    }
+
+    d0 = MakeLookup(regs.config1.disable_lut_d0 == 0 && IsSupported(Sampler::Distribution0),
+                    regs.lut_input.d0, regs.abs_lut_input.disable_d0 == 0, regs.lut_scale.d0,
+                    Sampler::Distribution0);
+    d1 = MakeLookup(regs.config1.disable_lut_d1 == 0 && IsSupported(Sampler::Distribution1),
+                    regs.lut_input.d1, regs.abs_lut_input.disable_d1 == 0, regs.lut_scale.d1,
+                    Sampler::Distribution1);
+    rr = MakeLookup(regs.config1.disable_lut_rr == 0 && IsSupported(Sampler::ReflectRed),
+                    regs.lut_input.rr, regs.abs_lut_input.disable_rr == 0, regs.lut_scale.rr,
+                    Sampler::ReflectRed);
+    rg = MakeLookup(regs.config1.disable_lut_rg == 0 && IsSupported(Sampler::ReflectGreen),
+                    regs.lut_input.rg, regs.abs_lut_input.disable_rg == 0, regs.lut_scale.rg,
+                    Sampler::ReflectGreen);
+    rb = MakeLookup(regs.config1.disable_lut_rb == 0 && IsSupported(Sampler::ReflectBlue),
+                    regs.lut_input.rb, regs.abs_lut_input.disable_rb == 0, regs.lut_scale.rb,
+                    Sampler::ReflectBlue);
+    fr = MakeLookup(regs.config1.disable_lut_fr == 0 && IsSupported(Sampler::Fresnel),
+                    regs.lut_input.fr, regs.abs_lut_input.disable_fr == 0, regs.lut_scale.fr,
+                    Sampler::Fresnel);
+
+    global_ambient = regs.global_ambient.ToVec3f();
+
+    shadow_enable = regs.config0.enable_shadow != 0;
+    shadow_invert = regs.config0.shadow_invert != 0;
+    shadow_primary = regs.config0.shadow_primary != 0;
+    shadow_secondary = regs.config0.shadow_secondary != 0;
+    shadow_alpha = regs.config0.shadow_alpha != 0;
+    shadow_selector = regs.config0.shadow_selector;
+
+    bump_mode = regs.config0.bump_mode;
+    if (bump_mode != LightingRegs::LightingBumpMode::None &&
+        bump_mode != LightingRegs::LightingBumpMode::NormalMap &&
+        bump_mode != LightingRegs::LightingBumpMode::TangentMap) {
+        LOG_ERROR(HW_GPU, "Unknown bump mode {}", static_cast<u32>(bump_mode));
+        bump_mode = LightingRegs::LightingBumpMode::None;
+    }
+    bump_renorm = regs.config0.disable_bump_renorm == 0;
+    bump_selector = regs.config0.bump_selector;
+
+    clamp_highlights = regs.config0.clamp_highlights != 0;
+    enable_primary_alpha = regs.config0.enable_primary_alpha != 0;
+    enable_secondary_alpha = regs.config0.enable_secondary_alpha != 0;
+}
+
+/// Samples the LUT of a lookup at the input computed from the given vectors
+static float SampleLut(const Pica::State::Lighting& lighting_state,
+                       const DecodedLighting::LutLookup& lookup, const LightingVectors& vectors,
+                       bool two_sided_diffuse) {
+    float result = lookup.input(vectors);
+
+    u8 index;
+    float delta;
+
+    if (lookup.abs) {
+        if (two_sided_diffuse)
+            result = std::abs(result);
+        else
+            result = std::max(result, 0.0f);
+
+        float flr = std::floor(result * 256.0f);
+        index = static_cast<u8>(std::clamp(flr, 0.0f, 255.0f));
+        delta = result * 256 - index;
+    } else {
+        float flr = std::floor(result * 128.0f);
+        s8 signed_index = static_cast<s8>(std::clamp(flr, -128.0f, 127.0f));
+        delta = result * 128.0f - signed_index;
+        index = static_cast<u8>(signed_index);
+    }
+
+    return lookup.scale * LookupLightingLut(lighting_state, lookup.lut, index, delta);
+}
+
 std::tuple<Common::Vec4<u8>, Common::Vec4<u8>> ComputeFragmentsColors(
-    const Pica::LightingRegs& lighting, const Pica::State::Lighting& lighting_state,
+    const DecodedLighting& lighting, const Pica::State::Lighting& lighting_state,
     const Common::Quaternion<float>& normquat, const Common::Vec3<float>& view,
     const Common::Vec4<u8> (&texture_color)[4]) {
 
     Common::Vec4<float> shadow;
-    if (lighting.config0.enable_shadow) {
-        shadow = texture_color[lighting.config0.shadow_selector].Cast<float>() / 255.0f;
-        if (lighting.config0.shadow_invert) {
+    if (lighting.shadow_enable) {
+        shadow = texture_color[lighting.shadow_selector].Cast<float>() / 255.0f;
+        if (lighting.shadow_invert) {
             shadow = Common::MakeVec(1.0f, 1.0f, 1.0f, 1.0f) - shadow;
         }
     } else {
@@ -38,261 +233,158 @@ std::tuple<Common::Vec4<u8>, Common::Vec4<u8>> ComputeFragmentsColors(
     Common::Vec3<float> surface_normal;
     Common::Vec3<float> surface_tangent;
 
-    if (lighting.config0.bump_mode != LightingRegs::LightingBumpMode::None) {
+    if (lighting.bump_mode != LightingRegs::LightingBumpMode::None) {
         Common::Vec3<float> perturbation =
-            texture_color[lighting.config0.bump_selector].xyz().Cast<float>() / 127.5f -
+            texture_color[lighting.bump_selector].xyz().Cast<float>() / 127.5f -
             Common::MakeVec(1.0f, 1.0f, 1.0f);
-        if (lighting.config0.bump_mode == LightingRegs::LightingBumpMode::NormalMap) {
-            if (!lighting.config0.disable_bump_renorm) {
+        if (lighting.bump_mode == LightingRegs::LightingBumpMode::NormalMap) {
+            if (lighting.bump_renorm) {
                 const float z_square = 1 - perturbation.xy().Length2();
                 perturbation.z = std::sqrt(std::max(z_square, 0.0f));
             }
             surface_normal = perturbation;
             surface_tangent = Common::MakeVec(1.0f, 0.0f, 0.0f);
-        } else if (lighting.config0.bump_mode == LightingRegs::LightingBumpMode::TangentMap) {
+        } else {
             surface_normal = Common::MakeVec(0.0f, 0.0f, 1.0f);
             surface_tangent = perturbation;
-        } else {
-            LOG_ERROR(HW_GPU, "Unknown bump mode {}",
-                      static_cast<u32>(lighting.config0.bump_mode.Value()));
         }
     } else {
         surface_normal = Common::MakeVec(0.0f, 0.0f, 1.0f);
         surface_tangent = Common::MakeVec(1.0f, 0.0f, 0.0f);
     }
 
+    LightingVectors vectors;
+
     // Use the normalized the quaternion when performing the rotation
-    auto normal = Common::QuaternionRotate(normquat, surface_normal);
-    auto tangent = Common::QuaternionRotate(normquat, surface_tangent);
+    vectors.normal = Common::QuaternionRotate(normquat, surface_normal);
+    vectors.tangent = Common::QuaternionRotate(normquat, surface_tangent);
+    vectors.norm_view = view.Normalized();
 
     Common::Vec4<float> diffuse_sum = {0.0f, 0.0f, 0.0f, 1.0f};
     Common::Vec4<float> specular_sum = {0.0f, 0.0f, 0.0f, 1.0f};
 
-    for (unsigned light_index = 0; light_index <= lighting.max_light_index; ++light_index) {
-        unsigned num = lighting.light_enable.GetNum(light_index);
-        const auto& light_config = lighting.light[num];
+    for (std::size_t light_index = 0; light_index < lighting.num_lights; ++light_index) {
+        const auto& light = lighting.lights[light_index];
 
         Common::Vec3<float> refl_value = {};
-        Common::Vec3<float> position = {float16::FromRaw(light_config.x).ToFloat32(),
-                                        float16::FromRaw(light_config.y).ToFloat32(),
-                                        float16::FromRaw(light_config.z).ToFloat32()};
-        Common::Vec3<float> light_vector;
+        Common::Vec3<float>& light_vector = vectors.light_vector;
 
-        if (light_config.config.directional)
-            light_vector = position;
+        if (light.directional)
+            light_vector = light.position;
         else
-            light_vector = position + view;
+            light_vector = light.position + view;
 
         [[maybe_unused]] float length = light_vector.Normalize();
 
-        Common::Vec3<float> norm_view = view.Normalized();
-        Common::Vec3<float> half_vector = norm_view + light_vector;
+        Common::Vec3<float> half_vector = vectors.norm_view + light_vector;
+        vectors.norm_half_vector = half_vector.Normalized();
+        vectors.spot_direction = light.spot_direction;
 
         float dist_atten = 1.0f;
-        if (!lighting.IsDistAttenDisabled(num)) {
-            auto distance = (-view - position).Length();
-            float scale = Pica::float20::FromRaw(light_config.dist_atten_scale).ToFloat32();
-            float bias = Pica::float20::FromRaw(light_config.dist_atten_bias).ToFloat32();
-            std::size_t lut =
-                static_cast<std::size_t>(LightingRegs::LightingSampler::DistanceAttenuation) + num;
-
-            float sample_loc = std::clamp(scale * distance + bias, 0.0f, 1.0f);
+        if (light.dist_atten_enable) {
+            auto distance = (-view - light.position).Length();
+            float sample_loc =
+                std::clamp(light.dist_atten_scale * distance + light.dist_atten_bias, 0.0f, 1.0f);
 
             u8 lutindex =
                 static_cast<u8>(std::clamp(std::floor(sample_loc * 256.0f), 0.0f, 255.0f));
             float delta = sample_loc * 256 - lutindex;
-            dist_atten = LookupLightingLut(lighting_state, lut, lutindex, delta);
+            dist_atten = LookupLightingLut(lighting_state, light.dist_atten_lut, lutindex, delta);
         }
 
-        auto GetLutValue = [&](LightingRegs::LightingLutInput input, bool abs,
-                               LightingRegs::LightingScale scale_enum,
-                               LightingRegs::LightingSampler sampler) {
-            float result = 0.0f;
-
-            switch (input) {
-            case LightingRegs::LightingLutInput::NH:
-                result = Common::Dot(normal, half_vector.Normalized());
-                break;
-
-            case LightingRegs::LightingLutInput::VH:
-                result = Common::Dot(norm_view, half_vector.Normalized());
-                break;
-
-            case LightingRegs::LightingLutInput::NV:
-                result = Common::Dot(normal, norm_view);
-                break;
-
-            case LightingRegs::LightingLutInput::LN:
-                result = Common::Dot(light_vector, normal);
-                break;
-
-            case LightingRegs::LightingLutInput::SP: {
-                Common::Vec3<s32> spot_dir{light_config.spot_x.Value(), light_config.spot_y.Value(),
-                                           light_config.spot_z.Value()};
-                result = Common::Dot(light_vector, spot_dir.Cast<float>() / 2047.0f);
-                break;
-            }
-            case LightingRegs::LightingLutInput::CP:
-                if (lighting.config0.config == LightingRegs::LightingConfig::Config7) {
-                    const Common::Vec3<float> norm_half_vector = half_vector.Normalized();
-                    const Common::Vec3<float> half_vector_proj =
-                        norm_half_vector - normal * Common::Dot(normal, norm_half_vector);
-                    result = Common::Dot(half_vector_proj, tangent);
-                } else {
-                    result = 0.0f;
-                }
-                break;
-            default:
-                LOG_CRITICAL(HW_GPU, "Unknown lighting LUT input {}", input);
-                UNIMPLEMENTED();
-                result = 0.0f;
-            }
-
-            u8 index;
-            float delta;
-
-            if (abs) {
-                if (light_config.config.two_sided_diffuse)
-                    result = std::abs(result);
-                else
-                    result = std::max(result, 0.0f);
-
-                float flr = std::floor(result * 256.0f);
-                index = static_cast<u8>(std::clamp(flr, 0.0f, 255.0f));
-                delta = result * 256 - index;
-            } else {
-                float flr = std::floor(result * 128.0f);
-                s8 signed_index = static_cast<s8>(std::clamp(flr, -128.0f, 127.0f));
-                delta = result * 128.0f - signed_index;
-                index = static_cast<u8>(signed_index);
-            }
-
-            float scale = lighting.lut_scale.GetScale(scale_enum);
-            return scale * LookupLightingLut(lighting_state, static_cast<std::size_t>(sampler),
-                                             index, delta);
+        const auto GetLutValue = [&](const DecodedLighting::LutLookup& lookup) {
+            return SampleLut(lighting_state, lookup, vectors, light.two_sided_diffuse);
         };
 
         // If enabled, compute spot light attenuation value
         float spot_atten = 1.0f;
-        if (!lighting.IsSpotAttenDisabled(num) &&
-            LightingRegs::IsLightingSamplerSupported(
-                lighting.config0.config, LightingRegs::LightingSampler::SpotlightAttenuation)) {
-            auto lut = LightingRegs::SpotlightAttenuationSampler(num);
-            spot_atten = GetLutValue(lighting.lut_input.sp, lighting.abs_lut_input.disable_sp == 0,
-                                     lighting.lut_scale.sp, lut);
+        if (light.spot.enable) {
+            spot_atten = GetLutValue(light.spot);
         }
 
         // Specular 0 component
         float d0_lut_value = 1.0f;
-        if (lighting.config1.disable_lut_d0 == 0 &&
-            LightingRegs::IsLightingSamplerSupported(
-                lighting.config0.config, LightingRegs::LightingSampler::Distribution0)) {
-            d0_lut_value =
-                GetLutValue(lighting.lut_input.d0, lighting.abs_lut_input.disable_d0 == 0,
-                            lighting.lut_scale.d0, LightingRegs::LightingSampler::Distribution0);
+        if (lighting.d0.enable) {
+            d0_lut_value = GetLutValue(lighting.d0);
         }
 
-        Common::Vec3<float> specular_0 = d0_lut_value * light_config.specular_0.ToVec3f();
+        Common::Vec3<float> specular_0 = d0_lut_value * light.specular_0;
 
         // If enabled, lookup ReflectRed value, otherwise, 1.0 is used
-        if (lighting.config1.disable_lut_rr == 0 &&
-            LightingRegs::IsLightingSamplerSupported(lighting.config0.config,
-                                                     LightingRegs::LightingSampler::ReflectRed)) {
-            refl_value.x =
-                GetLutValue(lighting.lut_input.rr, lighting.abs_lut_input.disable_rr == 0,
-                            lighting.lut_scale.rr, LightingRegs::LightingSampler::ReflectRed);
+        if (lighting.rr.enable) {
+            refl_value.x = GetLutValue(lighting.rr);
         } else {
             refl_value.x = 1.0f;
         }
 
         // If enabled, lookup ReflectGreen value, otherwise, ReflectRed value is used
-        if (lighting.config1.disable_lut_rg == 0 &&
-            LightingRegs::IsLightingSamplerSupported(lighting.config0.config,
-                                                     LightingRegs::LightingSampler::ReflectGreen)) {
-            refl_value.y =
-                GetLutValue(lighting.lut_input.rg, lighting.abs_lut_input.disable_rg == 0,
-                            lighting.lut_scale.rg, LightingRegs::LightingSampler::ReflectGreen);
+        if (lighting.rg.enable) {
+            refl_value.y = GetLutValue(lighting.rg);
         } else {
             refl_value.y = refl_value.x;
         }
 
         // If enabled, lookup ReflectBlue value, otherwise, ReflectRed value is used
-        if (lighting.config1.disable_lut_rb == 0 &&
-            LightingRegs::IsLightingSamplerSupported(lighting.config0.config,
-                                                     LightingRegs::LightingSampler::ReflectBlue)) {
-            refl_value.z =
-                GetLutValue(lighting.lut_input.rb, lighting.abs_lut_input.disable_rb == 0,
-                            lighting.lut_scale.rb, LightingRegs::LightingSampler::ReflectBlue);
+        if (lighting.rb.enable) {
+            refl_value.z = GetLutValue(lighting.rb);
         } else {
             refl_value.z = refl_value.x;
         }
 
         // Specular 1 component
         float d1_lut_value = 1.0f;
-        if (lighting.config1.disable_lut_d1 == 0 &&
-            LightingRegs::IsLightingSamplerSupported(
-                lighting.config0.config, LightingRegs::LightingSampler::Distribution1)) {
-            d1_lut_value =
-                GetLutValue(lighting.lut_input.d1, lighting.abs_lut_input.disable_d1 == 0,
-                            lighting.lut_scale.d1, LightingRegs::LightingSampler::Distribution1);
+        if (lighting.d1.enable) {
+            d1_lut_value = GetLutValue(lighting.d1);
         }
 
-        Common::Vec3<float> specular_1 =
-            d1_lut_value * refl_value * light_config.specular_1.ToVec3f();
+        Common::Vec3<float> specular_1 = d1_lut_value * refl_value * light.specular_1;
 
         // Fresnel
         // Note: only the last entry in the light slots applies the Fresnel factor
-        if (light_index == lighting.max_light_index && lighting.config1.disable_lut_fr == 0 &&
-            LightingRegs::IsLightingSamplerSupported(lighting.config0.config,
-                                                     LightingRegs::LightingSampler::Fresnel)) {
-
-            float lut_value =
-                GetLutValue(lighting.lut_input.fr, lighting.abs_lut_input.disable_fr == 0,
-                            lighting.lut_scale.fr, LightingRegs::LightingSampler::Fresnel);
+        if (light_index == lighting.num_lights - 1 && lighting.fr.enable) {
+            float lut_value = GetLutValue(lighting.fr);
 
             // Enabled for diffuse lighting alpha component
-            if (lighting.config0.enable_primary_alpha) {
+            if (lighting.enable_primary_alpha) {
                 diffuse_sum.a() = lut_value;
             }
 
             // Enabled for the specular lighting alpha component
-            if (lighting.config0.enable_secondary_alpha) {
+            if (lighting.enable_secondary_alpha) {
                 specular_sum.a() = lut_value;
             }
         }
 
-        auto dot_product = Common::Dot(light_vector, normal);
-        if (light_config.config.two_sided_diffuse)
+        auto dot_product = Common::Dot(light_vector, vectors.normal);
+        if (light.two_sided_diffuse)
             dot_product = std::abs(dot_product);
         else
             dot_product = std::max(dot_product, 0.0f);
 
         float clamp_highlights = 1.0f;
-        if (lighting.config0.clamp_highlights) {
+        if (lighting.clamp_highlights) {
             clamp_highlights = dot_product == 0.0f ? 0.0f : 1.0f;
         }
 
-        if (light_config.config.geometric_factor_0 || light_config.config.geometric_factor_1) {
+        if (light.geometric_factor_0 || light.geometric_factor_1) {
             float geo_factor = half_vector.Length2();
             geo_factor = geo_factor == 0.0f ? 0.0f : std::min(dot_product / geo_factor, 1.0f);
-            if (light_config.config.geometric_factor_0) {
+            if (light.geometric_factor_0) {
                 specular_0 *= geo_factor;
             }
-            if (light_config.config.geometric_factor_1) {
+            if (light.geometric_factor_1) {
                 specular_1 *= geo_factor;
             }
         }
 
-        auto diffuse =
-            (light_config.diffuse.ToVec3f() * dot_product + light_config.ambient.ToVec3f()) *
-            dist_atten * spot_atten;
+        auto diffuse = (light.diffuse * dot_product + light.ambient) * dist_atten * spot_atten;
         auto specular = (specular_0 + specular_1) * clamp_highlights * dist_atten * spot_atten;
 
-        if (!lighting.IsShadowDisabled(num)) {
-            if (lighting.config0.shadow_primary) {
+        if (light.shadow) {
+            if (lighting.shadow_primary) {
                 diffuse = diffuse * shadow.xyz();
             }
-            if (lighting.config0.shadow_secondary) {
+            if (lighting.shadow_secondary) {
                 specular = specular * shadow.xyz();
             }
         }
@@ -301,20 +393,20 @@ std::tuple<Common::Vec4<u8>, Common::Vec4<u8>> ComputeFragmentsColors(
         specular_sum += Common::MakeVec(specular, 0.0f);
     }
 
-    if (lighting.config0.shadow_alpha) {
+    if (lighting.shadow_alpha) {
         // Alpha shadow also uses the Fresnel selecotr to determine which alpha to apply
         // Enabled for diffuse lighting alpha component
-        if (lighting.config0.enable_primary_alpha) {
+        if (lighting.enable_primary_alpha) {
             diffuse_sum.a() *= shadow.w;
         }
 
         // Enabled for the specular lighting alpha component
-        if (lighting.config0.enable_secondary_alpha) {
+        if (lighting.enable_secondary_alpha) {
             specular_sum.a() *= shadow.w;
         }
     }
 
-    diffuse_sum += Common::MakeVec(lighting.global_ambient.ToVec3f(), 0.0f);
+    diffuse_sum += Common::MakeVec(lighting.global_ambient, 0.0f);
 
     auto diffuse = Common::MakeVec<float>(std::clamp(diffuse_sum.x, 0.0f, 1.0f) * 255,
                                           std::clamp(diffuse_sum.y, 0.0f, 1.0f) * 255,
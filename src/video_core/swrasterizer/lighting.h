@@ -4,6 +4,8 @@
 
 #pragma once
 
+#include <array>
+#include <cstddef>
 #include <tuple>
 #include "common/quaternion.h"
 #include "common/vector_math.h"
@@ -11,8 +13,79 @@
 
 namespace Pica {
 
+/// Vectors of a fragment and a light that the lighting LUTs can be indexed with
+struct LightingVectors;
+
+/**
+ * Fragment lighting configuration with all of its registers decoded. The registers only change
+ * between draws, so the software rasterizer decodes them once per triangle instead of per pixel:
+ * LUT inputs become functions specialized for them, and disabled or unsupported lookups are
+ * resolved up front.
+ */
+struct DecodedLighting {
+    explicit DecodedLighting(const LightingRegs& regs);
+
+    using LutInputFunc = float (*)(const LightingVectors& vectors);
+
+    struct LutLookup {
+        bool enable;
+        /// Whether the LUT is indexed with the absolute value of the input
+        bool abs;
+        LutInputFunc input;
+        float scale;
+        std::size_t lut;
+    };
+
+    struct Light {
+        Common::Vec3<float> position;
+        Common::Vec3<float> spot_direction;
+        Common::Vec3<float> specular_0;
+        Common::Vec3<float> specular_1;
+        Common::Vec3<float> diffuse;
+        Common::Vec3<float> ambient;
+        bool directional;
+        bool two_sided_diffuse;
+        bool geometric_factor_0;
+        bool geometric_factor_1;
+        bool shadow;
+        bool dist_atten_enable;
+        float dist_atten_scale;
+        float dist_atten_bias;
+        std::size_t dist_atten_lut;
+        LutLookup spot;
+    };
+
+    std::array<Light, 8> lights;
+    std::size_t num_lights;
+
+    LutLookup d0;
+    LutLookup d1;
+    LutLookup rr;
+    LutLookup rg;
+    LutLookup rb;
+    /// Only applied by the last light
+    LutLookup fr;
+
+    Common::Vec3<float> global_ambient;
+
+    bool shadow_enable;
+    bool shadow_invert;
+    bool shadow_primary;
+    bool shadow_secondary;
+    bool shadow_alpha;
+    std::size_t shadow_selector;
+
+    LightingRegs::LightingBumpMode bump_mode;
+    bool bump_renorm;
+    std::size_t bump_selector;
+
+    bool clamp_highlights;
+    bool enable_primary_alpha;
+    bool enable_secondary_alpha;
+};
+
 std::tuple<Common::Vec4<u8>, Common::Vec4<u8>> ComputeFragmentsColors(
-    const Pica::LightingRegs& lighting, const Pica::State::Lighting& lighting_state,
+    const DecodedLighting& lighting, const Pica::State::Lighting& lighting_state,
     const Common::Quaternion<float>& normquat, const Common::Vec3<float>& view,
     const Common::Vec4<u8> (&texture_color)[4]);
 
@@ -0,0 +1,336 @@
+// Copyright 2022 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cstring>
+#include "common/assert.h"
+#include "video_core/swrasterizer/quad_kernels.h"
+
+#if defined(ARCHITECTURE_x86_64)
+#include <emmintrin.h>
+#elif defined(ARCHITECTURE_ARM64)
+#include <arm_neon.h>
+#endif
+
+namespace Pica::Rasterizer {
+
+using TevStageConfig = TexturingRegs::TevStageConfig;
+
+namespace {
+
+static_assert(sizeof(QuadColor) == 16, "QuadColor must be tightly packed");
+
+#if defined(ARCHITECTURE_x86_64)
+
+/// The 16 RGBA channels of a quad widened to 16 bits. SSE2 is part of the x86-64 baseline.
+struct Lanes {
+    __m128i lo;
+    __m128i hi;
+
+    static Lanes Load(const QuadColor& color) {
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(color.data()));
+        const __m128i zero = _mm_setzero_si128();
+        return {_mm_unpacklo_epi8(bytes, zero), _mm_unpackhi_epi8(bytes, zero)};
+    }
+
+    static Lanes FromChannels(u16 rgb, u16 a) {
+        const s16 c = static_cast<s16>(rgb);
+        const s16 w = static_cast<s16>(a);
+        const __m128i value = _mm_setr_epi16(c, c, c, w, c, c, c, w);
+        return {value, value};
+    }
+
+    static Lanes Splat(u16 value) {
+        const __m128i splat = _mm_set1_epi16(static_cast<s16>(value));
+        return {splat, splat};
+    }
+
+    void Store(QuadColor& color) const {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(color.data()), _mm_packus_epi16(lo, hi));
+    }
+
+    Lanes operator+(const Lanes& other) const {
+        return {_mm_add_epi16(lo, other.lo), _mm_add_epi16(hi, other.hi)};
+    }
+
+    Lanes operator*(const Lanes& other) const {
+        return {_mm_mullo_epi16(lo, other.lo), _mm_mullo_epi16(hi, other.hi)};
+    }
+
+    template <int shift>
+    Lanes ShiftRight() const {
+        return {_mm_srli_epi16(lo, shift), _mm_srli_epi16(hi, shift)};
+    }
+
+    Lanes SubSaturate(const Lanes& other) const {
+        return {_mm_subs_epu16(lo, other.lo), _mm_subs_epu16(hi, other.hi)};
+    }
+
+    /// Only valid while both operands are below 0x8000, SSE2 lacks an unsigned 16-bit minimum
+    Lanes Min(const Lanes& other) const {
+        return {_mm_min_epi16(lo, other.lo), _mm_min_epi16(hi, other.hi)};
+    }
+
+    /// Takes the rgb channels from this and the alpha channels from other
+    Lanes MergeAlpha(const Lanes& other) const {
+        const __m128i alpha_mask = _mm_setr_epi16(0, 0, 0, -1, 0, 0, 0, -1);
+        const auto merge = [&alpha_mask](__m128i rgb, __m128i alpha) {
+            return _mm_or_si128(_mm_andnot_si128(alpha_mask, rgb),
+                                _mm_and_si128(alpha_mask, alpha));
+        };
+        return {merge(lo, other.lo), merge(hi, other.hi)};
+    }
+};
+
+#elif defined(ARCHITECTURE_ARM64)
+
+/// The 16 RGBA channels of a quad widened to 16 bits
+struct Lanes {
+    uint16x8_t lo;
+    uint16x8_t hi;
+
+    static Lanes Load(const QuadColor& color) {
+        const uint8x16_t bytes = vld1q_u8(&color[0].x);
+        return {vmovl_u8(vget_low_u8(bytes)), vmovl_high_u8(bytes)};
+    }
+
+    static Lanes FromChannels(u16 rgb, u16 a) {
+        const u16 channels[8] = {rgb, rgb, rgb, a, rgb, rgb, rgb, a};
+        const uint16x8_t value = vld1q_u16(channels);
+        return {value, value};
+    }
+
+    static Lanes Splat(u16 value) {
+        const uint16x8_t splat = vdupq_n_u16(value);
+        return {splat, splat};
+    }
+
+    void Store(QuadColor& color) const {
+        vst1q_u8(&color[0].x, vcombine_u8(vqmovn_u16(lo), vqmovn_u16(hi)));
+    }
+
+    Lanes operator+(const Lanes& other) const {
+        return {vaddq_u16(lo, other.lo), vaddq_u16(hi, other.hi)};
+    }
+
+    Lanes operator*(const Lanes& other) const {
+        return {vmulq_u16(lo, other.lo), vmulq_u16(hi, other.hi)};
+    }
+
+    template <int shift>
+    Lanes ShiftRight() const {
+        return {vshrq_n_u16(lo, shift), vshrq_n_u16(hi, shift)};
+    }
+
+    Lanes SubSaturate(const Lanes& other) const {
+        return {vqsubq_u16(lo, other.lo), vqsubq_u16(hi, other.hi)};
+    }
+
+    Lanes Min(const Lanes& other) const {
+        return {vminq_u16(lo, other.lo), vminq_u16(hi, other.hi)};
+    }
+
+    /// Takes the rgb channels from this and the alpha channels from other
+    Lanes MergeAlpha(const Lanes& other) const {
+        const u16 mask[8] = {0, 0, 0, 0xFFFF, 0, 0, 0, 0xFFFF};
+        const uint16x8_t alpha_mask = vld1q_u16(mask);
+        return {vbslq_u16(alpha_mask, other.lo, lo), vbslq_u16(alpha_mask, other.hi, hi)};
+    }
+};
+
+#else
+
+/// The 16 RGBA channels of a quad widened to 16 bits, plain loops for the compiler to vectorize
+struct Lanes {
+    std::array<u16, 16> v;
+
+    static Lanes Load(const QuadColor& color) {
+        Lanes result;
+        for (std::size_t i = 0; i < 16; ++i) {
+            result.v[i] = color[i / 4][i % 4];
+        }
+        return result;
+    }
+
+    static Lanes FromChannels(u16 rgb, u16 a) {
+        Lanes result;
+        for (std::size_t i = 0; i < 16; ++i) {
+            result.v[i] = (i % 4 == 3) ? a : rgb;
+        }
+        return result;
+    }
+
+    static Lanes Splat(u16 value) {
+        Lanes result;
+        result.v.fill(value);
+        return result;
+    }
+
+    void Store(QuadColor& color) const {
+        for (std::size_t i = 0; i < 16; ++i) {
+            color[i / 4][i % 4] = static_cast<u8>(std::min<u16>(v[i], 255));
+        }
+    }
+
+    template <typename Op>
+    Lanes Map(const Lanes& other, Op op) const {
+        Lanes result;
+        for (std::size_t i = 0; i < 16; ++i) {
+            result.v[i] = static_cast<u16>(op(v[i], other.v[i]));
+        }
+        return result;
+    }
+
+    Lanes operator+(const Lanes& other) const {
+        return Map(other, [](u16 a, u16 b) { return a + b; });
+    }
+
+    Lanes operator*(const Lanes& other) const {
+        return Map(other, [](u16 a, u16 b) { return a * b; });
+    }
+
+    template <int shift>
+    Lanes ShiftRight() const {
+        return Map(*this, [](u16 a, u16) { return a >> shift; });
+    }
+
+    Lanes SubSaturate(const Lanes& other) const {
+        return Map(other, [](u16 a, u16 b) { return a > b ? a - b : 0; });
+    }
+
+    Lanes Min(const Lanes& other) const {
+        return Map(other, [](u16 a, u16 b) { return std::min(a, b); });
+    }
+
+    /// Takes the rgb channels from this and the alpha channels from other
+    Lanes MergeAlpha(const Lanes& other) const {
+        Lanes result = *this;
+        for (std::size_t i = 3; i < 16; i += 4) {
+            result.v[i] = other.v[i];
+        }
+        return result;
+    }
+};
+
+#endif
+
+/// Exact x / 255 for 0 <= x <= 65280
+Lanes Div255(const Lanes& x) {
+    return (x + Lanes::Splat(1) + x.ShiftRight<8>()).ShiftRight<8>();
+}
+
+/**
+ * Lane-wise version of ColorCombine/AlphaCombine. All intermediate values stay within 16 bits:
+ * products are at most 255 * 255, and MultiplyThenAdd uses (a * b + 255 * c) / 255 being equal
+ * to c + (a * b) / 255.
+ */
+Lanes Combine(TevStageConfig::Operation op, const Lanes& a, const Lanes& b, const Lanes& c) {
+    using Operation = TevStageConfig::Operation;
+    const Lanes max = Lanes::Splat(255);
+
+    switch (op) {
+    case Operation::Replace:
+        return a;
+    case Operation::Modulate:
+        return Div255(a * b);
+    case Operation::Add:
+        return (a + b).Min(max);
+    case Operation::AddSigned:
+        return (a + b).SubSaturate(Lanes::Splat(128)).Min(max);
+    case Operation::Lerp:
+        return Div255(a * c + b * max.SubSaturate(c));
+    case Operation::Subtract:
+        return a.SubSaturate(b);
+    case Operation::MultiplyThenAdd:
+        return (c + Div255(a * b)).Min(max);
+    case Operation::AddThenMultiply:
+        return Div255((a + b).Min(max) * c);
+    default:
+        UNREACHABLE();
+    }
+}
+
+bool IsQuadOperation(TevStageConfig::Operation op) {
+    using Operation = TevStageConfig::Operation;
+
+    switch (op) {
+    case Operation::Replace:
+    case Operation::Modulate:
+    case Operation::Add:
+    case Operation::AddSigned:
+    case Operation::Lerp:
+    case Operation::Subtract:
+    case Operation::MultiplyThenAdd:
+    case Operation::AddThenMultiply:
+        return true;
+    default:
+        return false;
+    }
+}
+
+} // Anonymous namespace
+
+u32 EvaluateQuadCoverage(const std::array<s32, 3>& w, const std::array<s32, 3>& step_x,
+                         const std::array<s32, 3>& step_y, QuadEdgeValues& out) {
+#if defined(ARCHITECTURE_x86_64)
+    __m128i any_negative = _mm_setzero_si128();
+    for (std::size_t i = 0; i < 3; ++i) {
+        const __m128i offsets = _mm_setr_epi32(0, step_x[i], step_y[i], step_x[i] + step_y[i]);
+        const __m128i values = _mm_add_epi32(_mm_set1_epi32(w[i]), offsets);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out[i].data()), values);
+        any_negative = _mm_or_si128(any_negative, values);
+    }
+    // A pixel is covered if none of its edge functions has the sign bit set
+    return ~static_cast<u32>(_mm_movemask_ps(_mm_castsi128_ps(any_negative))) & 0xF;
+#elif defined(ARCHITECTURE_ARM64)
+    int32x4_t any_negative = vdupq_n_s32(0);
+    for (std::size_t i = 0; i < 3; ++i) {
+        const s32 offsets[QUAD_SIZE] = {0, step_x[i], step_y[i], step_x[i] + step_y[i]};
+        const int32x4_t values = vaddq_s32(vdupq_n_s32(w[i]), vld1q_s32(offsets));
+        vst1q_s32(out[i].data(), values);
+        any_negative = vorrq_s32(any_negative, values);
+    }
+    static constexpr u32 lane_bits[QUAD_SIZE] = {1, 2, 4, 8};
+    return vaddvq_u32(vandq_u32(vcgezq_s32(any_negative), vld1q_u32(lane_bits)));
+#else
+    u32 mask = 0xF;
+    for (std::size_t i = 0; i < 3; ++i) {
+        // Unsigned arithmetic to get the same wrap-around as the SIMD paths
+        const u32 base = static_cast<u32>(w[i]);
+        const u32 offsets[QUAD_SIZE] = {0, static_cast<u32>(step_x[i]), static_cast<u32>(step_y[i]),
+                                        static_cast<u32>(step_x[i]) + static_cast<u32>(step_y[i])};
+        for (std::size_t lane = 0; lane < QUAD_SIZE; ++lane) {
+            out[i][lane] = static_cast<s32>(base + offsets[lane]);
+            if (out[i][lane] < 0) {
+                mask &= ~(1u << lane);
+            }
+        }
+    }
+    return mask;
+#endif
+}
+
+bool IsQuadCombinerSupported(const TevStageConfig& stage) {
+    return IsQuadOperation(stage.color_op) && IsQuadOperation(stage.alpha_op);
+}
+
+QuadColor CombineQuad(const TevStageConfig& stage, const std::array<QuadColor, 3>& inputs) {
+    const Lanes a = Lanes::Load(inputs[0]);
+    const Lanes b = Lanes::Load(inputs[1]);
+    const Lanes c = Lanes::Load(inputs[2]);
+
+    const Lanes color = Combine(stage.color_op, a, b, c);
+    const Lanes alpha =
+        stage.alpha_op == stage.color_op ? color : Combine(stage.alpha_op, a, b, c);
+
+    const Lanes scale = Lanes::FromChannels(static_cast<u16>(stage.GetColorMultiplier()),
+                                            static_cast<u16>(stage.GetAlphaMultiplier()));
+    const Lanes result = (color.MergeAlpha(alpha) * scale).Min(Lanes::Splat(255));
+
+    QuadColor output;
+    result.Store(output);
+    return output;
+}
+
+} // namespace Pica::Rasterizer
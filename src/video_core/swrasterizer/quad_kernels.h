@@ -0,0 +1,50 @@
+// Copyright 2022 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include "common/common_types.h"
+#include "common/vector_math.h"
+#include "video_core/regs_texturing.h"
+
+namespace Pica::Rasterizer {
+
+/// Number of pixels in a 2x2 quad. Lanes are ordered (0,0), (1,0), (0,1), (1,1).
+constexpr std::size_t QUAD_SIZE = 4;
+
+/// One RGBA value per pixel of a quad
+using QuadColor = std::array<Common::Vec4<u8>, QUAD_SIZE>;
+
+/// Values of the three triangle edge functions for each pixel of a quad
+using QuadEdgeValues = std::array<std::array<s32, QUAD_SIZE>, 3>;
+
+/**
+ * Evaluates the edge functions of a triangle at the four pixels of a quad.
+ * @param w Edge function values at the top-left pixel of the quad
+ * @param step_x Increment of each edge function when moving one pixel to the right
+ * @param step_y Increment of each edge function when moving one pixel down
+ * @param out Receives the edge function values of every pixel
+ * @return Bitmask with bit i set if pixel i of the quad is covered by the triangle
+ */
+u32 EvaluateQuadCoverage(const std::array<s32, 3>& w, const std::array<s32, 3>& step_x,
+                         const std::array<s32, 3>& step_y, QuadEdgeValues& out);
+
+/**
+ * Checks whether CombineQuad can evaluate the given TEV stage. Dot3 operations are only
+ * implemented by the per-pixel ColorCombine path.
+ */
+bool IsQuadCombinerSupported(const TexturingRegs::TevStageConfig& stage);
+
+/**
+ * Evaluates the color and alpha combiner of a TEV stage for all pixels of a quad at once,
+ * including the color/alpha scale. The result is identical to running GetColorModifier,
+ * ColorCombine, AlphaCombine and the scale on every pixel separately.
+ * @param inputs Already modified combiner inputs. The rgb channels hold the color combiner input
+ *               and the alpha channel holds the alpha combiner input.
+ */
+QuadColor CombineQuad(const TexturingRegs::TevStageConfig& stage,
+                      const std::array<QuadColor, 3>& inputs);
+
+} // namespace Pica::Rasterizer
@@ -5,12 +5,16 @@
 #include <algorithm>
 #include <array>
 #include <cmath>
+#include <memory>
+#include <optional>
 #include <tuple>
+#include <boost/container/static_vector.hpp>
 #include "common/assert.h"
 #include "common/bit_field.h"
 #include "common/color.h"
 #include "common/common_types.h"
 #include "common/logging/log.h"
+#include "common/math_util.h"
 #include "common/microprofile.h"
 #include "common/quaternion.h"
 #include "common/vector_math.h"
@@ -27,6 +31,8 @@
 #include "video_core/swrasterizer/lighting.h"
 #include "video_core/swrasterizer/proctex.h"
 #include "video_core/swrasterizer/rasterizer.h"
+#include "video_core/swrasterizer/tev_program.h"
+#include "video_core/swrasterizer/texture_cache.h"
 #include "video_core/swrasterizer/texturing.h"
 #include "video_core/texture/texture_decode.h"
 #include "video_core/utils.h"
@@ -117,27 +123,99 @@ static std::tuple<float24, float24, float24, PAddr> ConvertCubeCoord(float24 u,
     return std::make_tuple(x / z * half + half, y / z * half + half, z_abs, addr);
 }
 
+/**
+ * Applies the texture type of unit 0 to its texture coordinates, w being the interpolated third
+ * coordinate. Returns the depth compared against shadow textures and, for cube maps, sets the
+ * address to the one of the sampled face.
+ */
+using ProjectTexCoordFunc = float24 (*)(float24& u, float24& v, float24 w, PAddr& address,
+                                        const TexturingRegs& regs);
+
+template <TexturingRegs::TextureConfig::TextureType type, bool orthographic = false>
+static float24 ProjectTexCoord(float24& u, float24& v, float24 w, PAddr& address,
+                               const TexturingRegs& regs) {
+    float24 shadow_z;
+    if constexpr (type == TexturingRegs::TextureConfig::TextureCube ||
+                  type == TexturingRegs::TextureConfig::ShadowCube) {
+        std::tie(u, v, shadow_z, address) = ConvertCubeCoord(u, v, w, regs);
+    } else if constexpr (type == TexturingRegs::TextureConfig::Projection2D) {
+        u /= w;
+        v /= w;
+    } else if constexpr (type == TexturingRegs::TextureConfig::Shadow2D) {
+        if constexpr (!orthographic) {
+            u /= w;
+            v /= w;
+        }
+        shadow_z = float24::FromFloat32(std::abs(w.ToFloat32()));
+    }
+    return shadow_z;
+}
+
+/// Blends the fog color into the combiner output by the fog factor at the given depth
+template <bool flip>
+static void ApplyFog(Common::Vec4<u8>& combiner_output, float depth,
+                     const Common::Vec3<u8>& fog_color) {
+    // Not fully accurate. We'd have to know what data type is used to
+    // store the depth etc. Using float for now until we know more
+    // about Pica datatypes
+
+    // Get index into fog LUT
+    float fog_index;
+    if constexpr (flip) {
+        fog_index = (1.0f - depth) * 128.0f;
+    } else {
+        fog_index = depth * 128.0f;
+    }
+
+    // Generate clamped fog factor from LUT for given fog index
+    float fog_i = std::clamp(floorf(fog_index), 0.0f, 127.0f);
+    float fog_f = fog_index - fog_i;
+    const auto& fog_lut_entry = g_state.fog.lut[static_cast<unsigned int>(fog_i)];
+    float fog_factor = fog_lut_entry.ToFloat() + fog_lut_entry.DiffToFloat() * fog_f;
+    fog_factor = std::clamp(fog_factor, 0.0f, 1.0f);
+
+    // Blend the fog
+    for (unsigned i = 0; i < 3; i++) {
+        combiner_output[i] = static_cast<u8>(fog_factor * combiner_output[i] +
+                                             (1.0f - fog_factor) * fog_color[i]);
+    }
+}
+
+using FogFunc = void (*)(Common::Vec4<u8>& combiner_output, float depth,
+                         const Common::Vec3<u8>& fog_color);
+
+static Fix12P4 FloatToFix(float24 flt) {
+    // TODO: Rounding here is necessary to prevent garbage pixels at
+    //       triangle borders. Is it that the correct solution, though?
+    return Fix12P4(static_cast<unsigned short>(round(flt.ToFloat32() * 16.0f)));
+}
+
+static Common::Vec3<Fix12P4> ScreenToRasterizerCoordinates(const Common::Vec3<float24>& vec) {
+    return Common::Vec3<Fix12P4>{FloatToFix(vec.x), FloatToFix(vec.y), FloatToFix(vec.z)};
+}
+
+/// Per-pixel state passed between the stages of the fragment pipeline
+struct Fragment {
+    u16 x;
+    u16 y;
+    float depth;
+    TevInputs tev_inputs;
+    Common::Vec4<u8> combiner_output;
+};
+
 MICROPROFILE_DEFINE(GPU_Rasterization, "GPU", "Rasterization", MP_RGB(50, 50, 240));
 
 /**
  * Helper function for ProcessTriangle with the "reversed" flag to allow for implementing
- * culling via recursion.
+ * culling via recursion. Only pixels inside the given tile are rasterized.
  */
 static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Vertex& v2,
-                                    bool reversed = false) {
+                                    TextureCache& texture_cache,
+                                    const Common::Rectangle<u16>& tile, bool reversed = false) {
     const auto& regs = g_state.regs;
     MICROPROFILE_SCOPE(GPU_Rasterization);
 
     // vertex positions in rasterizer coordinates
-    static auto FloatToFix = [](float24 flt) {
-        // TODO: Rounding here is necessary to prevent garbage pixels at
-        //       triangle borders. Is it that the correct solution, though?
-        return Fix12P4(static_cast<unsigned short>(round(flt.ToFloat32() * 16.0f)));
-    };
-    static auto ScreenToRasterizerCoordinates = [](const Common::Vec3<float24>& vec) {
-        return Common::Vec3<Fix12P4>{FloatToFix(vec.x), FloatToFix(vec.y), FloatToFix(vec.z)};
-    };
-
     Common::Vec3<Fix12P4> vtxpos[3]{ScreenToRasterizerCoordinates(v0.screenpos),
                                     ScreenToRasterizerCoordinates(v1.screenpos),
                                     ScreenToRasterizerCoordinates(v2.screenpos)};
@@ -145,13 +223,13 @@ static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Ve
     if (regs.rasterizer.cull_mode == RasterizerRegs::CullMode::KeepAll) {
         // Make sure we always end up with a triangle wound counter-clockwise
         if (!reversed && SignedArea(vtxpos[0].xy(), vtxpos[1].xy(), vtxpos[2].xy()) <= 0) {
-            ProcessTriangleInternal(v0, v2, v1, true);
+            ProcessTriangleInternal(v0, v2, v1, texture_cache, tile, true);
             return;
         }
     } else {
         if (!reversed && regs.rasterizer.cull_mode == RasterizerRegs::CullMode::KeepClockWise) {
             // Reverse vertex order and use the CCW code path.
-            ProcessTriangleInternal(v0, v2, v1, true);
+            ProcessTriangleInternal(v0, v2, v1, texture_cache, tile, true);
             return;
         }
 
@@ -185,6 +263,12 @@ static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Ve
     max_x = ((max_x + Fix12P4::FracMask()) & Fix12P4::IntMask());
     max_y = ((max_y + Fix12P4::FracMask()) & Fix12P4::IntMask());
 
+    // Restrict the bounding box to the tile this invocation is responsible for
+    min_x = static_cast<u16>(std::max<u32>(min_x, tile.left * 16u));
+    min_y = static_cast<u16>(std::max<u32>(min_y, tile.top * 16u));
+    max_x = static_cast<u16>(std::min<u32>(max_x, tile.right * 16u));
+    max_y = static_cast<u16>(std::min<u32>(max_y, tile.bottom * 16u));
+
     // Triangle filling rules: Pixels on the right-sided edge or on flat bottom edges are not
     // drawn. Pixels on any other triangle border are drawn. This is implemented with three bias
     // values which are added to the barycentric coordinates w0, w1 and w2, respectively.
@@ -212,690 +296,555 @@ static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Ve
 
     auto w_inverse = Common::MakeVec(v0.pos.w, v1.pos.w, v2.pos.w);
 
-    auto textures = regs.texturing.GetTextures();
-    auto tev_stages = regs.texturing.GetTevStages();
-
-    bool stencil_action_enable =
-        g_state.regs.framebuffer.output_merger.stencil_test.enable &&
-        g_state.regs.framebuffer.framebuffer.depth_format == FramebufferRegs::DepthFormat::D24S8;
-    const auto stencil_test = g_state.regs.framebuffer.output_merger.stencil_test;
+    // Depth state, decoded once per triangle like all of the register state below
+    const float depth_scale = float24::FromRaw(regs.rasterizer.viewport_depth_range).ToFloat32();
+    const float depth_offset =
+        float24::FromRaw(regs.rasterizer.viewport_depth_near_plane).ToFloat32();
+    const bool w_buffering =
+        regs.rasterizer.depthmap_enable == RasterizerRegs::DepthBuffering::WBuffering;
+
+    struct TextureUnit {
+        bool enabled;
+        /// Units without an address sample black
+        bool has_address;
+        std::size_t coordinate_index;
+        /// Applies the texture type, null if the coordinates are used as they are
+        ProjectTexCoordFunc project;
+        bool shadow;
+        u32 shadow_bias;
+        unsigned width;
+        unsigned height;
+        float24 float_width;
+        float24 float_height;
+        WrapTexCoordFunc wrap_s;
+        WrapTexCoordFunc wrap_t;
+        Common::Vec4<u8> border_color;
+        Texture::TextureInfo info;
+    };
+    const auto textures = regs.texturing.GetTextures();
+    std::array<TextureUnit, 3> texture_units{};
+    for (std::size_t i = 0; i < texture_units.size(); ++i) {
+        const auto& texture = textures[i];
+        auto& unit = texture_units[i];
+        unit.enabled = texture.enabled;
+        if (!unit.enabled) {
+            continue;
+        }
 
-    // Enter rasterization loop, starting at the center of the topleft bounding box corner.
-    // TODO: Not sure if looping through x first might be faster
-    for (u16 y = min_y + 8; y < max_y; y += 0x10) {
-        for (u16 x = min_x + 8; x < max_x; x += 0x10) {
-
-            // Do not process the pixel if it's inside the scissor box and the scissor mode is set
-            // to Exclude
-            if (regs.rasterizer.scissor_test.mode == RasterizerRegs::ScissorMode::Exclude) {
-                if (x >= scissor_x1 && x < scissor_x2 && y >= scissor_y1 && y < scissor_y2)
-                    continue;
+        unit.has_address = texture.config.address != 0;
+        unit.coordinate_index = (i == 2 && regs.texturing.main_config.texture2_use_coord1) ? 1 : i;
+
+        // Only unit 0 respects the texturing type (according to 3DBrew)
+        // TODO: Refactor so cubemaps and shadowmaps can be handled
+        if (i == 0) {
+            switch (texture.config.type) {
+            case TexturingRegs::TextureConfig::Texture2D:
+                break;
+            case TexturingRegs::TextureConfig::TextureCube:
+                unit.project = &ProjectTexCoord<TexturingRegs::TextureConfig::TextureCube>;
+                break;
+            case TexturingRegs::TextureConfig::ShadowCube:
+                unit.project = &ProjectTexCoord<TexturingRegs::TextureConfig::ShadowCube>;
+                unit.shadow = true;
+                break;
+            case TexturingRegs::TextureConfig::Projection2D:
+                unit.project = &ProjectTexCoord<TexturingRegs::TextureConfig::Projection2D>;
+                break;
+            case TexturingRegs::TextureConfig::Shadow2D:
+                unit.project =
+                    regs.texturing.shadow.orthographic
+                        ? &ProjectTexCoord<TexturingRegs::TextureConfig::Shadow2D, true>
+                        : &ProjectTexCoord<TexturingRegs::TextureConfig::Shadow2D, false>;
+                unit.shadow = true;
+                break;
+            case TexturingRegs::TextureConfig::Disabled:
+                // A unit without an address still samples black
+                unit.enabled = !unit.has_address;
+                break;
+            default:
+                LOG_ERROR(HW_GPU, "Unhandled texture type {:x}", (int)texture.config.type);
+                UNIMPLEMENTED();
+                break;
             }
+        }
 
-            // Calculate the barycentric coordinates w0, w1 and w2
-            int w0 = bias0 + SignedArea(vtxpos[1].xy(), vtxpos[2].xy(), {x, y});
-            int w1 = bias1 + SignedArea(vtxpos[2].xy(), vtxpos[0].xy(), {x, y});
-            int w2 = bias2 + SignedArea(vtxpos[0].xy(), vtxpos[1].xy(), {x, y});
-            int wsum = w0 + w1 + w2;
+        unit.shadow_bias = regs.texturing.shadow.bias << 1;
+        unit.width = texture.config.width;
+        unit.height = texture.config.height;
+        unit.float_width = float24::FromFloat32(static_cast<float>(unit.width));
+        unit.float_height = float24::FromFloat32(static_cast<float>(unit.height));
+        unit.wrap_s = GetWrapTexCoordFunc(texture.config.wrap_s);
+        unit.wrap_t = GetWrapTexCoordFunc(texture.config.wrap_t);
+        const auto border_color = texture.config.border_color;
+        unit.border_color = Common::MakeVec(border_color.r.Value(), border_color.g.Value(),
+                                            border_color.b.Value(), border_color.a.Value())
+                                .Cast<u8>();
+        unit.info = Texture::TextureInfo::FromPicaRegister(texture.config, texture.format);
+    }
 
-            // If current pixel is not covered by the current primitive
-            if (w0 < 0 || w1 < 0 || w2 < 0)
-                continue;
+    const bool proctex_enable = regs.texturing.main_config.texture3_enable != 0;
+    const std::size_t proctex_coordinates = regs.texturing.main_config.texture3_coordinates;
 
-            auto baricentric_coordinates =
-                Common::MakeVec(float24::FromFloat32(static_cast<float>(w0)),
-                                float24::FromFloat32(static_cast<float>(w1)),
-                                float24::FromFloat32(static_cast<float>(w2)));
-            float24 interpolated_w_inverse =
-                float24::FromFloat32(1.0f) / Common::Dot(w_inverse, baricentric_coordinates);
-
-            // interpolated_z = z / w
-            float interpolated_z_over_w =
-                (v0.screenpos[2].ToFloat32() * w0 + v1.screenpos[2].ToFloat32() * w1 +
-                 v2.screenpos[2].ToFloat32() * w2) /
-                wsum;
-
-            // Not fully accurate. About 3 bits in precision are missing.
-            // Z-Buffer (z / w * scale + offset)
-            float depth_scale = float24::FromRaw(regs.rasterizer.viewport_depth_range).ToFloat32();
-            float depth_offset =
-                float24::FromRaw(regs.rasterizer.viewport_depth_near_plane).ToFloat32();
-            float depth = interpolated_z_over_w * depth_scale + depth_offset;
-
-            // Potentially switch to W-Buffer
-            if (regs.rasterizer.depthmap_enable ==
-                Pica::RasterizerRegs::DepthBuffering::WBuffering) {
-                // W-Buffer (z * scale + w * offset = (z / w * scale + offset) * w)
-                depth *= interpolated_w_inverse.ToFloat32() * wsum;
+    // Lighting LUT configuration and the rest of the lighting registers
+    std::optional<DecodedLighting> lighting;
+    if (!regs.lighting.disable) {
+        lighting.emplace(regs.lighting);
+    }
+
+    // All texture environment state is decoded once per configuration instead of per pixel
+    const TevProgram& tev_program = GetTevProgram(regs.texturing);
+
+    FogFunc fog = nullptr;
+    if (regs.texturing.fog_mode == TexturingRegs::FogMode::Fog) {
+        fog = regs.texturing.fog_flip ? &ApplyFog<true> : &ApplyFog<false>;
+    }
+    const Common::Vec3<u8> fog_color =
+        Common::MakeVec(regs.texturing.fog_color.r.Value(), regs.texturing.fog_color.g.Value(),
+                        regs.texturing.fog_color.b.Value())
+            .Cast<u8>();
+
+    const auto& output_merger = regs.framebuffer.output_merger;
+    const auto& framebuffer = regs.framebuffer.framebuffer;
+    const bool shadow_mode =
+        output_merger.fragment_operation_mode == FramebufferRegs::FragmentOperationMode::Shadow;
+    const bool stencil_action_enable =
+        output_merger.stencil_test.enable &&
+        framebuffer.depth_format == FramebufferRegs::DepthFormat::D24S8;
+    const auto stencil_test = output_merger.stencil_test;
+    const bool depth_stencil_write = framebuffer.allow_depth_stencil_write != 0;
+    const bool depth_write = depth_stencil_write && output_merger.depth_write_enable;
+    const bool color_write = framebuffer.allow_color_write != 0;
+    const unsigned num_depth_bits = FramebufferRegs::DepthBitsPerPixel(framebuffer.depth_format);
+    const std::array<bool, 4> color_mask{
+        output_merger.red_enable != 0, output_merger.green_enable != 0,
+        output_merger.blue_enable != 0, output_merger.alpha_enable != 0};
+
+    // The same goes for the comparisons and blend operations of the output merger
+    const CompareTestFunc alpha_test = GetCompareTestFunc(output_merger.alpha_test.func);
+    const CompareTestFunc stencil_compare = GetCompareTestFunc(stencil_test.func);
+    const StencilActionFunc stencil_fail_action =
+        GetStencilActionFunc(stencil_test.action_stencil_fail);
+    const StencilActionFunc depth_fail_action =
+        GetStencilActionFunc(stencil_test.action_depth_fail);
+    const StencilActionFunc depth_pass_action =
+        GetStencilActionFunc(stencil_test.action_depth_pass);
+    const CompareTestFunc depth_test = GetCompareTestFunc(output_merger.depth_test_func);
+    const auto& blending = output_merger.alpha_blending;
+    const BlendFactorFunc source_rgb_factor = GetBlendFactorFunc(blending.factor_source_rgb);
+    const BlendFactorFunc source_a_factor = GetBlendFactorFunc(blending.factor_source_a);
+    const BlendFactorFunc dest_rgb_factor = GetBlendFactorFunc(blending.factor_dest_rgb);
+    const BlendFactorFunc dest_a_factor = GetBlendFactorFunc(blending.factor_dest_a);
+    const BlendEquationFunc blend_equation_rgb = GetBlendEquationFunc(blending.blend_equation_rgb);
+    const BlendEquationFunc blend_equation_a = GetBlendEquationFunc(blending.blend_equation_a);
+    const LogicOpFunc logic_op = GetLogicOpFunc(output_merger.logic_op);
+    const Common::Vec4<u8> blend_const =
+        Common::MakeVec(output_merger.blend_const.r.Value(), output_merger.blend_const.g.Value(),
+                        output_merger.blend_const.b.Value(), output_merger.blend_const.a.Value())
+            .Cast<u8>();
+
+    // Decoded textures are looked up once per triangle, on first use. Cube maps can sample a
+    // different face per pixel, so each unit remembers up to one texture per face.
+    struct ResolvedTexture {
+        PAddr address;
+        std::shared_ptr<const DecodedTexture> texture;
+    };
+    std::array<boost::container::static_vector<ResolvedTexture, 6>, 3> resolved_textures;
+    auto GetDecodedTexture = [&](std::size_t unit,
+                                 const Texture::TextureInfo& info) -> const DecodedTexture* {
+        auto& resolved = resolved_textures[unit];
+        for (const ResolvedTexture& entry : resolved) {
+            if (entry.address == info.physical_address) {
+                return entry.texture.get();
             }
+        }
+        if (resolved.size() == resolved.capacity()) {
+            resolved.clear();
+        }
+        resolved.push_back({info.physical_address, texture_cache.GetTexture(info)});
+        return resolved.back().texture.get();
+    };
 
-            // Clamp the result
-            depth = std::clamp(depth, 0.0f, 1.0f);
-
-            // Perspective correct attribute interpolation:
-            // Attribute values cannot be calculated by simple linear interpolation since
-            // they are not linear in screen space. For example, when interpolating a
-            // texture coordinate across two vertices, something simple like
-            //     u = (u0*w0 + u1*w1)/(w0+w1)
-            // will not work. However, the attribute value divided by the
-            // clipspace w-coordinate (u/w) and and the inverse w-coordinate (1/w) are linear
-            // in screenspace. Hence, we can linearly interpolate these two independently and
-            // calculate the interpolated attribute by dividing the results.
-            // I.e.
-            //     u_over_w   = ((u0/v0.pos.w)*w0 + (u1/v1.pos.w)*w1)/(w0+w1)
-            //     one_over_w = (( 1/v0.pos.w)*w0 + ( 1/v1.pos.w)*w1)/(w0+w1)
-            //     u = u_over_w / one_over_w
-            //
-            // The generalization to three vertices is straightforward in baricentric coordinates.
-            auto GetInterpolatedAttribute = [&](float24 attr0, float24 attr1, float24 attr2) {
-                auto attr_over_w = Common::MakeVec(attr0, attr1, attr2);
-                float24 interpolated_attr_over_w =
-                    Common::Dot(attr_over_w, baricentric_coordinates);
-                return interpolated_attr_over_w * interpolated_w_inverse;
-            };
+    // Interpolates the vertex attributes at a pixel and computes all TEV inputs from them, i.e.
+    // the primary color, the texture colors and the fragment lighting colors
+    auto ShadeFragment = [&](Fragment& fragment, int w0, int w1, int w2) {
+        int wsum = w0 + w1 + w2;
+
+        auto baricentric_coordinates =
+            Common::MakeVec(float24::FromFloat32(static_cast<float>(w0)),
+                            float24::FromFloat32(static_cast<float>(w1)),
+                            float24::FromFloat32(static_cast<float>(w2)));
+        float24 interpolated_w_inverse =
+            float24::FromFloat32(1.0f) / Common::Dot(w_inverse, baricentric_coordinates);
+
+        // interpolated_z = z / w
+        float interpolated_z_over_w =
+            (v0.screenpos[2].ToFloat32() * w0 + v1.screenpos[2].ToFloat32() * w1 +
+             v2.screenpos[2].ToFloat32() * w2) /
+            wsum;
+
+        // Not fully accurate. About 3 bits in precision are missing.
+        // Z-Buffer (z / w * scale + offset)
+        float& depth = fragment.depth;
+        depth = interpolated_z_over_w * depth_scale + depth_offset;
+
+        // Potentially switch to W-Buffer
+        if (w_buffering) {
+            // W-Buffer (z * scale + w * offset = (z / w * scale + offset) * w)
+            depth *= interpolated_w_inverse.ToFloat32() * wsum;
+        }
 
-            Common::Vec4<u8> primary_color{
-                static_cast<u8>(round(
-                    GetInterpolatedAttribute(v0.color.r(), v1.color.r(), v2.color.r()).ToFloat32() *
-                    255)),
-                static_cast<u8>(round(
-                    GetInterpolatedAttribute(v0.color.g(), v1.color.g(), v2.color.g()).ToFloat32() *
-                    255)),
-                static_cast<u8>(round(
-                    GetInterpolatedAttribute(v0.color.b(), v1.color.b(), v2.color.b()).ToFloat32() *
-                    255)),
-                static_cast<u8>(round(
-                    GetInterpolatedAttribute(v0.color.a(), v1.color.a(), v2.color.a()).ToFloat32() *
-                    255)),
-            };
+        // Clamp the result
+        depth = std::clamp(depth, 0.0f, 1.0f);
+
+        // Perspective correct attribute interpolation:
+        // Attribute values cannot be calculated by simple linear interpolation since
+        // they are not linear in screen space. For example, when interpolating a
+        // texture coordinate across two vertices, something simple like
+        //     u = (u0*w0 + u1*w1)/(w0+w1)
+        // will not work. However, the attribute value divided by the
+        // clipspace w-coordinate (u/w) and and the inverse w-coordinate (1/w) are linear
+        // in screenspace. Hence, we can linearly interpolate these two independently and
+        // calculate the interpolated attribute by dividing the results.
+        // I.e.
+        //     u_over_w   = ((u0/v0.pos.w)*w0 + (u1/v1.pos.w)*w1)/(w0+w1)
+        //     one_over_w = (( 1/v0.pos.w)*w0 + ( 1/v1.pos.w)*w1)/(w0+w1)
+        //     u = u_over_w / one_over_w
+        //
+        // The generalization to three vertices is straightforward in baricentric coordinates.
+        auto GetInterpolatedAttribute = [&](float24 attr0, float24 attr1, float24 attr2) {
+            auto attr_over_w = Common::MakeVec(attr0, attr1, attr2);
+            float24 interpolated_attr_over_w =
+                Common::Dot(attr_over_w, baricentric_coordinates);
+            return interpolated_attr_over_w * interpolated_w_inverse;
+        };
+
+        auto& primary_color = fragment.tev_inputs.primary_color;
+        primary_color = {
+            static_cast<u8>(round(
+                GetInterpolatedAttribute(v0.color.r(), v1.color.r(), v2.color.r()).ToFloat32() *
+                255)),
+            static_cast<u8>(round(
+                GetInterpolatedAttribute(v0.color.g(), v1.color.g(), v2.color.g()).ToFloat32() *
+                255)),
+            static_cast<u8>(round(
+                GetInterpolatedAttribute(v0.color.b(), v1.color.b(), v2.color.b()).ToFloat32() *
+                255)),
+            static_cast<u8>(round(
+                GetInterpolatedAttribute(v0.color.a(), v1.color.a(), v2.color.a()).ToFloat32() *
+                255)),
+        };
+
+        Common::Vec2<float24> uv[3];
+        uv[0].u() = GetInterpolatedAttribute(v0.tc0.u(), v1.tc0.u(), v2.tc0.u());
+        uv[0].v() = GetInterpolatedAttribute(v0.tc0.v(), v1.tc0.v(), v2.tc0.v());
+        uv[1].u() = GetInterpolatedAttribute(v0.tc1.u(), v1.tc1.u(), v2.tc1.u());
+        uv[1].v() = GetInterpolatedAttribute(v0.tc1.v(), v1.tc1.v(), v2.tc1.v());
+        uv[2].u() = GetInterpolatedAttribute(v0.tc2.u(), v1.tc2.u(), v2.tc2.u());
+        uv[2].v() = GetInterpolatedAttribute(v0.tc2.v(), v1.tc2.v(), v2.tc2.v());
+
+        auto& texture_color = fragment.tev_inputs.texture_color;
+        for (std::size_t i = 0; i < texture_units.size(); ++i) {
+            const TextureUnit& unit = texture_units[i];
+            if (!unit.enabled)
+                continue;
 
-            Common::Vec2<float24> uv[3];
-            uv[0].u() = GetInterpolatedAttribute(v0.tc0.u(), v1.tc0.u(), v2.tc0.u());
-            uv[0].v() = GetInterpolatedAttribute(v0.tc0.v(), v1.tc0.v(), v2.tc0.v());
-            uv[1].u() = GetInterpolatedAttribute(v0.tc1.u(), v1.tc1.u(), v2.tc1.u());
-            uv[1].v() = GetInterpolatedAttribute(v0.tc1.v(), v1.tc1.v(), v2.tc1.v());
-            uv[2].u() = GetInterpolatedAttribute(v0.tc2.u(), v1.tc2.u(), v2.tc2.u());
-            uv[2].v() = GetInterpolatedAttribute(v0.tc2.v(), v1.tc2.v(), v2.tc2.v());
-
-            Common::Vec4<u8> texture_color[4]{};
-            for (int i = 0; i < 3; ++i) {
-                const auto& texture = textures[i];
-                if (!texture.enabled)
-                    continue;
-
-                if (texture.config.address == 0) {
-                    texture_color[i] = {0, 0, 0, 255};
-                    continue;
-                }
+            if (!unit.has_address) {
+                texture_color[i] = {0, 0, 0, 255};
+                continue;
+            }
 
-                int coordinate_i =
-                    (i == 2 && regs.texturing.main_config.texture2_use_coord1) ? 1 : i;
-                float24 u = uv[coordinate_i].u();
-                float24 v = uv[coordinate_i].v();
-
-                // Only unit 0 respects the texturing type (according to 3DBrew)
-                // TODO: Refactor so cubemaps and shadowmaps can be handled
-                PAddr texture_address = texture.config.GetPhysicalAddress();
-                float24 shadow_z;
-                if (i == 0) {
-                    switch (texture.config.type) {
-                    case TexturingRegs::TextureConfig::Texture2D:
-                        break;
-                    case TexturingRegs::TextureConfig::ShadowCube:
-                    case TexturingRegs::TextureConfig::TextureCube: {
-                        auto w = GetInterpolatedAttribute(v0.tc0_w, v1.tc0_w, v2.tc0_w);
-                        std::tie(u, v, shadow_z, texture_address) =
-                            ConvertCubeCoord(u, v, w, regs.texturing);
-                        break;
-                    }
-                    case TexturingRegs::TextureConfig::Projection2D: {
-                        auto tc0_w = GetInterpolatedAttribute(v0.tc0_w, v1.tc0_w, v2.tc0_w);
-                        u /= tc0_w;
-                        v /= tc0_w;
-                        break;
-                    }
-                    case TexturingRegs::TextureConfig::Shadow2D: {
-                        auto tc0_w = GetInterpolatedAttribute(v0.tc0_w, v1.tc0_w, v2.tc0_w);
-                        if (!regs.texturing.shadow.orthographic) {
-                            u /= tc0_w;
-                            v /= tc0_w;
-                        }
-
-                        shadow_z = float24::FromFloat32(std::abs(tc0_w.ToFloat32()));
-                        break;
-                    }
-                    case TexturingRegs::TextureConfig::Disabled:
-                        continue; // skip this unit and continue to the next unit
-                    default:
-                        LOG_ERROR(HW_GPU, "Unhandled texture type {:x}", (int)texture.config.type);
-                        UNIMPLEMENTED();
-                        break;
-                    }
-                }
+            float24 u = uv[unit.coordinate_index].u();
+            float24 v = uv[unit.coordinate_index].v();
 
-                int s = (int)(u * float24::FromFloat32(static_cast<float>(texture.config.width)))
-                            .ToFloat32();
-                int t = (int)(v * float24::FromFloat32(static_cast<float>(texture.config.height)))
-                            .ToFloat32();
+            PAddr texture_address = unit.info.physical_address;
+            float24 shadow_z;
+            if (unit.project) {
+                const float24 w = GetInterpolatedAttribute(v0.tc0_w, v1.tc0_w, v2.tc0_w);
+                shadow_z = unit.project(u, v, w, texture_address, regs.texturing);
+            }
 
-                bool use_border_s = false;
-                bool use_border_t = false;
+            int s = (int)(u * unit.float_width).ToFloat32();
+            int t = (int)(v * unit.float_height).ToFloat32();
 
-                if (texture.config.wrap_s == TexturingRegs::TextureConfig::ClampToBorder) {
-                    use_border_s = s < 0 || s >= static_cast<int>(texture.config.width);
-                } else if (texture.config.wrap_s == TexturingRegs::TextureConfig::ClampToBorder2) {
-                    use_border_s = s >= static_cast<int>(texture.config.width);
-                }
+            s = unit.wrap_s(s, unit.width);
+            t = unit.wrap_t(t, unit.height);
 
-                if (texture.config.wrap_t == TexturingRegs::TextureConfig::ClampToBorder) {
-                    use_border_t = t < 0 || t >= static_cast<int>(texture.config.height);
-                } else if (texture.config.wrap_t == TexturingRegs::TextureConfig::ClampToBorder2) {
-                    use_border_t = t >= static_cast<int>(texture.config.height);
+            if (s < 0 || t < 0) {
+                texture_color[i] = unit.border_color;
+            } else {
+                // Textures are laid out from bottom to top, hence we invert the t coordinate.
+                // NOTE: This may not be the right place for the inversion.
+                // TODO: Check if this applies to ETC textures, too.
+                t = unit.height - 1 - t;
+
+                // Cube map faces share the configuration of the first face
+                Texture::TextureInfo face_info;
+                const Texture::TextureInfo* info = &unit.info;
+                if (texture_address != unit.info.physical_address) {
+                    face_info = unit.info;
+                    face_info.physical_address = texture_address;
+                    info = &face_info;
                 }
 
-                if (use_border_s || use_border_t) {
-                    auto border_color = texture.config.border_color;
-                    texture_color[i] =
-                        Common::MakeVec(border_color.r.Value(), border_color.g.Value(),
-                                        border_color.b.Value(), border_color.a.Value())
-                            .Cast<u8>();
+                // TODO: Apply the min and mag filters to the texture
+                if (const DecodedTexture* decoded = GetDecodedTexture(i, *info)) {
+                    texture_color[i] = decoded->Lookup(s, t);
                 } else {
-                    // Textures are laid out from bottom to top, hence we invert the t coordinate.
-                    // NOTE: This may not be the right place for the inversion.
-                    // TODO: Check if this applies to ETC textures, too.
-                    s = GetWrappedTexCoord(texture.config.wrap_s, s, texture.config.width);
-                    t = texture.config.height - 1 -
-                        GetWrappedTexCoord(texture.config.wrap_t, t, texture.config.height);
-
                     const u8* texture_data =
                         VideoCore::g_memory->GetPhysicalPointer(texture_address);
-                    auto info =
-                        Texture::TextureInfo::FromPicaRegister(texture.config, texture.format);
-
-                    // TODO: Apply the min and mag filters to the texture
-                    texture_color[i] = Texture::LookupTexture(texture_data, s, t, info);
+                    texture_color[i] = Texture::LookupTexture(texture_data, s, t, *info);
                 }
-
-                if (i == 0 && (texture.config.type == TexturingRegs::TextureConfig::Shadow2D ||
-                               texture.config.type == TexturingRegs::TextureConfig::ShadowCube)) {
-
-                    s32 z_int = static_cast<s32>(std::min(shadow_z.ToFloat32(), 1.0f) * 0xFFFFFF);
-                    z_int -= regs.texturing.shadow.bias << 1;
-                    auto& color = texture_color[i];
-                    s32 z_ref = (color.w << 16) | (color.z << 8) | color.y;
-                    u8 density;
-                    if (z_ref >= z_int) {
-                        density = color.x;
-                    } else {
-                        density = 0;
-                    }
-                    texture_color[i] = {density, density, density, density};
-                }
-            }
-
-            // sample procedural texture
-            if (regs.texturing.main_config.texture3_enable) {
-                const auto& proctex_uv = uv[regs.texturing.main_config.texture3_coordinates];
-                texture_color[3] = ProcTex(proctex_uv.u().ToFloat32(), proctex_uv.v().ToFloat32(),
-                                           g_state.regs.texturing, g_state.proctex);
             }
 
-            // Texture environment - consists of 6 stages of color and alpha combining.
-            //
-            // Color combiners take three input color values from some source (e.g. interpolated
-            // vertex color, texture color, previous stage, etc), perform some very simple
-            // operations on each of them (e.g. inversion) and then calculate the output color
-            // with some basic arithmetic. Alpha combiners can be configured separately but work
-            // analogously.
-            Common::Vec4<u8> combiner_output;
-            Common::Vec4<u8> combiner_buffer = {0, 0, 0, 0};
-            Common::Vec4<u8> next_combiner_buffer =
-                Common::MakeVec(regs.texturing.tev_combiner_buffer_color.r.Value(),
-                                regs.texturing.tev_combiner_buffer_color.g.Value(),
-                                regs.texturing.tev_combiner_buffer_color.b.Value(),
-                                regs.texturing.tev_combiner_buffer_color.a.Value())
-                    .Cast<u8>();
-
-            Common::Vec4<u8> primary_fragment_color = {0, 0, 0, 0};
-            Common::Vec4<u8> secondary_fragment_color = {0, 0, 0, 0};
-
-            if (!g_state.regs.lighting.disable) {
-                Common::Quaternion<float> normquat =
-                    Common::Quaternion<float>{
-                        {GetInterpolatedAttribute(v0.quat.x, v1.quat.x, v2.quat.x).ToFloat32(),
-                         GetInterpolatedAttribute(v0.quat.y, v1.quat.y, v2.quat.y).ToFloat32(),
-                         GetInterpolatedAttribute(v0.quat.z, v1.quat.z, v2.quat.z).ToFloat32()},
-                        GetInterpolatedAttribute(v0.quat.w, v1.quat.w, v2.quat.w).ToFloat32(),
-                    }
-                        .Normalized();
-
-                Common::Vec3<float> view{
-                    GetInterpolatedAttribute(v0.view.x, v1.view.x, v2.view.x).ToFloat32(),
-                    GetInterpolatedAttribute(v0.view.y, v1.view.y, v2.view.y).ToFloat32(),
-                    GetInterpolatedAttribute(v0.view.z, v1.view.z, v2.view.z).ToFloat32(),
-                };
-                std::tie(primary_fragment_color, secondary_fragment_color) = ComputeFragmentsColors(
-                    g_state.regs.lighting, g_state.lighting, normquat, view, texture_color);
+            if (unit.shadow) {
+                s32 z_int = static_cast<s32>(std::min(shadow_z.ToFloat32(), 1.0f) * 0xFFFFFF);
+                z_int -= unit.shadow_bias;
+                auto& color = texture_color[i];
+                s32 z_ref = (color.w << 16) | (color.z << 8) | color.y;
+                u8 density;
+                if (z_ref >= z_int) {
+                    density = color.x;
+                } else {
+                    density = 0;
+                }
+                texture_color[i] = {density, density, density, density};
             }
+        }
 
-            for (unsigned tev_stage_index = 0; tev_stage_index < tev_stages.size();
-                 ++tev_stage_index) {
-                const auto& tev_stage = tev_stages[tev_stage_index];
-                using Source = TexturingRegs::TevStageConfig::Source;
-
-                auto GetSource = [&](Source source) -> Common::Vec4<u8> {
-                    switch (source) {
-                    case Source::PrimaryColor:
-                        return primary_color;
-
-                    case Source::PrimaryFragmentColor:
-                        return primary_fragment_color;
-
-                    case Source::SecondaryFragmentColor:
-                        return secondary_fragment_color;
-
-                    case Source::Texture0:
-                        return texture_color[0];
-
-                    case Source::Texture1:
-                        return texture_color[1];
-
-                    case Source::Texture2:
-                        return texture_color[2];
+        // sample procedural texture
+        if (proctex_enable) {
+            const auto& proctex_uv = uv[proctex_coordinates];
+            texture_color[3] = ProcTex(proctex_uv.u().ToFloat32(), proctex_uv.v().ToFloat32(),
+                                       g_state.regs.texturing, g_state.proctex);
+        }
 
-                    case Source::Texture3:
-                        return texture_color[3];
+        auto& primary_fragment_color = fragment.tev_inputs.primary_fragment_color;
+        auto& secondary_fragment_color = fragment.tev_inputs.secondary_fragment_color;
 
-                    case Source::PreviousBuffer:
-                        return combiner_buffer;
+        if (lighting) {
+            Common::Quaternion<float> normquat =
+                Common::Quaternion<float>{
+                    {GetInterpolatedAttribute(v0.quat.x, v1.quat.x, v2.quat.x).ToFloat32(),
+                     GetInterpolatedAttribute(v0.quat.y, v1.quat.y, v2.quat.y).ToFloat32(),
+                     GetInterpolatedAttribute(v0.quat.z, v1.quat.z, v2.quat.z).ToFloat32()},
+                    GetInterpolatedAttribute(v0.quat.w, v1.quat.w, v2.quat.w).ToFloat32(),
+                }
+                    .Normalized();
 
-                    case Source::Constant:
-                        return Common::MakeVec(tev_stage.const_r.Value(), tev_stage.const_g.Value(),
-                                               tev_stage.const_b.Value(), tev_stage.const_a.Value())
-                            .Cast<u8>();
+            Common::Vec3<float> view{
+                GetInterpolatedAttribute(v0.view.x, v1.view.x, v2.view.x).ToFloat32(),
+                GetInterpolatedAttribute(v0.view.y, v1.view.y, v2.view.y).ToFloat32(),
+                GetInterpolatedAttribute(v0.view.z, v1.view.z, v2.view.z).ToFloat32(),
+            };
+            std::tie(primary_fragment_color, secondary_fragment_color) =
+                ComputeFragmentsColors(*lighting, g_state.lighting, normquat, view, texture_color);
+        }
+    };
 
-                    case Source::Previous:
-                        return combiner_output;
+    // Output merger: shadow map, alpha, stencil and depth tests, fog and blending
+    auto WriteFragment = [&](Fragment& fragment) {
+        const u16 x = fragment.x;
+        const u16 y = fragment.y;
+        const float depth = fragment.depth;
+        auto& combiner_output = fragment.combiner_output;
+
+        if (shadow_mode) {
+            u32 depth_int = static_cast<u32>(depth * 0xFFFFFF);
+            // use green color as the shadow intensity
+            u8 stencil = combiner_output.y;
+            DrawShadowMapPixel(x >> 4, y >> 4, depth_int, stencil);
+            // skip the normal output merger pipeline if it is in shadow mode
+            return;
+        }
 
-                    default:
-                        LOG_ERROR(HW_GPU, "Unknown color combiner source {}", (int)source);
-                        UNIMPLEMENTED();
-                        return {0, 0, 0, 0};
-                    }
-                };
-
-                // color combiner
-                // NOTE: Not sure if the alpha combiner might use the color output of the previous
-                //       stage as input. Hence, we currently don't directly write the result to
-                //       combiner_output.rgb(), but instead store it in a temporary variable until
-                //       alpha combining has been done.
-                Common::Vec3<u8> color_result[3] = {
-                    GetColorModifier(tev_stage.color_modifier1, GetSource(tev_stage.color_source1)),
-                    GetColorModifier(tev_stage.color_modifier2, GetSource(tev_stage.color_source2)),
-                    GetColorModifier(tev_stage.color_modifier3, GetSource(tev_stage.color_source3)),
-                };
-                auto color_output = ColorCombine(tev_stage.color_op, color_result);
-
-                u8 alpha_output;
-                if (tev_stage.color_op == TexturingRegs::TevStageConfig::Operation::Dot3_RGBA) {
-                    // result of Dot3_RGBA operation is also placed to the alpha component
-                    alpha_output = color_output.x;
-                } else {
-                    // alpha combiner
-                    std::array<u8, 3> alpha_result = {{
-                        GetAlphaModifier(tev_stage.alpha_modifier1,
-                                         GetSource(tev_stage.alpha_source1)),
-                        GetAlphaModifier(tev_stage.alpha_modifier2,
-                                         GetSource(tev_stage.alpha_source2)),
-                        GetAlphaModifier(tev_stage.alpha_modifier3,
-                                         GetSource(tev_stage.alpha_source3)),
-                    }};
-                    alpha_output = AlphaCombine(tev_stage.alpha_op, alpha_result);
-                }
+        // TODO: Does alpha testing happen before or after stencil?
+        if (output_merger.alpha_test.enable &&
+            !alpha_test(combiner_output.a(), output_merger.alpha_test.ref)) {
+            return;
+        }
 
-                combiner_output[0] =
-                    std::min((unsigned)255, color_output.r() * tev_stage.GetColorMultiplier());
-                combiner_output[1] =
-                    std::min((unsigned)255, color_output.g() * tev_stage.GetColorMultiplier());
-                combiner_output[2] =
-                    std::min((unsigned)255, color_output.b() * tev_stage.GetColorMultiplier());
-                combiner_output[3] =
-                    std::min((unsigned)255, alpha_output * tev_stage.GetAlphaMultiplier());
-
-                combiner_buffer = next_combiner_buffer;
-
-                if (regs.texturing.tev_combiner_buffer_input.TevStageUpdatesCombinerBufferColor(
-                        tev_stage_index)) {
-                    next_combiner_buffer.r() = combiner_output.r();
-                    next_combiner_buffer.g() = combiner_output.g();
-                    next_combiner_buffer.b() = combiner_output.b();
-                }
+        // Apply fog combiner
+        if (fog) {
+            fog(combiner_output, depth, fog_color);
+        }
 
-                if (regs.texturing.tev_combiner_buffer_input.TevStageUpdatesCombinerBufferAlpha(
-                        tev_stage_index)) {
-                    next_combiner_buffer.a() = combiner_output.a();
-                }
+        u8 old_stencil = 0;
+
+        auto UpdateStencil = [stencil_test, depth_stencil_write, x, y,
+                              &old_stencil](StencilActionFunc action) {
+            u8 new_stencil = action(old_stencil, stencil_test.reference_value);
+            if (depth_stencil_write)
+                SetStencil(x >> 4, y >> 4,
+                           (new_stencil & stencil_test.write_mask) |
+                               (old_stencil & ~stencil_test.write_mask));
+        };
+
+        if (stencil_action_enable) {
+            old_stencil = GetStencil(x >> 4, y >> 4);
+            u8 dest = old_stencil & stencil_test.input_mask;
+            u8 ref = stencil_test.reference_value & stencil_test.input_mask;
+
+            if (!stencil_compare(ref, dest)) {
+                UpdateStencil(stencil_fail_action);
+                return;
             }
+        }
 
-            const auto& output_merger = regs.framebuffer.output_merger;
+        // Convert float to integer
+        u32 z = (u32)(depth * ((1 << num_depth_bits) - 1));
 
-            if (output_merger.fragment_operation_mode ==
-                FramebufferRegs::FragmentOperationMode::Shadow) {
-                u32 depth_int = static_cast<u32>(depth * 0xFFFFFF);
-                // use green color as the shadow intensity
-                u8 stencil = combiner_output.y;
-                DrawShadowMapPixel(x >> 4, y >> 4, depth_int, stencil);
-                // skip the normal output merger pipeline if it is in shadow mode
-                continue;
+        if (output_merger.depth_test_enable) {
+            u32 ref_z = GetDepth(x >> 4, y >> 4);
+            if (!depth_test(z, ref_z)) {
+                if (stencil_action_enable)
+                    UpdateStencil(depth_fail_action);
+                return;
             }
+        }
 
-            // TODO: Does alpha testing happen before or after stencil?
-            if (output_merger.alpha_test.enable) {
-                bool pass = false;
+        if (depth_write) {
+            SetDepth(x >> 4, y >> 4, z);
+        }
 
-                switch (output_merger.alpha_test.func) {
-                case FramebufferRegs::CompareFunc::Never:
-                    pass = false;
-                    break;
+        // The stencil depth_pass action is executed even if depth testing is disabled
+        if (stencil_action_enable)
+            UpdateStencil(depth_pass_action);
 
-                case FramebufferRegs::CompareFunc::Always:
-                    pass = true;
-                    break;
+        auto dest = GetPixel(x >> 4, y >> 4);
+        Common::Vec4<u8> blend_output = combiner_output;
 
-                case FramebufferRegs::CompareFunc::Equal:
-                    pass = combiner_output.a() == output_merger.alpha_test.ref;
-                    break;
+        if (output_merger.alphablend_enable) {
+            const auto srcfactor = Common::MakeVec(
+                source_rgb_factor(combiner_output, dest, blend_const).rgb(),
+                source_a_factor(combiner_output, dest, blend_const).a());
+            const auto dstfactor =
+                Common::MakeVec(dest_rgb_factor(combiner_output, dest, blend_const).rgb(),
+                                dest_a_factor(combiner_output, dest, blend_const).a());
 
-                case FramebufferRegs::CompareFunc::NotEqual:
-                    pass = combiner_output.a() != output_merger.alpha_test.ref;
-                    break;
+            blend_output = blend_equation_rgb(combiner_output, srcfactor, dest, dstfactor);
+            blend_output.a() =
+                blend_equation_a(combiner_output, srcfactor, dest, dstfactor).a();
+        } else {
+            blend_output = logic_op(combiner_output, dest);
+        }
 
-                case FramebufferRegs::CompareFunc::LessThan:
-                    pass = combiner_output.a() < output_merger.alpha_test.ref;
-                    break;
+        const Common::Vec4<u8> result = {
+            color_mask[0] ? blend_output.r() : dest.r(),
+            color_mask[1] ? blend_output.g() : dest.g(),
+            color_mask[2] ? blend_output.b() : dest.b(),
+            color_mask[3] ? blend_output.a() : dest.a(),
+        };
 
-                case FramebufferRegs::CompareFunc::LessThanOrEqual:
-                    pass = combiner_output.a() <= output_merger.alpha_test.ref;
-                    break;
+        if (color_write)
+            DrawPixel(x >> 4, y >> 4, result);
+    };
 
-                case FramebufferRegs::CompareFunc::GreaterThan:
-                    pass = combiner_output.a() > output_merger.alpha_test.ref;
-                    break;
+    // Edge function increments per pixel step, see SignedArea
+    const std::array<int, 3> step_x{(vtxpos[1].y - vtxpos[2].y) * 16,
+                                    (vtxpos[2].y - vtxpos[0].y) * 16,
+                                    (vtxpos[0].y - vtxpos[1].y) * 16};
+    const std::array<int, 3> step_y{(vtxpos[2].x - vtxpos[1].x) * 16,
+                                    (vtxpos[0].x - vtxpos[2].x) * 16,
+                                    (vtxpos[1].x - vtxpos[0].x) * 16};
 
-                case FramebufferRegs::CompareFunc::GreaterThanOrEqual:
-                    pass = combiner_output.a() >= output_merger.alpha_test.ref;
-                    break;
-                }
+    const bool scissor_exclude =
+        regs.rasterizer.scissor_test.mode == RasterizerRegs::ScissorMode::Exclude;
 
-                if (!pass)
-                    continue;
+    // Enter rasterization loop, starting at the center of the topleft bounding box corner.
+    // Pixels are processed in 2x2 quads so that coverage and the texture environment can be
+    // evaluated for four pixels at once.
+    for (u32 quad_y = min_y + 8; quad_y < max_y; quad_y += 0x20) {
+        const Common::Vec2<Fix12P4> row_start{static_cast<u16>(min_x + 8),
+                                              static_cast<u16>(quad_y)};
+        std::array<int, 3> w{bias0 + SignedArea(vtxpos[1].xy(), vtxpos[2].xy(), row_start),
+                             bias1 + SignedArea(vtxpos[2].xy(), vtxpos[0].xy(), row_start),
+                             bias2 + SignedArea(vtxpos[0].xy(), vtxpos[1].xy(), row_start)};
+
+        for (u32 quad_x = min_x + 8; quad_x < max_x; quad_x += 0x20) {
+            QuadEdgeValues edges;
+            u32 coverage = EvaluateQuadCoverage(w, step_x, step_y, edges);
+            for (std::size_t i = 0; i < 3; ++i) {
+                w[i] += 2 * step_x[i];
             }
 
-            // Apply fog combiner
-            // Not fully accurate. We'd have to know what data type is used to
-            // store the depth etc. Using float for now until we know more
-            // about Pica datatypes
-            if (regs.texturing.fog_mode == TexturingRegs::FogMode::Fog) {
-                const Common::Vec3<u8> fog_color =
-                    Common::MakeVec(regs.texturing.fog_color.r.Value(),
-                                    regs.texturing.fog_color.g.Value(),
-                                    regs.texturing.fog_color.b.Value())
-                        .Cast<u8>();
-
-                // Get index into fog LUT
-                float fog_index;
-                if (g_state.regs.texturing.fog_flip) {
-                    fog_index = (1.0f - depth) * 128.0f;
-                } else {
-                    fog_index = depth * 128.0f;
-                }
-
-                // Generate clamped fog factor from LUT for given fog index
-                float fog_i = std::clamp(floorf(fog_index), 0.0f, 127.0f);
-                float fog_f = fog_index - fog_i;
-                const auto& fog_lut_entry = g_state.fog.lut[static_cast<unsigned int>(fog_i)];
-                float fog_factor = fog_lut_entry.ToFloat() + fog_lut_entry.DiffToFloat() * fog_f;
-                fog_factor = std::clamp(fog_factor, 0.0f, 1.0f);
-
-                // Blend the fog
-                for (unsigned i = 0; i < 3; i++) {
-                    combiner_output[i] = static_cast<u8>(fog_factor * combiner_output[i] +
-                                                         (1.0f - fog_factor) * fog_color[i]);
+            std::array<Fragment, QUAD_SIZE> fragments{};
+            for (std::size_t lane = 0; lane < QUAD_SIZE; ++lane) {
+                const u32 x = quad_x + (lane & 1) * 0x10;
+                const u32 y = quad_y + (lane >> 1) * 0x10;
+
+                // Quads may stick out of the bounding box at the right and bottom. Also do not
+                // process the pixel if it's inside the scissor box and the scissor mode is set to
+                // Exclude.
+                if (x >= max_x || y >= max_y ||
+                    (scissor_exclude && x >= scissor_x1 && x < scissor_x2 && y >= scissor_y1 &&
+                     y < scissor_y2)) {
+                    coverage &= ~(1u << lane);
                 }
+                fragments[lane].x = static_cast<u16>(x);
+                fragments[lane].y = static_cast<u16>(y);
             }
 
-            u8 old_stencil = 0;
-
-            auto UpdateStencil = [stencil_test, x, y,
-                                  &old_stencil](Pica::FramebufferRegs::StencilAction action) {
-                u8 new_stencil =
-                    PerformStencilAction(action, old_stencil, stencil_test.reference_value);
-                if (g_state.regs.framebuffer.framebuffer.allow_depth_stencil_write != 0)
-                    SetStencil(x >> 4, y >> 4,
-                               (new_stencil & stencil_test.write_mask) |
-                                   (old_stencil & ~stencil_test.write_mask));
-            };
-
-            if (stencil_action_enable) {
-                old_stencil = GetStencil(x >> 4, y >> 4);
-                u8 dest = old_stencil & stencil_test.input_mask;
-                u8 ref = stencil_test.reference_value & stencil_test.input_mask;
-
-                bool pass = false;
-                switch (stencil_test.func) {
-                case FramebufferRegs::CompareFunc::Never:
-                    pass = false;
-                    break;
-
-                case FramebufferRegs::CompareFunc::Always:
-                    pass = true;
-                    break;
-
-                case FramebufferRegs::CompareFunc::Equal:
-                    pass = (ref == dest);
-                    break;
-
-                case FramebufferRegs::CompareFunc::NotEqual:
-                    pass = (ref != dest);
-                    break;
-
-                case FramebufferRegs::CompareFunc::LessThan:
-                    pass = (ref < dest);
-                    break;
-
-                case FramebufferRegs::CompareFunc::LessThanOrEqual:
-                    pass = (ref <= dest);
-                    break;
-
-                case FramebufferRegs::CompareFunc::GreaterThan:
-                    pass = (ref > dest);
-                    break;
-
-                case FramebufferRegs::CompareFunc::GreaterThanOrEqual:
-                    pass = (ref >= dest);
-                    break;
-                }
+            // If no pixel of the quad is covered by the current primitive
+            if (coverage == 0)
+                continue;
 
-                if (!pass) {
-                    UpdateStencil(stencil_test.action_stencil_fail);
-                    continue;
+            for (std::size_t lane = 0; lane < QUAD_SIZE; ++lane) {
+                if (coverage & (1u << lane)) {
+                    ShadeFragment(fragments[lane], edges[0][lane], edges[1][lane],
+                                  edges[2][lane]);
                 }
             }
 
-            // Convert float to integer
-            unsigned num_bits =
-                FramebufferRegs::DepthBitsPerPixel(regs.framebuffer.framebuffer.depth_format);
-            u32 z = (u32)(depth * ((1 << num_bits) - 1));
-
-            if (output_merger.depth_test_enable) {
-                u32 ref_z = GetDepth(x >> 4, y >> 4);
-
-                bool pass = false;
-
-                switch (output_merger.depth_test_func) {
-                case FramebufferRegs::CompareFunc::Never:
-                    pass = false;
-                    break;
-
-                case FramebufferRegs::CompareFunc::Always:
-                    pass = true;
-                    break;
-
-                case FramebufferRegs::CompareFunc::Equal:
-                    pass = z == ref_z;
-                    break;
-
-                case FramebufferRegs::CompareFunc::NotEqual:
-                    pass = z != ref_z;
-                    break;
-
-                case FramebufferRegs::CompareFunc::LessThan:
-                    pass = z < ref_z;
-                    break;
-
-                case FramebufferRegs::CompareFunc::LessThanOrEqual:
-                    pass = z <= ref_z;
-                    break;
-
-                case FramebufferRegs::CompareFunc::GreaterThan:
-                    pass = z > ref_z;
-                    break;
-
-                case FramebufferRegs::CompareFunc::GreaterThanOrEqual:
-                    pass = z >= ref_z;
-                    break;
+            if (tev_program.IsQuadSupported()) {
+                const auto combiner_output =
+                    tev_program.RunQuad({&fragments[0].tev_inputs, &fragments[1].tev_inputs,
+                                         &fragments[2].tev_inputs, &fragments[3].tev_inputs});
+                for (std::size_t lane = 0; lane < QUAD_SIZE; ++lane) {
+                    fragments[lane].combiner_output = combiner_output[lane];
                 }
-
-                if (!pass) {
-                    if (stencil_action_enable)
-                        UpdateStencil(stencil_test.action_depth_fail);
-                    continue;
+            } else {
+                for (std::size_t lane = 0; lane < QUAD_SIZE; ++lane) {
+                    if (coverage & (1u << lane)) {
+                        fragments[lane].combiner_output =
+                            tev_program.Run(fragments[lane].tev_inputs);
+                    }
                 }
             }
 
-            if (regs.framebuffer.framebuffer.allow_depth_stencil_write != 0 &&
-                output_merger.depth_write_enable) {
-
-                SetDepth(x >> 4, y >> 4, z);
+            for (std::size_t lane = 0; lane < QUAD_SIZE; ++lane) {
+                if (coverage & (1u << lane)) {
+                    WriteFragment(fragments[lane]);
+                }
             }
+        }
+    }
+}
 
-            // The stencil depth_pass action is executed even if depth testing is disabled
-            if (stencil_action_enable)
-                UpdateStencil(stencil_test.action_depth_pass);
-
-            auto dest = GetPixel(x >> 4, y >> 4);
-            Common::Vec4<u8> blend_output = combiner_output;
-
-            if (output_merger.alphablend_enable) {
-                auto params = output_merger.alpha_blending;
-
-                auto LookupFactor = [&](unsigned channel,
-                                        FramebufferRegs::BlendFactor factor) -> u8 {
-                    DEBUG_ASSERT(channel < 4);
-
-                    const Common::Vec4<u8> blend_const =
-                        Common::MakeVec(output_merger.blend_const.r.Value(),
-                                        output_merger.blend_const.g.Value(),
-                                        output_merger.blend_const.b.Value(),
-                                        output_merger.blend_const.a.Value())
-                            .Cast<u8>();
-
-                    switch (factor) {
-                    case FramebufferRegs::BlendFactor::Zero:
-                        return 0;
-
-                    case FramebufferRegs::BlendFactor::One:
-                        return 255;
-
-                    case FramebufferRegs::BlendFactor::SourceColor:
-                        return combiner_output[channel];
-
-                    case FramebufferRegs::BlendFactor::OneMinusSourceColor:
-                        return 255 - combiner_output[channel];
-
-                    case FramebufferRegs::BlendFactor::DestColor:
-                        return dest[channel];
-
-                    case FramebufferRegs::BlendFactor::OneMinusDestColor:
-                        return 255 - dest[channel];
-
-                    case FramebufferRegs::BlendFactor::SourceAlpha:
-                        return combiner_output.a();
-
-                    case FramebufferRegs::BlendFactor::OneMinusSourceAlpha:
-                        return 255 - combiner_output.a();
-
-                    case FramebufferRegs::BlendFactor::DestAlpha:
-                        return dest.a();
-
-                    case FramebufferRegs::BlendFactor::OneMinusDestAlpha:
-                        return 255 - dest.a();
-
-                    case FramebufferRegs::BlendFactor::ConstantColor:
-                        return blend_const[channel];
-
-                    case FramebufferRegs::BlendFactor::OneMinusConstantColor:
-                        return 255 - blend_const[channel];
-
-                    case FramebufferRegs::BlendFactor::ConstantAlpha:
-                        return blend_const.a();
-
-                    case FramebufferRegs::BlendFactor::OneMinusConstantAlpha:
-                        return 255 - blend_const.a();
-
-                    case FramebufferRegs::BlendFactor::SourceAlphaSaturate:
-                        // Returns 1.0 for the alpha channel
-                        if (channel == 3)
-                            return 255;
-                        return std::min(combiner_output.a(), static_cast<u8>(255 - dest.a()));
-
-                    default:
-                        LOG_CRITICAL(HW_GPU, "Unknown blend factor {:x}", factor);
-                        UNIMPLEMENTED();
-                        break;
-                    }
-
-                    return combiner_output[channel];
-                };
-
-                auto srcfactor = Common::MakeVec(LookupFactor(0, params.factor_source_rgb),
-                                                 LookupFactor(1, params.factor_source_rgb),
-                                                 LookupFactor(2, params.factor_source_rgb),
-                                                 LookupFactor(3, params.factor_source_a));
-
-                auto dstfactor = Common::MakeVec(LookupFactor(0, params.factor_dest_rgb),
-                                                 LookupFactor(1, params.factor_dest_rgb),
-                                                 LookupFactor(2, params.factor_dest_rgb),
-                                                 LookupFactor(3, params.factor_dest_a));
+void ProcessTriangle(const Vertex& v0, const Vertex& v1, const Vertex& v2,
+                     TextureCache& texture_cache) {
+    ProcessTriangleInternal(v0, v1, v2, texture_cache,
+                            {0, 0, MAX_SCREEN_COORDINATE, MAX_SCREEN_COORDINATE});
+}
 
-                blend_output = EvaluateBlendEquation(combiner_output, srcfactor, dest, dstfactor,
-                                                     params.blend_equation_rgb);
-                blend_output.a() = EvaluateBlendEquation(combiner_output, srcfactor, dest,
-                                                         dstfactor, params.blend_equation_a)
-                                       .a();
-            } else {
-                blend_output =
-                    Common::MakeVec(LogicOp(combiner_output.r(), dest.r(), output_merger.logic_op),
-                                    LogicOp(combiner_output.g(), dest.g(), output_merger.logic_op),
-                                    LogicOp(combiner_output.b(), dest.b(), output_merger.logic_op),
-                                    LogicOp(combiner_output.a(), dest.a(), output_merger.logic_op));
-            }
+void ProcessTriangle(const Vertex& v0, const Vertex& v1, const Vertex& v2,
+                     TextureCache& texture_cache, const Common::Rectangle<u16>& tile) {
+    ProcessTriangleInternal(v0, v1, v2, texture_cache, tile);
+}
 
-            const Common::Vec4<u8> result = {
-                output_merger.red_enable ? blend_output.r() : dest.r(),
-                output_merger.green_enable ? blend_output.g() : dest.g(),
-                output_merger.blue_enable ? blend_output.b() : dest.b(),
-                output_merger.alpha_enable ? blend_output.a() : dest.a(),
-            };
+Common::Rectangle<u16> GetTriangleBounds(const Vertex& v0, const Vertex& v1, const Vertex& v2) {
+    const auto vtxpos0 = ScreenToRasterizerCoordinates(v0.screenpos);
+    const auto vtxpos1 = ScreenToRasterizerCoordinates(v1.screenpos);
+    const auto vtxpos2 = ScreenToRasterizerCoordinates(v2.screenpos);
 
-            if (regs.framebuffer.framebuffer.allow_color_write != 0)
-                DrawPixel(x >> 4, y >> 4, result);
-        }
-    }
-}
+    const u32 min_x = std::min({vtxpos0.x, vtxpos1.x, vtxpos2.x});
+    const u32 min_y = std::min({vtxpos0.y, vtxpos1.y, vtxpos2.y});
+    const u32 max_x = std::max({vtxpos0.x, vtxpos1.x, vtxpos2.x});
+    const u32 max_y = std::max({vtxpos0.y, vtxpos1.y, vtxpos2.y});
 
-void ProcessTriangle(const Vertex& v0, const Vertex& v1, const Vertex& v2) {
-    ProcessTriangleInternal(v0, v1, v2);
+    // Matches the pixel centers visited by ProcessTriangleInternal before scissoring
+    return {static_cast<u16>(min_x >> 4), static_cast<u16>(min_y >> 4),
+            static_cast<u16>((max_x + Fix12P4::FracMask()) >> 4),
+            static_cast<u16>((max_y + Fix12P4::FracMask()) >> 4)};
 }
 
 } // namespace Pica::Rasterizer
@@ -4,10 +4,13 @@
 
 #pragma once
 
+#include "common/math_util.h"
 #include "video_core/shader/shader.h"
 
 namespace Pica::Rasterizer {
 
+class TextureCache;
+
 struct Vertex : Shader::OutputVertex {
     Vertex(const OutputVertex& v) : OutputVertex(v) {}
 
@@ -39,6 +42,21 @@ struct Vertex : Shader::OutputVertex {
     }
 };
 
-void ProcessTriangle(const Vertex& v0, const Vertex& v1, const Vertex& v2);
+/// Exclusive upper bound of the rasterizer's 12.4 fixed-point coordinates, in whole pixels
+constexpr u16 MAX_SCREEN_COORDINATE = 0x1000;
+
+/// Rasterizes the given triangle, sampling textures through the decoded texture cache
+void ProcessTriangle(const Vertex& v0, const Vertex& v1, const Vertex& v2,
+                     TextureCache& texture_cache);
+
+/**
+ * Rasterizes only the pixels of the given triangle that lie inside a screen tile.
+ * @param tile Pixel rectangle to restrict rasterization to, right and bottom are exclusive
+ */
+void ProcessTriangle(const Vertex& v0, const Vertex& v1, const Vertex& v2,
+                     TextureCache& texture_cache, const Common::Rectangle<u16>& tile);
+
+/// Returns the pixel rectangle, right and bottom exclusive, that a triangle can cover at most
+Common::Rectangle<u16> GetTriangleBounds(const Vertex& v0, const Vertex& v1, const Vertex& v2);
 
 } // namespace Pica::Rasterizer
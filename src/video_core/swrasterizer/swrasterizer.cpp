@@ -2,15 +2,67 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <thread>
+#include "common/logging/log.h"
+#include "core/settings.h"
+#include "video_core/pica_state.h"
+#include "video_core/regs_framebuffer.h"
 #include "video_core/swrasterizer/clipper.h"
 #include "video_core/swrasterizer/swrasterizer.h"
+#include "video_core/swrasterizer/texture_cache.h"
+#include "video_core/swrasterizer/tile_binner.h"
 
 namespace VideoCore {
 
+SWRasterizer::SWRasterizer()
+    : texture_cache{std::make_unique<Pica::Rasterizer::TextureCache>()} {
+    std::size_t num_threads = Settings::values.sw_rasterizer_threads;
+    if (num_threads == 0) {
+        num_threads = std::max(1U, std::thread::hardware_concurrency());
+    }
+    if (num_threads > 1) {
+        LOG_INFO(Render_Software, "Rasterizing with {} threads", num_threads);
+        binner = std::make_unique<Pica::Rasterizer::TileBinner>(num_threads, *texture_cache);
+    }
+}
+
+SWRasterizer::~SWRasterizer() = default;
+
 void SWRasterizer::AddTriangle(const Pica::Shader::OutputVertex& v0,
                                const Pica::Shader::OutputVertex& v1,
                                const Pica::Shader::OutputVertex& v2) {
-    Pica::Clipper::ProcessTriangle(v0, v1, v2);
+    Pica::Clipper::ProcessTriangle(v0, v1, v2, *texture_cache, binner.get());
+}
+
+void SWRasterizer::DrawTriangles() {
+    if (binner) {
+        binner->Flush();
+    }
+
+    // Textures sampled from the render targets have to be decoded again after drawing
+    const auto& framebuffer = Pica::g_state.regs.framebuffer.framebuffer;
+    const u32 num_pixels = framebuffer.GetWidth() * framebuffer.GetHeight();
+    texture_cache->InvalidateRegion(
+        framebuffer.GetColorBufferPhysicalAddress(),
+        num_pixels * Pica::FramebufferRegs::BytesPerColorPixel(framebuffer.color_format));
+    texture_cache->InvalidateRegion(
+        framebuffer.GetDepthBufferPhysicalAddress(),
+        num_pixels * Pica::FramebufferRegs::BytesPerDepthPixel(framebuffer.depth_format));
+
+    // Pages of the textures decoded by this batch can only be marked now that it is done
+    texture_cache->SyncPages();
+}
+
+void SWRasterizer::InvalidateRegion(PAddr addr, u32 size) {
+    texture_cache->InvalidateRegion(addr, size);
+}
+
+void SWRasterizer::FlushAndInvalidateRegion(PAddr addr, u32 size) {
+    texture_cache->InvalidateRegion(addr, size);
+}
+
+void SWRasterizer::ClearAll(bool flush) {
+    texture_cache->ClearAll();
 }
 
 } // namespace VideoCore
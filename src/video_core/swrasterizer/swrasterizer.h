@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <memory>
 #include "common/common_types.h"
 #include "video_core/rasterizer_interface.h"
 
@@ -11,18 +12,34 @@ namespace Pica::Shader {
 struct OutputVertex;
 } // namespace Pica::Shader
 
+namespace Pica::Rasterizer {
+class TextureCache;
+class TileBinner;
+} // namespace Pica::Rasterizer
+
 namespace VideoCore {
 
 class SWRasterizer : public RasterizerInterface {
+public:
+    SWRasterizer();
+    ~SWRasterizer() override;
+
+private:
     void AddTriangle(const Pica::Shader::OutputVertex& v0, const Pica::Shader::OutputVertex& v1,
                      const Pica::Shader::OutputVertex& v2) override;
-    void DrawTriangles() override {}
+    void DrawTriangles() override;
     void NotifyPicaRegisterChanged(u32 id) override {}
     void FlushAll() override {}
     void FlushRegion(PAddr addr, u32 size) override {}
-    void InvalidateRegion(PAddr addr, u32 size) override {}
-    void FlushAndInvalidateRegion(PAddr addr, u32 size) override {}
-    void ClearAll(bool flush) override {}
+    void InvalidateRegion(PAddr addr, u32 size) override;
+    void FlushAndInvalidateRegion(PAddr addr, u32 size) override;
+    void ClearAll(bool flush) override;
+
+    /// Decoded copies of the sampled textures, shared by all rasterizer threads
+    std::unique_ptr<Pica::Rasterizer::TextureCache> texture_cache;
+
+    /// Defers rasterization to the end of the batch when multithreading is enabled
+    std::unique_ptr<Pica::Rasterizer::TileBinner> binner;
 };
 
 } // namespace VideoCore
@@ -0,0 +1,272 @@
+// Copyright 2022 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+#include "common/assert.h"
+#include "common/hash.h"
+#include "common/logging/log.h"
+#include "video_core/swrasterizer/tev_program.h"
+
+namespace Pica::Rasterizer {
+
+using TevStageConfig = TexturingRegs::TevStageConfig;
+
+static_assert(sizeof(TevStageConfig) == 5 * sizeof(u32), "TevStageConfig has incorrect size");
+
+TevProgram::Key TevProgram::MakeKey(const TexturingRegs& regs) {
+    Key key{};
+    const auto tev_stages = regs.GetTevStages();
+    std::memcpy(key.data(), tev_stages.data(), sizeof(tev_stages));
+
+    const auto& buffer_input = regs.tev_combiner_buffer_input;
+    key[30] = buffer_input.update_mask_rgb | (buffer_input.update_mask_a << 4);
+    key[31] = regs.tev_combiner_buffer_color.raw;
+    return key;
+}
+
+TevProgram::Slot TevProgram::GetSlot(TevStageConfig::Source source) {
+    using Source = TevStageConfig::Source;
+
+    switch (source) {
+    case Source::PrimaryColor:
+        return PrimaryColor;
+    case Source::PrimaryFragmentColor:
+        return PrimaryFragmentColor;
+    case Source::SecondaryFragmentColor:
+        return SecondaryFragmentColor;
+    case Source::Texture0:
+        return Texture0;
+    case Source::Texture1:
+        return Texture1;
+    case Source::Texture2:
+        return Texture2;
+    case Source::Texture3:
+        return Texture3;
+    case Source::PreviousBuffer:
+        return PreviousBuffer;
+    case Source::Constant:
+        return Constant;
+    case Source::Previous:
+        return Previous;
+    default:
+        LOG_ERROR(HW_GPU, "Unknown color combiner source {}", (int)source);
+        UNIMPLEMENTED();
+        return Zero;
+    }
+}
+
+TevProgram::TevProgram(const TexturingRegs& regs) : key(MakeKey(regs)) {
+    using ColorModifier = TevStageConfig::ColorModifier;
+    using AlphaModifier = TevStageConfig::AlphaModifier;
+    using Operation = TevStageConfig::Operation;
+    using Source = TevStageConfig::Source;
+
+    buffer_color = Common::MakeVec(regs.tev_combiner_buffer_color.r.Value(),
+                                   regs.tev_combiner_buffer_color.g.Value(),
+                                   regs.tev_combiner_buffer_color.b.Value(),
+                                   regs.tev_combiner_buffer_color.a.Value())
+                       .Cast<u8>();
+
+    quad_supported = true;
+    const auto tev_stages = regs.GetTevStages();
+    for (unsigned index = 0; index < tev_stages.size(); ++index) {
+        const auto& config = tev_stages[index];
+        auto& stage = stages[index];
+
+        stage.config = config;
+        stage.constant = Common::MakeVec(config.const_r.Value(), config.const_g.Value(),
+                                         config.const_b.Value(), config.const_a.Value())
+                             .Cast<u8>();
+        stage.color_sources = {GetSlot(config.color_source1), GetSlot(config.color_source2),
+                               GetSlot(config.color_source3)};
+        stage.alpha_sources = {GetSlot(config.alpha_source1), GetSlot(config.alpha_source2),
+                               GetSlot(config.alpha_source3)};
+        stage.color_modifiers = {GetColorModifierFunc(config.color_modifier1),
+                                 GetColorModifierFunc(config.color_modifier2),
+                                 GetColorModifierFunc(config.color_modifier3)};
+        stage.alpha_modifiers = {GetAlphaModifierFunc(config.alpha_modifier1),
+                                 GetAlphaModifierFunc(config.alpha_modifier2),
+                                 GetAlphaModifierFunc(config.alpha_modifier3)};
+        stage.color_combine = GetColorCombineFunc(config.color_op);
+        stage.alpha_combine = GetAlphaCombineFunc(config.alpha_op);
+        stage.color_multiplier = config.GetColorMultiplier();
+        stage.alpha_multiplier = config.GetAlphaMultiplier();
+        stage.alpha_from_color = config.color_op == Operation::Dot3_RGBA;
+
+        // Games commonly leave the unused trailing stages in this state
+        stage.passthrough = config.color_op == Operation::Replace &&
+                            config.alpha_op == Operation::Replace &&
+                            config.color_source1 == Source::Previous &&
+                            config.alpha_source1 == Source::Previous &&
+                            config.color_modifier1 == ColorModifier::SourceColor &&
+                            config.alpha_modifier1 == AlphaModifier::SourceAlpha &&
+                            stage.color_multiplier == 1 && stage.alpha_multiplier == 1;
+
+        stage.update_buffer_color =
+            regs.tev_combiner_buffer_input.TevStageUpdatesCombinerBufferColor(index);
+        stage.update_buffer_alpha =
+            regs.tev_combiner_buffer_input.TevStageUpdatesCombinerBufferAlpha(index);
+
+        quad_supported = quad_supported && (stage.passthrough || IsQuadCombinerSupported(config));
+    }
+}
+
+void TevProgram::LoadSlots(Slots& slots, const TevInputs& inputs) const {
+    slots[PrimaryColor] = inputs.primary_color;
+    slots[PrimaryFragmentColor] = inputs.primary_fragment_color;
+    slots[SecondaryFragmentColor] = inputs.secondary_fragment_color;
+    slots[Texture0] = inputs.texture_color[0];
+    slots[Texture1] = inputs.texture_color[1];
+    slots[Texture2] = inputs.texture_color[2];
+    slots[Texture3] = inputs.texture_color[3];
+    slots[Previous] = {0, 0, 0, 0};
+    slots[PreviousBuffer] = {0, 0, 0, 0};
+    slots[Zero] = {0, 0, 0, 0};
+}
+
+Common::Vec4<u8> TevProgram::Run(const TevInputs& inputs) const {
+    Slots slots;
+    LoadSlots(slots, inputs);
+    Common::Vec4<u8> next_combiner_buffer = buffer_color;
+
+    for (const auto& stage : stages) {
+        if (!stage.passthrough) {
+            slots[Constant] = stage.constant;
+
+            // NOTE: Not sure if the alpha combiner might use the color output of the previous
+            //       stage as input. Hence, all inputs are read before the output is written.
+            const Common::Vec3<u8> color_inputs[3] = {
+                stage.color_modifiers[0](slots[stage.color_sources[0]]),
+                stage.color_modifiers[1](slots[stage.color_sources[1]]),
+                stage.color_modifiers[2](slots[stage.color_sources[2]]),
+            };
+            const auto color_output = stage.color_combine(color_inputs);
+
+            u8 alpha_output;
+            if (stage.alpha_from_color) {
+                alpha_output = color_output.x;
+            } else {
+                const std::array<u8, 3> alpha_inputs = {{
+                    stage.alpha_modifiers[0](slots[stage.alpha_sources[0]]),
+                    stage.alpha_modifiers[1](slots[stage.alpha_sources[1]]),
+                    stage.alpha_modifiers[2](slots[stage.alpha_sources[2]]),
+                }};
+                alpha_output = stage.alpha_combine(alpha_inputs);
+            }
+
+            auto& combiner_output = slots[Previous];
+            combiner_output[0] = std::min(255u, color_output.r() * stage.color_multiplier);
+            combiner_output[1] = std::min(255u, color_output.g() * stage.color_multiplier);
+            combiner_output[2] = std::min(255u, color_output.b() * stage.color_multiplier);
+            combiner_output[3] = std::min(255u, alpha_output * stage.alpha_multiplier);
+        }
+
+        slots[PreviousBuffer] = next_combiner_buffer;
+
+        if (stage.update_buffer_color) {
+            next_combiner_buffer.r() = slots[Previous].r();
+            next_combiner_buffer.g() = slots[Previous].g();
+            next_combiner_buffer.b() = slots[Previous].b();
+        }
+
+        if (stage.update_buffer_alpha) {
+            next_combiner_buffer.a() = slots[Previous].a();
+        }
+    }
+
+    return slots[Previous];
+}
+
+QuadColor TevProgram::RunQuad(const std::array<const TevInputs*, QUAD_SIZE>& inputs) const {
+    std::array<Slots, QUAD_SIZE> slots;
+    for (std::size_t lane = 0; lane < QUAD_SIZE; ++lane) {
+        LoadSlots(slots[lane], *inputs[lane]);
+    }
+    QuadColor next_combiner_buffer;
+    next_combiner_buffer.fill(buffer_color);
+
+    for (const auto& stage : stages) {
+        if (!stage.passthrough) {
+            std::array<QuadColor, 3> combiner_inputs;
+            for (std::size_t lane = 0; lane < QUAD_SIZE; ++lane) {
+                auto& lane_slots = slots[lane];
+                lane_slots[Constant] = stage.constant;
+                for (std::size_t i = 0; i < 3; ++i) {
+                    combiner_inputs[i][lane] = Common::MakeVec(
+                        stage.color_modifiers[i](lane_slots[stage.color_sources[i]]),
+                        stage.alpha_modifiers[i](lane_slots[stage.alpha_sources[i]]));
+                }
+            }
+
+            const QuadColor combiner_output = CombineQuad(stage.config, combiner_inputs);
+            for (std::size_t lane = 0; lane < QUAD_SIZE; ++lane) {
+                slots[lane][Previous] = combiner_output[lane];
+            }
+        }
+
+        for (std::size_t lane = 0; lane < QUAD_SIZE; ++lane) {
+            slots[lane][PreviousBuffer] = next_combiner_buffer[lane];
+
+            if (stage.update_buffer_color) {
+                next_combiner_buffer[lane].r() = slots[lane][Previous].r();
+                next_combiner_buffer[lane].g() = slots[lane][Previous].g();
+                next_combiner_buffer[lane].b() = slots[lane][Previous].b();
+            }
+
+            if (stage.update_buffer_alpha) {
+                next_combiner_buffer[lane].a() = slots[lane][Previous].a();
+            }
+        }
+    }
+
+    QuadColor output;
+    for (std::size_t lane = 0; lane < QUAD_SIZE; ++lane) {
+        output[lane] = slots[lane][Previous];
+    }
+    return output;
+}
+
+namespace {
+
+/// Programs of the configurations recently used by a thread, keyed by the hash of their registers
+class TevProgramCache {
+public:
+    const TevProgram& Get(const TexturingRegs& regs) {
+        // Registers rarely change between the triangles of a draw, so check the last one first
+        const auto key = TevProgram::MakeKey(regs);
+        if (last_program && last_program->GetKey() == key) {
+            return *last_program;
+        }
+
+        const u64 hash = Common::ComputeHash64(key.data(), sizeof(key));
+        auto it = programs.find(hash);
+        if (it == programs.end() || it->second.GetKey() != key) {
+            if (programs.size() >= MAX_PROGRAMS) {
+                programs.clear();
+            }
+            it = programs.insert_or_assign(hash, TevProgram{regs}).first;
+        }
+
+        last_program = &it->second;
+        return *last_program;
+    }
+
+private:
+    static constexpr std::size_t MAX_PROGRAMS = 256;
+
+    std::unordered_map<u64, TevProgram> programs;
+    const TevProgram* last_program = nullptr;
+};
+
+} // Anonymous namespace
+
+const TevProgram& GetTevProgram(const TexturingRegs& regs) {
+    // Each rasterizer thread keeps its own cache, so lookups don't need any locking
+    thread_local TevProgramCache cache;
+    return cache.Get(regs);
+}
+
+} // namespace Pica::Rasterizer
@@ -0,0 +1,118 @@
+// Copyright 2022 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include "common/common_types.h"
+#include "common/vector_math.h"
+#include "video_core/regs_texturing.h"
+#include "video_core/swrasterizer/quad_kernels.h"
+#include "video_core/swrasterizer/texturing.h"
+
+namespace Pica::Rasterizer {
+
+/// Per-fragment colors the texture environment can read from
+struct TevInputs {
+    Common::Vec4<u8> primary_color;
+    Common::Vec4<u8> primary_fragment_color;
+    Common::Vec4<u8> secondary_fragment_color;
+    Common::Vec4<u8> texture_color[4];
+};
+
+/**
+ * Texture environment - consists of 6 stages of color and alpha combining.
+ *
+ * Color combiners take three input color values from some source (e.g. interpolated vertex color,
+ * texture color, previous stage, etc), perform some very simple operations on each of them (e.g.
+ * inversion) and then calculate the output color with some basic arithmetic. Alpha combiners can
+ * be configured separately but work analogously.
+ *
+ * A TevProgram is the texture environment configuration of a draw with all of its registers
+ * decoded up front: sources become indices into a per-fragment input table and the modifiers and
+ * operations become functions specialized for them, so evaluating a fragment involves no
+ * switching on register values.
+ */
+class TevProgram {
+public:
+    /// Raw register words the program is built from
+    using Key = std::array<u32, 32>;
+
+    explicit TevProgram(const TexturingRegs& regs);
+
+    /// Returns the register words the texture environment depends on
+    static Key MakeKey(const TexturingRegs& regs);
+
+    const Key& GetKey() const {
+        return key;
+    }
+
+    /// Evaluates all stages for a single fragment and returns the final combiner output
+    Common::Vec4<u8> Run(const TevInputs& inputs) const;
+
+    /// Whether RunQuad can be used with this configuration
+    bool IsQuadSupported() const {
+        return quad_supported;
+    }
+
+    /// Evaluates all stages for the four fragments of a quad at once. Equivalent to calling Run on
+    /// each of them.
+    QuadColor RunQuad(const std::array<const TevInputs*, QUAD_SIZE>& inputs) const;
+
+private:
+    /// Layout of the per-fragment table stage inputs are read from
+    enum Slot : u8 {
+        PrimaryColor,
+        PrimaryFragmentColor,
+        SecondaryFragmentColor,
+        Texture0,
+        Texture1,
+        Texture2,
+        Texture3,
+        Previous,
+        PreviousBuffer,
+        Constant,
+        Zero,
+        NumSlots,
+    };
+
+    using Slots = std::array<Common::Vec4<u8>, NumSlots>;
+
+    struct Stage {
+        TexturingRegs::TevStageConfig config;
+        Common::Vec4<u8> constant;
+        std::array<u8, 3> color_sources;
+        std::array<u8, 3> alpha_sources;
+        std::array<ColorModifierFunc, 3> color_modifiers;
+        std::array<AlphaModifierFunc, 3> alpha_modifiers;
+        ColorCombineFunc color_combine;
+        AlphaCombineFunc alpha_combine;
+        unsigned color_multiplier;
+        unsigned alpha_multiplier;
+        /// Dot3_RGBA also places its result in the alpha component
+        bool alpha_from_color;
+        /// The stage passes the previous output through unchanged
+        bool passthrough;
+        bool update_buffer_color;
+        bool update_buffer_alpha;
+    };
+
+    static Slot GetSlot(TexturingRegs::TevStageConfig::Source source);
+
+    /// Copies the fragment colors into a slot table
+    void LoadSlots(Slots& slots, const TevInputs& inputs) const;
+
+    Key key;
+    std::array<Stage, 6> stages;
+    Common::Vec4<u8> buffer_color;
+    bool quad_supported;
+};
+
+/**
+ * Returns the TEV program for the current texturing registers. Programs are cached per thread, so
+ * the returned reference is valid until the next call on the same thread.
+ */
+const TevProgram& GetTevProgram(const TexturingRegs& regs);
+
+} // namespace Pica::Rasterizer
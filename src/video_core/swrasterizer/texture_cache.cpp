@@ -0,0 +1,196 @@
+// Copyright 2022 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <boost/icl/interval_map.hpp>
+#include "common/assert.h"
+#include "common/microprofile.h"
+#include "core/hw/gpu.h"
+#include "core/memory.h"
+#include "video_core/swrasterizer/texture_cache.h"
+#include "video_core/texture/texture_decode.h"
+#include "video_core/video_core.h"
+
+namespace Pica::Rasterizer {
+
+/// Decoded data is dropped all at once when it grows past this size
+constexpr std::size_t MAX_CACHED_BYTES = 64 * 1024 * 1024;
+
+/**
+ * Page markings must only change on the CPU thread, while lookups happen on the rasterizer
+ * threads. Updates are queued in order and applied in batches by whoever runs on the CPU thread.
+ */
+class TextureCache::PageTracker {
+public:
+    void Queue(PAddr addr, u32 size, int delta) {
+        std::lock_guard lock{mutex};
+        pending.push_back({addr, size, delta});
+    }
+
+    bool HasPending() {
+        std::lock_guard lock{mutex};
+        return !pending.empty();
+    }
+
+    void Apply() {
+        std::lock_guard lock{mutex};
+        for (const PageUpdate& update : pending) {
+            UpdatePagesCachedCount(update.addr, update.size, update.delta);
+        }
+        pending.clear();
+    }
+
+private:
+    using PageMap = boost::icl::interval_map<u32, int>;
+
+    struct PageUpdate {
+        PAddr addr;
+        u32 size;
+        int delta;
+    };
+
+    void UpdatePagesCachedCount(PAddr addr, u32 size, int delta) {
+        const u32 num_pages =
+            ((addr + size - 1) >> Memory::PAGE_BITS) - (addr >> Memory::PAGE_BITS) + 1;
+        const u32 page_start = addr >> Memory::PAGE_BITS;
+        const u32 page_end = page_start + num_pages;
+
+        // Interval maps will erase segments if count reaches 0, so if delta is negative we have
+        // to subtract after iterating
+        const auto pages_interval = PageMap::interval_type::right_open(page_start, page_end);
+        if (delta > 0) {
+            cached_pages.add({pages_interval, delta});
+        }
+
+        const auto [begin, end] = cached_pages.equal_range(pages_interval);
+        for (auto it = begin; it != end; ++it) {
+            const auto interval = it->first & pages_interval;
+            const int count = it->second;
+
+            const PAddr interval_start_addr = boost::icl::first(interval) << Memory::PAGE_BITS;
+            const PAddr interval_end_addr = boost::icl::last_next(interval) << Memory::PAGE_BITS;
+            const u32 interval_size = interval_end_addr - interval_start_addr;
+
+            if (delta > 0 && count == delta) {
+                VideoCore::g_memory->RasterizerMarkRegionCached(interval_start_addr,
+                                                                interval_size, true);
+            } else if (delta < 0 && count == -delta) {
+                VideoCore::g_memory->RasterizerMarkRegionCached(interval_start_addr,
+                                                                interval_size, false);
+            } else {
+                ASSERT(count >= 0);
+            }
+        }
+
+        if (delta < 0) {
+            cached_pages.add({pages_interval, delta});
+        }
+    }
+
+    std::mutex mutex;
+    std::vector<PageUpdate> pending;
+    PageMap cached_pages;
+};
+
+TextureCache::TextureCache() : page_tracker{std::make_shared<PageTracker>()} {}
+
+TextureCache::~TextureCache() {
+#ifndef ANDROID
+    // This is for switching renderers, which is unsupported on Android, and costly on shutdown
+    ClearAll();
+#endif
+}
+
+MICROPROFILE_DEFINE(GPU_DecodeTexture, "GPU", "Decode Texture", MP_RGB(160, 160, 60));
+
+std::shared_ptr<const DecodedTexture> TextureCache::GetTexture(const Texture::TextureInfo& info) {
+    const Key key{info.physical_address, info.width, info.height, info.format};
+
+    std::lock_guard lock{mutex};
+    auto it = entries.find(key);
+    if (it != entries.end() && !it->second.dirty) {
+        return it->second.texture;
+    }
+
+    // Only textures made of whole tiles in a single memory region are decoded
+    if (info.width % 8 != 0 || info.height % 8 != 0 || info.width == 0 || info.height == 0) {
+        return nullptr;
+    }
+    const u32 size = static_cast<u32>(info.stride * (info.height / 8));
+    const u8* source = VideoCore::g_memory->GetPhysicalPointer(info.physical_address);
+    const u8* last = VideoCore::g_memory->GetPhysicalPointer(info.physical_address + size - 1);
+    if (source == nullptr || last != source + size - 1) {
+        return nullptr;
+    }
+
+    const u64 hash = Common::ComputeHash64(source, size);
+    if (it == entries.end()) {
+        const std::size_t decoded_size = info.width * info.height * 4;
+        if (total_size + decoded_size > MAX_CACHED_BYTES) {
+            RemoveAllEntries();
+        }
+        total_size += decoded_size;
+        it = entries.emplace(key, Entry{size, hash, nullptr, true}).first;
+    }
+
+    Entry& entry = it->second;
+    if (!entry.texture || entry.hash != hash) {
+        MICROPROFILE_SCOPE(GPU_DecodeTexture);
+        // Other threads may still sample the old data, so it is replaced rather than overwritten
+        auto texture = std::make_shared<DecodedTexture>();
+        texture->width = info.width;
+        texture->height = info.height;
+        texture->texels.resize(info.width * info.height * 4);
+        Texture::DecodeTexture(info, source, texture->texels.data());
+        entry.texture = std::move(texture);
+        entry.hash = hash;
+    }
+
+    entry.dirty = false;
+    page_tracker->Queue(key.address, size, 1);
+    return entry.texture;
+}
+
+void TextureCache::InvalidateRegion(PAddr addr, u32 size) {
+    const u64 end = static_cast<u64>(addr) + size;
+    {
+        std::lock_guard lock{mutex};
+        for (auto& [key, entry] : entries) {
+            if (entry.dirty || key.address >= end || key.address + entry.size <= addr) {
+                continue;
+            }
+            // Dirty entries don't hold their pages, so further writes take the fast path
+            entry.dirty = true;
+            page_tracker->Queue(key.address, entry.size, -1);
+        }
+    }
+    SyncPages();
+}
+
+void TextureCache::ClearAll() {
+    {
+        std::lock_guard lock{mutex};
+        RemoveAllEntries();
+    }
+    SyncPages();
+}
+
+void TextureCache::SyncPages() {
+    if (!page_tracker->HasPending()) {
+        return;
+    }
+    // The tracker is kept alive by the callback in case the cache is gone when it runs
+    GPU::RunOnCPUThread([tracker = page_tracker] { tracker->Apply(); });
+}
+
+void TextureCache::RemoveAllEntries() {
+    for (const auto& [key, entry] : entries) {
+        if (!entry.dirty) {
+            page_tracker->Queue(key.address, entry.size, -1);
+        }
+    }
+    entries.clear();
+    total_size = 0;
+}
+
+} // namespace Pica::Rasterizer
@@ -0,0 +1,105 @@
+// Copyright 2022 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "common/common_types.h"
+#include "common/hash.h"
+#include "common/vector_math.h"
+#include "video_core/regs_texturing.h"
+
+namespace Pica::Texture {
+struct TextureInfo;
+} // namespace Pica::Texture
+
+namespace Pica::Rasterizer {
+
+/// A texture decoded to linear RGBA8, rows ordered like the t coordinate of LookupTexture
+struct DecodedTexture {
+    u32 width;
+    u32 height;
+    std::vector<u8> texels;
+
+    Common::Vec4<u8> Lookup(u32 s, u32 t) const {
+        const u8* texel = &texels[(t * width + s) * 4];
+        return {texel[0], texel[1], texel[2], texel[3]};
+    }
+};
+
+/**
+ * Keeps decoded copies of the textures sampled by the software rasterizer. Entries are looked up
+ * by address, size and format and revalidated against a hash of the guest data after their memory
+ * was invalidated, so textures that were rewritten with the same contents aren't decoded again.
+ * Pages backing a cached texture are marked as rasterizer cached, which routes CPU writes through
+ * RasterizerInvalidateRegion. Lookups may come from several rasterizer threads at once.
+ */
+class TextureCache {
+public:
+    TextureCache();
+    ~TextureCache();
+
+    /**
+     * Returns the decoded texture described by info, decoding it if necessary. Returns nullptr
+     * for textures that can't be decoded as a whole, which have to be sampled from guest memory.
+     */
+    std::shared_ptr<const DecodedTexture> GetTexture(const Texture::TextureInfo& info);
+
+    /// Marks all textures overlapping the region for revalidation on their next use
+    void InvalidateRegion(PAddr addr, u32 size);
+
+    /// Removes all textures from the cache
+    void ClearAll();
+
+    /**
+     * Applies the page markings requested since the last call. Must be called by the thread that
+     * submits rasterization work once no rasterizer thread is running.
+     */
+    void SyncPages();
+
+private:
+    struct Key {
+        PAddr address;
+        u32 width;
+        u32 height;
+        TexturingRegs::TextureFormat format;
+
+        bool operator==(const Key& other) const {
+            return address == other.address && width == other.width &&
+                   height == other.height && format == other.format;
+        }
+    };
+
+    struct KeyHash {
+        std::size_t operator()(const Key& key) const {
+            return Common::ComputeStructHash64(key);
+        }
+    };
+
+    struct Entry {
+        /// Size of the guest data in bytes
+        u32 size;
+        u64 hash;
+        std::shared_ptr<const DecodedTexture> texture;
+        /// Whether the guest data may have changed since it was hashed
+        bool dirty;
+    };
+
+    /// Per page reference counts of the marked regions, shared with deferred page updates
+    class PageTracker;
+
+    /// Releases the pages of every entry and empties the cache, the mutex must be held
+    void RemoveAllEntries();
+
+    std::mutex mutex;
+    std::unordered_map<Key, Entry, KeyHash> entries;
+    std::size_t total_size = 0;
+    std::shared_ptr<PageTracker> page_tracker;
+};
+
+} // namespace Pica::Rasterizer
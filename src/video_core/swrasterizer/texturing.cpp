@@ -3,6 +3,8 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
+#include <array>
+#include <utility>
 #include "common/assert.h"
 #include "common/common_types.h"
 #include "common/vector_math.h"
@@ -51,8 +53,8 @@ int GetWrappedTexCoord(TexturingRegs::TextureConfig::WrapMode mode, int val, uns
     }
 };
 
-Common::Vec3<u8> GetColorModifier(TevStageConfig::ColorModifier factor,
-                                  const Common::Vec4<u8>& values) {
+template <TevStageConfig::ColorModifier factor>
+static Common::Vec3<u8> ColorModifierImpl(const Common::Vec4<u8>& values) {
     using ColorModifier = TevStageConfig::ColorModifier;
 
     switch (factor) {
@@ -90,7 +92,8 @@ Common::Vec3<u8> GetColorModifier(TevStageConfig::ColorModifier factor,
     UNREACHABLE();
 };
 
-u8 GetAlphaModifier(TevStageConfig::AlphaModifier factor, const Common::Vec4<u8>& values) {
+template <TevStageConfig::AlphaModifier factor>
+static u8 AlphaModifierImpl(const Common::Vec4<u8>& values) {
     using AlphaModifier = TevStageConfig::AlphaModifier;
 
     switch (factor) {
@@ -122,7 +125,8 @@ u8 GetAlphaModifier(TevStageConfig::AlphaModifier factor, const Common::Vec4<u8>
     UNREACHABLE();
 };
 
-Common::Vec3<u8> ColorCombine(TevStageConfig::Operation op, const Common::Vec3<u8> input[3]) {
+template <TevStageConfig::Operation op>
+static Common::Vec3<u8> ColorCombineImpl(const Common::Vec3<u8> input[3]) {
     using Operation = TevStageConfig::Operation;
 
     switch (op) {
@@ -200,7 +204,8 @@ Common::Vec3<u8> ColorCombine(TevStageConfig::Operation op, const Common::Vec3<u
     }
 };
 
-u8 AlphaCombine(TevStageConfig::Operation op, const std::array<u8, 3>& input) {
+template <TevStageConfig::Operation op>
+static u8 AlphaCombineImpl(const std::array<u8, 3>& input) {
     switch (op) {
         using Operation = TevStageConfig::Operation;
     case Operation::Replace:
@@ -237,4 +242,95 @@ u8 AlphaCombine(TevStageConfig::Operation op, const std::array<u8, 3>& input) {
     }
 };
 
+template <TexturingRegs::TextureConfig::WrapMode mode>
+static int WrapTexCoordImpl(int val, unsigned size) {
+    if constexpr (mode == TexturingRegs::TextureConfig::ClampToBorder) {
+        if (val < 0 || val >= static_cast<int>(size)) {
+            return -1;
+        }
+    } else if constexpr (mode == TexturingRegs::TextureConfig::ClampToBorder2) {
+        if (val >= static_cast<int>(size)) {
+            return -1;
+        }
+    }
+    return GetWrappedTexCoord(mode, val, size);
+}
+
+// Lookup tables holding an instantiation of the above for every possible register value, so that
+// the rasterizer can resolve its configuration once per draw instead of per pixel.
+
+template <std::size_t... modes>
+static constexpr std::array<WrapTexCoordFunc, sizeof...(modes)> MakeWrapTexCoordTable(
+    std::index_sequence<modes...>) {
+    return {&WrapTexCoordImpl<static_cast<TexturingRegs::TextureConfig::WrapMode>(modes)>...};
+}
+
+template <std::size_t... factors>
+static constexpr std::array<ColorModifierFunc, sizeof...(factors)> MakeColorModifierTable(
+    std::index_sequence<factors...>) {
+    return {&ColorModifierImpl<static_cast<TevStageConfig::ColorModifier>(factors)>...};
+}
+
+template <std::size_t... factors>
+static constexpr std::array<AlphaModifierFunc, sizeof...(factors)> MakeAlphaModifierTable(
+    std::index_sequence<factors...>) {
+    return {&AlphaModifierImpl<static_cast<TevStageConfig::AlphaModifier>(factors)>...};
+}
+
+template <std::size_t... ops>
+static constexpr std::array<ColorCombineFunc, sizeof...(ops)> MakeColorCombineTable(
+    std::index_sequence<ops...>) {
+    return {&ColorCombineImpl<static_cast<TevStageConfig::Operation>(ops)>...};
+}
+
+template <std::size_t... ops>
+static constexpr std::array<AlphaCombineFunc, sizeof...(ops)> MakeAlphaCombineTable(
+    std::index_sequence<ops...>) {
+    return {&AlphaCombineImpl<static_cast<TevStageConfig::Operation>(ops)>...};
+}
+
+// The sizes match the widths of the corresponding TextureConfig and TevStageConfig bit fields
+constexpr auto wrap_tex_coord_table = MakeWrapTexCoordTable(std::make_index_sequence<8>{});
+constexpr auto color_modifier_table = MakeColorModifierTable(std::make_index_sequence<16>{});
+constexpr auto alpha_modifier_table = MakeAlphaModifierTable(std::make_index_sequence<8>{});
+constexpr auto color_combine_table = MakeColorCombineTable(std::make_index_sequence<16>{});
+constexpr auto alpha_combine_table = MakeAlphaCombineTable(std::make_index_sequence<16>{});
+
+WrapTexCoordFunc GetWrapTexCoordFunc(TexturingRegs::TextureConfig::WrapMode mode) {
+    return wrap_tex_coord_table[static_cast<u32>(mode) % wrap_tex_coord_table.size()];
+}
+
+ColorModifierFunc GetColorModifierFunc(TevStageConfig::ColorModifier factor) {
+    return color_modifier_table[static_cast<u32>(factor) % color_modifier_table.size()];
+}
+
+AlphaModifierFunc GetAlphaModifierFunc(TevStageConfig::AlphaModifier factor) {
+    return alpha_modifier_table[static_cast<u32>(factor) % alpha_modifier_table.size()];
+}
+
+ColorCombineFunc GetColorCombineFunc(TevStageConfig::Operation op) {
+    return color_combine_table[static_cast<u32>(op) % color_combine_table.size()];
+}
+
+AlphaCombineFunc GetAlphaCombineFunc(TevStageConfig::Operation op) {
+    return alpha_combine_table[static_cast<u32>(op) % alpha_combine_table.size()];
+}
+
+Common::Vec3<u8> GetColorModifier(TevStageConfig::ColorModifier factor,
+                                  const Common::Vec4<u8>& values) {
+    return GetColorModifierFunc(factor)(values);
+}
+
+u8 GetAlphaModifier(TevStageConfig::AlphaModifier factor, const Common::Vec4<u8>& values) {
+    return GetAlphaModifierFunc(factor)(values);
+}
+
+Common::Vec3<u8> ColorCombine(TevStageConfig::Operation op, const Common::Vec3<u8> input[3]) {
+    return GetColorCombineFunc(op)(input);
+}
+
+u8 AlphaCombine(TevStageConfig::Operation op, const std::array<u8, 3>& input) {
+    return GetAlphaCombineFunc(op)(input);
+}
+
 } // namespace Pica::Rasterizer
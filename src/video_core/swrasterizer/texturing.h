@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <array>
 #include "common/common_types.h"
 #include "common/vector_math.h"
 #include "video_core/regs_texturing.h"
@@ -23,4 +24,26 @@ Common::Vec3<u8> ColorCombine(TexturingRegs::TevStageConfig::Operation op,
 
 u8 AlphaCombine(TexturingRegs::TevStageConfig::Operation op, const std::array<u8, 3>& input);
 
+/// Returns the wrapped texture coordinate, or -1 if the border color is sampled instead
+using WrapTexCoordFunc = int (*)(int val, unsigned size);
+using ColorModifierFunc = Common::Vec3<u8> (*)(const Common::Vec4<u8>& values);
+using AlphaModifierFunc = u8 (*)(const Common::Vec4<u8>& values);
+using ColorCombineFunc = Common::Vec3<u8> (*)(const Common::Vec3<u8> input[3]);
+using AlphaCombineFunc = u8 (*)(const std::array<u8, 3>& input);
+
+/// Returns GetWrappedTexCoord specialized for the given mode, including the border check
+WrapTexCoordFunc GetWrapTexCoordFunc(TexturingRegs::TextureConfig::WrapMode mode);
+
+/// Returns GetColorModifier specialized for the given factor
+ColorModifierFunc GetColorModifierFunc(TexturingRegs::TevStageConfig::ColorModifier factor);
+
+/// Returns GetAlphaModifier specialized for the given factor
+AlphaModifierFunc GetAlphaModifierFunc(TexturingRegs::TevStageConfig::AlphaModifier factor);
+
+/// Returns ColorCombine specialized for the given operation
+ColorCombineFunc GetColorCombineFunc(TexturingRegs::TevStageConfig::Operation op);
+
+/// Returns AlphaCombine specialized for the given operation
+AlphaCombineFunc GetAlphaCombineFunc(TexturingRegs::TevStageConfig::Operation op);
+
 } // namespace Pica::Rasterizer
@@ -0,0 +1,114 @@
+// Copyright 2022 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <atomic>
+#include "video_core/pica_state.h"
+#include "video_core/regs_framebuffer.h"
+#include "video_core/swrasterizer/tile_binner.h"
+
+namespace Pica::Rasterizer {
+
+TileBinner::TileBinner(std::size_t num_threads, TextureCache& texture_cache)
+    : workers{std::max<std::size_t>(num_threads, 1) - 1, "SwRasterizer"},
+      texture_cache{texture_cache} {}
+
+TileBinner::~TileBinner() = default;
+
+void TileBinner::SetupGrid() {
+    const auto& framebuffer = g_state.regs.framebuffer.framebuffer;
+    tiles_x = std::max<u32>((framebuffer.GetWidth() + TILE_SIZE - 1) / TILE_SIZE, 1);
+    tiles_y = std::max<u32>((framebuffer.GetHeight() + TILE_SIZE - 1) / TILE_SIZE, 1);
+    if (bins.size() < tiles_x * tiles_y) {
+        bins.resize(tiles_x * tiles_y);
+    }
+}
+
+Common::Rectangle<u16> TileBinner::GetTileRect(u32 tile_index) const {
+    const u32 tile_x = tile_index % tiles_x;
+    const u32 tile_y = tile_index / tiles_x;
+
+    // The last row and column also own everything outside of the framebuffer, so that pixels the
+    // serial rasterizer would touch there are still processed exactly once.
+    const u32 right = tile_x + 1 == tiles_x ? MAX_SCREEN_COORDINATE : (tile_x + 1) * TILE_SIZE;
+    const u32 bottom = tile_y + 1 == tiles_y ? MAX_SCREEN_COORDINATE : (tile_y + 1) * TILE_SIZE;
+    return {static_cast<u16>(tile_x * TILE_SIZE), static_cast<u16>(tile_y * TILE_SIZE),
+            static_cast<u16>(right), static_cast<u16>(bottom)};
+}
+
+void TileBinner::AddTriangle(const Vertex& v0, const Vertex& v1, const Vertex& v2) {
+    // Registers can't change in the middle of a batch, so the grid only needs to be set up once
+    if (triangles.empty()) {
+        SetupGrid();
+    }
+
+    const auto bounds = GetTriangleBounds(v0, v1, v2);
+    if (bounds.right <= bounds.left || bounds.bottom <= bounds.top) {
+        // Doesn't cover any pixel center
+        return;
+    }
+
+    const u32 triangle_index = static_cast<u32>(triangles.size());
+    triangles.push_back({v0, v1, v2});
+
+    const u32 first_x = std::min<u32>(bounds.left / TILE_SIZE, tiles_x - 1);
+    const u32 last_x = std::min<u32>((bounds.right - 1) / TILE_SIZE, tiles_x - 1);
+    const u32 first_y = std::min<u32>(bounds.top / TILE_SIZE, tiles_y - 1);
+    const u32 last_y = std::min<u32>((bounds.bottom - 1) / TILE_SIZE, tiles_y - 1);
+
+    for (u32 tile_y = first_y; tile_y <= last_y; ++tile_y) {
+        for (u32 tile_x = first_x; tile_x <= last_x; ++tile_x) {
+            const u32 tile_index = tile_y * tiles_x + tile_x;
+            auto& bin = bins[tile_index];
+            if (bin.empty()) {
+                active_tiles.push_back(tile_index);
+            }
+            bin.push_back(triangle_index);
+        }
+    }
+}
+
+void TileBinner::RasterizeTile(u32 tile_index) const {
+    const auto tile = GetTileRect(tile_index);
+    for (const u32 triangle_index : bins[tile_index]) {
+        const auto& triangle = triangles[triangle_index];
+        ProcessTriangle(triangle[0], triangle[1], triangle[2], texture_cache, tile);
+    }
+}
+
+void TileBinner::Flush() {
+    if (active_tiles.empty()) {
+        triangles.clear();
+        return;
+    }
+
+    if (active_tiles.size() == 1 || workers.NumWorkers() == 0) {
+        for (const u32 tile_index : active_tiles) {
+            RasterizeTile(tile_index);
+        }
+    } else {
+        std::atomic<std::size_t> next_tile{0};
+        const auto rasterize_tiles = [this, &next_tile] {
+            for (std::size_t i = next_tile++; i < active_tiles.size(); i = next_tile++) {
+                RasterizeTile(active_tiles[i]);
+            }
+        };
+
+        const std::size_t num_jobs = std::min(workers.NumWorkers(), active_tiles.size() - 1);
+        for (std::size_t i = 0; i < num_jobs; ++i) {
+            workers.QueueWork(rasterize_tiles);
+        }
+        // The emulation thread would otherwise just sit idle, so let it take tiles as well
+        rasterize_tiles();
+        workers.WaitForRequests();
+    }
+
+    for (const u32 tile_index : active_tiles) {
+        bins[tile_index].clear();
+    }
+    active_tiles.clear();
+    triangles.clear();
+}
+
+} // namespace Pica::Rasterizer
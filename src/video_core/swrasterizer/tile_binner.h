@@ -0,0 +1,62 @@
+// Copyright 2022 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <vector>
+#include "common/common_types.h"
+#include "common/math_util.h"
+#include "common/thread_worker.h"
+#include "video_core/swrasterizer/rasterizer.h"
+
+namespace Pica::Rasterizer {
+
+/**
+ * Buckets the clipped triangles of a primitive batch into screen tiles and rasterizes the tiles
+ * in parallel. A tile is only ever processed by a single thread, which walks its triangles in
+ * submission order, so blending, depth and stencil results are identical to the serial path.
+ */
+class TextureCache;
+
+class TileBinner {
+public:
+    /// Width and height of a screen tile in pixels, a multiple of the 8x8 Morton block size
+    static constexpr u32 TILE_SIZE = 32;
+
+    /**
+     * @param num_threads Total number of threads rasterizing a batch, including the calling thread
+     * @param texture_cache Cache of the decoded textures sampled by the rasterizer
+     */
+    TileBinner(std::size_t num_threads, TextureCache& texture_cache);
+    ~TileBinner();
+
+    /// Queues a screen-space triangle for rasterization in the next Flush()
+    void AddTriangle(const Vertex& v0, const Vertex& v1, const Vertex& v2);
+
+    /// Rasterizes all queued triangles and blocks until every tile has been processed
+    void Flush();
+
+private:
+    /// Recomputes the tile grid from the current framebuffer dimensions
+    void SetupGrid();
+
+    /// Returns the pixel rectangle covered by the given tile
+    Common::Rectangle<u16> GetTileRect(u32 tile_index) const;
+
+    /// Rasterizes all triangles binned into the given tile
+    void RasterizeTile(u32 tile_index) const;
+
+    Common::ThreadWorker workers;
+    TextureCache& texture_cache;
+
+    u32 tiles_x = 0;
+    u32 tiles_y = 0;
+    std::vector<std::array<Vertex, 3>> triangles;
+    std::vector<std::vector<u32>> bins;
+    std::vector<u32> active_tiles;
+};
+
+} // namespace Pica::Rasterizer
@@ -4,9 +4,11 @@
 
 #include <algorithm>
 #include <array>
+#include <cstring>
 #include "common/bit_field.h"
 #include "common/color.h"
 #include "common/common_types.h"
+#include "common/simd_lanes.h"
 #include "common/vector_math.h"
 #include "video_core/texture/etc1.h"
 
@@ -115,8 +117,60 @@ union ETC1Tile {
 
         return ret.Cast<u8>();
     }
+
+    /// Base color of one half of the subtile, packed as RGBA8 with red in the lowest byte
+    u32 GetBaseColor(unsigned int half) const {
+        u8 r, g, b;
+        if (differential_mode) {
+            // Like GetRGB, an out of range sum wraps around before being expanded
+            const auto expand = [half](u64 base, s64 delta) {
+                return Color::Convert5To8(static_cast<u8>(base + (half ? delta : 0)));
+            };
+            r = expand(differential.r, differential.dr);
+            g = expand(differential.g, differential.dg);
+            b = expand(differential.b, differential.db);
+        } else if (half == 0) {
+            r = Color::Convert4To8(static_cast<u8>(separate.r1));
+            g = Color::Convert4To8(static_cast<u8>(separate.g1));
+            b = Color::Convert4To8(static_cast<u8>(separate.b1));
+        } else {
+            r = Color::Convert4To8(static_cast<u8>(separate.r2));
+            g = Color::Convert4To8(static_cast<u8>(separate.g2));
+            b = Color::Convert4To8(static_cast<u8>(separate.b2));
+        }
+        return r | (g << 8) | (b << 16);
+    }
 };
 
+using Common::Simd::Lanes;
+
+/**
+ * Computes the 8 colors a subtile can use: for each half, its base color plus and minus the two
+ * modifiers of its table. The additions saturate per channel, which is the clamp of GetRGB.
+ * Entry 4 * negate + 2 * half + table_subindex holds the color of the matching texels.
+ */
+template <typename V>
+std::array<u32, 8> GetPalette(const ETC1Tile& tile) {
+    const u32 base0 = tile.GetBaseColor(0);
+    const u32 base1 = tile.GetBaseColor(1);
+    const auto& table1 = etc1_modifier_table[tile.table_index_1];
+    const auto& table2 = etc1_modifier_table[tile.table_index_2];
+
+    constexpr u32 rgb = 0x010101;
+    const std::array<u32, 4> bases = {base0, base0, base1, base1};
+    const std::array<u32, 4> modifiers = {table1[0] * rgb, table1[1] * rgb, table2[0] * rgb,
+                                          table2[1] * rgb};
+
+    std::array<u32, 8> palette;
+    for (std::size_t i = 0; i < 4; i += V::Count) {
+        const V base = V::Load32(reinterpret_cast<const u8*>(&bases[i]));
+        const V modifier = V::Load32(reinterpret_cast<const u8*>(&modifiers[i]));
+        base.AddSaturateBytes(modifier).Store32(reinterpret_cast<u8*>(&palette[i]));
+        base.SubSaturateBytes(modifier).Store32(reinterpret_cast<u8*>(&palette[4 + i]));
+    }
+    return palette;
+}
+
 } // anonymous namespace
 
 Common::Vec3<u8> SampleETC1Subtile(u64 value, unsigned int x, unsigned int y) {
@@ -124,4 +178,26 @@ Common::Vec3<u8> SampleETC1Subtile(u64 value, unsigned int x, unsigned int y) {
     return tile.GetRGB(x, y);
 }
 
+void DecodeETC1Subtile(u64 value, u64 packed_alpha, u8* dst, std::ptrdiff_t dst_pitch) {
+    const ETC1Tile tile{value};
+    const std::array<u32, 8> palette = GetPalette<Lanes>(tile);
+    const u32 table_subindexes = static_cast<u32>(tile.table_subindexes);
+    const u32 negation_flags = static_cast<u32>(tile.negation_flags);
+    const bool flip = tile.flip;
+
+    for (unsigned int y = 0; y < 4; ++y) {
+        u8* const row = dst + static_cast<std::ptrdiff_t>(y) * dst_pitch;
+        for (unsigned int x = 0; x < 4; ++x) {
+            // Texels and their alpha are stored column by column
+            const unsigned int texel = 4 * x + y;
+            const unsigned int half = (flip ? y : x) >= 2;
+            const unsigned int entry = 4 * ((negation_flags >> texel) & 1) + 2 * half +
+                                       ((table_subindexes >> texel) & 1);
+            const u32 alpha = Color::Convert4To8((packed_alpha >> (4 * texel)) & 0xF);
+            const u32_le color = palette[entry] | (alpha << 24);
+            std::memcpy(row + x * 4, &color, sizeof(color));
+        }
+    }
+}
+
 } // namespace Pica::Texture
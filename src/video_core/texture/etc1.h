@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <cstddef>
 #include "common/common_types.h"
 #include "common/vector_math.h"
 
@@ -11,4 +12,13 @@ namespace Pica::Texture {
 
 Common::Vec3<u8> SampleETC1Subtile(u64 value, unsigned int x, unsigned int y);
 
+/**
+ * Decodes all 16 texels of a 4x4 ETC1 subtile at once.
+ * @param value The compressed subtile.
+ * @param packed_alpha 4-bit alpha of each texel as stored by ETC1A4, all ones for opaque ETC1.
+ * @param dst Destination of the top row as RGBA8 texels, red at the lowest address.
+ * @param dst_pitch Distance in bytes between two rows of dst, which may be negative.
+ */
+void DecodeETC1Subtile(u64 value, u64 packed_alpha, u8* dst, std::ptrdiff_t dst_pitch);
+
 } // namespace Pica::Texture
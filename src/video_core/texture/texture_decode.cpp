@@ -2,10 +2,13 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <array>
+#include <cstring>
 #include "common/assert.h"
 #include "common/color.h"
 #include "common/logging/log.h"
 #include "common/math_util.h"
+#include "common/simd_lanes.h"
 #include "common/swap.h"
 #include "common/vector_math.h"
 #include "video_core/regs_texturing.h"
@@ -211,6 +214,261 @@ Common::Vec4<u8> LookupTexelInTile(const u8* source, unsigned int x, unsigned in
     }
 }
 
+namespace {
+
+using Common::Simd::Lanes;
+using Common::Simd::Scalar;
+
+/// Texels of a tile in Morton order, as RGBA8 with red in the lowest byte
+using DecodedTile = std::array<u32, TILE_SIZE>;
+
+/// Position of every run of 2 texels of a tile, which always lie next to each other on a row
+constexpr std::array<u8, TILE_SIZE / 2> pair_positions = [] {
+    std::array<u8, TILE_SIZE / 2> positions{};
+    for (u32 y = 0; y < 8; ++y) {
+        for (u32 x = 0; x < 8; x += 2) {
+            positions[VideoCore::MortonInterleave(x, y) / 2] = static_cast<u8>(y * 8 + x);
+        }
+    }
+    return positions;
+}();
+
+/// Reverses the bytes of each lane
+template <typename V>
+V ByteSwap(V value) {
+    const V swapped_halves = (value.template ShiftLeft<8>() & V::Splat(0xFF00FF00)) |
+                             (value.template ShiftRight<8>() & V::Splat(0x00FF00FF));
+    return swapped_halves.template ShiftLeft<16>() | swapped_halves.template ShiftRight<16>();
+}
+
+/// Replicates the 4-bit value in the low nibble of each byte to the high nibble
+template <typename V>
+V ExpandNibbles(V value) {
+    return value | value.template ShiftLeft<4>();
+}
+
+/// Expands 5-bit channel values that are at the bottom of each lane to 8 bits
+template <typename V>
+V Expand5(V value) {
+    return value.template ShiftLeft<3>() | value.template ShiftRight<2>();
+}
+
+/**
+ * Converts texels loaded as little endian integers of the size of the format, one per lane, to
+ * RGBA8 with red in the lowest byte. Matches the conversions of LookupTexelInTile.
+ */
+template <TextureFormat format, typename V>
+V ConvertTexels(V texel) {
+    const V opaque = V::Splat(0xFF000000);
+    if constexpr (format == TextureFormat::RGBA8) {
+        return ByteSwap(texel);
+    } else if constexpr (format == TextureFormat::RGB8) {
+        return ByteSwap(texel.template ShiftLeft<8>()) | opaque;
+    } else if constexpr (format == TextureFormat::RGB5A1) {
+        const V r = texel.template ShiftRight<11>() & V::Splat(0x1F);
+        const V g = texel.template ShiftRight<6>() & V::Splat(0x1F);
+        const V b = texel.template ShiftRight<1>() & V::Splat(0x1F);
+        const V a = texel & V::Splat(0x1);
+        const V a8 = a.template ShiftLeft<8>() - a;
+        return Expand5(r) | Expand5(g).template ShiftLeft<8>() |
+               Expand5(b).template ShiftLeft<16>() | a8.template ShiftLeft<24>();
+    } else if constexpr (format == TextureFormat::RGB565) {
+        const V r = texel.template ShiftRight<11>() & V::Splat(0x1F);
+        const V g = texel.template ShiftRight<5>() & V::Splat(0x3F);
+        const V b = texel & V::Splat(0x1F);
+        const V g8 = g.template ShiftLeft<2>() | g.template ShiftRight<4>();
+        return Expand5(r) | g8.template ShiftLeft<8>() | Expand5(b).template ShiftLeft<16>() |
+               opaque;
+    } else if constexpr (format == TextureFormat::RGBA4) {
+        return ExpandNibbles(texel.template ShiftRight<12>() | (texel & V::Splat(0x0F00)) |
+                             (texel.template ShiftLeft<12>() & V::Splat(0x0F0000)) |
+                             (texel.template ShiftLeft<24>() & V::Splat(0x0F000000)));
+    } else if constexpr (format == TextureFormat::IA8) {
+        const V i = texel.template ShiftRight<8>();
+        return i | i.template ShiftLeft<8>() | i.template ShiftLeft<16>() |
+               texel.template ShiftLeft<24>();
+    } else if constexpr (format == TextureFormat::RG8) {
+        return texel.template ShiftRight<8>() |
+               (texel.template ShiftLeft<8>() & V::Splat(0xFF00)) | opaque;
+    } else if constexpr (format == TextureFormat::I8) {
+        return texel | texel.template ShiftLeft<8>() | texel.template ShiftLeft<16>() | opaque;
+    } else if constexpr (format == TextureFormat::A8) {
+        return texel.template ShiftLeft<24>();
+    } else if constexpr (format == TextureFormat::IA4) {
+        const V i = ExpandNibbles(texel.template ShiftRight<4>());
+        const V a = ExpandNibbles(texel & V::Splat(0xF));
+        return i | i.template ShiftLeft<8>() | i.template ShiftLeft<16>() |
+               a.template ShiftLeft<24>();
+    }
+}
+
+constexpr u32 BytesPerTexel(TextureFormat format) {
+    switch (format) {
+    case TextureFormat::RGBA8:
+        return 4;
+    case TextureFormat::RGB8:
+        return 3;
+    case TextureFormat::I8:
+    case TextureFormat::A8:
+    case TextureFormat::IA4:
+        return 1;
+    default:
+        return 2;
+    }
+}
+
+template <typename V, u32 bytes_per_texel>
+V LoadTexels(const u8* src) {
+    if constexpr (bytes_per_texel == 1) {
+        return V::Load8(src);
+    } else if constexpr (bytes_per_texel == 2) {
+        return V::Load16(src);
+    } else if constexpr (bytes_per_texel == 3) {
+        return V::Load24(src);
+    } else {
+        return V::Load32(src);
+    }
+}
+
+template <TextureFormat format>
+void DecodeTexels(const u8* source, DecodedTile& texels) {
+    constexpr u32 bytes_per_texel = BytesPerTexel(format);
+    u8* const dst = reinterpret_cast<u8*>(texels.data());
+    if constexpr (bytes_per_texel == 3 || Lanes::Count == 1) {
+        // There are no vector loads of 3-byte texels
+        for (std::size_t i = 0; i < TILE_SIZE; ++i) {
+            ConvertTexels<format>(LoadTexels<Scalar, bytes_per_texel>(source + i * bytes_per_texel))
+                .Store32(dst + i * 4);
+        }
+    } else {
+        for (std::size_t i = 0; i < TILE_SIZE; i += Lanes::Count) {
+            ConvertTexels<format>(LoadTexels<Lanes, bytes_per_texel>(source + i * bytes_per_texel))
+                .Store32(dst + i * 4);
+        }
+    }
+}
+
+/// Every value of a 4-bit texel expanded to RGBA8 with red in the lowest byte
+template <TextureFormat format>
+constexpr std::array<u32, 16> nibble_colors = [] {
+    std::array<u32, 16> colors{};
+    for (u32 value = 0; value < 16; ++value) {
+        const u32 expanded = value * 0x11;
+        colors[value] = format == TextureFormat::I4 ? expanded * 0x010101 | 0xFF000000
+                                                    : expanded << 24;
+    }
+    return colors;
+}();
+
+/// 4-bit formats hold two texels per byte, the first one in the low nibble
+template <TextureFormat format>
+void DecodeNibbleTexels(const u8* source, DecodedTile& texels) {
+    for (std::size_t i = 0; i < TILE_SIZE / 2; ++i) {
+        texels[i * 2] = nibble_colors<format>[source[i] & 0xF];
+        texels[i * 2 + 1] = nibble_colors<format>[source[i] >> 4];
+    }
+}
+
+/// Writes the texels of a tile to their rows, two at a time
+void StoreTile(const DecodedTile& texels, u8* dst, std::ptrdiff_t dst_pitch) {
+    for (std::size_t pair = 0; pair < TILE_SIZE / 2; ++pair) {
+        const u32 position = pair_positions[pair];
+        u8* const texel_dst =
+            dst + static_cast<std::ptrdiff_t>(position / 8) * dst_pitch + (position % 8) * 4;
+        std::memcpy(texel_dst, &texels[pair * 2], 2 * sizeof(u32));
+    }
+}
+
+/// ETC1 tiles are made of four 4x4 subtiles in row order, each preceded by its alpha for ETC1A4
+template <bool has_alpha>
+void DecodeETC1Tile(const u8* source, u8* dst, std::ptrdiff_t dst_pitch) {
+    constexpr std::size_t subtile_size = has_alpha ? 16 : 8;
+    for (unsigned int subtile = 0; subtile < ETC1_SUBTILES; ++subtile) {
+        const u8* subtile_ptr = source + subtile * subtile_size;
+        u64_le packed_alpha = ~u64{0};
+        if constexpr (has_alpha) {
+            std::memcpy(&packed_alpha, subtile_ptr, sizeof(u64));
+            subtile_ptr += sizeof(u64);
+        }
+        u64_le subtile_data;
+        std::memcpy(&subtile_data, subtile_ptr, sizeof(u64));
+
+        u8* const subtile_dst = dst + static_cast<std::ptrdiff_t>(subtile / 2) * 4 * dst_pitch +
+                                (subtile % 2) * 4 * 4;
+        DecodeETC1Subtile(subtile_data, packed_alpha, subtile_dst, dst_pitch);
+    }
+}
+
+} // Anonymous namespace
+
+void DecodeTile(TextureFormat format, const u8* source, u8* dst, std::ptrdiff_t dst_pitch) {
+    DecodedTile texels;
+    switch (format) {
+    case TextureFormat::RGBA8:
+        DecodeTexels<TextureFormat::RGBA8>(source, texels);
+        break;
+    case TextureFormat::RGB8:
+        DecodeTexels<TextureFormat::RGB8>(source, texels);
+        break;
+    case TextureFormat::RGB5A1:
+        DecodeTexels<TextureFormat::RGB5A1>(source, texels);
+        break;
+    case TextureFormat::RGB565:
+        DecodeTexels<TextureFormat::RGB565>(source, texels);
+        break;
+    case TextureFormat::RGBA4:
+        DecodeTexels<TextureFormat::RGBA4>(source, texels);
+        break;
+    case TextureFormat::IA8:
+        DecodeTexels<TextureFormat::IA8>(source, texels);
+        break;
+    case TextureFormat::RG8:
+        DecodeTexels<TextureFormat::RG8>(source, texels);
+        break;
+    case TextureFormat::I8:
+        DecodeTexels<TextureFormat::I8>(source, texels);
+        break;
+    case TextureFormat::A8:
+        DecodeTexels<TextureFormat::A8>(source, texels);
+        break;
+    case TextureFormat::IA4:
+        DecodeTexels<TextureFormat::IA4>(source, texels);
+        break;
+    case TextureFormat::I4:
+        DecodeNibbleTexels<TextureFormat::I4>(source, texels);
+        break;
+    case TextureFormat::A4:
+        DecodeNibbleTexels<TextureFormat::A4>(source, texels);
+        break;
+    case TextureFormat::ETC1:
+        DecodeETC1Tile<false>(source, dst, dst_pitch);
+        return;
+    case TextureFormat::ETC1A4:
+        DecodeETC1Tile<true>(source, dst, dst_pitch);
+        return;
+    default:
+        LOG_ERROR(HW_GPU, "Unknown texture format: {:x}", (u32)format);
+        DEBUG_ASSERT(false);
+        return;
+    }
+    StoreTile(texels, dst, dst_pitch);
+}
+
+void DecodeTexture(const TextureInfo& info, const u8* source, u8* dst) {
+    DEBUG_ASSERT(info.width % 8 == 0 && info.height % 8 == 0);
+    const std::size_t tile_size = CalculateTileSize(info.format);
+    const std::ptrdiff_t dst_pitch = info.width * 4;
+    for (unsigned int y = 0; y < info.height; y += 8) {
+        const u8* tile = source + (y / 8) * info.stride;
+        u8* tile_dst = dst + y * dst_pitch;
+        for (unsigned int x = 0; x < info.width; x += 8) {
+            DecodeTile(info.format, tile, tile_dst, dst_pitch);
+            tile += tile_size;
+            tile_dst += 8 * 4;
+        }
+    }
+}
+
 TextureInfo TextureInfo::FromPicaRegister(const TexturingRegs::TextureConfig& config,
                                           const TexturingRegs::TextureFormat& format) {
     TextureInfo info;
@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <cstddef>
 #include "common/common_types.h"
 #include "common/vector_math.h"
 #include "video_core/regs_texturing.h"
@@ -55,4 +56,27 @@ Common::Vec4<u8> LookupTexture(const u8* source, unsigned int x, unsigned int y,
 Common::Vec4<u8> LookupTexelInTile(const u8* source, unsigned int x, unsigned int y,
                                    const TextureInfo& info, bool disable_alpha);
 
+/**
+ * Decodes all texels of a single 8x8 texture tile at once, with the same results as
+ * LookupTexelInTile without disable_alpha.
+ *
+ * @param format Format of the tile.
+ * @param source Pointer to the beginning of the tile.
+ * @param dst Destination of the texels of the row y = 0 as RGBA8, red at the lowest address.
+ * @param dst_pitch Distance in bytes between two rows of dst, which may be negative.
+ */
+void DecodeTile(TexturingRegs::TextureFormat format, const u8* source, u8* dst,
+                std::ptrdiff_t dst_pitch);
+
+/**
+ * Decodes a whole texture tile by tile, which is much faster than calling LookupTexture for every
+ * texel. The dimensions of the texture must be multiples of 8.
+ *
+ * @param info TextureInfo describing the texture.
+ * @param source Pointer to the beginning of the texture.
+ * @param dst Destination of width * height RGBA8 texels, red at the lowest address. The texel at
+ *            x, y is stored at index y * width + x.
+ */
+void DecodeTexture(const TextureInfo& info, const u8* source, u8* dst);
+
 } // namespace Pica::Texture
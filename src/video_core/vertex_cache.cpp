@@ -0,0 +1,44 @@
+// Copyright 2022 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include "common/assert.h"
+#include "video_core/vertex_cache.h"
+
+namespace Pica {
+
+void VertexCache::BeginDraw(u64 state_key) {
+    if (state_key != current_state_key) {
+        Invalidate();
+        current_state_key = state_key;
+    }
+}
+
+void VertexCache::Invalidate() {
+    if (++generation == 0) {
+        // Tags of the wrapped around generations could match again
+        std::fill(tags.begin(), tags.end(), 0);
+        generation = 1;
+    }
+}
+
+void VertexCache::Insert(u32 vertex) {
+    ASSERT_MSG(vertex < MAX_VERTICES, "Vertex {} is out of the index range", vertex);
+    if (vertex >= tags.size()) {
+        // Draws usually touch increasing indices, so the storage grows geometrically to keep
+        // Insert amortized constant, but never beyond what an index can address
+        const std::size_t new_size = static_cast<std::size_t>(vertex) + 1;
+        if (new_size > entries.capacity()) {
+            const std::size_t new_capacity =
+                std::min(std::max(new_size, entries.capacity() * 2), MAX_VERTICES);
+            tags.reserve(new_capacity);
+            entries.reserve(new_capacity);
+        }
+        tags.resize(new_size, 0);
+        entries.resize(new_size);
+    }
+    tags[vertex] = generation;
+}
+
+} // namespace Pica
@@ -0,0 +1,66 @@
+// Copyright 2022 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <vector>
+#include "common/common_types.h"
+#include "video_core/shader/shader.h"
+
+namespace Pica {
+
+/**
+ * Post-transform cache of vertex shader outputs, directly indexed by vertex id. The cache grows to
+ * the range of indices seen and keeps its entries across draws as long as the state affecting the
+ * shaded vertices stays the same, so that consecutive draws sharing a vertex buffer only shade
+ * each vertex once.
+ */
+class VertexCache {
+public:
+    /// Indices are at most 16 bits wide, so this many entries cover every cacheable vertex
+    static constexpr std::size_t MAX_VERTICES = 0x10000;
+
+    /**
+     * Prepares the cache for a draw, dropping all entries if they were shaded with other state.
+     * @param state_key Hash of the state the vertex shader outputs depend on
+     */
+    void BeginDraw(u64 state_key);
+
+    /// Drops all entries
+    void Invalidate();
+
+    /// Returns whether the outputs of the given vertex are cached or about to be written
+    bool Contains(u32 vertex) const {
+        return vertex < tags.size() && tags[vertex] == generation;
+    }
+
+    /**
+     * Claims the entry of the given vertex, which the caller is expected to fill through Get()
+     * before reading it. The cache grows to exactly the entries up to the vertex, and growing it
+     * invalidates references to entries returned earlier.
+     */
+    void Insert(u32 vertex);
+
+    /// Returns the number of entries, which is one past the largest vertex inserted so far
+    std::size_t Size() const {
+        return tags.size();
+    }
+
+    /// Returns the entry holding the outputs of the given vertex
+    Shader::AttributeBuffer& Get(u32 vertex) {
+        return entries[vertex];
+    }
+    const Shader::AttributeBuffer& Get(u32 vertex) const {
+        return entries[vertex];
+    }
+
+private:
+    std::vector<Shader::AttributeBuffer> entries;
+    /// Generation each entry was written in, entries of older generations are stale
+    std::vector<u32> tags;
+    u32 generation = 1;
+    u64 current_state_key = 0;
+};
+
+} // namespace Pica
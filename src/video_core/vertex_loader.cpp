@@ -1,9 +1,12 @@
+#include <cstring>
 #include <memory>
+#include <utility>
 #include <boost/range/algorithm/fill.hpp>
 #include "common/alignment.h"
 #include "common/assert.h"
 #include "common/bit_field.h"
 #include "common/common_types.h"
+#include "common/hash.h"
 #include "common/logging/log.h"
 #include "common/vector_math.h"
 #include "core/memory.h"
@@ -17,6 +20,45 @@
 
 namespace Pica {
 
+template <typename T, u32 num_elements>
+static void FetchAttribute(const u8* data, Common::Vec4<float24>& attribute) {
+    const T* srcdata = reinterpret_cast<const T*>(data);
+    for (u32 comp = 0; comp < num_elements; ++comp) {
+        attribute[comp] = float24::FromFloat32(srcdata[comp]);
+    }
+
+    // Default attribute values set if array elements have < 4 components. This
+    // is *not* carried over from the default attribute settings even if they're
+    // enabled for this attribute.
+    for (u32 comp = num_elements; comp < 4; ++comp) {
+        attribute[comp] = comp == 3 ? float24::FromFloat32(1.0f) : float24::FromFloat32(0.0f);
+    }
+}
+
+template <typename T, std::size_t... indices>
+static constexpr auto MakeFetchFuncs(std::index_sequence<indices...>) {
+    return std::array{&FetchAttribute<T, static_cast<u32>(indices + 1)>...};
+}
+
+/// Fetch functions indexed by format and number of elements minus one
+static constexpr std::array fetch_funcs = {
+    MakeFetchFuncs<s8>(std::make_index_sequence<4>{}),
+    MakeFetchFuncs<u8>(std::make_index_sequence<4>{}),
+    MakeFetchFuncs<s16>(std::make_index_sequence<4>{}),
+    MakeFetchFuncs<float>(std::make_index_sequence<4>{}),
+};
+
+VertexLoader::Layout VertexLoader::GetLayout(const PipelineRegs& regs) {
+    static_assert(sizeof(regs.vertex_attributes) == sizeof(Layout) + sizeof(u32),
+                  "Layout has incorrect size");
+
+    Layout layout;
+    // Skip the base address, which doesn't affect how vertices are loaded
+    std::memcpy(layout.data(), reinterpret_cast<const u8*>(&regs.vertex_attributes) + sizeof(u32),
+                sizeof(layout));
+    return layout;
+}
+
 void VertexLoader::Setup(const PipelineRegs& regs) {
     ASSERT_MSG(!is_setup, "VertexLoader is not intended to be setup more than once.");
 
@@ -68,90 +110,28 @@ void VertexLoader::Setup(const PipelineRegs& regs) {
         }
     }
 
+    layout = GetLayout(regs);
+    Compile(regs);
     is_setup = true;
 }
 
-void VertexLoader::LoadVertex(u32 base_address, int index, int vertex,
-                              Shader::AttributeBuffer& input,
-                              DebugUtils::MemoryAccessTracker& memory_accesses) {
-    ASSERT_MSG(is_setup, "A VertexLoader needs to be setup before loading vertices.");
+void VertexLoader::Compile(const PipelineRegs& regs) {
+    num_fetches = 0;
+    num_default_attributes = 0;
 
     for (int i = 0; i < num_total_attributes; ++i) {
         if (vertex_attribute_elements[i] != 0) {
-            // Load per-vertex data from the loader arrays
-            u32 source_addr =
-                base_address + vertex_attribute_sources[i] + vertex_attribute_strides[i] * vertex;
-
-            if (g_debug_context && Pica::g_debug_context->recorder) {
-                memory_accesses.AddAccess(
-                    source_addr,
-                    vertex_attribute_elements[i] *
-                        ((vertex_attribute_formats[i] == PipelineRegs::VertexAttributeFormat::FLOAT)
-                             ? 4
-                             : (vertex_attribute_formats[i] ==
-                                PipelineRegs::VertexAttributeFormat::SHORT)
-                                   ? 2
-                                   : 1));
-            }
-
-            switch (vertex_attribute_formats[i]) {
-            case PipelineRegs::VertexAttributeFormat::BYTE: {
-                const s8* srcdata = reinterpret_cast<const s8*>(
-                    VideoCore::g_memory->GetPhysicalPointer(source_addr));
-                for (unsigned int comp = 0; comp < vertex_attribute_elements[i]; ++comp) {
-                    input.attr[i][comp] = float24::FromFloat32(srcdata[comp]);
-                }
-                break;
-            }
-            case PipelineRegs::VertexAttributeFormat::UBYTE: {
-                const u8* srcdata = reinterpret_cast<const u8*>(
-                    VideoCore::g_memory->GetPhysicalPointer(source_addr));
-                for (unsigned int comp = 0; comp < vertex_attribute_elements[i]; ++comp) {
-                    input.attr[i][comp] = float24::FromFloat32(srcdata[comp]);
-                }
-                break;
-            }
-            case PipelineRegs::VertexAttributeFormat::SHORT: {
-                const s16* srcdata = reinterpret_cast<const s16*>(
-                    VideoCore::g_memory->GetPhysicalPointer(source_addr));
-                for (unsigned int comp = 0; comp < vertex_attribute_elements[i]; ++comp) {
-                    input.attr[i][comp] = float24::FromFloat32(srcdata[comp]);
-                }
-                break;
-            }
-            case PipelineRegs::VertexAttributeFormat::FLOAT: {
-                const float* srcdata = reinterpret_cast<const float*>(
-                    VideoCore::g_memory->GetPhysicalPointer(source_addr));
-                for (unsigned int comp = 0; comp < vertex_attribute_elements[i]; ++comp) {
-                    input.attr[i][comp] = float24::FromFloat32(srcdata[comp]);
-                }
-                break;
-            }
-            }
-
-            // Default attribute values set if array elements have < 4 components. This
-            // is *not* carried over from the default attribute settings even if they're
-            // enabled for this attribute.
-            for (unsigned int comp = vertex_attribute_elements[i]; comp < 4; ++comp) {
-                input.attr[i][comp] =
-                    comp == 3 ? float24::FromFloat32(1.0f) : float24::FromFloat32(0.0f);
-            }
-
-            LOG_TRACE(HW_GPU,
-                      "Loaded {} components of attribute {:x} for vertex {:x} (index {:x}) from "
-                      "0x{:08x} + 0x{:08x} + 0x{:04x}: {} {} {} {}",
-                      vertex_attribute_elements[i], i, vertex, index, base_address,
-                      vertex_attribute_sources[i], vertex_attribute_strides[i] * vertex,
-                      input.attr[i][0].ToFloat32(), input.attr[i][1].ToFloat32(),
-                      input.attr[i][2].ToFloat32(), input.attr[i][3].ToFloat32());
+            const auto format = vertex_attribute_formats[i];
+            const u32 element_size = regs.vertex_attributes.GetElementSizeInBytes(i);
+            fetches[num_fetches++] = {
+                static_cast<u32>(i),
+                vertex_attribute_sources[i],
+                vertex_attribute_strides[i],
+                vertex_attribute_elements[i] * element_size,
+                fetch_funcs[static_cast<u32>(format)][vertex_attribute_elements[i] - 1],
+            };
         } else if (vertex_attribute_is_default[i]) {
-            // Load the default attribute if we're configured to do so
-            input.attr[i] = g_state.input_default_attributes.attr[i];
-            LOG_TRACE(
-                HW_GPU,
-                "Loaded default attribute {:x} for vertex {:x} (index {:x}): ({}, {}, {}, {})", i,
-                vertex, index, input.attr[i][0].ToFloat32(), input.attr[i][1].ToFloat32(),
-                input.attr[i][2].ToFloat32(), input.attr[i][3].ToFloat32());
+            default_attributes[num_default_attributes++] = static_cast<u32>(i);
         } else {
             // TODO(yuriks): In this case, no data gets loaded and the vertex
             // remains with the last value it had. This isn't currently maintained
@@ -160,4 +140,64 @@ void VertexLoader::LoadVertex(u32 base_address, int index, int vertex,
     }
 }
 
+void VertexLoader::LoadVertex(u32 base_address, int index, int vertex,
+                              Shader::AttributeBuffer& input,
+                              DebugUtils::MemoryAccessTracker& memory_accesses) const {
+    ASSERT_MSG(is_setup, "A VertexLoader needs to be setup before loading vertices.");
+
+    const bool record_accesses = g_debug_context && Pica::g_debug_context->recorder;
+
+    for (std::size_t f = 0; f < num_fetches; ++f) {
+        const auto& fetch = fetches[f];
+        const u32 i = fetch.attribute;
+
+        // Load per-vertex data from the loader arrays
+        const u32 source_addr = base_address + fetch.source + fetch.stride * vertex;
+
+        if (record_accesses) {
+            memory_accesses.AddAccess(source_addr, fetch.size);
+        }
+
+        fetch.fetch(VideoCore::g_memory->GetPhysicalPointer(source_addr), input.attr[i]);
+
+        LOG_TRACE(HW_GPU,
+                  "Loaded {} components of attribute {:x} for vertex {:x} (index {:x}) from "
+                  "0x{:08x} + 0x{:08x} + 0x{:04x}: {} {} {} {}",
+                  vertex_attribute_elements[i], i, vertex, index, base_address, fetch.source,
+                  fetch.stride * vertex, input.attr[i][0].ToFloat32(),
+                  input.attr[i][1].ToFloat32(), input.attr[i][2].ToFloat32(),
+                  input.attr[i][3].ToFloat32());
+    }
+
+    for (std::size_t d = 0; d < num_default_attributes; ++d) {
+        // Load the default attribute if we're configured to do so
+        const u32 i = default_attributes[d];
+        input.attr[i] = g_state.input_default_attributes.attr[i];
+        LOG_TRACE(HW_GPU,
+                  "Loaded default attribute {:x} for vertex {:x} (index {:x}): ({}, {}, {}, {})",
+                  i, vertex, index, input.attr[i][0].ToFloat32(), input.attr[i][1].ToFloat32(),
+                  input.attr[i][2].ToFloat32(), input.attr[i][3].ToFloat32());
+    }
+}
+
+const VertexLoader& VertexLoaderCache::Get(const PipelineRegs& regs) {
+    // Consecutive draws usually share their layout, so check the last one first
+    const auto layout = VertexLoader::GetLayout(regs);
+    if (last_loader && last_loader->GetLayout() == layout) {
+        return *last_loader;
+    }
+
+    const u64 hash = Common::ComputeHash64(layout.data(), sizeof(layout));
+    auto it = loaders.find(hash);
+    if (it == loaders.end() || it->second.GetLayout() != layout) {
+        if (loaders.size() >= MAX_LOADERS) {
+            loaders.clear();
+        }
+        it = loaders.insert_or_assign(hash, VertexLoader{regs}).first;
+    }
+
+    last_loader = &it->second;
+    return *last_loader;
+}
+
 } // namespace Pica
@@ -1,7 +1,10 @@
 #pragma once
 
 #include <array>
+#include <unordered_map>
 #include "common/common_types.h"
+#include "common/vector_math.h"
+#include "video_core/pica_types.h"
 #include "video_core/regs_pipeline.h"
 
 namespace Pica {
@@ -16,20 +19,44 @@ struct AttributeBuffer;
 
 class VertexLoader {
 public:
+    /// Attribute layout registers, i.e. vertex_attributes without the base address
+    using Layout = std::array<u32, sizeof(PipelineRegs::vertex_attributes) / sizeof(u32) - 1>;
+
     VertexLoader() = default;
     explicit VertexLoader(const PipelineRegs& regs) {
         Setup(regs);
     }
 
+    static Layout GetLayout(const PipelineRegs& regs);
+
     void Setup(const PipelineRegs& regs);
     void LoadVertex(u32 base_address, int index, int vertex, Shader::AttributeBuffer& input,
-                    DebugUtils::MemoryAccessTracker& memory_accesses);
+                    DebugUtils::MemoryAccessTracker& memory_accesses) const;
 
     int GetNumTotalAttributes() const {
         return num_total_attributes;
     }
 
+    const Layout& GetLayout() const {
+        return layout;
+    }
+
 private:
+    /// Converts the raw elements of an attribute and fills in the missing components
+    using FetchFunc = void (*)(const u8* data, Common::Vec4<float24>& attribute);
+
+    /// An attribute loaded from vertex arrays, with its format resolved to a conversion function
+    struct AttributeFetch {
+        u32 attribute;
+        u32 source;
+        u32 stride;
+        u32 size;
+        FetchFunc fetch;
+    };
+
+    /// Resolves the per-attribute configuration into the lists LoadVertex walks
+    void Compile(const PipelineRegs& regs);
+
     std::array<u32, 16> vertex_attribute_sources;
     std::array<u32, 16> vertex_attribute_strides{};
     std::array<PipelineRegs::VertexAttributeFormat, 16> vertex_attribute_formats;
@@ -37,6 +64,25 @@ private:
     std::array<bool, 16> vertex_attribute_is_default;
     int num_total_attributes = 0;
     bool is_setup = false;
+
+    Layout layout{};
+    std::array<AttributeFetch, 16> fetches;
+    std::size_t num_fetches = 0;
+    std::array<u32, 16> default_attributes;
+    std::size_t num_default_attributes = 0;
+};
+
+/// Keeps the vertex loaders of previously seen attribute layouts
+class VertexLoaderCache {
+public:
+    /// Returns the loader for the current attribute layout, setting one up if necessary
+    const VertexLoader& Get(const PipelineRegs& regs);
+
+private:
+    static constexpr std::size_t MAX_LOADERS = 256;
+
+    std::unordered_map<u64, VertexLoader> loaders;
+    const VertexLoader* last_loader = nullptr;
 };
 
 } // namespace Pica
@@ -11,6 +11,7 @@
 #include "video_core/renderer_base.h"
 #include "video_core/renderer_opengl/gl_vars.h"
 #include "video_core/renderer_opengl/renderer_opengl.h"
+#include "video_core/renderer_software/renderer_software.h"
 #include "video_core/video_core.h"
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -43,9 +44,12 @@ ResultStatus Init(Frontend::EmuWindow& emu_window, Memory::MemorySystem& memory)
     g_memory = &memory;
     Pica::Init();
 
-    OpenGL::GLES = Settings::values.use_gles;
-
-    g_renderer = std::make_unique<OpenGL::RendererOpenGL>(emu_window);
+    if (Settings::values.graphics_api == Settings::GraphicsAPI::Software) {
+        g_renderer = std::make_unique<SwRenderer::RendererSoftware>(emu_window);
+    } else {
+        OpenGL::GLES = Settings::values.use_gles;
+        g_renderer = std::make_unique<OpenGL::RendererOpenGL>(emu_window);
+    }
     ResultStatus result = g_renderer->Init();
 
     if (result != ResultStatus::Success) {